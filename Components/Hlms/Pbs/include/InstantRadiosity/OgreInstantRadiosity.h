@@ -32,7 +32,11 @@ THE SOFTWARE.
 
 #include "Math/Array/OgreArrayRay.h"
 #include "OgreConstBufferPool.h"
+#include "OgreAxisAlignedBox.h"
 #include "OgreHlmsBufferManager.h"
+#include "OgreId.h"
+#include "OgreMatrix4.h"
+#include "OgreQuaternion.h"
 #include "OgreRawPtr.h"
 #include "OgreRay.h"
 #include "OgreTextureBox.h"
@@ -54,6 +58,18 @@ namespace Ogre
 
     class _OgreHlmsPbsExport InstantRadiosity
     {
+        /// Node of a MeshData's triangle BVH, in mesh (local) space.
+        struct BvhNode
+        {
+            float aabbMin[3];
+            /// Leaf: first triangle in MeshData::bvhTriangles.
+            /// Inner node: index of the second child. The first child is the next node.
+            uint32 offset;
+            float  aabbMax[3];
+            /// 0 for inner nodes.
+            uint32 numTriangles;
+        };
+
         struct MeshData
         {
             float *RESTRICT_ALIAS vertexData;
@@ -68,7 +84,19 @@ namespace Ogre
             size_t numIndices;
             bool   useIndices16bit;
 
+            /// Triangle BVH, built once when the mesh is downloaded and kept until
+            /// freeMemory. Nodes are stored depth first; the root is bvhNodes[0].
+            BvhNode *RESTRICT_ALIAS bvhNodes;
+            /// Triangle indices, sorted so that each leaf references a contiguous range.
+            uint32 *RESTRICT_ALIAS bvhTriangles;
+            size_t                 numBvhNodes;
+
             float *getUvStart( uint8_t uvSet ) const;
+
+            size_t getNumTriangles() const;
+            void   getTriangle( size_t triIdx, uint32 outVertexIdx[3] ) const;
+            /// Mesh space position
+            Vector3 getVertex( uint32 vertexIdx ) const;
         };
 
         struct MaterialData
@@ -120,10 +148,57 @@ namespace Ogre
             bool operator()( const SparseCluster &_l, const SparseCluster &_r ) const;
         };
 
+        /// Tests the rays mRaycastJobRays[rayStart; rayStart + numRays) against a mesh.
+        /// Generated on the main thread (which is the one allowed to download the
+        /// meshes & textures), processed by the worker threads.
+        struct RaycastJob
+        {
+            MeshData const *meshData;
+            Matrix4         worldMatrix;
+            Matrix4         invWorldMatrix;
+            MaterialData    material;
+            size_t          rayStart;
+            size_t          numRays;
+        };
+
+        /// Closest hit found so far by raycastLightRayVsMesh
+        struct TriangleHit
+        {
+            bool    hasHit;
+            uint32  triIdx;
+            uint32  vertexIdx[3];
+            Real    distance;
+            Vector3 triVerts[3];
+            Vector3 triNormal;
+        };
+
+        class RaycastTask;
+
         typedef vector<RayHit>::type                    RayHitVec;
         typedef vector<Vpl>::type                       VplVec;
         typedef set<SparseCluster, SparseCluster>::type SparseClusterSet;
 
+        /// The light parameters the VPLs were traced with, and the VPLs it generated
+        /// (before being clustered with the VPLs of other lights).
+        /// Lets updateChangedLights find out which lights need to be traced again.
+        struct PerLightData
+        {
+            Vector3    position;
+            Quaternion orientation;
+            Vector3    colour;
+            Real       range;
+            Real       attenConst;
+            Real       attenLinear;
+            Real       attenQuad;
+            Radian     spotOuterAngle;
+            uint8      type;
+            bool       stillInScene;
+            VplVec     vpls;
+        };
+        /// Keyed by Light::getId rather than by pointer, since the address of a
+        /// destroyed light may be reused by a new one.
+        typedef map<IdType, PerLightData>::type PerLightDataMap;
+
         struct OrderRenderOperation
         {
             bool operator()( const v1::RenderOperation &_l, const v1::RenderOperation &_r ) const;
@@ -233,11 +308,24 @@ namespace Ogre
         RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL> mArrayRays;
 
         FastArray<size_t> mTmpRaysThatHitObject[ARRAY_PACKED_REALS];
+
+        /// Jobs are in the same order objects were found, and mRaycastJobRays is sorted
+        /// in ascending order within each job. Every ray is only ever touched by one thread,
+        /// and sees the jobs in the same order regardless of the number of threads; thus
+        /// the results are deterministic.
+        FastArray<RaycastJob> mRaycastJobs;
+        FastArray<size_t>     mRaycastJobRays;
         SparseClusterSet  mTmpSparseClusters[3];
 
         typedef map<VertexArrayObject *, MeshData>::type                       MeshDataMapV2;
         typedef map<v1::RenderOperation, MeshData, OrderRenderOperation>::type MeshDataMapV1;
 
+        PerLightDataMap mPerLightData;
+        bool            mBuilt;
+        /// World space area whose irradiance needs to be recalculated by
+        /// updateIrradianceVolume, due to updateChangedLights.
+        AxisAlignedBox mIrradianceDirtyArea;
+
         MeshDataMapV2 mMeshDataMapV2;
         MeshDataMapV1 mMeshDataMapV1;
 
@@ -251,6 +339,8 @@ namespace Ogre
 
         bool mUseIrradianceVolume;
 
+        bool mUseBvh;
+
         /**
         @param lightPos
         @param lightRot
@@ -283,9 +373,22 @@ namespace Ogre
         void testLightVsAllObjects( uint8 lightType, Real lightRange, ObjectData objData,
                                     size_t numNodes, const AreaOfInterest &areaOfInterest,
                                     size_t rayStart, size_t numRays );
-        void raycastLightRayVsMesh( Real lightRange, const MeshData meshData, Matrix4 worldMatrix,
-                                    const MaterialData      &material,
-                                    const FastArray<size_t> &raysThatHitObj );
+        /// Tests the ray against a single triangle. Updates inOutBestHit if it's closer.
+        static void raycastTriangle( const Ray &ray, Real lightRange, const MeshData &meshData,
+                                     const Matrix4 &worldMatrix, uint32 triIdx,
+                                     TriangleHit &inOutBestHit );
+        /// Tests the given rays against meshData, using its BVH unless mUseBvh is false
+        void raycastLightRayVsMesh( Real lightRange, const MeshData &meshData,
+                                    const Matrix4 &worldMatrix, const Matrix4 &invWorldMatrix,
+                                    const MaterialData &material, const size_t *rayIndices,
+                                    size_t numRays );
+        /// Runs all mRaycastJobs on the rays in range [firstRay; lastRay).
+        /// Concurrent calls are safe as long as their ranges don't overlap.
+        void raycastJobs( Real lightRange, size_t firstRay, size_t lastRay );
+        /// Runs & clears all mRaycastJobs, splitting the rays among SceneManager's worker threads.
+        void executeRaycastJobs( Real lightRange, size_t rayStart, size_t numRays );
+
+        static void buildBvh( MeshData &meshData );
 
         Vpl convertToVpl( Vector3 lightColour, Vector3 pointOnTri, const RayHit &hit );
         /// Generates the VPLs from a particular lights, and clusters them.
@@ -296,9 +399,28 @@ namespace Ogre
         /// Clusters the VPL from all lights (these VPLs may have been clustered with other
         /// VPLs from the same light, now we need to do this again with lights from different
         /// clusters)
-        void clusterAllVpls();
+        void clusterAllVpls( VplVec &inOutVpls );
         void autogenerateAreaOfInterest();
 
+        /// Lights that can generate VPLs, in scene order.
+        void collectLights( FastArray<Light *> &outLights );
+        static bool hasLightChanged( const Light *light, const PerLightData &lightData );
+        /// Updates the scene graph & allocates the ray buffers.
+        /// Returns true if the AoI had to be autogenerated.
+        bool beginTracing();
+        void endTracing( bool aoiAutogenerated );
+        /// Traces the given light for every area of interest and stores the result
+        /// in outLightData. Must be called between beginTracing & endTracing.
+        void traceLight( Light *light, PerLightData &outLightData );
+        /// Inserts the cells touched by the given VPLs into outCells
+        void addVplCells( const VplVec &vpls, SparseClusterSet &outCells ) const;
+        void destroyVplLight( Vpl &vpl );
+
+        /// Adds the contribution of all VPLs to the given cells of the volume, using
+        /// the parameters the volume was last filled with (see fillIrradianceVolume)
+        void addVplsToIrradianceVolume( IrradianceVolume *volume, const int32 regionMin[3],
+                                        const int32 regionMax[3] );
+
         /// lightDir is normalized
         static void mergeDirectionalDiffuse( const Vector3 &diffuse, const Vector3 &lightDir,
                                              Vector3 *inOutDirDiffuse );
@@ -321,6 +443,23 @@ namespace Ogre
 
         void build();
 
+        /** Traces again only the lights that changed since the last build (moved, rotated,
+            changed colour, range or attenuation), plus the ones that were added; and
+            removes the VPLs of the lights that were removed or became invisible.
+        @remarks
+            Only the VPL clusters touched by those lights are merged again; every other
+            VPL is left untouched. The result is the same as calling build again.
+        @par
+            Changes to any other setting (e.g. mNumRays, mCellSize, the areas of interest
+            or the geometry) still require calling build.
+        @par
+            If build hasn't been called yet, it is called.
+            Call updateIrradianceVolume afterwards if you're using an irradiance volume.
+        @return
+            The number of lights that were traced again or removed. 0 if nothing changed.
+        */
+        size_t updateChangedLights();
+
         /// "build" will download meshes for raycasting. We will not free
         /// them after build (in case you want to build again).
         /// If you wish to free that memory, call this function.
@@ -348,6 +487,28 @@ namespace Ogre
         void setUseIrradianceVolume( bool bUseIrradianceVolume );
         bool getUseIrradianceVolume() const { return mUseIrradianceVolume; }
 
+        /** Whether to test the rays against each mesh's triangle BVH. When disabled, every
+            ray is tested against every triangle of the meshes it hits, which is much slower
+            but gives the same result. Only useful for debugging and testing.
+        @remarks
+            Takes effect on the next build.
+        @param bUseBvh
+            Default is true.
+        */
+        void setUseBvh( bool bUseBvh ) { mUseBvh = bUseBvh; }
+        bool getUseBvh() const { return mUseBvh; }
+
+        /// Number of VPLs generated by the last build or updateChangedLights,
+        /// after clustering. Includes the ones below mVplThreshold.
+        size_t getNumVpls() const { return mVpls.size(); }
+
+        /** Returns the data of a VPL. Mostly for debugging and testing.
+        @param idx
+            In range [0; getNumVpls())
+        */
+        void getVpl( size_t idx, Vector3 &outPosition, Vector3 &outNormal,
+                     Vector3 &outDiffuse ) const;
+
         /** Outputs suggested parameters for a volumetric texture that will encompass all
             VPLs. They are suggestions, you don't have to follow them.
         @param inCellSize
@@ -388,6 +549,15 @@ namespace Ogre
         */
         void fillIrradianceVolume( IrradianceVolume *volume, Vector3 cellSize, Vector3 volumeOrigin,
                                    Real lightMaxPower, bool fadeAttenuationOverDistance );
+
+        /** Recalculates the cells of the volume that are affected by the VPLs that changed
+            since it was last filled, due to updateChangedLights.
+        @remarks
+            The volume must have been filled with fillIrradianceVolume; the same parameters
+            are used. Cells outside the reach of the changed VPLs are left untouched.
+        @param volume
+        */
+        void updateIrradianceVolume( IrradianceVolume *volume );
     };
 
     /** @} */
@@ -81,6 +81,11 @@ namespace Ogre
         void destroyIrradianceVolumeTexture();
 
         void clearVolumeData();
+        /// Zeroes the cells in range [min; max] (inclusive). Volume data must already exist.
+        void clearVolumeData( uint32 minX, uint32 minY, uint32 minZ, uint32 maxX, uint32 maxY,
+                              uint32 maxZ );
+        /// Whether clearVolumeData has been called, i.e. the volume can be modified.
+        bool hasVolumeData() const { return mVolumeData != 0; }
         void updateIrradianceVolumeTexture();
         void freeMemory();
 
@@ -44,6 +44,7 @@ THE SOFTWARE.
 #include "OgreRay.h"
 #include "OgreSceneManager.h"
 #include "OgreTextureGpu.h"
+#include "Threading/OgreUniformScalableTask.h"
 #include "Vao/OgreAsyncTicket.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreVertexArrayObject.h"
@@ -127,6 +128,91 @@ namespace Ogre
             return retVal;
         }
     };
+
+    /// Leaves with more triangles than this get split.
+    static const size_t c_bvhMaxTrianglesPerLeaf = 4u;
+    /// Enough for 2^64 triangles, since we always split at the median.
+    static const size_t c_bvhMaxDepth = 64u;
+    /// Below this many rays per thread it's not worth waking up the worker threads.
+    static const size_t c_minRaysPerThread = 16u;
+
+    /// Sorts triangles by their centroid along an axis. Ties are broken by
+    /// index so the BVH is always the same for the same mesh.
+    struct BvhCentroidOrder
+    {
+        Vector3 const *centroids;
+        size_t         axis;
+
+        BvhCentroidOrder( const Vector3 *_centroids, size_t _axis ) :
+            centroids( _centroids ),
+            axis( _axis )
+        {
+        }
+
+        bool operator()( uint32 a, uint32 b ) const
+        {
+            if( centroids[a][axis] != centroids[b][axis] )
+                return centroids[a][axis] < centroids[b][axis];
+            return a < b;
+        }
+    };
+
+    /// Slab test. Rays can start inside the box.
+    static inline bool intersectsBvhNode( const float *RESTRICT_ALIAS aabbMin,
+                                          const float *RESTRICT_ALIAS aabbMax, const Vector3 &origin,
+                                          const Vector3 &dir, const Vector3 &invDir, Real maxDist )
+    {
+        Real tMin = 0;
+        Real tMax = maxDist;
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            if( dir[i] == Real( 0 ) )
+            {
+                // Parallel to the slab (avoids 0 * inf = NaN)
+                if( origin[i] < aabbMin[i] || origin[i] > aabbMax[i] )
+                    return false;
+            }
+            else
+            {
+                Real t0 = ( aabbMin[i] - origin[i] ) * invDir[i];
+                Real t1 = ( aabbMax[i] - origin[i] ) * invDir[i];
+                if( t0 > t1 )
+                    std::swap( t0, t1 );
+                tMin = std::max( tMin, t0 );
+                tMax = std::min( tMax, t1 );
+                if( tMin > tMax )
+                    return false;
+            }
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    /// Splits the rays of InstantRadiosity::executeRaycastJobs between the worker threads
+    class InstantRadiosity::RaycastTask final : public UniformScalableTask
+    {
+        InstantRadiosity *mInstantRadiosity;
+        Real              mLightRange;
+        size_t            mRayStart;
+        size_t            mNumRays;
+
+    public:
+        RaycastTask( InstantRadiosity *instantRadiosity, Real lightRange, size_t rayStart,
+                     size_t numRays ) :
+            mInstantRadiosity( instantRadiosity ),
+            mLightRange( lightRange ),
+            mRayStart( rayStart ),
+            mNumRays( numRays )
+        {
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            const size_t numPerThread = ( mNumRays + numThreads - 1u ) / numThreads;
+            const size_t firstRay = std::min( threadId * numPerThread, mNumRays );
+            const size_t lastRay = std::min( firstRay + numPerThread, mNumRays );
+            mInstantRadiosity->raycastJobs( mLightRange, mRayStart + firstRay, mRayStart + lastRay );
+        }
+    };
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
@@ -155,9 +241,11 @@ namespace Ogre
         mVplIntensityRangeMultiplier( 100.0 ),
         mMipmapBias( 0 ),
         mTotalNumRays( 0 ),
+        mBuilt( false ),
         mEnableDebugMarkers( false ),
         mUseTextures( true ),
-        mUseIrradianceVolume( false )
+        mUseIrradianceVolume( false ),
+        mUseBvh( true )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -488,20 +576,20 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void InstantRadiosity::clusterAllVpls()
+    void InstantRadiosity::clusterAllVpls( VplVec &inOutVpls )
     {
         assert( mCellSize > 0 );
 
         const Real cellSize = Real( 1.0 ) / mCellSize;
 
-        VplVec::iterator itor = mVpls.begin();
-        VplVec::iterator end = mVpls.end();
+        VplVec::iterator itor = inOutVpls.begin();
+        VplVec::iterator end = inOutVpls.end();
 
         while( itor != end )
         {
             Vpl vpl = *itor;  // Hard copy!
 
-            const ptrdiff_t idx = itor - mVpls.begin();
+            const ptrdiff_t idx = itor - inOutVpls.begin();
 
             const int32 blockX = static_cast<int32>( Math::Floor( vpl.position.x * cellSize ) );
             const int32 blockY = static_cast<int32>( Math::Floor( vpl.position.y * cellSize ) );
@@ -537,9 +625,9 @@ namespace Ogre
                     numCollectedVpls += alikeVpl.numMergedVpls;
 
                     // Iterators get invalidated!
-                    itAlike = efficientVectorRemove( mVpls, itAlike );
-                    itor = mVpls.begin() + idx;
-                    end = mVpls.end();
+                    itAlike = efficientVectorRemove( inOutVpls, itAlike );
+                    itor = inOutVpls.begin() + idx;
+                    end = inOutVpls.end();
                 }
                 else
                 {
@@ -673,6 +761,8 @@ namespace Ogre
                 }
             }
 
+            executeRaycastJobs( lightRange, rayStart, numRays );
+
             const size_t oldRayStart = rayStart;
             const size_t oldNumRays = numRays;
 
@@ -879,6 +969,8 @@ namespace Ogre
             }
         }
 
+        buildBvh( meshData );
+
         mMeshDataMapV2[vao] = meshData;
 
         return &mMeshDataMapV2[vao];
@@ -1005,6 +1097,8 @@ namespace Ogre
                     renderOp.indexData->indexCount * renderOp.indexData->indexBuffer->getIndexSize() );
         }
 
+        buildBvh( meshData );
+
         mMeshDataMapV1[renderOp] = meshData;
 
         return &mMeshDataMapV1[renderOp];
@@ -1166,8 +1260,20 @@ namespace Ogre
                                 }
                             }
 
-                            raycastLightRayVsMesh( lightRange, *meshData, worldMatrix, material,
-                                                   mTmpRaysThatHitObject[j] );
+                            // A zero scale leaves nothing to hit (and no inverse)
+                            if( meshData->numBvhNodes && worldMatrix.determinant() != Real( 0 ) )
+                            {
+                                RaycastJob job;
+                                job.meshData = meshData;
+                                job.worldMatrix = worldMatrix;
+                                job.invWorldMatrix = worldMatrix.inverseAffine();
+                                job.material = material;
+                                job.rayStart = mRaycastJobRays.size();
+                                job.numRays = mTmpRaysThatHitObject[j].size();
+                                mRaycastJobRays.appendPOD( mTmpRaysThatHitObject[j].begin(),
+                                                           mTmpRaysThatHitObject[j].end() );
+                                mRaycastJobs.push_back( job );
+                            }
                         }
 
                         ++itor;
@@ -1179,105 +1285,308 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void InstantRadiosity::raycastLightRayVsMesh( Real lightRange, const MeshData meshData,
-                                                  Matrix4 worldMatrix, const MaterialData &material,
-                                                  const FastArray<size_t> &raysThatHitObj )
+    void InstantRadiosity::buildBvh( MeshData &meshData )
     {
-        const size_t numElements = meshData.indexData ? meshData.numIndices : meshData.numVertices;
+        const size_t numTriangles = meshData.getNumTriangles();
 
-        const uint16 *RESTRICT_ALIAS indexData16 =
-            reinterpret_cast<const uint16 * RESTRICT_ALIAS>( meshData.indexData );
-        const uint32 *RESTRICT_ALIAS indexData32 =
-            reinterpret_cast<const uint32 * RESTRICT_ALIAS>( meshData.indexData );
+        meshData.bvhNodes = 0;
+        meshData.bvhTriangles = 0;
+        meshData.numBvhNodes = 0;
 
-        for( size_t i = 0; i < numElements; i += 3 )
-        {
-            Vector3 triVerts[3];
+        if( !numTriangles )
+            return;
 
+        FastArray<Vector3> triMin, triMax, centroids;
+        triMin.resize( numTriangles );
+        triMax.resize( numTriangles );
+        centroids.resize( numTriangles );
+
+        meshData.bvhTriangles = reinterpret_cast<uint32 *>(
+            OGRE_MALLOC_SIMD( numTriangles * sizeof( uint32 ), MEMCATEGORY_GEOMETRY ) );
+
+        for( size_t i = 0; i < numTriangles; ++i )
+        {
             uint32 vertexIdx[3];
+            meshData.getTriangle( i, vertexIdx );
+            const Vector3 v0 = meshData.getVertex( vertexIdx[0] );
+            const Vector3 v1 = meshData.getVertex( vertexIdx[1] );
+            const Vector3 v2 = meshData.getVertex( vertexIdx[2] );
+
+            triMin[i] = v0;
+            triMin[i].makeFloor( v1 );
+            triMin[i].makeFloor( v2 );
+            triMax[i] = v0;
+            triMax[i].makeCeil( v1 );
+            triMax[i].makeCeil( v2 );
+            centroids[i] = ( triMin[i] + triMax[i] ) * Real( 0.5 );
+
+            meshData.bvhTriangles[i] = static_cast<uint32>( i );
+        }
+
+        struct PendingNode
+        {
+            size_t begin;
+            size_t end;
+            /// Node whose 'offset' must point to this one, if this is a second child.
+            size_t parentIdx;
+        };
+
+        // A binary tree with at least one triangle per leaf has less than 2n nodes
+        FastArray<BvhNode> nodes;
+        nodes.reserve( ( numTriangles / c_bvhMaxTrianglesPerLeaf + 1u ) * 2u );
 
-            if( meshData.indexData )
+        FastArray<PendingNode> pending;
+        PendingNode root = { 0u, numTriangles, std::numeric_limits<size_t>::max() };
+        pending.push_back( root );
+
+        while( !pending.empty() )
+        {
+            const PendingNode current = pending.back();
+            pending.pop_back();
+
+            const size_t nodeIdx = nodes.size();
+            if( current.parentIdx != std::numeric_limits<size_t>::max() )
+                nodes[current.parentIdx].offset = static_cast<uint32>( nodeIdx );
+
+            Vector3 aabbMin( std::numeric_limits<Real>::max() );
+            Vector3 aabbMax( -std::numeric_limits<Real>::max() );
+            Vector3 centroidMin( std::numeric_limits<Real>::max() );
+            Vector3 centroidMax( -std::numeric_limits<Real>::max() );
+            for( size_t i = current.begin; i < current.end; ++i )
             {
-                if( meshData.useIndices16bit )
-                {
-                    vertexIdx[0] = indexData16[i + 0];
-                    vertexIdx[1] = indexData16[i + 1];
-                    vertexIdx[2] = indexData16[i + 2];
-                }
-                else
-                {
-                    vertexIdx[0] = indexData32[i + 0];
-                    vertexIdx[1] = indexData32[i + 1];
-                    vertexIdx[2] = indexData32[i + 2];
-                }
+                const uint32 triIdx = meshData.bvhTriangles[i];
+                aabbMin.makeFloor( triMin[triIdx] );
+                aabbMax.makeCeil( triMax[triIdx] );
+                centroidMin.makeFloor( centroids[triIdx] );
+                centroidMax.makeCeil( centroids[triIdx] );
+            }
+
+            // Pad the box so rays transformed into mesh space don't
+            // miss grazing triangles due to precision loss.
+            const Vector3 padding = ( aabbMax - aabbMin ) * Real( 1e-4 ) + Real( 1e-5 );
+            aabbMin -= padding;
+            aabbMax += padding;
+
+            BvhNode node;
+            for( size_t i = 0; i < 3u; ++i )
+            {
+                node.aabbMin[i] = aabbMin[i];
+                node.aabbMax[i] = aabbMax[i];
+            }
+
+            const size_t numNodeTriangles = current.end - current.begin;
+            if( numNodeTriangles <= c_bvhMaxTrianglesPerLeaf )
+            {
+                node.offset = static_cast<uint32>( current.begin );
+                node.numTriangles = static_cast<uint32>( numNodeTriangles );
+                nodes.push_back( node );
             }
             else
             {
-                vertexIdx[0] = uint32( i + 0u );
-                vertexIdx[1] = uint32( i + 1u );
-                vertexIdx[2] = uint32( i + 2u );
+                // Split at the median along the longest axis (of the centroids)
+                const Vector3 extent = centroidMax - centroidMin;
+                size_t axis = 0u;
+                if( extent.y > extent[axis] )
+                    axis = 1u;
+                if( extent.z > extent[axis] )
+                    axis = 2u;
+
+                const size_t mid = current.begin + numNodeTriangles / 2u;
+                std::nth_element( meshData.bvhTriangles + current.begin, meshData.bvhTriangles + mid,
+                                  meshData.bvhTriangles + current.end,
+                                  BvhCentroidOrder( centroids.begin(), axis ) );
+
+                node.offset = 0u;  // Patched once the second child is created
+                node.numTriangles = 0u;
+                nodes.push_back( node );
+
+                // The first child must be popped first, so it's placed right after us
+                PendingNode secondChild = { mid, current.end, nodeIdx };
+                PendingNode firstChild = { current.begin, mid, std::numeric_limits<size_t>::max() };
+                pending.push_back( secondChild );
+                pending.push_back( firstChild );
             }
+        }
 
-            triVerts[0].x = meshData.vertexData[vertexIdx[0] * 3u + 0];
-            triVerts[0].y = meshData.vertexData[vertexIdx[0] * 3u + 1];
-            triVerts[0].z = meshData.vertexData[vertexIdx[0] * 3u + 2];
-            triVerts[1].x = meshData.vertexData[vertexIdx[1] * 3u + 0];
-            triVerts[1].y = meshData.vertexData[vertexIdx[1] * 3u + 1];
-            triVerts[1].z = meshData.vertexData[vertexIdx[1] * 3u + 2];
-            triVerts[2].x = meshData.vertexData[vertexIdx[2] * 3u + 0];
-            triVerts[2].y = meshData.vertexData[vertexIdx[2] * 3u + 1];
-            triVerts[2].z = meshData.vertexData[vertexIdx[2] * 3u + 2];
-
-            triVerts[0] = worldMatrix * triVerts[0];
-            triVerts[1] = worldMatrix * triVerts[1];
-            triVerts[2] = worldMatrix * triVerts[2];
-
-            Vector3 triNormal =
-                Math::calculateBasicFaceNormalWithoutNormalize( triVerts[0], triVerts[1], triVerts[2] );
-            triNormal.normalise();
-
-            FastArray<size_t>::const_iterator itRayIdx = raysThatHitObj.begin();
-            FastArray<size_t>::const_iterator enRayIdx = raysThatHitObj.end();
-            while( itRayIdx != enRayIdx )
+        meshData.numBvhNodes = nodes.size();
+        meshData.bvhNodes = reinterpret_cast<BvhNode *>(
+            OGRE_MALLOC_SIMD( nodes.size() * sizeof( BvhNode ), MEMCATEGORY_GEOMETRY ) );
+        memcpy( meshData.bvhNodes, nodes.begin(), nodes.size() * sizeof( BvhNode ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::raycastTriangle( const Ray &ray, Real lightRange, const MeshData &meshData,
+                                            const Matrix4 &worldMatrix, uint32 triIdx,
+                                            TriangleHit &inOutBestHit )
+    {
+        uint32 vertexIdx[3];
+        meshData.getTriangle( triIdx, vertexIdx );
+
+        Vector3 triVerts[3];
+        triVerts[0] = worldMatrix * meshData.getVertex( vertexIdx[0] );
+        triVerts[1] = worldMatrix * meshData.getVertex( vertexIdx[1] );
+        triVerts[2] = worldMatrix * meshData.getVertex( vertexIdx[2] );
+
+        Vector3 triNormal =
+            Math::calculateBasicFaceNormalWithoutNormalize( triVerts[0], triVerts[1], triVerts[2] );
+        triNormal.normalise();
+
+        const std::pair<bool, Real> inters =
+            Math::intersects( ray, triVerts[0], triVerts[1], triVerts[2], triNormal, true, false );
+
+        // Same rules as testing every triangle in order: the hit must be closer than any
+        // previous object and within range, and the lowest triangle index wins ties.
+        if( inters.first && inters.second <= lightRange &&
+            ( inters.second < inOutBestHit.distance ||
+              ( inOutBestHit.hasHit && inters.second == inOutBestHit.distance &&
+                triIdx < inOutBestHit.triIdx ) ) )
+        {
+            inOutBestHit.hasHit = true;
+            inOutBestHit.triIdx = triIdx;
+            inOutBestHit.distance = inters.second;
+            for( size_t j = 0; j < 3u; ++j )
             {
-                Ray ray = mRayHits[*itRayIdx].ray;
+                inOutBestHit.vertexIdx[j] = vertexIdx[j];
+                inOutBestHit.triVerts[j] = triVerts[j];
+            }
+            inOutBestHit.triNormal = triNormal;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::raycastLightRayVsMesh( Real lightRange, const MeshData &meshData,
+                                                  const Matrix4 &worldMatrix,
+                                                  const Matrix4 &invWorldMatrix,
+                                                  const MaterialData &material,
+                                                  const size_t *rayIndices, size_t numRays )
+    {
+        uint32 nodeStack[c_bvhMaxDepth];
 
-                const std::pair<bool, Real> inters = Math::intersects(
-                    ray, triVerts[0], triVerts[1], triVerts[2], triNormal, true, false );
+        const uint32 numTriangles = static_cast<uint32>( meshData.getNumTriangles() );
+
+        for( size_t rayIdx = 0; rayIdx < numRays; ++rayIdx )
+        {
+            RayHit &rayHit = mRayHits[rayIndices[rayIdx]];
+            const Ray ray = rayHit.ray;
 
-                if( inters.first )
+            TriangleHit bestHit;
+            bestHit.hasHit = false;
+            bestHit.triIdx = 0;
+            bestHit.distance = rayHit.distance;
+
+            if( !mUseBvh )
+            {
+                for( uint32 triIdx = 0; triIdx < numTriangles; ++triIdx )
+                    raycastTriangle( ray, lightRange, meshData, worldMatrix, triIdx, bestHit );
+            }
+            else
+            {
+                // The direction is intentionally not normalised, so that distances
+                // along the ray are the same in mesh space as in world space.
+                const Vector3 localOrigin = invWorldMatrix.transformAffine( ray.getOrigin() );
+                const Vector3 localDir = invWorldMatrix.transformDirectionAffine( ray.getDirection() );
+                Vector3 localInvDir;
+                for( size_t i = 0; i < 3u; ++i )
+                    localInvDir[i] = localDir[i] != Real( 0 ) ? Real( 1 ) / localDir[i] : Real( 0 );
+
+                size_t stackSize = 0u;
+                nodeStack[stackSize++] = 0u;
+
+                while( stackSize > 0u )
                 {
-                    RayHit &rayHit = mRayHits[*itRayIdx];
-                    if( inters.second < rayHit.distance && inters.second <= lightRange )
+                    const BvhNode &node = meshData.bvhNodes[nodeStack[--stackSize]];
+
+                    // Slightly conservative: the distance in mesh space can be a bit off
+                    const Real maxDistance =
+                        std::min( bestHit.distance, lightRange ) * Real( 1.0001 );
+                    if( !intersectsBvhNode( node.aabbMin, node.aabbMax, localOrigin, localDir,
+                                            localInvDir, maxDistance ) )
                     {
-                        rayHit.distance = inters.second;
-                        rayHit.material = material;
-                        rayHit.triVerts[0] = triVerts[0];
-                        rayHit.triVerts[1] = triVerts[1];
-                        rayHit.triVerts[2] = triVerts[2];
-                        rayHit.triNormal = triNormal;
-
-                        for( int j = 0; j < 5 && material.image[j]; ++j )
-                        {
-                            const uint8 uvSet = material.uvSet[j];
-                            const float *RESTRICT_ALIAS uvPtr = meshData.getUvStart( uvSet );
-                            rayHit.triUVs[j][0].x = uvPtr[vertexIdx[0] * 2u + 0];
-                            rayHit.triUVs[j][0].y = uvPtr[vertexIdx[0] * 2u + 1];
+                        continue;
+                    }
 
-                            rayHit.triUVs[j][1].x = uvPtr[vertexIdx[1] * 2u + 0];
-                            rayHit.triUVs[j][1].y = uvPtr[vertexIdx[1] * 2u + 1];
+                    if( node.numTriangles == 0u )
+                    {
+                        const size_t nodeIdx = static_cast<size_t>( &node - meshData.bvhNodes );
+                        nodeStack[stackSize++] = node.offset;
+                        nodeStack[stackSize++] = static_cast<uint32>( nodeIdx + 1u );
+                        continue;
+                    }
 
-                            rayHit.triUVs[j][2].x = uvPtr[vertexIdx[2] * 2u + 0];
-                            rayHit.triUVs[j][2].y = uvPtr[vertexIdx[2] * 2u + 1];
-                        }
+                    for( uint32 i = 0; i < node.numTriangles; ++i )
+                    {
+                        raycastTriangle( ray, lightRange, meshData, worldMatrix,
+                                         meshData.bvhTriangles[node.offset + i], bestHit );
                     }
                 }
+            }
+
+            if( bestHit.hasHit )
+            {
+                const uint32 *bestVertexIdx = bestHit.vertexIdx;
+
+                rayHit.distance = bestHit.distance;
+                rayHit.material = material;
+                rayHit.triVerts[0] = bestHit.triVerts[0];
+                rayHit.triVerts[1] = bestHit.triVerts[1];
+                rayHit.triVerts[2] = bestHit.triVerts[2];
+                rayHit.triNormal = bestHit.triNormal;
+
+                for( int j = 0; j < 5 && material.image[j]; ++j )
+                {
+                    const uint8 uvSet = material.uvSet[j];
+                    const float *RESTRICT_ALIAS uvPtr = meshData.getUvStart( uvSet );
+                    rayHit.triUVs[j][0].x = uvPtr[bestVertexIdx[0] * 2u + 0];
+                    rayHit.triUVs[j][0].y = uvPtr[bestVertexIdx[0] * 2u + 1];
+
+                    rayHit.triUVs[j][1].x = uvPtr[bestVertexIdx[1] * 2u + 0];
+                    rayHit.triUVs[j][1].y = uvPtr[bestVertexIdx[1] * 2u + 1];
 
-                ++itRayIdx;
+                    rayHit.triUVs[j][2].x = uvPtr[bestVertexIdx[2] * 2u + 0];
+                    rayHit.triUVs[j][2].y = uvPtr[bestVertexIdx[2] * 2u + 1];
+                }
             }
         }
     }
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::raycastJobs( Real lightRange, size_t firstRay, size_t lastRay )
+    {
+        FastArray<RaycastJob>::const_iterator itor = mRaycastJobs.begin();
+        FastArray<RaycastJob>::const_iterator endt = mRaycastJobs.end();
+
+        while( itor != endt )
+        {
+            // Rays are sorted within each job; find the ones in our range
+            const size_t *jobRays = mRaycastJobRays.begin() + itor->rayStart;
+            const size_t *jobRaysEnd = jobRays + itor->numRays;
+            const size_t *begin = std::lower_bound( jobRays, jobRaysEnd, firstRay );
+            const size_t *end = std::lower_bound( begin, jobRaysEnd, lastRay );
+
+            if( begin != end )
+            {
+                raycastLightRayVsMesh( lightRange, *itor->meshData, itor->worldMatrix,
+                                       itor->invWorldMatrix, itor->material, begin,
+                                       static_cast<size_t>( end - begin ) );
+            }
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::executeRaycastJobs( Real lightRange, size_t rayStart, size_t numRays )
+    {
+        const size_t numThreads = mSceneManager->getNumWorkerThreads();
+        if( numThreads > 1u && numRays >= numThreads * c_minRaysPerThread )
+        {
+            RaycastTask task( this, lightRange, rayStart, numRays );
+            mSceneManager->executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            raycastJobs( lightRange, rayStart, rayStart + numRays );
+        }
+
+        mRaycastJobs.clear();
+        mRaycastJobRays.clear();
+    }
+    //-----------------------------------------------------------------------------------
     void InstantRadiosity::updateExistingVpls()
     {
         SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_DYNAMIC );
@@ -1327,10 +1636,7 @@ namespace Ogre
             }
             else if( vpl.light )
             {
-                SceneNode *lightNode = vpl.light->getParentSceneNode();
-                lightNode->getParentSceneNode()->removeAndDestroyChild( lightNode );
-                mSceneManager->destroyLight( vpl.light );
-                vpl.light = 0;
+                destroyVplLight( vpl );
             }
 
             ++itor;
@@ -1340,33 +1646,35 @@ namespace Ogre
             createDebugMarkers();
     }
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::destroyVplLight( Vpl &vpl )
+    {
+        SceneNode *lightNode = vpl.light->getParentSceneNode();
+        lightNode->getParentSceneNode()->removeAndDestroyChild( lightNode );
+        mSceneManager->destroyLight( vpl.light );
+        vpl.light = 0;
+    }
+    //-----------------------------------------------------------------------------------
     void InstantRadiosity::clear()
     {
-        VplVec::const_iterator itor = mVpls.begin();
-        VplVec::const_iterator end = mVpls.end();
+        VplVec::iterator itor = mVpls.begin();
+        VplVec::iterator end = mVpls.end();
 
         while( itor != end )
         {
-            const Vpl &vpl = *itor;
-            if( vpl.light )
-            {
-                SceneNode *lightNode = vpl.light->getParentSceneNode();
-                lightNode->getParentSceneNode()->removeAndDestroyChild( lightNode );
-                mSceneManager->destroyLight( vpl.light );
-            }
-
+            if( itor->light )
+                destroyVplLight( *itor );
             ++itor;
         }
 
         mVpls.clear();
+        mPerLightData.clear();
+        mBuilt = false;
 
         destroyDebugMarkers();
     }
     //-----------------------------------------------------------------------------------
-    void InstantRadiosity::build()
+    bool InstantRadiosity::beginTracing()
     {
-        clear();
-
         if( mNumRayBounces > 0 && ( mSurvivingRayFraction <= 0 || mSurvivingRayFraction > 1.0f ) )
         {
             OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
@@ -1404,11 +1712,6 @@ namespace Ogre
 
         mArrayRays = RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL>( mTotalNumRays );
 
-        const uint32 lightMask = mLightMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
-
-        ObjectMemoryManager &memoryManager = mSceneManager->_getLightMemoryManager();
-        const size_t numRenderQueues = memoryManager.getNumRenderQueues();
-
         bool aoiAutogenerated = false;
         if( mAoI.empty() )
         {
@@ -1416,6 +1719,25 @@ namespace Ogre
             aoiAutogenerated = true;
         }
 
+        return aoiAutogenerated;
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::endTracing( bool aoiAutogenerated )
+    {
+        // Free memory
+        mArrayRays = RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL>();
+
+        if( aoiAutogenerated )
+            mAoI.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::collectLights( FastArray<Light *> &outLights )
+    {
+        const uint32 lightMask = mLightMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
+
+        ObjectMemoryManager &memoryManager = mSceneManager->_getLightMemoryManager();
+        const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+
         for( size_t i = 0; i < numRenderQueues; ++i )
         {
             ObjectData objData;
@@ -1432,53 +1754,272 @@ namespace Ogre
                     {
                         Light *light = static_cast<Light *>( objData.mOwner[k] );
                         if( light->getType() != Light::LT_VPL )
-                        {
-                            Node *lightNode = light->getParentNode();
-                            Vector3 diffuseCol;
-                            ColourValue lightColour = light->getDiffuseColour() * light->getPowerScale();
-                            diffuseCol.x = lightColour.r;
-                            diffuseCol.y = lightColour.g;
-                            diffuseCol.z = lightColour.b;
+                            outLights.push_back( light );
+                    }
+                }
 
-                            Real lightRange = light->getAttenuationRange();
-                            if( light->getType() == Light::LT_DIRECTIONAL )
-                                lightRange = std::numeric_limits<Real>::max();
+                objData.advancePack();
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool InstantRadiosity::hasLightChanged( const Light *light, const PerLightData &lightData )
+    {
+        const Node *lightNode = light->getParentNode();
+        const ColourValue lightColour = light->getDiffuseColour() * light->getPowerScale();
+
+        return lightData.type != light->getType() ||
+               lightData.position != lightNode->_getDerivedPosition() ||
+               lightData.orientation != lightNode->_getDerivedOrientation() ||
+               lightData.colour != Vector3( lightColour.r, lightColour.g, lightColour.b ) ||
+               lightData.range != light->getAttenuationRange() ||
+               lightData.attenConst != light->getAttenuationConstant() ||
+               lightData.attenLinear != light->getAttenuationLinear() ||
+               lightData.attenQuad != light->getAttenuationQuadric() ||
+               lightData.spotOuterAngle != light->getSpotlightOuterAngle();
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::traceLight( Light *light, PerLightData &outLightData )
+    {
+        Node *lightNode = light->getParentNode();
+        const ColourValue lightColour = light->getDiffuseColour() * light->getPowerScale();
+
+        outLightData.position = lightNode->_getDerivedPosition();
+        outLightData.orientation = lightNode->_getDerivedOrientation();
+        outLightData.colour = Vector3( lightColour.r, lightColour.g, lightColour.b );
+        outLightData.range = light->getAttenuationRange();
+        outLightData.attenConst = light->getAttenuationConstant();
+        outLightData.attenLinear = light->getAttenuationLinear();
+        outLightData.attenQuad = light->getAttenuationQuadric();
+        outLightData.spotOuterAngle = light->getSpotlightOuterAngle();
+        outLightData.type = light->getType();
+        outLightData.stillInScene = true;
+
+        Real lightRange = light->getAttenuationRange();
+        if( light->getType() == Light::LT_DIRECTIONAL )
+            lightRange = std::numeric_limits<Real>::max();
+
+        size_t numAoI = mAoI.size();
+
+        if( light->getType() != Light::LT_DIRECTIONAL )
+            numAoI = 1;
+
+        // processLight appends to mVpls. Make it append to this light's VPLs instead
+        outLightData.vpls.clear();
+        mVpls.swap( outLightData.vpls );
+
+        for( size_t l = 0; l < numAoI; ++l )
+        {
+            const AreaOfInterest &areaOfInterest = mAoI[l];
+            processLight( outLightData.position, outLightData.orientation, light->getType(),
+                          light->getSpotlightOuterAngle(), outLightData.colour, lightRange,
+                          light->getAttenuationConstant(), light->getAttenuationLinear(),
+                          light->getAttenuationQuadric(), areaOfInterest );
+        }
 
-                            size_t numAoI = mAoI.size();
+        mVpls.swap( outLightData.vpls );
 
-                            if( light->getType() != Light::LT_DIRECTIONAL )
-                                numAoI = 1;
+        // light->setPowerScale( Math::PI * 4 );
+        // light->setPowerScale( 0 );
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::addVplCells( const VplVec &vpls, SparseClusterSet &outCells ) const
+    {
+        const Real cellSize = Real( 1.0 ) / mCellSize;
 
-                            for( size_t l = 0; l < numAoI; ++l )
-                            {
-                                const AreaOfInterest &areaOfInterest = mAoI[l];
-                                processLight( lightNode->_getDerivedPosition(),
-                                              lightNode->_getDerivedOrientation(), light->getType(),
-                                              light->getSpotlightOuterAngle(), diffuseCol, lightRange,
-                                              light->getAttenuationConstant(),
-                                              light->getAttenuationLinear(),
-                                              light->getAttenuationQuadric(), areaOfInterest );
-                            }
+        VplVec::const_iterator itor = vpls.begin();
+        VplVec::const_iterator end = vpls.end();
 
-                            // light->setPowerScale( Math::PI * 4 );
-                            // light->setPowerScale( 0 );
-                        }
-                    }
+        while( itor != end )
+        {
+            int32 blockHash[3];
+            blockHash[0] = static_cast<int32>( Math::Floor( itor->position.x * cellSize ) );
+            blockHash[1] = static_cast<int32>( Math::Floor( itor->position.y * cellSize ) );
+            blockHash[2] = static_cast<int32>( Math::Floor( itor->position.z * cellSize ) );
+            outCells.insert( SparseCluster( blockHash ) );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::build()
+    {
+        clear();
+
+        const bool aoiAutogenerated = beginTracing();
+
+        FastArray<Light *> lights;
+        collectLights( lights );
+
+        FastArray<Light *>::const_iterator itor = lights.begin();
+        FastArray<Light *>::const_iterator endt = lights.end();
+
+        while( itor != endt )
+        {
+            PerLightData &lightData = mPerLightData[( *itor )->getId()];
+            traceLight( *itor, lightData );
+            mVpls.insert( mVpls.end(), lightData.vpls.begin(), lightData.vpls.end() );
+            ++itor;
+        }
+
+        clusterAllVpls( mVpls );
+
+        updateExistingVpls();
+
+        endTracing( aoiAutogenerated );
+
+        mBuilt = true;
+        // The whole irradiance volume is out of date
+        mIrradianceDirtyArea.setInfinite();
+    }
+    //-----------------------------------------------------------------------------------
+    size_t InstantRadiosity::updateChangedLights()
+    {
+        if( !mBuilt )
+        {
+            build();
+            return mPerLightData.size();
+        }
+
+        // Ensure position data is up to date before comparing.
+        mSceneManager->updateSceneGraph();
+        mSceneManager->clearFrameData();
+
+        FastArray<Light *> lights;
+        collectLights( lights );
+
+        PerLightDataMap::iterator itLightData = mPerLightData.begin();
+        PerLightDataMap::iterator enLightData = mPerLightData.end();
+        while( itLightData != enLightData )
+        {
+            itLightData->second.stillInScene = false;
+            ++itLightData;
+        }
+
+        FastArray<Light *> dirtyLights;
+
+        FastArray<Light *>::const_iterator itor = lights.begin();
+        FastArray<Light *>::const_iterator endt = lights.end();
+        while( itor != endt )
+        {
+            itLightData = mPerLightData.find( ( *itor )->getId() );
+            if( itLightData == mPerLightData.end() || hasLightChanged( *itor, itLightData->second ) )
+                dirtyLights.push_back( *itor );
+            else
+                itLightData->second.stillInScene = true;
+            ++itor;
+        }
+
+        // The cells where the VPLs of the changed lights were, or will be.
+        SparseClusterSet affectedCells;
+        size_t numChangedLights = dirtyLights.size();
+
+        itLightData = mPerLightData.begin();
+        while( itLightData != enLightData )
+        {
+            // Dirty lights are retraced below. Lights no longer in the scene are removed.
+            if( !itLightData->second.stillInScene )
+            {
+                addVplCells( itLightData->second.vpls, affectedCells );
+                bool bDirty = false;
+                for( size_t i = 0u; i < dirtyLights.size() && !bDirty; ++i )
+                    bDirty = dirtyLights[i]->getId() == itLightData->first;
+                if( !bDirty )
+                {
+                    mPerLightData.erase( itLightData++ );
+                    ++numChangedLights;
+                    continue;
                 }
+            }
+            ++itLightData;
+        }
 
-                objData.advancePack();
+        if( !numChangedLights )
+            return 0;
+
+        if( !dirtyLights.empty() )
+        {
+            const bool aoiAutogenerated = beginTracing();
+
+            itor = dirtyLights.begin();
+            endt = dirtyLights.end();
+            while( itor != endt )
+            {
+                PerLightData &lightData = mPerLightData[( *itor )->getId()];
+                traceLight( *itor, lightData );
+                addVplCells( lightData.vpls, affectedCells );
+                ++itor;
             }
+
+            endTracing( aoiAutogenerated );
         }
 
-        clusterAllVpls();
+        const Real cellSize = Real( 1.0 ) / mCellSize;
 
-        updateExistingVpls();
+        // Remove the clusters in the affected cells...
+        VplVec::iterator itVpl = mVpls.begin();
+        VplVec::iterator enVpl = mVpls.end();
+        while( itVpl != enVpl )
+        {
+            int32 blockHash[3];
+            blockHash[0] = static_cast<int32>( Math::Floor( itVpl->position.x * cellSize ) );
+            blockHash[1] = static_cast<int32>( Math::Floor( itVpl->position.y * cellSize ) );
+            blockHash[2] = static_cast<int32>( Math::Floor( itVpl->position.z * cellSize ) );
 
-        // Free memory
-        mArrayRays = RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL>();
+            if( affectedCells.find( blockHash ) != affectedCells.end() )
+            {
+                mIrradianceDirtyArea.merge( AxisAlignedBox( itVpl->position - mVplMaxRange,
+                                                            itVpl->position + mVplMaxRange ) );
+                if( itVpl->light )
+                    destroyVplLight( *itVpl );
+                itVpl = efficientVectorRemove( mVpls, itVpl );
+                enVpl = mVpls.end();
+            }
+            else
+            {
+                ++itVpl;
+            }
+        }
 
-        if( aoiAutogenerated )
-            mAoI.clear();
+        // ...and cluster them again, with the VPLs from every light in those cells.
+        // Same order as in build, so the result is the same.
+        VplVec newVpls;
+        itor = lights.begin();
+        endt = lights.end();
+        while( itor != endt )
+        {
+            const VplVec &lightVpls = mPerLightData[( *itor )->getId()].vpls;
+            VplVec::const_iterator itLightVpl = lightVpls.begin();
+            VplVec::const_iterator enLightVpl = lightVpls.end();
+            while( itLightVpl != enLightVpl )
+            {
+                int32 blockHash[3];
+                blockHash[0] = static_cast<int32>( Math::Floor( itLightVpl->position.x * cellSize ) );
+                blockHash[1] = static_cast<int32>( Math::Floor( itLightVpl->position.y * cellSize ) );
+                blockHash[2] = static_cast<int32>( Math::Floor( itLightVpl->position.z * cellSize ) );
+
+                if( affectedCells.find( blockHash ) != affectedCells.end() )
+                    newVpls.push_back( *itLightVpl );
+                ++itLightVpl;
+            }
+            ++itor;
+        }
+
+        clusterAllVpls( newVpls );
+
+        itVpl = newVpls.begin();
+        enVpl = newVpls.end();
+        while( itVpl != enVpl )
+        {
+            mIrradianceDirtyArea.merge( AxisAlignedBox( itVpl->position - mVplMaxRange,
+                                                        itVpl->position + mVplMaxRange ) );
+            ++itVpl;
+        }
+
+        mVpls.insert( mVpls.end(), newVpls.begin(), newVpls.end() );
+
+        updateExistingVpls();
+
+        return numChangedLights;
     }
     //-----------------------------------------------------------------------------------
     void InstantRadiosity::freeMemory()
@@ -1492,6 +2033,10 @@ namespace Ogre
                 MeshData &meshData = itor->second;
                 OGRE_FREE_SIMD( meshData.vertexData, MEMCATEGORY_GEOMETRY );
                 meshData.vertexData = 0;
+                OGRE_FREE_SIMD( meshData.bvhNodes, MEMCATEGORY_GEOMETRY );
+                meshData.bvhNodes = 0;
+                OGRE_FREE_SIMD( meshData.bvhTriangles, MEMCATEGORY_GEOMETRY );
+                meshData.bvhTriangles = 0;
                 if( meshData.indexData && !itor->first->getIndexBuffer()->getShadowCopy() )
                 {
                     OGRE_FREE_SIMD( meshData.indexData, MEMCATEGORY_GEOMETRY );
@@ -1511,6 +2056,10 @@ namespace Ogre
                 MeshData &meshData = itor->second;
                 OGRE_FREE_SIMD( meshData.vertexData, MEMCATEGORY_GEOMETRY );
                 meshData.vertexData = 0;
+                OGRE_FREE_SIMD( meshData.bvhNodes, MEMCATEGORY_GEOMETRY );
+                meshData.bvhNodes = 0;
+                OGRE_FREE_SIMD( meshData.bvhTriangles, MEMCATEGORY_GEOMETRY );
+                meshData.bvhTriangles = 0;
                 if( meshData.indexData )
                 {
                     OGRE_FREE_SIMD( meshData.indexData, MEMCATEGORY_GEOMETRY );
@@ -1635,6 +2184,16 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::getVpl( size_t idx, Vector3 &outPosition, Vector3 &outNormal,
+                                   Vector3 &outDiffuse ) const
+    {
+        OGRE_ASSERT_LOW( idx < mVpls.size() );
+        const Vpl &vpl = mVpls[idx];
+        outPosition = vpl.position;
+        outNormal = vpl.normal;
+        outDiffuse = vpl.diffuse;
+    }
+    //-----------------------------------------------------------------------------------
     void InstantRadiosity::suggestIrradianceVolumeParameters(
         const Vector3 &cellSize, Vector3 &outVolumeOrigin, Real &outLightMaxPower, uint32 &outNumBlocksX,
         uint32 &outNumBlocksY, uint32 &outNumBlocksZ )
@@ -1729,21 +2288,91 @@ namespace Ogre
         volume->setPowerScale( mVplPowerBoost );
         volume->setFadeAttenuationOverDistace( fadeAttenuationOverDistance );
 
-        const int32 volumeOriginX = static_cast<int32>( volumeOrigin.x );
-        const int32 volumeOriginY = static_cast<int32>( volumeOrigin.y );
-        const int32 volumeOriginZ = static_cast<int32>( volumeOrigin.z );
+        volume->clearVolumeData();
+
+        const int32 regionMin[3] = { 0, 0, 0 };
+        const int32 regionMax[3] = { static_cast<int32>( volume->getNumBlocksX() ) - 1,
+                                     static_cast<int32>( volume->getNumBlocksY() ) - 1,
+                                     static_cast<int32>( volume->getNumBlocksZ() ) - 1 };
+        addVplsToIrradianceVolume( volume, regionMin, regionMax );
 
-        const Real invMaxPower = 1.0f / lightMaxPower;
+        volume->updateIrradianceVolumeTexture();
+
+        mIrradianceDirtyArea.setNull();
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::updateIrradianceVolume( IrradianceVolume *volume )
+    {
+        if( !volume || mIrradianceDirtyArea.isNull() )
+            return;
+
+        if( !volume->hasVolumeData() || mIrradianceDirtyArea.isInfinite() )
+        {
+            fillIrradianceVolume( volume, volume->getIrradianceCellSize(),
+                                  volume->getIrradianceOrigin(), volume->getIrradianceMaxPower(),
+                                  volume->getFadeAttenuationOverDistace() );
+            return;
+        }
+
+        const Vector3 cellSize = volume->getIrradianceCellSize();
+        const Vector3 invCellSize = Real( 1.0 ) / cellSize;
+        const Vector3 volumeOrigin = volume->getIrradianceOrigin();
 
-        const int32 numBlocksX = static_cast<int32>( volume->getNumBlocksX() );
-        const int32 numBlocksY = static_cast<int32>( volume->getNumBlocksY() );
-        const int32 numBlocksZ = static_cast<int32>( volume->getNumBlocksZ() );
+        const int32 numBlocks[3] = { static_cast<int32>( volume->getNumBlocksX() ),
+                                     static_cast<int32>( volume->getNumBlocksY() ),
+                                     static_cast<int32>( volume->getNumBlocksZ() ) };
+
+        int32 regionMin[3];
+        int32 regionMax[3];
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            const Real originBlock = Math::Floor( volumeOrigin[i] * invCellSize[i] + Real( 0.5 ) );
+            regionMin[i] = static_cast<int32>(
+                Math::Floor( mIrradianceDirtyArea.getMinimum()[i] * invCellSize[i] ) - originBlock );
+            regionMax[i] = static_cast<int32>(
+                Math::Floor( mIrradianceDirtyArea.getMaximum()[i] * invCellSize[i] ) - originBlock );
+            regionMin[i] = std::max( regionMin[i], 0 );
+            regionMax[i] = std::min( regionMax[i], numBlocks[i] - 1 );
+        }
+
+        mIrradianceDirtyArea.setNull();
+
+        if( regionMin[0] > regionMax[0] || regionMin[1] > regionMax[1] || regionMin[2] > regionMax[2] )
+            return;  // The changes are outside the volume
+
+        volume->setPowerScale( mVplPowerBoost );
+        volume->clearVolumeData( static_cast<uint32>( regionMin[0] ), static_cast<uint32>( regionMin[1] ),
+                                 static_cast<uint32>( regionMin[2] ), static_cast<uint32>( regionMax[0] ),
+                                 static_cast<uint32>( regionMax[1] ),
+                                 static_cast<uint32>( regionMax[2] ) );
+        addVplsToIrradianceVolume( volume, regionMin, regionMax );
+
+        volume->updateIrradianceVolumeTexture();
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::addVplsToIrradianceVolume( IrradianceVolume *volume,
+                                                      const int32 regionMin[3],
+                                                      const int32 regionMax[3] )
+    {
+        const Vector3 cellSize = volume->getIrradianceCellSize();
+        const Vector3 invCellSize = Real( 1.0 ) / cellSize;
+        const Real lightMaxPower = volume->getIrradianceMaxPower();
+        const bool fadeAttenuationOverDistance = volume->getFadeAttenuationOverDistace();
+
+        // The origin is already quantized
+        const Vector3 volumeOrigin = volume->getIrradianceOrigin();
+        const int32 volumeOriginX =
+            static_cast<int32>( Math::Floor( volumeOrigin.x * invCellSize.x + Real( 0.5 ) ) );
+        const int32 volumeOriginY =
+            static_cast<int32>( Math::Floor( volumeOrigin.y * invCellSize.y + Real( 0.5 ) ) );
+        const int32 volumeOriginZ =
+            static_cast<int32>( Math::Floor( volumeOrigin.z * invCellSize.z + Real( 0.5 ) ) );
+
+        const Real invMaxPower = 1.0f / lightMaxPower;
 
         VplVec::const_iterator itor = mVpls.begin();
         VplVec::const_iterator end = mVpls.end();
 
-        volume->clearVolumeData();
-
         const Vector3 c_directions[6] = {
             Vector3( 1, 0, 0 ),  Vector3( -1, 0, 0 ), Vector3( 0, 1, 0 ),
             Vector3( 0, -1, 0 ), Vector3( 0, 0, 1 ),  Vector3( 0, 0, -1 )
@@ -1780,16 +2409,15 @@ namespace Ogre
             blockY -= volumeOriginY;
             blockZ -= volumeOriginZ;
 
-            const int32 minBlockX = std::max( 0, blockX - xRange );
-            const int32 minBlockY = std::max( 0, blockY - yRange );
-            const int32 minBlockZ = std::max( 0, blockZ - zRange );
+            const int32 minBlockX = std::max( regionMin[0], blockX - xRange );
+            const int32 minBlockY = std::max( regionMin[1], blockY - yRange );
+            const int32 minBlockZ = std::max( regionMin[2], blockZ - zRange );
 
-            const int32 maxBlockX = std::min( numBlocksX - 1, blockX + xRange );
-            const int32 maxBlockY = std::min( numBlocksY - 1, blockY + yRange );
-            const int32 maxBlockZ = std::min( numBlocksZ - 1, blockZ + zRange );
+            const int32 maxBlockX = std::min( regionMax[0], blockX + xRange );
+            const int32 maxBlockY = std::min( regionMax[1], blockY + yRange );
+            const int32 maxBlockZ = std::min( regionMax[2], blockZ + zRange );
 
-            if( maxBlockX >= 0 && minBlockX < numBlocksX && maxBlockY >= 0 && minBlockY < numBlocksY &&
-                maxBlockZ >= 0 && minBlockZ < numBlocksZ )
+            if( minBlockX <= maxBlockX && minBlockY <= maxBlockY && minBlockZ <= maxBlockZ )
             {
                 for( int32 z = minBlockZ; z <= maxBlockZ; ++z )
                 {
@@ -1843,8 +2471,6 @@ namespace Ogre
 
             ++itor;
         }
-
-        volume->updateIrradianceVolumeTexture();
     }
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
@@ -1895,4 +2521,45 @@ namespace Ogre
     {
         return vertexData + numVertices * 3u + uvSet * 2u;
     }
+    //-----------------------------------------------------------------------------------
+    size_t InstantRadiosity::MeshData::getNumTriangles() const
+    {
+        return ( indexData ? numIndices : numVertices ) / 3u;
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::MeshData::getTriangle( size_t triIdx, uint32 outVertexIdx[3] ) const
+    {
+        const size_t i = triIdx * 3u;
+        if( indexData )
+        {
+            if( useIndices16bit )
+            {
+                const uint16 *RESTRICT_ALIAS indexData16 =
+                    reinterpret_cast<const uint16 * RESTRICT_ALIAS>( indexData );
+                outVertexIdx[0] = indexData16[i + 0];
+                outVertexIdx[1] = indexData16[i + 1];
+                outVertexIdx[2] = indexData16[i + 2];
+            }
+            else
+            {
+                const uint32 *RESTRICT_ALIAS indexData32 =
+                    reinterpret_cast<const uint32 * RESTRICT_ALIAS>( indexData );
+                outVertexIdx[0] = indexData32[i + 0];
+                outVertexIdx[1] = indexData32[i + 1];
+                outVertexIdx[2] = indexData32[i + 2];
+            }
+        }
+        else
+        {
+            outVertexIdx[0] = uint32( i + 0u );
+            outVertexIdx[1] = uint32( i + 1u );
+            outVertexIdx[2] = uint32( i + 2u );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    Vector3 InstantRadiosity::MeshData::getVertex( uint32 vertexIdx ) const
+    {
+        return Vector3( vertexData[vertexIdx * 3u + 0], vertexData[vertexIdx * 3u + 1],
+                        vertexData[vertexIdx * 3u + 2] );
+    }
 }  // namespace Ogre
@@ -356,6 +356,27 @@ namespace Ogre
         }
     }
 
+    void IrradianceVolume::clearVolumeData( uint32 minX, uint32 minY, uint32 minZ, uint32 maxX,
+                                            uint32 maxY, uint32 maxZ )
+    {
+        assert( mVolumeData );
+        assert( maxX < mNumBlocksX && maxY < mNumBlocksY && maxZ < mNumBlocksZ );
+
+        const size_t bytesPerRow = ( maxX - minX + 1u ) * 3u * sizeof( float );
+
+        for( size_t z = minZ; z <= maxZ; ++z )
+        {
+            for( size_t y = minY; y <= maxY; ++y )
+            {
+                for( size_t i = 0; i < 6u; ++i )
+                {
+                    const size_t idx = z * mSlicePitch + ( y * 6u + i ) * mRowPitch + minX * 3u;
+                    memset( mVolumeData + idx, 0, bytesPerRow );
+                }
+            }
+        }
+    }
+
     void IrradianceVolume::updateIrradianceVolumeTexture()
     {
         const uint32 texWidth = mIrradianceVolume->getWidth();
@@ -189,6 +189,9 @@ namespace Ogre
         const HlmsCache *retVal =
             Hlms::createShaderCacheEntry( renderableHash, passCache, finalHash, queuedRenderable );
 
+        if( !retVal )
+            return retVal;  // Still being generated asynchronously. See setAsyncShaderGeneration
+
         if( mShaderProfile != "glsl" )
         {
             mListener->shaderCacheEntryCreated( mShaderProfile, retVal, passCache, mSetProperties,
@@ -131,6 +131,8 @@ namespace Ogre
         Real mLoadRadius;
         /// Hold radius
         Real mHoldRadius;
+        /// Time to look ahead for page prefetching, 0 to disable
+        Real mPrefetchTime;
         Real mLoadRadiusInCells;
         Real mHoldRadiusInCells;
         int32 mMinCellX;
@@ -169,6 +171,16 @@ namespace Ogre
         virtual void setHoldRadius(Real sz);
         /// Get the Holding radius 
         virtual Real getHoldRadius() const { return mHoldRadius; }
+        /** Set how far ahead, in seconds, pages are prefetched along the camera's motion.
+        @remarks
+            Pages within the load radius of where the camera will be after this time
+            (at its current velocity) start loading in advance. The prediction never
+            goes further than the hold radius. This is a runtime setting and is not
+            saved. Default is 0 (disabled).
+        */
+        virtual void setPrefetchTime(Real seconds) { mPrefetchTime = seconds; }
+        /// Get how far ahead, in seconds, pages are prefetched along the camera's motion
+        virtual Real getPrefetchTime() const { return mPrefetchTime; }
         /// Get the load radius as a multiple of cells
         virtual Real getLoadRadiusInCells() { return mLoadRadiusInCells; }
         /// Get the Hold radius as a multiple of cells
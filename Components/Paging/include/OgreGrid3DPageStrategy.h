@@ -114,6 +114,8 @@ namespace Ogre
         Real mLoadRadius;
         /// Hold radius
         Real mHoldRadius;
+        /// Time to look ahead for page prefetching, 0 to disable
+        Real mPrefetchTime;
         int32 mMinCellX;
         int32 mMinCellY;
         int32 mMinCellZ;
@@ -144,6 +146,16 @@ namespace Ogre
         virtual void setHoldRadius(Real sz);
         /// Get the Holding radius 
         virtual Real getHoldRadius() const { return mHoldRadius; }
+        /** Set how far ahead, in seconds, pages are prefetched along the camera's motion.
+        @remarks
+            Pages within the load radius of where the camera will be after this time
+            (at its current velocity) start loading in advance. The prediction never
+            goes further than the hold radius. This is a runtime setting and is not
+            saved. Default is 0 (disabled).
+        */
+        virtual void setPrefetchTime(Real seconds) { mPrefetchTime = seconds; }
+        /// Get how far ahead, in seconds, pages are prefetched along the camera's motion
+        virtual Real getPrefetchTime() const { return mPrefetchTime; }
 
         /// Set the index range of all cells (values outside this will be ignored)
         virtual void setCellRange(int32 minX, int32 minY, int32 minZ, int32 maxX, int32 maxY, int32 maxZ);
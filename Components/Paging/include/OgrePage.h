@@ -57,6 +57,9 @@ namespace Ogre
         unsigned long mFrameLastHeld;
         ContentCollectionList mContentCollections;
         uint16 mWorkQueueChannel;
+        /// Priority of the load request. See setLoadPriority
+        int16 mLoadPriority;
+        WorkQueue::RequestID mLoadRequestID;
         bool mDeferredProcessInProgress;
         bool mModified;
 
@@ -126,6 +129,14 @@ namespace Ogre
         @param synchronous Whether to force this to happen synchronously.
         */
         virtual void load(bool synchronous);
+        /** Set the priority of the background load request of this page.
+        @remarks
+            Pages with a higher priority are prepared first. If the page is still
+            waiting to be prepared, the pending request is re-prioritised.
+            See WorkQueue::addPrioritisedRequest
+        */
+        void setLoadPriority(int16 priority);
+        int16 getLoadPriority() const { return mLoadPriority; }
         /** Unload this page. 
         */
         virtual void unload();
@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "OgreCamera.h"
 #include "OgreFrameListener.h"
 #include "OgreNameGenerator.h"
+#include "Threading/OgreThreadHeaders.h"
+#include "ogrestd/list.h"
 
 namespace Ogre
 {
@@ -432,6 +434,65 @@ namespace Ogre
         /** Get whether paging operations are currently allowed to happen. */
         bool getPagingOperationsEnabled() const { return mPagingEnabled; }
 
+        /** Set the maximum amount of memory, in bytes, used to keep the contents of
+            page files that were read recently.
+        @remarks
+            Pages that fall out of the hold range are destroyed, so a camera that
+            travels back and forth over the same area would keep reading the same
+            page files again and again. When the budget is greater than 0, the raw
+            contents of every page file read through the default routines are kept
+            in a least-recently-used cache and revisited pages are prepared from
+            memory instead. Procedural pages and pages supplied by a PageProvider
+            are not cached.
+        @par
+            Lowering the budget evicts pages immediately. Default is 0 (disabled).
+        */
+        void setPageCacheBudget(size_t bytes);
+        /** Get the maximum amount of memory, in bytes, used by the page cache. */
+        size_t getPageCacheBudget() const;
+        /** Get the amount of memory, in bytes, currently used by the page cache. */
+        size_t getPageCacheMemoryUsage() const;
+        /** Get the number of page reads served from the page cache. */
+        size_t getPageCacheHits() const;
+        /** Get the number of page reads that had to go to the page file. */
+        size_t getPageCacheMisses() const;
+        /** Remove all pages from the page cache, and reset the hit & miss counters. */
+        void clearPageCache();
+        /** Get the cached contents of a page file.
+        @remarks
+            You should not call this method directly. May be called from a background thread.
+        @param outGeneration The current generation of the file, which must be passed to
+            _addCachedPageData if the file is read because it wasn't cached.
+        @return The contents of the file, or a null pointer if it isn't cached. Counts as
+            a cache hit or miss.
+        */
+        MemoryDataStreamPtr _getCachedPageData(const String& filename, uint32& outGeneration);
+        /** Add the contents of a page file to the page cache, evicting the least recently
+            used pages if the budget is exceeded.
+        @remarks
+            You should not call this method directly. May be called from a background thread.
+        @param generation The generation returned by _getCachedPageData before the file
+            was read. If the file was removed from the cache since then, i.e. because it
+            was saved while being read, the data is stale and is not added.
+        */
+        void _addCachedPageData(const String& filename, const MemoryDataStreamPtr& data,
+            uint32 generation);
+        /** Remove a page file from the page cache, i.e. because it was saved. 
+        @remarks
+            You should not call this method directly. May be called from a background thread.
+            Increments the generation of the file, so that reads still in flight can't
+            add the old contents back.
+        */
+        void _removeCachedPageData(const String& filename);
+
+        /** Get the velocity of a tracked camera, in world units per second.
+        @remarks
+            It is measured between the last two frames, and is used by the page
+            strategies to prefetch the pages the camera is heading to.
+        @return The velocity, or Vector3::ZERO if the camera is not tracked.
+        */
+        const Vector3& getCameraVelocity(Camera* c) const;
+
 
     protected:
 
@@ -453,6 +514,28 @@ namespace Ogre
 
         void createStandardStrategies();
         void createStandardContentFactories();
+        /// Must be called with mPageCacheMutex locked
+        void evictCachedPages(size_t budget);
+        void updateCameraMotion(Real timeSinceLastFrame);
+
+        struct CachedPage
+        {
+            String filename;
+            MemoryDataStreamPtr data;
+        };
+        /// Most recently used pages are at the front
+        typedef list<CachedPage>::type CachedPageList;
+        typedef map<String, CachedPageList::iterator>::type CachedPageMap;
+        /// Number of times each file was removed from the cache. Files never removed
+        /// are at generation 0 and aren't stored
+        typedef map<String, uint32>::type PageGenerationMap;
+
+        struct CameraMotion
+        {
+            Vector3 lastPosition;
+            Vector3 velocity;
+        };
+        typedef map<Camera*, CameraMotion>::type CameraMotionMap;
 
         WorldMap mWorlds;
         StrategyMap mStrategies;
@@ -463,6 +546,7 @@ namespace Ogre
         PageProvider* mPageProvider;
         String mPageResourceGroup;
         CameraList mCameraList;
+        CameraMotionMap mCameraMotion;
         EventRouter mEventRouter;
         uint8 mDebugDisplayLvl;
         bool mPagingEnabled;
@@ -470,6 +554,15 @@ namespace Ogre
         Grid2DPageStrategy* mGrid2DPageStrategy;
         Grid3DPageStrategy* mGrid3DPageStrategy;
         SimplePageContentCollectionFactory* mSimpleCollectionFactory;
+
+        CachedPageList mCachedPages;
+        CachedPageMap mCachedPageMap;
+        PageGenerationMap mPageGenerations;
+        size_t mPageCacheBudget;
+        size_t mPageCacheMemoryUsage;
+        size_t mPageCacheHits;
+        size_t mPageCacheMisses;
+        OGRE_MUTEX(mPageCacheMutex);
     };
 
     /** @} */
@@ -129,6 +129,18 @@ namespace Ogre
         @return The page ID
         */
         virtual PageID getPageID(const Vector3& worldPos, PagedWorldSection* section) = 0;
+
+        /** Load priority (see PagedWorldSection::loadPage) for a page at the given
+            distance from the camera, in cells. Nearer pages get higher priorities.
+        */
+        static int16 getLoadPriority(Real distanceInCells)
+        {
+            // A tenth of a cell of resolution; far away pages share the lowest priority
+            const Real priority = -distanceInCells * 10.0f;
+            if (priority <= (Real)std::numeric_limits<int16>::min())
+                return std::numeric_limits<int16>::min();
+            return (int16)priority;
+        }
     };
 
     /*@}*/
@@ -84,6 +84,13 @@ namespace Ogre
         virtual void loadSubtypeData(StreamSerialiser& ser) {}
         virtual void saveSubtypeData(StreamSerialiser& ser) {}
 
+        /** Implementation of loadPage and loadPageWithPriority.
+        @remarks
+            Subclasses wanting to see every load request should override this.
+        @param priority Priority of the load request, see Page::setLoadPriority.
+        */
+        virtual void loadPageImpl(PageID pageID, bool forceSynchronous, int16 priority);
+
 
     public:
         static const uint32 CHUNK_ID;
@@ -177,6 +184,12 @@ namespace Ogre
         */
         virtual void loadPage(PageID pageID, bool forceSynchronous = false);
 
+        /** Same as loadPage, but with a priority for the load request.
+        @param priority Priority of the load request, see Page::setLoadPriority.
+            PageStrategy::getLoadPriority derives it from the distance to the camera.
+        */
+        void loadPageWithPriority(PageID pageID, int16 priority, bool forceSynchronous = false);
+
         /** Ask for a page to be unloaded with the given (section-relative) PageID
         @remarks
             You would not normally call this manually, the PageStrategy is in 
@@ -52,7 +52,7 @@ namespace Ogre
     class SimplePageContentCollectionFactory;
 
 
-    typedef GeneralAllocatedObject PageAlloc;
+    typedef OgreAllocatedObj PageAlloc;
 
     /// Identifier for a page
     typedef uint32 PageID;
@@ -52,6 +52,7 @@ namespace Ogre
         , mCellSize(1000)
         , mLoadRadius(2000)
         , mHoldRadius(3000)
+        , mPrefetchTime(0)
         , mMinCellX(-32768)
         , mMinCellY(-32768)
         , mMaxCellX(32767)
@@ -337,8 +338,9 @@ namespace Ogre
                 PageID pageID = stratData->calculatePageID(cx, cy);
                 if (cx >= loadxmin && cx <= loadxmax && cy >= loadymin && cy <= loadymax)
                 {
-                    // in the 'load' range, request it
-                    section->loadPage(pageID);
+                    // in the 'load' range, request it. Nearest first
+                    const Real dist = Math::Sqrt(Real((cx - x) * (cx - x) + (cy - y) * (cy - y)));
+                    section->loadPageWithPriority(pageID, getLoadPriority(dist));
                 }
                 else
                 {
@@ -348,9 +350,49 @@ namespace Ogre
                 // other pages will by inference be marked for unloading
             }
         }   
-        
-
 
+        Real prefetchTime = stratData->getPrefetchTime();
+        if (prefetchTime > 0)
+        {
+            // predict where the camera is heading, but no further than the hold range
+            Vector3 offset = mManager->getCameraVelocity(cam) * prefetchTime;
+            Real maxOffset = stratData->getHoldRadius();
+            if (offset.squaredLength() > maxOffset * maxOffset)
+                offset *= maxOffset / offset.length();
+
+            Vector2 predictedGridPos;
+            stratData->convertWorldToGridSpace(pos + offset, predictedGridPos);
+            int32 px, py;
+            stratData->determineGridLocation(predictedGridPos, &px, &py);
+
+            if (px != x || py != y)
+            {
+                fxmin = (Real)px - loadRadius;
+                fxmax = (Real)px + loadRadius;
+                fymin = (Real)py - loadRadius;
+                fymax = (Real)py + loadRadius;
+                int32 prefetchxmin = std::max((int32)floor(fxmin), stratData->getCellRangeMinX());
+                int32 prefetchxmax = std::min((int32)ceil(fxmax), stratData->getCellRangeMaxX());
+                int32 prefetchymin = std::max((int32)floor(fymin), stratData->getCellRangeMinY());
+                int32 prefetchymax = std::min((int32)ceil(fymax), stratData->getCellRangeMaxY());
+
+                for (int32 cy = prefetchymin; cy <= prefetchymax; ++cy)
+                {
+                    for (int32 cx = prefetchxmin; cx <= prefetchxmax; ++cx)
+                    {
+                        // the active load range was already requested above
+                        if (cx < loadxmin || cx > loadxmax || cy < loadymin || cy > loadymax)
+                        {
+                            // still prioritised by the distance to where the camera is now
+                            const Real dist =
+                                Math::Sqrt(Real((cx - x) * (cx - x) + (cy - y) * (cy - y)));
+                            section->loadPageWithPriority(stratData->calculatePageID(cx, cy),
+                                getLoadPriority(dist));
+                        }
+                    }
+                }
+            }
+        }
     }
     //---------------------------------------------------------------------
     PageStrategyData* Grid2DPageStrategy::createData()
@@ -52,6 +52,7 @@ namespace Ogre
         , mCellSize(1000,1000,1000)
         , mLoadRadius(2000)
         , mHoldRadius(3000)
+        , mPrefetchTime(0)
         , mMinCellX(-512)
         , mMinCellY(-512)
         , mMinCellZ(-512)
@@ -306,7 +307,12 @@ namespace Ogre
                         Ogre::AxisAlignedBox bbox(bl, bl+stratData->getCellSize());
 
                         if( cam->isVisible(bbox) )
-                            section->loadPage(pageID);
+                        {
+                            // nearest first
+                            const Real dist = Math::Sqrt(Real((cx - x) * (cx - x) +
+                                (cy - y) * (cy - y) + (cz - z) * (cz - z)));
+                            section->loadPageWithPriority(pageID, getLoadPriority(dist));
+                        }
                         else
                             section->holdPage(pageID);
                     }
@@ -319,6 +325,56 @@ namespace Ogre
                 }
             }
         }
+
+        Real prefetchTime = stratData->getPrefetchTime();
+        if (prefetchTime > 0)
+        {
+            // predict where the camera is heading, but no further than the hold range
+            Vector3 offset = mManager->getCameraVelocity(cam) * prefetchTime;
+            if (offset.squaredLength() > holdRadius * holdRadius)
+                offset *= holdRadius / offset.length();
+
+            int32 px, py, pz;
+            stratData->determineGridLocation(pos + offset, &px, &py, &pz);
+
+            if (px != x || py != y || pz != z)
+            {
+                const Vector3 cellSize = stratData->getCellSize();
+                int32 prefetchxmin = std::max((int32)floor((Real)px - loadRadius/cellSize.x), 
+                    stratData->getCellRangeMinX());
+                int32 prefetchxmax = std::min((int32)ceil((Real)px + loadRadius/cellSize.x), 
+                    stratData->getCellRangeMaxX());
+                int32 prefetchymin = std::max((int32)floor((Real)py - loadRadius/cellSize.y), 
+                    stratData->getCellRangeMinY());
+                int32 prefetchymax = std::min((int32)ceil((Real)py + loadRadius/cellSize.y), 
+                    stratData->getCellRangeMaxY());
+                int32 prefetchzmin = std::max((int32)floor((Real)pz - loadRadius/cellSize.z), 
+                    stratData->getCellRangeMinZ());
+                int32 prefetchzmax = std::min((int32)ceil((Real)pz + loadRadius/cellSize.z), 
+                    stratData->getCellRangeMaxZ());
+
+                for (int32 cz = prefetchzmin; cz <= prefetchzmax; ++cz)
+                {
+                    for (int32 cy = prefetchymin; cy <= prefetchymax; ++cy)
+                    {
+                        for (int32 cx = prefetchxmin; cx <= prefetchxmax; ++cx)
+                        {
+                            // the active load range was already handled above
+                            if (cx < loadxmin || cx > loadxmax 
+                             || cy < loadymin || cy > loadymax
+                             || cz < loadzmin || cz > loadzmax)
+                            {
+                                // still prioritised by the distance to where the camera is now
+                                const Real dist = Math::Sqrt(Real((cx - x) * (cx - x) +
+                                    (cy - y) * (cy - y) + (cz - z) * (cz - z)));
+                                section->loadPageWithPriority(
+                                    stratData->calculatePageID(cx, cy, cz), getLoadPriority(dist));
+                            }
+                        }
+                    }
+                }
+            }
+        }
     }
     //---------------------------------------------------------------------
     PageStrategyData* Grid3DPageStrategy::createData()
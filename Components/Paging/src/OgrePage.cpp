@@ -56,6 +56,8 @@ namespace Ogre
     Page::Page(PageID pageID, PagedWorldSection* parent)
         : mID(pageID)
         , mParent(parent)
+        , mLoadPriority(0)
+        , mLoadRequestID(0)
         , mDeferredProcessInProgress(false)
         , mModified(false)
         , mDebugNode(0)
@@ -188,12 +190,22 @@ namespace Ogre
             destroyAllContentCollections();
             PageRequest req(this);
             mDeferredProcessInProgress = true;
-            Root::getSingleton().getWorkQueue()->addRequest(mWorkQueueChannel, WORKQUEUE_PREPARE_REQUEST, 
-                Any(req), 0, synchronous);
+            mLoadRequestID = Root::getSingleton().getWorkQueue()->addPrioritisedRequest(
+                mWorkQueueChannel, WORKQUEUE_PREPARE_REQUEST, Any(req), mLoadPriority, 0, 0, synchronous);
         }
 
     }
     //---------------------------------------------------------------------
+    void Page::setLoadPriority(int16 priority)
+    {
+        if (mLoadPriority == priority)
+            return;
+
+        mLoadPriority = priority;
+        if (mDeferredProcessInProgress && mLoadRequestID)
+            Root::getSingleton().getWorkQueue()->setRequestPriority(mLoadRequestID, priority);
+    }
+    //---------------------------------------------------------------------
     void Page::unload()
     {
         destroyAllContentCollections();
@@ -284,9 +296,34 @@ namespace Ogre
         {
             // Background loading
             String filename = generateFilename();
+            PageManager* mgr = getManager();
+
+            // Keeps the cached data alive while we parse it, even if it gets evicted
+            MemoryDataStreamPtr cachedData;
+            uint32 cacheGeneration = 0;
+            if (mgr->getPageCacheBudget() > 0)
+                cachedData = mgr->_getCachedPageData(filename, cacheGeneration);
+
+            DataStreamPtr stream;
+            if (!cachedData)
+            {
+                stream = Root::getSingleton().openFileStream(filename, 
+                    mgr->getPageResourceGroup());
+
+                if (mgr->getPageCacheBudget() > 0)
+                {
+                    cachedData.reset(OGRE_NEW MemoryDataStream(stream, true, true));
+                    mgr->_addCachedPageData(filename, cachedData, cacheGeneration);
+                }
+            }
+
+            if (cachedData)
+            {
+                // Read through a view, the cached stream may be in use by other threads
+                stream.reset(OGRE_NEW MemoryDataStream(cachedData->getPtr(), cachedData->size(), 
+                    false, true));
+            }
 
-            DataStreamPtr stream = Root::getSingleton().openFileStream(filename, 
-                getManager()->getPageResourceGroup());
             StreamSerialiser ser(stream);
             return prepareImpl(ser, dataToPopulate);
         }
@@ -315,8 +352,15 @@ namespace Ogre
     {
         DataStreamPtr stream = Root::getSingleton().createFileStream(filename, 
             getManager()->getPageResourceGroup(), true);
-        StreamSerialiser ser(stream);
-        save(ser);
+        {
+            StreamSerialiser ser(stream);
+            save(ser);
+        }
+        stream->close();
+
+        // The cached contents are now stale. Must be done once the file is complete,
+        // otherwise a background prepare could cache a partially written file.
+        getManager()->_removeCachedPageData(filename);
     }
     //---------------------------------------------------------------------
     void Page::save(StreamSerialiser& stream)
@@ -51,6 +51,10 @@ namespace Ogre
         , mGrid2DPageStrategy(0)
         , mGrid3DPageStrategy(0)
         , mSimpleCollectionFactory(0)
+        , mPageCacheBudget(0)
+        , mPageCacheMemoryUsage(0)
+        , mPageCacheHits(0)
+        , mPageCacheMisses(0)
     {
 
         mEventRouter.pManager = this;
@@ -477,6 +481,10 @@ namespace Ogre
         {
             mCameraList.push_back(c);
             c->addListener(&mEventRouter);
+
+            CameraMotion& motion = mCameraMotion[c];
+            motion.lastPosition = c->getDerivedPosition();
+            motion.velocity = Vector3::ZERO;
         }
     }
     //---------------------------------------------------------------------
@@ -487,6 +495,7 @@ namespace Ogre
         {
             c->removeListener(&mEventRouter);
             mCameraList.erase(i);
+            mCameraMotion.erase(c);
         }
     }
     //---------------------------------------------------------------------
@@ -501,6 +510,142 @@ namespace Ogre
     }
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
+    const Vector3& PageManager::getCameraVelocity(Camera* c) const
+    {
+        CameraMotionMap::const_iterator i = mCameraMotion.find(c);
+        if (i != mCameraMotion.end())
+            return i->second.velocity;
+        return Vector3::ZERO;
+    }
+    //---------------------------------------------------------------------
+    void PageManager::updateCameraMotion(Real timeSinceLastFrame)
+    {
+        for (CameraMotionMap::iterator i = mCameraMotion.begin(); i != mCameraMotion.end(); ++i)
+        {
+            const Vector3& pos = i->first->getDerivedPosition();
+            CameraMotion& motion = i->second;
+            if (timeSinceLastFrame > 0)
+                motion.velocity = (pos - motion.lastPosition) / timeSinceLastFrame;
+            motion.lastPosition = pos;
+        }
+    }
+    //---------------------------------------------------------------------
+    void PageManager::setPageCacheBudget(size_t bytes)
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        mPageCacheBudget = bytes;
+        evictCachedPages(mPageCacheBudget);
+    }
+    //---------------------------------------------------------------------
+    size_t PageManager::getPageCacheBudget() const
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        return mPageCacheBudget;
+    }
+    //---------------------------------------------------------------------
+    size_t PageManager::getPageCacheMemoryUsage() const
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        return mPageCacheMemoryUsage;
+    }
+    //---------------------------------------------------------------------
+    size_t PageManager::getPageCacheHits() const
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        return mPageCacheHits;
+    }
+    //---------------------------------------------------------------------
+    size_t PageManager::getPageCacheMisses() const
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        return mPageCacheMisses;
+    }
+    //---------------------------------------------------------------------
+    void PageManager::clearPageCache()
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        evictCachedPages(0);
+        mPageCacheHits = 0;
+        mPageCacheMisses = 0;
+    }
+    //---------------------------------------------------------------------
+    MemoryDataStreamPtr PageManager::_getCachedPageData(const String& filename,
+        uint32& outGeneration)
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        PageGenerationMap::const_iterator g = mPageGenerations.find(filename);
+        outGeneration = g != mPageGenerations.end() ? g->second : 0;
+
+        CachedPageMap::iterator i = mCachedPageMap.find(filename);
+        if (i == mCachedPageMap.end())
+        {
+            ++mPageCacheMisses;
+            return MemoryDataStreamPtr();
+        }
+
+        ++mPageCacheHits;
+        // Move to the front, it's now the most recently used
+        mCachedPages.splice(mCachedPages.begin(), mCachedPages, i->second);
+        return i->second->data;
+    }
+    //---------------------------------------------------------------------
+    void PageManager::_addCachedPageData(const String& filename, const MemoryDataStreamPtr& data,
+        uint32 generation)
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        if (data->size() > mPageCacheBudget)
+            return;
+
+        // The file was saved while it was being read, what we got may be outdated
+        PageGenerationMap::const_iterator g = mPageGenerations.find(filename);
+        if (generation != (g != mPageGenerations.end() ? g->second : 0))
+            return;
+
+        CachedPageMap::iterator i = mCachedPageMap.find(filename);
+        if (i != mCachedPageMap.end())
+        {
+            // Another thread read the same file; replace it
+            mPageCacheMemoryUsage -= i->second->data->size();
+            mCachedPages.erase(i->second);
+            mCachedPageMap.erase(i);
+        }
+
+        evictCachedPages(mPageCacheBudget - data->size());
+
+        CachedPage cachedPage;
+        cachedPage.filename = filename;
+        cachedPage.data = data;
+        mCachedPages.push_front(cachedPage);
+        mCachedPageMap[filename] = mCachedPages.begin();
+        mPageCacheMemoryUsage += data->size();
+    }
+    //---------------------------------------------------------------------
+    void PageManager::_removeCachedPageData(const String& filename)
+    {
+        OGRE_LOCK_MUTEX(mPageCacheMutex);
+        ++mPageGenerations[filename];
+
+        CachedPageMap::iterator i = mCachedPageMap.find(filename);
+        if (i != mCachedPageMap.end())
+        {
+            mPageCacheMemoryUsage -= i->second->data->size();
+            mCachedPages.erase(i->second);
+            mCachedPageMap.erase(i);
+        }
+    }
+    //---------------------------------------------------------------------
+    void PageManager::evictCachedPages(size_t budget)
+    {
+        while (mPageCacheMemoryUsage > budget)
+        {
+            // Least recently used is at the back
+            const CachedPage& cachedPage = mCachedPages.back();
+            mPageCacheMemoryUsage -= cachedPage.data->size();
+            mCachedPageMap.erase(cachedPage.filename);
+            mCachedPages.pop_back();
+        }
+    }
+    //---------------------------------------------------------------------
     void PageManager::EventRouter::cameraPreRenderScene(Camera* cam)
     {
     }
@@ -512,6 +657,8 @@ namespace Ogre
     //---------------------------------------------------------------------
     bool PageManager::EventRouter::frameStarted(const FrameEvent& evt)
     {
+        pManager->updateCameraMotion(evt.timeSinceLastFrame);
+
         if(pWorldMap->empty())
             return true;
 
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgrePageManager.h"
 #include "OgrePage.h"
 #include "OgreLogManager.h"
+#include "OgrePlatformInformation.h"
 #include "OgreRoot.h"
 
 namespace Ogre
@@ -199,6 +200,16 @@ namespace Ogre
     }
     //---------------------------------------------------------------------
     void PagedWorldSection::loadPage(PageID pageID, bool sync)
+    {
+        loadPageImpl(pageID, sync, 0);
+    }
+    //---------------------------------------------------------------------
+    void PagedWorldSection::loadPageWithPriority(PageID pageID, int16 priority, bool sync)
+    {
+        loadPageImpl(pageID, sync, priority);
+    }
+    //---------------------------------------------------------------------
+    void PagedWorldSection::loadPageImpl(PageID pageID, bool sync, int16 priority)
     {
         if (!mParent->getManager()->getPagingOperationsEnabled())
             return;
@@ -221,10 +232,14 @@ namespace Ogre
                     ret.first->second = page;
                 }
             }
+            page->setLoadPriority(priority);
             page->load(sync);
         }
         else
+        {
             i->second->touch();
+            i->second->setLoadPriority(priority);
+        }
     }
     //---------------------------------------------------------------------
     void PagedWorldSection::unloadPage(PageID pageID, bool sync)
@@ -77,6 +77,10 @@ namespace Ogre
             ParallaxCorrectedCubemap= 1u << 15u,
             AreaLightMasks          = 1u << 16u,
             Decals                  = 1u << 17u,
+            /// Only used by exportSceneToFile & importSceneFromFile: SceneNodes, Items,
+            /// Entities and Lights are stored in scene.bin (see SceneFormatBinary)
+            /// instead of scene.json. Much faster to load for large scenes.
+            BinarySceneObjects      = 1u << 18u,
             // clang-format on
         };
     }
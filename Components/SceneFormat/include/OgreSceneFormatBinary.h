@@ -0,0 +1,341 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2017 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreSceneFormatBinary_H_
+#define _OgreSceneFormatBinary_H_
+
+#include "OgreSceneFormatPrerequisites.h"
+
+#include "ogrestd/map.h"
+#include "ogrestd/vector.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Component
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    /** Compact binary alternative to the JSON "scene_nodes", "items", "entities" and "lights"
+        sections of a scene.
+
+        The file is a Header followed by flat arrays of fixed-size records, a table of string
+        offsets and a blob of null-terminated strings. Records refer to strings (mesh names,
+        datablock names, object names) and to other records (parent nodes, sub objects) by
+        index, so the file can be used in place (e.g. memory mapped) without any parsing.
+
+        SceneNodes are always sorted so that a parent comes before its children, which allows
+        creating the whole hierarchy in a single linear pass.
+    @remarks
+        Data is stored in the native byte order of the machine that wrote it. A file written
+        by a machine with different endianness is rejected because its magic number won't match.
+
+        See SceneFlags::BinarySceneObjects, SceneFormatExporter::exportSceneBinary,
+        SceneFormatImporter::importSceneBinary, SceneFormatImporter::convertJsonToBinary and
+        SceneFormatExporter::convertBinaryToJson
+    */
+    namespace SceneFormatBinary
+    {
+        /// 'OSFB' in little endian
+        static const uint32 c_magic = 0x4246534Fu;
+        static const uint32 c_invalidIdx = 0xFFFFFFFFu;
+
+        enum Version
+        {
+            VERSION_0 = 0,
+            LATEST_VERSION = VERSION_0
+        };
+
+        namespace NodeFlags
+        {
+            enum NodeFlags
+            {
+                IsStatic = 1u << 0u,
+                InheritOrientation = 1u << 1u,
+                InheritScale = 1u << 2u,
+                IsRootNode = 1u << 3u
+            };
+        }
+
+        namespace MovableObjectFlags
+        {
+            enum MovableObjectFlags
+            {
+                IsStatic = 1u << 0u,
+                /// When not set, localAabb & localRadius are left as calculated by the object
+                HasLocalAabb = 1u << 1u,
+                /// When not set, the object keeps its default render queue
+                HasRenderQueue = 1u << 2u,
+                /// When not set, the object keeps its default rendering distance
+                HasRenderingDistance = 1u << 3u,
+                /// When not set, the object keeps the visibility flags it was created with.
+                /// Note these include reserved bits such as VisibilityFlags::LAYER_VISIBILITY
+                HasVisibilityFlags = 1u << 4u,
+                /// When not set, the object keeps the query flags it was created with
+                HasQueryFlags = 1u << 5u,
+                /// When not set, the object keeps the light mask it was created with
+                HasLightMask = 1u << 6u
+            };
+        }
+
+        namespace SubObjectFlags
+        {
+            enum SubObjectFlags
+            {
+                IsV1Material = 1u << 0u,
+                PolygonModeOverrideable = 1u << 1u,
+                UseIdentityView = 1u << 2u,
+                UseIdentityProjection = 1u << 3u
+            };
+        }
+
+        namespace LightFlags
+        {
+            enum LightFlags
+            {
+                /// See Light::setAffectParentNode
+                AffectParentNode = 1u << 0u
+            };
+        }
+
+        struct Header
+        {
+            uint32 magic;
+            uint32 version;
+            uint32 totalSize;
+
+            uint32 numStrings;
+            uint32 numNodes;
+            uint32 numItems;
+            uint32 numEntities;
+            uint32 numSubObjects;
+            uint32 numCustomParams;
+            uint32 numLights;
+
+            /// Byte offsets from the start of the file
+            uint32 stringOffsetsStart;
+            uint32 nodesStart;
+            uint32 itemsStart;
+            uint32 entitiesStart;
+            uint32 subObjectsStart;
+            uint32 customParamsStart;
+            uint32 lightsStart;
+            uint32 stringDataStart;
+            uint32 stringDataSize;
+
+            /// See MovableObject::setDefaultVisibilityFlags & co.
+            uint32 defaultVisibilityFlags;
+            uint32 defaultQueryFlags;
+            uint32 defaultLightMask;
+        };
+
+        struct NodeRecord
+        {
+            float position[3];
+            /// w, x, y, z
+            float orientation[4];
+            float scale[3];
+            /// c_invalidIdx if it has no parent. Otherwise always lower than this node's index
+            uint32 parentIdx;
+            uint32 nameIdx;
+            /// See NodeFlags
+            uint32 flags;
+        };
+
+        struct MovableObjectRecord
+        {
+            uint32 nameIdx;
+            uint32 parentNodeIdx;
+            uint32 visibilityFlags;
+            uint32 queryFlags;
+            uint32 lightMask;
+            float  localAabbCenter[3];
+            float  localAabbHalfSize[3];
+            float  localRadius;
+            float  renderingDistance;
+            uint8  renderQueue;
+            /// See MovableObjectFlags
+            uint8  flags;
+            uint16 padding;
+        };
+
+        /// Used by both Items and Entities
+        struct MeshObjectRecord
+        {
+            MovableObjectRecord movableObject;
+            uint32              meshIdx;
+            uint32              firstSubObject;
+            uint32              numSubObjects;
+        };
+
+        /// SubItem or SubEntity
+        struct SubObjectRecord
+        {
+            uint32 datablockIdx;
+            uint32 firstCustomParam;
+            uint32 numCustomParams;
+            uint8  customParameter;
+            uint8  renderQueueSubGroup;
+            /// See SubObjectFlags
+            uint8 flags;
+            uint8 padding;
+        };
+
+        /// See Renderable::setCustomParameter
+        struct CustomParamRecord
+        {
+            uint32 idx;
+            float  value[4];
+        };
+
+        struct LightRecord
+        {
+            MovableObjectRecord movableObject;
+            float               diffuse[3];
+            float               specular[3];
+            float               powerScale;
+            /// range, constant, linear, quadratic
+            float attenuation[4];
+            /// inner angle (radians), outer angle (radians), falloff, near clip distance
+            float spot[4];
+            /// 0 if the light doesn't override the SceneManager's shadow far distance
+            float  shadowFarDistance;
+            float  shadowClipDistance[2];
+            float  rectSize[2];
+            uint16 textureLightMaskIdx;
+            uint8  type;
+            /// See LightFlags
+            uint8 flags;
+        };
+
+        /** Builds a binary scene in memory.
+            Fill the public arrays, use addString for every string reference,
+            then call serialize.
+        */
+        class _OgreSceneFormatExport Writer
+        {
+            typedef map<String, uint32>::type StringToIdxMap;
+
+            StringToIdxMap       mStringToIdx;
+            vector<uint32>::type mStringOffsets;
+            vector<char>::type   mStringData;
+
+        public:
+            vector<NodeRecord>::type          mNodes;
+            vector<MeshObjectRecord>::type    mItems;
+            vector<MeshObjectRecord>::type    mEntities;
+            vector<SubObjectRecord>::type     mSubObjects;
+            vector<CustomParamRecord>::type   mCustomParams;
+            vector<LightRecord>::type         mLights;
+
+            uint32 mDefaultVisibilityFlags;
+            uint32 mDefaultQueryFlags;
+            uint32 mDefaultLightMask;
+
+            Writer();
+
+            /// Returns the index of the string in the string table. Identical strings are
+            /// only stored once. Empty strings are stored as c_invalidIdx.
+            uint32 addString( const String &str );
+
+            void serialize( vector<uint8>::type &outBinary ) const;
+        };
+
+        /** Read-only access to a binary scene. Does not copy nor own the data.
+            The constructor validates the header and all indices, and throws
+            if the data is malformed. Thus once constructed, the data can be
+            accessed without further checks.
+        */
+        class _OgreSceneFormatExport Reader
+        {
+            uint8 const  *mData;
+            Header const *mHeader;
+
+            template <typename T>
+            const T *getArray( uint32 offset ) const
+            {
+                return reinterpret_cast<const T *>( mData + offset );
+            }
+
+            void validateMovableObject( const MovableObjectRecord &movableObject,
+                                        const String &filename ) const;
+            void validateMeshObjects( const MeshObjectRecord *meshObjects, uint32 numMeshObjects,
+                                      const String &filename ) const;
+
+        public:
+            /**
+            @param data
+                Pointer to the binary scene. Must be aligned to 4 bytes.
+                Must remain valid while this Reader is in use.
+            @param sizeBytes
+                Size in bytes of data
+            @param filename
+                For error reporting
+            */
+            Reader( const void *data, size_t sizeBytes, const String &filename );
+
+            const Header &getHeader() const { return *mHeader; }
+
+            /// Returns an empty string if idx is c_invalidIdx
+            const char *getString( uint32 idx ) const;
+
+            const NodeRecord *getNodes() const { return getArray<NodeRecord>( mHeader->nodesStart ); }
+            const MeshObjectRecord *getItems() const
+            {
+                return getArray<MeshObjectRecord>( mHeader->itemsStart );
+            }
+            const MeshObjectRecord *getEntities() const
+            {
+                return getArray<MeshObjectRecord>( mHeader->entitiesStart );
+            }
+            const SubObjectRecord *getSubObjects() const
+            {
+                return getArray<SubObjectRecord>( mHeader->subObjectsStart );
+            }
+            const CustomParamRecord *getCustomParams() const
+            {
+                return getArray<CustomParamRecord>( mHeader->customParamsStart );
+            }
+            const LightRecord *getLights() const
+            {
+                return getArray<LightRecord>( mHeader->lightsStart );
+            }
+        };
+    }  // namespace SceneFormatBinary
+
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -37,6 +37,13 @@ namespace Ogre
     class LwString;
     class InstantRadiosity;
 
+    namespace SceneFormatBinary
+    {
+        class Writer;
+        class Reader;
+        struct MovableObjectRecord;
+    }  // namespace SceneFormatBinary
+
     /** \addtogroup Component
      *  @{
      */
@@ -53,6 +60,7 @@ namespace Ogre
         String            mCurrentExportFolder;
 
         typedef map<Node *, uint32>::type NodeToIdxMap;
+        typedef vector<SceneNode *>::type SceneNodeVec;
 
         NodeToIdxMap mNodeToIdxMap;
 
@@ -99,6 +107,14 @@ namespace Ogre
 
         static inline void flushLwString( LwString &jsonStr, String &outJson );
 
+        /// Gathers all SceneNodes to export (as allowed by the listener), parents always
+        /// before their children; and fills mNodeToIdxMap with their index in outSceneNodes
+        void collectSceneNodes( SceneNodeVec &outSceneNodes );
+
+        /// Saves the mesh to mCurrentExportFolder, if we haven't done that already
+        void saveMesh( const Mesh *mesh );
+        void saveMesh( const v1::Mesh *mesh );
+
         void exportNode( LwString &jsonStr, String &outJson, Node *node );
         void exportSceneNode( LwString &jsonStr, String &outJson, SceneNode *sceneNode );
         void exportRenderable( LwString &jsonStr, String &outJson, Renderable *renderable );
@@ -114,6 +130,28 @@ namespace Ogre
         void exportPcc( LwString &jsonStr, String &outJson );
         void exportSceneSettings( LwString &jsonStr, String &outJson, uint32 exportFlags );
 
+        void exportMovableObjectBinary( SceneFormatBinary::Writer &writer,
+                                        SceneFormatBinary::MovableObjectRecord &outRecord,
+                                        MovableObject *movableObject );
+        void exportRenderableBinary( SceneFormatBinary::Writer &writer, Renderable *renderable );
+        void exportItemBinary( SceneFormatBinary::Writer &writer, Item *item, bool exportMesh );
+        void exportEntityBinary( SceneFormatBinary::Writer &writer, v1::Entity *entity,
+                                 bool exportMesh );
+        void exportLightBinary( SceneFormatBinary::Writer &writer, Light *light );
+
+        void exportNodeRecord( LwString &jsonStr, String &outJson,
+                               const SceneFormatBinary::Reader &reader, uint32 nodeIdx );
+        void exportMovableObjectRecord( LwString &jsonStr, String &outJson,
+                                        const SceneFormatBinary::Reader &reader,
+                                        const SceneFormatBinary::MovableObjectRecord &record );
+        void exportSubObjectRecords( LwString &jsonStr, String &outJson,
+                                     const SceneFormatBinary::Reader &reader, uint32 firstSubObject,
+                                     uint32 numSubObjects );
+        void exportMeshObjectRecords( LwString &jsonStr, String &outJson,
+                                      const SceneFormatBinary::Reader &reader, bool entities );
+        void exportLightRecords( LwString &jsonStr, String &outJson,
+                                 const SceneFormatBinary::Reader &reader );
+
         /**
         @param outJson
         @param exportFlags
@@ -123,6 +161,9 @@ namespace Ogre
         */
         void _exportScene( String &outJson, set<String>::type &savedTextures, uint32 exportFlags = ~0u );
 
+        /// See exportSceneBinary
+        void _exportSceneBinary( vector<uint8>::type &outBinary, uint32 exportFlags );
+
     public:
         SceneFormatExporter( Root *root, SceneManager *sceneManager,
                              InstantRadiosity *instantRadiosity );
@@ -160,8 +201,38 @@ namespace Ogre
         void exportScene( String &outJson,
                           uint32  exportFlags = static_cast<uint32>( ~SceneFlags::TexturesOriginal ) );
 
+        /** Same as exportSceneToFile, but for the SceneFlags::BinarySceneObjects flag.
+        @param folderPath
+        @param exportFlags
+            When BinarySceneObjects is set, SceneNodes, Items, Entities & Lights are written to
+            scene.bin instead of scene.json. Everything else (scene settings, decals, PCC, IR,
+            materials, textures) is still written as JSON.
+        */
         void exportSceneToFile( const String &folderPath, uint32 exportFlags = static_cast<uint32>(
                                                               ~SceneFlags::TexturesOriginal ) );
+
+        /** Exports SceneNodes, Items, Entities and Lights into the compact binary format.
+            See SceneFormatBinary.
+        @param outBinary [out]
+            The binary scene. Its contents will be replaced.
+        @param exportFlags
+            Combination of SceneFlags::SceneFlags. Only SceneNodes, Items, Entities and Lights
+            are relevant here.
+        */
+        void exportSceneBinary( vector<uint8>::type &outBinary, uint32 exportFlags = ~0u );
+
+        /** Converts a binary scene (see SceneFormatBinary) back to JSON, without going
+            through the SceneManager. The result can be loaded with
+            SceneFormatImporter::importScene.
+            Respects setUseBinaryFloatingPoint.
+        @param data
+            Binary scene. Must be aligned to 4 bytes.
+        @param sizeBytes
+            Size in bytes of data.
+        @param outJson [out]
+            JSON will be appended to this string.
+        */
+        void convertBinaryToJson( const void *data, size_t sizeBytes, String &outJson );
     };
 
     /** @} */
@@ -57,6 +57,15 @@ namespace Ogre
     class InstantRadiosity;
     class IrradianceVolume;
 
+    namespace SceneFormatBinary
+    {
+        class Writer;
+        class Reader;
+        struct MovableObjectRecord;
+        struct MeshObjectRecord;
+        struct SubObjectRecord;
+    }  // namespace SceneFormatBinary
+
     /** \addtogroup Component
      *  @{
      */
@@ -67,6 +76,34 @@ namespace Ogre
      */
     class _OgreSceneFormatExport SceneFormatImporter : public SceneFormatBase
     {
+    public:
+        /// Time spent (in microseconds) in each phase of the last import, plus
+        /// the number of objects created. See SceneFormatImporter::getImportStats
+        struct ImportStats
+        {
+            uint64 parseTime;
+            uint64 resourceGroupTime;
+            uint64 meshPrepareTime;
+            uint64 sceneNodesTime;
+            uint64 itemsTime;
+            uint64 entitiesTime;
+            uint64 lightsTime;
+            uint64 decalsTime;
+            uint64 sceneSettingsTime;
+            uint64 instantRadiosityTime;
+            uint64 totalTime;
+
+            uint32 numSceneNodes;
+            uint32 numItems;
+            uint32 numEntities;
+            uint32 numLights;
+            uint32 numDecals;
+            /// Number of meshes whose file IO was done by worker threads
+            uint32 numMeshesPrepared;
+
+            ImportStats();
+        };
+
     protected:
         String                    mFilename;
         InstantRadiosity         *mInstantRadiosity;
@@ -77,11 +114,16 @@ namespace Ogre
 
         bool mUseBinaryFloatingPoint;
         bool mUsingOitd;
+        bool mParallelMeshPreparation;
 
         LightArray mVplLights;
 
-        typedef map<uint32, SceneNode *>::type IndexToSceneNodeMap;
-        IndexToSceneNodeMap                    mCreatedSceneNodes;
+        /// Indexed by the node's position in the "scene_nodes" array.
+        /// Nodes that haven't been created yet are nullptr.
+        typedef vector<SceneNode *>::type SceneNodeVec;
+        SceneNodeVec                      mCreatedSceneNodes;
+
+        ImportStats mImportStats;
 
         SceneNode *mRootNodes[NUM_SCENE_MEMORY_MANAGER_TYPES];
         SceneNode *mParentlessRootNodes[NUM_SCENE_MEMORY_MANAGER_TYPES];
@@ -89,6 +131,8 @@ namespace Ogre
         void destroyInstantRadiosity();
         void destroyParallaxCorrectedCubemap();
 
+        class PrepareMeshesTask;
+
         static inline Light::LightTypes parseLightType( const char *value );
 
         inline bool        isFloat( const rapidjson::Value &jsonValue ) const;
@@ -126,6 +170,51 @@ namespace Ogre
         void importPcc( const rapidjson::Value &pccValue );
         void importSceneSettings( const rapidjson::Value &json, uint32 importFlags );
 
+        /// Gathers the unique "mesh" names referenced by the objects in the given array
+        static void collectMeshNames( const rapidjson::Value &json, set<String>::type &outMeshNames );
+
+        /** Performs the file IO of every mesh referenced by Items and Entities using the
+            SceneManager's worker threads (see Resource::prepare). Creating the GPU buffers
+            still happens in the main thread when the Item / Entity gets created.
+        */
+        void prepareMeshes( const set<String>::type &meshNames,
+                            const set<String>::type &meshNamesV1 );
+        void prepareMeshes( const rapidjson::Document &d, uint32 importFlags );
+
+        void importMovableObjectBinary( const SceneFormatBinary::Reader              &reader,
+                                        const SceneFormatBinary::MovableObjectRecord &record,
+                                        MovableObject                                *movableObject );
+        void importRenderableBinary( const SceneFormatBinary::Reader &reader, uint32 subObjectIdx,
+                                     Renderable *renderable );
+        void importSceneNodesBinary( const SceneFormatBinary::Reader &reader );
+        void importItemsBinary( const SceneFormatBinary::Reader &reader );
+        void importEntitiesBinary( const SceneFormatBinary::Reader &reader );
+        void importLightsBinary( const SceneFormatBinary::Reader &reader );
+
+        /// See importSceneBinary. Doesn't reset nor log the import stats
+        void _importSceneBinary( const String &filename, const void *data, size_t sizeBytes,
+                                 uint32 importFlags );
+
+        /// Converts "scene_nodes", sorting them so that parents come before their children.
+        /// outNodeRemap[jsonIdx] contains the new index of each node.
+        void convertSceneNodesToBinary( const rapidjson::Value &json, SceneFormatBinary::Writer &writer,
+                                        vector<uint32>::type &outNodeRemap );
+        void convertMovableObjectToBinary( const rapidjson::Value &movableObjectValue,
+                                           SceneFormatBinary::MovableObjectRecord &outRecord,
+                                           SceneFormatBinary::Writer              &writer,
+                                           const vector<uint32>::type             &nodeRemap );
+        void convertRenderableToBinary( const rapidjson::Value            &renderableValue,
+                                        SceneFormatBinary::SubObjectRecord &outRecord,
+                                        SceneFormatBinary::Writer          &writer );
+        void convertMeshObjectsToBinary( const rapidjson::Value &json, const char *subObjectsKey,
+                                         vector<SceneFormatBinary::MeshObjectRecord>::type &outRecords,
+                                         SceneFormatBinary::Writer                         &writer,
+                                         const vector<uint32>::type                        &nodeRemap );
+        void convertLightsToBinary( const rapidjson::Value &json, SceneFormatBinary::Writer &writer,
+                                    const vector<uint32>::type &nodeRemap );
+
+        void logImportStats() const;
+
         void importScene( const String &filename, const rapidjson::Document &d,
                           uint32 importFlags = static_cast<uint32>( ~SceneFlags::LightsVpl ) );
 
@@ -212,9 +301,42 @@ namespace Ogre
         void importScene( const String &filename, const char *jsonString,
                           uint32 importFlags = static_cast<uint32>( ~SceneFlags::LightsVpl ) );
 
+        /** Imports a scene exported with SceneFormatExporter::exportSceneToFile.
+            If the scene was exported with SceneFlags::BinarySceneObjects, SceneNodes,
+            Items, Entities & Lights are loaded from scene.bin.
+        */
         void importSceneFromFile( const String &filename,
                                   uint32 importFlags = static_cast<uint32>( ~SceneFlags::LightsVpl ) );
 
+        /** Imports SceneNodes, Items, Entities and Lights from a binary scene
+            (see SceneFormatBinary and SceneFormatExporter::exportSceneBinary).
+            The data is used in place and not copied, thus it can be a memory mapped file.
+        @param filename
+            For error reporting and logging.
+        @param data
+            Binary scene. Must be aligned to 4 bytes. Only needs to stay valid during this call.
+        @param sizeBytes
+            Size in bytes of data.
+        @param importFlags
+            Combination of SceneFlags::SceneFlags. Only SceneNodes, Items, Entities, Lights
+            and LightsVpl are relevant here.
+        */
+        void importSceneBinary( const String &filename, const void *data, size_t sizeBytes,
+                                uint32 importFlags = static_cast<uint32>( ~SceneFlags::LightsVpl ) );
+
+        /** Converts the "scene_nodes", "items", "entities" and "lights" of a JSON scene
+            into the binary format, without going through the SceneManager.
+            Other sections (decals, scene settings, IR, PCC) are ignored.
+        @param filename
+            For error reporting.
+        @param jsonString
+            Null-terminated JSON scene, as generated by SceneFormatExporter::exportScene.
+        @param outBinary [out]
+            The binary scene. Its contents will be replaced.
+        */
+        void convertJsonToBinary( const String &filename, const char *jsonString,
+                                  vector<uint8>::type &outBinary );
+
         /** Retrieve the InstantRadiosity pointer that may have been created while importing a scene
         @param releaseOwnership
             If true, we will return the InstantRadiosity & IrradianceVolume pointers and
@@ -237,6 +359,25 @@ namespace Ogre
                                   IrradianceVolume **outIrradianceVolume );
 
         ParallaxCorrectedCubemap *getParallaxCorrectedCubemap( bool releaseOwnership );
+
+        /** When true (default), the mesh files referenced by the scene are read from disk
+            by the SceneManager's worker threads before any Item or Entity is created.
+            The rest of the import (creation of SceneNodes, Items, Lights, etc) always
+            happens in the calling thread.
+        @remarks
+            Only has an effect if OGRE was built with thread support (OGRE_THREAD_SUPPORT)
+            and the SceneManager was created with more than one worker thread.
+            Custom ResourceGroupListeners that intercept mesh loading (see
+            ResourceLoadingListener) will be called from worker threads.
+            If a mesh fails to be prepared, the first error is thrown from the calling
+            thread once all worker threads are done.
+        */
+        void setParallelMeshPreparation( bool bParallel );
+        bool getParallelMeshPreparation() const { return mParallelMeshPreparation; }
+
+        /// Returns the timings and object counts of the last call to importScene
+        /// or importSceneFromFile. They're also written to the log.
+        const ImportStats &getImportStats() const { return mImportStats; }
     };
 
     /** @} */
@@ -0,0 +1,291 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2017 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreSceneFormatBinary.h"
+
+#include "OgreException.h"
+#include "OgreLight.h"
+#include "OgreStringConverter.h"
+
+namespace Ogre
+{
+    namespace SceneFormatBinary
+    {
+        /// Appends an array to the output, and returns the offset where it was written
+        template <typename T>
+        static uint32 appendArray( vector<uint8>::type &outBinary,
+                                   const typename vector<T>::type &values )
+        {
+            const size_t offset = outBinary.size();
+            const size_t sizeBytes = values.size() * sizeof( T );
+            if( offset + sizeBytes > 0xFFFFFFFFu )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Scene is too big for the binary format",
+                             "SceneFormatBinary::Writer::serialize" );
+            }
+            outBinary.resize( offset + sizeBytes );
+            if( sizeBytes )
+                memcpy( &outBinary[offset], &values[0], sizeBytes );
+            return static_cast<uint32>( offset );
+        }
+        //-------------------------------------------------------------------------------
+        Writer::Writer() :
+            mDefaultVisibilityFlags( 0 ),
+            mDefaultQueryFlags( 0 ),
+            mDefaultLightMask( 0 )
+        {
+        }
+        //-------------------------------------------------------------------------------
+        uint32 Writer::addString( const String &str )
+        {
+            if( str.empty() )
+                return c_invalidIdx;
+
+            StringToIdxMap::const_iterator itor = mStringToIdx.find( str );
+            if( itor != mStringToIdx.end() )
+                return itor->second;
+
+            const uint32 idx = static_cast<uint32>( mStringOffsets.size() );
+            mStringOffsets.push_back( static_cast<uint32>( mStringData.size() ) );
+            mStringData.insert( mStringData.end(), str.begin(), str.end() );
+            mStringData.push_back( '\0' );
+            mStringToIdx[str] = idx;
+
+            return idx;
+        }
+        //-------------------------------------------------------------------------------
+        void Writer::serialize( vector<uint8>::type &outBinary ) const
+        {
+            Header header;
+            memset( &header, 0, sizeof( header ) );
+
+            header.magic = c_magic;
+            header.version = LATEST_VERSION;
+            header.numStrings = static_cast<uint32>( mStringOffsets.size() );
+            header.numNodes = static_cast<uint32>( mNodes.size() );
+            header.numItems = static_cast<uint32>( mItems.size() );
+            header.numEntities = static_cast<uint32>( mEntities.size() );
+            header.numSubObjects = static_cast<uint32>( mSubObjects.size() );
+            header.numCustomParams = static_cast<uint32>( mCustomParams.size() );
+            header.numLights = static_cast<uint32>( mLights.size() );
+            header.defaultVisibilityFlags = mDefaultVisibilityFlags;
+            header.defaultQueryFlags = mDefaultQueryFlags;
+            header.defaultLightMask = mDefaultLightMask;
+
+            outBinary.clear();
+            outBinary.resize( sizeof( Header ) );
+
+            // All records are multiples of 4 bytes, thus every array stays 4-byte aligned.
+            header.stringOffsetsStart = appendArray<uint32>( outBinary, mStringOffsets );
+            header.nodesStart = appendArray<NodeRecord>( outBinary, mNodes );
+            header.itemsStart = appendArray<MeshObjectRecord>( outBinary, mItems );
+            header.entitiesStart = appendArray<MeshObjectRecord>( outBinary, mEntities );
+            header.subObjectsStart = appendArray<SubObjectRecord>( outBinary, mSubObjects );
+            header.customParamsStart = appendArray<CustomParamRecord>( outBinary, mCustomParams );
+            header.lightsStart = appendArray<LightRecord>( outBinary, mLights );
+            header.stringDataStart = appendArray<char>( outBinary, mStringData );
+            header.stringDataSize = static_cast<uint32>( mStringData.size() );
+
+            // Keep the total size 4-byte aligned too
+            outBinary.resize( alignToNextMultiple<size_t>( outBinary.size(), 4u ), 0 );
+            header.totalSize = static_cast<uint32>( outBinary.size() );
+
+            memcpy( &outBinary[0], &header, sizeof( header ) );
+        }
+        //-------------------------------------------------------------------------------
+        //-------------------------------------------------------------------------------
+        //-------------------------------------------------------------------------------
+        static void validateArray( uint32 offset, uint32 numElements, size_t elementSize,
+                                   uint32 totalSize, const char *arrayName, const String &filename )
+        {
+            if( ( offset & 0x03u ) != 0u ||
+                uint64( offset ) + uint64( numElements ) * elementSize > uint64( totalSize ) )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Array '" + String( arrayName ) + "' is out of bounds in binary scene " +
+                                 filename + ". The file is corrupt.",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        static void validateIdx( uint32 idx, uint32 numElements, bool allowInvalid,
+                                 const char *fieldName, const String &filename )
+        {
+            if( idx >= numElements && !( allowInvalid && idx == c_invalidIdx ) )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Invalid " + String( fieldName ) + " " + StringConverter::toString( idx ) +
+                                 " in binary scene " + filename + ". The file is corrupt.",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        /// Checks that [first; first + count) lies within [0; numElements)
+        static void validateRange( uint32 first, uint32 count, uint32 numElements,
+                                   const char *rangeName, const String &filename )
+        {
+            if( uint64( first ) + uint64( count ) > uint64( numElements ) )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Range of " + String( rangeName ) + " [" +
+                                 StringConverter::toString( first ) + "; " +
+                                 StringConverter::toString( uint64( first ) + count ) +
+                                 ") exceeds the " + StringConverter::toString( numElements ) +
+                                 " available in binary scene " + filename + ". The file is corrupt.",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        Reader::Reader( const void *data, size_t sizeBytes, const String &filename ) :
+            mData( reinterpret_cast<const uint8 *>( data ) ),
+            mHeader( reinterpret_cast<const Header *>( data ) )
+        {
+            if( reinterpret_cast<uintptr_t>( data ) & 0x03u )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Binary scene data must be aligned to 4 bytes. File: " + filename,
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+
+            if( sizeBytes < sizeof( Header ) || mHeader->magic != c_magic )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             filename + " is not a binary scene, or was written by a machine "
+                                        "with different endianness.",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+
+            if( mHeader->version > LATEST_VERSION )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Binary scene " + filename + " is a newer version (" +
+                                 StringConverter::toString( mHeader->version ) +
+                                 ") than what we support (" +
+                                 StringConverter::toString( LATEST_VERSION ) + ")",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+
+            const Header &header = *mHeader;
+
+            if( header.totalSize > sizeBytes )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Binary scene " + filename + " is truncated.",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+
+            const uint32 totalSize = header.totalSize;
+            validateArray( header.stringOffsetsStart, header.numStrings, sizeof( uint32 ), totalSize,
+                           "string offsets", filename );
+            validateArray( header.nodesStart, header.numNodes, sizeof( NodeRecord ), totalSize,
+                           "nodes", filename );
+            validateArray( header.itemsStart, header.numItems, sizeof( MeshObjectRecord ), totalSize,
+                           "items", filename );
+            validateArray( header.entitiesStart, header.numEntities, sizeof( MeshObjectRecord ),
+                           totalSize, "entities", filename );
+            validateArray( header.subObjectsStart, header.numSubObjects, sizeof( SubObjectRecord ),
+                           totalSize, "sub objects", filename );
+            validateArray( header.customParamsStart, header.numCustomParams,
+                           sizeof( CustomParamRecord ), totalSize, "custom params", filename );
+            validateArray( header.lightsStart, header.numLights, sizeof( LightRecord ), totalSize,
+                           "lights", filename );
+            if( uint64( header.stringDataStart ) + header.stringDataSize > totalSize ||
+                ( header.numStrings > 0u &&
+                  ( header.stringDataSize == 0u ||
+                    mData[header.stringDataStart + header.stringDataSize - 1u] != '\0' ) ) )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "String table is out of bounds in binary scene " + filename +
+                                 ". The file is corrupt.",
+                             "SceneFormatBinary::Reader::Reader" );
+            }
+
+            const uint32 *stringOffsets = getArray<uint32>( header.stringOffsetsStart );
+            for( uint32 i = 0u; i < header.numStrings; ++i )
+                validateIdx( stringOffsets[i], header.stringDataSize, false, "string offset", filename );
+
+            const NodeRecord *nodes = getNodes();
+            for( uint32 i = 0u; i < header.numNodes; ++i )
+            {
+                // Parents must come before their children
+                validateIdx( nodes[i].parentIdx, i, true, "parent node index", filename );
+                validateIdx( nodes[i].nameIdx, header.numStrings, true, "string index", filename );
+            }
+
+            validateMeshObjects( getItems(), header.numItems, filename );
+            validateMeshObjects( getEntities(), header.numEntities, filename );
+
+            const SubObjectRecord *subObjects = getSubObjects();
+            for( uint32 i = 0u; i < header.numSubObjects; ++i )
+            {
+                validateIdx( subObjects[i].datablockIdx, header.numStrings, true, "string index",
+                             filename );
+                validateRange( subObjects[i].firstCustomParam, subObjects[i].numCustomParams,
+                               header.numCustomParams, "custom params", filename );
+            }
+
+            const LightRecord *lights = getLights();
+            for( uint32 i = 0u; i < header.numLights; ++i )
+            {
+                validateMovableObject( lights[i].movableObject, filename );
+                validateIdx( lights[i].type, Light::NUM_LIGHT_TYPES, false, "light type", filename );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        void Reader::validateMovableObject( const MovableObjectRecord &movableObject,
+                                            const String &filename ) const
+        {
+            validateIdx( movableObject.nameIdx, mHeader->numStrings, true, "string index", filename );
+            validateIdx( movableObject.parentNodeIdx, mHeader->numNodes, true, "parent node index",
+                         filename );
+        }
+        //-------------------------------------------------------------------------------
+        void Reader::validateMeshObjects( const MeshObjectRecord *meshObjects, uint32 numMeshObjects,
+                                          const String &filename ) const
+        {
+            for( uint32 i = 0u; i < numMeshObjects; ++i )
+            {
+                const MeshObjectRecord &meshObject = meshObjects[i];
+                validateMovableObject( meshObject.movableObject, filename );
+                validateIdx( meshObject.meshIdx, mHeader->numStrings, false, "mesh name index",
+                             filename );
+                validateRange( meshObject.firstSubObject, meshObject.numSubObjects,
+                               mHeader->numSubObjects, "sub objects", filename );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        const char *Reader::getString( uint32 idx ) const
+        {
+            if( idx == c_invalidIdx )
+                return "";
+            const uint32 *stringOffsets = getArray<uint32>( mHeader->stringOffsetsStart );
+            return reinterpret_cast<const char *>( mData + mHeader->stringDataStart +
+                                                   stringOffsets[idx] );
+        }
+    }  // namespace SceneFormatBinary
+}  // namespace Ogre
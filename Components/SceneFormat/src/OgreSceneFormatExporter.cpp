@@ -28,6 +28,8 @@ THE SOFTWARE.
 
 #include "OgreSceneFormatExporter.h"
 
+#include "OgreSceneFormatBinary.h"
+
 #include "Compositor/OgreCompositorWorkspaceDef.h"
 #include "Cubemaps/OgreParallaxCorrectedCubemap.h"
 #include "InstantRadiosity/OgreInstantRadiosity.h"
@@ -244,6 +246,66 @@ namespace Ogre
         jsonStr.clear();
     }
     //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::collectSceneNodes( SceneNodeVec &outSceneNodes )
+    {
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            SceneNode *rootSceneNode =
+                mSceneManager->getRootSceneNode( static_cast<SceneMemoryMgrTypes>( i ) );
+
+            mNodeToIdxMap[rootSceneNode] = static_cast<uint32>( outSceneNodes.size() );
+            outSceneNodes.push_back( rootSceneNode );
+
+            std::queue<SceneNode *> nodeQueue;
+            nodeQueue.push( rootSceneNode );
+
+            while( !nodeQueue.empty() )
+            {
+                SceneNode *frontNode = nodeQueue.front();
+                nodeQueue.pop();
+                Node::NodeVecIterator nodeItor = frontNode->getChildIterator();
+                while( nodeItor.hasMoreElements() )
+                {
+                    Node *node = nodeItor.getNext();
+                    SceneNode *sceneNode = dynamic_cast<SceneNode *>( node );
+
+                    if( sceneNode && mListener->exportSceneNode( sceneNode ) )
+                    {
+                        mNodeToIdxMap[sceneNode] = static_cast<uint32>( outSceneNodes.size() );
+                        outSceneNodes.push_back( sceneNode );
+                        nodeQueue.push( sceneNode );
+                    }
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::saveMesh( const Mesh *mesh )
+    {
+        if( mExportedMeshes.find( mesh ) == mExportedMeshes.end() && mListener->exportMesh( mesh ) )
+        {
+            FileSystemLayer::createDirectory( mCurrentExportFolder + "/v2/" );
+
+            Ogre::MeshSerializer meshSerializer( mRoot->getRenderSystem()->getVaoManager() );
+            meshSerializer.exportMesh( mesh, mCurrentExportFolder + "/v2/" + mesh->getName(),
+                                       MESH_VERSION_LATEST );
+            mExportedMeshes.insert( mesh );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::saveMesh( const v1::Mesh *mesh )
+    {
+        if( mExportedMeshesV1.find( mesh ) == mExportedMeshesV1.end() && mListener->exportMesh( mesh ) )
+        {
+            FileSystemLayer::createDirectory( mCurrentExportFolder + "/v1/" );
+
+            Ogre::v1::MeshSerializer meshSerializer;
+            meshSerializer.exportMesh( mesh, mCurrentExportFolder + "/v1/" + mesh->getName(),
+                                       v1::MESH_VERSION_LATEST );
+            mExportedMeshesV1.insert( mesh );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void SceneFormatExporter::exportNode( LwString &jsonStr, String &outJson, Node *node )
     {
         outJson += "\n\t\t\t\"node\" :\n\t\t\t{";
@@ -425,17 +487,8 @@ namespace Ogre
         }
         outJson += "\n\t\t\t]";
 
-        // Export the mesh, if we haven't done that already
-        if( exportMesh && mExportedMeshes.find( mesh ) == mExportedMeshes.end() &&
-            mListener->exportMesh( mesh ) )
-        {
-            FileSystemLayer::createDirectory( mCurrentExportFolder + "/v2/" );
-
-            Ogre::MeshSerializer meshSerializer( mRoot->getRenderSystem()->getVaoManager() );
-            meshSerializer.exportMesh( mesh, mCurrentExportFolder + "/v2/" + mesh->getName(),
-                                       MESH_VERSION_LATEST );
-            mExportedMeshes.insert( mesh );
-        }
+        if( exportMesh )
+            saveMesh( mesh );
     }
     //-----------------------------------------------------------------------------------
     void SceneFormatExporter::exportLight( LwString &jsonStr, String &outJson, Light *light )
@@ -514,17 +567,8 @@ namespace Ogre
         }
         outJson += "\n\t\t\t]";
 
-        // Export the mesh, if we haven't done that already
-        if( exportMesh && mExportedMeshesV1.find( mesh ) == mExportedMeshesV1.end() &&
-            mListener->exportMesh( mesh ) )
-        {
-            FileSystemLayer::createDirectory( mCurrentExportFolder + "/v1/" );
-
-            Ogre::v1::MeshSerializer meshSerializer;
-            meshSerializer.exportMesh( mesh, mCurrentExportFolder + "/v1/" + mesh->getName(),
-                                       v1::MESH_VERSION_LATEST );
-            mExportedMeshesV1.insert( mesh );
-        }
+        if( exportMesh )
+            saveMesh( mesh );
     }
     //-----------------------------------------------------------------------------------
     void SceneFormatExporter::exportDecalTex( LwString &jsonStr, String &outJson,
@@ -890,6 +934,439 @@ namespace Ogre
         flushLwString( jsonStr, outJson );
     }
     //-----------------------------------------------------------------------------------
+    static void toFloatArray( float *RESTRICT_ALIAS outValues, const Vector3 &value )
+    {
+        outValues[0] = static_cast<float>( value.x );
+        outValues[1] = static_cast<float>( value.y );
+        outValues[2] = static_cast<float>( value.z );
+    }
+    //-----------------------------------------------------------------------------------
+    static void toFloatArray( float *RESTRICT_ALIAS outValues, const ColourValue &value )
+    {
+        outValues[0] = value.r;
+        outValues[1] = value.g;
+        outValues[2] = value.b;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportMovableObjectBinary(
+        SceneFormatBinary::Writer &writer, SceneFormatBinary::MovableObjectRecord &outRecord,
+        MovableObject *movableObject )
+    {
+        memset( &outRecord, 0, sizeof( outRecord ) );
+
+        outRecord.nameIdx = writer.addString( movableObject->getName() );
+
+        outRecord.parentNodeIdx = SceneFormatBinary::c_invalidIdx;
+        Node *parentNode = movableObject->getParentNode();
+        if( parentNode )
+        {
+            NodeToIdxMap::const_iterator itor = mNodeToIdxMap.find( parentNode );
+            if( itor != mNodeToIdxMap.end() )
+                outRecord.parentNodeIdx = itor->second;
+        }
+
+        const ObjectData &objData = movableObject->_getObjectData();
+        outRecord.visibilityFlags = objData.mVisibilityFlags[objData.mIndex];
+        outRecord.queryFlags = objData.mQueryFlags[objData.mIndex];
+        outRecord.lightMask = objData.mLightMask[objData.mIndex];
+
+        const Aabb localAabb = movableObject->getLocalAabb();
+        toFloatArray( outRecord.localAabbCenter, localAabb.mCenter );
+        toFloatArray( outRecord.localAabbHalfSize, localAabb.mHalfSize );
+        outRecord.localRadius = static_cast<float>( movableObject->getLocalRadius() );
+        outRecord.renderingDistance = static_cast<float>( movableObject->getRenderingDistance() );
+        outRecord.renderQueue = movableObject->getRenderQueueGroup();
+        outRecord.flags = SceneFormatBinary::MovableObjectFlags::HasLocalAabb |
+                          SceneFormatBinary::MovableObjectFlags::HasRenderQueue |
+                          SceneFormatBinary::MovableObjectFlags::HasRenderingDistance |
+                          SceneFormatBinary::MovableObjectFlags::HasVisibilityFlags |
+                          SceneFormatBinary::MovableObjectFlags::HasQueryFlags |
+                          SceneFormatBinary::MovableObjectFlags::HasLightMask;
+        if( movableObject->isStatic() )
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::IsStatic;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportRenderableBinary( SceneFormatBinary::Writer &writer,
+                                                      Renderable *renderable )
+    {
+        SceneFormatBinary::SubObjectRecord record;
+        memset( &record, 0, sizeof( record ) );
+
+        if( !renderable->getMaterial() )
+        {
+            HlmsDatablock *datablock = renderable->getDatablock();
+            const String *datablockName = datablock->getNameStr();
+
+            if( datablockName )
+                record.datablockIdx = writer.addString( *datablockName );
+            else
+                record.datablockIdx = writer.addString( datablock->getName().getFriendlyText() );
+        }
+        else
+        {
+            record.datablockIdx = writer.addString( renderable->getMaterial()->getName() );
+            record.flags |= SceneFormatBinary::SubObjectFlags::IsV1Material;
+        }
+
+        record.customParameter = renderable->mCustomParameter;
+        record.renderQueueSubGroup = renderable->getRenderQueueSubGroup();
+        if( renderable->getPolygonModeOverrideable() )
+            record.flags |= SceneFormatBinary::SubObjectFlags::PolygonModeOverrideable;
+        if( renderable->getUseIdentityView() )
+            record.flags |= SceneFormatBinary::SubObjectFlags::UseIdentityView;
+        if( renderable->getUseIdentityProjection() )
+            record.flags |= SceneFormatBinary::SubObjectFlags::UseIdentityProjection;
+
+        const Renderable::CustomParameterMap &customParams = renderable->getCustomParameters();
+        record.firstCustomParam = static_cast<uint32>( writer.mCustomParams.size() );
+        record.numCustomParams = static_cast<uint32>( customParams.size() );
+
+        Renderable::CustomParameterMap::const_iterator itor = customParams.begin();
+        Renderable::CustomParameterMap::const_iterator endt = customParams.end();
+        while( itor != endt )
+        {
+            SceneFormatBinary::CustomParamRecord customParam;
+            customParam.idx = static_cast<uint32>( itor->first );
+            for( size_t i = 0u; i < 4u; ++i )
+                customParam.value[i] = static_cast<float>( itor->second[i] );
+            writer.mCustomParams.push_back( customParam );
+            ++itor;
+        }
+
+        writer.mSubObjects.push_back( record );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportItemBinary( SceneFormatBinary::Writer &writer, Item *item,
+                                                bool exportMesh )
+    {
+        const Mesh *mesh = item->getMesh().get();
+
+        SceneFormatBinary::MeshObjectRecord record;
+        exportMovableObjectBinary( writer, record.movableObject, item );
+        record.meshIdx = writer.addString( mesh->getName() );
+        record.firstSubObject = static_cast<uint32>( writer.mSubObjects.size() );
+        record.numSubObjects = static_cast<uint32>( item->getNumSubItems() );
+
+        for( uint32 i = 0u; i < record.numSubObjects; ++i )
+            exportRenderableBinary( writer, item->getSubItem( i ) );
+
+        writer.mItems.push_back( record );
+
+        if( exportMesh )
+            saveMesh( mesh );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportEntityBinary( SceneFormatBinary::Writer &writer,
+                                                  v1::Entity *entity, bool exportMesh )
+    {
+        const v1::Mesh *mesh = entity->getMesh().get();
+
+        SceneFormatBinary::MeshObjectRecord record;
+        exportMovableObjectBinary( writer, record.movableObject, entity );
+        record.meshIdx = writer.addString( mesh->getName() );
+        record.firstSubObject = static_cast<uint32>( writer.mSubObjects.size() );
+        record.numSubObjects = static_cast<uint32>( entity->getNumSubEntities() );
+
+        for( uint32 i = 0u; i < record.numSubObjects; ++i )
+            exportRenderableBinary( writer, entity->getSubEntity( i ) );
+
+        writer.mEntities.push_back( record );
+
+        if( exportMesh )
+            saveMesh( mesh );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportLightBinary( SceneFormatBinary::Writer &writer, Light *light )
+    {
+        SceneFormatBinary::LightRecord record;
+        memset( &record, 0, sizeof( record ) );
+
+        exportMovableObjectBinary( writer, record.movableObject, light );
+
+        toFloatArray( record.diffuse, light->getDiffuseColour() );
+        toFloatArray( record.specular, light->getSpecularColour() );
+        record.powerScale = static_cast<float>( light->getPowerScale() );
+
+        record.attenuation[0] = static_cast<float>( light->getAttenuationRange() );
+        record.attenuation[1] = static_cast<float>( light->getAttenuationConstant() );
+        record.attenuation[2] = static_cast<float>( light->getAttenuationLinear() );
+        record.attenuation[3] = static_cast<float>( light->getAttenuationQuadric() );
+
+        record.spot[0] = static_cast<float>( light->getSpotlightInnerAngle().valueRadians() );
+        record.spot[1] = static_cast<float>( light->getSpotlightOuterAngle().valueRadians() );
+        record.spot[2] = static_cast<float>( light->getSpotlightFalloff() );
+        record.spot[3] = static_cast<float>( light->getSpotlightNearClipDistance() );
+
+        if( light->_getOwnShadowFarDistance() != 0.0 )
+            record.shadowFarDistance = static_cast<float>( light->getShadowFarDistance() );
+
+        record.shadowClipDistance[0] = static_cast<float>( light->getShadowNearClipDistance() );
+        record.shadowClipDistance[1] = static_cast<float>( light->getShadowFarClipDistance() );
+
+        const Vector2 rectSize = light->getRectSize();
+        record.rectSize[0] = static_cast<float>( rectSize.x );
+        record.rectSize[1] = static_cast<float>( rectSize.y );
+
+        record.textureLightMaskIdx = light->mTextureLightMaskIdx;
+        record.type = static_cast<uint8>( light->getType() );
+        if( light->getAffectParentNode() )
+            record.flags |= SceneFormatBinary::LightFlags::AffectParentNode;
+
+        writer.mLights.push_back( record );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportNodeRecord( LwString &jsonStr, String &outJson,
+                                                const SceneFormatBinary::Reader &reader,
+                                                uint32 nodeIdx )
+    {
+        const SceneFormatBinary::NodeRecord &node = reader.getNodes()[nodeIdx];
+
+        if( node.flags & SceneFormatBinary::NodeFlags::IsRootNode )
+            outJson += "\n\t\t\t\"is_root_node\" : true,";
+
+        outJson += "\n\t\t\t\"node\" :\n\t\t\t{";
+
+        jsonStr.a( "\n\t\t\t\t\"position\" : " );
+        encodeVector( jsonStr, Vector3( node.position[0], node.position[1], node.position[2] ) );
+        jsonStr.a( ",\n\t\t\t\t\"rotation\" : " );
+        encodeQuaternion( jsonStr, Quaternion( node.orientation[0], node.orientation[1],
+                                               node.orientation[2], node.orientation[3] ) );
+        jsonStr.a( ",\n\t\t\t\t\"scale\" : " );
+        encodeVector( jsonStr, Vector3( node.scale[0], node.scale[1], node.scale[2] ) );
+
+        jsonStr.a( ",\n\t\t\t\t\"inherit_orientation\" : ",
+                   toQuotedStr( ( node.flags & SceneFormatBinary::NodeFlags::InheritOrientation ) !=
+                                0u ) );
+        jsonStr.a( ",\n\t\t\t\t\"inherit_scale\" : ",
+                   toQuotedStr( ( node.flags & SceneFormatBinary::NodeFlags::InheritScale ) != 0u ) );
+        jsonStr.a( ",\n\t\t\t\t\"is_static\" : ",
+                   toQuotedStr( ( node.flags & SceneFormatBinary::NodeFlags::IsStatic ) != 0u ) );
+
+        if( node.nameIdx != SceneFormatBinary::c_invalidIdx )
+            jsonStr.a( ",\n\t\t\t\t\"name\" : \"", reader.getString( node.nameIdx ), "\"" );
+
+        if( node.parentIdx != SceneFormatBinary::c_invalidIdx )
+            jsonStr.a( ",\n\t\t\t\t\"parent_id\" : ", node.parentIdx );
+
+        flushLwString( jsonStr, outJson );
+
+        outJson += "\n\t\t\t}";
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportMovableObjectRecord(
+        LwString &jsonStr, String &outJson, const SceneFormatBinary::Reader &reader,
+        const SceneFormatBinary::MovableObjectRecord &record )
+    {
+        outJson += "\t\t\t\"movable_object\" :\n\t\t\t{";
+        if( record.nameIdx != SceneFormatBinary::c_invalidIdx )
+        {
+            outJson += "\n\t\t\t\t\"name\" : \"";
+            outJson += reader.getString( record.nameIdx );
+            outJson += "\",\n";
+        }
+
+        // Always written, so that every optional field below can start with a comma
+        jsonStr.a( "\n\t\t\t\t\"is_static\" : ",
+                   ( record.flags & SceneFormatBinary::MovableObjectFlags::IsStatic ) ? "true"
+                                                                                      : "false" );
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasRenderingDistance )
+        {
+            jsonStr.a( ",\n\t\t\t\t\"rendering_distance\" : ",
+                       encodeFloat( record.renderingDistance ) );
+        }
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasRenderQueue )
+            jsonStr.a( ",\n\t\t\t\t\"render_queue\" : ", record.renderQueue );
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasLocalAabb )
+        {
+            jsonStr.a( ",\n\t\t\t\t\"local_aabb\" : " );
+            encodeAabb( jsonStr,
+                        Aabb( Vector3( record.localAabbCenter[0], record.localAabbCenter[1],
+                                       record.localAabbCenter[2] ),
+                              Vector3( record.localAabbHalfSize[0], record.localAabbHalfSize[1],
+                                       record.localAabbHalfSize[2] ) ) );
+            jsonStr.a( ",\n\t\t\t\t\"local_radius\" : ", encodeFloat( record.localRadius ) );
+        }
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasVisibilityFlags )
+            jsonStr.a( ",\n\t\t\t\t\"visibility_flags\" : ", record.visibilityFlags );
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasQueryFlags )
+            jsonStr.a( ",\n\t\t\t\t\"query_flags\" : ", record.queryFlags );
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasLightMask )
+            jsonStr.a( ",\n\t\t\t\t\"light_mask\" : ", record.lightMask );
+
+        if( record.parentNodeIdx != SceneFormatBinary::c_invalidIdx )
+            jsonStr.a( ",\n\t\t\t\t\"parent_node_id\" : ", record.parentNodeIdx );
+
+        flushLwString( jsonStr, outJson );
+
+        outJson += "\n\t\t\t}";
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportSubObjectRecords( LwString &jsonStr, String &outJson,
+                                                      const SceneFormatBinary::Reader &reader,
+                                                      uint32 firstSubObject, uint32 numSubObjects )
+    {
+        const SceneFormatBinary::SubObjectRecord *subObjects = reader.getSubObjects() + firstSubObject;
+        const SceneFormatBinary::CustomParamRecord *customParams = reader.getCustomParams();
+
+        for( uint32 i = 0u; i < numSubObjects; ++i )
+        {
+            const SceneFormatBinary::SubObjectRecord &subObject = subObjects[i];
+
+            if( i != 0 )
+                outJson += ",\n";
+            else
+                outJson += "\n";
+            outJson += "\t\t\t\t{";
+            outJson += "\n\t\t\t\t\t\"renderable\" :\n\t\t\t\t\t{";
+
+            jsonStr.a( "\n\t\t\t\t\t\t\"datablock\" : \"", reader.getString( subObject.datablockIdx ),
+                       "\"" );
+            jsonStr.a( ",\n\t\t\t\t\t\t\"is_v1_material\" : ",
+                       toQuotedStr( ( subObject.flags &
+                                      SceneFormatBinary::SubObjectFlags::IsV1Material ) != 0u ) );
+            jsonStr.a( ",\n\t\t\t\t\t\t\"custom_parameter\" : ", subObject.customParameter );
+            jsonStr.a( ",\n\t\t\t\t\t\t\"render_queue_sub_group\" : ", subObject.renderQueueSubGroup );
+            jsonStr.a( ",\n\t\t\t\t\t\t\"polygon_mode_overrideable\" : ",
+                       toQuotedStr( ( subObject.flags &
+                                      SceneFormatBinary::SubObjectFlags::PolygonModeOverrideable ) !=
+                                    0u ) );
+            jsonStr.a( ",\n\t\t\t\t\t\t\"use_identity_view\" : ",
+                       toQuotedStr( ( subObject.flags &
+                                      SceneFormatBinary::SubObjectFlags::UseIdentityView ) != 0u ) );
+            jsonStr.a( ",\n\t\t\t\t\t\t\"use_identity_projection\" : ",
+                       toQuotedStr( ( subObject.flags &
+                                      SceneFormatBinary::SubObjectFlags::UseIdentityProjection ) !=
+                                    0u ) );
+
+            flushLwString( jsonStr, outJson );
+
+            if( subObject.numCustomParams > 0u )
+            {
+                outJson += ",\n\t\t\t\t\t\t\"custom_parameters\" : { ";
+                for( uint32 j = 0u; j < subObject.numCustomParams; ++j )
+                {
+                    const SceneFormatBinary::CustomParamRecord &customParam =
+                        customParams[subObject.firstCustomParam + j];
+                    if( j != 0u )
+                        jsonStr.a( ", " );
+                    jsonStr.a( "\"", customParam.idx, "\" : " );
+                    encodeVector( jsonStr, Vector4( customParam.value[0], customParam.value[1],
+                                                    customParam.value[2], customParam.value[3] ) );
+                }
+
+                flushLwString( jsonStr, outJson );
+                outJson += " }";
+            }
+
+            outJson += "\n\t\t\t\t\t}\n";
+            outJson += "\t\t\t\t}";
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportMeshObjectRecords( LwString &jsonStr, String &outJson,
+                                                       const SceneFormatBinary::Reader &reader,
+                                                       bool entities )
+    {
+        const SceneFormatBinary::Header &header = reader.getHeader();
+        const SceneFormatBinary::MeshObjectRecord *meshObjects =
+            entities ? reader.getEntities() : reader.getItems();
+        const uint32 numMeshObjects = entities ? header.numEntities : header.numItems;
+
+        if( !numMeshObjects )
+            return;
+
+        outJson += entities ? ",\n\t\"entities\" :\n\t[\n" : ",\n\t\"items\" :\n\t[\n";
+
+        for( uint32 i = 0u; i < numMeshObjects; ++i )
+        {
+            const SceneFormatBinary::MeshObjectRecord &meshObject = meshObjects[i];
+
+            outJson += i == 0u ? "\n\t\t{" : ",\n\t\t{";
+
+            outJson += "\n\t\t\t\"mesh\" : \"";
+            outJson += reader.getString( meshObject.meshIdx );
+            outJson += "\",\n";
+            exportMovableObjectRecord( jsonStr, outJson, reader, meshObject.movableObject );
+
+            outJson += entities ? ",\n\t\t\t\"sub_entities\" :\n\t\t\t["
+                                : ",\n\t\t\t\"sub_items\" :\n\t\t\t[";
+            exportSubObjectRecords( jsonStr, outJson, reader, meshObject.firstSubObject,
+                                    meshObject.numSubObjects );
+            outJson += "\n\t\t\t]";
+
+            outJson += "\n\t\t}";
+        }
+
+        outJson += "\n\t]";
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportLightRecords( LwString &jsonStr, String &outJson,
+                                                  const SceneFormatBinary::Reader &reader )
+    {
+        const uint32 numLights = reader.getHeader().numLights;
+        if( !numLights )
+            return;
+
+        const SceneFormatBinary::LightRecord *lights = reader.getLights();
+
+        outJson += ",\n\t\"lights\" :\n\t[\n";
+
+        for( uint32 i = 0u; i < numLights; ++i )
+        {
+            const SceneFormatBinary::LightRecord &light = lights[i];
+
+            outJson += i == 0u ? "\n\t\t{" : ",\n\t\t{";
+
+            jsonStr.a( "\n\t\t\t\"diffuse\" : " );
+            encodeColour( jsonStr, ColourValue( light.diffuse[0], light.diffuse[1], light.diffuse[2] ) );
+            jsonStr.a( ",\n\t\t\t\"specular\" : " );
+            encodeColour( jsonStr,
+                          ColourValue( light.specular[0], light.specular[1], light.specular[2] ) );
+            jsonStr.a( ",\n\t\t\t\"power\" : ", encodeFloat( light.powerScale ) );
+
+            jsonStr.a( ",\n\t\t\t\"type\" : " );
+            toQuotedStr( jsonStr, static_cast<Light::LightTypes>( light.type ) );
+
+            jsonStr.a( ",\n\t\t\t\"attenuation\" : " );
+            encodeVector( jsonStr, Vector4( light.attenuation[0], light.attenuation[1],
+                                            light.attenuation[2], light.attenuation[3] ) );
+
+            jsonStr.a( ",\n\t\t\t\"spot\" : " );
+            encodeVector( jsonStr,
+                          Vector4( light.spot[0], light.spot[1], light.spot[2], light.spot[3] ) );
+
+            if( light.shadowFarDistance != 0.0f )
+                jsonStr.a( ",\n\t\t\t\"shadow_far_dist\" : ", encodeFloat( light.shadowFarDistance ) );
+
+            if( light.shadowClipDistance[0] >= 0.0f || light.shadowClipDistance[1] >= 0.0f )
+            {
+                jsonStr.a( ",\n\t\t\t\"shadow_clip_dist\" : " );
+                encodeVector( jsonStr,
+                              Vector2( light.shadowClipDistance[0], light.shadowClipDistance[1] ) );
+            }
+
+            jsonStr.a( ",\n\t\t\t\"rect_size\" : " );
+            encodeVector( jsonStr, Vector2( light.rectSize[0], light.rectSize[1] ) );
+
+            jsonStr.a( ",\n\t\t\t\"texture_light_mask_idx\" : ", light.textureLightMaskIdx );
+
+            if( light.flags & SceneFormatBinary::LightFlags::AffectParentNode )
+                jsonStr.a( ",\n\t\t\t\"affect_parent_node\" : true" );
+
+            jsonStr.a( ",\n" );
+            flushLwString( jsonStr, outJson );
+            exportMovableObjectRecord( jsonStr, outJson, reader, light.movableObject );
+
+            outJson += "\n\t\t}";
+        }
+
+        outJson += "\n\t]";
+    }
+    //-----------------------------------------------------------------------------------
     void SceneFormatExporter::_exportScene( String &outJson, set<String>::type &savedTextures,
                                             uint32 exportFlags )
     {
@@ -933,54 +1410,40 @@ namespace Ogre
         if( exportFlags & SceneFlags::TexturesOriginal )
             jsonStr.a( ",\n\t\"saved_original_textures\" : true" );
 
+        // SceneNodes, Items, Entities & Lights go to scene.bin. See _exportSceneBinary
+        const bool binarySceneObjects = ( exportFlags & SceneFlags::BinarySceneObjects ) != 0u;
+        if( binarySceneObjects )
+            jsonStr.a( ",\n\t\"binary_scene_objects\" : true" );
+
         flushLwString( jsonStr, outJson );
 
         if( exportFlags & SceneFlags::SceneNodes )
         {
-            uint32 nodeCount = 0;
+            // Even when the nodes go to scene.bin, we still need mNodeToIdxMap for decals.
+            // The node indices are the same in both files.
+            SceneNodeVec sceneNodes;
+            collectSceneNodes( sceneNodes );
 
-            outJson += ",\n\t\"scene_nodes\" :\n\t[";
-            for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+            if( !binarySceneObjects )
             {
-                SceneNode *rootSceneNode =
-                    mSceneManager->getRootSceneNode( static_cast<SceneMemoryMgrTypes>( i ) );
-
-                mNodeToIdxMap[rootSceneNode] = nodeCount++;
-                if( i == 0 )
-                    outJson += "\n\t\t{";
-                else
-                    outJson += ",\n\t\t{";
-                exportSceneNode( jsonStr, outJson, rootSceneNode );
-                outJson += "\n\t\t}";
-
-                std::queue<SceneNode *> nodeQueue;
-                nodeQueue.push( rootSceneNode );
-
-                while( !nodeQueue.empty() )
+                outJson += ",\n\t\"scene_nodes\" :\n\t[";
+                SceneNodeVec::const_iterator itor = sceneNodes.begin();
+                SceneNodeVec::const_iterator endt = sceneNodes.end();
+                while( itor != endt )
                 {
-                    SceneNode *frontNode = nodeQueue.front();
-                    nodeQueue.pop();
-                    Node::NodeVecIterator nodeItor = frontNode->getChildIterator();
-                    while( nodeItor.hasMoreElements() )
-                    {
-                        Node *node = nodeItor.getNext();
-                        SceneNode *sceneNode = dynamic_cast<SceneNode *>( node );
-
-                        if( sceneNode && mListener->exportSceneNode( sceneNode ) )
-                        {
-                            mNodeToIdxMap[sceneNode] = nodeCount++;
-                            outJson += ",\n\t\t{";
-                            exportSceneNode( jsonStr, outJson, sceneNode );
-                            outJson += "\n\t\t}";
-                            nodeQueue.push( sceneNode );
-                        }
-                    }
+                    if( itor == sceneNodes.begin() )
+                        outJson += "\n\t\t{";
+                    else
+                        outJson += ",\n\t\t{";
+                    exportSceneNode( jsonStr, outJson, *itor );
+                    outJson += "\n\t\t}";
+                    ++itor;
                 }
+                outJson += "\n\t]";
             }
-            outJson += "\n\t]";
         }
 
-        if( exportFlags & SceneFlags::Items )
+        if( ( exportFlags & SceneFlags::Items ) && !binarySceneObjects )
         {
             SceneManager::MovableObjectIterator movableObjects =
                 mSceneManager->getMovableObjectIterator( ItemFactory::FACTORY_TYPE_NAME );
@@ -1013,7 +1476,7 @@ namespace Ogre
             }
         }
 
-        if( exportFlags & SceneFlags::Lights )
+        if( ( exportFlags & SceneFlags::Lights ) && !binarySceneObjects )
         {
             SceneManager::MovableObjectIterator movableObjects =
                 mSceneManager->getMovableObjectIterator( LightFactory::FACTORY_TYPE_NAME );
@@ -1046,7 +1509,7 @@ namespace Ogre
             }
         }
 
-        if( exportFlags & SceneFlags::Entities )
+        if( ( exportFlags & SceneFlags::Entities ) && !binarySceneObjects )
         {
             SceneManager::MovableObjectIterator movableObjects =
                 mSceneManager->getMovableObjectIterator( v1::EntityFactory::FACTORY_TYPE_NAME );
@@ -1149,6 +1612,21 @@ namespace Ogre
             file.close();
         }
 
+        if( exportFlags & SceneFlags::BinarySceneObjects )
+        {
+            vector<uint8>::type binary;
+            _exportSceneBinary( binary, exportFlags );
+
+            const String scenePath = folderPath + "/scene.bin";
+            std::ofstream file( scenePath.c_str(), std::ios::binary | std::ios::out );
+            if( file.is_open() && !binary.empty() )
+            {
+                file.write( reinterpret_cast<const char *>( &binary[0] ),
+                            static_cast<std::streamsize>( binary.size() ) );
+            }
+            file.close();
+        }
+
         if( exportFlags & SceneFlags::Materials )
         {
             HlmsManager *hlmsManager = mRoot->getHlmsManager();
@@ -1192,4 +1670,159 @@ namespace Ogre
             }
         }
     }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::_exportSceneBinary( vector<uint8>::type &outBinary,
+                                                  uint32 exportFlags )
+    {
+        mNodeToIdxMap.clear();
+        mExportedMeshes.clear();
+        mExportedMeshesV1.clear();
+
+        mListener->setSceneFlags( exportFlags, this );
+
+        SceneFormatBinary::Writer writer;
+        writer.mDefaultVisibilityFlags = MovableObject::getDefaultVisibilityFlags();
+        writer.mDefaultQueryFlags = MovableObject::getDefaultQueryFlags();
+        writer.mDefaultLightMask = MovableObject::getDefaultLightMask();
+
+        if( exportFlags & SceneFlags::SceneNodes )
+        {
+            SceneNodeVec sceneNodes;
+            collectSceneNodes( sceneNodes );
+
+            writer.mNodes.reserve( sceneNodes.size() );
+
+            SceneNodeVec::const_iterator itor = sceneNodes.begin();
+            SceneNodeVec::const_iterator endt = sceneNodes.end();
+            while( itor != endt )
+            {
+                SceneNode *sceneNode = *itor;
+
+                SceneFormatBinary::NodeRecord record;
+                memset( &record, 0, sizeof( record ) );
+
+                toFloatArray( record.position, sceneNode->getPosition() );
+                const Quaternion orientation = sceneNode->getOrientation();
+                record.orientation[0] = static_cast<float>( orientation.w );
+                record.orientation[1] = static_cast<float>( orientation.x );
+                record.orientation[2] = static_cast<float>( orientation.y );
+                record.orientation[3] = static_cast<float>( orientation.z );
+                toFloatArray( record.scale, sceneNode->getScale() );
+
+                record.parentIdx = SceneFormatBinary::c_invalidIdx;
+                Node *parentNode = sceneNode->getParent();
+                if( parentNode )
+                {
+                    NodeToIdxMap::const_iterator itParent = mNodeToIdxMap.find( parentNode );
+                    if( itParent != mNodeToIdxMap.end() )
+                        record.parentIdx = itParent->second;
+                }
+
+                record.nameIdx = writer.addString( sceneNode->getName() );
+
+                if( sceneNode->isStatic() )
+                    record.flags |= SceneFormatBinary::NodeFlags::IsStatic;
+                if( sceneNode->getInheritOrientation() )
+                    record.flags |= SceneFormatBinary::NodeFlags::InheritOrientation;
+                if( sceneNode->getInheritScale() )
+                    record.flags |= SceneFormatBinary::NodeFlags::InheritScale;
+                if( sceneNode == mSceneManager->getRootSceneNode( SCENE_DYNAMIC ) ||
+                    sceneNode == mSceneManager->getRootSceneNode( SCENE_STATIC ) )
+                {
+                    record.flags |= SceneFormatBinary::NodeFlags::IsRootNode;
+                }
+
+                writer.mNodes.push_back( record );
+                ++itor;
+            }
+        }
+
+        if( exportFlags & SceneFlags::Items )
+        {
+            SceneManager::MovableObjectIterator movableObjects =
+                mSceneManager->getMovableObjectIterator( ItemFactory::FACTORY_TYPE_NAME );
+            while( movableObjects.hasMoreElements() )
+            {
+                Item *item = static_cast<Item *>( movableObjects.getNext() );
+                if( mListener->exportItem( item ) )
+                    exportItemBinary( writer, item, exportFlags & SceneFlags::Meshes );
+            }
+        }
+
+        if( exportFlags & SceneFlags::Lights )
+        {
+            SceneManager::MovableObjectIterator movableObjects =
+                mSceneManager->getMovableObjectIterator( LightFactory::FACTORY_TYPE_NAME );
+            while( movableObjects.hasMoreElements() )
+            {
+                Light *light = static_cast<Light *>( movableObjects.getNext() );
+                if( mListener->exportLight( light ) )
+                    exportLightBinary( writer, light );
+            }
+        }
+
+        if( exportFlags & SceneFlags::Entities )
+        {
+            SceneManager::MovableObjectIterator movableObjects =
+                mSceneManager->getMovableObjectIterator( v1::EntityFactory::FACTORY_TYPE_NAME );
+            while( movableObjects.hasMoreElements() )
+            {
+                v1::Entity *entity = static_cast<v1::Entity *>( movableObjects.getNext() );
+                if( mListener->exportEntity( entity ) )
+                    exportEntityBinary( writer, entity, exportFlags & SceneFlags::MeshesV1 );
+            }
+        }
+
+        writer.serialize( outBinary );
+
+        mNodeToIdxMap.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::exportSceneBinary( vector<uint8>::type &outBinary, uint32 exportFlags )
+    {
+        mCurrentExportFolder.clear();
+        _exportSceneBinary( outBinary, exportFlags & static_cast<uint32>( ~( SceneFlags::Meshes |
+                                                                             SceneFlags::MeshesV1 ) ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatExporter::convertBinaryToJson( const void *data, size_t sizeBytes,
+                                                   String &outJson )
+    {
+        SceneFormatBinary::Reader reader( data, sizeBytes, "SceneFormatExporter::convertBinaryToJson" );
+        const SceneFormatBinary::Header &header = reader.getHeader();
+
+        char tmpBuffer[4096];
+        LwString jsonStr( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        // Old importers cannot import our scenes if they use float literals
+        if( mUseBinaryFloatingPoint )
+            jsonStr.a( "{\n\t\"version\" : ", (int)VERSION_0, "" );
+        else
+            jsonStr.a( "{\n\t\"version\" : ", (int)VERSION_1, "" );
+        jsonStr.a( ",\n\t\"use_binary_floating_point\" : ", toQuotedStr( mUseBinaryFloatingPoint ) );
+        jsonStr.a( ",\n\t\"MovableObject_msDefaultVisibilityFlags\" : ",
+                   header.defaultVisibilityFlags );
+        jsonStr.a( ",\n\t\"MovableObject_msDefaultQueryFlags\" : ", header.defaultQueryFlags );
+        jsonStr.a( ",\n\t\"MovableObject_msDefaultLightMask\" : ", header.defaultLightMask );
+
+        flushLwString( jsonStr, outJson );
+
+        if( header.numNodes > 0u )
+        {
+            outJson += ",\n\t\"scene_nodes\" :\n\t[";
+            for( uint32 i = 0u; i < header.numNodes; ++i )
+            {
+                outJson += i == 0u ? "\n\t\t{" : ",\n\t\t{";
+                exportNodeRecord( jsonStr, outJson, reader, i );
+                outJson += "\n\t\t}";
+            }
+            outJson += "\n\t]";
+        }
+
+        exportMeshObjectRecords( jsonStr, outJson, reader, false );
+        exportLightRecords( jsonStr, outJson, reader );
+        exportMeshObjectRecords( jsonStr, outJson, reader, true );
+
+        outJson += "\n}\n";
+    }
 }  // namespace Ogre
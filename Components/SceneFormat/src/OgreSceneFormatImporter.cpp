@@ -28,11 +28,14 @@ THE SOFTWARE.
 
 #include "OgreSceneFormatImporter.h"
 
+#include "OgreSceneFormatBinary.h"
+
 #include "Compositor/OgreCompositorManager2.h"
 #include "Cubemaps/OgreParallaxCorrectedCubemap.h"
 #include "InstantRadiosity/OgreInstantRadiosity.h"
 #include "OgreDecal.h"
 #include "OgreEntity.h"
+#include "OgreFileSystem.h"
 #include "OgreFileSystemLayer.h"
 #include "OgreHlms.h"
 #include "OgreHlmsPbs.h"
@@ -42,11 +45,16 @@ THE SOFTWARE.
 #include "OgreLwString.h"
 #include "OgreMesh2.h"
 #include "OgreMesh2Serializer.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshManager2.h"
 #include "OgreMeshSerializer.h"
 #include "OgreRoot.h"
 #include "OgreSceneManager.h"
 #include "OgreTextureFilters.h"
 #include "OgreTextureGpuManager.h"
+#include "OgreTimer.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 #if defined( __GNUC__ ) && !defined( __clang__ )
 #    pragma GCC diagnostic push
@@ -68,6 +76,69 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    /// Calls Resource::prepare (i.e. reads the file into memory) on a list of
+    /// resources, distributed across all worker threads.
+    class SceneFormatImporter::PrepareMeshesTask : public UniformScalableTask
+    {
+        const vector<Resource *>::type &mResources;
+
+        LightweightMutex   mErrorMutex;
+        std::exception_ptr mFirstError;
+
+    public:
+        PrepareMeshesTask( const vector<Resource *>::type &resources ) : mResources( resources ) {}
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            const size_t numResources = mResources.size();
+            for( size_t i = threadId; i < numResources; i += numThreads )
+            {
+                try
+                {
+                    mResources[i]->prepare();
+                }
+                catch( ... )
+                {
+                    // Exceptions must not escape a worker thread. Resource::prepare already
+                    // restored the resource to LOADSTATE_UNLOADED; keep the error so that
+                    // it can be thrown from the main thread.
+                    mErrorMutex.lock();
+                    if( !mFirstError )
+                        mFirstError = std::current_exception();
+                    mErrorMutex.unlock();
+                }
+            }
+        }
+
+        /// Throws (from the calling thread) the first error caught by a worker thread, if any.
+        void rethrowFirstError()
+        {
+            if( mFirstError )
+                std::rethrow_exception( mFirstError );
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    SceneFormatImporter::ImportStats::ImportStats() :
+        parseTime( 0 ),
+        resourceGroupTime( 0 ),
+        meshPrepareTime( 0 ),
+        sceneNodesTime( 0 ),
+        itemsTime( 0 ),
+        entitiesTime( 0 ),
+        lightsTime( 0 ),
+        decalsTime( 0 ),
+        sceneSettingsTime( 0 ),
+        instantRadiosityTime( 0 ),
+        totalTime( 0 ),
+        numSceneNodes( 0 ),
+        numItems( 0 ),
+        numEntities( 0 ),
+        numLights( 0 ),
+        numDecals( 0 ),
+        numMeshesPrepared( 0 )
+    {
+    }
+    //-----------------------------------------------------------------------------------
     SceneFormatImporter::SceneFormatImporter( Root *root, SceneManager *sceneManager,
                                               const String &defaultPccWorkspaceName ) :
         SceneFormatBase( root, sceneManager ),
@@ -77,7 +148,8 @@ namespace Ogre
         mSceneComponentTransform( Matrix4::IDENTITY ),
         mDefaultPccWorkspaceName( defaultPccWorkspaceName ),
         mUseBinaryFloatingPoint( true ),
-        mUsingOitd( false )
+        mUsingOitd( false ),
+        mParallelMeshPreparation( true )
     {
         memset( mRootNodes, 0, sizeof( mRootNodes ) );
         memset( mParentlessRootNodes, 0, sizeof( mParentlessRootNodes ) );
@@ -397,8 +469,10 @@ namespace Ogre
             if( parentIdx != nodeIdx )
             {
                 SceneNode *parentNode = 0;
-                IndexToSceneNodeMap::const_iterator parentNodeIt = mCreatedSceneNodes.find( parentIdx );
-                if( parentNodeIt == mCreatedSceneNodes.end() )
+                if( parentIdx < mCreatedSceneNodes.size() )
+                    parentNode = mCreatedSceneNodes[parentIdx];
+
+                if( !parentNode )
                 {
                     // Our parent node will be created after us. Initialize it now.
                     if( parentIdx < sceneNodesJson.Size() && sceneNodesJson[parentIdx].IsObject() )
@@ -417,11 +491,6 @@ namespace Ogre
                             "SceneFormatImporter::importSceneNode" );
                     }
                 }
-                else
-                {
-                    // Parent was already created
-                    parentNode = parentNodeIt->second;
-                }
 
                 sceneNode = parentNode->createChildSceneNode( sceneNodeType );
             }
@@ -448,6 +517,7 @@ namespace Ogre
             importNode( nodeValue, sceneNode );
 
             mCreatedSceneNodes[nodeIdx] = sceneNode;
+            ++mImportStats.numSceneNodes;
         }
         else
         {
@@ -462,6 +532,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void SceneFormatImporter::importSceneNodes( const rapidjson::Value &json )
     {
+        mCreatedSceneNodes.resize( json.Size(), 0 );
+
         rapidjson::Value::ConstValueIterator begin = json.Begin();
         rapidjson::Value::ConstValueIterator itor = begin;
         rapidjson::Value::ConstValueIterator end = json.End();
@@ -469,7 +541,7 @@ namespace Ogre
         while( itor != end )
         {
             const uint32 nodeIdx = static_cast<uint32>( itor - begin );
-            if( itor->IsObject() && mCreatedSceneNodes.find( nodeIdx ) == mCreatedSceneNodes.end() )
+            if( itor->IsObject() && !mCreatedSceneNodes[nodeIdx] )
             {
                 importSceneNode( *itor, nodeIdx, json );
             }
@@ -491,9 +563,9 @@ namespace Ogre
         if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsUint() )
         {
             uint32 nodeId = tmpIt->value.GetUint();
-            IndexToSceneNodeMap::const_iterator itNode = mCreatedSceneNodes.find( nodeId );
-            if( itNode != mCreatedSceneNodes.end() )
-                itNode->second->attachObject( movableObject );
+            SceneNode *sceneNode = nodeId < mCreatedSceneNodes.size() ? mCreatedSceneNodes[nodeId] : 0;
+            if( sceneNode )
+                sceneNode->attachObject( movableObject );
             else
             {
                 LogManager::getSingleton().logMessage( "WARNING: MovableObject references SceneNode " +
@@ -678,7 +750,10 @@ namespace Ogre
         while( itor != end )
         {
             if( itor->IsObject() )
+            {
                 importItem( *itor );
+                ++mImportStats.numItems;
+            }
 
             ++itor;
         }
@@ -746,7 +821,10 @@ namespace Ogre
         while( itor != end )
         {
             if( itor->IsObject() )
+            {
                 importEntity( *itor );
+                ++mImportStats.numEntities;
+            }
 
             ++itor;
         }
@@ -835,7 +913,10 @@ namespace Ogre
         while( itor != end )
         {
             if( itor->IsObject() )
+            {
                 importLight( *itor );
+                ++mImportStats.numLights;
+            }
 
             ++itor;
         }
@@ -1094,7 +1175,10 @@ namespace Ogre
         while( itor != end )
         {
             if( itor->IsObject() )
+            {
                 importDecal( *itor );
+                ++mImportStats.numDecals;
+            }
 
             ++itor;
         }
@@ -1349,9 +1433,170 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::collectMeshNames( const rapidjson::Value &json,
+                                                set<String>::type &outMeshNames )
+    {
+        rapidjson::Value::ConstValueIterator itor = json.Begin();
+        rapidjson::Value::ConstValueIterator end = json.End();
+
+        while( itor != end )
+        {
+            if( itor->IsObject() )
+            {
+                rapidjson::Value::ConstMemberIterator tmpIt = itor->FindMember( "mesh" );
+                if( tmpIt != itor->MemberEnd() && tmpIt->value.IsString() )
+                    outMeshNames.insert( tmpIt->value.GetString() );
+            }
+
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::prepareMeshes( const set<String>::type &meshNames,
+                                             const set<String>::type &meshNamesV1 )
+    {
+        // Without thread support, the ResourceGroupManager & resource managers
+        // aren't protected against being used from multiple threads.
+        if( !OGRE_THREAD_SUPPORT || !mParallelMeshPreparation ||
+            mSceneManager->getNumWorkerThreads() <= 1u )
+        {
+            return;
+        }
+
+        // Must match the resource group used by importItem & importEntity
+        const String resourceGroup = "SceneFormatImporter";
+
+        vector<Resource *>::type resources;
+        // Keep a strong reference while worker threads are operating on them
+        vector<ResourcePtr>::type resourcePtrs;
+
+        // Creating the resource touches the ResourceManager, thus must be done here
+        set<String>::type::const_iterator itName = meshNames.begin();
+        set<String>::type::const_iterator enName = meshNames.end();
+        while( itName != enName )
+        {
+            ResourcePtr resource =
+                MeshManager::getSingleton().createOrRetrieve( *itName, resourceGroup ).first;
+            if( resource->getLoadingState() == Resource::LOADSTATE_UNLOADED )
+            {
+                resources.push_back( resource.get() );
+                resourcePtrs.push_back( resource );
+            }
+            ++itName;
+        }
+
+        itName = meshNamesV1.begin();
+        enName = meshNamesV1.end();
+        while( itName != enName )
+        {
+            ResourcePtr resource =
+                v1::MeshManager::getSingleton().createOrRetrieve( *itName, resourceGroup ).first;
+            if( resource->getLoadingState() == Resource::LOADSTATE_UNLOADED )
+            {
+                resources.push_back( resource.get() );
+                resourcePtrs.push_back( resource );
+            }
+            ++itName;
+        }
+
+        if( resources.empty() )
+            return;
+
+        // prepareImpl logs when verbose. LogManager is not safe to
+        // call from multiple threads when built without thread support.
+        const bool meshVerbose = MeshManager::getSingleton().getVerbose();
+        const bool meshV1Verbose = v1::MeshManager::getSingleton().getVerbose();
+        MeshManager::getSingleton().setVerbose( false );
+        v1::MeshManager::getSingleton().setVerbose( false );
+
+        PrepareMeshesTask task( resources );
+        mSceneManager->executeUserScalableTask( &task, true );
+
+        MeshManager::getSingleton().setVerbose( meshVerbose );
+        v1::MeshManager::getSingleton().setVerbose( meshV1Verbose );
+
+        task.rethrowFirstError();
+
+        vector<Resource *>::type::const_iterator itRes = resources.begin();
+        vector<Resource *>::type::const_iterator enRes = resources.end();
+        while( itRes != enRes )
+        {
+            if( ( *itRes )->isPrepared() )
+                ++mImportStats.numMeshesPrepared;
+            ++itRes;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::prepareMeshes( const rapidjson::Document &d, uint32 importFlags )
+    {
+        // Without thread support, the ResourceGroupManager & resource managers
+        // aren't protected against being used from multiple threads.
+        if( !OGRE_THREAD_SUPPORT || !mParallelMeshPreparation ||
+            mSceneManager->getNumWorkerThreads() <= 1u )
+        {
+            return;
+        }
+
+        set<String>::type meshNames;
+        set<String>::type meshNamesV1;
+
+        rapidjson::Value::ConstMemberIterator itor;
+
+        if( importFlags & SceneFlags::Items )
+        {
+            itor = d.FindMember( "items" );
+            if( itor != d.MemberEnd() && itor->value.IsArray() )
+                collectMeshNames( itor->value, meshNames );
+        }
+
+        if( importFlags & SceneFlags::Entities )
+        {
+            itor = d.FindMember( "entities" );
+            if( itor != d.MemberEnd() && itor->value.IsArray() )
+                collectMeshNames( itor->value, meshNamesV1 );
+        }
+
+        prepareMeshes( meshNames, meshNamesV1 );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::logImportStats() const
+    {
+        char tmpBuffer[1024];
+        LwString msg( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        const ImportStats &s = mImportStats;
+        msg.a( "SceneFormatImporter: imported ", mFilename.c_str(), " in ",
+               LwString::Float( float( s.totalTime ) / 1000.0f, 2 ), " ms" );
+        msg.a( "\n\tParse JSON:         ", LwString::Float( float( s.parseTime ) / 1000.0f, 2 ),
+               " ms" );
+        msg.a( "\n\tResource group:     ",
+               LwString::Float( float( s.resourceGroupTime ) / 1000.0f, 2 ), " ms" );
+        msg.a( "\n\tMesh prepare:       ", LwString::Float( float( s.meshPrepareTime ) / 1000.0f, 2 ),
+               " ms (", s.numMeshesPrepared, " meshes)" );
+        msg.a( "\n\tScene nodes:        ", LwString::Float( float( s.sceneNodesTime ) / 1000.0f, 2 ),
+               " ms (", s.numSceneNodes, ")" );
+        msg.a( "\n\tItems:              ", LwString::Float( float( s.itemsTime ) / 1000.0f, 2 ),
+               " ms (", s.numItems, ")" );
+        msg.a( "\n\tEntities:           ", LwString::Float( float( s.entitiesTime ) / 1000.0f, 2 ),
+               " ms (", s.numEntities, ")" );
+        msg.a( "\n\tLights:             ", LwString::Float( float( s.lightsTime ) / 1000.0f, 2 ),
+               " ms (", s.numLights, ")" );
+        msg.a( "\n\tDecals:             ", LwString::Float( float( s.decalsTime ) / 1000.0f, 2 ),
+               " ms (", s.numDecals, ")" );
+        msg.a( "\n\tScene settings:     ",
+               LwString::Float( float( s.sceneSettingsTime ) / 1000.0f, 2 ), " ms" );
+        msg.a( "\n\tInstant Radiosity:  ",
+               LwString::Float( float( s.instantRadiosityTime ) / 1000.0f, 2 ), " ms" );
+
+        LogManager::getSingleton().logMessage( msg.c_str() );
+    }
+    //-----------------------------------------------------------------------------------
     void SceneFormatImporter::importScene( const String &filename, const rapidjson::Document &d,
                                            uint32 importFlags )
     {
+        Timer timer;
+        uint64 phaseStart = timer.getMicroseconds();
+
         mUseBinaryFloatingPoint = true;  // The default when setting is not present
 
         mFilename = filename;
@@ -1411,44 +1656,70 @@ namespace Ogre
         if( itor != d.MemberEnd() && itor->value.IsUint() )
             MovableObject::setDefaultLightMask( itor->value.GetUint() );
 
+        uint64 phaseEnd = timer.getMicroseconds();
+
+        // Mesh file IO happens in worker threads. Everything else must be done from this thread.
+        phaseStart = phaseEnd;
+        prepareMeshes( d, importFlags );
+        phaseEnd = timer.getMicroseconds();
+        mImportStats.meshPrepareTime += phaseEnd - phaseStart;
+
         if( importFlags & SceneFlags::SceneNodes )
         {
+            phaseStart = phaseEnd;
             itor = d.FindMember( "scene_nodes" );
             if( itor != d.MemberEnd() && itor->value.IsArray() )
                 importSceneNodes( itor->value );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.sceneNodesTime += phaseEnd - phaseStart;
         }
 
         if( importFlags & SceneFlags::Items )
         {
+            phaseStart = phaseEnd;
             itor = d.FindMember( "items" );
             if( itor != d.MemberEnd() && itor->value.IsArray() )
                 importItems( itor->value );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.itemsTime += phaseEnd - phaseStart;
         }
 
         if( importFlags & SceneFlags::Entities )
         {
+            phaseStart = phaseEnd;
             itor = d.FindMember( "entities" );
             if( itor != d.MemberEnd() && itor->value.IsArray() )
                 importEntities( itor->value );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.entitiesTime += phaseEnd - phaseStart;
         }
 
         if( importFlags & SceneFlags::Lights )
         {
+            phaseStart = phaseEnd;
             itor = d.FindMember( "lights" );
             if( itor != d.MemberEnd() && itor->value.IsArray() )
                 importLights( itor->value );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.lightsTime += phaseEnd - phaseStart;
         }
 
         if( importFlags & SceneFlags::Decals )
         {
+            phaseStart = phaseEnd;
             itor = d.FindMember( "decals" );
             if( itor != d.MemberEnd() && itor->value.IsArray() )
                 importDecals( itor->value );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.decalsTime += phaseEnd - phaseStart;
         }
 
+        phaseStart = phaseEnd;
         itor = d.FindMember( "scene" );
         if( itor != d.MemberEnd() && itor->value.IsObject() )
             importSceneSettings( itor->value, importFlags );
+        phaseEnd = timer.getMicroseconds();
+        mImportStats.sceneSettingsTime += phaseEnd - phaseStart;
 
         if( !( importFlags & SceneFlags::LightsVpl ) )
         {
@@ -1467,6 +1738,7 @@ namespace Ogre
             mVplLights.clear();
         }
 
+        phaseStart = timer.getMicroseconds();
         if( mInstantRadiosity && importFlags & SceneFlags::BuildInstantRadiosity )
         {
             mInstantRadiosity->build();
@@ -1483,11 +1755,892 @@ namespace Ogre
                     mIrradianceVolume->getFadeAttenuationOverDistace() );
             }
         }
+        phaseEnd = timer.getMicroseconds();
+        mImportStats.instantRadiosityTime += phaseEnd - phaseStart;
 
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
             mRootNodes[i] = oldRootNodes[i];
     }
 
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importMovableObjectBinary(
+        const SceneFormatBinary::Reader &reader, const SceneFormatBinary::MovableObjectRecord &record,
+        MovableObject *movableObject )
+    {
+        if( record.nameIdx != SceneFormatBinary::c_invalidIdx )
+            movableObject->setName( reader.getString( record.nameIdx ) );
+
+        if( record.parentNodeIdx != SceneFormatBinary::c_invalidIdx )
+        {
+            SceneNode *sceneNode = record.parentNodeIdx < mCreatedSceneNodes.size()
+                                       ? mCreatedSceneNodes[record.parentNodeIdx]
+                                       : 0;
+            if( sceneNode )
+                sceneNode->attachObject( movableObject );
+            else
+            {
+                LogManager::getSingleton().logMessage(
+                    "WARNING: MovableObject references SceneNode " +
+                    StringConverter::toString( record.parentNodeIdx ) +
+                    " which does not exist or couldn't be created" );
+            }
+        }
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasRenderQueue )
+            movableObject->setRenderQueueGroup( record.renderQueue );
+
+        ObjectData &objData = movableObject->_getObjectData();
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasLocalAabb )
+        {
+            movableObject->setLocalAabb(
+                Aabb( Vector3( record.localAabbCenter[0], record.localAabbCenter[1],
+                               record.localAabbCenter[2] ),
+                      Vector3( record.localAabbHalfSize[0], record.localAabbHalfSize[1],
+                               record.localAabbHalfSize[2] ) ) );
+            objData.mLocalRadius[objData.mIndex] = record.localRadius;
+        }
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasRenderingDistance )
+            movableObject->setRenderingDistance( record.renderingDistance );
+
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasVisibilityFlags )
+            objData.mVisibilityFlags[objData.mIndex] = record.visibilityFlags;
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasQueryFlags )
+            objData.mQueryFlags[objData.mIndex] = record.queryFlags;
+        if( record.flags & SceneFormatBinary::MovableObjectFlags::HasLightMask )
+            objData.mLightMask[objData.mIndex] = record.lightMask;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importRenderableBinary( const SceneFormatBinary::Reader &reader,
+                                                      uint32 subObjectIdx, Renderable *renderable )
+    {
+        const SceneFormatBinary::SubObjectRecord &record = reader.getSubObjects()[subObjectIdx];
+
+        const SceneFormatBinary::CustomParamRecord *customParams =
+            reader.getCustomParams() + record.firstCustomParam;
+        for( uint32 i = 0u; i < record.numCustomParams; ++i )
+        {
+            renderable->setCustomParameter(
+                customParams[i].idx, Vector4( customParams[i].value[0], customParams[i].value[1],
+                                              customParams[i].value[2], customParams[i].value[3] ) );
+        }
+
+        if( record.datablockIdx != SceneFormatBinary::c_invalidIdx )
+        {
+            if( !( record.flags & SceneFormatBinary::SubObjectFlags::IsV1Material ) )
+                renderable->setDatablock( reader.getString( record.datablockIdx ) );
+            else
+            {
+                renderable->setDatablockOrMaterialName(
+                    reader.getString( record.datablockIdx ),
+                    ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME );
+            }
+        }
+
+        renderable->mCustomParameter = record.customParameter;
+        renderable->setRenderQueueSubGroup( record.renderQueueSubGroup );
+        renderable->setPolygonModeOverrideable(
+            ( record.flags & SceneFormatBinary::SubObjectFlags::PolygonModeOverrideable ) != 0u );
+        renderable->setUseIdentityView(
+            ( record.flags & SceneFormatBinary::SubObjectFlags::UseIdentityView ) != 0u );
+        renderable->setUseIdentityProjection(
+            ( record.flags & SceneFormatBinary::SubObjectFlags::UseIdentityProjection ) != 0u );
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importSceneNodesBinary( const SceneFormatBinary::Reader &reader )
+    {
+        const uint32 numNodes = reader.getHeader().numNodes;
+        const SceneFormatBinary::NodeRecord *nodes = reader.getNodes();
+
+        mCreatedSceneNodes.resize( numNodes, 0 );
+
+        // Parents always come before their children (the Reader validated it),
+        // thus a single linear pass creates the whole hierarchy.
+        for( uint32 i = 0u; i < numNodes; ++i )
+        {
+            const SceneFormatBinary::NodeRecord &record = nodes[i];
+
+            const SceneMemoryMgrTypes sceneNodeType =
+                ( record.flags & SceneFormatBinary::NodeFlags::IsStatic ) ? SCENE_STATIC
+                                                                          : SCENE_DYNAMIC;
+
+            SceneNode *sceneNode = 0;
+            if( record.parentIdx != SceneFormatBinary::c_invalidIdx )
+                sceneNode = mCreatedSceneNodes[record.parentIdx]->createChildSceneNode( sceneNodeType );
+            else if( record.flags & SceneFormatBinary::NodeFlags::IsRootNode )
+                sceneNode = mRootNodes[sceneNodeType];
+            else if( mParentlessRootNodes[sceneNodeType] )
+                sceneNode = mParentlessRootNodes[sceneNodeType]->createChildSceneNode();
+            else
+                sceneNode = mSceneManager->createSceneNode( sceneNodeType );
+
+            sceneNode->setPosition( record.position[0], record.position[1], record.position[2] );
+            sceneNode->setOrientation( record.orientation[0], record.orientation[1],
+                                       record.orientation[2], record.orientation[3] );
+            sceneNode->setScale( record.scale[0], record.scale[1], record.scale[2] );
+            sceneNode->setInheritOrientation(
+                ( record.flags & SceneFormatBinary::NodeFlags::InheritOrientation ) != 0u );
+            sceneNode->setInheritScale( ( record.flags & SceneFormatBinary::NodeFlags::InheritScale ) !=
+                                        0u );
+            if( record.nameIdx != SceneFormatBinary::c_invalidIdx )
+                sceneNode->setName( reader.getString( record.nameIdx ) );
+
+            mCreatedSceneNodes[i] = sceneNode;
+        }
+
+        mImportStats.numSceneNodes += numNodes;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importItemsBinary( const SceneFormatBinary::Reader &reader )
+    {
+        const uint32 numItems = reader.getHeader().numItems;
+        const SceneFormatBinary::MeshObjectRecord *items = reader.getItems();
+
+        for( uint32 i = 0u; i < numItems; ++i )
+        {
+            const SceneFormatBinary::MeshObjectRecord &record = items[i];
+
+            const SceneMemoryMgrTypes sceneNodeType =
+                ( record.movableObject.flags & SceneFormatBinary::MovableObjectFlags::IsStatic )
+                    ? SCENE_STATIC
+                    : SCENE_DYNAMIC;
+
+            Item *item = mSceneManager->createItem( reader.getString( record.meshIdx ),
+                                                    "SceneFormatImporter", sceneNodeType );
+            importMovableObjectBinary( reader, record.movableObject, item );
+
+            const uint32 numSubItems =
+                std::min( static_cast<uint32>( item->getNumSubItems() ), record.numSubObjects );
+            for( uint32 j = 0u; j < numSubItems; ++j )
+                importRenderableBinary( reader, record.firstSubObject + j, item->getSubItem( j ) );
+        }
+
+        mImportStats.numItems += numItems;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importEntitiesBinary( const SceneFormatBinary::Reader &reader )
+    {
+        const uint32 numEntities = reader.getHeader().numEntities;
+        const SceneFormatBinary::MeshObjectRecord *entities = reader.getEntities();
+
+        for( uint32 i = 0u; i < numEntities; ++i )
+        {
+            const SceneFormatBinary::MeshObjectRecord &record = entities[i];
+
+            const SceneMemoryMgrTypes sceneNodeType =
+                ( record.movableObject.flags & SceneFormatBinary::MovableObjectFlags::IsStatic )
+                    ? SCENE_STATIC
+                    : SCENE_DYNAMIC;
+
+            v1::Entity *entity = mSceneManager->createEntity( reader.getString( record.meshIdx ),
+                                                              "SceneFormatImporter", sceneNodeType );
+            importMovableObjectBinary( reader, record.movableObject, entity );
+
+            const uint32 numSubEntities =
+                std::min( static_cast<uint32>( entity->getNumSubEntities() ), record.numSubObjects );
+            for( uint32 j = 0u; j < numSubEntities; ++j )
+                importRenderableBinary( reader, record.firstSubObject + j, entity->getSubEntity( j ) );
+        }
+
+        mImportStats.numEntities += numEntities;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importLightsBinary( const SceneFormatBinary::Reader &reader )
+    {
+        const uint32 numLights = reader.getHeader().numLights;
+        const SceneFormatBinary::LightRecord *lights = reader.getLights();
+
+        for( uint32 i = 0u; i < numLights; ++i )
+        {
+            const SceneFormatBinary::LightRecord &record = lights[i];
+
+            Light *light = mSceneManager->createLight();
+            importMovableObjectBinary( reader, record.movableObject, light );
+
+            light->setDiffuseColour( record.diffuse[0], record.diffuse[1], record.diffuse[2] );
+            light->setSpecularColour( record.specular[0], record.specular[1], record.specular[2] );
+            light->setPowerScale( record.powerScale );
+            light->setType( static_cast<Light::LightTypes>( record.type ) );
+            light->setAttenuation( record.attenuation[0], record.attenuation[1],
+                                   record.attenuation[2], record.attenuation[3] );
+            light->setSpotlightInnerAngle( Radian( record.spot[0] ) );
+            light->setSpotlightOuterAngle( Radian( record.spot[1] ) );
+            light->setSpotlightFalloff( record.spot[2] );
+            light->setSpotlightNearClipDistance( record.spot[3] );
+            if( record.shadowFarDistance != 0.0f )
+                light->setShadowFarDistance( record.shadowFarDistance );
+            light->setShadowNearClipDistance( record.shadowClipDistance[0] );
+            light->setShadowFarClipDistance( record.shadowClipDistance[1] );
+            light->setRectSize( Vector2( record.rectSize[0], record.rectSize[1] ) );
+            light->mTextureLightMaskIdx = record.textureLightMaskIdx;
+            light->setAffectParentNode(
+                ( record.flags & SceneFormatBinary::LightFlags::AffectParentNode ) != 0u );
+
+            if( light->getType() == Light::LT_VPL )
+                mVplLights.push_back( light );
+        }
+
+        mImportStats.numLights += numLights;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::_importSceneBinary( const String &filename, const void *data,
+                                                  size_t sizeBytes, uint32 importFlags )
+    {
+        Timer timer;
+        uint64 phaseStart = timer.getMicroseconds();
+
+        // Validates the whole file. Nothing else needs to be checked after this.
+        SceneFormatBinary::Reader reader( data, sizeBytes, filename );
+        const SceneFormatBinary::Header &header = reader.getHeader();
+
+        uint64 phaseEnd = timer.getMicroseconds();
+        mImportStats.parseTime += phaseEnd - phaseStart;
+
+        MovableObject::setDefaultVisibilityFlags( header.defaultVisibilityFlags );
+        MovableObject::setDefaultQueryFlags( header.defaultQueryFlags );
+        MovableObject::setDefaultLightMask( header.defaultLightMask );
+
+        // Set null pointers to valid root scene nodes. We'll restore the nullptrs at the end.
+        SceneNode *oldRootNodes[NUM_SCENE_MEMORY_MANAGER_TYPES];
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            oldRootNodes[i] = mRootNodes[i];
+            if( !mRootNodes[i] )
+                mRootNodes[i] = mSceneManager->getRootSceneNode( static_cast<SceneMemoryMgrTypes>( i ) );
+        }
+
+        if( mParallelMeshPreparation && mSceneManager->getNumWorkerThreads() > 1u )
+        {
+            phaseStart = phaseEnd;
+
+            set<String>::type meshNames;
+            set<String>::type meshNamesV1;
+            if( importFlags & SceneFlags::Items )
+            {
+                for( uint32 i = 0u; i < header.numItems; ++i )
+                    meshNames.insert( reader.getString( reader.getItems()[i].meshIdx ) );
+            }
+            if( importFlags & SceneFlags::Entities )
+            {
+                for( uint32 i = 0u; i < header.numEntities; ++i )
+                    meshNamesV1.insert( reader.getString( reader.getEntities()[i].meshIdx ) );
+            }
+            prepareMeshes( meshNames, meshNamesV1 );
+
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.meshPrepareTime += phaseEnd - phaseStart;
+        }
+
+        if( importFlags & SceneFlags::SceneNodes )
+        {
+            phaseStart = phaseEnd;
+            importSceneNodesBinary( reader );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.sceneNodesTime += phaseEnd - phaseStart;
+        }
+
+        if( importFlags & SceneFlags::Items )
+        {
+            phaseStart = phaseEnd;
+            importItemsBinary( reader );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.itemsTime += phaseEnd - phaseStart;
+        }
+
+        if( importFlags & SceneFlags::Entities )
+        {
+            phaseStart = phaseEnd;
+            importEntitiesBinary( reader );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.entitiesTime += phaseEnd - phaseStart;
+        }
+
+        if( importFlags & SceneFlags::Lights )
+        {
+            phaseStart = phaseEnd;
+            importLightsBinary( reader );
+            phaseEnd = timer.getMicroseconds();
+            mImportStats.lightsTime += phaseEnd - phaseStart;
+        }
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+            mRootNodes[i] = oldRootNodes[i];
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::importSceneBinary( const String &filename, const void *data,
+                                                 size_t sizeBytes, uint32 importFlags )
+    {
+        mImportStats = ImportStats();
+        mCreatedSceneNodes.clear();
+        mFilename = filename;
+
+        Timer timer;
+
+        _importSceneBinary( filename, data, sizeBytes, importFlags );
+
+        if( !( importFlags & SceneFlags::LightsVpl ) )
+        {
+            LightArray::const_iterator itLight = mVplLights.begin();
+            LightArray::const_iterator enLight = mVplLights.end();
+
+            while( itLight != enLight )
+            {
+                Light *vplLight = *itLight;
+                SceneNode *sceneNode = vplLight->getParentSceneNode();
+                mSceneManager->destroySceneNode( sceneNode );
+                mSceneManager->destroyLight( vplLight );
+                ++itLight;
+            }
+
+            mVplLights.clear();
+        }
+
+        mImportStats.totalTime = timer.getMicroseconds();
+        logImportStats();
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::convertSceneNodesToBinary( const rapidjson::Value &json,
+                                                         SceneFormatBinary::Writer &writer,
+                                                         vector<uint32>::type &outNodeRemap )
+    {
+        const uint32 numJsonNodes = static_cast<uint32>( json.Size() );
+
+        vector<SceneFormatBinary::NodeRecord>::type records;
+        records.resize( numJsonNodes );
+        // Non-object entries are skipped by importSceneNodes; mark them as invalid
+        vector<bool>::type validNodes;
+        validNodes.resize( numJsonNodes, false );
+
+        for( uint32 i = 0u; i < numJsonNodes; ++i )
+        {
+            const rapidjson::Value &sceneNodeValue = json[i];
+            if( !sceneNodeValue.IsObject() )
+                continue;
+
+            rapidjson::Value::ConstMemberIterator itTmp = sceneNodeValue.FindMember( "node" );
+            if( itTmp == sceneNodeValue.MemberEnd() || !itTmp->value.IsObject() )
+            {
+                OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND,
+                             "Object 'node' must be present in a scene_node. SceneNode: " +
+                                 StringConverter::toString( i ) + " File: " + mFilename,
+                             "SceneFormatImporter::convertSceneNodesToBinary" );
+            }
+
+            const rapidjson::Value &nodeValue = itTmp->value;
+
+            Vector3 position( Vector3::ZERO );
+            Quaternion orientation( Quaternion::IDENTITY );
+            Vector3 scale( Vector3::UNIT_SCALE );
+            bool inheritOrientation = true;
+            bool inheritScale = true;
+
+            SceneFormatBinary::NodeRecord &record = records[i];
+            memset( &record, 0, sizeof( record ) );
+            record.parentIdx = SceneFormatBinary::c_invalidIdx;
+            record.nameIdx = SceneFormatBinary::c_invalidIdx;
+
+            itTmp = nodeValue.FindMember( "position" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsArray() )
+                position = decodeVector3Array( itTmp->value );
+            itTmp = nodeValue.FindMember( "rotation" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsArray() )
+                orientation = decodeQuaternionArray( itTmp->value );
+            itTmp = nodeValue.FindMember( "scale" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsArray() )
+                scale = decodeVector3Array( itTmp->value );
+            itTmp = nodeValue.FindMember( "inherit_orientation" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsBool() )
+                inheritOrientation = itTmp->value.GetBool();
+            itTmp = nodeValue.FindMember( "inherit_scale" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsBool() )
+                inheritScale = itTmp->value.GetBool();
+            itTmp = nodeValue.FindMember( "is_static" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsBool() && itTmp->value.GetBool() )
+                record.flags |= SceneFormatBinary::NodeFlags::IsStatic;
+            itTmp = nodeValue.FindMember( "name" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsString() )
+                record.nameIdx = writer.addString( itTmp->value.GetString() );
+
+            itTmp = nodeValue.FindMember( "parent_id" );
+            if( itTmp != nodeValue.MemberEnd() && itTmp->value.IsUint() &&
+                itTmp->value.GetUint() != i )
+            {
+                record.parentIdx = itTmp->value.GetUint();
+            }
+
+            itTmp = sceneNodeValue.FindMember( "is_root_node" );
+            if( itTmp != sceneNodeValue.MemberEnd() && itTmp->value.IsBool() &&
+                itTmp->value.GetBool() )
+            {
+                record.flags |= SceneFormatBinary::NodeFlags::IsRootNode;
+            }
+
+            if( inheritOrientation )
+                record.flags |= SceneFormatBinary::NodeFlags::InheritOrientation;
+            if( inheritScale )
+                record.flags |= SceneFormatBinary::NodeFlags::InheritScale;
+
+            record.position[0] = static_cast<float>( position.x );
+            record.position[1] = static_cast<float>( position.y );
+            record.position[2] = static_cast<float>( position.z );
+            record.orientation[0] = static_cast<float>( orientation.w );
+            record.orientation[1] = static_cast<float>( orientation.x );
+            record.orientation[2] = static_cast<float>( orientation.y );
+            record.orientation[3] = static_cast<float>( orientation.z );
+            record.scale[0] = static_cast<float>( scale.x );
+            record.scale[1] = static_cast<float>( scale.y );
+            record.scale[2] = static_cast<float>( scale.z );
+
+            validNodes[i] = true;
+        }
+
+        // Build the list of children of each node (CSR layout)
+        vector<uint32>::type childrenStart;
+        vector<uint32>::type children;
+        childrenStart.resize( numJsonNodes + 1u, 0u );
+        for( uint32 i = 0u; i < numJsonNodes; ++i )
+        {
+            if( !validNodes[i] || records[i].parentIdx == SceneFormatBinary::c_invalidIdx )
+                continue;
+
+            const uint32 parentIdx = records[i].parentIdx;
+            if( parentIdx >= numJsonNodes || !validNodes[parentIdx] )
+            {
+                OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND,
+                             "Node " + StringConverter::toString( i ) + " is child of " +
+                                 StringConverter::toString( parentIdx ) +
+                                 " but we could not find it. This file is malformed.",
+                             "SceneFormatImporter::convertSceneNodesToBinary" );
+            }
+            ++childrenStart[parentIdx + 1u];
+        }
+        for( uint32 i = 0u; i < numJsonNodes; ++i )
+            childrenStart[i + 1u] += childrenStart[i];
+
+        children.resize( childrenStart.back() );
+        {
+            vector<uint32>::type childrenCursor( childrenStart.begin(), childrenStart.end() - 1 );
+            for( uint32 i = 0u; i < numJsonNodes; ++i )
+            {
+                if( validNodes[i] && records[i].parentIdx != SceneFormatBinary::c_invalidIdx )
+                    children[childrenCursor[records[i].parentIdx]++] = i;
+            }
+        }
+
+        // Breadth first from all parentless nodes, same order as SceneFormatExporter
+        vector<uint32>::type order;
+        order.reserve( numJsonNodes );
+        for( uint32 i = 0u; i < numJsonNodes; ++i )
+        {
+            if( validNodes[i] && records[i].parentIdx == SceneFormatBinary::c_invalidIdx )
+                order.push_back( i );
+        }
+        for( size_t cursor = 0u; cursor < order.size(); ++cursor )
+        {
+            const uint32 nodeIdx = order[cursor];
+            order.insert( order.end(), children.begin() + childrenStart[nodeIdx],
+                          children.begin() + childrenStart[nodeIdx + 1u] );
+        }
+
+        outNodeRemap.clear();
+        outNodeRemap.resize( numJsonNodes, SceneFormatBinary::c_invalidIdx );
+        for( size_t i = 0u; i < order.size(); ++i )
+            outNodeRemap[order[i]] = static_cast<uint32>( i );
+
+        for( uint32 i = 0u; i < numJsonNodes; ++i )
+        {
+            if( validNodes[i] && outNodeRemap[i] == SceneFormatBinary::c_invalidIdx )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Node " + StringConverter::toString( i ) +
+                                 " is part of a cycle in the hierarchy. This file is malformed.",
+                             "SceneFormatImporter::convertSceneNodesToBinary" );
+            }
+        }
+
+        writer.mNodes.reserve( order.size() );
+        for( size_t i = 0u; i < order.size(); ++i )
+        {
+            SceneFormatBinary::NodeRecord record = records[order[i]];
+            if( record.parentIdx != SceneFormatBinary::c_invalidIdx )
+                record.parentIdx = outNodeRemap[record.parentIdx];
+            writer.mNodes.push_back( record );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::convertMovableObjectToBinary(
+        const rapidjson::Value &movableObjectValue, SceneFormatBinary::MovableObjectRecord &outRecord,
+        SceneFormatBinary::Writer &writer, const vector<uint32>::type &nodeRemap )
+    {
+        memset( &outRecord, 0, sizeof( outRecord ) );
+        outRecord.nameIdx = SceneFormatBinary::c_invalidIdx;
+        outRecord.parentNodeIdx = SceneFormatBinary::c_invalidIdx;
+
+        if( !movableObjectValue.IsObject() )
+            return;
+
+        rapidjson::Value::ConstMemberIterator tmpIt;
+
+        tmpIt = movableObjectValue.FindMember( "name" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsString() )
+            outRecord.nameIdx = writer.addString( tmpIt->value.GetString() );
+
+        tmpIt = movableObjectValue.FindMember( "parent_node_id" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsUint() &&
+            tmpIt->value.GetUint() < nodeRemap.size() )
+        {
+            outRecord.parentNodeIdx = nodeRemap[tmpIt->value.GetUint()];
+        }
+
+        tmpIt = movableObjectValue.FindMember( "render_queue" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsUint() )
+        {
+            outRecord.renderQueue = static_cast<uint8>( tmpIt->value.GetUint() );
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::HasRenderQueue;
+        }
+
+        tmpIt = movableObjectValue.FindMember( "local_aabb" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsArray() )
+        {
+            const Aabb localAabb = decodeAabbArray( tmpIt->value, Aabb::BOX_ZERO );
+            outRecord.localAabbCenter[0] = static_cast<float>( localAabb.mCenter.x );
+            outRecord.localAabbCenter[1] = static_cast<float>( localAabb.mCenter.y );
+            outRecord.localAabbCenter[2] = static_cast<float>( localAabb.mCenter.z );
+            outRecord.localAabbHalfSize[0] = static_cast<float>( localAabb.mHalfSize.x );
+            outRecord.localAabbHalfSize[1] = static_cast<float>( localAabb.mHalfSize.y );
+            outRecord.localAabbHalfSize[2] = static_cast<float>( localAabb.mHalfSize.z );
+            outRecord.localRadius = static_cast<float>( localAabb.getRadius() );
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::HasLocalAabb;
+
+            tmpIt = movableObjectValue.FindMember( "local_radius" );
+            if( tmpIt != movableObjectValue.MemberEnd() && isFloat( tmpIt->value ) )
+                outRecord.localRadius = decodeFloat( tmpIt->value );
+        }
+
+        tmpIt = movableObjectValue.FindMember( "rendering_distance" );
+        if( tmpIt != movableObjectValue.MemberEnd() && isFloat( tmpIt->value ) )
+        {
+            outRecord.renderingDistance = decodeFloat( tmpIt->value );
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::HasRenderingDistance;
+        }
+
+        tmpIt = movableObjectValue.FindMember( "is_static" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsBool() && tmpIt->value.GetBool() )
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::IsStatic;
+
+        tmpIt = movableObjectValue.FindMember( "visibility_flags" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsUint() )
+        {
+            outRecord.visibilityFlags = tmpIt->value.GetUint();
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::HasVisibilityFlags;
+        }
+        tmpIt = movableObjectValue.FindMember( "query_flags" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsUint() )
+        {
+            outRecord.queryFlags = tmpIt->value.GetUint();
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::HasQueryFlags;
+        }
+        tmpIt = movableObjectValue.FindMember( "light_mask" );
+        if( tmpIt != movableObjectValue.MemberEnd() && tmpIt->value.IsUint() )
+        {
+            outRecord.lightMask = tmpIt->value.GetUint();
+            outRecord.flags |= SceneFormatBinary::MovableObjectFlags::HasLightMask;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::convertRenderableToBinary( const rapidjson::Value &renderableValue,
+                                                         SceneFormatBinary::SubObjectRecord &outRecord,
+                                                         SceneFormatBinary::Writer &writer )
+    {
+        memset( &outRecord, 0, sizeof( outRecord ) );
+        outRecord.datablockIdx = SceneFormatBinary::c_invalidIdx;
+        outRecord.firstCustomParam = static_cast<uint32>( writer.mCustomParams.size() );
+        // Renderable's default
+        outRecord.flags = SceneFormatBinary::SubObjectFlags::PolygonModeOverrideable;
+
+        if( !renderableValue.IsObject() )
+            return;
+
+        rapidjson::Value::ConstMemberIterator tmpIt;
+
+        tmpIt = renderableValue.FindMember( "custom_parameters" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsObject() )
+        {
+            rapidjson::Value::ConstMemberIterator itor = tmpIt->value.MemberBegin();
+            rapidjson::Value::ConstMemberIterator end = tmpIt->value.MemberEnd();
+
+            while( itor != end )
+            {
+                // The exporter writes the index as a string key
+                if( itor->name.IsString() && itor->value.IsArray() )
+                {
+                    const Vector4 value = decodeVector4Array( itor->value );
+                    SceneFormatBinary::CustomParamRecord customParam;
+                    customParam.idx = StringConverter::parseUnsignedInt( itor->name.GetString() );
+                    customParam.value[0] = static_cast<float>( value.x );
+                    customParam.value[1] = static_cast<float>( value.y );
+                    customParam.value[2] = static_cast<float>( value.z );
+                    customParam.value[3] = static_cast<float>( value.w );
+                    writer.mCustomParams.push_back( customParam );
+                    ++outRecord.numCustomParams;
+                }
+
+                ++itor;
+            }
+        }
+
+        tmpIt = renderableValue.FindMember( "is_v1_material" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsBool() && tmpIt->value.GetBool() )
+            outRecord.flags |= SceneFormatBinary::SubObjectFlags::IsV1Material;
+
+        tmpIt = renderableValue.FindMember( "datablock" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsString() )
+            outRecord.datablockIdx = writer.addString( tmpIt->value.GetString() );
+
+        tmpIt = renderableValue.FindMember( "custom_parameter" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsUint() )
+            outRecord.customParameter = static_cast<uint8>( tmpIt->value.GetUint() );
+
+        tmpIt = renderableValue.FindMember( "render_queue_sub_group" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsUint() )
+            outRecord.renderQueueSubGroup = static_cast<uint8>( tmpIt->value.GetUint() );
+
+        tmpIt = renderableValue.FindMember( "polygon_mode_overrideable" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsBool() && !tmpIt->value.GetBool() )
+            outRecord.flags &= ~SceneFormatBinary::SubObjectFlags::PolygonModeOverrideable;
+
+        tmpIt = renderableValue.FindMember( "use_identity_view" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsBool() && tmpIt->value.GetBool() )
+            outRecord.flags |= SceneFormatBinary::SubObjectFlags::UseIdentityView;
+
+        tmpIt = renderableValue.FindMember( "use_identity_projection" );
+        if( tmpIt != renderableValue.MemberEnd() && tmpIt->value.IsBool() && tmpIt->value.GetBool() )
+            outRecord.flags |= SceneFormatBinary::SubObjectFlags::UseIdentityProjection;
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::convertMeshObjectsToBinary(
+        const rapidjson::Value &json, const char *subObjectsKey,
+        vector<SceneFormatBinary::MeshObjectRecord>::type &outRecords,
+        SceneFormatBinary::Writer &writer, const vector<uint32>::type &nodeRemap )
+    {
+        rapidjson::Value::ConstValueIterator itor = json.Begin();
+        rapidjson::Value::ConstValueIterator endt = json.End();
+
+        while( itor != endt )
+        {
+            if( itor->IsObject() )
+            {
+                const rapidjson::Value &meshObjectValue = *itor;
+                rapidjson::Value::ConstMemberIterator tmpIt;
+
+                SceneFormatBinary::MeshObjectRecord record;
+
+                const rapidjson::Value nullValue;
+                tmpIt = meshObjectValue.FindMember( "movable_object" );
+                convertMovableObjectToBinary(
+                    tmpIt != meshObjectValue.MemberEnd() ? tmpIt->value : nullValue,
+                    record.movableObject, writer, nodeRemap );
+
+                tmpIt = meshObjectValue.FindMember( "mesh" );
+                if( tmpIt == meshObjectValue.MemberEnd() || !tmpIt->value.IsString() )
+                {
+                    OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND,
+                                 "Object without 'mesh' found in file " + mFilename,
+                                 "SceneFormatImporter::convertMeshObjectsToBinary" );
+                }
+                record.meshIdx = writer.addString( tmpIt->value.GetString() );
+
+                record.firstSubObject = static_cast<uint32>( writer.mSubObjects.size() );
+                record.numSubObjects = 0u;
+
+                tmpIt = meshObjectValue.FindMember( subObjectsKey );
+                if( tmpIt != meshObjectValue.MemberEnd() && tmpIt->value.IsArray() )
+                {
+                    const rapidjson::Value &subObjectsArray = tmpIt->value;
+                    const rapidjson::SizeType numSubObjects = subObjectsArray.Size();
+                    for( rapidjson::SizeType i = 0; i < numSubObjects; ++i )
+                    {
+                        const rapidjson::Value &subObjectValue = subObjectsArray[i];
+
+                        const rapidjson::Value *renderableValue = &nullValue;
+                        if( subObjectValue.IsObject() )
+                        {
+                            tmpIt = subObjectValue.FindMember( "renderable" );
+                            if( tmpIt != subObjectValue.MemberEnd() )
+                                renderableValue = &tmpIt->value;
+                        }
+
+                        SceneFormatBinary::SubObjectRecord subObject;
+                        convertRenderableToBinary( *renderableValue, subObject, writer );
+                        writer.mSubObjects.push_back( subObject );
+                        ++record.numSubObjects;
+                    }
+                }
+
+                outRecords.push_back( record );
+            }
+
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::convertLightsToBinary( const rapidjson::Value &json,
+                                                     SceneFormatBinary::Writer &writer,
+                                                     const vector<uint32>::type &nodeRemap )
+    {
+        rapidjson::Value::ConstValueIterator itor = json.Begin();
+        rapidjson::Value::ConstValueIterator endt = json.End();
+
+        while( itor != endt )
+        {
+            if( itor->IsObject() )
+            {
+                const rapidjson::Value &lightValue = *itor;
+                rapidjson::Value::ConstMemberIterator tmpIt;
+
+                SceneFormatBinary::LightRecord record;
+                memset( &record, 0, sizeof( record ) );
+
+                const rapidjson::Value nullValue;
+                tmpIt = lightValue.FindMember( "movable_object" );
+                convertMovableObjectToBinary(
+                    tmpIt != lightValue.MemberEnd() ? tmpIt->value : nullValue,
+                    record.movableObject, writer, nodeRemap );
+
+                // Same defaults as Light's constructor
+                ColourValue diffuse( ColourValue::White );
+                ColourValue specular( ColourValue::White );
+                Vector4 attenuation( 23.0f, 0.5f, 0.0f, 0.5f );
+                Vector4 spot( Degree( 30.0f ).valueRadians(), Degree( 40.0f ).valueRadians(), 1.0f,
+                              0.0f );
+                Vector2 shadowClipDist( -1.0f, -1.0f );
+                Vector2 rectSize( 1.0f, 1.0f );
+                Light::LightTypes lightType = Light::LT_POINT;
+                float powerScale = 1.0f;
+
+                tmpIt = lightValue.FindMember( "diffuse" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsArray() )
+                    diffuse = decodeColourValueArray( tmpIt->value );
+                tmpIt = lightValue.FindMember( "specular" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsArray() )
+                    specular = decodeColourValueArray( tmpIt->value );
+                tmpIt = lightValue.FindMember( "power" );
+                if( tmpIt != lightValue.MemberEnd() && isFloat( tmpIt->value ) )
+                    powerScale = decodeFloat( tmpIt->value );
+                tmpIt = lightValue.FindMember( "type" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsString() )
+                    lightType = parseLightType( tmpIt->value.GetString() );
+                tmpIt = lightValue.FindMember( "attenuation" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsArray() )
+                    attenuation = decodeVector4Array( tmpIt->value );
+                tmpIt = lightValue.FindMember( "spot" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsArray() )
+                    spot = decodeVector4Array( tmpIt->value );
+                tmpIt = lightValue.FindMember( "affect_parent_node" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsBool() && tmpIt->value.GetBool() )
+                    record.flags |= SceneFormatBinary::LightFlags::AffectParentNode;
+                tmpIt = lightValue.FindMember( "shadow_far_dist" );
+                if( tmpIt != lightValue.MemberEnd() && isFloat( tmpIt->value ) )
+                    record.shadowFarDistance = decodeFloat( tmpIt->value );
+                tmpIt = lightValue.FindMember( "shadow_clip_dist" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsArray() )
+                    shadowClipDist = decodeVector2Array( tmpIt->value );
+                tmpIt = lightValue.FindMember( "rect_size" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsArray() )
+                    rectSize = decodeVector2Array( tmpIt->value );
+                record.textureLightMaskIdx = std::numeric_limits<uint16>::max();
+                tmpIt = lightValue.FindMember( "texture_light_mask_idx" );
+                if( tmpIt != lightValue.MemberEnd() && tmpIt->value.IsUint() )
+                    record.textureLightMaskIdx = static_cast<uint16>( tmpIt->value.GetUint() );
+
+                record.diffuse[0] = diffuse.r;
+                record.diffuse[1] = diffuse.g;
+                record.diffuse[2] = diffuse.b;
+                record.specular[0] = specular.r;
+                record.specular[1] = specular.g;
+                record.specular[2] = specular.b;
+                record.powerScale = powerScale;
+                for( size_t i = 0u; i < 4u; ++i )
+                {
+                    record.attenuation[i] = static_cast<float>( attenuation[i] );
+                    record.spot[i] = static_cast<float>( spot[i] );
+                }
+                record.shadowClipDistance[0] = static_cast<float>( shadowClipDist.x );
+                record.shadowClipDistance[1] = static_cast<float>( shadowClipDist.y );
+                record.rectSize[0] = static_cast<float>( rectSize.x );
+                record.rectSize[1] = static_cast<float>( rectSize.y );
+                record.type = static_cast<uint8>( lightType );
+
+                writer.mLights.push_back( record );
+            }
+
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::convertJsonToBinary( const String &filename, const char *jsonString,
+                                                   vector<uint8>::type &outBinary )
+    {
+        rapidjson::Document d;
+        d.Parse( jsonString );
+
+        if( d.HasParseError() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "Invalid JSON string in file " + filename + " at line " +
+                             StringConverter::toString( d.GetErrorOffset() ) +
+                             " Reason: " + rapidjson::GetParseError_En( d.GetParseError() ),
+                         "SceneFormatImporter::convertJsonToBinary" );
+        }
+
+        mFilename = filename;
+        mUseBinaryFloatingPoint = true;  // The default when setting is not present
+
+        SceneFormatBinary::Writer writer;
+        writer.mDefaultVisibilityFlags = MovableObject::getDefaultVisibilityFlags();
+        writer.mDefaultQueryFlags = MovableObject::getDefaultQueryFlags();
+        writer.mDefaultLightMask = MovableObject::getDefaultLightMask();
+
+        rapidjson::Value::ConstMemberIterator itor;
+
+        itor = d.FindMember( "use_binary_floating_point" );
+        if( itor != d.MemberEnd() && itor->value.IsBool() )
+            mUseBinaryFloatingPoint = itor->value.GetBool();
+
+        itor = d.FindMember( "MovableObject_msDefaultVisibilityFlags" );
+        if( itor != d.MemberEnd() && itor->value.IsUint() )
+            writer.mDefaultVisibilityFlags = itor->value.GetUint();
+        itor = d.FindMember( "MovableObject_msDefaultQueryFlags" );
+        if( itor != d.MemberEnd() && itor->value.IsUint() )
+            writer.mDefaultQueryFlags = itor->value.GetUint();
+        itor = d.FindMember( "MovableObject_msDefaultLightMask" );
+        if( itor != d.MemberEnd() && itor->value.IsUint() )
+            writer.mDefaultLightMask = itor->value.GetUint();
+
+        vector<uint32>::type nodeRemap;
+
+        itor = d.FindMember( "scene_nodes" );
+        if( itor != d.MemberEnd() && itor->value.IsArray() )
+            convertSceneNodesToBinary( itor->value, writer, nodeRemap );
+
+        itor = d.FindMember( "items" );
+        if( itor != d.MemberEnd() && itor->value.IsArray() )
+            convertMeshObjectsToBinary( itor->value, "sub_items", writer.mItems, writer, nodeRemap );
+
+        itor = d.FindMember( "entities" );
+        if( itor != d.MemberEnd() && itor->value.IsArray() )
+        {
+            convertMeshObjectsToBinary( itor->value, "sub_entities", writer.mEntities, writer,
+                                        nodeRemap );
+        }
+
+        itor = d.FindMember( "lights" );
+        if( itor != d.MemberEnd() && itor->value.IsArray() )
+            convertLightsToBinary( itor->value, writer, nodeRemap );
+
+        writer.serialize( outBinary );
+    }
     //-----------------------------------------------------------------------------------
     void SceneFormatImporter::setRootNodes( SceneNode *dynamicRoot, SceneNode *staticRoot )
     {
@@ -1506,11 +2659,22 @@ namespace Ogre
         mSceneComponentTransform = transform;
     }
     //-----------------------------------------------------------------------------------
+    void SceneFormatImporter::setParallelMeshPreparation( bool bParallel )
+    {
+        mParallelMeshPreparation = bParallel;
+    }
+    //-----------------------------------------------------------------------------------
     void SceneFormatImporter::importScene( const String &filename, const char *jsonString,
                                            uint32 importFlags )
     {
+        mImportStats = ImportStats();
+        // Node indices are local to each file
+        mCreatedSceneNodes.clear();
+
+        Timer timer;
         rapidjson::Document d;
         d.Parse( jsonString );
+        mImportStats.parseTime = timer.getMicroseconds();
 
         if( d.HasParseError() )
         {
@@ -1521,10 +2685,18 @@ namespace Ogre
         }
 
         importScene( filename, d, importFlags );
+
+        mImportStats.totalTime = timer.getMicroseconds();
+        logImportStats();
     }
     //-----------------------------------------------------------------------------------
     void SceneFormatImporter::importSceneFromFile( const String &folderPath, uint32 importFlags )
     {
+        mImportStats = ImportStats();
+        mCreatedSceneNodes.clear();
+
+        Timer timer;
+
         ResourceGroupManager &resourceGroupManager = ResourceGroupManager::getSingleton();
         resourceGroupManager.addResourceLocation( folderPath, "FileSystem", "SceneFormatImporter" );
         resourceGroupManager.addResourceLocation( folderPath + "/v2/", "FileSystem",
@@ -1561,8 +2733,12 @@ namespace Ogre
             // Add null terminator just in case (to prevent bad input)
             fileData.back() = '\0';
 
+            const uint64 parseStart = timer.getMicroseconds();
+
+            // Parse in place: strings point directly into fileData instead of being
+            // copied. fileData must outlive d.
             rapidjson::Document d;
-            d.Parse( &fileData[0] );
+            d.ParseInsitu( &fileData[0] );
 
             if( d.HasParseError() )
             {
@@ -1579,6 +2755,14 @@ namespace Ogre
             if( itor != d.MemberEnd() && itor->value.IsBool() )
                 mUsingOitd = itor->value.GetBool();
 
+            bool binarySceneObjects = false;
+            itor = d.FindMember( "binary_scene_objects" );
+            if( itor != d.MemberEnd() && itor->value.IsBool() )
+                binarySceneObjects = itor->value.GetBool();
+
+            const uint64 resourceGroupStart = timer.getMicroseconds();
+            mImportStats.parseTime = resourceGroupStart - parseStart;
+
             HlmsManager *hlmsManager = mRoot->getHlmsManager();
             if( mUsingOitd )
                 hlmsManager->mAdditionalTextureExtensionsPerGroup["SceneFormatImporter"] = ".oitd";
@@ -1586,6 +2770,37 @@ namespace Ogre
             if( mUsingOitd )
                 hlmsManager->mAdditionalTextureExtensionsPerGroup.erase( "SceneFormatImporter" );
 
+            mImportStats.resourceGroupTime = timer.getMicroseconds() - resourceGroupStart;
+
+            if( binarySceneObjects )
+            {
+                // Must be imported first: decals in scene.json may reference scene nodes.
+                // Map the file so the Reader points straight into the page cache.
+                DataStreamPtr binStream;
+                MappedFileDataStream *mappedStream =
+                    MappedFileDataStream::mapFile( "scene.bin", folderPath + "/scene.bin" );
+                if( mappedStream )
+                    binStream = DataStreamPtr( mappedStream );
+                else
+                    binStream = resourceGroupManager.openResource( "scene.bin", "SceneFormatImporter" );
+
+                const size_t binSize = binStream->size();
+                const uint8 *binData = binStream->getContiguousPtr();
+                vector<uint8>::type binDataCopy;
+                if( !binData && binSize > 0u )
+                {
+                    binDataCopy.resize( binSize );
+                    binStream->read( &binDataCopy[0], binSize );
+                    binData = &binDataCopy[0];
+                }
+
+                if( binSize > 0u )
+                    _importSceneBinary( binStream->getName(), binData, binSize, importFlags );
+
+                importFlags &= static_cast<uint32>( ~( SceneFlags::SceneNodes | SceneFlags::Items |
+                                                       SceneFlags::Entities | SceneFlags::Lights ) );
+            }
+
             importScene( stream->getName(), d, importFlags );
 
             resourceGroupManager.removeResourceLocation( folderPath + "/textures/",
@@ -1594,6 +2809,9 @@ namespace Ogre
             resourceGroupManager.removeResourceLocation( folderPath + "/v1/", "SceneFormatImporter" );
             resourceGroupManager.removeResourceLocation( folderPath, "SceneFormatImporter" );
         }
+
+        mImportStats.totalTime = timer.getMicroseconds();
+        logImportStats();
     }
     //-----------------------------------------------------------------------------------
     void SceneFormatImporter::getInstantRadiosity( bool releaseOwnership,
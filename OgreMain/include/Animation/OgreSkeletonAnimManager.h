@@ -65,6 +65,10 @@ namespace Ogre
         */
         FastArray<size_t> threadStarts;
 
+        /// Assigned to the next created instance, so that throttled instances
+        /// (@see SkeletonInstance::setUpdateInterval) get sampled in different frames.
+        uint8 nextUpdateFrameOffset;
+
         BySkeletonDef( const SkeletonDef *skeletonDef, size_t threadCount );
 
         void initializeMemoryManager();
@@ -107,6 +111,12 @@ namespace Ogre
         typedef list<BySkeletonDef>::type BySkeletonDefList;
         BySkeletonDefList                 bySkeletonDefs;
 
+        /// Incremented every time animations are updated. Used for throttling.
+        /// @see SkeletonInstance::_updateThrottled
+        uint32 frameIdx;
+
+        SkeletonAnimManager();
+
         /// Creates an instance of a skeleton based on the given definition.
         SkeletonInstance *createSkeletonInstance( const SkeletonDef *skeletonDef,
                                                   size_t             numWorkerThreads );
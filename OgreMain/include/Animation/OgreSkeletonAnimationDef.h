@@ -62,6 +62,10 @@ namespace Ogre
 
         KfTransformArrayMemoryManager *mKfTransformMemoryManager;
 
+        /// SIMD aligned memory holding the data of all tracks after compressTracks
+        uint8 *mCompressedTrackData;
+        size_t mCompressedTrackDataSize;
+
         typedef vector<Real>::type              TimestampVec;
         typedef map<size_t, TimestampVec>::type TimestampsPerBlock;
 
@@ -96,10 +100,31 @@ namespace Ogre
         void          _setSkeletonDef( const SkeletonDef *skeletonDef ) { mSkeletonDef = skeletonDef; }
 
         Real getNumFrames() const { return mNumFrames; }
+        const SkeletonTrackVec &getTracks() const { return mTracks; }
         Real getOriginalFrameRate() const { return mOriginalFrameRate; }
 
         void build( const v1::Skeleton *skeleton, const v1::Animation *animation, Real frameRate );
 
+        /** Converts all tracks to a compressed format (quantised orientations; positions and
+            scales quantised to the range of each track; constant channels stored only once)
+            and releases the uncompressed keyframes. This typically reduces keyframe memory
+            to less than half, trading a small amount of precision for less memory bandwidth
+            when animating many SkeletonInstances.
+        @remarks
+            Does nothing if already compressed.
+            Existing SkeletonAnimations keep working. However this function must not be called
+            while animations are being updated (i.e. during SceneManager::updateAllAnimations)
+        @param constantThreshold
+            A channel (position, orientation or scale) whose components don't vary more than
+            this value across all keyframes is considered constant.
+        */
+        void compressTracks( Real constantThreshold = Real( 1e-5 ) );
+
+        bool isCompressed() const { return mCompressedTrackData != 0; }
+
+        /// Returns the amount of bytes used by the keyframes of all tracks.
+        size_t getKeyFrameMemoryUsage() const;
+
         /// Dumps all the tracks in CSV format to the output string argument.
         /// Mostly for debugging purposes. (also easy example to show how to
         /// enumerate all the tracks and get the bones back from its block index)
@@ -156,6 +156,10 @@ namespace Ogre
         }
         void getBonesPerDepth( vector<size_t>::type &out ) const;
 
+        /// Compresses the keyframes of all animations.
+        /// @see SkeletonAnimationDef::compressTracks
+        void compressAnimations( Real constantThreshold = Real( 1e-5 ) );
+
         /** Returns the total number of bone blocks to reach the given level. i.e On SSE2,
             If the skeleton has 1 root node, 3 children, and 5 children of children;
             then the total number of blocks is 1 + 1 + 2 = 4
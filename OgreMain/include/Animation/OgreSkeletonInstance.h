@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 #include "Animation/OgreBone.h"
 
+#include <atomic>
+
 namespace Ogre
 {
 #if defined( __GNUC__ ) && !defined( __clang__ )
@@ -44,6 +46,24 @@ namespace Ogre
     typedef vector<SkeletonAnimation>::type   SkeletonAnimationVec;
     typedef vector<SkeletonAnimation *>::type ActiveAnimationsVec;
 
+    /// @see SkeletonInstance::setAnimationLodTiers
+    struct AnimationLodTier
+    {
+        /// LOD value from which this tier is used, in the same representation
+        /// as the LodStrategy's values (@see LodStrategy::transformUserValue)
+        Real lodValue;
+        /// @see SkeletonInstance::setUpdateInterval
+        uint8 updateInterval;
+
+        AnimationLodTier( Real _lodValue, uint8 _updateInterval ) :
+            lodValue( _lodValue ),
+            updateInterval( _updateInterval )
+        {
+        }
+    };
+
+    typedef FastArray<AnimationLodTier> AnimationLodTierArray;
+
     /** \addtogroup Core
      *  @{
      */
@@ -116,6 +136,54 @@ namespace Ogre
 
         uint16 mRefCount;
 
+        /// @see setUpdateInterval
+        uint8 mUpdateInterval;
+        /// Staggers the frames in which throttled instances get updated.
+        uint8 mUpdateFrameOffset;
+        bool  mInterpolateSkippedFrames;
+        /// True if mLodPoses contains a valid pair of sampled poses.
+        bool  mLodPosesValid;
+        /// LOD value used to pick the tier. Latched from mPendingLodValue on every update.
+        Real  mLodValue;
+        /** Most detailed (i.e. smallest) LOD value calculated since the last update.
+            std::numeric_limits<Real>::max() if none.
+        @remarks
+            LODs are calculated by several threads, for every camera and shadow pass;
+            and Items sharing us may be processed by different threads. Thus it is
+            only written by an atomic min (see _setLodValue).
+        */
+        std::atomic<Real> mPendingLodValue;
+
+        AnimationLodTierArray const *mAnimationLodTiers;
+
+        /** When interpolating skipped frames; holds the previously sampled pose followed by
+            the last sampled pose. Each has one KfTransform per bone block.
+        */
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> mLodPoses;
+
+        /// @see setSharedPoseSource
+        SkeletonInstance            *mSharedPoseSource;
+        FastArray<SkeletonInstance *> mSharedPoseFollowers;
+        /** Double buffered copy of our pose for mSharedPoseFollowers, indexed by frame parity.
+            Followers read the buffer we're not writing to, thus they're one frame late.
+        */
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> mSharedPoses;
+
+        /** Copies the local transforms of all bones to the given pose.
+        @param replicateSharedBlocks
+            When true, the bones in SIMD blocks shared with other instances are repeated
+            to all slots in the same pattern used by SkeletonTrack::_bakeUnusedSlots, so
+            that the pose can be applied to any instance regardless of its slot.
+        */
+        void savePose( KfTransform *RESTRICT_ALIAS outPose, bool replicateSharedBlocks ) const;
+        /// Sets the local transforms of all non-manual bones to
+        /// the interpolation of the two poses in mLodPoses.
+        void blendLodPoses( Real weight );
+        /// Sets the local transforms of all non-manual bones to the given pose.
+        void applyPose( const KfTransform *RESTRICT_ALIAS pose );
+        /// Updates the pose following our own throttling settings.
+        void updateOwnPose( uint32 frameIdx );
+
     public:
         SkeletonInstance( const SkeletonDef *skeletonDef, BoneMemoryManager *boneMemoryManager );
         ~SkeletonInstance();
@@ -124,6 +192,82 @@ namespace Ogre
 
         void update();
 
+        /** Same as update, but follows the throttling settings (@see setUpdateInterval and
+            @see setAnimationLodTiers). Called by SceneManager::updateAllAnimations.
+        @param frameIdx
+            Counter that increments once per frame.
+        */
+        void _updateThrottled( uint32 frameIdx );
+
+        /** Sets how often the animations of this instance are sampled. Bones' derived
+            transforms are still updated every frame (i.e. if the parent node moves).
+        @param updateInterval
+            1 to sample every frame (default).
+            N to sample every Nth frame. @see setInterpolateSkippedFrames.
+            0 to freeze the current pose.
+        */
+        void  setUpdateInterval( uint8 updateInterval );
+        uint8 getUpdateInterval() const { return mUpdateInterval; }
+
+        /** Selects the update interval automatically based on the LOD value calculated by
+            the LodStrategy (e.g. distance or pixel count) for the Item using this instance,
+            overriding setUpdateInterval.
+        @remarks
+            LOD values are calculated by the compositor scene passes, thus the tier change
+            is seen with one frame of latency.
+            When the instance is shared by several Items (see Item::useSkeletonInstanceFrom)
+            or seen by several passes in the same frame, the most detailed value is used.
+        @param tiers
+            Must be sorted by lodValue in ascending order (i.e. highest detail first).
+            The pointer is not owned by us and is meant to be shared by many instances.
+            Must remain valid while set. Null to disable.
+        */
+        void setAnimationLodTiers( const AnimationLodTierArray *tiers );
+        const AnimationLodTierArray *getAnimationLodTiers() const { return mAnimationLodTiers; }
+
+        /// Returns the update interval for the current LOD value (@see setAnimationLodTiers)
+        /// or the one set via setUpdateInterval.
+        uint8 getCurrentUpdateInterval() const;
+
+        /** When true, instead of holding the last sampled pose while the animation isn't
+            sampled, bone transforms are interpolated between the last two sampled poses.
+            This costs a fraction of sampling the animations, but requires extra memory
+            and delays the animation by one update interval.
+        */
+        void setInterpolateSkippedFrames( bool bInterpolate );
+        bool getInterpolateSkippedFrames() const { return mInterpolateSkippedFrames; }
+
+        /** Makes this instance reuse the pose (i.e. bone local transforms) of another
+            instance instead of sampling its own animations. Useful for crowds playing the
+            same animations in sync, as the animations are sampled only once per group.
+        @remarks
+            The pose is seen with one frame of latency (to avoid stalls or race conditions
+            with the worker threads), and our own animations and throttling settings are
+            ignored while set. Manual bones are left untouched.
+            Derived transforms are still calculated per instance, since they depend on each
+            instance's parent node.
+            Don't call this function while animations are being updated.
+        @param source
+            Instance to take the pose from. Must be based on the same SkeletonDef and can't
+            be following another instance itself. Null to sample our own animations again.
+        */
+        void              setSharedPoseSource( SkeletonInstance *source );
+        SkeletonInstance *getSharedPoseSource() const { return mSharedPoseSource; }
+
+        /// Called by LodStrategy::lodSet. Can be called from multiple threads at the same time.
+        void _setLodValue( Real lodValue )
+        {
+            Real currentValue = mPendingLodValue.load( std::memory_order_relaxed );
+            while( lodValue < currentValue &&
+                   !mPendingLodValue.compare_exchange_weak( currentValue, lodValue,
+                                                            std::memory_order_relaxed ) )
+            {
+            }
+        }
+        Real getLodValue() const { return mLodValue; }
+
+        void _setUpdateFrameOffset( uint8 frameOffset ) { mUpdateFrameOffset = frameOffset; }
+
         /// Resets the transform of all bones to the binding pose. Manual bones are not reset
         void resetToPose();
 
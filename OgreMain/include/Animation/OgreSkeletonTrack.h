@@ -51,10 +51,32 @@ namespace Ogre
 
     typedef vector<KeyFrameRig>::type KeyFrameRigVec;
 
+    /** Ranges needed to decode the quantised keyframes of a compressed SkeletonTrack.
+        When a channel is constant across all keyframes, its value is stored in the
+        centre (or orientation) member and no per-keyframe data is kept for it.
+    @see SkeletonTrack::_compress
+    */
+    struct CompressedTrackRanges
+    {
+        ArrayVector3    mPositionCentre;
+        ArrayVector3    mPositionScale;
+        ArrayQuaternion mOrientation;  // Only used if the orientation is constant
+        ArrayVector3    mScaleCentre;
+        ArrayVector3    mScaleScale;
+    };
+
     typedef FastArray<BoneTransform> TransformArray;
 
     class _OgreExport SkeletonTrack : public OgreAllocatedObj
     {
+    public:
+        enum CompressedChannel
+        {
+            ChannelPosition = 1u << 0u,
+            ChannelOrientation = 1u << 1u,
+            ChannelScale = 1u << 2u
+        };
+
     protected:
         /// There is one entry per each parent level
         KeyFrameRigVec mKeyFrameRigs;
@@ -81,6 +103,21 @@ namespace Ogre
 
         KfTransformArrayMemoryManager *mLocalMemoryManager;
 
+        /// Null if the track is not compressed. Owned by SkeletonAnimationDef.
+        CompressedTrackRanges *RESTRICT_ALIAS mCompressedRanges;
+        /** Quantised keyframes; mCompressedStride int16 per KeyFrameRig. Only the channels
+            not in mConstantChannels are stored, in order position (xyz), orientation (wxyz)
+            and scale (xyz); each component is ARRAY_PACKED_REALS wide, matching the
+            SoA layout of ArrayVector3 & ArrayQuaternion. Owned by SkeletonAnimationDef.
+        */
+        int16 *RESTRICT_ALIAS mCompressedKeyFrames;
+        uint16                mCompressedStride;
+        /// Bitmask of CompressedChannel
+        uint8 mConstantChannels;
+
+        /// Dequantises the given keyframe. Track must be compressed.
+        inline void decodeKeyFrame( size_t keyFrameIdx, KfTransform &outTransform ) const;
+
     public:
         SkeletonTrack( uint32 boneBlockIdx, KfTransformArrayMemoryManager *kfTransformMemoryManager );
         ~SkeletonTrack();
@@ -127,6 +164,43 @@ namespace Ogre
             mUsedSlots <= (ARRAY_PACKED_REALS >> 1). Otherwise it does nothing.
         */
         void _bakeUnusedSlots();
+
+        /** Returns the transform of a single bone at a given keyframe. Works whether
+            the track is compressed or not.
+        @param keyFrameIdx
+            Index to getKeyFrames()
+        @param slot
+            Slot in range [0; ARRAY_PACKED_REALS)
+        */
+        void getKeyFrameTransform( size_t keyFrameIdx, size_t slot, Vector3 &outPos,
+                                   Quaternion &outRot, Vector3 &outScale ) const;
+
+        bool isCompressed() const { return mCompressedRanges != 0; }
+
+        /// Returns a bitmask of CompressedChannel whose values don't change
+        /// (within threshold) across all keyframes.
+        uint8 _findConstantChannels( Real threshold ) const;
+
+        /// Number of int16 needed per keyframe to store the given non-constant channels.
+        static size_t calculateCompressedStride( uint8 constantChannels );
+
+        /** Quantises all keyframes into the given memory and switches this track to decode
+            from it. Orientations are stored as int16 in range [-1; 1], while positions and
+            scales are stored as int16 scaled to each component's range within the track.
+            Channels flagged in constantChannels are stored only once.
+        @remarks
+            KeyFrameRig::mBoneTransform will be set to null afterwards, and the caller is
+            expected to free the KfTransform memory.
+            Don't call this while animations using this track are being updated.
+        @param constantChannels
+            Value returned by _findConstantChannels
+        @param ranges
+            SIMD aligned memory for the ranges. Must outlive this track.
+        @param keyFrameData
+            Memory for calculateCompressedStride( constantChannels ) * getKeyFrames().size()
+            int16. Must outlive this track.
+        */
+        void _compress( uint8 constantChannels, CompressedTrackRanges *ranges, int16 *keyFrameData );
     };
 
     typedef vector<SkeletonTrack>::type SkeletonTrackVec;
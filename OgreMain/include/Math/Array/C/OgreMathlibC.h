@@ -237,6 +237,13 @@ namespace Ogre
 
         static inline void Set( ArrayReal &dst, Real val, size_t index ) { dst = val; }
 
+        /** Loads ARRAY_PACKED_REALS signed 16-bit integers and converts them to floating point.
+            src doesn't need to be aligned.
+        @return
+            r[i] = (float)src[i];
+        */
+        static inline ArrayReal Int16ToReal( const int16 *src ) { return static_cast<Real>( *src ); }
+
         /** Returns the result of "a == std::numeric_limits<float>::infinity()"
         @return
             r[i] = a[i] == Inf ? 0xffffffff : 0;
@@ -387,6 +387,16 @@ namespace Ogre
             dst[index] = val;
         }
 
+        /** Loads ARRAY_PACKED_REALS signed 16-bit integers and converts them to floating point.
+            src doesn't need to be aligned.
+        @return
+            r[i] = (float)src[i];
+        */
+        static inline ArrayReal Int16ToReal( const int16 *src )
+        {
+            return vcvtq_f32_s32( vmovl_s16( vld1_s16( src ) ) );
+        }
+
         /** Returns the result of "a == std::numeric_limits<float>::infinity()"
         @return
             r[i] = a[i] == Inf ? 0xffffffff : 0;
@@ -81,6 +81,53 @@ namespace Ogre
             // tmax >= max( tmin, 0 )
             return Mathlib::CompareGreaterEqual( tmax, Mathlib::Max( tmin, ARRAY_REAL_ZERO ) );
         }
+
+        /** Same as intersects( const ArrayAabb& ), but also returns the distance to the
+            entry point (0 if the origin is inside the box).
+        @remarks
+            Intended for testing the same rays against many boxes, thus the box extents
+            and the ray's inverse direction are supplied precomputed.
+        @param aabbMin
+            ArrayAabb::getMinimum
+        @param aabbMax
+            ArrayAabb::getMaximum
+        @param invDir
+            1.0 / mDirection
+        @param outDistance [out]
+            Distance along the ray to the box. Only valid where the returned mask is set.
+        */
+        ArrayMaskR intersects( const ArrayVector3 &aabbMin, const ArrayVector3 &aabbMax,
+                               const ArrayVector3 &invDir, ArrayReal &outDistance ) const
+        {
+            ArrayVector3 intersectAtMinPlane = ( aabbMin - mOrigin ) * invDir;
+            ArrayVector3 intersectAtMaxPlane = ( aabbMax - mOrigin ) * invDir;
+
+            ArrayVector3 minIntersect = intersectAtMinPlane;
+            minIntersect.makeFloor( intersectAtMaxPlane );
+            ArrayVector3 maxIntersect = intersectAtMinPlane;
+            maxIntersect.makeCeil( intersectAtMaxPlane );
+
+            ArrayReal tmin, tmax;
+            tmin = minIntersect.mChunkBase[0];
+            tmax = maxIntersect.mChunkBase[0];
+
+#if OGRE_CPU == OGRE_CPU_ARM && OGRE_USE_SIMD == 1
+            tmin = Mathlib::Max( Mathlib::Max( minIntersect.mChunkBase[0], minIntersect.mChunkBase[1] ),
+                                 minIntersect.mChunkBase[2] );
+            tmax = Mathlib::Min( Mathlib::Min( maxIntersect.mChunkBase[0], maxIntersect.mChunkBase[1] ),
+                                 maxIntersect.mChunkBase[2] );
+#else
+            tmin = Mathlib::Max( tmin, Mathlib::Min( minIntersect.mChunkBase[1], tmax ) );
+            tmax = Mathlib::Min( tmax, Mathlib::Max( maxIntersect.mChunkBase[1], tmin ) );
+
+            tmin = Mathlib::Max( tmin, Mathlib::Min( minIntersect.mChunkBase[2], tmax ) );
+            tmax = Mathlib::Min( tmax, Mathlib::Max( maxIntersect.mChunkBase[2], tmin ) );
+#endif
+            outDistance = Mathlib::Max( tmin, ARRAY_REAL_ZERO );
+            // A ray parallel to a slab it's outside of results in tmin = tmax = inf
+            return Mathlib::And( Mathlib::CompareGreaterEqual( tmax, outDistance ),
+                                 Mathlib::CompareLess( outDistance, Mathlib::INFINITEA ) );
+        }
     };
 }  // namespace Ogre
 
@@ -62,6 +62,9 @@ namespace Ogre
         /// Tracks total number of objects in all render queues.
         size_t mTotalObjects;
 
+        /// Incremented every time an object is created or destroyed.
+        uint32 mStructureRevision;
+
         /// Dummy node where to point ObjectData::mParents[i] when they're unused slots.
         SceneNode  *mDummyNode;
         Transform   mDummyTransformPtrs;
@@ -165,6 +168,12 @@ namespace Ogre
         */
         size_t getTotalNumObjects() const { return mTotalObjects; }
 
+        /** Returns a counter that changes every time an object is added to or removed
+            from this manager (including migrations between static and dynamic).
+            Useful for caches (e.g. SceneQueryBvh) that hold MovableObject pointers.
+        */
+        uint32 getStructureRevision() const { return mStructureRevision; }
+
         /// This is the opposite of getTotalNumObjects. This function returns the sum
         /// of the return values of getFirstObjectData
         size_t calculateTotalNumObjectDataIncludingFragmentedSlots() const;
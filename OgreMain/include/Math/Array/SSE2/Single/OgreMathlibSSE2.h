@@ -269,6 +269,19 @@ namespace Ogre
             dst[index] = val;
         }
 
+        /** Loads ARRAY_PACKED_REALS signed 16-bit integers and converts them to floating point.
+            src doesn't need to be aligned.
+        @return
+            r[i] = (float)src[i];
+        */
+        static inline ArrayReal Int16ToReal( const int16 *src )
+        {
+            // Sign-extend the 4 int16 to int32 by unpacking into the upper halves
+            __m128i val = _mm_loadl_epi64( reinterpret_cast<const __m128i *>( src ) );
+            val = _mm_srai_epi32( _mm_unpacklo_epi16( val, val ), 16 );
+            return _mm_cvtepi32_ps( val );
+        }
+
         /** Returns the result of "a == std::numeric_limits<float>::infinity()"
         @return
             r[i] = a[i] == Inf ? 0xffffffff : 0;
@@ -165,6 +165,15 @@ namespace Ogre
         */
         virtual void remove( const String &filename );
 
+        /** Rename a file, replacing newFilename if it already exists.
+        @remarks Not possible on read-only archives.
+            Write to a temporary file and rename it once done so that other readers
+            never see a half written file.
+        @param oldFilename The fully qualified name of the file
+        @param newFilename The fully qualified name the file will have
+        */
+        virtual void rename( const String &oldFilename, const String &newFilename );
+
         /** List all file names in the archive.
         @note
             This method only returns filenames, you can also retrieve other
@@ -0,0 +1,102 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreBlockCompressor_H_
+#define _OgreBlockCompressor_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Image
+     *  @{
+     */
+    /** CPU encoders for the BC1, BC3, BC4, BC5 & BC7 block compressed formats.
+    @remarks
+        The encoders favour speed over quality, as they're meant to be run at load time
+        (see TextureFilter::CompressBc). Use an offline tool if you need the best quality.
+
+        BC1 & BC3 fit the endpoints along the principal axis of the block, then refine them
+        with least squares. BC4 & BC5 use the block's range. BC7 only uses mode 6
+        (1 subset, RGBA endpoints, 4-bit indices).
+    */
+    class _OgreExport BlockCompressor
+    {
+    public:
+        /// Returns true if compress() can encode srcFormat into dstFormat.
+        /// Supported source formats are RGBA8, BGRA8 & BGRX8 (for BC1, BC3 & BC7),
+        /// R8 (for BC4) and RG8 (for BC5). UNORM & SNORM must match.
+        static bool canCompress( PixelFormatGpu srcFormat, PixelFormatGpu dstFormat );
+
+        /** Compresses srcBox into dstBox, which must have the same resolution
+        @remarks
+            Blocks that lie partially outside the image (e.g. mips smaller than 4x4) are
+            padded by repeating the last row & column.
+        @param srcBox
+            Uncompressed data. All its slices are compressed.
+        @param srcFormat
+        @param dstBox
+            Where to store the compressed blocks.
+        @param dstFormat
+            See canCompress.
+        @param blockRowStart
+            Only rows of blocks in range [blockRowStart; blockRowEnd) are compressed.
+            Different ranges can be compressed from different threads at the same time.
+        @param blockRowEnd
+            Use getNumBlockRows to compress the whole image.
+        */
+        static void compress( const TextureBox &srcBox, PixelFormatGpu srcFormat,
+                              const TextureBox &dstBox, PixelFormatGpu dstFormat, uint32 blockRowStart,
+                              uint32 blockRowEnd );
+
+        static uint32 getNumBlockRows( uint32 height ) { return ( height + 3u ) >> 2u; }
+
+        /// Encodes 16 texels (4x4, row major) with 4 components each into 8 bytes. Alpha is ignored.
+        static void encodeBc1( const uint8 rgba[16 * 4], uint8 outBlock[8] );
+        /// Encodes 16 texels (4x4, row major) with 4 components each into 16 bytes.
+        static void encodeBc3( const uint8 rgba[16 * 4], uint8 outBlock[16] );
+        /// Encodes 16 values into 8 bytes.
+        static void encodeBc4( const uint8 values[16], uint8 outBlock[8] );
+        /// Encodes 16 values into 8 bytes. -128 is treated as -127.
+        static void encodeBc4Snorm( const int8 values[16], uint8 outBlock[8] );
+        /// Encodes 16 texels (4x4, row major) with 4 components each into 16 bytes.
+        static void encodeBc7( const uint8 rgba[16 * 4], uint8 outBlock[16] );
+    };
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
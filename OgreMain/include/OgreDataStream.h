@@ -308,6 +308,16 @@ namespace Ogre
         */
         size_t size() const { return mSize; }
 
+        /** Returns a pointer to the entire contents of the stream (not just from the current
+            position) if they are contiguous in memory, e.g. MemoryDataStream or
+            MappedFileDataStream. Returns null otherwise.
+        @remarks
+            Allows consumers to read the data in place instead of copying it with read().
+            Use tell() & skip() to keep the stream position in sync.
+            The pointer is valid until the stream is closed.
+        */
+        virtual const uint8 *getContiguousPtr() const { return 0; }
+
         /** Close the stream; this makes further operations invalid. */
         virtual void close() = 0;
     };
@@ -441,6 +451,9 @@ namespace Ogre
         /** Get a pointer to the current position in the memory block this stream holds. */
         uchar *getCurrentPtr() { return mPos; }
 
+        /// @copydoc DataStream::getContiguousPtr
+        const uint8 *getContiguousPtr() const override { return mData; }
+
         /** @copydoc DataStream::read
          */
         size_t read( void *buf, size_t count ) override;
@@ -113,12 +113,18 @@ namespace Ogre
             std::swap( this->mCapacity, other.mCapacity );
         }
 
-        FastArray( const FastArray<T> &copy ) : mSize( copy.mSize ), mCapacity( copy.mSize )
+        FastArray( const FastArray<T> &copy ) :
+            mData( 0 ),
+            mSize( copy.mSize ),
+            mCapacity( copy.mSize )
         {
-            mData = (T *)::operator new( mSize * sizeof( T ) );
-            for( size_t i = 0; i < mSize; ++i )
+            if( mSize )
             {
-                new( &mData[i] ) T( copy.mData[i] );
+                mData = (T *)::operator new( mSize * sizeof( T ) );
+                for( size_t i = 0; i < mSize; ++i )
+                {
+                    new( &mData[i] ) T( copy.mData[i] );
+                }
             }
         }
 
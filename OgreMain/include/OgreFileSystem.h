@@ -62,6 +62,60 @@ namespace Ogre
     /** \addtogroup Resources
      *  @{
      */
+    /** Read-only DataStream backed by a memory-mapped file.
+    @remarks
+        Data is paged in by the OS on demand, and consumers can read it in place through
+        getContiguousPtr() instead of copying it with read().
+        Returned by FileSystemArchive::open when FileSystemArchive::setUseMemoryMapping is
+        enabled.
+    */
+    class _OgreExport MappedFileDataStream final : public DataStream
+    {
+    protected:
+        /// Pointer to the start of the mapped view
+        uint8 *mData;
+        /// Current read position, in bytes from mData
+        size_t mPos;
+
+        MappedFileDataStream( const String &name, uint8 *data, size_t size );
+
+    public:
+        /** Maps the given file.
+        @param name
+            Name to give to the stream.
+        @param fullPath
+            Path to the file to map, as passed to std::ifstream.
+        @return
+            The stream. Null if the file couldn't be mapped (e.g. it doesn't exist, it is
+            empty, or the platform doesn't support it) in which case the caller should fall
+            back to FileStreamDataStream.
+        */
+        static MappedFileDataStream *mapFile( const String &name, const String &fullPath );
+
+        ~MappedFileDataStream() override;
+
+        /// @copydoc DataStream::getContiguousPtr
+        const uint8 *getContiguousPtr() const override { return mData; }
+
+        /// @copydoc DataStream::read
+        size_t read( void *buf, size_t count ) override;
+
+        /// @copydoc DataStream::skip
+        void skip( long count ) override;
+
+        /// @copydoc DataStream::seek
+        void seek( size_t pos ) override;
+
+        /// @copydoc DataStream::tell
+        size_t tell() const override { return mPos; }
+
+        /// @copydoc DataStream::eof
+        bool eof() const override { return mPos >= mSize; }
+
+        /// @copydoc DataStream::close
+        void close() override;
+    };
+
     /** Specialisation of the Archive class to allow reading of files from
         filesystem folders / directories.
     */
@@ -106,6 +160,9 @@ namespace Ogre
         /// @copydoc Archive::remove
         void remove( const String &filename ) override;
 
+        /// @copydoc Archive::rename
+        void rename( const String &oldFilename, const String &newFilename ) override;
+
         /// @copydoc Archive::list
         StringVectorPtr list( bool recursive = true, bool dirs = false ) override;
 
@@ -133,7 +190,23 @@ namespace Ogre
         /// Get whether hidden files are ignored during filesystem enumeration.
         static bool getIgnoreHidden() { return msIgnoreHidden; }
 
+        /** Set whether files opened in read-only mode are memory-mapped (see
+            MappedFileDataStream) instead of being read through std::ifstream.
+            Consumers such as the mesh serializer, DDSCodec2 & HlmsDiskCache then read
+            straight from the mapping, avoiding intermediate copies.
+            Files that can't be mapped fall back to std::ifstream.
+            The default is false.
+        */
+        static void setUseMemoryMapping( bool useMemoryMapping )
+        {
+            msUseMemoryMapping = useMemoryMapping;
+        }
+
+        /// Get whether read-only files are memory-mapped.
+        static bool getUseMemoryMapping() { return msUseMemoryMapping; }
+
         static bool msIgnoreHidden;
+        static bool msUseMemoryMapping;
     };
 
     /** Specialisation of ArchiveFactory for FileSystem files. */
@@ -182,8 +182,17 @@ namespace Ogre
             /// Contains merged properties (pass and renderable's)
             RenderableCache mergedCache;
             GpuProgramPtr   shaders[NumShaderTypes];
-
-            ShaderCodeCache( const PiecesMap *_pieces ) : mergedCache( HlmsPropertyVec(), _pieces ) {}
+            /// Number of PSOs that were created using these shaders. Saved by HlmsDiskCache
+            /// to compile the most used shaders first on the next run.
+            /// Counts carried over from previous runs are halved every run, so that shaders
+            /// which are no longer used eventually lose their priority. Saturates.
+            uint32 usageCount;
+
+            ShaderCodeCache( const PiecesMap *_pieces ) :
+                mergedCache( HlmsPropertyVec(), _pieces ),
+                usageCount( 0u )
+            {
+            }
 
             bool operator==( const ShaderCodeCache &_r ) const
             {
@@ -221,6 +230,17 @@ namespace Ogre
         HlmsPropertyVec mSetProperties;
         PiecesMap       mPieces;
 
+        struct AsyncShaderJob;
+        struct AsyncShaderSources;
+        class AsyncShaderHandler;
+
+        /// Owns the in-flight asynchronous shader jobs. Null while
+        /// asynchronous generation is disabled. See setAsyncShaderGeneration
+        AsyncShaderHandler *mAsyncShaderHandler;
+        /// True while getMaterial is being called by a caller that can skip
+        /// the renderable if its shaders are still being generated.
+        bool mAsyncShaderRequestAllowed;
+
     public:
         struct Library
         {
@@ -254,6 +274,10 @@ namespace Ogre
         HlmsListener *mListener;
         RenderSystem *mRenderSystem;
 
+        /// HlmsDiskCache currently warming up this Hlms. May be null.
+        /// See HlmsDiskCache::beginWarmUp
+        HlmsDiskCache *mDiskCacheWarmUp;
+
         HlmsDatablockMap mDatablocks;
 
         String        mShaderProfile;  ///< "glsl", "glsles", "hlsl"
@@ -296,6 +320,14 @@ namespace Ogre
 
         void unsetProperty( IdString key );
 
+        /// Properties the template parser works on. Normally these are mSetProperties, except
+        /// for worker threads doing asynchronous shader generation, which use their own copy.
+        HlmsPropertyVec       &getParserProperties();
+        const HlmsPropertyVec &getParserProperties() const;
+        /// Pieces the template parser works on. See getParserProperties
+        PiecesMap       &getParserPieces();
+        const PiecesMap &getParserPieces() const;
+
         enum ExpressionType
         {
             EXPR_OPERATOR_OR,    //||
@@ -391,6 +423,21 @@ namespace Ogre
         virtual void     clearShaderCache();
 
         void processPieces( Archive *archive, const StringVector &pieceFiles );
+        /// Runs a piece file through the template parser, collecting its pieces.
+        /// Contents of both inString and outString are destroyed.
+        void processPieceSource( String &inString, String &outString );
+        /** Runs a shader template through the template parser. Pieces must've been collected.
+        @param inString [in/out]
+            The template. Contents are destroyed.
+        @param outString [out]
+            The preprocessed shader.
+        @return
+            True if there were syntax errors.
+        */
+        bool preprocessShaderSource( String &inString, String &outString );
+        /// Fills outProperties with the properties compileShaderCode and parseOffline set
+        /// before parsing a template (syntax, shading language version, precision, etc).
+        void getBaseShaderProperties( HlmsPropertyVec &outProperties ) const;
         void hashPieceFiles( Archive *archive, const StringVector &pieceFiles,
                              FastArray<uint8> &fileContents ) const;
 
@@ -410,14 +457,17 @@ namespace Ogre
                                                   ShaderType shaderType );
 
     public:
-        void _compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
-                                                   const String           source[NumShaderTypes] );
+        /// Returns the index of the new entry in the shader code cache. See getShaderCodeCache
+        size_t _compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
+                                                     const String           source[NumShaderTypes] );
 
         /** Compiles input properties and adds it to the shader code cache
         @param codeCache [in/out]
             All variables must be filled except for ShaderCodeCache::shaders which is the output
+        @return
+            Index of the new entry in the shader code cache. See getShaderCodeCache
         */
-        void compileShaderCode( ShaderCodeCache &codeCache );
+        size_t compileShaderCode( ShaderCodeCache &codeCache );
 
         const ShaderCodeCacheVec &getShaderCodeCache() const { return mShaderCodeCache; }
 
@@ -802,11 +852,28 @@ namespace Ogre
             should cast shadows)
         @param casterPass
             True if this pass is the shadow mapping caster pass, false otherwise
+        @param allowAsync
+            When true and asynchronous shader generation is enabled (see
+            setAsyncShaderGeneration), a cache miss queues the shader for generation
+            in a worker thread and a null pointer is returned. The caller must then
+            skip the renderable until its shaders are ready.
         @return
-            Structure containing all necessary shaders
+            Structure containing all necessary shaders.
+            Null only if allowAsync is true and the shaders are still being generated.
         */
         const HlmsCache *getMaterial( HlmsCache const *lastReturnedValue, const HlmsCache &passCache,
-                                      const QueuedRenderable &queuedRenderable, bool casterPass );
+                                      const QueuedRenderable &queuedRenderable, bool casterPass,
+                                      bool allowAsync = false );
+
+        /** Same as getMaterial, but it never creates shaders. Returns a null pointer if the
+            shaders needed by the renderable don't exist yet.
+        @remarks
+            It doesn't modify any state, thus it can be called from multiple threads at the
+            same time, as long as no thread is calling getMaterial or creating shaders
+            in the meantime.
+        */
+        const HlmsCache *findMaterial( const HlmsCache        &passCache,
+                                       const QueuedRenderable &queuedRenderable, bool casterPass ) const;
 
         /** Fills the constant buffers. Gets executed right before drawing the mesh.
         @param cache
@@ -901,6 +968,32 @@ namespace Ogre
 
         void _clearShaderCache();
 
+        /** When enabled, the template preprocessing of shaders not yet in the cache
+            (i.e. the @property, @foreach, @piece, etc. passes) is performed on the
+            threads of Root's WorkQueue, so that new material variants don't stall
+            the render thread.
+        @remarks
+            Only affects getMaterial calls made with allowAsync = true, which the RenderQueue
+            does while rendering. Until the shader is ready, renderables needing it are
+            not drawn (they'll pop in once ready). Warm up passes, HlmsDiskCache and
+            renderSingleObject are always synchronous.
+            Preprocessed sources are turned into GPU programs and PSOs in the render thread
+            the next time they are requested, as that's the only thread allowed to do it.
+        @par
+            Derived implementations overriding createShaderCacheEntry must return the
+            null pointer returned by the base class when the shader is still pending.
+        */
+        void setAsyncShaderGeneration( bool bAsync );
+        bool getAsyncShaderGeneration() const { return mAsyncShaderHandler != 0; }
+
+        /// Returns the number of shaders queued or being generated in a worker thread,
+        /// or already generated and waiting to be compiled on their next request.
+        size_t getNumPendingAsyncShaders() const;
+
+        /// See HlmsDiskCache::beginWarmUp. Null to unset
+        void _setDiskCacheWarmUp( HlmsDiskCache *diskCache ) { mDiskCacheWarmUp = diskCache; }
+        HlmsDiskCache *_getDiskCacheWarmUp() const { return mDiskCacheWarmUp; }
+
         virtual void _changeRenderSystem( RenderSystem *newRs );
 
         RenderSystem *getRenderSystem() const { return mRenderSystem; }
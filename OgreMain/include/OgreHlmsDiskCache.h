@@ -128,6 +128,12 @@ namespace Ogre
                                     some stalls at runtime, due to the driver translating the Microcode
                                     to the internal ISA.
     @endcode
+    @par
+        The cache also records how many PSOs used each shader. applyTo compiles everything
+        immediately; alternatively beginWarmUp + warmUp compile the shaders over several
+        frames (e.g. while a loading screen is displayed), most used first. If a draw needs
+        a shader the warm-up hasn't reached yet, it gets compiled on the spot and the stall
+        is logged (see getNumWarmUpStalls).
     */
     class _OgreExport HlmsDiskCache : public OgreAllocatedObj
     {
@@ -136,6 +142,8 @@ namespace Ogre
         {
             Hlms::RenderableCache mergedCache;
             String                sourceFile[NumShaderTypes];
+            /// See Hlms::ShaderCodeCache::usageCount
+            uint32 usageCount;
 
             SourceCode();
             SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache );
@@ -175,6 +183,28 @@ namespace Ogre
         bool         mFastShaderBuildHack;
         uint16       mDebugStrSize;
 
+        /// Hlms being warmed up. Null if there's no warm-up in progress. See beginWarmUp
+        Hlms *mWarmUpHlms;
+        /// Indices to mCache.sourceCode, most used first.
+        /// Entries compiled on demand are replaced by c_warmUpEntryDone.
+        vector<uint32>::type mWarmUpOrder;
+        /// Hash of the set properties (see hashSetProperties) and index to mWarmUpOrder,
+        /// sorted by hash. Lets _notifyCompilingOnDemand avoid scanning every entry.
+        vector<std::pair<uint32, uint32> >::type mWarmUpLookup;
+        /// Next entry in mWarmUpOrder to compile
+        size_t mNextWarmUp;
+        size_t mNumPendingWarmUp;
+        size_t mNumWarmUpStalls;
+        /// Stalls that happened since the last time they were logged. Stalls are logged
+        /// at most once per warmUp call, as there may be many of them in a single frame.
+        size_t mNumUnloggedStalls;
+
+        /// Returns false if the cache can't be used at all with the given Hlms.
+        /// Otherwise sets mTemplatesOutOfDate if needed.
+        bool checkCompatibility( Hlms *hlms );
+        void compileSourceCode( const SourceCode &sourceCode );
+        void endWarmUp();
+
         void save( DataStreamPtr &dataStream, const IdString &hashedString );
         void save( DataStreamPtr &dataStream, const String &string );
         void save( DataStreamPtr &dataStream, const HlmsPropertyVec &properties );
@@ -192,8 +222,46 @@ namespace Ogre
         void clearCache();
 
         void copyFrom( Hlms *hlms );
+
+        /// Compiles all the shaders in the cache right away. Equivalent to beginWarmUp
+        /// followed by a warmUp with no time limit.
         void applyTo( Hlms *hlms );
 
+        /** Starts applying the cache to the given Hlms, without compiling any shader yet.
+            Call warmUp every frame until it returns true.
+        @remarks
+            The Hlms must outlive the warm-up. Calling clearCache, loadFrom or copyFrom
+            ends the warm-up (copyFrom finishes it first).
+        @return
+            False if the cache can't be applied to this Hlms.
+        */
+        bool beginWarmUp( Hlms *hlms );
+
+        /** Compiles the pending shaders, most used first, until the time budget runs out.
+        @remarks
+            Shaders are compiled on the calling thread, which must be the render thread: the
+            RenderSystems can't create GPU programs from other threads.
+        @param maxMicroseconds
+            Time budget. At least one shader is compiled per call.
+        @return
+            True if the warm-up is finished (or there was none in progress).
+        */
+        bool warmUp( uint64 maxMicroseconds );
+
+        bool isWarmingUp() const { return mWarmUpHlms != 0; }
+        /// Number of shaders the warm-up hasn't compiled yet.
+        size_t getNumPendingWarmUp() const { return mNumPendingWarmUp; }
+        /// Number of times a draw needed a shader that the warm-up hadn't compiled yet.
+        size_t getNumWarmUpStalls() const { return mNumWarmUpStalls; }
+
+        /** Called by Hlms when it is about to compile a shader for a draw.
+        @return
+            The usage count recorded in the cache for that shader (if it was pending), so
+            that frequencies keep accumulating across runs. 0 if not in the cache.
+            See Hlms::ShaderCodeCache::usageCount.
+        */
+        uint32 _notifyCompilingOnDemand( const Hlms::ShaderCodeCache &codeCache );
+
         void saveTo( DataStreamPtr &dataStream );
         void loadFrom( DataStreamPtr &dataStream );
     };
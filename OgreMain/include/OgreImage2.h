@@ -415,10 +415,15 @@ namespace Ogre
             True if the filter should be applied in linear space.
         @param filter
             The type of filter to use.
+        @param textureManager
+            Optional. When present, each mip level is split in bands and processed in parallel
+            using TextureGpuManager's multiload threadpool (see TextureGpuManager::setMultiLoadPool).
+            The output is the same regardless of this setting.
         @return
             False if failed to generate and mipmaps properties won't be changed. True on success.
         */
-        bool generateMipmaps( bool gammaCorrected, Filter filter = FILTER_BILINEAR );
+        bool generateMipmaps( bool gammaCorrected, Filter filter = FILTER_BILINEAR,
+                              TextureGpuManager *textureManager = 0 );
 
         /// Static function to get an image type string from a stream via magic numbers
         static String getFileExtFromMagic( DataStreamPtr &stream );
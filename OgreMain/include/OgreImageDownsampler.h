@@ -46,12 +46,19 @@ namespace Ogre
     @param kernelEndX
     @param kernelStartY
     @param kernelEndY
+    @param dstRowStart
+        Only rows in range [dstRowStart; dstRowEnd) of the destination are written.
+        dstPtr and srcPtr must still point to the first row of each image.
+        Different ranges can be processed from different threads at the same time.
+    @param dstRowEnd
+        See dstRowStart. Use dstHeight to process the whole image.
      */
     typedef void( ImageDownsampler2D )( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
                                         int32 dstHeight, int32 dstBytesPerRow, int32 srcWidth,
                                         int32 srcBytesPerRow, const uint8 kernel[5][5],
                                         const int8 kernelStartX, const int8 kernelEndX,
-                                        const int8 kernelStartY, const int8 kernelEndY );
+                                        const int8 kernelStartY, const int8 kernelEndY,
+                                        int32 dstRowStart, int32 dstRowEnd );
 
     ImageDownsampler2D downscale2x_XXXA8888;
     ImageDownsampler2D downscale2x_XXX888;
@@ -65,11 +72,17 @@ namespace Ogre
     //
 
     /** Bilinear 3D downsampler
+    @param dstSliceStart
+        Only slices in range [dstSliceStart; dstSliceEnd) of the destination are written.
+        See ImageDownsampler2D's dstRowStart.
+    @param dstSliceEnd
+        See dstSliceStart. Use dstDepth to process the whole volume.
      */
     typedef void( ImageDownsampler3D )( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
                                         int32 dstHeight, int32 dstDepth, int32 dstBytesPerRow,
                                         int32 dstBytesPerImage, int32 srcWidth, int32 srcHeight,
-                                        int32 srcBytesPerRow, int32 srcBytesPerImage );
+                                        int32 srcBytesPerRow, int32 srcBytesPerImage,
+                                        int32 dstSliceStart, int32 dstSliceEnd );
 
     ImageDownsampler3D downscale3D2x_X8;
     ImageDownsampler3D downscale3D2x_XXXA8888;
@@ -43,6 +43,9 @@ namespace Ogre
                     static_cast<uint8>( std::max<ptrdiff_t>( it - owner->mLodMesh->begin() - 1, 0 ) );
             }
 
+            if( owner->mSkeletonInstance )
+                owner->mSkeletonInstance->_setLodValue( lodValues[j] );
+
             RenderableArray::iterator itor = owner->mRenderables.begin();
             RenderableArray::iterator end = owner->mRenderables.end();
 
@@ -546,6 +546,20 @@ namespace Ogre
         static Real SymmetricRandom();
 
         static void SetRandomValueProvider( RandomValueProvider *provider );
+        /// Returns the provider set with SetRandomValueProvider. Null if none.
+        static RandomValueProvider *GetRandomValueProvider() { return mRandProvider; }
+
+        /** Overrides the random value provider for the calling thread only.
+        @remarks
+            Takes precedence over SetRandomValueProvider. Used by ParticleSystem so that
+            each system draws from its own generator, which keeps results deterministic
+            when systems are updated from several threads.
+        @param provider
+            The provider to use from now on in this thread. Null restores the global one.
+        @return
+            The previous provider of this thread.
+        */
+        static RandomValueProvider *_setThreadRandomValueProvider( RandomValueProvider *provider );
 
         /** Tangent function.
             @param fValue
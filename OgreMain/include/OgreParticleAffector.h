@@ -115,6 +115,38 @@ namespace Ogre
         */
         virtual void _affectParticles( ParticleSystem *pSystem, Real timeElapsed ) = 0;
 
+        /** Returns true if the affector implements _affectParticlesSoA.
+        @remarks
+            ParticleSystem keeps its particles in a ParticleSoA while it updates them. Calling
+            _affectParticles instead requires writing them back into the Particle instances
+            first, and reading them again afterwards.
+        */
+        virtual bool getSupportsSoA() const { return false; }
+
+        /** Same as _affectParticles, but working directly on the structure of arrays the
+            ParticleSystem updates its particles in, ARRAY_PACKED_REALS particles at a time.
+        @remarks
+            Only called if getSupportsSoA returns true.
+        @param
+            pSystem Pointer to a ParticleSystem to affect.
+        @param
+            particles The particles of pSystem.
+        @param
+            timeElapsed The number of seconds which have elapsed since the last call.
+        */
+        virtual void _affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                          Real timeElapsed )
+        {
+        }
+
+        /** Called on the main thread before the parent system gets updated from a worker thread.
+        @remarks
+            _initParticle and _affectParticles may run on a worker thread when
+            SceneManager::setParticleSystemUpdatesThreaded is enabled. Anything which isn't
+            thread safe (e.g. loading resources) must be done here instead.
+        */
+        virtual void _prepareThreadedUpdate() {}
+
         /** Returns the name of the type of affector.
         @remarks
             This property is useful for determining the type of affector procedurally so another
@@ -0,0 +1,192 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreParticleSoA_H_
+#define _OgreParticleSoA_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Array/OgreArrayVector3.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Effects
+     *  @{
+     */
+    /** Structure of arrays holding the state of the active particles of a ParticleSystem
+        while it gets updated.
+    @remarks
+        ParticleSystem::_update copies its Particle instances into these arrays, runs expiry,
+        the affectors and motion on ARRAY_PACKED_REALS particles at a time, and writes the
+        results back into the Particle instances at the end. See
+        ParticleAffector::_affectParticlesSoA.
+    @par
+        Each attribute is a separate array of Real, indexed by slot. Slot i of an attribute is
+        lane i % ARRAY_PACKED_REALS of its pack i / ARRAY_PACKED_REALS. The lanes past
+        mNumParticles in the last pack always hold finite values, so SIMD code can process
+        getNumPacks() whole packs and ignore the remainder.
+    @par
+        The Width & Height attributes hold the dimensions the particle is rendered with, i.e.
+        the system's default ones if the particle doesn't have its own.
+    */
+    class _OgreExport ParticleSoA : public OgreAllocatedObj
+    {
+    public:
+        enum Attribute
+        {
+            PositionX,
+            PositionY,
+            PositionZ,
+            DirectionX,
+            DirectionY,
+            DirectionZ,
+            TimeToLive,
+            TotalTimeToLive,
+            ColourR,
+            ColourG,
+            ColourB,
+            ColourA,
+            /// In radians
+            Rotation,
+            /// In radians per second
+            RotationSpeed,
+            Width,
+            Height,
+            NumAttributes
+        };
+
+    protected:
+        Real *RESTRICT_ALIAS mAttributes[NumAttributes];
+        /// The Particle instance each slot mirrors
+        Particle **RESTRICT_ALIAS mParticles;
+        /// Particle::mOwnDimensions of each slot
+        bool *RESTRICT_ALIAS mOwnDimensions;
+
+        size_t mNumParticles;
+        /// In slots. Always a multiple of ARRAY_PACKED_REALS
+        size_t mCapacity;
+
+    public:
+        ParticleSoA();
+        ParticleSoA( const ParticleSoA & ) = delete;
+        ~ParticleSoA();
+
+        ParticleSoA &operator=( const ParticleSoA & ) = delete;
+
+        size_t getNumParticles() const { return mNumParticles; }
+        size_t getNumPacks() const
+        {
+            return ( mNumParticles + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+        }
+
+        /** Changes the number of particles. Existing slots are kept, new ones are
+            uninitialised until gather or copySlot is called on them.
+        */
+        void resize( size_t numParticles );
+
+        /// Array of packs of the given attribute, for SIMD processing
+        ArrayReal *RESTRICT_ALIAS getArray( Attribute attribute )
+        {
+            return reinterpret_cast<ArrayReal *>( mAttributes[attribute] );
+        }
+        /// Array of slots of the given attribute
+        Real *RESTRICT_ALIAS getScalarArray( Attribute attribute ) { return mAttributes[attribute]; }
+
+        /// Loads the given pack of PositionXYZ or DirectionXYZ
+        ArrayVector3 getVector3( Attribute attributeX, size_t pack ) const
+        {
+            const ArrayReal *RESTRICT_ALIAS x =
+                reinterpret_cast<const ArrayReal *>( mAttributes[attributeX] );
+            const ArrayReal *RESTRICT_ALIAS y =
+                reinterpret_cast<const ArrayReal *>( mAttributes[attributeX + 1u] );
+            const ArrayReal *RESTRICT_ALIAS z =
+                reinterpret_cast<const ArrayReal *>( mAttributes[attributeX + 2u] );
+            return ArrayVector3( x[pack], y[pack], z[pack] );
+        }
+        /// Stores the given pack of PositionXYZ or DirectionXYZ
+        void setVector3( Attribute attributeX, size_t pack, const ArrayVector3 &value )
+        {
+            reinterpret_cast<ArrayReal *>( mAttributes[attributeX] )[pack] = value.mChunkBase[0];
+            reinterpret_cast<ArrayReal *>( mAttributes[attributeX + 1u] )[pack] = value.mChunkBase[1];
+            reinterpret_cast<ArrayReal *>( mAttributes[attributeX + 2u] )[pack] = value.mChunkBase[2];
+        }
+
+        Vector3 getPosition( size_t slot ) const
+        {
+            return Vector3( mAttributes[PositionX][slot], mAttributes[PositionY][slot],
+                            mAttributes[PositionZ][slot] );
+        }
+
+        Particle *getParticle( size_t slot ) const { return mParticles[slot]; }
+
+        /// Sets Particle::mOwnDimensions to true for all particles
+        void setAllOwnDimensions();
+
+        /** Copies the Particle into the given slot.
+        @param defaultWidth
+            Stored as the width if the particle doesn't have its own dimensions.
+        @param defaultHeight
+            Stored as the height if the particle doesn't have its own dimensions.
+        */
+        void gather( size_t slot, Particle *particle, Real defaultWidth, Real defaultHeight );
+
+        /// Copies the given slot back into its Particle
+        void scatter( size_t slot ) const;
+
+        /// Overwrites the slot dstSlot with a copy of srcSlot
+        void copySlot( size_t dstSlot, size_t srcSlot );
+
+        /** Removes the given slots, keeping the relative order of the remaining ones.
+        @param sortedSlots
+            Slots to remove, in ascending order.
+        */
+        void removeStable( const size_t *sortedSlots, size_t numSlots );
+
+        /** Removes the given slots by moving the last slots into their place.
+            Faster than removeStable, but the order of the remaining slots changes.
+        @param sortedSlots
+            Slots to remove, in ascending order.
+        */
+        void removeUnordered( const size_t *sortedSlots, size_t numSlots );
+
+        /// Fills the lanes past the last particle with copies of it, so that reductions
+        /// (e.g. calculating the bounds) can process whole packs.
+        void padLastPack();
+    };
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -30,8 +30,11 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "OgreMath.h"
+#include "OgreMatrix4.h"
 #include "OgreMovableObject.h"
 #include "OgreParticleIterator.h"
+#include "OgreParticleSoA.h"
 #include "OgreRadixSort.h"
 #include "OgreResourceGroupManager.h"
 #include "OgreStringInterface.h"
@@ -61,6 +64,10 @@ namespace Ogre
         In addition, like all subclasses of MovableObject, the ParticleSystem
         will only be considered for rendering once it has been attached to a
         SceneNode.
+    @par
+        While updating, the particles are kept in a structure of arrays (see ParticleSoA) and
+        the affectors which support it process them ARRAY_PACKED_REALS at a time. The Particle
+        instances are read before, and written back after each update.
     */
     class _OgreExport ParticleSystem : public StringInterface, public MovableObject
     {
@@ -295,6 +302,9 @@ namespace Ogre
             Normally you use an affector to alter particles in flight, but
             for small manually controlled particle systems you might want to use
             this method.
+        @note
+            Changes must be made between updates. While an update runs, the particles
+            live in a ParticleSoA and the Particle instances are out of date.
         */
         Particle *getParticle( size_t index );
 
@@ -345,6 +355,64 @@ namespace Ogre
         */
         void _update( Real timeElapsed );
 
+        /** Called by the time controller. Updates the system now, or defers the update
+            until SceneManager::updateSceneGraph if threaded particle updates are enabled.
+        @see
+            SceneManager::setParticleSystemUpdatesThreaded
+        @param timeStep
+            Time passed to each call to _update.
+        @param numIterations
+            Number of times _update must be called.
+        */
+        void _scheduleUpdate( Real timeStep, size_t numIterations );
+
+        /** Performs, on the main thread, everything a pending update needs that is not
+            thread safe (configuring the renderer, updating the parent node transforms,
+            ParticleAffector::_prepareThreadedUpdate).
+            Must be called before _executePendingUpdate when the latter is called from a
+            worker thread.
+        @return
+            False if there is nothing to update, in which case the pending update was
+            discarded and _executePendingUpdate must not be called. This happens when the
+            system isn't attached to a node, just like _update does nothing in that case.
+        */
+        bool _prepareThreadedUpdate();
+
+        /// Executes the update that was deferred by _scheduleUpdate.
+        /// Can be called from a worker thread after _prepareThreadedUpdate.
+        void _executePendingUpdate();
+
+        /// True between _prepareThreadedUpdate and the end of _executePendingUpdate,
+        /// i.e. while _update may be running on a worker thread.
+        bool _isThreadedUpdatePrepared() const { return mUseCachedTransforms; }
+
+        /// True if _scheduleUpdate deferred an update which hasn't been executed yet.
+        bool _hasPendingUpdate() const { return mPendingUpdateIterations != 0u; }
+
+        /** Makes emitters and affectors draw random numbers from a generator owned by this
+            system, instead of Math::UnitRandom's global one (a provider installed with
+            Math::SetRandomValueProvider, or rand()).
+        @remarks
+            The generator is active (via Math::_setThreadRandomValueProvider) only while the
+            system is updated. That way the output doesn't depend on the order in which
+            systems get updated, nor on how many threads update them.
+        @par
+            It is always used while SceneManager::setParticleSystemUpdatesThreaded is
+            enabled, since the global generator can't be assumed to be thread safe.
+        @param bUseOwnRandom
+            Default is false.
+        */
+        void setUseOwnRandomGenerator( bool bUseOwnRandom );
+        bool getUseOwnRandomGenerator() const { return mUseOwnRandom; }
+
+        /** Sets the seed of the generator used when setUseOwnRandomGenerator is enabled, or
+            SceneManager::setParticleSystemUpdatesThreaded is.
+        @remarks
+            Defaults to the object's Id. Setting the seed restarts the random sequence.
+        */
+        void setRandomSeed( uint64 seed );
+        uint64 getRandomSeed() const { return mRandomSeed; }
+
         /** Returns an iterator for stepping through all particles in this system.
         @remarks
             This method is designed to be used by people providing new ParticleAffector subclasses,
@@ -651,6 +719,17 @@ namespace Ogre
         }
 
     protected:
+        /// xorshift64* generator. Cheap and with plenty of quality for particle effects.
+        class RandomGenerator final : public Math::RandomValueProvider
+        {
+            uint64 mState;
+
+        public:
+            RandomGenerator() : mState( 1u ) {}
+            void seed( uint64 seed );
+            Real getRandomUnit() override;
+        };
+
         /// Command objects
         static CmdCull                msCullCmd;
         static CmdHeight              msHeightCmd;
@@ -710,8 +789,27 @@ namespace Ogre
         /// Defines whether particles emitts in direction with is translated into worldspace or not
         bool mTranslateParticleDirectionIntoWorldSpace;
 
+        /// See setUseOwnRandomGenerator & setRandomSeed
+        bool            mUseOwnRandom;
+        uint64          mRandomSeed;
+        RandomGenerator mRandom;
+
+        /// Scratch for _triggerEmitters (emission requested per emitter)
+        vector<unsigned>::type mEmitterRequested;
+        vector<unsigned>::type mEmittedEmitterRequested;
+
+        /// See _scheduleUpdate
+        Real   mPendingUpdateTimeStep;
+        size_t mPendingUpdateIterations;
+
+        /// When true, getParentNodeTransform & co. return the transforms cached by
+        /// _prepareThreadedUpdate, as Node::_getFullTransformUpdated isn't thread safe.
+        bool    mUseCachedTransforms;
+        Matrix4 mCachedParentTransform;
+        Matrix4 mCachedEmitterRootTransform;
+
         typedef list<Particle *>::type   ActiveParticleList;
-        typedef list<Particle *>::type   FreeParticleList;
+        typedef vector<Particle *>::type FreeParticleList;
         typedef vector<Particle *>::type ParticlePool;
 
         /** Sort by direction functor */
@@ -747,17 +845,35 @@ namespace Ogre
         */
         ActiveParticleList mActiveParticles;
 
-        /** Free particle queue.
+        /// Unused nodes of mActiveParticles, so that it doesn't allocate when it grows again
+        ActiveParticleList mSpareParticleNodes;
+
+        /** Free particle stack.
             @remarks
                 This contains a list of the particles free for use as new instances
                 as required by the set. Particle instances are preconstructed up
                 to the estimated size in the mParticlePool vector and are
-                referenced on this deque at startup. As they get used this list
+                referenced on this stack at startup. As they get used this list
                 reduces, as they get released back to to the set they get added
                 back to the list.
         */
         FreeParticleList mFreeParticles;
 
+        /** The active particles while _update runs. mActiveParticles and the Particle
+            instances are only brought up to date at the end, or before calling an affector
+            which doesn't support ParticleSoA.
+        */
+        ParticleSoA mParticleSoA;
+
+        /// True while mParticleSoA holds the particles, see gatherParticleSoA
+        bool mUpdatingSoA;
+
+        /// Particles created while mUpdatingSoA, waiting to be added to mParticleSoA
+        vector<Particle *>::type mNewParticles;
+
+        /// Scratch for _expire
+        vector<size_t>::type mExpiredSlots;
+
         /** Pool of particle instances for use and reuse in the active particle list.
             @remarks
                 This vector will be preallocated with the estimated size of the set,and will extend as
@@ -839,6 +955,11 @@ namespace Ogre
         /** Updates existing particle based on their momentum. */
         void _applyMotion( Real timeElapsed );
 
+        /// Full transform of mParentNode. See mUseCachedTransforms
+        const Matrix4 &getParentNodeTransform();
+        /// Full transform of mParticleEmitterRootNode. See mUseCachedTransforms
+        const Matrix4 &getEmitterRootNodeTransform();
+
         /** Applies the effects of affectors. */
         void _triggerAffectors( Real timeElapsed );
 
@@ -848,6 +969,20 @@ namespace Ogre
         /** Resize the internal pool of particles. */
         void increasePool( size_t size );
 
+        /// Appends the particle to mActiveParticles, reusing a spare node if possible.
+        void addActiveParticle( Particle *p );
+
+        /// Copies mActiveParticles into mParticleSoA, and sets mUpdatingSoA.
+        void gatherParticleSoA();
+
+        /// Appends mNewParticles to mParticleSoA.
+        void gatherNewParticles();
+
+        /** Writes mParticleSoA back into the Particle instances, and makes mActiveParticles
+            hold them in the same order. Doesn't touch mUpdatingSoA.
+        */
+        void scatterParticleSoA();
+
         /** Resize the internal pool of emitted emitters.
             @remarks
                 The pool consists of multiple vectors containing pointers to particle emitters.
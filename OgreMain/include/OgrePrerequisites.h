@@ -201,6 +201,7 @@ namespace Ogre
     class HlmsComputeJob;
     struct HlmsComputePso;
     class HlmsDatablock;
+    class HlmsDiskCache;
     class HlmsListener;
     class HlmsLowLevel;
     class HlmsLowLevelDatablock;
@@ -249,6 +250,7 @@ namespace Ogre
     class ParticleAffectorFactory;
     class ParticleEmitter;
     class ParticleEmitterFactory;
+    class ParticleSoA;
     class ParticleSystem;
     class ParticleSystemManager;
     class ParticleSystemRenderer;
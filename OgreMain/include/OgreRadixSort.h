@@ -30,6 +30,8 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "ogrestd/vector.h"
+
 namespace Ogre
 {
     /** \addtogroup Core
@@ -322,6 +324,190 @@ namespace Ogre
         }
     };
 
+    /** LSD radix sort specialised for contiguous arrays of PODs sorted by a 64-bit
+        unsigned key (e.g. QueuedRenderable::hash in RenderQueue).
+    @remarks
+        Unlike RadixSort, this one works on raw arrays (e.g. FastArray) and the caller
+        provides the scratch buffer, so that it can be kept alive across frames without
+        reallocating.
+    @par
+        The sort is stable, thus it can replace both std::sort and std::stable_sort.
+        All 8 histograms are built in a single pass over the data, and byte columns where
+        every key has the same value are skipped entirely (which is very common with
+        RenderQueue hashes, where a lot of bits are constant in a given frame).
+        Input that is already sorted is detected and left untouched.
+    @par
+        Big arrays can be split in slices sorted by different threads, and then put
+        together with mergeSortedSlices.
+    @code
+        struct QueuedRenderableKey
+        {
+            uint64 operator()( const QueuedRenderable &val ) const { return val.hash; }
+        };
+
+        scratch.resizePOD( queuedRenderables.size() );
+        RadixSort64<QueuedRenderable, QueuedRenderableKey>::sort(
+            queuedRenderables.begin(), scratch.begin(), queuedRenderables.size() );
+    @endcode
+    */
+    template <typename T, typename TKeyFunctor>
+    class RadixSort64
+    {
+    public:
+        /** Sorts in place the range [data; data + numElements)
+        @param data
+            Array to sort.
+        @param scratch
+            Array of at least numElements. Must not overlap with data. Its contents
+            are garbage after this call.
+        @param numElements
+            Number of elements in data.
+        @param func
+            Functor that returns the uint64 key of a given element.
+        @return
+            Number of byte passes that were actually performed. 0 if the data
+            was already sorted.
+        */
+        static size_t sort( T *RESTRICT_ALIAS data, T *RESTRICT_ALIAS scratch, size_t numElements,
+                            TKeyFunctor func = TKeyFunctor() )
+        {
+            if( numElements < 2u )
+                return 0u;
+
+            // Early out: Nothing to do. Stops at the first element out of order.
+            bool bSorted = true;
+            for( size_t i = 1u; i < numElements && bSorted; ++i )
+                bSorted = func( data[i - 1u] ) <= func( data[i] );
+
+            if( bSorted )
+                return 0u;
+
+            size_t counters[8][256];
+            memset( counters, 0, sizeof( counters ) );
+
+            for( size_t i = 0u; i < numElements; ++i )
+            {
+                const uint64 key = func( data[i] );
+                for( size_t b = 0u; b < 8u; ++b )
+                    ++counters[b][( key >> ( b << 3u ) ) & 0xFF];
+            }
+
+            const uint64 firstKey = func( data[0] );
+
+            T *RESTRICT_ALIAS src = data;
+            T *RESTRICT_ALIAS dst = scratch;
+            size_t numPasses = 0u;
+
+            for( size_t b = 0u; b < 8u; ++b )
+            {
+                const size_t shift = b << 3u;
+                size_t *RESTRICT_ALIAS offsets = counters[b];
+
+                // All keys share the same byte in this column. Nothing to do.
+                if( offsets[( firstKey >> shift ) & 0xFF] == numElements )
+                    continue;
+
+                size_t sum = 0u;
+                for( size_t j = 0u; j < 256u; ++j )
+                {
+                    const size_t count = offsets[j];
+                    offsets[j] = sum;
+                    sum += count;
+                }
+
+                for( size_t i = 0u; i < numElements; ++i )
+                {
+                    const size_t byteVal = ( func( src[i] ) >> shift ) & 0xFF;
+                    dst[offsets[byteVal]++] = src[i];
+                }
+
+                std::swap( src, dst );
+                ++numPasses;
+            }
+
+            if( src != data )
+                std::copy( src, src + numElements, data );
+
+            return numPasses;
+        }
+
+        /** Merges the consecutive slices of data, each of them already sorted (e.g. by
+            calling sort() on each slice from a different thread), into dst.
+        @remarks
+            Elements with equal keys keep the order of the slices they come from, thus
+            sorting the slices and merging them produces the same result as calling
+            sort() on the whole array.
+        @param data
+            Array of numElements, split in slices of sliceSize elements. The last slice
+            may be smaller.
+        @param dst
+            Array of at least numElements. Must not overlap with data.
+        @param numElements
+            Number of elements in data.
+        @param sliceSize
+            Number of elements in each slice. Must be greater than 0.
+        @param func
+            Functor that returns the uint64 key of a given element.
+        */
+        static void mergeSortedSlices( const T *RESTRICT_ALIAS data, T *RESTRICT_ALIAS dst,
+                                       size_t numElements, size_t sliceSize,
+                                       TKeyFunctor func = TKeyFunctor() )
+        {
+            assert( sliceSize > 0u );
+
+            typename vector<SliceCursor>::type heap;
+            heap.reserve( ( numElements + sliceSize - 1u ) / sliceSize );
+            for( size_t start = 0u; start < numElements; start += sliceSize )
+            {
+                SliceCursor cursor;
+                cursor.itor = data + start;
+                cursor.end = data + std::min( start + sliceSize, numElements );
+                cursor.key = func( *cursor.itor );
+                cursor.sliceIdx = heap.size();
+                heap.push_back( cursor );
+            }
+
+            // Single k-way pass driven by a min-heap of the slices' current elements
+            std::make_heap( heap.begin(), heap.end() );
+
+            while( heap.size() > 1u )
+            {
+                std::pop_heap( heap.begin(), heap.end() );
+                SliceCursor &cursor = heap.back();
+                *dst++ = *cursor.itor++;
+                if( cursor.itor == cursor.end )
+                {
+                    heap.pop_back();
+                }
+                else
+                {
+                    cursor.key = func( *cursor.itor );
+                    std::push_heap( heap.begin(), heap.end() );
+                }
+            }
+
+            if( !heap.empty() )
+                std::copy( heap.back().itor, heap.back().end, dst );
+        }
+
+    private:
+        struct SliceCursor
+        {
+            T const *itor;
+            T const *end;
+            uint64   key;
+            size_t   sliceIdx;
+
+            /// Reversed, so that std heaps put the lowest key (then lowest slice) on top.
+            bool operator<( const SliceCursor &other ) const
+            {
+                if( this->key != other.key )
+                    return this->key > other.key;
+                return this->sliceIdx > other.sliceIdx;
+            }
+        };
+    };
+
     /** @} */
     /** @} */
 
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 #include "OgreHlmsCommon.h"
+#include "OgreId.h"
 #include "OgreIteratorWrappers.h"
 #include "OgreSharedPtr.h"
 
@@ -133,12 +134,26 @@ namespace Ogre
         struct ThreadRenderQueue
         {
             QueuedRenderableArray q;
+            /// Order-independent hash of everything in q. See setTemporalCoherence
+            uint64 signature[2];
             /// The padding prevents false cache sharing when multithreading.
             uint8 padding[128];
         };
 
         typedef FastArray<ThreadRenderQueue> QueuedRenderableArrayPerThread;
 
+        /// The sorted queue from the last time a camera rendered a queue group.
+        /// See setTemporalCoherence
+        struct CachedSortedQueue
+        {
+            IdType                cameraId;
+            bool                  casterPass;
+            uint64                signature[2];
+            uint32                lastUsedFrame;
+            QueuedRenderableArray queuedRenderables;
+        };
+        typedef vector<CachedSortedQueue>::type CachedSortedQueueVec;
+
         struct RenderQueueGroup
         {
             QueuedRenderableArrayPerThread mQueuedRenderablesPerThread;
@@ -147,11 +162,34 @@ namespace Ogre
             bool                           mSorted;
             Modes                          mMode;
 
-            RenderQueueGroup() : mSortMode( NormalSort ), mSorted( false ), mMode( FAST ) {}
+            CachedSortedQueueVec mCachedSortedQueues;
+            /// Index of the entry in mCachedSortedQueues that must be swapped
+            /// with mQueuedRenderables on clear(). -1 if none.
+            size_t mCachedQueueToSwap;
+
+            RenderQueueGroup() :
+                mSortMode( NormalSort ),
+                mSorted( false ),
+                mMode( FAST ),
+                mCachedQueueToSwap( std::numeric_limits<size_t>::max() )
+            {
+            }
         };
 
         typedef vector<IndirectBufferPacked *>::type IndirectBufferPackedVec;
 
+        /// Data resolved by the worker threads before rendering FAST queues.
+        /// See setParallelPrepareThreshold
+        struct PreparedRenderable
+        {
+            VertexArrayObject *vao;
+            /// Null if the shaders didn't exist yet. The main thread creates them.
+            HlmsCache const *hlmsCache;
+        };
+        typedef FastArray<PreparedRenderable> PreparedRenderableArray;
+
+        class PrepareTask;
+
         RenderQueueGroup mRenderQueues[256];
 
         HlmsManager  *mHlmsManager;
@@ -173,6 +211,16 @@ namespace Ogre
 
         uint32 mRenderingStarted;
 
+        size_t                mParallelSortThreshold;
+        QueuedRenderableArray mSortScratch;
+
+        size_t                  mParallelPrepareThreshold;
+        PreparedRenderableArray mPreparedRenderables;
+
+        bool   mTemporalCoherence;
+        uint32 mFrameCount;
+        size_t mNumReplayedQueues;
+
         /** Returns a new (or an existing) indirect buffer that can hold the requested number of draws.
         @param numDraws
             Number of draws the indirect buffer is expected to hold. It must be an upper limit.
@@ -194,13 +242,41 @@ namespace Ogre
         unsigned char *renderGL3( RenderSystem *rs, bool casterPass, bool dualParaboloid,
                                   HlmsCache passCache[], const RenderQueueGroup &renderQueueGroup,
                                   IndirectBufferPacked *indirectBuffer, unsigned char *indirectDraw,
-                                  unsigned char *startIndirectDraw );
+                                  unsigned char *startIndirectDraw,
+                                  const PreparedRenderable *preparedRenderables );
         void renderGL3V1( RenderSystem *rs, bool casterPass, bool dualParaboloid, HlmsCache passCache[],
                           const RenderQueueGroup &renderQueueGroup );
 
         void warmUpShaders( bool casterPass, HlmsCache passCache[],
                             const RenderQueueGroup &renderQueueGroup );
 
+        /// Sorts the given queue, using worker threads if it's big enough.
+        void sortRenderQueue( RenderQueueGroup &renderQueueGroup );
+
+        /** Merges the per-thread queues of the group into mQueuedRenderables and sorts them.
+            With temporal coherence enabled, the sorted queue from the last time the
+            rendering camera rendered this group is used instead when it holds exactly
+            the same renderables. See setTemporalCoherence
+        */
+        void mergeAndSortRenderQueue( RenderQueueGroup &renderQueueGroup, bool casterPass );
+
+        /// Drops all the cached sorted queues of the group. See setTemporalCoherence
+        static void clearCachedSortedQueues( RenderQueueGroup &renderQueueGroup );
+
+        /// Sorts queuedRenderables by splitting it in slices that are radix sorted in
+        /// the worker threads, and then merged together in a single k-way pass
+        /// by the calling thread.
+        void sortRenderablesInParallel( QueuedRenderableArray &queuedRenderables );
+
+        /** Fills mPreparedRenderables for all FAST queues in range [firstRq; lastRq)
+            using the SceneManager's worker threads.
+        @return
+            True if the work was done. False if there weren't enough renderables to be
+            worth it (or the feature is disabled).
+        */
+        bool prepareRenderablesInParallel( uint8 firstRq, uint8 lastRq, bool casterPass,
+                                           size_t numNeededDraws );
+
     public:
         RenderQueue( HlmsManager *hlmsManager, SceneManager *sceneManager, VaoManager *vaoManager );
         ~RenderQueue();
@@ -305,6 +381,64 @@ namespace Ogre
         */
         void       setSortRenderQueue( uint8 rqId, RqSortMode sortMode );
         RqSortMode getSortRenderQueue( uint8 rqId ) const;
+
+        /** When sorting a render queue with at least this many renderables, the
+            SceneManager's worker threads will radix sort one slice each, which are
+            then merged by the main thread.
+            Smaller queues are radix sorted by the main thread alone.
+        @remarks
+            Both approaches produce the exact same (stable) order.
+            Has no effect if there is only one worker thread.
+        @param numRenderables
+            Minimum number of renderables in a queue. 0 to disable. Default is 32768.
+        */
+        void   setParallelSortThreshold( size_t numRenderables );
+        size_t getParallelSortThreshold() const { return mParallelSortThreshold; }
+
+        /** When rendering at least this many v2 renderables (i.e. Items) in a single call to
+            render(), the SceneManager's worker threads first resolve in parallel the Vao
+            (according to the current LOD) and the shaders of each renderable.
+            The main thread then only has to fill the buffers and record the commands.
+        @remarks
+            Hlms::fillBuffersForV2 and command recording stay in the main thread, as Hlms
+            implementations keep state (mapped buffers, bound pools, etc) that depends
+            on the previously processed renderable.
+        @par
+            Shaders that don't exist yet are still created by the main thread. The output
+            is exactly the same as with the feature disabled.
+        @param numRenderables
+            Minimum number of renderables. 0 to disable. Default is 0 (disabled).
+        */
+        void   setParallelPrepareThreshold( size_t numRenderables );
+        size_t getParallelPrepareThreshold() const { return mParallelPrepareThreshold; }
+
+        /** When enabled, the sorted result of each NormalSort queue is kept per rendering
+            camera and pass type (caster or not). If the same camera later queues exactly
+            the same renderables again (same Renderable, MovableObject and sort hash, which
+            covers the datablock, mesh LOD and quantized depth), the kept queue is rendered
+            as is. Merging the per-thread queues and sorting are skipped.
+        @remarks
+            Ideal for static cameras looking at a mostly static scene, e.g. security
+            cameras or shadow maps. The visible set is compared with an order-independent
+            signature that the worker threads accumulate while culling, thus a change
+            costs nothing extra. Any change (an object moving enough to change its
+            quantized depth, a LOD switch, a material change, etc) is detected and the
+            queue is sorted again.
+        @par
+            Culling still runs every frame, as it's what finds out the visible set.
+            The commands and the indirect buffer are still recorded every frame as well,
+            because Hlms rewrites its per-object buffers on every pass.
+        @par
+            Kept queues that go unused for a few frames are released.
+        @param bEnabled
+            Default is false.
+        */
+        void setTemporalCoherence( bool bEnabled );
+        bool getTemporalCoherence() const { return mTemporalCoherence; }
+
+        /// Number of times a kept queue was rendered instead of sorting again since
+        /// this RenderQueue was created. See setTemporalCoherence
+        size_t getNumReplayedQueues() const { return mNumReplayedQueues; }
     };
 
 #define OGRE_RQ_MAKE_MASK( x ) ( ( 1 << ( x ) ) - 1 )
@@ -48,6 +48,7 @@ Torus Knot Software Ltd.
 #include "OgreResourceGroupManager.h"
 #include "OgreSceneQuery.h"
 #include "Threading/OgreThreads.h"
+#include "Threading/OgreWorkStealingScheduler.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -77,6 +78,7 @@ namespace Ogre
     class DefaultRaySceneQuery;
     class DefaultSphereSceneQuery;
     class DefaultAxisAlignedBoxSceneQuery;
+    class SceneQueryBvh;
     class LodListener;
     struct MovableObjectLodChangedEvent;
     struct EntityMeshLodChangedEvent;
@@ -157,20 +159,43 @@ namespace Ogre
     struct UpdateTransformRequest
     {
         Transform t;
-        /// Number of nodes to process for each thread. Must be multiple of ARRAY_PACKED_REALS
-        size_t numNodesPerThread;
+        /// Number of nodes to process on each chunk. Must be multiple of ARRAY_PACKED_REALS
+        size_t numNodesPerChunk;
         size_t numTotalNodes;
 
-        UpdateTransformRequest() : numNodesPerThread( 0 ), numTotalNodes( 0 ) {}
+        UpdateTransformRequest() : numNodesPerChunk( 0 ), numTotalNodes( 0 ) {}
 
-        UpdateTransformRequest( const Transform &_t, size_t _numNodesPerThread, size_t _numTotalNodes ) :
+        UpdateTransformRequest( const Transform &_t, size_t _numNodesPerChunk, size_t _numTotalNodes ) :
             t( _t ),
-            numNodesPerThread( _numNodesPerThread ),
+            numNodesPerChunk( _numNodesPerChunk ),
             numTotalNodes( _numTotalNodes )
         {
         }
     };
 
+    /** A contiguous range of objects from a single render queue of an ObjectMemoryManager.
+        Worker threads grab these from WorkStealingScheduler instead of processing a fixed
+        1/N slice each.
+    */
+    struct ObjectDataChunk
+    {
+        ObjectMemoryManager *memoryManager;
+        size_t               renderQueue;
+        /// Must be multiple of ARRAY_PACKED_REALS
+        size_t firstObj;
+        size_t numObjs;
+
+        ObjectDataChunk( ObjectMemoryManager *_memoryManager, size_t _renderQueue, size_t _firstObj,
+                         size_t _numObjs ) :
+            memoryManager( _memoryManager ),
+            renderQueue( _renderQueue ),
+            firstObj( _firstObj ),
+            numObjs( _numObjs )
+        {
+        }
+    };
+    typedef vector<ObjectDataChunk>::type ObjectDataChunkVec;
+
     struct BuildLightListRequest
     {
         size_t startLightIdx;
@@ -821,14 +846,27 @@ namespace Ogre
         size_t mNumWorkerThreads;
         bool   mForceMainThread;
 
-        CullFrustumRequest            mCurrentCullFrustumRequest;
-        UpdateLodRequest              mUpdateLodRequest;
-        UpdateTransformRequest        mUpdateTransformRequest;
-        ObjectMemoryManagerVec const *mUpdateBoundsRequest;
-        UniformScalableTask          *mUserTask;
-        RequestType                   mRequestType;
-        Barrier                      *mWorkerThreadsBarrier;
-        ThreadHandleVec               mWorkerThreads;
+        CullFrustumRequest     mCurrentCullFrustumRequest;
+        UpdateLodRequest       mUpdateLodRequest;
+        UpdateTransformRequest mUpdateTransformRequest;
+        UniformScalableTask   *mUserTask;
+        RequestType            mRequestType;
+        Barrier               *mWorkerThreadsBarrier;
+        ThreadHandleVec        mWorkerThreads;
+
+        /// Hands out mObjectDataChunks (or chunks of Nodes) to the worker threads
+        WorkStealingScheduler mWorkStealingScheduler;
+        /// Work for the current request, when it operates on ObjectData
+        ObjectDataChunkVec mObjectDataChunks;
+        /// See setMinObjectsPerChunk
+        size_t mMinObjectsPerChunk;
+
+        /// See setSceneQueryBvhEnabled. Null when disabled.
+        SceneQueryBvh *mSceneQueryBvh;
+
+        /// See setParticleSystemUpdatesThreaded
+        bool                       mParticleSystemUpdatesThreaded;
+        FastArray<ParticleSystem *> mPendingParticleSystemUpdates;
 
         /** Contains MovableObjects to be visited and rendered.
         @rermarks
@@ -908,6 +946,18 @@ namespace Ogre
         */
         void updateAllTransformsThread( const UpdateTransformRequest &request, size_t threadIdx );
 
+        /// Returns the number of objects/nodes each chunk should have when splitting
+        /// totalObjs across worker threads. Always a multiple of ARRAY_PACKED_REALS
+        size_t calculateObjectsPerChunk( size_t totalObjs ) const;
+
+        /** Splits the objects in the given render queue range in mObjectDataChunks.
+            Call mWorkStealingScheduler.reset once all chunks have been added.
+        @remarks
+            Main thread only.
+        */
+        void addObjectDataChunks( const ObjectMemoryManagerVec &objectMemManager, size_t firstRq,
+                                  size_t lastRq );
+
         /// @see TagPoint::updateAllTransformsBoneToTag
         void updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
                                                  size_t                        threadIdx );
@@ -916,12 +966,12 @@ namespace Ogre
         void updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
                                                 size_t                        threadIdx );
 
-        /** Updates the world aabbs from the given request inside a thread. @see updateAllTransforms
+        /** Updates the world aabbs of mObjectDataChunks inside a thread. @see updateAllTransforms
         @param threadIdx
             Thread index so we know at which point we should start at.
             Must be unique for each worker thread
         */
-        void updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager, size_t threadIdx );
+        void updateAllBoundsThread( size_t threadIdx );
 
         /**
         @param threadIdx
@@ -1011,6 +1061,20 @@ namespace Ogre
 
         size_t getNumWorkerThreads() const { return mNumWorkerThreads; }
 
+        /** Work done by worker threads (culling, updating bounds, lods, transforms, etc) is split
+            in chunks and load balanced via work stealing; so that threads that finish early
+            help those that got the most expensive objects.
+        @remarks
+            Smaller chunks balance better but increase scheduling overhead.
+            Chunks may be bigger than this value when there are lots of objects, as we aim
+            at a few chunks per thread.
+        @param minObjectsPerChunk
+            Minimum number of objects (or nodes) per chunk. Will be rounded up to a multiple
+            of ARRAY_PACKED_REALS. Default is 64.
+        */
+        void   setMinObjectsPerChunk( size_t minObjectsPerChunk );
+        size_t getMinObjectsPerChunk() const { return mMinObjectsPerChunk; }
+
         /// Finds all the movable objects with the type and name passed as parameters.
         virtual MovableObjectVec findMovableObjects( const String &type, const String &name );
 
@@ -1617,6 +1681,27 @@ namespace Ogre
          */
         virtual void destroyAllParticleSystems();
 
+        /** When enabled, ParticleSystems are no longer updated one after another by their
+            time controllers. Instead their updates are deferred and dispatched across the
+            worker threads at the beginning of updateSceneGraph.
+        @remarks
+            While enabled, each ParticleSystem draws random numbers from its own generator
+            (see ParticleSystem::setUseOwnRandomGenerator), so the simulation produces the
+            same results no matter how many worker threads there are.
+        @par
+            Custom ParticleEmitters, ParticleAffectors and ParticleSystemRenderers must be
+            thread safe across different ParticleSystems (i.e. they must not modify state
+            shared with other systems) and must not access the SceneNode hierarchy.
+        @param bThreaded
+            Default is false.
+        */
+        void setParticleSystemUpdatesThreaded( bool bThreaded );
+        bool getParticleSystemUpdatesThreaded() const { return mParticleSystemUpdatesThreaded; }
+
+        /// @see ParticleSystem::_scheduleUpdate
+        void _addPendingParticleSystemUpdate( ParticleSystem *particleSystem );
+        void _removePendingParticleSystemUpdate( ParticleSystem *particleSystem );
+
         /** Empties the entire scene, inluding all SceneNodes, Entities, Lights,
             BillboardSets etc. Cameras are not deleted at this stage since
             they are still referenced by viewports, which are not destroyed during
@@ -1824,6 +1909,11 @@ namespace Ogre
         */
         void updateAllAnimations();
 
+        /** Executes the ParticleSystem updates deferred by their time controllers, using
+            the worker threads. @see setParticleSystemUpdatesThreaded
+        */
+        void updateAllParticleSystems();
+
         /** Updates the derived transforms of all nodes in the scene. This is typically called once
             per frame during render, but the user may want to manually call this function.
         @remarks
@@ -2211,6 +2301,25 @@ namespace Ogre
             certain objects; see SceneQuery for details.
         */
         virtual RaySceneQuery *createRayQuery( const Ray &ray, uint32 mask = QUERY_ENTITY_DEFAULT_MASK );
+
+        /** Maintains a Bounding Volume Hierarchy over the bounds of all entities, which
+            DefaultRaySceneQuery, DefaultSphereSceneQuery and DefaultAxisAlignedBoxSceneQuery
+            use instead of testing every single object.
+        @remarks
+            The tree is refitted at the end of updateSceneGraph (or rebuilt if objects were
+            created or destroyed), which costs one pass over all entities every frame.
+            Worth it when issuing many queries per frame.
+        @par
+            Queries issued after creating or destroying objects, but before the next
+            updateSceneGraph, will use the brute force path.
+        @param bEnabled
+            Default is false.
+        */
+        void setSceneQueryBvhEnabled( bool bEnabled );
+        bool getSceneQueryBvhEnabled() const { return mSceneQueryBvh != 0; }
+
+        /// Returns null if disabled. See setSceneQueryBvhEnabled
+        SceneQueryBvh *_getSceneQueryBvh() const { return mSceneQueryBvh; }
         // PyramidSceneQuery* createPyramidQuery(const Pyramid& p, unsigned long mask = 0xFFFFFFFF);
         /** Creates an IntersectionSceneQuery for this scene manager.
         @remarks
@@ -2617,6 +2726,13 @@ namespace Ogre
     protected:
         void fireWorkerThreadsAndWait();
 
+        /** Distributes mObjectDataChunks across the worker threads and processes
+            the given request on them.
+        @remarks
+            Will block until all threads are done.
+        */
+        void fireObjectDataChunks( RequestType requestType );
+
         /** Launches cullFrustum on all worker threads with the requested parameters
         @remarks
             Will block until all threads are done.
@@ -2678,6 +2794,16 @@ namespace Ogre
         void execute( RaySceneQueryListener *listener ) override;
         bool execute( ObjectData objData, size_t numNodes, RaySceneQueryListener *listener );
 
+        /// See RaySceneQuery::executeBatch
+        void executeBatch( const Ray *rays, size_t numRays, RaySceneQueryBatchResult *outResults,
+                           bool bUseWorkerThreads = false ) override;
+
+        /** Single threaded implementation of executeBatch.
+            Can be called from multiple threads concurrently, as long as the scene isn't modified.
+        */
+        void _executeBatch( const Ray *rays, size_t numRays,
+                            RaySceneQueryBatchResult *outResults ) const;
+
     private:
         using RaySceneQuery::execute;  // Shut up compiler warnings
     };
@@ -367,6 +367,15 @@ namespace Ogre
     };
     typedef vector<RaySceneQueryResultEntry>::type RaySceneQueryResult;
 
+    /** Nearest hit of a single ray. See RaySceneQuery::executeBatch */
+    struct RaySceneQueryBatchResult
+    {
+        /// Nearest object hit by the ray. Null if the ray didn't hit anything.
+        MovableObject *movable;
+        /// Distance along the ray to the bounds of movable (0 if the ray starts inside them)
+        Real distance;
+    };
+
     /** Specialises the SceneQuery class for querying along a ray. */
     class _OgreExport RaySceneQuery : public SceneQuery, public RaySceneQueryListener
     {
@@ -426,6 +435,28 @@ namespace Ogre
         */
         virtual void execute( RaySceneQueryListener *listener ) = 0;
 
+        /** Finds the nearest object hit by each ray of a batch, using this query's
+            mask and render queue range. The ray set via setRay is not used.
+        @remarks
+            Much cheaper than calling setRay and execute once per ray. The default
+            implementation does exactly that though; SceneManagers are expected to
+            override it (DefaultRaySceneQuery tests packets of objects against each ray
+            using SIMD, or uses SceneManager's BVH when enabled).
+        @param rays
+            Array of numRays rays.
+        @param numRays
+            Number of rays.
+        @param outResults [out]
+            Array of at least numRays elements. outResults[i] contains the nearest hit of rays[i].
+        @param bUseWorkerThreads
+            When true, the rays may be split between SceneManager's worker threads.
+            In that case this function must be called from the main thread, and
+            not while the SceneManager is rendering or updating the scene graph.
+        */
+        virtual void executeBatch( const Ray *rays, size_t numRays,
+                                   RaySceneQueryBatchResult *outResults,
+                                   bool bUseWorkerThreads = false );
+
         /** Gets the results of the last query that was run using this object, provided
             the query was executed using the collection-returning version of execute.
         */
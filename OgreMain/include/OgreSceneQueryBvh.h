@@ -0,0 +1,201 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreSceneQueryBvh_H_
+#define _OgreSceneQueryBvh_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Simple/OgreAabb.h"
+#include "OgreCommon.h"
+#include "OgreFastArray.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    class RaySceneQueryListener;
+    struct RaySceneQueryBatchResult;
+    class SceneQueryListener;
+
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    /** Bounding Volume Hierarchy over the world AABBs of all the entities (i.e. not lights)
+        in a SceneManager, used to accelerate DefaultRaySceneQuery, DefaultSphereSceneQuery
+        and DefaultAxisAlignedBoxSceneQuery.
+    @remarks
+        The SceneManager calls update() at the end of updateSceneGraph, which:
+            1. Rebuilds the tree if objects were created or destroyed since last time.
+            2. Otherwise refits the tree to the new bounds. Only the leaves holding objects
+               whose bounds changed, and their parents, are recalculated. Static objects
+               are only checked when the SceneManager flagged them as dirty.
+            3. Rebuilds the tree if refitting degraded its quality beyond the rebuild
+               threshold (see setRebuildThreshold).
+    @par
+        Queries are const and do not modify the tree, thus they can be issued from
+        multiple threads at the same time, as long as no one calls update() concurrently.
+    @par
+        If objects were created or destroyed after the last update() the tree cannot be
+        trusted (it may contain dangling pointers); isUpToDate returns false in that case
+        and the queries fall back to the brute force path.
+    */
+    class _OgreExport SceneQueryBvh : public OgreAllocatedObj
+    {
+    public:
+        struct Node
+        {
+            float aabbMin[3];
+            /// Internal nodes: index to the first of two consecutive children.
+            /// Leaves: index to the first object in mObjects.
+            uint32 firstChildOrObject;
+            float  aabbMax[3];
+            /// 0 for internal nodes.
+            uint32 numObjects;
+        };
+
+        struct ObjectEntry
+        {
+            MovableObject *movableObject;
+            Aabb           worldAabb;
+            Real           worldRadius;
+        };
+
+        typedef FastArray<Node>        NodeArray;
+        typedef FastArray<ObjectEntry> ObjectEntryArray;
+
+    protected:
+        SceneManager *mSceneManager;
+
+        NodeArray        mNodes;
+        ObjectEntryArray mObjects;
+
+        /// Parent of each node in mNodes. The root's parent is itself.
+        FastArray<uint32> mNodeParents;
+        /// Leaf node that holds each object in mObjects.
+        FastArray<uint32> mObjectLeaves;
+        /// Indices to the objects in mObjects that aren't static.
+        FastArray<uint32> mDynamicObjects;
+
+        /// Nodes to recalculate during refit, and whether each node is in that list.
+        FastArray<uint32> mDirtyNodes;
+        FastArray<uint8>  mNodeDirtyFlags;
+
+        /// ObjectMemoryManager::getStructureRevision at the time of the last build.
+        uint32 mStructureRevisions[NUM_SCENE_MEMORY_MANAGER_TYPES];
+        bool   mBuilt;
+
+        /// Sum of the surface areas of all nodes right after the last build.
+        Real mBuildCost;
+        /// Sum of the surface areas of all nodes after the last refit.
+        Real mCurrentCost;
+        Real mRebuildThreshold;
+
+        uint32 mMaxObjectsPerLeaf;
+
+        /// Builds the node at nodeIdx containing mObjects[firstObj; firstObj + numObjs)
+        void buildNode( size_t nodeIdx, size_t firstObj, size_t numObjs );
+
+        /// Updates mObjects[objIdx] bounds. If they changed, the leaf holding
+        /// it and all its parents are added to mDirtyNodes.
+        void refitObject( size_t objIdx );
+
+        /// Recalculates mNodes[nodeIdx] bounds from its objects or children.
+        void calculateNodeBounds( size_t nodeIdx );
+
+        /// Sums the surface areas of all nodes.
+        Real calculateCost() const;
+
+        void build();
+
+        /// Returns true if any of the bounds changed.
+        bool refit( bool staticObjectsDirty );
+
+        bool isObjectAccepted( const MovableObject *movableObject, uint32 queryMask, uint8 firstRq,
+                               uint8 lastRq ) const;
+
+    public:
+        SceneQueryBvh( SceneManager *sceneManager );
+        ~SceneQueryBvh();
+
+        /** Refits or rebuilds the tree. See class description.
+        @param staticObjectsDirty
+            Whether any static object may have changed its bounds since the last update.
+            When false, only the bounds of dynamic objects are checked for changes.
+        */
+        void update( bool staticObjectsDirty );
+
+        /// Returns false if objects were created or destroyed after the last update.
+        bool isUpToDate() const;
+
+        /** Rebuild the whole tree when, after refitting it to moving objects, the sum of
+            the surface areas of all nodes grows above this factor compared to the last build.
+        @param threshold
+            Must be >= 1. Default is 2.
+        */
+        void setRebuildThreshold( Real threshold );
+        Real getRebuildThreshold() const { return mRebuildThreshold; }
+
+        /** Casts a ray against the tree and reports every hit object to the listener.
+            Same results as DefaultRaySceneQuery's brute force path (order may differ).
+        @return
+            False if the listener requested to stop.
+        */
+        bool rayQuery( const Ray &ray, uint32 queryMask, uint8 firstRq, uint8 lastRq,
+                       RaySceneQueryListener *listener ) const;
+
+        /** Finds the nearest object hit by the ray. Subtrees farther than the
+            nearest hit found so far are skipped.
+        @param outResult [out]
+            outResult.movable is null if nothing was hit.
+        */
+        void rayQueryNearest( const Ray &ray, uint32 queryMask, uint8 firstRq, uint8 lastRq,
+                              RaySceneQueryBatchResult &outResult ) const;
+
+        /// Same as DefaultSphereSceneQuery's brute force path (order may differ).
+        bool sphereQuery( const Sphere &sphere, uint32 queryMask, uint8 firstRq, uint8 lastRq,
+                          SceneQueryListener *listener ) const;
+
+        /// Same as DefaultAxisAlignedBoxSceneQuery's brute force path (order may differ).
+        bool aabbQuery( const Aabb &aabb, uint32 queryMask, uint8 firstRq, uint8 lastRq,
+                        SceneQueryListener *listener ) const;
+
+        size_t getNumNodes() const { return mNodes.size(); }
+        size_t getNumObjects() const { return mObjects.size(); }
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
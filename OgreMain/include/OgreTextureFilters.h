@@ -59,6 +59,11 @@ namespace Ogre
             TypePrepareForNormalMapping         = 1u << 2u,
             TypeLeaveChannelR                   = 1u << 3u,
             TypePremultiplyAlpha                = 1u << 4u,
+            /// Compresses RGBA8 & BGRA8 to BC1 (or BC3 if it has alpha), BGRX8 to BC1,
+            /// R8 to BC4 & RG8 to BC5 on the CPU. See CompressBc
+            TypeCompressBc                      = 1u << 5u,
+            /// Same as TypeCompressBc, but colour textures are compressed to BC7
+            TypeCompressBc7                     = 1u << 6u,
             // clang-format on
 
             TypeGenerateDefaultMipmaps = TypeGenerateSwMipmaps | TypeGenerateHwMipmaps
@@ -157,6 +162,43 @@ namespace Ogre
         public:
             void _executeStreaming( Image2 &image, TextureGpu *texture ) override;
         };
+        //-----------------------------------------------------------------------------------
+        /** Compresses the texture to a BC format on the CPU. See BlockCompressor.
+        @remarks
+            Runs after all other filters (including mipmap generation, which is forced to
+            run on the CPU since the GPU can't render to BC formats).
+            Textures are left untouched if their format isn't supported, they aren't 2D, 2D array,
+            cubemap or cubemap arrays, their resolution isn't a multiple of 4, or the
+            RenderSystem doesn't support the resulting format.
+        */
+        class _OgreExport CompressBc final : public FilterBase
+        {
+            bool mUseBc7;
+
+        public:
+            CompressBc( bool bUseBc7 ) : mUseBc7( bUseBc7 ) {}
+
+            /// Returns true if mip 0 of the image has no alpha, or all of it is 1.0
+            static bool isOpaque( const Image2 &image );
+
+            /// Returns the BC format srcFormat gets compressed to, or srcFormat if unsupported
+            static PixelFormatGpu getDestinationFormat( PixelFormatGpu srcFormat, bool bOpaque,
+                                                        bool bUseBc7 );
+
+            /** Returns the BC format the texture will be compressed to, or srcFormat if it
+                won't be compressed
+            @param srcFormat
+                Format after all the other filters were applied.
+            @param image
+                Image as loaded from file. Used to check its type, resolution and
+                whether it is opaque.
+            */
+            static PixelFormatGpu getDestinationFormat( PixelFormatGpu srcFormat, bool bUseBc7,
+                                                        const Image2            &image,
+                                                        const TextureGpuManager *textureManager );
+
+            void _executeStreaming( Image2 &image, TextureGpu *texture ) override;
+        };
     }  // namespace TextureFilter
     /** @} */
     /** @} */
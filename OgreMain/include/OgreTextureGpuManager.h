@@ -61,6 +61,7 @@ namespace Ogre
     class ObjCmdBuffer;
     class ResourceLoadingListener;
     class TextureGpuManagerListener;
+    class UniformScalableTask;
 
     namespace TextureFilter
     {
@@ -320,6 +321,14 @@ namespace Ogre
             bool autoDeleteImage;
             /// Indicates we're going to GpuResidency::OnSystemRam instead of Resident
             bool toSysRam;
+            /// Whether image was loaded from the transcoded cache, which means all filters
+            /// have already been applied except HW mipmap generation (and SW mipmap
+            /// generation for textures that couldn't use HW mipmaps at the time)
+            bool fromTranscodedCache;
+            /// Name of the entry in the transcoded cache for this image. Empty if
+            /// the cache is disabled or the image hasn't been loaded yet.
+            /// See setTranscodedCacheArchive
+            String transcodedCacheName;
 
             LoadRequest( const String &_name, Archive *_archive,
                          ResourceLoadingListener *_loadingListener, Image2 *_image, TextureGpu *_texture,
@@ -332,7 +341,8 @@ namespace Ogre
                 sliceOrDepth( _sliceOrDepth ),
                 filters( _filters ),
                 autoDeleteImage( _autoDeleteImage ),
-                toSysRam( _toSysRam )
+                toSysRam( _toSysRam ),
+                fromTranscodedCache( false )
             {
             }
         };
@@ -525,6 +535,15 @@ namespace Ogre
         typedef vector<ScheduledTasks>::type               ScheduledTasksVec;
         typedef map<TextureGpu *, ScheduledTasksVec>::type ScheduledTasksMap;
 
+        struct TranscodedCacheEntry
+        {
+            String name;
+            size_t sizeBytes;
+        };
+        /// Most recently used entries are at the front
+        typedef list<TranscodedCacheEntry>::type                      TranscodedCacheEntryList;
+        typedef map<String, TranscodedCacheEntryList::iterator>::type TranscodedCacheEntryMap;
+
         DefaultMipmapGen::DefaultMipmapGen mDefaultMipmapGen;
         DefaultMipmapGen::DefaultMipmapGen mDefaultMipmapGenCubemaps;
         bool                               mShuttingDown;
@@ -552,6 +571,13 @@ namespace Ogre
         Semaphore                    mMultiLoadsSemaphore;
         std::atomic<uint32>          mPendingMultiLoads;
 
+        /// Task split across the multiload threadpool. See _executeOnMultiLoadPool().
+        /// mPoolTask, mPoolTaskNextIdx & mPoolTaskNumTasks are protected by mMultiLoadsMutex
+        UniformScalableTask *mPoolTask;
+        uint32               mPoolTaskNextIdx;
+        uint32               mPoolTaskNumTasks;
+        Semaphore            mPoolTaskDoneSemaphore;
+
         TexturePoolList  mTexturePool;
         ResourceEntryMap mEntries;
         /// Protects mEntries
@@ -564,6 +590,22 @@ namespace Ogre
         TextureGpuManagerListener *mTextureGpuManagerListener;
         size_t                     mStagingTextureMaxBudgetBytes;
 
+        /// See setTranscodedCacheArchive. Used by the worker & multiload threads
+        Archive *mTranscodedCacheArchive;
+        /// Makes the names of the temporary files written by saveToTranscodedCache unique
+        std::atomic<uint32> mTranscodedCacheTmpCounter;
+        /// One bit per block compressed format the filters may produce, set if the
+        /// RenderSystem supports it. Part of every entry's name
+        uint32 mTranscodedCacheCapsTag;
+        /// See setTranscodedCacheBudget
+        size_t mTranscodedCacheBudget;
+        /// mTranscodedCacheBytes, mTranscodedCacheEntries & mTranscodedCacheEntryMap
+        /// are protected by mTranscodedCacheMutex
+        size_t                   mTranscodedCacheBytes;
+        TranscodedCacheEntryList mTranscodedCacheEntries;
+        TranscodedCacheEntryMap  mTranscodedCacheEntryMap;
+        LightweightMutex         mTranscodedCacheMutex;
+
         StagingTextureVec mUsedStagingTextures;
         StagingTextureVec mAvailableStagingTextures;
 
@@ -780,6 +822,10 @@ namespace Ogre
         */
         unsigned long _updateTextureMultiLoadWorkerThread( ThreadHandle *threadHandle );
 
+        /// Grabs the next unprocessed index of mPoolTask (if any) and executes it.
+        /// Returns false if there was nothing left to grab.
+        bool executeNextPoolTask();
+
         unsigned long _updateStreamingWorkerThread( ThreadHandle *threadHandle );
 
     protected:
@@ -1057,6 +1103,26 @@ namespace Ogre
         /// Returns false if the entry was not found in the cache
         bool applyMetadataCacheTo( TextureGpu *texture );
 
+        /** Loads data into img, from the transcoded cache if possible. Called from the worker
+            or multiload threads.
+        @param outTranscodedCacheName [out]
+            Name of img's entry in the transcoded cache. Left untouched if the cache is
+            disabled or the image failed to load.
+        @return
+            True if img was loaded from the transcoded cache.
+        */
+        bool loadImage( Image2 &img, DataStreamPtr &data, const LoadRequest &loadRequest,
+                        String &outTranscodedCacheName );
+
+        /// Stores img (after running its filters) in the transcoded cache.
+        /// The entry is written to a temporary file which then gets renamed.
+        void saveToTranscodedCache( Image2 &img, const String &transcodedCacheName );
+
+        /// Removes the least recently used entries from the transcoded cache
+        /// until they take no more than budget bytes.
+        /// Assumes we're protected by mTranscodedCacheMutex!
+        void evictTranscodedCacheEntries( size_t budget );
+
     public:
         void _updateMetadataCache( TextureGpu *texture );
         void _removeMetadataCacheEntry( TextureGpu *texture );
@@ -1126,6 +1192,74 @@ namespace Ogre
         */
         void setMultiLoadPool( uint32 numThreads );
 
+        /** Enables caching textures on disk after they've been decoded and run through their
+            filters (e.g. TextureFilter::PrepareForNormalMapping, mipmap generation, compression).
+            Subsequent loads of the same file with the same filters read the final mip chain
+            directly from the cache (as an OITD file), skipping decoding & filtering.
+        @remarks
+            Entries are keyed by a hash of the source file's contents, the filters, whether
+            the texture prefers sRGB, the version of the cache format and which block
+            compressed formats the RenderSystem supports. Thus stale entries are never used.
+            They are eventually evicted, see setTranscodedCacheBudget.
+            Entries of other cache format versions and temporary files left behind by a crash
+            are deleted when the archive is set.
+
+            The result of some filters depends on the RenderSystem (e.g. whether BC formats
+            are supported). Entries made for a different GPU don't get used, but they count
+            against the budget. Prefer a different archive per RenderSystem/device.
+            Cached images in a format the RenderSystem can't sample from are ignored,
+            and the original file is decoded instead.
+
+            Textures loaded from a ResourceLoadingListener or from an Image2 are not cached.
+            Mipmaps generated on the GPU are not cached and get regenerated every time.
+            Block compressed entries (see TextureFilter::CompressBc) always contain their
+            mipmaps, since they're generated on the CPU before compressing.
+
+            Entries are written to a temporary file and renamed once complete, thus an entry
+            is either fully written or not there at all. Several processes sharing the same
+            archive at the same time is not supported.
+
+            Don't call this function while textures are being loaded.
+        @param archive
+            Writable archive (e.g. a FileSystem archive with read-only = false) where cache
+            entries are stored. It must support Archive::create & Archive::rename.
+            Must remain valid until it is unset.
+            Null to disable the cache (default).
+        */
+        void setTranscodedCacheArchive( Archive *archive );
+        Archive *getTranscodedCacheArchive() const { return mTranscodedCacheArchive; }
+
+        /** Sets the maximum size in bytes of all the entries in the transcoded cache.
+            When saving a new entry would exceed it, the least recently used entries are
+            deleted from the archive. Entries bigger than the budget are not saved.
+        @remarks
+            Recency is tracked while the archive is set. Entries found when setting the
+            archive are ordered by the time they were written.
+            Lowering the budget evicts entries immediately.
+        @param bytes
+            Maximum size in bytes. 0 means unlimited. Default is 1GB.
+        */
+        void   setTranscodedCacheBudget( size_t bytes );
+        size_t getTranscodedCacheBudget() const { return mTranscodedCacheBudget; }
+
+        /// Returns the size in bytes of all the entries in the transcoded cache
+        size_t getTranscodedCacheSize();
+
+        /** Calls task->execute( i, numTasks ) for every i in range [0; numTasks), using the
+            threads from the multiload pool (see setMultiLoadPool) to help the caller.
+        @remarks
+            Blocks until all tasks are done. The caller always takes part in the work.
+            If the pool is disabled or already busy with another task, all tasks are executed
+            serially by the caller.
+            Used by the streaming thread to split expensive work (e.g. software mipmap
+            generation) that would otherwise be executed on a single thread.
+        @param task
+            Task to execute. Must be safe to execute different indices concurrently.
+        @param numTasks
+            Number of pieces the work was split in.
+        */
+        void _executeOnMultiLoadPool( UniformScalableTask *task, uint32 numTasks );
+
         /** Background streaming works by having a bunch of preallocated StagingTextures so
             we're ready to start uploading as soon as we see a request to load a texture
             from file.
@@ -36,8 +36,11 @@ THE SOFTWARE.
 #include "Threading/OgreThreadHeaders.h"
 
 #include "ogrestd/deque.h"
-#include "ogrestd/list.h"
 #include "ogrestd/map.h"
+#include "ogrestd/unordered_map.h"
+#include "ogrestd/vector.h"
+
+#include <atomic>
 
 #include "OgreHeaderPrefix.h"
 
@@ -91,6 +94,7 @@ namespace Ogre
         class _OgreExport Request : public OgreAllocatedObj
         {
             friend class WorkQueue;
+            friend class DefaultWorkQueueBase;
 
         protected:
             /// The request channel, as an integer
@@ -105,10 +109,19 @@ namespace Ogre
             RequestID mID;
             /// Abort Flag
             mutable bool mAborted;
+            /// Requests with a higher priority are started first. See WorkQueue::addPrioritisedRequest
+            int16 mPriority;
+            /// Time (in milliseconds, as in Root::getTimer) by which the request should have
+            /// been started. 0 if it has no deadline.
+            uint64 mDeadline;
+            /// Position in DefaultWorkQueueBase's priority [0] & deadline [1] heaps while
+            /// the request is queued, so it can be removed without searching for it.
+            size_t mHeapIdx[2];
 
         public:
             /// Constructor
-            Request( uint16 channel, uint16 rtype, const Any &rData, uint8 retry, RequestID rid );
+            Request( uint16 channel, uint16 rtype, const Any &rData, uint8 retry, RequestID rid,
+                     int16 priority = 0, uint64 deadline = 0 );
             ~Request();
             /// Set the abort flag
             void abortRequest() const { mAborted = true; }
@@ -124,6 +137,13 @@ namespace Ogre
             RequestID getID() const { return mID; }
             /// Get the abort flag
             bool getAborted() const { return mAborted; }
+            /// Get the scheduling priority. Higher values are started first.
+            int16 getPriority() const { return mPriority; }
+            /// Get the deadline in milliseconds (see Root::getTimer), 0 if none
+            uint64 getDeadline() const { return mDeadline; }
+            /// Changes the priority. Don't call this while the request is queued, see
+            /// WorkQueue::setRequestPriority instead.
+            void _setPriority( int16 priority ) { mPriority = priority; }
         };
 
         /** General purpose response structure.
@@ -138,6 +158,9 @@ namespace Ogre
             String mMessages;
             /// Data associated with the result of the process
             Any mData;
+            /// Intrusive link used by DefaultWorkQueueBase while the response waits
+            /// to be processed. Not for user use.
+            Response *mNext;
 
         public:
             Response( const Request *rq, bool success, const Any &data,
@@ -294,6 +317,52 @@ namespace Ogre
                                       uint8 retryCount = 0, bool forceSynchronous = false,
                                       bool idleThread = false ) = 0;
 
+        /** Add a new request to the queue, with a scheduling priority and an optional deadline.
+        @remarks
+            Requests added via addRequest have priority 0. Among the requests waiting to be
+            processed, the ones with the highest priority are started first; those with the
+            same priority are started in order of deadline, then in order of submission.
+            A request whose deadline has passed is started before any other.
+        @par
+            Responses are also handed to the ResponseHandlers in order of priority; see
+            DefaultWorkQueueBase::setUrgentResponsePriority.
+        @par
+            The default implementation ignores the priority and the deadline.
+        @param priority Higher values are started first.
+        @param deadline Time in milliseconds, as returned by Root::getTimer()->getMilliseconds(),
+            by which the request should have been started. 0 for none.
+        @see addRequest for the rest of the parameters.
+        @return The ID of the request that has been added
+        */
+        virtual RequestID addPrioritisedRequest( uint16 channel, uint16 requestType,
+                                                 const Any &rData, int16 priority,
+                                                 uint64 deadline = 0, uint8 retryCount = 0,
+                                                 bool forceSynchronous = false,
+                                                 bool idleThread = false );
+
+        /** Changes the priority of a request that is still waiting to be processed.
+        @remarks
+            Useful when the relevance of queued work changes (e.g. the camera moved
+            and what was far is now near). Has no effect on requests that have
+            already been started, nor on idle thread requests.
+        @return
+            True if the request was found in the queue and its priority updated.
+            The default implementation always returns false.
+        */
+        virtual bool setRequestPriority( RequestID id, int16 priority );
+
+        /** Removes a request that hasn't been started yet from the queue.
+        @remarks
+            Unlike abortRequest, the request is destroyed immediately and neither the
+            RequestHandler nor the ResponseHandler will ever see it.
+        @return
+            True if the request was removed. False if it wasn't found (e.g. it's already
+            being processed, or has been processed); in that case nothing is done, and
+            the caller may want to use abortRequest instead.
+            The default implementation always returns false.
+        */
+        virtual bool cancelPendingRequest( RequestID id );
+
         /** Abort a previously issued request.
         If the request is still waiting to be processed, it will be
         removed from the queue.
@@ -452,6 +521,15 @@ namespace Ogre
         /// @copydoc WorkQueue::addRequest
         RequestID addRequest( uint16 channel, uint16 requestType, const Any &rData, uint8 retryCount = 0,
                               bool forceSynchronous = false, bool idleThread = false ) override;
+        /// @copydoc WorkQueue::addPrioritisedRequest
+        RequestID addPrioritisedRequest( uint16 channel, uint16 requestType, const Any &rData,
+                                         int16 priority, uint64 deadline = 0, uint8 retryCount = 0,
+                                         bool forceSynchronous = false,
+                                         bool idleThread = false ) override;
+        /// @copydoc WorkQueue::setRequestPriority
+        bool setRequestPriority( RequestID id, int16 priority ) override;
+        /// @copydoc WorkQueue::cancelPendingRequest
+        bool cancelPendingRequest( RequestID id ) override;
         /// @copydoc WorkQueue::abortRequest
         void abortRequest( RequestID id ) override;
         /// @copydoc WorkQueue::abortRequestsByChannel
@@ -475,19 +553,114 @@ namespace Ogre
         /// @copydoc WorkQueue::setResponseProcessingTimeLimit
         void setResponseProcessingTimeLimit( unsigned long ms ) override { mResposeTimeLimitMS = ms; }
 
+        /** Responses whose request has this priority or higher are always processed
+            by processResponses, even once the time limit has been exceeded.
+        @remarks
+            Responses are processed in order of priority, so urgent ones never
+            wait behind a backlog of less important ones.
+            Default is std::numeric_limits<int32>::max(), i.e. no response is urgent.
+        */
+        void  setUrgentResponsePriority( int32 priority ) { mUrgentResponsePriority = priority; }
+        int32 getUrgentResponsePriority() const { return mUrgentResponsePriority; }
+
+        /// Counters to diagnose throughput & contention of the queue. See getStatistics
+        struct Statistics
+        {
+            /// Requests accepted by addRequest
+            uint64 numRequests;
+            /// Responses handed to the ResponseHandlers by processResponses
+            uint64 numResponses;
+            /// Times a worker thread lost the race against another one while
+            /// publishing a response, and had to try again.
+            uint64 numResponsePushRetries;
+            /// Times the RequestHandler list was modified (and thus copied) while
+            /// the queue was running.
+            uint64 numRequestHandlerUpdates;
+            /// Times a thread wanting the request queue (to start, reprioritise or abort
+            /// requests) found another thread already holding or waiting for it.
+            /// Adding requests only needs it when the channel's ring is full.
+            uint64 numRequestLockContentions;
+            /// Times a thread lost the race against another one while pushing a request
+            /// into a channel's ring, and had to try again.
+            uint64 numRequestPushRetries;
+            /// Requests that found their channel's ring full, and had to be added to the
+            /// request queue under its lock instead.
+            uint64 numRequestRingOverflows;
+        };
+
+        /// Returns a snapshot of the counters. Can be called from any thread.
+        Statistics getStatistics() const;
+        void       resetStatistics();
+
     protected:
         String        mName;
         size_t        mWorkerThreadCount;
         bool          mWorkerRenderSystemAccess;
         bool          mIsRunning;
         unsigned long mResposeTimeLimitMS;
+        int32         mUrgentResponsePriority;
 
-        typedef deque<Request *>::type  RequestQueue;
-        typedef deque<Response *>::type ResponseQueue;
+        enum RequestHeapType
+        {
+            /// Highest priority first, then earliest deadline, then oldest.
+            RequestHeapPriority,
+            /// Earliest deadline first, then oldest. Only for requests with a deadline.
+            RequestHeapDeadline
+        };
 
-        RequestQueue  mRequestQueue;   // Guarded by mRequestMutex
-        RequestQueue  mProcessQueue;   // Guarded by mProcessMutex
-        ResponseQueue mResponseQueue;  // Guarded by mResponseMutex
+        typedef deque<Request *>::type                     RequestQueue;
+        /// Binary heap. Each request knows its position (Request::mHeapIdx), so it can be
+        /// removed or re-sorted in O(log n). The vector's memory is reused, so unlike a
+        /// tree it doesn't allocate for every request.
+        typedef vector<Request *>::type                    RequestHeap;
+        typedef unordered_map<RequestID, Request *>::type  QueuedRequestMap;
+        typedef deque<Response *>::type                    ResponseQueue;
+
+        /// Bounded lock-free MPMC queue with the requests of one channel that haven't been
+        /// moved to mRequestQueue yet. Defined in OgreWorkQueue.cpp.
+        struct RequestRing;
+        /// Aborts that processResponses has yet to apply to its queues. Defined in
+        /// OgreWorkQueue.cpp.
+        struct ResponseAbort;
+
+        RequestHeap      mRequestQueue;      // Guarded by mRequestMutex
+        RequestHeap      mRequestDeadlines;  // Subset of mRequestQueue. Guarded by mRequestMutex
+        /// Same requests as mRequestQueue, by ID. Guarded by mRequestMutex
+        QueuedRequestMap mQueuedRequestsById;
+        RequestQueue     mProcessQueue;    // Guarded by mProcessMutex
+        ResponseQueue    mResponseQueue;   // Main thread only
+        /// Responses being processed by processResponses. Main thread only.
+        ResponseQueue mResponseBatch;
+
+        /** One ring per channel that ever got a request, newest first. Rings are added
+            with a CAS and never removed until destruction, so they can be walked without
+            locking. Producers push to them without taking mRequestMutex; whoever holds
+            it moves their requests to mRequestQueue (see drainRequestRings).
+        */
+        std::atomic<RequestRing *> mRequestRings;
+        /// Requests pushed to the rings and not yet moved to mRequestQueue.
+        /// May briefly go below zero, as producers count them after pushing.
+        std::atomic<int32> mNumRingRequests;
+        /// Workers that are about to sleep or are sleeping in waitForNextRequest.
+        std::atomic<uint32> mNumSleepingWorkers;
+
+        /** Responses published by the worker threads, newest first, linked through
+            Response::mNext. Workers push with a CAS and never take a lock;
+            drainPublishedResponses moves them to mResponseQueue in a single exchange.
+        */
+        std::atomic<Response *> mPublishedResponses;
+        /// Published by the abort*() calls the same way. See applyResponseAborts
+        std::atomic<ResponseAbort *> mPublishedResponseAborts;
+
+        std::atomic<uint64> mNumRequests;
+        std::atomic<uint64> mNumResponses;
+        std::atomic<uint64> mNumResponsePushRetries;
+        std::atomic<uint64> mNumRequestHandlerUpdates;
+        std::atomic<uint64> mNumRequestLockContentions;
+        std::atomic<uint64> mNumRequestPushRetries;
+        std::atomic<uint64> mNumRequestRingOverflows;
+        /// Threads holding or waiting for mRequestMutex. See numRequestLockContentions
+        std::atomic<uint32> mRequestMutexUsers;
 
         /// Thread function
         struct _OgreExport WorkerFunc OGRE_THREAD_WORKER_INHERIT
@@ -552,14 +725,18 @@ namespace Ogre
         // Hold these by shared pointer so they can be copied keeping same instance
         typedef SharedPtr<RequestHandlerHolder> RequestHandlerHolderPtr;
 
-        typedef list<RequestHandlerHolderPtr>::type    RequestHandlerList;
-        typedef list<ResponseHandler *>::type          ResponseHandlerList;
-        typedef map<uint16, RequestHandlerList>::type  RequestHandlerListByChannel;
-        typedef map<uint16, ResponseHandlerList>::type ResponseHandlerListByChannel;
-
-        RequestHandlerListByChannel  mRequestHandlers;
-        ResponseHandlerListByChannel mResponseHandlers;
-        RequestID                    mRequestCount;  // Guarded by mRequestMutex
+        typedef vector<RequestHandlerHolderPtr>::type   RequestHandlerList;
+        typedef vector<ResponseHandler *>::type         ResponseHandlerList;
+        typedef map<uint16, RequestHandlerList>::type   RequestHandlerListByChannel;
+        typedef map<uint16, ResponseHandlerList>::type  ResponseHandlerListByChannel;
+        typedef SharedPtr<RequestHandlerListByChannel> RequestHandlerListByChannelPtr;
+
+        /// Copy on write. Adding or removing a handler replaces the whole map, so worker
+        /// threads only need to grab a reference to it (under mRequestHandlerMutex)
+        /// instead of copying it for every request. Never null.
+        RequestHandlerListByChannelPtr mRequestHandlers;
+        ResponseHandlerListByChannel   mResponseHandlers;
+        std::atomic<RequestID>         mRequestCount;
         bool                         mPaused;
         bool                         mAcceptRequests;
         bool                         mShuttingDown;
@@ -572,23 +749,74 @@ namespace Ogre
         OGRE_MUTEX( mIdleMutex );
         OGRE_MUTEX( mRequestMutex );
         OGRE_MUTEX( mProcessMutex );
-        OGRE_MUTEX( mResponseMutex );
         OGRE_RW_MUTEX( mRequestHandlerMutex );
 
         void      processRequestResponse( Request *r, bool synchronous );
         Response *processRequest( Request *r );
         void      processResponse( Response *r );
+        /// Lock-free. Can be called from any thread.
+        void publishResponse( Response *r );
+        /// Moves the responses published by workers to the back of mResponseQueue, in the
+        /// order they were published. Main thread only.
+        void drainPublishedResponses();
+        /// Lock-free. Can be called from any thread. Caller must hold mProcessMutex, so
+        /// that no worker publishes a response for an aborted request afterwards.
+        void publishResponseAbort( ResponseAbort *abort );
+        /** Raises the abort flag of the queued responses matching the published aborts.
+            Main thread only.
+        @remarks
+            Drains the published responses after taking the aborts, so that any response
+            published before an abort gets to see it.
+        */
+        void applyResponseAborts();
+        /// Highest priority first, from responses[first] onwards. Main thread only.
+        static void sortResponsesByPriority( ResponseQueue &responses, size_t first );
+        /// Whether LML_TRIVIAL messages would be logged; avoids formatting them otherwise.
+        static bool isTraceLogEnabled();
         /// Notify workers about a new request.
         virtual void notifyWorkers() = 0;
         /// Put a Request on the queue with a specific RequestID.
         void addRequestWithRID( RequestID rid, uint16 channel, uint16 requestType, const Any &rData,
-                                uint8 retryCount );
+                                uint8 retryCount, int16 priority, uint64 deadline );
+        /// Returns the ring of the given channel, creating it if needed. Lock-free.
+        RequestRing *getRequestRing( uint16 channel );
+        /// Pushes the request to its channel's ring, without locking. If the ring is full,
+        /// locks mRequestMutex and queues it directly.
+        void pushRequest( Request *req );
+        /// Moves the requests in the rings to mRequestQueue. Caller must hold mRequestMutex.
+        void drainRequestRings();
+        /// Caller must hold mRequestMutex.
+        void queueRequest( Request *req );
+        /// Removes & returns the request that should be started next, 0 if the queue is
+        /// empty. Caller must hold mRequestMutex.
+        Request *dequeueNextRequest();
+        /// Returns the queued request with the given ID, 0 if it's not in mRequestQueue.
+        /// Caller must hold mRequestMutex.
+        Request *findQueuedRequest( RequestID id ) const;
+        /// Removes the request from mRequestQueue & mRequestDeadlines without deleting it.
+        /// Caller must hold mRequestMutex.
+        void unqueueRequest( Request *req );
+
+        /// True if a must be started before b, according to the heap's order.
+        static bool requestGoesFirst( RequestHeapType heapType, const Request *a,
+                                      const Request *b );
+        static void requestHeapPush( RequestHeap &heap, RequestHeapType heapType, Request *req );
+        static void requestHeapErase( RequestHeap &heap, RequestHeapType heapType, size_t idx );
+        /// Restores the heap property after heap[idx]'s key changed.
+        static void requestHeapUpdate( RequestHeap &heap, RequestHeapType heapType, size_t idx );
+        static void requestHeapSet( RequestHeap &heap, RequestHeapType heapType, size_t idx,
+                                    Request *req );
 
         RequestQueue mIdleRequestQueue;   // Guarded by mIdleMutex
         bool         mIdleThreadRunning;  // Guarded by mIdleMutex
         Request     *mIdleProcessed;      // Guarded by mProcessMutex
 
         bool processIdleRequests();
+
+        /// Index of the next response in mResponseBatch. Main thread only.
+        size_t mNextBatchResponse;
+        /// Number of nested processResponses calls. Main thread only.
+        uint32 mResponseProcessingDepth;
     };
 
     /** @} */
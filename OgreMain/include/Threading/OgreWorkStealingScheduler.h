@@ -0,0 +1,108 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreWorkStealingScheduler_H_
+#define _OgreWorkStealingScheduler_H_
+
+#include "OgrePrerequisites.h"
+
+#include <atomic>
+
+namespace Ogre
+{
+    /** Distributes a set of N independent chunks of work (i.e. ranges of ObjectData or Nodes)
+        across a fixed number of threads, with load balancing.
+    @remarks
+        Each thread initially owns a contiguous range of chunks (its 'deque'). It pops chunks
+        from the front of its own range; and once it runs out it steals chunks from the back
+        of the ranges owned by other threads. This way a slow slice (e.g. a render queue
+        with expensive objects) no longer stalls every other thread while they idle at the
+        Barrier.
+    @par
+        Each range is packed into a single 64-bit atomic, so popping and stealing are both
+        a single CAS and no locks are involved.
+    @par
+        reset() must only be called while no thread is calling getNextChunk, i.e. from the
+        main thread before firing the worker threads (the Barrier provides the needed
+        memory ordering).
+    */
+    class _OgreExport WorkStealingScheduler
+    {
+        static const size_t c_cacheLineSize = 64u;
+
+        struct ThreadQueue
+        {
+            /// Low 32 bits = first chunk (inclusive). High 32 bits = last chunk (exclusive).
+            std::atomic<uint64> range;
+            /// Number of chunks this thread took away from other threads. For profiling.
+            size_t numSteals;
+            /// Avoid false sharing. mQueues is allocated aligned to c_cacheLineSize,
+            /// so each ThreadQueue spans exactly one cache line.
+            uint8 padding[c_cacheLineSize - sizeof( std::atomic<uint64> ) - sizeof( size_t )];
+        };
+
+        ThreadQueue *mQueues;
+        size_t       mNumThreads;
+        uint32       mNumChunks;
+
+        static uint64 packRange( uint32 begin, uint32 end )
+        {
+            return uint64( begin ) | ( uint64( end ) << 32u );
+        }
+
+    public:
+        WorkStealingScheduler( size_t numThreads );
+        ~WorkStealingScheduler();
+
+        /** Evenly assigns the chunks [0; numChunks) to each thread, as contiguous ranges.
+            All steal counters are reset as well.
+        @remarks
+            Not thread safe. See class remarks.
+        */
+        void reset( size_t numChunks );
+
+        /** Retrieves the next chunk of work the given thread must process.
+        @param threadIdx
+            Index of the thread calling this function. Must be unique for each thread
+            and in range [0; numThreads)
+        @param outChunkIdx [out]
+            Index of the chunk to process, in range [0; numChunks)
+        @return
+            False if there is no more work left (in any thread). True otherwise.
+        */
+        bool getNextChunk( size_t threadIdx, size_t &outChunkIdx );
+
+        size_t getNumThreads() const { return mNumThreads; }
+        size_t getNumChunks() const { return mNumChunks; }
+
+        /// Returns the total number of chunks that were stolen since the last reset.
+        size_t getNumSteals() const;
+    };
+}  // namespace Ogre
+
+#endif
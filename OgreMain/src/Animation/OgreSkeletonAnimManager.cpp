@@ -38,7 +38,8 @@ namespace Ogre
 {
     BySkeletonDef::BySkeletonDef( const SkeletonDef *_skeletonDef, size_t threadCount ) :
         skeletonDef( _skeletonDef ),
-        skeletonDefName( _skeletonDef->getNameStr() )
+        skeletonDefName( _skeletonDef->getNameStr() ),
+        nextUpdateFrameOffset( 0u )
     {
         threadStarts.resize( threadCount + 1, 0 );
     }
@@ -85,6 +86,8 @@ namespace Ogre
         }
     }
 
+    //-----------------------------------------------------------------------
+    SkeletonAnimManager::SkeletonAnimManager() : frameIdx( 0u ) {}
     //-----------------------------------------------------------------------
     SkeletonInstance *SkeletonAnimManager::createSkeletonInstance( const SkeletonDef *skeletonDef,
                                                                    size_t numWorkerThreads )
@@ -103,6 +106,7 @@ namespace Ogre
         FastArray<SkeletonInstance *> &skeletonsArray = bySkelDef.skeletons;
         SkeletonInstance *newInstance =
             OGRE_NEW SkeletonInstance( skeletonDef, &bySkelDef.boneMemoryManager );
+        newInstance->_setUpdateFrameOffset( bySkelDef.nextUpdateFrameOffset++ );
         FastArray<SkeletonInstance *>::iterator it = std::lower_bound(
             skeletonsArray.begin(), skeletonsArray.end(), newInstance, OrderSkeletonInstanceByMemory );
 
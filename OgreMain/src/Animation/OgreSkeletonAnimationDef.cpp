@@ -47,7 +47,9 @@ namespace Ogre
         mNumFrames( 0 ),
         mOriginalFrameRate( 25.0f ),
         mSkeletonDef( 0 ),
-        mKfTransformMemoryManager( 0 )
+        mKfTransformMemoryManager( 0 ),
+        mCompressedTrackData( 0 ),
+        mCompressedTrackDataSize( 0 )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -61,6 +63,13 @@ namespace Ogre
             delete mKfTransformMemoryManager;
             mKfTransformMemoryManager = 0;
         }
+
+        if( mCompressedTrackData )
+        {
+            OGRE_FREE_SIMD( mCompressedTrackData, MEMCATEGORY_ANIMATION );
+            mCompressedTrackData = 0;
+            mCompressedTrackDataSize = 0;
+        }
     }
     //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::build( const v1::Skeleton *skeleton, const v1::Animation *animation,
@@ -382,6 +391,86 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonAnimationDef::compressTracks( Real constantThreshold )
+    {
+        if( mCompressedTrackData || mTracks.empty() )
+            return;
+
+        const size_t rangesSize =
+            alignToNextMultiple<size_t>( sizeof( CompressedTrackRanges ), OGRE_SIMD_ALIGNMENT );
+
+        // 1st pass: Find out which channels are constant, and how much memory we need
+        vector<uint8>::type constantChannels;
+        constantChannels.reserve( mTracks.size() );
+
+        size_t totalSize = 0;
+        SkeletonTrackVec::const_iterator itor = mTracks.begin();
+        SkeletonTrackVec::const_iterator endt = mTracks.end();
+
+        while( itor != endt )
+        {
+            constantChannels.push_back( itor->_findConstantChannels( constantThreshold ) );
+            const size_t keyFramesSize =
+                SkeletonTrack::calculateCompressedStride( constantChannels.back() ) *
+                itor->getKeyFrames().size() * sizeof( int16 );
+            totalSize += rangesSize +
+                         alignToNextMultiple<size_t>( keyFramesSize, OGRE_SIMD_ALIGNMENT );
+            ++itor;
+        }
+
+        mCompressedTrackData =
+            reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( totalSize, MEMCATEGORY_ANIMATION ) );
+        mCompressedTrackDataSize = totalSize;
+
+        // 2nd pass: Compress. Each track's ranges are followed by its keyframes
+        uint8 *dataPtr = mCompressedTrackData;
+        vector<uint8>::type::const_iterator itConstant = constantChannels.begin();
+        SkeletonTrackVec::iterator itTrack = mTracks.begin();
+        SkeletonTrackVec::iterator enTrack = mTracks.end();
+
+        while( itTrack != enTrack )
+        {
+            CompressedTrackRanges *ranges = reinterpret_cast<CompressedTrackRanges *>( dataPtr );
+            int16 *keyFrameData = reinterpret_cast<int16 *>( dataPtr + rangesSize );
+
+            const size_t keyFramesSize = SkeletonTrack::calculateCompressedStride( *itConstant ) *
+                                         itTrack->getKeyFrames().size() * sizeof( int16 );
+
+            itTrack->_compress( *itConstant, ranges, keyFrameData );
+
+            dataPtr += rangesSize + alignToNextMultiple<size_t>( keyFramesSize, OGRE_SIMD_ALIGNMENT );
+            ++itConstant;
+            ++itTrack;
+        }
+
+        // The uncompressed keyframes are no longer referenced by any track
+        if( mKfTransformMemoryManager )
+        {
+            mKfTransformMemoryManager->destroy();
+            delete mKfTransformMemoryManager;
+            mKfTransformMemoryManager = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonAnimationDef::getKeyFrameMemoryUsage() const
+    {
+        size_t memoryUsage = mCompressedTrackDataSize;
+
+        SkeletonTrackVec::const_iterator itor = mTracks.begin();
+        SkeletonTrackVec::const_iterator endt = mTracks.end();
+
+        while( itor != endt )
+        {
+            const size_t numKeyFrames = itor->getKeyFrames().size();
+            memoryUsage += numKeyFrames * sizeof( KeyFrameRig );
+            if( !itor->isCompressed() )
+                memoryUsage += numKeyFrames * sizeof( KfTransform );
+            ++itor;
+        }
+
+        return memoryUsage;
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::_dumpCsvTracks( String &outText ) const
     {
         const SkeletonDef::BoneDataVec &mBones = mSkeletonDef->getBones();
@@ -419,14 +508,12 @@ namespace Ogre
                         outText += StringConverter::toString( itKeyFrames->mFrame );
                         outText += ",";
 
-                        const KfTransform *RESTRICT_ALIAS boneTransform = itKeyFrames->mBoneTransform;
-
                         Vector3 vPos, vScale;
                         Quaternion qRot;
 
-                        boneTransform->mPosition.getAsVector3( vPos, i );
-                        boneTransform->mOrientation.getAsQuaternion( qRot, i );
-                        boneTransform->mScale.getAsVector3( vScale, i );
+                        track.getKeyFrameTransform(
+                            static_cast<size_t>( itKeyFrames - keyFrames.begin() ), i, vPos, qRot,
+                            vScale );
 
                         outText += StringConverter::toString( vPos.x ) + ",";
                         outText += StringConverter::toString( vPos.y ) + ",";
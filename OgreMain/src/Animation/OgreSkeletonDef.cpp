@@ -325,6 +325,18 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonDef::compressAnimations( Real constantThreshold )
+    {
+        SkeletonAnimationDefVec::iterator itor = mAnimationDefs.begin();
+        SkeletonAnimationDefVec::iterator endt = mAnimationDefs.end();
+
+        while( itor != endt )
+        {
+            itor->compressTracks( constantThreshold );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     size_t SkeletonDef::getNumberOfBoneBlocks( size_t numLevels ) const
     {
         size_t numBlocks = 0;
@@ -49,7 +49,15 @@ namespace Ogre
                                         BoneMemoryManager *boneMemoryManager ) :
         mDefinition( skeletonDef ),
         mParentNode( 0 ),
-        mRefCount( 1 )
+        mRefCount( 1 ),
+        mUpdateInterval( 1u ),
+        mUpdateFrameOffset( 0u ),
+        mInterpolateSkippedFrames( false ),
+        mLodPosesValid( false ),
+        mLodValue( -std::numeric_limits<Real>::max() ),
+        mPendingLodValue( std::numeric_limits<Real>::max() ),
+        mAnimationLodTiers( 0 ),
+        mSharedPoseSource( 0 )
     {
         mBones.resize( mDefinition->getBones().size(), Bone() );
 
@@ -192,6 +200,19 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     SkeletonInstance::~SkeletonInstance()
     {
+        setSharedPoseSource( 0 );
+
+        {
+            FastArray<SkeletonInstance *>::const_iterator itor = mSharedPoseFollowers.begin();
+            FastArray<SkeletonInstance *>::const_iterator endt = mSharedPoseFollowers.end();
+            while( itor != endt )
+            {
+                ( *itor )->mSharedPoseSource = 0;
+                ++itor;
+            }
+            mSharedPoseFollowers.clear();
+        }
+
         {
             SceneNodeBonePairVec::iterator itor = mCustomParentSceneNodes.begin();
             SceneNodeBonePairVec::iterator endt = mCustomParentSceneNodes.end();
@@ -253,6 +274,297 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonInstance::_updateThrottled( uint32 frameIdx )
+    {
+        // Take what the LOD passes calculated since our last update.
+        // If we weren't seen at all, keep the previous value.
+        const Real pendingLodValue =
+            mPendingLodValue.exchange( std::numeric_limits<Real>::max(), std::memory_order_relaxed );
+        if( pendingLodValue != std::numeric_limits<Real>::max() )
+            mLodValue = pendingLodValue;
+
+        if( mSharedPoseSource )
+        {
+            // Read what the source wrote in the previous frame
+            const size_t numBlocks = mSharedPoseSource->mSharedPoses.size() >> 1u;
+            applyPose( mSharedPoseSource->mSharedPoses.get() +
+                       ( ( frameIdx + 1u ) & 0x01u ) * numBlocks );
+            return;
+        }
+
+        updateOwnPose( frameIdx );
+
+        if( !mSharedPoseFollowers.empty() )
+        {
+            const size_t numBlocks = mSharedPoses.size() >> 1u;
+            savePose( mSharedPoses.get() + ( frameIdx & 0x01u ) * numBlocks, true );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::updateOwnPose( uint32 frameIdx )
+    {
+        const uint8 updateInterval = getCurrentUpdateInterval();
+
+        if( updateInterval == 1u )
+        {
+            mLodPosesValid = false;
+            update();
+            return;
+        }
+
+        if( updateInterval == 0u )
+            return;  // Frozen
+
+        const uint32 phase = ( frameIdx + mUpdateFrameOffset ) % updateInterval;
+
+        if( !mInterpolateSkippedFrames )
+        {
+            if( phase == 0u )
+                update();
+            return;
+        }
+
+        const size_t numBlocks =
+            mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+
+        if( phase == 0u || !mLodPosesValid )
+        {
+            update();
+
+            // Sampled pose becomes the target, and we start from the previous one
+            // (or from this one if we had none)
+            KfTransform *RESTRICT_ALIAS prevPose = mLodPoses.get();
+            KfTransform *RESTRICT_ALIAS nextPose = mLodPoses.get() + numBlocks;
+            if( mLodPosesValid )
+                std::copy( nextPose, nextPose + numBlocks, prevPose );
+            savePose( nextPose, false );
+            if( !mLodPosesValid )
+                std::copy( nextPose, nextPose + numBlocks, prevPose );
+            mLodPosesValid = true;
+        }
+
+        blendLodPoses( Real( phase ) / Real( updateInterval ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::savePose( KfTransform *RESTRICT_ALIAS outPose,
+                                     bool replicateSharedBlocks ) const
+    {
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::const_iterator itor = mBoneStartTransforms.begin();
+        TransformArray::const_iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            const size_t numBonesInLevel = itDepthLevelInfo->numBonesInLevel;
+
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                outPose->mPosition = *t.mPosition;
+                outPose->mOrientation = *t.mOrientation;
+                outPose->mScale = *t.mScale;
+
+                if( replicateSharedBlocks && numBonesInLevel <= ( ARRAY_PACKED_REALS >> 1u ) )
+                {
+                    // Our bones start at slot t.mIndex (a multiple of numBonesInLevel).
+                    // Repeat them so slot j contains bone j % numBonesInLevel
+                    for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                    {
+                        const size_t srcSlot = t.mIndex + j % numBonesInLevel;
+                        if( srcSlot != j )
+                        {
+                            Vector3 vTmp;
+                            Quaternion qTmp;
+                            t.mPosition->getAsVector3( vTmp, srcSlot );
+                            outPose->mPosition.setFromVector3( vTmp, j );
+                            t.mOrientation->getAsQuaternion( qTmp, srcSlot );
+                            outPose->mOrientation.setFromQuaternion( qTmp, j );
+                            t.mScale->getAsVector3( vTmp, srcSlot );
+                            outPose->mScale.setFromVector3( vTmp, j );
+                        }
+                    }
+                }
+
+                t.advancePack();
+                ++outPose;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::blendLodPoses( Real weight )
+    {
+        const size_t numBlocks =
+            mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+
+        KfTransform const *RESTRICT_ALIAS prevPose = mLodPoses.get();
+        KfTransform const *RESTRICT_ALIAS nextPose = mLodPoses.get() + numBlocks;
+        ArrayReal const *RESTRICT_ALIAS manualBones = mManualBones.get();
+
+        const ArrayReal simdWeight = Mathlib::SetAll( weight );
+
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::iterator itor = mBoneStartTransforms.begin();
+        TransformArray::iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < itDepthLevelInfo->numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                // Manual bones and slots that belong to other instances are left untouched
+                const ArrayVector3 interpPos =
+                    Math::lerp( prevPose->mPosition, nextPose->mPosition, simdWeight );
+                const ArrayQuaternion interpRot = ArrayQuaternion::nlerpShortest(
+                    simdWeight, prevPose->mOrientation, nextPose->mOrientation );
+                const ArrayVector3 interpScale =
+                    Math::lerp( prevPose->mScale, nextPose->mScale, simdWeight );
+
+                *t.mPosition = Math::lerp( *t.mPosition, interpPos, *manualBones );
+                *t.mOrientation = Math::lerp( *t.mOrientation, interpRot, *manualBones );
+                *t.mScale = Math::lerp( *t.mScale, interpScale, *manualBones );
+                t.advancePack();
+
+                ++prevPose;
+                ++nextPose;
+                ++manualBones;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::applyPose( const KfTransform *RESTRICT_ALIAS pose )
+    {
+        ArrayReal const *RESTRICT_ALIAS manualBones = mManualBones.get();
+
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::iterator itor = mBoneStartTransforms.begin();
+        TransformArray::iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < itDepthLevelInfo->numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                *t.mPosition = Math::lerp( *t.mPosition, pose->mPosition, *manualBones );
+                *t.mOrientation = Math::lerp( *t.mOrientation, pose->mOrientation, *manualBones );
+                *t.mScale = Math::lerp( *t.mScale, pose->mScale, *manualBones );
+                t.advancePack();
+
+                ++pose;
+                ++manualBones;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setSharedPoseSource( SkeletonInstance *source )
+    {
+        if( source == mSharedPoseSource )
+            return;
+
+        if( source )
+        {
+            if( source->mDefinition != mDefinition || source == this ||
+                source->mSharedPoseSource || !mSharedPoseFollowers.empty() )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                             "Source must use the same SkeletonDef, and neither this instance nor "
+                             "the source can be following another instance's pose",
+                             "SkeletonInstance::setSharedPoseSource" );
+            }
+        }
+
+        if( mSharedPoseSource )
+        {
+            FastArray<SkeletonInstance *> &followers = mSharedPoseSource->mSharedPoseFollowers;
+            FastArray<SkeletonInstance *>::iterator itor =
+                std::find( followers.begin(), followers.end(), this );
+            if( itor != followers.end() )
+                efficientVectorRemove( followers, itor );
+
+            if( followers.empty() )
+            {
+                RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> emptyPtr;
+                mSharedPoseSource->mSharedPoses.swap( emptyPtr );
+            }
+        }
+
+        mSharedPoseSource = source;
+
+        if( source )
+        {
+            if( source->mSharedPoseFollowers.empty() )
+            {
+                // Fill both buffers so followers get a valid pose right away
+                const size_t numBlocks =
+                    mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+                RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> sharedPoses( numBlocks * 2u );
+                source->mSharedPoses.swap( sharedPoses );
+                source->savePose( source->mSharedPoses.get(), true );
+                source->savePose( source->mSharedPoses.get() + numBlocks, true );
+            }
+            source->mSharedPoseFollowers.push_back( this );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setUpdateInterval( uint8 updateInterval )
+    {
+        mUpdateInterval = updateInterval;
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setAnimationLodTiers( const AnimationLodTierArray *tiers )
+    {
+        mAnimationLodTiers = tiers;
+    }
+    //-----------------------------------------------------------------------------------
+    uint8 SkeletonInstance::getCurrentUpdateInterval() const
+    {
+        if( !mAnimationLodTiers || mAnimationLodTiers->empty() )
+            return mUpdateInterval;
+
+        // Same criteria as LodStrategy::lodSet. There are only a few tiers
+        AnimationLodTierArray::const_iterator itor = mAnimationLodTiers->begin();
+        AnimationLodTierArray::const_iterator endt = mAnimationLodTiers->end();
+        AnimationLodTierArray::const_iterator selected = itor;
+
+        while( itor != endt && itor->lodValue < mLodValue )
+            selected = itor++;
+
+        return selected->updateInterval;
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setInterpolateSkippedFrames( bool bInterpolate )
+    {
+        mInterpolateSkippedFrames = bInterpolate;
+        mLodPosesValid = false;
+
+        if( bInterpolate && !mLodPoses.get() )
+        {
+            const size_t numBlocks =
+                mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+            RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> lodPoses( numBlocks * 2u );
+            mLodPoses.swap( lodPoses );
+        }
+        else if( !bInterpolate && mLodPoses.get() )
+        {
+            RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> emptyPtr;
+            mLodPoses.swap( emptyPtr );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonInstance::resetToPose()
     {
         KfTransform const *RESTRICT_ALIAS bindPose = mDefinition->getBindPose();
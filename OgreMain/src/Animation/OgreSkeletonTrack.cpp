@@ -43,7 +43,11 @@ namespace Ogre
         mNumFrames( 0 ),
         mBoneBlockIdx( boneBlockIdx ),
         mUsedSlots( 0 ),
-        mLocalMemoryManager( kfTransformMemoryManager )
+        mLocalMemoryManager( kfTransformMemoryManager ),
+        mCompressedRanges( 0 ),
+        mCompressedKeyFrames( 0 ),
+        mCompressedStride( 0 ),
+        mConstantChannels( 0 )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -54,6 +58,7 @@ namespace Ogre
     void SkeletonTrack::addKeyFrame( Real timestamp, Real frameRate )
     {
         assert( mKeyFrameRigs.empty() || timestamp > mKeyFrameRigs.back().mFrame );
+        assert( !isCompressed() && "Can't add keyframes to a compressed track" );
 
         mKeyFrameRigs.push_back( KeyFrameRig() );
         KeyFrameRig &keyFrame = mKeyFrameRigs.back();
@@ -83,6 +88,12 @@ namespace Ogre
                          "SkeletonTrack::setKeyFrameTransform" );
         }
 
+        if( isCompressed() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Can't modify a compressed track.",
+                         "SkeletonTrack::setKeyFrameTransform" );
+        }
+
         itor->mBoneTransform->mPosition.setFromVector3( vPos, slot );
         itor->mBoneTransform->mOrientation.setFromQuaternion( qRot, slot );
         itor->mBoneTransform->mScale.setFromVector3( vScale, slot );
@@ -112,6 +123,49 @@ namespace Ogre
         outNextFrame = nextFrame;
     }
     //-----------------------------------------------------------------------------------
+    inline void SkeletonTrack::decodeKeyFrame( size_t keyFrameIdx, KfTransform &outTransform ) const
+    {
+        const int16 *RESTRICT_ALIAS src = mCompressedKeyFrames + keyFrameIdx * mCompressedStride;
+
+        if( mConstantChannels & ChannelPosition )
+            outTransform.mPosition = mCompressedRanges->mPositionCentre;
+        else
+        {
+            const ArrayVector3 quantised( Mathlib::Int16ToReal( src ),
+                                          Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS ),
+                                          Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS * 2u ) );
+            outTransform.mPosition =
+                quantised * mCompressedRanges->mPositionScale + mCompressedRanges->mPositionCentre;
+            src += ARRAY_PACKED_REALS * 3u;
+        }
+
+        if( mConstantChannels & ChannelOrientation )
+            outTransform.mOrientation = mCompressedRanges->mOrientation;
+        else
+        {
+            const ArrayQuaternion quantised( Mathlib::Int16ToReal( src ),
+                                             Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS ),
+                                             Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS * 2u ),
+                                             Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS * 3u ) );
+            // Each component was rounded on its own, thus the result is slightly off unit
+            // length. Normalising also takes care of the 1 / 32767 dequantisation scale.
+            outTransform.mOrientation = quantised;
+            outTransform.mOrientation.normalise();
+            src += ARRAY_PACKED_REALS * 4u;
+        }
+
+        if( mConstantChannels & ChannelScale )
+            outTransform.mScale = mCompressedRanges->mScaleCentre;
+        else
+        {
+            const ArrayVector3 quantised( Mathlib::Int16ToReal( src ),
+                                          Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS ),
+                                          Mathlib::Int16ToReal( src + ARRAY_PACKED_REALS * 2u ) );
+            outTransform.mScale =
+                quantised * mCompressedRanges->mScaleScale + mCompressedRanges->mScaleCentre;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonTrack::applyKeyFrameRigAt( KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrameRig,
                                             float frame, ArrayReal animWeight,
                                             const ArrayReal *RESTRICT_ALIAS perBoneWeights,
@@ -131,8 +185,19 @@ namespace Ogre
         ArrayVector3 *RESTRICT_ALIAS finalScale = boneTransforms[level].mScale + offset;
         ArrayQuaternion *RESTRICT_ALIAS finalRot = boneTransforms[level].mOrientation + offset;
 
-        KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
-        KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+        const KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
+        const KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+
+        KfTransform decodedTransf[2];
+        if( mCompressedRanges )
+        {
+            decodeKeyFrame( static_cast<size_t>( prevFrame - mKeyFrameRigs.begin() ),
+                            decodedTransf[0] );
+            decodeKeyFrame( static_cast<size_t>( nextFrame - mKeyFrameRigs.begin() ),
+                            decodedTransf[1] );
+            prevTransf = &decodedTransf[0];
+            nextTransf = &decodedTransf[1];
+        }
 
         ArrayVector3 interpPos, interpScale;
         ArrayQuaternion interpRot;
@@ -185,4 +250,219 @@ namespace Ogre
             }
         }
     }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::getKeyFrameTransform( size_t keyFrameIdx, size_t slot, Vector3 &outPos,
+                                              Quaternion &outRot, Vector3 &outScale ) const
+    {
+        assert( keyFrameIdx < mKeyFrameRigs.size() && slot < ARRAY_PACKED_REALS );
+
+        const KfTransform *transform = mKeyFrameRigs[keyFrameIdx].mBoneTransform;
+
+        KfTransform decodedTransf;
+        if( mCompressedRanges )
+        {
+            decodeKeyFrame( keyFrameIdx, decodedTransf );
+            transform = &decodedTransf;
+        }
+
+        transform->mPosition.getAsVector3( outPos, slot );
+        transform->mOrientation.getAsQuaternion( outRot, slot );
+        transform->mScale.getAsVector3( outScale, slot );
+    }
+    //-----------------------------------------------------------------------------------
+    uint8 SkeletonTrack::_findConstantChannels( Real threshold ) const
+    {
+        assert( !isCompressed() );
+
+        uint8 constantChannels = ChannelPosition | ChannelOrientation | ChannelScale;
+
+        if( mKeyFrameRigs.empty() )
+            return constantChannels;
+
+        const KfTransform *firstTransf = mKeyFrameRigs.front().mBoneTransform;
+
+        KeyFrameRigVec::const_iterator itor = mKeyFrameRigs.begin() + 1;
+        KeyFrameRigVec::const_iterator endt = mKeyFrameRigs.end();
+
+        while( itor != endt && constantChannels )
+        {
+            for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+            {
+                Vector3 vFirst, vTmp;
+                Quaternion qFirst, qTmp;
+
+                firstTransf->mPosition.getAsVector3( vFirst, i );
+                itor->mBoneTransform->mPosition.getAsVector3( vTmp, i );
+                if( !vFirst.positionEquals( vTmp, threshold ) )
+                    constantChannels &= ~ChannelPosition;
+
+                firstTransf->mOrientation.getAsQuaternion( qFirst, i );
+                itor->mBoneTransform->mOrientation.getAsQuaternion( qTmp, i );
+                if( Math::Abs( qFirst.w - qTmp.w ) > threshold ||
+                    Math::Abs( qFirst.x - qTmp.x ) > threshold ||
+                    Math::Abs( qFirst.y - qTmp.y ) > threshold ||
+                    Math::Abs( qFirst.z - qTmp.z ) > threshold )
+                {
+                    constantChannels &= ~ChannelOrientation;
+                }
+
+                firstTransf->mScale.getAsVector3( vFirst, i );
+                itor->mBoneTransform->mScale.getAsVector3( vTmp, i );
+                if( !vFirst.positionEquals( vTmp, threshold ) )
+                    constantChannels &= ~ChannelScale;
+            }
+            ++itor;
+        }
+
+        return constantChannels;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonTrack::calculateCompressedStride( uint8 constantChannels )
+    {
+        size_t numComponents = 0;
+        if( !( constantChannels & ChannelPosition ) )
+            numComponents += 3u;
+        if( !( constantChannels & ChannelOrientation ) )
+            numComponents += 4u;
+        if( !( constantChannels & ChannelScale ) )
+            numComponents += 3u;
+        return numComponents * ARRAY_PACKED_REALS;
+    }
+    //-----------------------------------------------------------------------------------
+    /** Calculates the centre and the dequantisation scale of each component of an
+        ArrayVector3 member across all keyframes; then quantises the keyframes.
+    */
+    static void quantiseVector3Channel( const KeyFrameRigVec &keyFrameRigs,
+                                        ArrayVector3 KfTransform::*member, ArrayVector3 &outCentre,
+                                        ArrayVector3 &outScale, int16 *RESTRICT_ALIAS dst,
+                                        size_t stride )
+    {
+        Vector3 vMin[ARRAY_PACKED_REALS];
+        Vector3 vMax[ARRAY_PACKED_REALS];
+        for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+        {
+            vMin[i] = Vector3( std::numeric_limits<Real>::max() );
+            vMax[i] = Vector3( -std::numeric_limits<Real>::max() );
+        }
+
+        KeyFrameRigVec::const_iterator itor = keyFrameRigs.begin();
+        KeyFrameRigVec::const_iterator endt = keyFrameRigs.end();
+
+        while( itor != endt )
+        {
+            for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+            {
+                Vector3 vTmp;
+                ( itor->mBoneTransform->*member ).getAsVector3( vTmp, i );
+                vMin[i].makeFloor( vTmp );
+                vMax[i].makeCeil( vTmp );
+            }
+            ++itor;
+        }
+
+        Vector3 invScale[ARRAY_PACKED_REALS];
+        for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+        {
+            const Vector3 centre = ( vMin[i] + vMax[i] ) * 0.5f;
+            const Vector3 scale = ( vMax[i] - vMin[i] ) * ( 0.5f / 32767.0f );
+            for( size_t j = 0; j < 3u; ++j )
+                invScale[i][j] = scale[j] > 0.0f ? ( 1.0f / scale[j] ) : 0.0f;
+            outCentre.setFromVector3( centre, i );
+            outScale.setFromVector3( scale, i );
+        }
+
+        itor = keyFrameRigs.begin();
+        while( itor != endt )
+        {
+            for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+            {
+                Vector3 vTmp, centre;
+                ( itor->mBoneTransform->*member ).getAsVector3( vTmp, i );
+                outCentre.getAsVector3( centre, i );
+                for( size_t j = 0; j < 3u; ++j )
+                {
+                    const Real quantised = Math::Clamp( ( vTmp[j] - centre[j] ) * invScale[i][j],
+                                                        Real( -32767.0 ), Real( 32767.0 ) );
+                    dst[j * ARRAY_PACKED_REALS + i] =
+                        static_cast<int16>( Math::Floor( quantised + 0.5f ) );
+                }
+            }
+            dst += stride;
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::_compress( uint8 constantChannels, CompressedTrackRanges *ranges,
+                                   int16 *keyFrameData )
+    {
+        assert( !isCompressed() );
+        assert( ( reinterpret_cast<uintptr_t>( ranges ) & ( OGRE_SIMD_ALIGNMENT - 1u ) ) == 0 &&
+                "ranges must be SIMD aligned" );
+
+        const size_t stride = calculateCompressedStride( constantChannels );
+        const KfTransform *firstTransf = mKeyFrameRigs.front().mBoneTransform;
+
+        int16 *RESTRICT_ALIAS dst = keyFrameData;
+
+        ranges->mPositionScale = ArrayVector3::ZERO;
+        if( constantChannels & ChannelPosition )
+            ranges->mPositionCentre = firstTransf->mPosition;
+        else
+        {
+            quantiseVector3Channel( mKeyFrameRigs, &KfTransform::mPosition, ranges->mPositionCentre,
+                                    ranges->mPositionScale, dst, stride );
+            dst += ARRAY_PACKED_REALS * 3u;
+        }
+
+        ranges->mOrientation = firstTransf->mOrientation;
+        if( !( constantChannels & ChannelOrientation ) )
+        {
+            int16 *RESTRICT_ALIAS rotDst = dst;
+
+            KeyFrameRigVec::const_iterator itor = mKeyFrameRigs.begin();
+            KeyFrameRigVec::const_iterator endt = mKeyFrameRigs.end();
+
+            while( itor != endt )
+            {
+                for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+                {
+                    Quaternion qTmp;
+                    itor->mBoneTransform->mOrientation.getAsQuaternion( qTmp, i );
+                    for( size_t j = 0; j < 4u; ++j )
+                    {
+                        const Real quantised =
+                            Math::Clamp( qTmp[j], Real( -1.0 ), Real( 1.0 ) ) * Real( 32767.0 );
+                        rotDst[j * ARRAY_PACKED_REALS + i] =
+                            static_cast<int16>( Math::Floor( quantised + 0.5f ) );
+                    }
+                }
+                rotDst += stride;
+                ++itor;
+            }
+            dst += ARRAY_PACKED_REALS * 4u;
+        }
+
+        ranges->mScaleScale = ArrayVector3::ZERO;
+        if( constantChannels & ChannelScale )
+            ranges->mScaleCentre = firstTransf->mScale;
+        else
+        {
+            quantiseVector3Channel( mKeyFrameRigs, &KfTransform::mScale, ranges->mScaleCentre,
+                                    ranges->mScaleScale, dst, stride );
+        }
+
+        KeyFrameRigVec::iterator itor = mKeyFrameRigs.begin();
+        KeyFrameRigVec::iterator endt = mKeyFrameRigs.end();
+        while( itor != endt )
+        {
+            itor->mBoneTransform = 0;
+            ++itor;
+        }
+
+        mCompressedRanges = ranges;
+        mCompressedKeyFrames = keyFrameData;
+        mCompressedStride = static_cast<uint16>( stride );
+        mConstantChannels = constantChannels;
+        mLocalMemoryManager = 0;
+    }
 }  // namespace Ogre
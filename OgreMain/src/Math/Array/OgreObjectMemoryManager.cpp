@@ -36,6 +36,7 @@ namespace Ogre
 {
     ObjectMemoryManager::ObjectMemoryManager() :
         mTotalObjects( 0 ),
+        mStructureRevision( 0 ),
         mDummyNode( 0 ),
         mDummyObject( 0 ),
         mMemoryManagerType( SCENE_DYNAMIC ),
@@ -134,6 +135,7 @@ namespace Ogre
         mgr.createNewNode( outObjectData );
 
         ++mTotalObjects;
+        ++mStructureRevision;
     }
     //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::objectMoved( ObjectData &inOutObjectData, size_t oldRenderQueue,
@@ -158,6 +160,7 @@ namespace Ogre
         mgr.destroyNode( outObjectData );
 
         --mTotalObjects;
+        ++mStructureRevision;
     }
     //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::migrateTo( ObjectData &inOutObjectData, size_t renderQueue,
@@ -47,4 +47,10 @@ namespace Ogre
                      "Archive::remove" );
     }
     //---------------------------------------------------------------------
+    void Archive::rename( const String &, const String & )
+    {
+        OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED, "This archive does not support renaming files.",
+                     "Archive::rename" );
+    }
+    //---------------------------------------------------------------------
 }  // namespace Ogre
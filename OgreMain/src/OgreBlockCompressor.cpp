@@ -0,0 +1,646 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreBlockCompressor.h"
+
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureBox.h"
+
+namespace Ogre
+{
+    namespace
+    {
+        inline int clampInt( int value, int minValue, int maxValue )
+        {
+            return std::min( std::max( value, minValue ), maxValue );
+        }
+        //-------------------------------------------------------------------------------
+        inline uint16 packRgb565( const float rgb[3] )
+        {
+            const int r = clampInt( int( rgb[0] * ( 31.0f / 255.0f ) + 0.5f ), 0, 31 );
+            const int g = clampInt( int( rgb[1] * ( 63.0f / 255.0f ) + 0.5f ), 0, 63 );
+            const int b = clampInt( int( rgb[2] * ( 31.0f / 255.0f ) + 0.5f ), 0, 31 );
+            return static_cast<uint16>( ( r << 11 ) | ( g << 5 ) | b );
+        }
+        //-------------------------------------------------------------------------------
+        inline void unpackRgb565( uint16 colour, int outRgb[3] )
+        {
+            const int r = ( colour >> 11 ) & 0x1F;
+            const int g = ( colour >> 5 ) & 0x3F;
+            const int b = colour & 0x1F;
+            outRgb[0] = ( r << 3 ) | ( r >> 2 );
+            outRgb[1] = ( g << 2 ) | ( g >> 4 );
+            outRgb[2] = ( b << 3 ) | ( b >> 2 );
+        }
+        //-------------------------------------------------------------------------------
+        /// Colour block of BC1 & BC3 in 4-colour mode
+        struct ColourBlock
+        {
+            uint16 colour0;
+            uint16 colour1;
+            uint32 indices;
+            uint32 error;
+        };
+        //-------------------------------------------------------------------------------
+        /// Quantizes the endpoints and picks the closest palette entry for each texel
+        ColourBlock fitColourIndices( const uint8 *rgba, const float endPoint0[3],
+                                      const float endPoint1[3] )
+        {
+            ColourBlock block;
+            block.colour0 = packRgb565( endPoint0 );
+            block.colour1 = packRgb565( endPoint1 );
+            // colour0 > colour1 selects 4-colour mode. colour0 == colour1 can't be
+            // 4-colour mode, but then using index 0 for everything is fine.
+            if( block.colour0 < block.colour1 )
+                std::swap( block.colour0, block.colour1 );
+
+            int palette[4][3];
+            unpackRgb565( block.colour0, palette[0] );
+            unpackRgb565( block.colour1, palette[1] );
+            for( size_t c = 0; c < 3u; ++c )
+            {
+                palette[2][c] = ( 2 * palette[0][c] + palette[1][c] + 1 ) / 3;
+                palette[3][c] = ( palette[0][c] + 2 * palette[1][c] + 1 ) / 3;
+            }
+            const size_t numPaletteEntries = block.colour0 == block.colour1 ? 1u : 4u;
+
+            block.indices = 0u;
+            block.error = 0u;
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                uint32 bestError = std::numeric_limits<uint32>::max();
+                uint32 bestIdx = 0u;
+                for( size_t j = 0; j < numPaletteEntries; ++j )
+                {
+                    const int dr = int( rgba[i * 4u + 0u] ) - palette[j][0];
+                    const int dg = int( rgba[i * 4u + 1u] ) - palette[j][1];
+                    const int db = int( rgba[i * 4u + 2u] ) - palette[j][2];
+                    const uint32 error = uint32( dr * dr + dg * dg + db * db );
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        bestIdx = uint32( j );
+                    }
+                }
+                block.indices |= bestIdx << ( i * 2u );
+                block.error += bestError;
+            }
+
+            return block;
+        }
+        //-------------------------------------------------------------------------------
+        /// Finds the endpoints that minimize the squared error for the chosen indices.
+        /// Returns false if the system can't be solved (e.g. all texels use the same index)
+        bool leastSquaresEndPoints( const uint8 *rgba, const float *weights, const uint32 *indices,
+                                    float outEndPoint0[], float outEndPoint1[],
+                                    size_t numComponents )
+        {
+            float aa = 0, ab = 0, bb = 0;
+            float ax[4] = { 0, 0, 0, 0 };
+            float bx[4] = { 0, 0, 0, 0 };
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                // weights[] is how much of endpoint 1 is used by each index
+                const float b = weights[indices[i]];
+                const float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for( size_t c = 0; c < numComponents; ++c )
+                {
+                    ax[c] += a * float( rgba[i * 4u + c] );
+                    bx[c] += b * float( rgba[i * 4u + c] );
+                }
+            }
+
+            const float det = aa * bb - ab * ab;
+            if( std::abs( det ) < 1e-6f )
+                return false;
+
+            const float invDet = 1.0f / det;
+            for( size_t c = 0; c < numComponents; ++c )
+            {
+                outEndPoint0[c] = ( ax[c] * bb - bx[c] * ab ) * invDet;
+                outEndPoint1[c] = ( bx[c] * aa - ax[c] * ab ) * invDet;
+            }
+            return true;
+        }
+        //-------------------------------------------------------------------------------
+        /** Finds the principal axis of the texels (4 components each) and returns the texels
+            with the lowest & highest projection along it.
+        @param numComponents
+            3 to ignore alpha, 4 to include it
+        */
+        void findPrincipalEndPoints( const uint8 *rgba, size_t numComponents, float outMin[4],
+                                     float outMax[4] )
+        {
+            float mean[4] = { 0, 0, 0, 0 };
+            float minC[4] = { 255, 255, 255, 255 };
+            float maxC[4] = { 0, 0, 0, 0 };
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                for( size_t c = 0; c < numComponents; ++c )
+                {
+                    const float value = float( rgba[i * 4u + c] );
+                    mean[c] += value;
+                    minC[c] = std::min( minC[c], value );
+                    maxC[c] = std::max( maxC[c], value );
+                }
+            }
+            for( size_t c = 0; c < numComponents; ++c )
+                mean[c] *= 1.0f / 16.0f;
+
+            float covariance[4][4];
+            memset( covariance, 0, sizeof( covariance ) );
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                float diff[4];
+                for( size_t c = 0; c < numComponents; ++c )
+                    diff[c] = float( rgba[i * 4u + c] ) - mean[c];
+                for( size_t c0 = 0; c0 < numComponents; ++c0 )
+                {
+                    for( size_t c1 = c0; c1 < numComponents; ++c1 )
+                        covariance[c0][c1] += diff[c0] * diff[c1];
+                }
+            }
+            for( size_t c0 = 0; c0 < numComponents; ++c0 )
+            {
+                for( size_t c1 = 0; c1 < c0; ++c1 )
+                    covariance[c0][c1] = covariance[c1][c0];
+            }
+
+            // Power iteration, starting from the diagonal of the bounding box
+            float axis[4];
+            for( size_t c = 0; c < numComponents; ++c )
+                axis[c] = maxC[c] - minC[c];
+            for( size_t iteration = 0; iteration < 8u; ++iteration )
+            {
+                float newAxis[4] = { 0, 0, 0, 0 };
+                float maxAbs = 0;
+                for( size_t c0 = 0; c0 < numComponents; ++c0 )
+                {
+                    for( size_t c1 = 0; c1 < numComponents; ++c1 )
+                        newAxis[c0] += covariance[c0][c1] * axis[c1];
+                    maxAbs = std::max( maxAbs, std::abs( newAxis[c0] ) );
+                }
+                if( maxAbs < 1e-6f )
+                    break;
+                for( size_t c = 0; c < numComponents; ++c )
+                    axis[c] = newAxis[c] / maxAbs;
+            }
+
+            float minDot = std::numeric_limits<float>::max();
+            float maxDot = -std::numeric_limits<float>::max();
+            size_t minIdx = 0u, maxIdx = 0u;
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                float dot = 0;
+                for( size_t c = 0; c < numComponents; ++c )
+                    dot += float( rgba[i * 4u + c] ) * axis[c];
+                if( dot < minDot )
+                {
+                    minDot = dot;
+                    minIdx = i;
+                }
+                if( dot > maxDot )
+                {
+                    maxDot = dot;
+                    maxIdx = i;
+                }
+            }
+
+            for( size_t c = 0; c < numComponents; ++c )
+            {
+                outMin[c] = float( rgba[minIdx * 4u + c] );
+                outMax[c] = float( rgba[maxIdx * 4u + c] );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        void encodeColourBlock( const uint8 *rgba, uint8 *outBlock )
+        {
+            float endPoint0[4], endPoint1[4];
+            findPrincipalEndPoints( rgba, 3u, endPoint1, endPoint0 );
+
+            ColourBlock bestBlock = fitColourIndices( rgba, endPoint0, endPoint1 );
+
+            // How much of colour1 is used by each index in 4-colour mode
+            const float c_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+            for( size_t iteration = 0; iteration < 2u && bestBlock.error > 0u; ++iteration )
+            {
+                if( bestBlock.colour0 == bestBlock.colour1 )
+                    break;
+
+                uint32 indices[16];
+                for( size_t i = 0; i < 16u; ++i )
+                    indices[i] = ( bestBlock.indices >> ( i * 2u ) ) & 0x03u;
+
+                if( !leastSquaresEndPoints( rgba, c_weights, indices, endPoint0, endPoint1, 3u ) )
+                    break;
+
+                const ColourBlock block = fitColourIndices( rgba, endPoint0, endPoint1 );
+                if( block.error >= bestBlock.error )
+                    break;
+                bestBlock = block;
+            }
+
+            outBlock[0] = static_cast<uint8>( bestBlock.colour0 & 0xFF );
+            outBlock[1] = static_cast<uint8>( bestBlock.colour0 >> 8u );
+            outBlock[2] = static_cast<uint8>( bestBlock.colour1 & 0xFF );
+            outBlock[3] = static_cast<uint8>( bestBlock.colour1 >> 8u );
+            for( size_t i = 0; i < 4u; ++i )
+                outBlock[4u + i] = static_cast<uint8>( ( bestBlock.indices >> ( i * 8u ) ) & 0xFF );
+        }
+        //-------------------------------------------------------------------------------
+        /// BC4 block (also used by BC3's alpha & BC5) in 8-value mode. values[] can be
+        /// unsigned or signed, as long as endpoints are written with the same signedness.
+        void encodeSingleChannelBlock( const int values[16], uint8 *outBlock )
+        {
+            int minValue = values[0];
+            int maxValue = values[0];
+            for( size_t i = 1u; i < 16u; ++i )
+            {
+                minValue = std::min( minValue, values[i] );
+                maxValue = std::max( maxValue, values[i] );
+            }
+
+            // endpoint0 > endpoint1 selects 8-value mode:
+            //  index 0 = endpoint0, index 1 = endpoint1 and indices 2-7 are 6/7 to 1/7
+            //  of the way from endpoint1 to endpoint0.
+            // If they're equal (6-value mode), index 0 is still endpoint0.
+            outBlock[0] = static_cast<uint8>( maxValue );
+            outBlock[1] = static_cast<uint8>( minValue );
+
+            uint64 indices = 0u;
+            const int range = maxValue - minValue;
+            if( range > 0 )
+            {
+                for( size_t i = 0; i < 16u; ++i )
+                {
+                    // Position along [endpoint1; endpoint0], rounded to nearest seventh
+                    const int pos = ( ( values[i] - minValue ) * 14 + range ) / ( 2 * range );
+                    const uint64 idx = pos == 7 ? 0u : ( pos == 0 ? 1u : uint64( 8 - pos ) );
+                    indices |= idx << ( i * 3u );
+                }
+            }
+
+            for( size_t i = 0; i < 6u; ++i )
+                outBlock[2u + i] = static_cast<uint8>( ( indices >> ( i * 8u ) ) & 0xFF );
+        }
+        //-------------------------------------------------------------------------------
+        /// Writes bits into a zero-initialized block, least significant bit first
+        struct BitWriter
+        {
+            uint8 *data;
+            size_t bitPos;
+
+            BitWriter( uint8 *_data ) : data( _data ), bitPos( 0u ) {}
+
+            void write( uint32 value, uint32 numBits )
+            {
+                for( uint32 i = 0u; i < numBits; ++i )
+                {
+                    if( ( value >> i ) & 0x01u )
+                        data[bitPos >> 3u] |= static_cast<uint8>( 1u << ( bitPos & 0x07u ) );
+                    ++bitPos;
+                }
+            }
+        };
+        //-------------------------------------------------------------------------------
+        const uint32 c_bc7Weights4[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                           34, 38, 43, 47, 51, 55, 60, 64 };
+        //-------------------------------------------------------------------------------
+        /// BC7 mode 6 block, before being packed
+        struct Bc7Mode6Block
+        {
+            uint8 endPoints[2][4];  // 7 bits each
+            uint8 pBits[2];
+            uint8 indices[16];
+            uint32 error;
+        };
+        //-------------------------------------------------------------------------------
+        /// Quantizes the endpoints (picking the best p-bit for each) and picks the closest
+        /// interpolated colour for each texel
+        Bc7Mode6Block fitBc7Mode6( const uint8 *rgba, const float endPoint0[4],
+                                   const float endPoint1[4] )
+        {
+            Bc7Mode6Block block;
+
+            int decoded[2][4];
+            const float *endPoints[2] = { endPoint0, endPoint1 };
+            for( size_t e = 0; e < 2u; ++e )
+            {
+                float bestError = std::numeric_limits<float>::max();
+                for( int p = 0; p < 2; ++p )
+                {
+                    int candidate[4];
+                    float error = 0;
+                    for( size_t c = 0; c < 4u; ++c )
+                    {
+                        const int q = clampInt( int( ( endPoints[e][c] - float( p ) ) * 0.5f + 0.5f ),
+                                                0, 127 );
+                        candidate[c] = ( q << 1 ) | p;
+                        const float diff = float( candidate[c] ) - endPoints[e][c];
+                        error += diff * diff;
+                    }
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        block.pBits[e] = static_cast<uint8>( p );
+                        for( size_t c = 0; c < 4u; ++c )
+                        {
+                            decoded[e][c] = candidate[c];
+                            block.endPoints[e][c] = static_cast<uint8>( candidate[c] >> 1 );
+                        }
+                    }
+                }
+            }
+
+            int palette[16][4];
+            for( size_t j = 0; j < 16u; ++j )
+            {
+                const int w = int( c_bc7Weights4[j] );
+                for( size_t c = 0; c < 4u; ++c )
+                    palette[j][c] = ( ( 64 - w ) * decoded[0][c] + w * decoded[1][c] + 32 ) >> 6;
+            }
+
+            block.error = 0u;
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                uint32 bestError = std::numeric_limits<uint32>::max();
+                uint8 bestIdx = 0u;
+                for( size_t j = 0; j < 16u; ++j )
+                {
+                    uint32 error = 0u;
+                    for( size_t c = 0; c < 4u; ++c )
+                    {
+                        const int diff = int( rgba[i * 4u + c] ) - palette[j][c];
+                        error += uint32( diff * diff );
+                    }
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        bestIdx = static_cast<uint8>( j );
+                    }
+                }
+                block.indices[i] = bestIdx;
+                block.error += bestError;
+            }
+
+            return block;
+        }
+        //-------------------------------------------------------------------------------
+        /// Reads the 4x4 block at (xBlock, yBlock, z) as RGBA8 or as 1/2 channel values,
+        /// repeating the last row & column of the image when the block goes past its edges
+        template <typename T>
+        void fetchBlock( const TextureBox &srcBox, size_t xBlock, size_t yBlock, size_t z,
+                         size_t srcComponents, const size_t swizzle[4], T *outTexels,
+                         size_t dstComponents, T fillValue )
+        {
+            for( size_t y = 0; y < 4u; ++y )
+            {
+                const size_t srcY = std::min<size_t>( yBlock * 4u + y, srcBox.height - 1u );
+                for( size_t x = 0; x < 4u; ++x )
+                {
+                    const size_t srcX = std::min<size_t>( xBlock * 4u + x, srcBox.width - 1u );
+                    const T *src = reinterpret_cast<const T *>( srcBox.at( srcX, srcY, z ) );
+                    T *dst = outTexels + ( y * 4u + x ) * dstComponents;
+                    for( size_t c = 0; c < dstComponents; ++c )
+                        dst[c] = swizzle[c] < srcComponents ? src[swizzle[c]] : fillValue;
+                }
+            }
+        }
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    bool BlockCompressor::canCompress( PixelFormatGpu srcFormat, PixelFormatGpu dstFormat )
+    {
+        srcFormat = PixelFormatGpuUtils::getEquivalentLinear( srcFormat );
+        dstFormat = PixelFormatGpuUtils::getEquivalentLinear( dstFormat );
+
+        switch( dstFormat )
+        {
+        case PFG_BC1_UNORM:
+        case PFG_BC3_UNORM:
+        case PFG_BC7_UNORM:
+            return srcFormat == PFG_RGBA8_UNORM || srcFormat == PFG_BGRA8_UNORM ||
+                   srcFormat == PFG_BGRX8_UNORM;
+        case PFG_BC4_UNORM:
+            return srcFormat == PFG_R8_UNORM;
+        case PFG_BC4_SNORM:
+            return srcFormat == PFG_R8_SNORM;
+        case PFG_BC5_UNORM:
+            return srcFormat == PFG_RG8_UNORM;
+        case PFG_BC5_SNORM:
+            return srcFormat == PFG_RG8_SNORM;
+        default:
+            return false;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompressor::compress( const TextureBox &srcBox, PixelFormatGpu srcFormat,
+                                    const TextureBox &dstBox, PixelFormatGpu dstFormat,
+                                    uint32 blockRowStart, uint32 blockRowEnd )
+    {
+        OGRE_ASSERT_LOW( canCompress( srcFormat, dstFormat ) );
+        OGRE_ASSERT_LOW( srcBox.width == dstBox.width && srcBox.height == dstBox.height );
+
+        srcFormat = PixelFormatGpuUtils::getEquivalentLinear( srcFormat );
+        dstFormat = PixelFormatGpuUtils::getEquivalentLinear( dstFormat );
+
+        const size_t srcComponents = srcFormat == PFG_BGRX8_UNORM
+                                         ? 3u
+                                         : PixelFormatGpuUtils::getNumberOfComponents( srcFormat );
+        // Where to read R, G, B & A from. Values >= srcComponents are filled
+        size_t swizzle[4] = { 0u, 1u, 2u, 3u };
+        if( srcFormat == PFG_BGRA8_UNORM || srcFormat == PFG_BGRX8_UNORM )
+        {
+            swizzle[0] = 2u;
+            swizzle[2] = 0u;
+        }
+
+        const size_t blockSize = PixelFormatGpuUtils::getCompressedBlockSize( dstFormat );
+        const size_t numBlocksX = ( srcBox.width + 3u ) >> 2u;
+        const size_t depthOrSlices = srcBox.getDepthOrSlices();
+
+        for( size_t z = 0; z < depthOrSlices; ++z )
+        {
+            for( size_t yBlock = blockRowStart; yBlock < blockRowEnd; ++yBlock )
+            {
+                uint8 *dst = reinterpret_cast<uint8 *>( dstBox.data ) + z * dstBox.bytesPerImage +
+                             yBlock * dstBox.bytesPerRow;
+                for( size_t xBlock = 0; xBlock < numBlocksX; ++xBlock )
+                {
+                    switch( dstFormat )
+                    {
+                    case PFG_BC1_UNORM:
+                    case PFG_BC3_UNORM:
+                    case PFG_BC7_UNORM:
+                    {
+                        uint8 rgba[16 * 4];
+                        fetchBlock<uint8>( srcBox, xBlock, yBlock, z, srcComponents, swizzle, rgba,
+                                           4u, 0xFF );
+                        if( dstFormat == PFG_BC1_UNORM )
+                            encodeBc1( rgba, dst );
+                        else if( dstFormat == PFG_BC3_UNORM )
+                            encodeBc3( rgba, dst );
+                        else
+                            encodeBc7( rgba, dst );
+                        break;
+                    }
+                    case PFG_BC4_UNORM:
+                    {
+                        uint8 values[16];
+                        fetchBlock<uint8>( srcBox, xBlock, yBlock, z, 1u, swizzle, values, 1u, 0 );
+                        encodeBc4( values, dst );
+                        break;
+                    }
+                    case PFG_BC4_SNORM:
+                    {
+                        int8 values[16];
+                        fetchBlock<int8>( srcBox, xBlock, yBlock, z, 1u, swizzle, values, 1u, 0 );
+                        encodeBc4Snorm( values, dst );
+                        break;
+                    }
+                    case PFG_BC5_UNORM:
+                    case PFG_BC5_SNORM:
+                    {
+                        int8 values[16 * 2];
+                        fetchBlock<int8>( srcBox, xBlock, yBlock, z, 2u, swizzle, values, 2u, 0 );
+                        int8 red[16], green[16];
+                        for( size_t i = 0; i < 16u; ++i )
+                        {
+                            red[i] = values[i * 2u + 0u];
+                            green[i] = values[i * 2u + 1u];
+                        }
+                        if( dstFormat == PFG_BC5_SNORM )
+                        {
+                            encodeBc4Snorm( red, dst );
+                            encodeBc4Snorm( green, dst + 8u );
+                        }
+                        else
+                        {
+                            encodeBc4( reinterpret_cast<const uint8 *>( red ), dst );
+                            encodeBc4( reinterpret_cast<const uint8 *>( green ), dst + 8u );
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                    }
+
+                    dst += blockSize;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompressor::encodeBc1( const uint8 rgba[16 * 4], uint8 outBlock[8] )
+    {
+        encodeColourBlock( rgba, outBlock );
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompressor::encodeBc3( const uint8 rgba[16 * 4], uint8 outBlock[16] )
+    {
+        uint8 alpha[16];
+        for( size_t i = 0; i < 16u; ++i )
+            alpha[i] = rgba[i * 4u + 3u];
+        encodeBc4( alpha, outBlock );
+        encodeColourBlock( rgba, outBlock + 8u );
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompressor::encodeBc4( const uint8 values[16], uint8 outBlock[8] )
+    {
+        int intValues[16];
+        for( size_t i = 0; i < 16u; ++i )
+            intValues[i] = values[i];
+        encodeSingleChannelBlock( intValues, outBlock );
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompressor::encodeBc4Snorm( const int8 values[16], uint8 outBlock[8] )
+    {
+        int intValues[16];
+        for( size_t i = 0; i < 16u; ++i )
+            intValues[i] = std::max<int>( values[i], -127 );
+        encodeSingleChannelBlock( intValues, outBlock );
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompressor::encodeBc7( const uint8 rgba[16 * 4], uint8 outBlock[16] )
+    {
+        float endPoint0[4], endPoint1[4];
+        findPrincipalEndPoints( rgba, 4u, endPoint0, endPoint1 );
+
+        Bc7Mode6Block bestBlock = fitBc7Mode6( rgba, endPoint0, endPoint1 );
+
+        // How much of endpoint 1 is used by each index
+        float weights[16];
+        for( size_t i = 0; i < 16u; ++i )
+            weights[i] = float( c_bc7Weights4[i] ) / 64.0f;
+
+        for( size_t iteration = 0; iteration < 2u && bestBlock.error > 0u; ++iteration )
+        {
+            uint32 indices[16];
+            for( size_t i = 0; i < 16u; ++i )
+                indices[i] = bestBlock.indices[i];
+
+            if( !leastSquaresEndPoints( rgba, weights, indices, endPoint0, endPoint1, 4u ) )
+                break;
+
+            const Bc7Mode6Block block = fitBc7Mode6( rgba, endPoint0, endPoint1 );
+            if( block.error >= bestBlock.error )
+                break;
+            bestBlock = block;
+        }
+
+        // The most significant bit of the first index is implicitly 0.
+        // If it isn't, swap the endpoints and invert the indices.
+        if( bestBlock.indices[0] & 0x08u )
+        {
+            for( size_t c = 0; c < 4u; ++c )
+                std::swap( bestBlock.endPoints[0][c], bestBlock.endPoints[1][c] );
+            std::swap( bestBlock.pBits[0], bestBlock.pBits[1] );
+            for( size_t i = 0; i < 16u; ++i )
+                bestBlock.indices[i] = static_cast<uint8>( 15u - bestBlock.indices[i] );
+        }
+
+        memset( outBlock, 0, 16u );
+        BitWriter writer( outBlock );
+        writer.write( 1u << 6u, 7u );  // Mode 6
+        for( size_t c = 0; c < 4u; ++c )
+        {
+            writer.write( bestBlock.endPoints[0][c], 7u );
+            writer.write( bestBlock.endPoints[1][c], 7u );
+        }
+        writer.write( bestBlock.pBits[0], 1u );
+        writer.write( bestBlock.pBits[1], 1u );
+        writer.write( bestBlock.indices[0], 3u );
+        for( size_t i = 1u; i < 16u; ++i )
+            writer.write( bestBlock.indices[i], 4u );
+    }
+}  // namespace Ogre
@@ -883,12 +883,10 @@ namespace Ogre
                                 imgData->box.getDepthOrSlices(), imgData->textureType, imgData->format,
                                 false, imgData->numMipmaps );
 
+        // If the stream is already in memory (e.g. a memory-mapped file), 24-bit
+        // images get converted straight from it instead of through rgb24TmpRow
+        const uint8 *contiguousData = stream->getContiguousPtr();
         uint8 *rgb24TmpRow = 0;
-        if( header.pixelFormat.rgbBits == 24u )
-        {
-            rgb24TmpRow = reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD(
-                imgData->box.width * imgData->box.height * 3u, MEMCATEGORY_RESOURCE ) );
-        }
 
         // All mips for a face, then each face
         const size_t numSlices = imgData->box.numSlices;
@@ -1036,12 +1034,28 @@ namespace Ogre
                         {
                             for( size_t y = 0; y < height; ++y )
                             {
-                                stream->read( rgb24TmpRow, srcBytesPerRow );
+                                uint8 const *RESTRICT_ALIAS srcRgba24;
+                                if( contiguousData &&
+                                    stream->tell() + srcBytesPerRow <= stream->size() )
+                                {
+                                    srcRgba24 = contiguousData + stream->tell();
+                                    stream->skip( static_cast<long>( srcBytesPerRow ) );
+                                }
+                                else
+                                {
+                                    // Not in memory, or the file is truncated
+                                    if( !rgb24TmpRow )
+                                    {
+                                        rgb24TmpRow = reinterpret_cast<uint8 *>(
+                                            OGRE_MALLOC_SIMD( imgData->box.width * 3u,
+                                                              MEMCATEGORY_RESOURCE ) );
+                                    }
+                                    stream->read( rgb24TmpRow, srcBytesPerRow );
+                                    srcRgba24 = rgb24TmpRow;
+                                }
 
                                 uint8 *RESTRICT_ALIAS dstRgba32 =
                                     static_cast<uint8 * RESTRICT_ALIAS>( destPtr );
-                                uint8 *RESTRICT_ALIAS srcRgba24 =
-                                    static_cast<uint8 * RESTRICT_ALIAS>( rgb24TmpRow );
 
                                 for( size_t x = 0; x < width; ++x )
                                 {
@@ -31,11 +31,46 @@ THE SOFTWARE.
 
 #include "Math/Array/OgreArraySphere.h"
 #include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreArrayRay.h"
 #include "Math/Array/OgreMathlib.h"
 #include "OgreRoot.h"
+#include "OgreSceneQueryBvh.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 namespace Ogre
 {
+    /// Number of rays DefaultRaySceneQuery::_executeBatch tests at once against each
+    /// pack of objects, so that the objects are streamed only once per batch.
+    static const size_t c_rayBatchSize = 64u;
+    /// Below this many rays per thread it's not worth waking up the worker threads.
+    static const size_t c_minRaysPerThread = 32u;
+
+    /// Splits the rays of DefaultRaySceneQuery::executeBatch between the worker threads
+    class RaySceneQueryBatchTask final : public UniformScalableTask
+    {
+        DefaultRaySceneQuery const *mQuery;
+        Ray const *mRays;
+        size_t mNumRays;
+        RaySceneQueryBatchResult *mResults;
+
+    public:
+        RaySceneQueryBatchTask( const DefaultRaySceneQuery *query, const Ray *rays, size_t numRays,
+                                RaySceneQueryBatchResult *results ) :
+            mQuery( query ),
+            mRays( rays ),
+            mNumRays( numRays ),
+            mResults( results )
+        {
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            const size_t numPerThread = ( mNumRays + numThreads - 1u ) / numThreads;
+            const size_t firstRay = std::min( threadId * numPerThread, mNumRays );
+            const size_t lastRay = std::min( firstRay + numPerThread, mNumRays );
+            mQuery->_executeBatch( mRays + firstRay, lastRay - firstRay, mResults + firstRay );
+        }
+    };
     //---------------------------------------------------------------------
     DefaultIntersectionSceneQuery::DefaultIntersectionSceneQuery( SceneManager *creator ) :
         IntersectionSceneQuery( creator )
@@ -134,6 +169,14 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        const SceneQueryBvh *bvh = mParentSceneMgr->_getSceneQueryBvh();
+        if( bvh && bvh->isUpToDate() )
+        {
+            bvh->aabbQuery( Aabb::newFromExtents( mAABB.getMinimum(), mAABB.getMaximum() ),
+                            mQueryMask, mFirstRq, mLastRq, listener );
+            return;
+        }
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
@@ -220,6 +263,13 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        const SceneQueryBvh *bvh = mParentSceneMgr->_getSceneQueryBvh();
+        if( bvh && bvh->isUpToDate() )
+        {
+            bvh->rayQuery( mRay, mQueryMask, mFirstRq, mLastRq, listener );
+            return;
+        }
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
@@ -350,6 +400,140 @@ namespace Ogre
         return true;
     }
     //---------------------------------------------------------------------
+    void DefaultRaySceneQuery::executeBatch( const Ray *rays, size_t numRays,
+                                             RaySceneQueryBatchResult *outResults,
+                                             bool bUseWorkerThreads )
+    {
+        const size_t numThreads = mParentSceneMgr->getNumWorkerThreads();
+        if( bUseWorkerThreads && numThreads > 1u && numRays >= numThreads * c_minRaysPerThread )
+        {
+            RaySceneQueryBatchTask task( this, rays, numRays, outResults );
+            mParentSceneMgr->executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            _executeBatch( rays, numRays, outResults );
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultRaySceneQuery::_executeBatch( const Ray *rays, size_t numRays,
+                                              RaySceneQueryBatchResult *outResults ) const
+    {
+        assert( mFirstRq < mLastRq && "This query will never hit any result!" );
+
+        const SceneQueryBvh *bvh = mParentSceneMgr->_getSceneQueryBvh();
+        if( bvh && bvh->isUpToDate() )
+        {
+            for( size_t i = 0; i < numRays; ++i )
+                bvh->rayQueryNearest( rays[i], mQueryMask, mFirstRq, mLastRq, outResults[i] );
+            return;
+        }
+
+        for( size_t i = 0; i < numRays; ++i )
+        {
+            outResults[i].movable = 0;
+            outResults[i].distance = std::numeric_limits<Real>::max();
+        }
+
+        const ArrayInt ourQueryMask = Mathlib::SetAll( mQueryMask );
+        const ArrayInt layerVisibility = Mathlib::SetAll( VisibilityFlags::LAYER_VISIBILITY );
+
+        // Each ray is broadcast to all lanes, and tested against ARRAY_PACKED_REALS objects at once
+        ArrayRay arrayRays[c_rayBatchSize];
+        ArrayVector3 arrayInvDirs[c_rayBatchSize];
+        ArrayReal nearestDistances[c_rayBatchSize];
+
+        for( size_t batchStart = 0; batchStart < numRays; batchStart += c_rayBatchSize )
+        {
+            const size_t batchSize = std::min( numRays - batchStart, c_rayBatchSize );
+            const Ray *batchRays = rays + batchStart;
+            RaySceneQueryBatchResult *batchResults = outResults + batchStart;
+
+            for( size_t r = 0; r < batchSize; ++r )
+            {
+                const Vector3 &dir = batchRays[r].getDirection();
+                arrayRays[r].mOrigin.setAll( batchRays[r].getOrigin() );
+                arrayRays[r].mDirection.setAll( dir );
+                arrayInvDirs[r].setAll( Vector3( Real( 1 ) / dir.x, Real( 1 ) / dir.y,
+                                                 Real( 1 ) / dir.z ) );
+                nearestDistances[r] = Mathlib::SetAll( std::numeric_limits<Real>::max() );
+            }
+
+            for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+            {
+                ObjectMemoryManager &memoryManager =
+                    mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+
+                const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+
+                const size_t firstRq = std::min<size_t>( mFirstRq, numRenderQueues );
+                const size_t lastRq = std::min<size_t>( mLastRq, numRenderQueues );
+
+                for( size_t j = firstRq; j < lastRq; ++j )
+                {
+                    ObjectData objData;
+                    const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
+
+                    for( size_t k = 0; k < totalObjs; k += ARRAY_PACKED_REALS )
+                    {
+                        ArrayInt *RESTRICT_ALIAS visibilityFlags =
+                            reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mVisibilityFlags );
+                        ArrayInt *RESTRICT_ALIAS queryFlags =
+                            reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mQueryFlags );
+
+                        // objMask = ( (*queryFlags & ourQueryMask) != 0 ) && isVisble;
+                        ArrayMaskI objMask = Mathlib::TestFlags4( *queryFlags, ourQueryMask );
+                        objMask =
+                            Mathlib::And( objMask, Mathlib::TestFlags4( *visibilityFlags, layerVisibility ) );
+                        const uint32 scalarObjMask = BooleanMask4::getScalarMask( objMask );
+
+                        // Early out: No object in this pack can be hit by any ray.
+                        if( scalarObjMask )
+                        {
+                            const ArrayVector3 vMin = objData.mWorldAabb->getMinimum();
+                            const ArrayVector3 vMax = objData.mWorldAabb->getMaximum();
+
+                            for( size_t r = 0; r < batchSize; ++r )
+                            {
+                                ArrayReal distance;
+                                ArrayMaskR hitMask =
+                                    arrayRays[r].intersects( vMin, vMax, arrayInvDirs[r], distance );
+                                // Early out: Only hits closer than the current nearest are of interest
+                                hitMask = Mathlib::And(
+                                    hitMask, Mathlib::CompareLess( distance, nearestDistances[r] ) );
+
+                                const uint32 scalarMask =
+                                    BooleanMask4::getScalarMask( hitMask ) & scalarObjMask;
+
+                                if( scalarMask )
+                                {
+                                    OGRE_ALIGNED_DECL( Real, scalarDistance[ARRAY_PACKED_REALS],
+                                                       OGRE_SIMD_ALIGNMENT );
+                                    CastArrayToReal( scalarDistance, distance );
+
+                                    RaySceneQueryBatchResult &result = batchResults[r];
+                                    for( size_t l = 0; l < ARRAY_PACKED_REALS; ++l )
+                                    {
+                                        if( IS_BIT_SET( l, scalarMask ) &&
+                                            scalarDistance[l] < result.distance )
+                                        {
+                                            result.movable = objData.mOwner[l];
+                                            result.distance = scalarDistance[l];
+                                        }
+                                    }
+
+                                    nearestDistances[r] = Mathlib::SetAll( result.distance );
+                                }
+                            }
+                        }
+
+                        objData.advancePack();
+                    }
+                }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
     DefaultSphereSceneQuery::DefaultSphereSceneQuery( SceneManager *creator ) :
         SphereSceneQuery( creator )
     {
@@ -363,6 +547,13 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        const SceneQueryBvh *bvh = mParentSceneMgr->_getSceneQueryBvh();
+        if( bvh && bvh->isUpToDate() )
+        {
+            bvh->sphereQuery( mSphere, mQueryMask, mFirstRq, mLastRq, listener );
+            return;
+        }
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
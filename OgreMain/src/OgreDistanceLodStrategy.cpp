@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgreDistanceLodStrategy.h"
 
+#include "Animation/OgreSkeletonInstance.h"
 #include "OgreCamera.h"
 #include "OgreNode.h"
 #include "OgreViewport.h"
@@ -49,6 +49,12 @@ THE SOFTWARE.
 #endif
 // clang-format on
 
+#if OGRE_PLATFORM != OGRE_PLATFORM_WIN32 && OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_WIN32 || OGRE_PLATFORM == OGRE_PLATFORM_WINRT
 #    define WIN32_LEAN_AND_MEAN
 #    if !defined( NOMINMAX ) && defined( _MSC_VER )
@@ -64,6 +70,104 @@ THE SOFTWARE.
 namespace Ogre
 {
     bool FileSystemArchive::msIgnoreHidden = true;
+    bool FileSystemArchive::msUseMemoryMapping = false;
+
+    //-----------------------------------------------------------------------
+    MappedFileDataStream::MappedFileDataStream( const String &name, uint8 *data, size_t size ) :
+        DataStream( name, READ ),
+        mData( data ),
+        mPos( 0u )
+    {
+        mSize = size;
+    }
+    //-----------------------------------------------------------------------
+    MappedFileDataStream::~MappedFileDataStream() { close(); }
+    //-----------------------------------------------------------------------
+    MappedFileDataStream *MappedFileDataStream::mapFile( const String &name, const String &fullPath )
+    {
+        void *data = 0;
+        size_t size = 0u;
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        HANDLE hFile = CreateFileW( fileSystemPathFromString( fullPath ).c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+        if( hFile == INVALID_HANDLE_VALUE )
+            return 0;
+
+        LARGE_INTEGER fileSize;
+        if( GetFileSizeEx( hFile, &fileSize ) && fileSize.QuadPart > 0 &&
+            uint64( fileSize.QuadPart ) <= uint64( std::numeric_limits<size_t>::max() ) )
+        {
+            // The view keeps the file & mapping alive after their handles are closed
+            HANDLE hMapping = CreateFileMappingW( hFile, 0, PAGE_READONLY, 0, 0, 0 );
+            if( hMapping )
+            {
+                data = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+                size = static_cast<size_t>( fileSize.QuadPart );
+                CloseHandle( hMapping );
+            }
+        }
+        CloseHandle( hFile );
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+        const int fd = ::open( fullPath.c_str(), O_RDONLY );
+        if( fd < 0 )
+            return 0;
+
+        // The mapping keeps the file alive after fd is closed
+        struct stat tagStat;
+        if( fstat( fd, &tagStat ) == 0 && tagStat.st_size > 0 )
+        {
+            size = static_cast<size_t>( tagStat.st_size );
+            data = mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( data == MAP_FAILED )
+                data = 0;
+        }
+        ::close( fd );
+#endif
+
+        if( !data )
+            return 0;
+
+        return OGRE_NEW MappedFileDataStream( name, static_cast<uint8 *>( data ), size );
+    }
+    //-----------------------------------------------------------------------
+    size_t MappedFileDataStream::read( void *buf, size_t count )
+    {
+        if( !mData )
+            return 0u;
+        const size_t cnt = std::min( count, mSize - std::min( mPos, mSize ) );
+        memcpy( buf, mData + mPos, cnt );
+        mPos += cnt;
+        return cnt;
+    }
+    //-----------------------------------------------------------------------
+    void MappedFileDataStream::skip( long count )
+    {
+        if( count < 0 )
+            mPos -= std::min( mPos, static_cast<size_t>( -count ) );
+        else
+            mPos = std::min( mPos + static_cast<size_t>( count ), mSize );
+    }
+    //-----------------------------------------------------------------------
+    void MappedFileDataStream::seek( size_t pos )
+    {
+        assert( pos <= mSize );
+        mPos = std::min( pos, mSize );
+    }
+    //-----------------------------------------------------------------------
+    void MappedFileDataStream::close()
+    {
+        mAccess = 0;
+        if( mData )
+        {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+            UnmapViewOfFile( mData );
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+            munmap( mData, mSize );
+#endif
+            mData = 0;
+        }
+    }
 
     //-----------------------------------------------------------------------
     FileSystemArchive::FileSystemArchive( const String &name, const String &archType, bool readOnly ) :
@@ -313,6 +417,13 @@ namespace Ogre
         assert( ret == 0 && "Problem getting file size" );
         (void)ret;  // Silence warning
 
+        if( readOnly && msUseMemoryMapping )
+        {
+            MappedFileDataStream *mappedStream = MappedFileDataStream::mapFile( filename, full_path );
+            if( mappedStream )
+                return DataStreamPtr( mappedStream );
+        }
+
         // Always open in binary mode
         // Also, always include reading
         std::ios::openmode mode = std::ios::in | std::ios::binary;
@@ -421,6 +532,31 @@ namespace Ogre
         ::remove( full_path.c_str() );
 #endif
     }
+    //---------------------------------------------------------------------
+    void FileSystemArchive::rename( const String &oldFilename, const String &newFilename )
+    {
+        if( isReadOnly() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Cannot rename a file in a read-only archive",
+                         "FileSystemArchive::rename" );
+        }
+        const String oldPath = concatenate_path( mName, oldFilename );
+        const String newPath = concatenate_path( mName, newFilename );
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32 || OGRE_PLATFORM == OGRE_PLATFORM_WINRT
+        // ::rename fails on Windows if the destination already exists
+        const bool bSuccess =
+            ::MoveFileExW( fileSystemPathFromString( oldPath ).c_str(),
+                           fileSystemPathFromString( newPath ).c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+        const bool bSuccess = ::rename( oldPath.c_str(), newPath.c_str() ) == 0;
+#endif
+        if( !bSuccess )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE,
+                         "Cannot rename " + oldFilename + " to " + newFilename,
+                         "FileSystemArchive::rename" );
+        }
+    }
     //-----------------------------------------------------------------------
     StringVectorPtr FileSystemArchive::list( bool recursive, bool dirs )
     {
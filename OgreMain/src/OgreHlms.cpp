@@ -39,6 +39,7 @@ THE SOFTWARE.
 #include "OgreForward3D.h"
 #include "OgreHighLevelGpuProgram.h"
 #include "OgreHighLevelGpuProgramManager.h"
+#include "OgreHlmsDiskCache.h"
 #include "OgreHlmsListener.h"
 #include "OgreHlmsManager.h"
 #include "OgreLight.h"
@@ -47,12 +48,16 @@ THE SOFTWARE.
 #include "OgrePixelFormatGpuUtils.h"
 #include "OgreProfiler.h"
 #include "OgreRenderQueue.h"
+#include "OgreRoot.h"
 #include "OgreRootLayout.h"
 #include "OgreSceneManager.h"
 #include "OgreViewport.h"
+#include "OgreWorkQueue.h"
 #include "Vao/OgreVaoManager.h"
 #include "Vao/OgreVertexArrayObject.h"
 
+#include "ogrestd/unordered_set.h"
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
 #    include "OSX/macUtils.h"
 #endif
@@ -251,6 +256,8 @@ namespace Ogre
 
     Hlms::Hlms( HlmsTypes type, const String &typeName, Archive *dataFolder,
                 ArchiveVec *libraryFolders ) :
+        mAsyncShaderHandler( 0 ),
+        mAsyncShaderRequestAllowed( false ),
         mDataFolder( dataFolder ),
         mHlmsManager( 0 ),
         mLightGatheringMode( LightGatherForward ),
@@ -264,6 +271,7 @@ namespace Ogre
         mRealNumAreaLtcLights( 0u ),
         mListener( &c_defaultListener ),
         mRenderSystem( 0 ),
+        mDiskCacheWarmUp( 0 ),
         mShaderProfile( "unset!" ),
         mShaderSyntax( "unset!" ),
         mShaderFileExt( "unset!" ),
@@ -313,6 +321,7 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     Hlms::~Hlms()
     {
+        setAsyncShaderGeneration( false );
         clearShaderCache();
 
         _destroyAllDatablocks();
@@ -546,6 +555,129 @@ namespace Ogre
             mSetProperties.erase( it );
     }
     //-----------------------------------------------------------------------------------
+    // Set by worker threads while they preprocess a shader asynchronously,
+    // so that the template parser doesn't touch mSetProperties & mPieces.
+    static thread_local HlmsPropertyVec *tlsParserProperties = 0;
+    static thread_local PiecesMap *tlsParserPieces = 0;
+    //-----------------------------------------------------------------------------------
+    HlmsPropertyVec &Hlms::getParserProperties()
+    {
+        return tlsParserProperties ? *tlsParserProperties : mSetProperties;
+    }
+    //-----------------------------------------------------------------------------------
+    const HlmsPropertyVec &Hlms::getParserProperties() const
+    {
+        return tlsParserProperties ? *tlsParserProperties : mSetProperties;
+    }
+    //-----------------------------------------------------------------------------------
+    PiecesMap &Hlms::getParserPieces() { return tlsParserPieces ? *tlsParserPieces : mPieces; }
+    //-----------------------------------------------------------------------------------
+    const PiecesMap &Hlms::getParserPieces() const
+    {
+        return tlsParserPieces ? *tlsParserPieces : mPieces;
+    }
+    //-----------------------------------------------------------------------------------
+    struct Hlms::AsyncShaderSources : public OgreAllocatedObj
+    {
+        /// Contents of the piece files of each stage, in the order they must be parsed
+        /// (library pieces first). Only those matching the shader file extension.
+        StringVector pieceFiles[NumShaderTypes];
+        /// Contents of the template of each stage.
+        String templates[NumShaderTypes];
+        bool   hasTemplate[NumShaderTypes];
+    };
+    //-----------------------------------------------------------------------------------
+    struct Hlms::AsyncShaderJob : public OgreAllocatedObj
+    {
+        Hlms *creator;
+        /// Merged properties & pieces, as they were handed to compileShaderCode
+        ShaderCodeCache                codeCache;
+        HlmsPropertyVec                baseProperties;
+        SharedPtr<AsyncShaderSources>  sources;
+        uint32                         usageCount;
+        /// Hashes of the HlmsCache entries waiting for this job. See AsyncShaderHandler::isPending
+        vector<uint32>::type finalHashes;
+
+        /// Preprocessed shaders. Empty for stages without template or disabled by it.
+        String outSource[NumShaderTypes];
+        bool   syntaxError;
+        /// Set by the main thread once the worker thread is done with outSource
+        bool finished;
+
+        AsyncShaderJob( Hlms *_creator, const ShaderCodeCache &_codeCache ) :
+            creator( _creator ),
+            codeCache( _codeCache ),
+            usageCount( 0u ),
+            syntaxError( false ),
+            finished( false )
+        {
+        }
+
+        /// Same as Hlms::compileShaderCode, minus the GPU program creation.
+        /// Safe to call from any thread.
+        void preprocess();
+    };
+    //-----------------------------------------------------------------------------------
+    class Hlms::AsyncShaderHandler : public WorkQueue::RequestHandler,
+                                     public WorkQueue::ResponseHandler,
+                                     public OgreAllocatedObj
+    {
+        typedef SharedPtr<AsyncShaderJob>       AsyncShaderJobPtr;
+        typedef vector<AsyncShaderJobPtr>::type AsyncShaderJobVec;
+        typedef unordered_set<uint32>::type     PendingHashSet;
+
+        Hlms  *mCreator;
+        uint16 mChannel;
+
+        /// Lazily loaded. Shared with the jobs, as they may outlive a reset()
+        SharedPtr<AsyncShaderSources> mSources;
+        AsyncShaderJobVec             mPendingJobs;
+        /// Final hashes (renderable | pass) whose shaders are still being generated
+        PendingHashSet mPendingHashes;
+
+        void loadSources();
+        /// Returns the index of the new entry in Hlms::mShaderCodeCache
+        size_t compile( AsyncShaderJob &job );
+
+    public:
+        AsyncShaderHandler( Hlms *creator );
+        ~AsyncShaderHandler() override;
+
+        /// Forgets all pending jobs and the loaded templates. Jobs already
+        /// queued will still run, but their results will be discarded.
+        void reset();
+
+        size_t getNumPendingJobs() const { return mPendingJobs.size(); }
+
+        /// True if the shaders for the given final hash were requested and aren't ready
+        /// yet. Lets getMaterial skip merging the properties again every frame.
+        bool isPending( uint32 finalHash ) const
+        {
+            return mPendingHashes.find( finalHash ) != mPendingHashes.end();
+        }
+
+        /** Requests the shaders for the given properties & pieces.
+        @param codeCache
+            Same as in Hlms::compileShaderCode
+        @param finalHash
+            Hash of the HlmsCache entry that will use the shaders.
+            Remembered while they're being generated. See isPending
+        @param outCodeCacheIdx [out]
+            When returning true, index of the shaders in Hlms::mShaderCodeCache.
+        @return
+            True if the shaders are ready and were pushed to Hlms::mShaderCodeCache.
+            False if they're still being generated.
+        */
+        bool requestShader( const ShaderCodeCache &codeCache, uint32 finalHash,
+                            size_t &outCodeCacheIdx );
+
+        bool canHandleRequest( const WorkQueue::Request *req, const WorkQueue *srcQ ) override;
+        WorkQueue::Response *handleRequest( const WorkQueue::Request *req,
+                                            const WorkQueue          *srcQ ) override;
+        bool canHandleResponse( const WorkQueue::Response *res, const WorkQueue *srcQ ) override;
+        void handleResponse( const WorkQueue::Response *res, const WorkQueue *srcQ ) override;
+    };
+    //-----------------------------------------------------------------------------------
     void Hlms::setProperty( HlmsPropertyVec &properties, IdString key, int32 value )
     {
         HlmsProperty p( key, value );
@@ -899,7 +1031,7 @@ namespace Ogre
                 if( exp.value.c_str() == endPtr )
                 {
                     // This isn't a number. Let's try if it's a variable
-                    exp.result = getProperty( exp.value );
+                    exp.result = getProperty( getParserProperties(), exp.value );
                 }
                 lastExpWasOperator = false;
             }
@@ -1139,7 +1271,7 @@ namespace Ogre
         if( opValue == -std::numeric_limits<int>::max() )
         {
             // Not a number, interpret as property
-            opValue = getProperty( argValue );
+            opValue = getProperty( getParserProperties(), argValue );
         }
 
         return opValue;
@@ -1194,7 +1326,7 @@ namespace Ogre
                 const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1] );
 
                 int result = c_operations[keyword].opFunc( op1Value, op2Value );
-                setProperty( dstProperty, result );
+                setProperty( getParserProperties(), dstProperty, result );
             }
             else
             {
@@ -1267,7 +1399,7 @@ namespace Ogre
                 {
                     // This isn't a number. Let's try if it's a variable
                     // count = getProperty( argValues[0], -1 );
-                    count = getProperty( argValues[0], 0 );
+                    count = getProperty( getParserProperties(), argValues[0], 0 );
                 }
 
                 /*if( count < 0 )
@@ -1290,7 +1422,8 @@ namespace Ogre
                     if( argValues[2].c_str() == endPtr )
                     {
                         // This isn't a number. Let's try if it's a variable
-                        start = static_cast<int32>( getProperty( argValues[2], -1 ) );
+                        start = static_cast<int32>(
+                            getProperty( getParserProperties(), argValues[2], -1 ) );
                     }
 
                     if( start < 0 )
@@ -1397,9 +1530,10 @@ namespace Ogre
             if( !syntaxError )
             {
                 const IdString pieceName( argValues[0] );
-                PiecesMap::iterator it = mPieces.find( pieceName );
-                if( it != mPieces.end() )
-                    mPieces.erase( it );
+                PiecesMap &pieces = getParserPieces();
+                PiecesMap::iterator it = pieces.find( pieceName );
+                if( it != pieces.end() )
+                    pieces.erase( it );
             }
             else
             {
@@ -1439,8 +1573,9 @@ namespace Ogre
             if( !syntaxError )
             {
                 const IdString pieceName( argValues[0] );
-                PiecesMap::const_iterator it = mPieces.find( pieceName );
-                if( it != mPieces.end() )
+                PiecesMap &pieces = getParserPieces();
+                PiecesMap::const_iterator it = pieces.find( pieceName );
+                if( it != pieces.end() )
                 {
                     syntaxError = true;
                     printf( "Error at line %lu: @piece '%s' already defined",
@@ -1453,7 +1588,7 @@ namespace Ogre
 
                     String tmpBuffer;
                     copy( tmpBuffer, blockSubString, blockSubString.getSize() );
-                    mPieces[pieceName] = tmpBuffer;
+                    pieces[pieceName] = tmpBuffer;
 
                     subString.setStart( blockSubString.getEnd() + sizeof( "@end" ) );
                 }
@@ -1496,8 +1631,9 @@ namespace Ogre
             if( !syntaxError )
             {
                 const IdString pieceName( argValues[0] );
-                PiecesMap::const_iterator it = mPieces.find( pieceName );
-                if( it != mPieces.end() )
+                const PiecesMap &pieces = getParserPieces();
+                PiecesMap::const_iterator it = pieces.find( pieceName );
+                if( it != pieces.end() )
                     outBuffer += it->second;
             }
             else
@@ -1572,7 +1708,7 @@ namespace Ogre
                 {
                     const IdString dstProperty = argValues[0];
                     const IdString srcProperty = dstProperty;
-                    int op1Value = getProperty( srcProperty );
+                    int op1Value = getProperty( getParserProperties(), srcProperty );
 
                     //@value & @counter write, the others are invisible
                     char tmp[16];
@@ -1582,7 +1718,7 @@ namespace Ogre
                     if( keyword == 0 )
                     {
                         ++op1Value;
-                        setProperty( dstProperty, op1Value );
+                        setProperty( getParserProperties(), dstProperty, op1Value );
                     }
                 }
                 else
@@ -1593,7 +1729,7 @@ namespace Ogre
                     const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1] );
 
                     int result = c_counterOperations[keyword].opFunc( op1Value, op2Value );
-                    setProperty( dstProperty, result );
+                    setProperty( getParserProperties(), dstProperty, result );
                 }
             }
             else
@@ -1639,39 +1775,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     bool Hlms::parseOffline( const String &filename, String &inString, String &outString )
     {
-        mSetProperties.clear();
         mPieces.clear();
-
-        if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
-        {
-            setProperty( HlmsBaseProp::GL3Plus, mRenderSystem->getNativeShadingLanguageVersion() );
-        }
-        else if( mShaderProfile == "glsles" )  // TODO: String comparision
-        {
-            setProperty( HlmsBaseProp::GLES, mRenderSystem->getNativeShadingLanguageVersion() );
-        }
-
-        setProperty( HlmsBaseProp::Syntax, static_cast<int32>( mShaderSyntax.getU32Value() ) );
-        setProperty( HlmsBaseProp::Hlsl, static_cast<int32>( HlmsBaseProp::Hlsl.getU32Value() ) );
-        setProperty( HlmsBaseProp::Glsl, static_cast<int32>( HlmsBaseProp::Glsl.getU32Value() ) );
-        setProperty( HlmsBaseProp::Glsles, static_cast<int32>( HlmsBaseProp::Glsles.getU32Value() ) );
-        setProperty( HlmsBaseProp::Glslvk, static_cast<int32>( HlmsBaseProp::Glslvk.getU32Value() ) );
-        setProperty( HlmsBaseProp::Hlslvk, static_cast<int32>( HlmsBaseProp::Hlslvk.getU32Value() ) );
-        setProperty( HlmsBaseProp::Metal, static_cast<int32>( HlmsBaseProp::Metal.getU32Value() ) );
-
-#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
-        setProperty( HlmsBaseProp::iOS, 1 );
-#endif
-#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
-        setProperty( HlmsBaseProp::macOS, 1 );
-#endif
-        setProperty( HlmsBaseProp::Full32, static_cast<int32>( HlmsBaseProp::Full32.getU32Value() ) );
-        setProperty( HlmsBaseProp::Midf16, static_cast<int32>( HlmsBaseProp::Midf16.getU32Value() ) );
-        setProperty( HlmsBaseProp::Relaxed, static_cast<int32>( HlmsBaseProp::Relaxed.getU32Value() ) );
-        setProperty( HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
-
-        if( mFastShaderBuildHack )
-            setProperty( HlmsBaseProp::FastShaderBuildHack, 1 );
+        getBaseShaderProperties( mSetProperties );
 
         bool syntaxError = false;
 
@@ -2032,6 +2137,9 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void Hlms::clearShaderCache()
     {
+        if( mAsyncShaderHandler )
+            mAsyncShaderHandler->reset();
+
         mPassCache.clear();
 
         // Empty mShaderCache so that mHlmsManager->destroyMacroblock would
@@ -2076,21 +2184,99 @@ namespace Ogre
                 inString.resize( inFile->size() );
                 inFile->read( &inString[0], inFile->size() );
 
-                this->parseMath( inString, outString );
-                while( outString.find( "@foreach" ) != String::npos )
-                {
-                    this->parseForEach( outString, inString );
-                    inString.swap( outString );
-                }
-                this->parseProperties( outString, inString );
-                this->parseUndefPieces( inString, outString );
-                this->collectPieces( outString, inString );
-                this->parseCounter( inString, outString );
+                processPieceSource( inString, outString );
             }
             ++itor;
         }
     }
     //-----------------------------------------------------------------------------------
+    void Hlms::processPieceSource( String &inString, String &outString )
+    {
+        this->parseMath( inString, outString );
+        while( outString.find( "@foreach" ) != String::npos )
+        {
+            this->parseForEach( outString, inString );
+            inString.swap( outString );
+        }
+        this->parseProperties( outString, inString );
+        this->parseUndefPieces( inString, outString );
+        this->collectPieces( outString, inString );
+        this->parseCounter( inString, outString );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::preprocessShaderSource( String &inString, String &outString )
+    {
+        bool syntaxError = false;
+
+        syntaxError |= this->parseMath( inString, outString );
+        while( !syntaxError && outString.find( "@foreach" ) != String::npos )
+        {
+            syntaxError |= this->parseForEach( outString, inString );
+            inString.swap( outString );
+        }
+        syntaxError |= this->parseProperties( outString, inString );
+        syntaxError |= this->parseUndefPieces( inString, outString );
+        while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
+                                 outString.find( "@insertpiece" ) != String::npos ) )
+        {
+            syntaxError |= this->collectPieces( outString, inString );
+            syntaxError |= this->insertPieces( inString, outString );
+        }
+        syntaxError |= this->parseCounter( outString, inString );
+
+        outString.swap( inString );
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::getBaseShaderProperties( HlmsPropertyVec &outProperties ) const
+    {
+        outProperties.clear();
+
+        if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
+        {
+            setProperty( outProperties, HlmsBaseProp::GL3Plus,
+                         mRenderSystem->getNativeShadingLanguageVersion() );
+        }
+        else if( mShaderProfile == "glsles" )  // TODO: String comparision
+        {
+            setProperty( outProperties, HlmsBaseProp::GLES,
+                         mRenderSystem->getNativeShadingLanguageVersion() );
+        }
+
+        setProperty( outProperties, HlmsBaseProp::Syntax,
+                     static_cast<int32>( mShaderSyntax.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Hlsl,
+                     static_cast<int32>( HlmsBaseProp::Hlsl.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Glsl,
+                     static_cast<int32>( HlmsBaseProp::Glsl.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Glsles,
+                     static_cast<int32>( HlmsBaseProp::Glsles.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Glslvk,
+                     static_cast<int32>( HlmsBaseProp::Glslvk.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Hlslvk,
+                     static_cast<int32>( HlmsBaseProp::Hlslvk.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Metal,
+                     static_cast<int32>( HlmsBaseProp::Metal.getU32Value() ) );
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
+        setProperty( outProperties, HlmsBaseProp::iOS, 1 );
+#endif
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+        setProperty( outProperties, HlmsBaseProp::macOS, 1 );
+#endif
+        setProperty( outProperties, HlmsBaseProp::Full32,
+                     static_cast<int32>( HlmsBaseProp::Full32.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Midf16,
+                     static_cast<int32>( HlmsBaseProp::Midf16.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::Relaxed,
+                     static_cast<int32>( HlmsBaseProp::Relaxed.getU32Value() ) );
+        setProperty( outProperties, HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
+
+        if( mFastShaderBuildHack )
+            setProperty( outProperties, HlmsBaseProp::FastShaderBuildHack, 1 );
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::dumpProperties( std::ofstream &outFile )
     {
         outFile.write( "#if 0", sizeof( "#if 0" ) - 1u );
@@ -2226,8 +2412,8 @@ namespace Ogre
         return gp;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::_compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
-                                                     const String source[NumShaderTypes] )
+    size_t Hlms::_compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
+                                                       const String source[NumShaderTypes] )
     {
         OgreProfileExhaustive( "Hlms::_compileShaderFromPreprocessedSource" );
 
@@ -2253,10 +2439,13 @@ namespace Ogre
 
                     if( mDebugOutputProperties )
                         dumpProperties( debugDumpFile );
+
+                    debugDumpFile.write( &source[i][0],
+                                         static_cast<std::streamsize>( source[i].size() ) );
                 }
 
-                codeCache.shaders[i] =
-                    compileShaderCode( source[i], "", finalHash, static_cast<ShaderType>( i ) );
+                codeCache.shaders[i] = compileShaderCode( source[i], debugFilenameOutput, finalHash,
+                                                          static_cast<ShaderType>( i ) );
             }
         }
 
@@ -2266,9 +2455,10 @@ namespace Ogre
         OGRE_ASSERT_HIGH( codeCache.mergedCache.setProperties == mergedCache.setProperties );
 
         mShaderCodeCache.push_back( codeCache );
+        return mShaderCodeCache.size() - 1u;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::compileShaderCode( ShaderCodeCache &codeCache )
+    size_t Hlms::compileShaderCode( ShaderCodeCache &codeCache )
     {
         OgreProfileExhaustive( "Hlms::compileShaderCode" );
 
@@ -2277,6 +2467,9 @@ namespace Ogre
 
         mSetProperties = codeCache.mergedCache.setProperties;
 
+        HlmsPropertyVec baseProperties;
+        getBaseShaderProperties( baseProperties );
+
         // Generate the shaders
         for( size_t i = 0; i < NumShaderTypes; ++i )
         {
@@ -2286,47 +2479,15 @@ namespace Ogre
             const String filename = ShaderFiles[i] + mShaderFileExt;
             if( mDataFolder->exists( filename ) )
             {
-                if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
-                {
-                    setProperty( HlmsBaseProp::GL3Plus,
-                                 mRenderSystem->getNativeShadingLanguageVersion() );
-                }
-                else if( mShaderProfile == "glsles" )  // TODO: String comparision
+                HlmsPropertyVec::const_iterator itProp = baseProperties.begin();
+                HlmsPropertyVec::const_iterator enProp = baseProperties.end();
+
+                while( itProp != enProp )
                 {
-                    setProperty( HlmsBaseProp::GLES, mRenderSystem->getNativeShadingLanguageVersion() );
+                    setProperty( itProp->keyName, itProp->value );
+                    ++itProp;
                 }
 
-                setProperty( HlmsBaseProp::Syntax, static_cast<int32>( mShaderSyntax.getU32Value() ) );
-                setProperty( HlmsBaseProp::Hlsl,
-                             static_cast<int32>( HlmsBaseProp::Hlsl.getU32Value() ) );
-                setProperty( HlmsBaseProp::Glsl,
-                             static_cast<int32>( HlmsBaseProp::Glsl.getU32Value() ) );
-                setProperty( HlmsBaseProp::Glsles,
-                             static_cast<int32>( HlmsBaseProp::Glsles.getU32Value() ) );
-                setProperty( HlmsBaseProp::Glslvk,
-                             static_cast<int32>( HlmsBaseProp::Glslvk.getU32Value() ) );
-                setProperty( HlmsBaseProp::Hlslvk,
-                             static_cast<int32>( HlmsBaseProp::Hlslvk.getU32Value() ) );
-                setProperty( HlmsBaseProp::Metal,
-                             static_cast<int32>( HlmsBaseProp::Metal.getU32Value() ) );
-
-#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
-                setProperty( HlmsBaseProp::iOS, 1 );
-#endif
-#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
-                setProperty( HlmsBaseProp::macOS, 1 );
-#endif
-                setProperty( HlmsBaseProp::Full32,
-                             static_cast<int32>( HlmsBaseProp::Full32.getU32Value() ) );
-                setProperty( HlmsBaseProp::Midf16,
-                             static_cast<int32>( HlmsBaseProp::Midf16.getU32Value() ) );
-                setProperty( HlmsBaseProp::Relaxed,
-                             static_cast<int32>( HlmsBaseProp::Relaxed.getU32Value() ) );
-                setProperty( HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
-
-                if( mFastShaderBuildHack )
-                    setProperty( HlmsBaseProp::FastShaderBuildHack, 1 );
-
                 String debugFilenameOutput;
                 std::ofstream debugDumpFile;
                 if( mDebugOutput )
@@ -2365,25 +2526,7 @@ namespace Ogre
                 inString.resize( inFile->size() );
                 inFile->read( &inString[0], inFile->size() );
 
-                bool syntaxError = false;
-
-                syntaxError |= this->parseMath( inString, outString );
-                while( !syntaxError && outString.find( "@foreach" ) != String::npos )
-                {
-                    syntaxError |= this->parseForEach( outString, inString );
-                    inString.swap( outString );
-                }
-                syntaxError |= this->parseProperties( outString, inString );
-                syntaxError |= this->parseUndefPieces( inString, outString );
-                while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
-                                         outString.find( "@insertpiece" ) != String::npos ) )
-                {
-                    syntaxError |= this->collectPieces( outString, inString );
-                    syntaxError |= this->insertPieces( inString, outString );
-                }
-                syntaxError |= this->parseCounter( outString, inString );
-
-                outString.swap( inString );
+                const bool syntaxError = preprocessShaderSource( inString, outString );
 
                 if( syntaxError )
                 {
@@ -2412,6 +2555,265 @@ namespace Ogre
         }
 
         mShaderCodeCache.push_back( codeCache );
+        return mShaderCodeCache.size() - 1u;
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    void Hlms::AsyncShaderJob::preprocess()
+    {
+        OgreProfileExhaustive( "Hlms::AsyncShaderJob::preprocess" );
+
+        // Properties persist across stages, exactly like mSetProperties in compileShaderCode
+        HlmsPropertyVec properties( codeCache.mergedCache.setProperties );
+        PiecesMap pieces;
+
+        tlsParserProperties = &properties;
+        tlsParserPieces = &pieces;
+
+        String inString;
+        String outString;
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            if( !sources->hasTemplate[i] )
+                continue;
+
+            pieces = codeCache.mergedCache.pieces[i];
+
+            HlmsPropertyVec::const_iterator itProp = baseProperties.begin();
+            HlmsPropertyVec::const_iterator enProp = baseProperties.end();
+
+            while( itProp != enProp )
+            {
+                setProperty( properties, itProp->keyName, itProp->value );
+                ++itProp;
+            }
+
+            StringVector::const_iterator itor = sources->pieceFiles[i].begin();
+            StringVector::const_iterator endt = sources->pieceFiles[i].end();
+
+            while( itor != endt )
+            {
+                inString = *itor;
+                creator->processPieceSource( inString, outString );
+                ++itor;
+            }
+
+            inString = sources->templates[i];
+            syntaxError |= creator->preprocessShaderSource( inString, outString );
+
+            if( !getProperty( properties, HlmsBaseProp::DisableStage ) )
+                outSource[i].swap( outString );
+
+            setProperty( properties, HlmsBaseProp::DisableStage, 0 );
+        }
+
+        tlsParserProperties = 0;
+        tlsParserPieces = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    Hlms::AsyncShaderHandler::AsyncShaderHandler( Hlms *creator ) : mCreator( creator ), mChannel( 0 )
+    {
+        WorkQueue *workQueue = Root::getSingleton().getWorkQueue();
+        mChannel = workQueue->getChannel( "Hlms" );
+        workQueue->addRequestHandler( mChannel, this );
+        workQueue->addResponseHandler( mChannel, this );
+    }
+    //-----------------------------------------------------------------------------------
+    Hlms::AsyncShaderHandler::~AsyncShaderHandler()
+    {
+        Root *root = Root::getSingletonPtr();
+        if( root )
+        {
+            WorkQueue *workQueue = root->getWorkQueue();
+            if( workQueue )
+            {
+                // Waits for our requests currently being processed by worker threads
+                workQueue->removeRequestHandler( mChannel, this );
+                workQueue->removeResponseHandler( mChannel, this );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::AsyncShaderHandler::reset()
+    {
+        mSources.reset();
+        mPendingJobs.clear();
+        mPendingHashes.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::AsyncShaderHandler::loadSources()
+    {
+        // Archives are not thread safe. Read everything the workers need in advance.
+        mSources = SharedPtr<AsyncShaderSources>( OGRE_NEW AsyncShaderSources() );
+
+        const String &shaderFileExt = mCreator->mShaderFileExt;
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            StringVector &pieceFiles = mSources->pieceFiles[i];
+
+            for( size_t j = 0u; j <= mCreator->mLibrary.size(); ++j )
+            {
+                Archive *archive;
+                const StringVector *pieceFileNames;
+                if( j < mCreator->mLibrary.size() )
+                {
+                    archive = mCreator->mLibrary[j].dataFolder;
+                    pieceFileNames = &mCreator->mLibrary[j].pieceFiles[i];
+                }
+                else
+                {
+                    archive = mCreator->mDataFolder;
+                    pieceFileNames = &mCreator->mPieceFiles[i];
+                }
+
+                StringVector::const_iterator itor = pieceFileNames->begin();
+                StringVector::const_iterator endt = pieceFileNames->end();
+
+                while( itor != endt )
+                {
+                    // Same filter as Hlms::processPieces
+                    const String::size_type extPos0 = itor->find( shaderFileExt );
+                    const String::size_type extPos1 = itor->find( ".any" );
+                    if( extPos0 == itor->size() - shaderFileExt.size() ||
+                        extPos1 == itor->size() - 4u )
+                    {
+                        pieceFiles.push_back( archive->open( *itor )->getAsString() );
+                    }
+                    ++itor;
+                }
+            }
+
+            const String filename = ShaderFiles[i] + shaderFileExt;
+            mSources->hasTemplate[i] = mCreator->mDataFolder->exists( filename );
+            if( mSources->hasTemplate[i] )
+                mSources->templates[i] = mCreator->mDataFolder->open( filename )->getAsString();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t Hlms::AsyncShaderHandler::compile( AsyncShaderJob &job )
+    {
+        const uint32 finalHash =
+            mCreator->mType * 100000000u + static_cast<uint32>( mCreator->mShaderCodeCache.size() );
+
+        if( job.syntaxError )
+        {
+            LogManager::getSingleton().logMessage( "There were HLMS syntax errors while parsing " +
+                                                   StringConverter::toString( finalHash ) );
+        }
+
+        const size_t codeCacheIdx =
+            mCreator->_compileShaderFromPreprocessedSource( job.codeCache.mergedCache, job.outSource );
+        mCreator->mShaderCodeCache[codeCacheIdx].usageCount = job.usageCount;
+        return codeCacheIdx;
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::AsyncShaderHandler::requestShader( const ShaderCodeCache &codeCache, uint32 finalHash,
+                                                  size_t &outCodeCacheIdx )
+    {
+        AsyncShaderJobVec::iterator itor = mPendingJobs.begin();
+        AsyncShaderJobVec::iterator endt = mPendingJobs.end();
+
+        while( itor != endt && !( ( *itor )->codeCache == codeCache ) )
+            ++itor;
+
+        if( itor == endt )
+        {
+            if( !mSources )
+                loadSources();
+
+            AsyncShaderJobPtr job( OGRE_NEW AsyncShaderJob( mCreator, codeCache ) );
+            job->sources = mSources;
+            mCreator->getBaseShaderProperties( job->baseProperties );
+            if( mCreator->mDiskCacheWarmUp )
+                job->usageCount = mCreator->mDiskCacheWarmUp->_notifyCompilingOnDemand( codeCache );
+
+            mPendingJobs.push_back( job );
+            itor = mPendingJobs.end() - 1u;
+
+            WorkQueue *workQueue = Root::getSingleton().getWorkQueue();
+            if( !workQueue->addRequest( mChannel, 0, Any( job ) ) )
+            {
+                // The queue isn't accepting requests. Do it ourselves.
+                job->preprocess();
+                job->finished = true;
+            }
+            // Without threading support, the WorkQueue may have already finished it
+        }
+
+        if( !( *itor )->finished )
+        {
+            ( *itor )->finalHashes.push_back( finalHash );
+            mPendingHashes.insert( finalHash );
+            return false;
+        }
+
+        AsyncShaderJobPtr job = *itor;
+        efficientVectorRemove( mPendingJobs, itor );
+        outCodeCacheIdx = compile( *job );
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::AsyncShaderHandler::canHandleRequest( const WorkQueue::Request *req,
+                                                     const WorkQueue *srcQ )
+    {
+        return WorkQueue::RequestHandler::canHandleRequest( req, srcQ ) &&
+               any_cast<AsyncShaderJobPtr>( req->getData() )->creator == mCreator;
+    }
+    //-----------------------------------------------------------------------------------
+    WorkQueue::Response *Hlms::AsyncShaderHandler::handleRequest( const WorkQueue::Request *req,
+                                                                  const WorkQueue *srcQ )
+    {
+        // Called from a worker thread
+        AsyncShaderJobPtr job = any_cast<AsyncShaderJobPtr>( req->getData() );
+        job->preprocess();
+        return OGRE_NEW WorkQueue::Response( req, true, req->getData() );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::AsyncShaderHandler::canHandleResponse( const WorkQueue::Response *res,
+                                                      const WorkQueue *srcQ )
+    {
+        return WorkQueue::ResponseHandler::canHandleResponse( res, srcQ ) &&
+               any_cast<AsyncShaderJobPtr>( res->getData() )->creator == mCreator;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::AsyncShaderHandler::handleResponse( const WorkQueue::Response *res,
+                                                   const WorkQueue *srcQ )
+    {
+        // Called from the main thread. The job may no longer be pending if
+        // the shader cache got cleared meanwhile, in which case nobody will
+        // look at it again and it gets freed along with the response.
+        AsyncShaderJobPtr job = any_cast<AsyncShaderJobPtr>( res->getData() );
+        job->finished = true;
+
+        // Let the waiting entries through, so that the next getMaterial compiles it
+        vector<uint32>::type::const_iterator itor = job->finalHashes.begin();
+        vector<uint32>::type::const_iterator endt = job->finalHashes.end();
+        while( itor != endt )
+            mPendingHashes.erase( *itor++ );
+        job->finalHashes.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    void Hlms::setAsyncShaderGeneration( bool bAsync )
+    {
+        if( bAsync && !mAsyncShaderHandler )
+        {
+            mAsyncShaderHandler = OGRE_NEW AsyncShaderHandler( this );
+        }
+        else if( !bAsync && mAsyncShaderHandler )
+        {
+            OGRE_DELETE mAsyncShaderHandler;
+            mAsyncShaderHandler = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t Hlms::getNumPendingAsyncShaders() const
+    {
+        return mAsyncShaderHandler ? mAsyncShaderHandler->getNumPendingJobs() : 0u;
     }
     //-----------------------------------------------------------------------------------
     const HlmsCache *Hlms::createShaderCacheEntry( uint32 renderableHash, const HlmsCache &passCache,
@@ -2468,13 +2870,32 @@ namespace Ogre
         {
             ShaderCodeCacheVec::iterator itCodeCache =
                 std::find( mShaderCodeCache.begin(), mShaderCodeCache.end(), codeCache );
+            if( itCodeCache == mShaderCodeCache.end() && mAsyncShaderHandler &&
+                mAsyncShaderRequestAllowed )
+            {
+                size_t codeCacheIdx;
+                if( !mAsyncShaderHandler->requestShader( codeCache, finalHash, codeCacheIdx ) )
+                    return 0;  // Still being generated. Caller will skip this renderable.
+
+                // requestShader has just compiled it.
+                itCodeCache = mShaderCodeCache.begin() + static_cast<ptrdiff_t>( codeCacheIdx );
+            }
+
             if( itCodeCache == mShaderCodeCache.end() )
-                compileShaderCode( codeCache );
+            {
+                uint32 usageCount = 0u;
+                if( mDiskCacheWarmUp )
+                    usageCount = mDiskCacheWarmUp->_notifyCompilingOnDemand( codeCache );
+                const size_t codeCacheIdx = compileShaderCode( codeCache );
+                mShaderCodeCache[codeCacheIdx].usageCount = usageCount + 1u;
+            }
             else
             {
                 for( size_t i = 0; i < NumShaderTypes; ++i )
                     codeCache.shaders[i] = itCodeCache->shaders[i];
                 codeCache.mergedCache.setProperties.swap( mSetProperties );
+                if( itCodeCache->usageCount != std::numeric_limits<uint32>::max() )
+                    ++itCodeCache->usageCount;
             }
         }
 
@@ -3437,7 +3858,7 @@ namespace Ogre
     const HlmsCache *Hlms::getMaterial( HlmsCache const *lastReturnedValue,        //
                                         const HlmsCache &passCache,                //
                                         const QueuedRenderable &queuedRenderable,  //
-                                        bool casterPass )
+                                        bool casterPass, bool allowAsync )
     {
         uint32 finalHash;
         uint32 hash[2];
@@ -3459,16 +3880,34 @@ namespace Ogre
         {
             lastReturnedValue = this->getShaderCache( finalHash );
 
+            if( !lastReturnedValue && allowAsync && mAsyncShaderHandler &&
+                mAsyncShaderHandler->isPending( finalHash ) )
+            {
+                // Still being generated. Don't merge the properties again
+                return 0;
+            }
+
             if( !lastReturnedValue )
             {
+                mAsyncShaderRequestAllowed = allowAsync;
                 lastReturnedValue =
                     createShaderCacheEntry( hash[0], passCache, finalHash, queuedRenderable );
+                mAsyncShaderRequestAllowed = false;
             }
         }
 
         return lastReturnedValue;
     }
     //-----------------------------------------------------------------------------------
+    const HlmsCache *Hlms::findMaterial( const HlmsCache &passCache,
+                                         const QueuedRenderable &queuedRenderable,
+                                         bool casterPass ) const
+    {
+        const uint32 renderableHash = casterPass ? queuedRenderable.renderable->getHlmsCasterHash()
+                                                 : queuedRenderable.renderable->getHlmsHash();
+        return this->getShaderCache( renderableHash | passCache.hash );
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::setDebugOutputPath( bool enableDebugOutput, bool outputProperties, const String &path )
     {
         mDebugOutput = enableDebugOutput;
@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "OgreProfiler.h"
 #include "OgreRenderSystem.h"
 #include "OgreStringConverter.h"
+#include "OgreTimer.h"
 
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
 #    include "iOS/macUtils.h"
@@ -42,11 +43,50 @@ THE SOFTWARE.
 
 namespace Ogre
 {
-    static const uint16 c_hlmsDiskCacheVersion = 4u;
+    static const uint16 c_hlmsDiskCacheVersion = 5u;
+    static const uint32 c_warmUpEntryDone = 0xFFFFFFFF;
+
+    /// Sorts indices to HlmsDiskCache::SourceCodeVec by descending usage count
+    struct MostUsedFirst
+    {
+        const HlmsDiskCache::SourceCodeVec &sourceCode;
+
+        MostUsedFirst( const HlmsDiskCache::SourceCodeVec &_sourceCode ) : sourceCode( _sourceCode ) {}
+
+        bool operator()( uint32 a, uint32 b ) const
+        {
+            return sourceCode[a].usageCount > sourceCode[b].usageCount;
+        }
+    };
+
+    /// Hash of Hlms::RenderableCache::setProperties, to quickly find warm-up entries.
+    /// Collisions are resolved by comparing the whole RenderableCache.
+    static uint32 hashSetProperties( const HlmsPropertyVec &properties )
+    {
+        uint32 retVal = 0u;
+        HlmsPropertyVec::const_iterator itor = properties.begin();
+        HlmsPropertyVec::const_iterator endt = properties.end();
+        while( itor != endt )
+        {
+            retVal = retVal * 31u + itor->keyName.getU32Value();
+            retVal = retVal * 31u + static_cast<uint32>( itor->value );
+            ++itor;
+        }
+        return retVal;
+    }
+
+    /// Usage counts from previous runs lose half their weight every run.
+    /// See Hlms::ShaderCodeCache::usageCount
+    static uint32 decayUsageCount( uint32 usageCount ) { return usageCount >> 1u; }
 
     HlmsDiskCache::HlmsDiskCache( HlmsManager *hlmsManager ) :
         mTemplatesOutOfDate( false ),
-        mHlmsManager( hlmsManager )
+        mHlmsManager( hlmsManager ),
+        mWarmUpHlms( 0 ),
+        mNextWarmUp( 0u ),
+        mNumPendingWarmUp( 0u ),
+        mNumWarmUpStalls( 0u ),
+        mNumUnloggedStalls( 0u )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -54,6 +94,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsDiskCache::clearCache()
     {
+        endWarmUp();
+
         mTemplatesOutOfDate = false;
         memset( mCache.templateHash, 0, sizeof( mCache.templateHash ) );
         mCache.type = 255;
@@ -68,10 +110,11 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
-    HlmsDiskCache::SourceCode::SourceCode() : mergedCache( HlmsPropertyVec(), 0 ) {}
+    HlmsDiskCache::SourceCode::SourceCode() : mergedCache( HlmsPropertyVec(), 0 ), usageCount( 0u ) {}
     //-----------------------------------------------------------------------------------
     HlmsDiskCache::SourceCode::SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache ) :
-        mergedCache( shaderCodeCache.mergedCache )
+        mergedCache( shaderCodeCache.mergedCache ),
+        usageCount( shaderCodeCache.usageCount )
     {
         for( size_t i = 0; i < NumShaderTypes; ++i )
         {
@@ -96,6 +139,10 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsDiskCache::copyFrom( Hlms *hlms )
     {
+        // Don't lose the shaders that haven't been compiled yet
+        if( mWarmUpHlms == hlms )
+            warmUp( std::numeric_limits<uint64>::max() );
+
         clearCache();
 
         mCache.type = hlms->getType();
@@ -142,18 +189,15 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void HlmsDiskCache::applyTo( Hlms *hlms )
+    bool HlmsDiskCache::checkCompatibility( Hlms *hlms )
     {
-        LogManager::getSingleton().logMessage( "Applying HlmsDiskCache " +
-                                               StringConverter::toString( hlms->getType() ) );
-
         if( mCache.type != hlms->getType() )
         {
             LogManager::getSingleton().logMessage(
                 "WARNING: The cached Hlms is for type " + StringConverter::toString( mCache.type ) +
                 " but it is being applied to Hlms type: " +
                 StringConverter::toString( hlms->getType() ) + ". HlmsDiskCache won't be applied." );
-            return;
+            return false;
         }
 
         if( mShaderProfile != hlms->getShaderProfile() )
@@ -209,30 +253,76 @@ namespace Ogre
             }
         }
 
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::compileSourceCode( const SourceCode &sourceCode )
+    {
+        Hlms *hlms = mWarmUpHlms;
+        size_t codeCacheIdx;
+        if( !mTemplatesOutOfDate )
+        {
+            // Templates haven't changed, send the Hlms-processed shader code for compilation
+            codeCacheIdx = hlms->_compileShaderFromPreprocessedSource( sourceCode.mergedCache,
+                                                                       sourceCode.sourceFile );
+        }
+        else
+        {
+            // Templates have changed, they need to be run through the Hlms
+            // preprocessor again before they can be compiled again
+            Hlms::ShaderCodeCache shaderCodeCache( sourceCode.mergedCache.pieces );
+            shaderCodeCache.mergedCache.setProperties = sourceCode.mergedCache.setProperties;
+            codeCacheIdx = hlms->compileShaderCode( shaderCodeCache );
+        }
+
+        // Keep accumulating across runs
+        hlms->mShaderCodeCache[codeCacheIdx].usageCount = decayUsageCount( sourceCode.usageCount );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::applyTo( Hlms *hlms )
+    {
+        if( beginWarmUp( hlms ) )
+            warmUp( std::numeric_limits<uint64>::max() );
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::beginWarmUp( Hlms *hlms )
+    {
+        LogManager::getSingleton().logMessage( "Applying HlmsDiskCache " +
+                                               StringConverter::toString( hlms->getType() ) );
+
+        endWarmUp();
+
+        if( !checkCompatibility( hlms ) )
+            return false;
+
         hlms->clearShaderCache();
 
+        mWarmUpHlms = hlms;
+        hlms->_setDiskCacheWarmUp( this );
+        mNextWarmUp = 0u;
+        mNumWarmUpStalls = 0u;
+        mNumUnloggedStalls = 0u;
+
         {
-            // Compile shaders
-            SourceCodeVec::const_iterator itor = mCache.sourceCode.begin();
-            SourceCodeVec::const_iterator endt = mCache.sourceCode.end();
+            // Most used shaders first
+            const uint32 numEntries = static_cast<uint32>( mCache.sourceCode.size() );
+            mWarmUpOrder.resize( numEntries );
+            for( uint32 i = 0u; i < numEntries; ++i )
+                mWarmUpOrder[i] = i;
 
-            while( itor != endt )
+            std::stable_sort( mWarmUpOrder.begin(), mWarmUpOrder.end(),
+                              MostUsedFirst( mCache.sourceCode ) );
+
+            mWarmUpLookup.resize( numEntries );
+            for( uint32 i = 0u; i < numEntries; ++i )
             {
-                if( !mTemplatesOutOfDate )
-                {
-                    // Templates haven't changed, send the Hlms-processed shader code for compilation
-                    hlms->_compileShaderFromPreprocessedSource( itor->mergedCache, itor->sourceFile );
-                }
-                else
-                {
-                    // Templates have changed, they need to be run through the Hlms
-                    // preprocessor again before they can be compiled again
-                    Hlms::ShaderCodeCache shaderCodeCache( itor->mergedCache.pieces );
-                    shaderCodeCache.mergedCache.setProperties = itor->mergedCache.setProperties;
-                    hlms->compileShaderCode( shaderCodeCache );
-                }
-                ++itor;
+                const SourceCode &sourceCode = mCache.sourceCode[mWarmUpOrder[i]];
+                const uint32 hash = hashSetProperties( sourceCode.mergedCache.setProperties );
+                mWarmUpLookup[i] = std::pair<uint32, uint32>( hash, i );
             }
+            std::sort( mWarmUpLookup.begin(), mWarmUpLookup.end() );
+
+            mNumPendingWarmUp = numEntries;
         }
 
         {
@@ -273,6 +363,97 @@ namespace Ogre
                 ++itor;
             }
         }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::warmUp( uint64 maxMicroseconds )
+    {
+        if( !mWarmUpHlms )
+            return true;
+
+        OgreProfileExhaustive( "HlmsDiskCache::warmUp" );
+
+        if( mNumUnloggedStalls )
+        {
+            LogManager::getSingleton().logMessage(
+                "HlmsDiskCache: stall. Draws needed " + StringConverter::toString( mNumUnloggedStalls ) +
+                " shader(s) the warm-up hadn't compiled yet (" +
+                StringConverter::toString( mNumPendingWarmUp ) + " pending)." );
+            mNumUnloggedStalls = 0u;
+        }
+
+        Timer timer;
+        const uint64 startTime = timer.getMicroseconds();
+
+        const size_t numEntries = mWarmUpOrder.size();
+        bool bTimeLeft = true;
+        while( mNextWarmUp < numEntries && bTimeLeft )
+        {
+            const uint32 entryIdx = mWarmUpOrder[mNextWarmUp++];
+            if( entryIdx != c_warmUpEntryDone )
+            {
+                --mNumPendingWarmUp;
+                compileSourceCode( mCache.sourceCode[entryIdx] );
+                bTimeLeft = ( timer.getMicroseconds() - startTime ) < maxMicroseconds;
+            }
+        }
+
+        if( mNextWarmUp < numEntries )
+            return false;
+
+        if( mNumWarmUpStalls )
+        {
+            LogManager::getSingleton().logMessage(
+                "HlmsDiskCache: warm-up finished. " + StringConverter::toString( mNumWarmUpStalls ) +
+                " shader(s) had to be compiled on demand before the warm-up reached them." );
+        }
+        endWarmUp();
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::endWarmUp()
+    {
+        if( mWarmUpHlms )
+        {
+            mWarmUpHlms->_setDiskCacheWarmUp( 0 );
+            mWarmUpHlms = 0;
+        }
+        mWarmUpOrder.clear();
+        mWarmUpLookup.clear();
+        mNextWarmUp = 0u;
+        mNumPendingWarmUp = 0u;
+        mNumUnloggedStalls = 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 HlmsDiskCache::_notifyCompilingOnDemand( const Hlms::ShaderCodeCache &codeCache )
+    {
+        typedef vector<std::pair<uint32, uint32> >::type::const_iterator LookupIterator;
+
+        const std::pair<uint32, uint32> key(
+            hashSetProperties( codeCache.mergedCache.setProperties ), 0u );
+        LookupIterator itor = std::lower_bound( mWarmUpLookup.begin(), mWarmUpLookup.end(), key );
+        LookupIterator endt = mWarmUpLookup.end();
+
+        while( itor != endt && itor->first == key.first )
+        {
+            const size_t warmUpIdx = itor->second;
+            const uint32 entryIdx = mWarmUpOrder[warmUpIdx];
+            if( warmUpIdx >= mNextWarmUp && entryIdx != c_warmUpEntryDone &&
+                mCache.sourceCode[entryIdx].mergedCache == codeCache.mergedCache )
+            {
+                // The draw got here before the warm-up did. It will compile it, we won't.
+                mWarmUpOrder[warmUpIdx] = c_warmUpEntryDone;
+                --mNumPendingWarmUp;
+                ++mNumWarmUpStalls;
+                // Logged by the next warmUp call
+                ++mNumUnloggedStalls;
+                return decayUsageCount( mCache.sourceCode[entryIdx].usageCount );
+            }
+            ++itor;
+        }
+
+        return 0u;
     }
     //-----------------------------------------------------------------------------------
     template <typename T>
@@ -371,6 +552,7 @@ namespace Ogre
                 save( dataStream, itor->mergedCache );
                 for( size_t i = 0; i < NumShaderTypes; ++i )
                     save( dataStream, itor->sourceFile[i] );
+                write<uint32>( dataStream, itor->usageCount );
 
                 ++itor;
             }
@@ -537,6 +719,19 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsDiskCache::loadFrom( DataStreamPtr &dataStream )
     {
+        if( !dataStream->getContiguousPtr() )
+        {
+            // The cache is parsed with lots of tiny reads. Prebuffer it into RAM
+            // if it isn't already there (e.g. memory-mapped files)
+            DataStreamPtr cachedCopy( OGRE_NEW MemoryDataStream( dataStream->getName(), dataStream ) );
+            // An empty stream may have no memory at all. Don't recurse forever
+            if( cachedCopy->getContiguousPtr() )
+            {
+                loadFrom( cachedCopy );
+                return;
+            }
+        }
+
         LogManager::getSingleton().logMessage( "Loading HlmsDiskCache from " + dataStream->getName() );
 
         clearCache();
@@ -589,6 +784,7 @@ namespace Ogre
                 load( dataStream, sourceCode.mergedCache );
                 for( size_t j = 0; j < NumShaderTypes; ++j )
                     load( dataStream, sourceCode.sourceFile[j] );
+                read( dataStream, sourceCode.usageCount );
                 mCache.sourceCode.push_back( sourceCode );
             }
         }
@@ -130,7 +130,11 @@ namespace Ogre
 
         mRenderSystem->_hlmsPipelineStateObjectCreated( &pso );
 
+        // Unlike Hlms::createShaderCacheEntry this never returns null, even if
+        // setAsyncShaderGeneration was enabled: the shaders come from the material and
+        // there is nothing to generate.
         const HlmsCache *retVal = addShaderCache( finalHash, pso );
+        OGRE_ASSERT_LOW( retVal );
         return retVal;
     }
     //-----------------------------------------------------------------------------------
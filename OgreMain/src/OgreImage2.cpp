@@ -41,9 +41,98 @@ THE SOFTWARE.
 #include "OgreResourceGroupManager.h"
 #include "OgreStagingTexture.h"
 #include "OgreTextureGpuManager.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 namespace Ogre
 {
+    /// Below this many bytes per task it's not worth waking up the multiload threadpool
+    static const size_t c_minBytesPerMipmapTask = 64u * 1024u;
+    static const uint32 c_maxMipmapTasks = 32u;
+
+    /// Splits the downsampling of a single mip level in bands of rows (2D), slices (3D)
+    /// or faces (cubemaps), so that Image2::generateMipmaps can process them in parallel
+    class MipmapDownsampleTask final : public UniformScalableTask
+    {
+        TextureTypes::TextureTypes mTextureType;
+        ImageDownsampler2D *mDownsampler2DFunc;
+        ImageDownsampler3D *mDownsampler3DFunc;
+        ImageDownsamplerCube *mDownsamplerCubeFunc;
+        const FilterKernel &mFilter;
+        TextureBox mDstBox;
+        TextureBox mSrcBox;
+
+    public:
+        MipmapDownsampleTask( TextureTypes::TextureTypes textureType,
+                              ImageDownsampler2D *downsampler2DFunc,
+                              ImageDownsampler3D *downsampler3DFunc,
+                              ImageDownsamplerCube *downsamplerCubeFunc, const FilterKernel &filter,
+                              const TextureBox &dstBox, const TextureBox &srcBox ) :
+            mTextureType( textureType ),
+            mDownsampler2DFunc( downsampler2DFunc ),
+            mDownsampler3DFunc( downsampler3DFunc ),
+            mDownsamplerCubeFunc( downsamplerCubeFunc ),
+            mFilter( filter ),
+            mDstBox( dstBox ),
+            mSrcBox( srcBox )
+        {
+        }
+
+        /// Returns in how many pieces this mip level can be split
+        uint32 getNumUnits() const
+        {
+            if( mTextureType == TextureTypes::TypeCube )
+                return 6u;
+            else if( mTextureType == TextureTypes::Type3D )
+                return mDstBox.depth;
+            return mDstBox.height;
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            const size_t numUnits = getNumUnits();
+            const int32 unitStart = static_cast<int32>( numUnits * threadId / numThreads );
+            const int32 unitEnd = static_cast<int32>( numUnits * ( threadId + 1u ) / numThreads );
+
+            if( mTextureType == TextureTypes::TypeCube )
+            {
+                uint8 const *upFaces[6];
+                for( size_t j = 0; j < 6; ++j )
+                    upFaces[j] = reinterpret_cast<uint8 *>( mSrcBox.at( 0, 0, j ) );
+
+                for( int32 j = unitStart; j < unitEnd; ++j )
+                {
+                    uint8 *downFace = reinterpret_cast<uint8 *>( mDstBox.at( 0, 0, size_t( j ) ) );
+                    ( *mDownsamplerCubeFunc )(
+                        downFace, upFaces, static_cast<int32>( mDstBox.width ),
+                        static_cast<int32>( mDstBox.height ), static_cast<int32>( mDstBox.bytesPerRow ),
+                        static_cast<int32>( mSrcBox.width ), static_cast<int32>( mSrcBox.height ),
+                        static_cast<int32>( mSrcBox.bytesPerRow ), mFilter.kernel, mFilter.kernelStartX,
+                        mFilter.kernelEndX, mFilter.kernelStartY, mFilter.kernelEndY,
+                        static_cast<uint8>( j ) );
+                }
+            }
+            else if( mTextureType == TextureTypes::Type3D )
+            {
+                ( *mDownsampler3DFunc )(
+                    reinterpret_cast<uint8 *>( mDstBox.data ), reinterpret_cast<uint8 *>( mSrcBox.data ),
+                    static_cast<int32>( mDstBox.width ), static_cast<int32>( mDstBox.height ),
+                    static_cast<int32>( mDstBox.depth ), static_cast<int32>( mDstBox.bytesPerRow ),
+                    static_cast<int32>( mDstBox.bytesPerImage ), static_cast<int32>( mSrcBox.width ),
+                    static_cast<int32>( mSrcBox.height ), static_cast<int32>( mSrcBox.bytesPerRow ),
+                    static_cast<int32>( mSrcBox.bytesPerImage ), unitStart, unitEnd );
+            }
+            else
+            {
+                ( *mDownsampler2DFunc )(
+                    reinterpret_cast<uint8 *>( mDstBox.data ), reinterpret_cast<uint8 *>( mSrcBox.data ),
+                    static_cast<int32>( mDstBox.width ), static_cast<int32>( mDstBox.height ),
+                    static_cast<int32>( mDstBox.bytesPerRow ), static_cast<int32>( mSrcBox.width ),
+                    static_cast<int32>( mSrcBox.bytesPerRow ), mFilter.kernel, mFilter.kernelStartX,
+                    mFilter.kernelEndX, mFilter.kernelStartY, mFilter.kernelEndY, unitStart, unitEnd );
+            }
+        }
+    };
+    //-----------------------------------------------------------------------------------
     ImageCodec2::~ImageCodec2() {}
     //-----------------------------------------------------------------------------------
     Image2::Image2() :
@@ -1080,7 +1169,8 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    bool Image2::generateMipmaps( bool gammaCorrected, Filter filter )
+    bool Image2::generateMipmaps( bool gammaCorrected, Filter filter,
+                                  TextureGpuManager *textureManager )
     {
         OgreProfileExhaustive( "Image2::generateMipmaps" );
 
@@ -1178,81 +1268,51 @@ namespace Ogre
             TextureBox box0 = this->getData( i - 1u );
             TextureBox box1 = this->getData( i );
 
-            if( mTextureType == TextureTypes::TypeCube )
+            if( filter == FILTER_GAUSSIAN_HIGH && mTextureType != TextureTypes::TypeCube &&
+                mTextureType != TextureTypes::Type3D )
             {
-                uint8 const *upFaces[6];
-                for( size_t j = 0; j < 6; ++j )
-                    upFaces[j] = reinterpret_cast<uint8 *>( box0.at( 0, 0, j ) );
-
-                for( size_t j = 0; j < 6; ++j )
-                {
-                    uint8 *downFace = reinterpret_cast<uint8 *>( box1.at( 0, 0, j ) );
-                    ( *downsamplerCubeFunc )(
-                        reinterpret_cast<uint8 *>( downFace ), upFaces, static_cast<int32>( dstWidth ),
-                        static_cast<int32>( dstHeight ), static_cast<int32>( box1.bytesPerRow ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( srcHeight ),
-                        static_cast<int32>( box0.bytesPerRow ), chosenFilter.kernel,
-                        chosenFilter.kernelStartX, chosenFilter.kernelEndX, chosenFilter.kernelStartY,
-                        chosenFilter.kernelEndY, static_cast<uint8>( j ) );
-                }
+                // tmpImage0 should contain one or more mips (from mip 0), and tmpBuffer1 should
+                // be large enough to contain mip 0. This assert should never trigger.
+                assert( tmpImage0.getSizeBytes() >= box0.getSizeBytes() );
+
+                // Copy box0 to tmpImage0
+                memcpy( tmpImage0.mBuffer, box0.data, box0.getSizeBytes() );
+
+                // The image right now is in both box0 and tmpImage0. We can't touch box0,
+                // So we blur tmpImage0, and use tmpBuffer1 to store intermediate results
+                const FilterSeparableKernel &separableKernel = c_filterSeparableKernels[0];
+                ( *separableBlur2DFunc )(
+                    tmpBuffer1, reinterpret_cast<uint8 *>( tmpImage0.mBuffer ),
+                    static_cast<int32>( srcWidth ), static_cast<int32>( srcHeight ),
+                    static_cast<int32>( box0.bytesPerRow ), separableKernel.kernel,
+                    separableKernel.kernelStart, separableKernel.kernelEnd );
+                // Filter again...
+                ( *separableBlur2DFunc )( tmpBuffer1, reinterpret_cast<uint8 *>( tmpImage0.mBuffer ),
+                                          static_cast<int32>( srcWidth ),
+                                          static_cast<int32>( srcHeight ),  //
+                                          static_cast<int32>( box0.bytesPerRow ),
+                                          separableKernel.kernel, separableKernel.kernelStart,
+                                          separableKernel.kernelEnd );
+
+                // Now that tmpImage0 is blurred, bilinear downsample its contents into box1.
+                box0.data = tmpImage0.mBuffer;
             }
-            else if( mTextureType == TextureTypes::Type3D )
+
+            MipmapDownsampleTask task( mTextureType, downsampler2DFunc, downsampler3DFunc,
+                                       downsamplerCubeFunc, chosenFilter, box1, box0 );
+
+            uint32 numTasks = 1u;
+            if( textureManager )
             {
-                ( *downsampler3DFunc )(
-                    reinterpret_cast<uint8 *>( box1.data ), reinterpret_cast<uint8 *>( box0.data ),
-                    static_cast<int32>( dstWidth ), static_cast<int32>( dstHeight ),
-                    static_cast<int32>( dstDepth ), static_cast<int32>( box1.bytesPerRow ),
-                    static_cast<int32>( box1.bytesPerImage ), static_cast<int32>( srcWidth ),
-                    static_cast<int32>( srcHeight ), static_cast<int32>( box0.bytesPerRow ),
-                    static_cast<int32>( box0.bytesPerImage ) );
+                const size_t numTasksBySize = box1.getSizeBytes() / c_minBytesPerMipmapTask;
+                numTasks = static_cast<uint32>( std::min<size_t>( numTasksBySize, c_maxMipmapTasks ) );
+                numTasks = std::max( std::min( numTasks, task.getNumUnits() ), 1u );
             }
+
+            if( numTasks > 1u )
+                textureManager->_executeOnMultiLoadPool( &task, numTasks );
             else
-            {
-                if( filter != FILTER_GAUSSIAN_HIGH )
-                {
-                    ( *downsampler2DFunc )(
-                        reinterpret_cast<uint8 *>( box1.data ), reinterpret_cast<uint8 *>( box0.data ),
-                        static_cast<int32>( dstWidth ), static_cast<int32>( dstHeight ),
-                        static_cast<int32>( box1.bytesPerRow ), static_cast<int32>( srcWidth ),
-                        static_cast<int32>( box0.bytesPerRow ), chosenFilter.kernel,
-                        chosenFilter.kernelStartX, chosenFilter.kernelEndX, chosenFilter.kernelStartY,
-                        chosenFilter.kernelEndY );
-                }
-                else
-                {
-                    // tmpImage0 should contain one or more mips (from mip 0), and tmpBuffer1 should
-                    // be large enough to contain mip 0. This assert should never trigger.
-                    assert( tmpImage0.getSizeBytes() >= box0.getSizeBytes() );
-
-                    // Copy box0 to tmpImage0
-                    memcpy( tmpImage0.mBuffer, box0.data, box0.getSizeBytes() );
-
-                    // The image right now is in both box0 and tmpImage0. We can't touch box0,
-                    // So we blur tmpImage0, and use tmpBuffer1 to store intermediate results
-                    const FilterSeparableKernel &separableKernel = c_filterSeparableKernels[0];
-                    ( *separableBlur2DFunc )(
-                        tmpBuffer1, reinterpret_cast<uint8 *>( tmpImage0.mBuffer ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( srcHeight ),
-                        static_cast<int32>( box0.bytesPerRow ), separableKernel.kernel,
-                        separableKernel.kernelStart, separableKernel.kernelEnd );
-                    // Filter again...
-                    ( *separableBlur2DFunc )( tmpBuffer1, reinterpret_cast<uint8 *>( tmpImage0.mBuffer ),
-                                              static_cast<int32>( srcWidth ),
-                                              static_cast<int32>( srcHeight ),  //
-                                              static_cast<int32>( box0.bytesPerRow ),
-                                              separableKernel.kernel, separableKernel.kernelStart,
-                                              separableKernel.kernelEnd );
-
-                    // Now that tmpImage0 is blurred, bilinear downsample its contents into box1.
-                    ( *downsampler2DFunc )(
-                        reinterpret_cast<uint8 *>( box1.data ),
-                        reinterpret_cast<uint8 *>( tmpImage0.mBuffer ), static_cast<int32>( dstWidth ),
-                        static_cast<int32>( dstHeight ), static_cast<int32>( box1.bytesPerRow ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( box0.bytesPerRow ),
-                        chosenFilter.kernel, chosenFilter.kernelStartX, chosenFilter.kernelEndX,
-                        chosenFilter.kernelStartY, chosenFilter.kernelEndY );
-                }
-            }
+                task.execute( 0u, 1u );
         }
 
         if( tmpBuffer1 )
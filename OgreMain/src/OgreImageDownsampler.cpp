@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 #include "OgreImageDownsampler.h"
 
+#include "Math/Array/OgreArrayConfig.h"
+
 namespace Ogre
 {
     struct CubemapUVI
@@ -175,6 +177,332 @@ namespace Ogre
             -2, 2
         }
     };
+
+    namespace
+    {
+        // The downscaleRow2x2_* functions average 2x2 blocks of src0 & src1 (two consecutive rows)
+        // for as many destination pixels as they can in bulk and return how many they wrote.
+        // They only handle the bilinear filter away from the image borders, and produce the exact
+        // same results as the scalar code in OgreImageDownsamplerImpl.inl, which takes care of
+        // the remainder.
+#if __OGRE_HAVE_SSE
+        /// Returns the sum of each pair of consecutive pixels in 16 bytes as 8 uint16
+        template <size_t C>
+        inline __m128i pairSumU8_SSE2( __m128i px );
+        template <>
+        inline __m128i pairSumU8_SSE2<1u>( __m128i px )
+        {
+            return _mm_add_epi16( _mm_and_si128( px, _mm_set1_epi16( 0x00FF ) ),
+                                  _mm_srli_epi16( px, 8 ) );
+        }
+        template <>
+        inline __m128i pairSumU8_SSE2<2u>( __m128i px )
+        {
+            const __m128 lo = _mm_castsi128_ps( _mm_unpacklo_epi8( px, _mm_setzero_si128() ) );
+            const __m128 hi = _mm_castsi128_ps( _mm_unpackhi_epi8( px, _mm_setzero_si128() ) );
+            const __m128 even = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+            const __m128 odd = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+            return _mm_add_epi16( _mm_castps_si128( even ), _mm_castps_si128( odd ) );
+        }
+        template <>
+        inline __m128i pairSumU8_SSE2<4u>( __m128i px )
+        {
+            const __m128i lo = _mm_unpacklo_epi8( px, _mm_setzero_si128() );
+            const __m128i hi = _mm_unpackhi_epi8( px, _mm_setzero_si128() );
+            return _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+        }
+        //-------------------------------------------------------------------------------
+        /// Returns -1 in the 32-bit lanes that hold alphaIdx, assuming C components per pixel
+        inline __m128i alphaMask32_SSE2( size_t C, int alphaIdx )
+        {
+            int32 values[4];
+            for( size_t i = 0; i < 4u; ++i )
+                values[i] = int( i % C ) == alphaIdx ? -1 : 0;
+            return _mm_loadu_si128( reinterpret_cast<const __m128i *>( values ) );
+        }
+        //-------------------------------------------------------------------------------
+        template <size_t C>
+        size_t downscaleRow2x2_U8( uint8 *dst, const uint8 *src0, const uint8 *src1,
+                                   size_t numDstPixels, int alphaIdx )
+        {
+            // Colour is rounded to nearest: ( sum + 2 ) / 4. Alpha is rounded up: ( sum + 3 ) / 4
+            uint16 biasValues[8];
+            for( size_t i = 0; i < 8u; ++i )
+                biasValues[i] = int( i % C ) == alphaIdx ? 3u : 2u;
+            const __m128i bias = _mm_loadu_si128( reinterpret_cast<const __m128i *>( biasValues ) );
+            const size_t pixelsPerIteration = 16u / C;
+
+            size_t i = 0;
+            for( ; i + pixelsPerIteration <= numDstPixels; i += pixelsPerIteration )
+            {
+                const __m128i *srcA = reinterpret_cast<const __m128i *>( src0 + i * C * 2u );
+                const __m128i *srcB = reinterpret_cast<const __m128i *>( src1 + i * C * 2u );
+
+                __m128i sum0 = _mm_add_epi16( pairSumU8_SSE2<C>( _mm_loadu_si128( srcA + 0 ) ),
+                                              pairSumU8_SSE2<C>( _mm_loadu_si128( srcB + 0 ) ) );
+                __m128i sum1 = _mm_add_epi16( pairSumU8_SSE2<C>( _mm_loadu_si128( srcA + 1 ) ),
+                                              pairSumU8_SSE2<C>( _mm_loadu_si128( srcB + 1 ) ) );
+                sum0 = _mm_srli_epi16( _mm_add_epi16( sum0, bias ), 2 );
+                sum1 = _mm_srli_epi16( _mm_add_epi16( sum1, bias ), 2 );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i * C ),
+                                  _mm_packus_epi16( sum0, sum1 ) );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        /// Returns the sum of the squares of the 2 pixels in px01 (8 uint16) as 4 int32
+        inline __m128i pairSumSquaresU8_SSE2( __m128i px01 )
+        {
+            const __m128i sq = _mm_mullo_epi16( px01, px01 );
+            return _mm_add_epi32( _mm_unpacklo_epi16( sq, _mm_setzero_si128() ),
+                                  _mm_unpackhi_epi16( sq, _mm_setzero_si128() ) );
+        }
+        //-------------------------------------------------------------------------------
+        /// Returns the sum of the 2 pixels in px01 (8 uint16) as 4 int32
+        inline __m128i pairSumU8toU32_SSE2( __m128i px01 )
+        {
+            return _mm_add_epi32( _mm_unpacklo_epi16( px01, _mm_setzero_si128() ),
+                                  _mm_unpackhi_epi16( px01, _mm_setzero_si128() ) );
+        }
+        //-------------------------------------------------------------------------------
+        /// Averages one 2x2 block of RGBA8 pixels in gamma space; alpha stays linear
+        inline __m128i averageSrgb_SSE2( __m128i row0, __m128i row1, __m128i alphaMask )
+        {
+            const __m128i sumSq =
+                _mm_add_epi32( pairSumSquaresU8_SSE2( row0 ), pairSumSquaresU8_SSE2( row1 ) );
+            const __m128i sum =
+                _mm_add_epi32( pairSumU8toU32_SSE2( row0 ), pairSumU8toU32_SSE2( row1 ) );
+
+            __m128 colour = _mm_mul_ps( _mm_cvtepi32_ps( sumSq ), _mm_set1_ps( 0.25f ) );
+            colour = _mm_add_ps( _mm_sqrt_ps( colour ), _mm_set1_ps( 0.5f ) );
+            const __m128i alpha = _mm_srli_epi32( _mm_add_epi32( sum, _mm_set1_epi32( 3 ) ), 2 );
+
+            return _mm_or_si128( _mm_and_si128( alphaMask, alpha ),
+                                 _mm_andnot_si128( alphaMask, _mm_cvttps_epi32( colour ) ) );
+        }
+        //-------------------------------------------------------------------------------
+        size_t downscaleRow2x2_sRGB_XXXA( uint8 *dst, const uint8 *src0, const uint8 *src1,
+                                          size_t numDstPixels )
+        {
+            const __m128i alphaMask = alphaMask32_SSE2( 4u, 3 );
+            const __m128i zero = _mm_setzero_si128();
+
+            size_t i = 0;
+            for( ; i + 4u <= numDstPixels; i += 4u )
+            {
+                const __m128i *srcA = reinterpret_cast<const __m128i *>( src0 + i * 8u );
+                const __m128i *srcB = reinterpret_cast<const __m128i *>( src1 + i * 8u );
+
+                const __m128i a0 = _mm_loadu_si128( srcA + 0 );
+                const __m128i a1 = _mm_loadu_si128( srcA + 1 );
+                const __m128i b0 = _mm_loadu_si128( srcB + 0 );
+                const __m128i b1 = _mm_loadu_si128( srcB + 1 );
+
+                const __m128i px0 = averageSrgb_SSE2( _mm_unpacklo_epi8( a0, zero ),
+                                                      _mm_unpacklo_epi8( b0, zero ), alphaMask );
+                const __m128i px1 = averageSrgb_SSE2( _mm_unpackhi_epi8( a0, zero ),
+                                                      _mm_unpackhi_epi8( b0, zero ), alphaMask );
+                const __m128i px2 = averageSrgb_SSE2( _mm_unpacklo_epi8( a1, zero ),
+                                                      _mm_unpacklo_epi8( b1, zero ), alphaMask );
+                const __m128i px3 = averageSrgb_SSE2( _mm_unpackhi_epi8( a1, zero ),
+                                                      _mm_unpackhi_epi8( b1, zero ), alphaMask );
+
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i *>( dst + i * 4u ),
+                    _mm_packus_epi16( _mm_packs_epi32( px0, px1 ), _mm_packs_epi32( px2, px3 ) ) );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        /// Splits 8 consecutive floats into the components of even & odd pixels
+        template <size_t C>
+        inline void deinterleaveF32_SSE2( __m128 lo, __m128 hi, __m128 &even, __m128 &odd );
+        template <>
+        inline void deinterleaveF32_SSE2<1u>( __m128 lo, __m128 hi, __m128 &even, __m128 &odd )
+        {
+            even = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+            odd = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+        }
+        template <>
+        inline void deinterleaveF32_SSE2<2u>( __m128 lo, __m128 hi, __m128 &even, __m128 &odd )
+        {
+            even = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+            odd = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        }
+        template <>
+        inline void deinterleaveF32_SSE2<4u>( __m128 lo, __m128 hi, __m128 &even, __m128 &odd )
+        {
+            even = lo;
+            odd = hi;
+        }
+        //-------------------------------------------------------------------------------
+        template <size_t C>
+        size_t downscaleRow2x2_Float32( float *dst, const float *src0, const float *src1,
+                                        size_t numDstPixels, int alphaIdx )
+        {
+            const __m128 alphaMask = _mm_castsi128_ps( alphaMask32_SSE2( C, alphaIdx ) );
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 quarter = _mm_set1_ps( 0.25f );
+            const __m128 four = _mm_set1_ps( 4.0f );
+            const __m128 one = _mm_set1_ps( 1.0f );
+            const size_t pixelsPerIteration = 4u / C;
+
+            size_t i = 0;
+            for( ; i + pixelsPerIteration <= numDstPixels; i += pixelsPerIteration )
+            {
+                __m128 a, b, c, d;
+                deinterleaveF32_SSE2<C>( _mm_loadu_ps( src0 + i * C * 2u ),
+                                         _mm_loadu_ps( src0 + i * C * 2u + 4u ), a, b );
+                deinterleaveF32_SSE2<C>( _mm_loadu_ps( src1 + i * C * 2u ),
+                                         _mm_loadu_ps( src1 + i * C * 2u + 4u ), c, d );
+
+                // Same order of operations as the scalar code, to get the same rounding
+                __m128 accum = _mm_add_ps( _mm_add_ps( zero, a ), b );
+                accum = _mm_add_ps( _mm_add_ps( accum, c ), d );
+                const __m128 colour = _mm_add_ps( _mm_mul_ps( accum, quarter ), zero );
+                const __m128 alpha = _mm_mul_ps( _mm_sub_ps( _mm_add_ps( accum, four ), one ), quarter );
+
+                _mm_storeu_ps( dst + i * C, _mm_or_ps( _mm_and_ps( alphaMask, alpha ),
+                                                       _mm_andnot_ps( alphaMask, colour ) ) );
+            }
+            return i;
+        }
+#elif __OGRE_HAVE_NEON
+        /// Returns the even & odd pixels of 32 bytes, for C bytes per pixel
+        template <size_t C>
+        inline uint8x16x2_t deinterleaveU8_NEON( const uint8 *src );
+        template <>
+        inline uint8x16x2_t deinterleaveU8_NEON<1u>( const uint8 *src )
+        {
+            return vld2q_u8( src );
+        }
+        template <>
+        inline uint8x16x2_t deinterleaveU8_NEON<2u>( const uint8 *src )
+        {
+            const uint16x8x2_t px = vld2q_u16( reinterpret_cast<const uint16_t *>( src ) );
+            uint8x16x2_t retVal;
+            retVal.val[0] = vreinterpretq_u8_u16( px.val[0] );
+            retVal.val[1] = vreinterpretq_u8_u16( px.val[1] );
+            return retVal;
+        }
+        template <>
+        inline uint8x16x2_t deinterleaveU8_NEON<4u>( const uint8 *src )
+        {
+            const uint32x4x2_t px = vld2q_u32( reinterpret_cast<const uint32_t *>( src ) );
+            uint8x16x2_t retVal;
+            retVal.val[0] = vreinterpretq_u8_u32( px.val[0] );
+            retVal.val[1] = vreinterpretq_u8_u32( px.val[1] );
+            return retVal;
+        }
+        //-------------------------------------------------------------------------------
+        template <size_t C>
+        size_t downscaleRow2x2_U8( uint8 *dst, const uint8 *src0, const uint8 *src1,
+                                   size_t numDstPixels, int alphaIdx )
+        {
+            // Colour is rounded to nearest: ( sum + 2 ) / 4. Alpha is rounded up: ( sum + 3 ) / 4
+            uint16_t biasValues[8];
+            for( size_t i = 0; i < 8u; ++i )
+                biasValues[i] = int( i % C ) == alphaIdx ? 3u : 2u;
+            const uint16x8_t bias = vld1q_u16( biasValues );
+            const size_t pixelsPerIteration = 16u / C;
+
+            size_t i = 0;
+            for( ; i + pixelsPerIteration <= numDstPixels; i += pixelsPerIteration )
+            {
+                const uint8x16x2_t a = deinterleaveU8_NEON<C>( src0 + i * C * 2u );
+                const uint8x16x2_t b = deinterleaveU8_NEON<C>( src1 + i * C * 2u );
+
+                uint16x8_t sum0 = vaddl_u8( vget_low_u8( a.val[0] ), vget_low_u8( a.val[1] ) );
+                uint16x8_t sum1 = vaddl_u8( vget_high_u8( a.val[0] ), vget_high_u8( a.val[1] ) );
+                sum0 = vaddq_u16( sum0, vaddl_u8( vget_low_u8( b.val[0] ), vget_low_u8( b.val[1] ) ) );
+                sum1 =
+                    vaddq_u16( sum1, vaddl_u8( vget_high_u8( b.val[0] ), vget_high_u8( b.val[1] ) ) );
+                vst1q_u8( dst + i * C, vcombine_u8( vshrn_n_u16( vaddq_u16( sum0, bias ), 2 ),
+                                                    vshrn_n_u16( vaddq_u16( sum1, bias ), 2 ) ) );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t downscaleRow2x2_sRGB_XXXA( uint8 *, const uint8 *, const uint8 *, size_t )
+        {
+            return 0u;
+        }
+        //-------------------------------------------------------------------------------
+        /// Splits 8 consecutive floats into the components of even & odd pixels
+        template <size_t C>
+        inline float32x4x2_t deinterleaveF32_NEON( const float *src );
+        template <>
+        inline float32x4x2_t deinterleaveF32_NEON<1u>( const float *src )
+        {
+            return vld2q_f32( src );
+        }
+        template <>
+        inline float32x4x2_t deinterleaveF32_NEON<2u>( const float *src )
+        {
+            const float32x4_t lo = vld1q_f32( src );
+            const float32x4_t hi = vld1q_f32( src + 4u );
+            float32x4x2_t retVal;
+            retVal.val[0] = vcombine_f32( vget_low_f32( lo ), vget_low_f32( hi ) );
+            retVal.val[1] = vcombine_f32( vget_high_f32( lo ), vget_high_f32( hi ) );
+            return retVal;
+        }
+        template <>
+        inline float32x4x2_t deinterleaveF32_NEON<4u>( const float *src )
+        {
+            float32x4x2_t retVal;
+            retVal.val[0] = vld1q_f32( src );
+            retVal.val[1] = vld1q_f32( src + 4u );
+            return retVal;
+        }
+        //-------------------------------------------------------------------------------
+        template <size_t C>
+        size_t downscaleRow2x2_Float32( float *dst, const float *src0, const float *src1,
+                                        size_t numDstPixels, int alphaIdx )
+        {
+            uint32_t alphaMaskValues[4];
+            for( size_t i = 0; i < 4u; ++i )
+                alphaMaskValues[i] = int( i % C ) == alphaIdx ? 0xFFFFFFFFu : 0u;
+            const uint32x4_t alphaMask = vld1q_u32( alphaMaskValues );
+            const float32x4_t zero = vdupq_n_f32( 0.0f );
+            const float32x4_t quarter = vdupq_n_f32( 0.25f );
+            const float32x4_t four = vdupq_n_f32( 4.0f );
+            const float32x4_t one = vdupq_n_f32( 1.0f );
+            const size_t pixelsPerIteration = 4u / C;
+
+            size_t i = 0;
+            for( ; i + pixelsPerIteration <= numDstPixels; i += pixelsPerIteration )
+            {
+                const float32x4x2_t ab = deinterleaveF32_NEON<C>( src0 + i * C * 2u );
+                const float32x4x2_t cd = deinterleaveF32_NEON<C>( src1 + i * C * 2u );
+
+                // Same order of operations as the scalar code, to get the same rounding
+                float32x4_t accum = vaddq_f32( zero, ab.val[0] );
+                accum = vaddq_f32( vaddq_f32( vaddq_f32( accum, ab.val[1] ), cd.val[0] ), cd.val[1] );
+                const float32x4_t colour = vaddq_f32( vmulq_f32( accum, quarter ), zero );
+                const float32x4_t alpha =
+                    vmulq_f32( vsubq_f32( vaddq_f32( accum, four ), one ), quarter );
+
+                vst1q_f32( dst + i * C, vbslq_f32( alphaMask, alpha, colour ) );
+            }
+            return i;
+        }
+#else
+        template <size_t C>
+        size_t downscaleRow2x2_U8( uint8 *, const uint8 *, const uint8 *, size_t, int )
+        {
+            return 0u;
+        }
+        size_t downscaleRow2x2_sRGB_XXXA( uint8 *, const uint8 *, const uint8 *, size_t )
+        {
+            return 0u;
+        }
+        template <size_t C>
+        size_t downscaleRow2x2_Float32( float *, const float *, const float *, size_t, int )
+        {
+            return 0u;
+        }
+#endif
+    }  // namespace
 }
 
 #define OGRE_GAM_TO_LIN( x ) x
@@ -189,6 +517,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_XXXA8888
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_U8<4u>( dst, src0, src1, n, 3 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XXXA8888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XXXA8888_cube
 #define BLUR_NAME separableBlur_XXXA8888
@@ -208,6 +537,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_G 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_XX88
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_U8<2u>( dst, src0, src1, n, -1 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XX88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XX88_cube
 #define BLUR_NAME separableBlur_XX88
@@ -216,6 +546,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_X8
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_U8<1u>( dst, src0, src1, n, -1 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_X8
 #define DOWNSAMPLE_CUBE_NAME downscale2x_X8_cube
 #define BLUR_NAME separableBlur_X8
@@ -224,6 +555,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_A8
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_U8<1u>( dst, src0, src1, n, 0 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_A8
 #define DOWNSAMPLE_CUBE_NAME downscale2x_A8_cube
 #define BLUR_NAME separableBlur_A8
@@ -233,6 +565,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_XA88
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_U8<2u>( dst, src0, src1, n, 1 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XA88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XA88_cube
 #define BLUR_NAME separableBlur_XA88
@@ -319,6 +652,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_Float32_XXXA
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_Float32<4u>( dst, src0, src1, n, 3 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XXXA
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XXXA_cube
 #define BLUR_NAME separableBlur_Float32_XXXA
@@ -338,6 +672,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_G 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_Float32_XX
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_Float32<2u>( dst, src0, src1, n, -1 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XX
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XX_cube
 #define BLUR_NAME separableBlur_Float32_XX
@@ -346,6 +681,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_Float32_X
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_Float32<1u>( dst, src0, src1, n, -1 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_X
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_X_cube
 #define BLUR_NAME separableBlur_Float32_X
@@ -354,6 +690,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_Float32_A
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_Float32<1u>( dst, src0, src1, n, 0 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_A
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_A_cube
 #define BLUR_NAME separableBlur_Float32_A
@@ -363,6 +700,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_Float32_XA
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_Float32<2u>( dst, src0, src1, n, 1 )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XA
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XA_cube
 #define BLUR_NAME separableBlur_Float32_XA
@@ -390,6 +728,7 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_sRGB_XXXA8888
+#define DOWNSAMPLE_ROW_2X2( dst, src0, src1, n ) downscaleRow2x2_sRGB_XXXA( dst, src0, src1, n )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_XXXA8888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_XXXA8888_cube
 #define BLUR_NAME separableBlur_sRGB_XXXA8888
@@ -34,7 +34,8 @@ namespace Ogre
     void DOWNSAMPLE_NAME( uint8 *_dstPtr, uint8 const *_srcPtr, int32 dstWidth, int32 dstHeight,
                           int32 dstBytesPerRow, int32 srcWidth, int32 srcBytesPerRow,
                           const uint8 kernel[5][5], const int8 kernelStartX, const int8 kernelEndX,
-                          const int8 kernelStartY, const int8 kernelEndY )
+                          const int8 kernelStartY, const int8 kernelEndY, int32 dstRowStart,
+                          int32 dstRowEnd )
     {
         OGRE_UINT8 *dstPtr = reinterpret_cast<OGRE_UINT8 *>( _dstPtr );
         OGRE_UINT8 const *srcPtr = reinterpret_cast<OGRE_UINT8 const *>( _srcPtr );
@@ -45,9 +46,29 @@ namespace Ogre
         int32 srcBytesPerRowSkip = srcBytesPerRow - srcWidth * OGRE_TOTAL_SIZE;
         int32 dstBytesPerRowSkip = dstBytesPerRow - dstWidth * OGRE_TOTAL_SIZE;
 
-        for( int32 y = 0; y < dstHeight; ++y )
+        dstPtr += dstRowStart * dstBytesPerRow;
+        srcPtr += dstRowStart * srcBytesPerRow * 2;
+
+#ifdef DOWNSAMPLE_ROW_2X2
+        // The bilinear filter with both rows & columns in range can be vectorized
+        const bool bIsBilinear = kernelStartX == 0 && kernelEndX == 1 && kernelStartY == 0 &&
+                                 kernelEndY == 1 && kernel[2][2] == 1u && kernel[2][3] == 1u &&
+                                 kernel[3][2] == 1u && kernel[3][3] == 1u;
+#endif
+
+        for( int32 y = dstRowStart; y < dstRowEnd; ++y )
         {
-            for( int32 x = 0; x < dstWidth; ++x )
+            int32 x = 0;
+#ifdef DOWNSAMPLE_ROW_2X2
+            if( bIsBilinear && y + 1 < dstHeight )
+            {
+                x = static_cast<int32>( DOWNSAMPLE_ROW_2X2( dstPtr, srcPtr, srcPtr + srcBytesPerRow,
+                                                            static_cast<size_t>( dstWidth - 1 ) ) );
+                dstPtr += x * OGRE_TOTAL_SIZE;
+                srcPtr += x * OGRE_TOTAL_SIZE * 2;
+            }
+#endif
+            for( ; x < dstWidth; ++x )
             {
                 int kStartY = std::max<int>( -y, kernelStartY );
                 int kEndY = std::min<int>( dstHeight - y - 1, kernelEndY );
@@ -135,7 +156,7 @@ namespace Ogre
     void DOWNSAMPLE_3D_NAME( uint8 *_dstPtr, uint8 const *_srcPtr, int32 dstWidth, int32 dstHeight,
                              int32 dstDepth, int32 dstBytesPerRow, int32 dstBytesPerImage,
                              int32 srcWidth, int32 srcHeight, int32 srcBytesPerRow,
-                             int32 srcBytesPerImage )
+                             int32 srcBytesPerImage, int32 dstSliceStart, int32 dstSliceEnd )
     {
         OGRE_UINT8 *dstPtr = reinterpret_cast<OGRE_UINT8 *>( _dstPtr );
         OGRE_UINT8 const *srcPtr = reinterpret_cast<OGRE_UINT8 const *>( _srcPtr );
@@ -149,7 +170,20 @@ namespace Ogre
         int32 srcBytesPerImageSkip = srcBytesPerImage - srcWidth * srcHeight * OGRE_TOTAL_SIZE;
         int32 dstBytesPerImageSkip = dstBytesPerImage - dstWidth * dstHeight * OGRE_TOTAL_SIZE;
 
-        for( int32 z = 0; z < dstDepth; ++z )
+        {
+            // How much the loops below advance dstPtr & srcPtr for each destination slice
+            const int32 dstAdvancePerSlice = dstHeight * dstBytesPerRow + dstBytesPerImageSkip;
+            const int32 srcAdvancePerRow = std::max( srcWidth, 2 ) * OGRE_TOTAL_SIZE +
+                                           srcBytesPerRowSkip + srcBytesPerRow;
+            const int32 srcAdvancePerSlice =
+                dstHeight * srcAdvancePerRow +
+                ( std::max( srcHeight, 2 ) - dstHeight * 2 ) * OGRE_TOTAL_SIZE +
+                srcBytesPerImageSkip + srcBytesPerImage;
+            dstPtr += dstSliceStart * dstAdvancePerSlice;
+            srcPtr += dstSliceStart * srcAdvancePerSlice;
+        }
+
+        for( int32 z = dstSliceStart; z < dstSliceEnd; ++z )
         {
             const int kEndZ = std::min<int>( dstDepth - 1 - z, 1 );
 
@@ -703,3 +737,4 @@ namespace Ogre
 #undef DOWNSAMPLE_CUBE_NAME
 #undef BLUR_NAME
 #undef OGRE_TOTAL_SIZE
+#undef DOWNSAMPLE_ROW_2X2
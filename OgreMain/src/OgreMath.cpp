@@ -65,6 +65,7 @@ namespace Ogre
     Real *Math::mTanTable = NULL;
 
     Math::RandomValueProvider *Math::mRandProvider = NULL;
+    static thread_local Math::RandomValueProvider *tlsRandProvider = NULL;
 
     //-----------------------------------------------------------------------
     Math::Math( unsigned int trigTableSize )
@@ -175,7 +176,9 @@ namespace Ogre
     //-----------------------------------------------------------------------
     Real Math::UnitRandom()
     {
-        if( mRandProvider )
+        if( tlsRandProvider )
+            return tlsRandProvider->getRandomUnit();
+        else if( mRandProvider )
             return mRandProvider->getRandomUnit();
         else
             return Real( rand() ) / Real( RAND_MAX );
@@ -189,6 +192,13 @@ namespace Ogre
 
     //-----------------------------------------------------------------------
     void Math::SetRandomValueProvider( RandomValueProvider *provider ) { mRandProvider = provider; }
+    //-----------------------------------------------------------------------
+    Math::RandomValueProvider *Math::_setThreadRandomValueProvider( RandomValueProvider *provider )
+    {
+        RandomValueProvider *oldProvider = tlsRandProvider;
+        tlsRandProvider = provider;
+        return oldProvider;
+    }
 
     //-----------------------------------------------------------------------
     void Math::setAngleUnit( Math::AngleUnit unit ) { msAngleUnit = unit; }
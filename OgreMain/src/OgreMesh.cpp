@@ -276,8 +276,12 @@ namespace Ogre
             mFreshFromDisk =
                 ResourceGroupManager::getSingleton().openResource( mName, mGroup, true, this );
 
-            // fully prebuffer into host RAM
-            mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+            // fully prebuffer into host RAM, unless it's already there (e.g. memory-mapped files)
+            if( !mFreshFromDisk->getContiguousPtr() )
+            {
+                mFreshFromDisk =
+                    DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+            }
         }
         //-----------------------------------------------------------------------
         void Mesh::unprepareImpl() { mFreshFromDisk.reset(); }
@@ -0,0 +1,222 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreParticleSoA.h"
+
+#include "OgreParticle.h"
+
+namespace Ogre
+{
+    ParticleSoA::ParticleSoA() :
+        mParticles( 0 ),
+        mOwnDimensions( 0 ),
+        mNumParticles( 0 ),
+        mCapacity( 0 )
+    {
+        for( size_t i = 0u; i < NumAttributes; ++i )
+            mAttributes[i] = 0;
+    }
+    //-----------------------------------------------------------------------
+    ParticleSoA::~ParticleSoA()
+    {
+        // All arrays live in the same allocation
+        if( mAttributes[0] )
+        {
+            OGRE_FREE_SIMD( mAttributes[0], MEMCATEGORY_GENERAL );
+            mAttributes[0] = 0;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::resize( size_t numParticles )
+    {
+        if( numParticles > mCapacity )
+        {
+            size_t newCapacity = std::max( numParticles, mCapacity * 2u );
+            newCapacity = ( ( newCapacity + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS ) *
+                          ARRAY_PACKED_REALS;
+
+            // The Real arrays go first. Their sizes are multiples of sizeof( ArrayReal ),
+            // so they all stay aligned
+            const size_t bytesPerAttribute = newCapacity * sizeof( Real );
+            const size_t totalBytes = bytesPerAttribute * NumAttributes +
+                                      newCapacity * ( sizeof( Particle * ) + sizeof( bool ) );
+            uint8 *data =
+                reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( totalBytes, MEMCATEGORY_GENERAL ) );
+
+            Real *newAttributes[NumAttributes];
+            for( size_t i = 0u; i < NumAttributes; ++i )
+            {
+                newAttributes[i] = reinterpret_cast<Real *>( data + bytesPerAttribute * i );
+                if( mCapacity )
+                    memcpy( newAttributes[i], mAttributes[i], mCapacity * sizeof( Real ) );
+                // Zero the new lanes, so that they hold finite values
+                memset( newAttributes[i] + mCapacity, 0, ( newCapacity - mCapacity ) * sizeof( Real ) );
+            }
+            Particle **newParticles =
+                reinterpret_cast<Particle **>( data + bytesPerAttribute * NumAttributes );
+            bool *newOwnDimensions = reinterpret_cast<bool *>( newParticles + newCapacity );
+            if( mCapacity )
+            {
+                memcpy( newParticles, mParticles, mCapacity * sizeof( Particle * ) );
+                memcpy( newOwnDimensions, mOwnDimensions, mCapacity * sizeof( bool ) );
+                OGRE_FREE_SIMD( mAttributes[0], MEMCATEGORY_GENERAL );
+            }
+
+            for( size_t i = 0u; i < NumAttributes; ++i )
+                mAttributes[i] = newAttributes[i];
+            mParticles = newParticles;
+            mOwnDimensions = newOwnDimensions;
+            mCapacity = newCapacity;
+        }
+
+        mNumParticles = numParticles;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::setAllOwnDimensions()
+    {
+        std::fill( mOwnDimensions, mOwnDimensions + mNumParticles, true );
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::gather( size_t slot, Particle *particle, Real defaultWidth, Real defaultHeight )
+    {
+        assert( slot < mNumParticles );
+
+        mParticles[slot] = particle;
+        mOwnDimensions[slot] = particle->mOwnDimensions;
+
+        mAttributes[PositionX][slot] = particle->mPosition.x;
+        mAttributes[PositionY][slot] = particle->mPosition.y;
+        mAttributes[PositionZ][slot] = particle->mPosition.z;
+        mAttributes[DirectionX][slot] = particle->mDirection.x;
+        mAttributes[DirectionY][slot] = particle->mDirection.y;
+        mAttributes[DirectionZ][slot] = particle->mDirection.z;
+        mAttributes[TimeToLive][slot] = particle->mTimeToLive;
+        mAttributes[TotalTimeToLive][slot] = particle->mTotalTimeToLive;
+        mAttributes[ColourR][slot] = particle->mColour.r;
+        mAttributes[ColourG][slot] = particle->mColour.g;
+        mAttributes[ColourB][slot] = particle->mColour.b;
+        mAttributes[ColourA][slot] = particle->mColour.a;
+        mAttributes[Rotation][slot] = particle->mRotation.valueRadians();
+        mAttributes[RotationSpeed][slot] = particle->mRotationSpeed.valueRadians();
+        mAttributes[Width][slot] = particle->mOwnDimensions ? particle->mWidth : defaultWidth;
+        mAttributes[Height][slot] = particle->mOwnDimensions ? particle->mHeight : defaultHeight;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::scatter( size_t slot ) const
+    {
+        assert( slot < mNumParticles );
+
+        Particle *particle = mParticles[slot];
+
+        particle->mPosition.x = mAttributes[PositionX][slot];
+        particle->mPosition.y = mAttributes[PositionY][slot];
+        particle->mPosition.z = mAttributes[PositionZ][slot];
+        particle->mDirection.x = mAttributes[DirectionX][slot];
+        particle->mDirection.y = mAttributes[DirectionY][slot];
+        particle->mDirection.z = mAttributes[DirectionZ][slot];
+        particle->mTimeToLive = mAttributes[TimeToLive][slot];
+        particle->mTotalTimeToLive = mAttributes[TotalTimeToLive][slot];
+        particle->mColour.r = static_cast<float>( mAttributes[ColourR][slot] );
+        particle->mColour.g = static_cast<float>( mAttributes[ColourG][slot] );
+        particle->mColour.b = static_cast<float>( mAttributes[ColourB][slot] );
+        particle->mColour.a = static_cast<float>( mAttributes[ColourA][slot] );
+        particle->mRotation = Radian( mAttributes[Rotation][slot] );
+        particle->mRotationSpeed = Radian( mAttributes[RotationSpeed][slot] );
+        if( mOwnDimensions[slot] )
+        {
+            particle->mOwnDimensions = true;
+            particle->mWidth = mAttributes[Width][slot];
+            particle->mHeight = mAttributes[Height][slot];
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::copySlot( size_t dstSlot, size_t srcSlot )
+    {
+        for( size_t i = 0u; i < NumAttributes; ++i )
+            mAttributes[i][dstSlot] = mAttributes[i][srcSlot];
+        mParticles[dstSlot] = mParticles[srcSlot];
+        mOwnDimensions[dstSlot] = mOwnDimensions[srcSlot];
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::removeStable( const size_t *sortedSlots, size_t numSlots )
+    {
+        if( !numSlots )
+            return;
+
+        // Move each run of surviving slots down over the removed ones
+        size_t dstSlot = sortedSlots[0];
+        for( size_t i = 0u; i < numSlots; ++i )
+        {
+            const size_t srcSlot = sortedSlots[i] + 1u;
+            const size_t srcEnd = ( i + 1u ) < numSlots ? sortedSlots[i + 1u] : mNumParticles;
+            const size_t numToMove = srcEnd - srcSlot;
+            if( numToMove )
+            {
+                for( size_t j = 0u; j < NumAttributes; ++j )
+                {
+                    memmove( mAttributes[j] + dstSlot, mAttributes[j] + srcSlot,
+                             numToMove * sizeof( Real ) );
+                }
+                memmove( mParticles + dstSlot, mParticles + srcSlot, numToMove * sizeof( Particle * ) );
+                memmove( mOwnDimensions + dstSlot, mOwnDimensions + srcSlot,
+                         numToMove * sizeof( bool ) );
+                dstSlot += numToMove;
+            }
+        }
+
+        mNumParticles -= numSlots;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::removeUnordered( const size_t *sortedSlots, size_t numSlots )
+    {
+        // Back to front, so that the last slot is never one still pending removal
+        for( size_t i = numSlots; i--; )
+        {
+            const size_t lastSlot = mNumParticles - 1u;
+            if( sortedSlots[i] != lastSlot )
+                copySlot( sortedSlots[i], lastSlot );
+            --mNumParticles;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSoA::padLastPack()
+    {
+        if( !mNumParticles )
+            return;
+
+        const size_t lastSlot = mNumParticles - 1u;
+        const size_t endSlot = getNumPacks() * ARRAY_PACKED_REALS;
+        for( size_t i = 0u; i < NumAttributes; ++i )
+        {
+            for( size_t j = mNumParticles; j < endSlot; ++j )
+                mAttributes[i][j] = mAttributes[i][lastSlot];
+        }
+    }
+}  // namespace Ogre
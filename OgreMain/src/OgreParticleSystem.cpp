@@ -29,6 +29,8 @@ THE SOFTWARE.
 
 #include "OgreParticleSystem.h"
 
+#include "Math/Array/OgreBooleanMask.h"
+#include "OgreBitwise.h"
 #include "OgreCamera.h"
 #include "OgreControllerManager.h"
 #include "OgreHlmsManager.h"
@@ -76,7 +78,7 @@ namespace Ogre
 
         Real getValue() const override { return 0; }  // N/A
 
-        void setValue( Real value ) override { mTarget->_update( value ); }
+        void setValue( Real value ) override { mTarget->_scheduleUpdate( value, 1u ); }
     };
 
     class ParticleSystemUpdateValueDeterministic : public ControllerValue<Real>
@@ -104,8 +106,7 @@ namespace Ogre
 
             const size_t numIterations = static_cast<size_t>( value / timeStep );
 
-            for( size_t i = 0u; i < numIterations; ++i )
-                mTarget->_update( timeStep );
+            mTarget->_scheduleUpdate( timeStep, numIterations );
 
             mLeftOver = value - static_cast<Real>( numIterations ) * timeStep;
         }
@@ -133,6 +134,12 @@ namespace Ogre
         mIsEmitting( true ),
         mParticleEmitterRootNode( 0 ),
         mTranslateParticleDirectionIntoWorldSpace( true ),
+        mUseOwnRandom( false ),
+        mRandomSeed( id ),
+        mPendingUpdateTimeStep( 0 ),
+        mPendingUpdateIterations( 0u ),
+        mUseCachedTransforms( false ),
+        mUpdatingSoA( false ),
         mRenderer( 0 ),
         mCullIndividual( false ),
         mPoolSize( 0 ),
@@ -152,10 +159,15 @@ namespace Ogre
         setCastShadows( false );
 
         mObjectData.mQueryFlags[mObjectData.mIndex] = SceneManager::QUERY_FX_DEFAULT_MASK;
+
+        mRandom.seed( mRandomSeed );
     }
     //-----------------------------------------------------------------------
     ParticleSystem::~ParticleSystem()
     {
+        if( mPendingUpdateIterations && mManager )
+            mManager->_removePendingParticleSystemUpdate( this );
+
         if( mTimeController )
         {
             // Destroy controller
@@ -308,6 +320,8 @@ namespace Ogre
         mIterationIntervalSet = rhs.mIterationIntervalSet;
         mNonvisibleTimeout = rhs.mNonvisibleTimeout;
         mNonvisibleTimeoutSet = rhs.mNonvisibleTimeoutSet;
+        // The seed is left as is, so that systems created from the same template differ
+        mUseOwnRandom = rhs.mUseOwnRandom;
         // last frame visible and time since last visible should be left default
 
         setRenderer( rhs.getRendererName() );
@@ -395,12 +409,23 @@ namespace Ogre
         // Scale incoming speed for the rest of the calculation
         timeElapsed *= mSpeedFactor;
 
+        // Emitters & affectors draw from our own generator while we're updating, if asked
+        // to or if we may be on a worker thread. See setUseOwnRandomGenerator
+        const bool bOwnRandom =
+            mUseOwnRandom || ( mManager && mManager->getParticleSystemUpdatesThreaded() );
+        Math::RandomValueProvider *oldRandProvider = 0;
+        if( bOwnRandom )
+            oldRandProvider = Math::_setThreadRandomValueProvider( &mRandom );
+
         // Init renderer if not done already
         configureRenderer();
 
         // Initialise emitted emitters list if not done already
         initialiseEmittedEmitters();
 
+        gatherParticleSoA();
+
+        bool bMoved = false;
         Real iterationInterval = mIterationIntervalSet ? mIterationInterval : msDefaultIterationInterval;
         if( iterationInterval > 0 )
         {
@@ -412,6 +437,7 @@ namespace Ogre
                 _expire( iterationInterval );
                 _triggerAffectors( iterationInterval );
                 _applyMotion( iterationInterval );
+                bMoved = true;
 
                 if( mIsEmitting )
                 {
@@ -428,6 +454,7 @@ namespace Ogre
             _expire( timeElapsed );
             _triggerAffectors( timeElapsed );
             _applyMotion( timeElapsed );
+            bMoved = true;
 
             if( mIsEmitting )
             {
@@ -439,59 +466,211 @@ namespace Ogre
         if( !mBoundsAutoUpdate && mBoundsUpdateTime > 0.0f )
             mBoundsUpdateTime -= timeElapsed;  // count down
         _updateBounds();
+
+        scatterParticleSoA();
+        mUpdatingSoA = false;
+
+        // Notify renderer
+        if( bMoved )
+            mRenderer->_notifyParticleMoved( mActiveParticles );
+
+        if( bOwnRandom )
+            Math::_setThreadRandomValueProvider( oldRandProvider );
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_scheduleUpdate( Real timeStep, size_t numIterations )
+    {
+        // _update would do nothing, don't bother the SceneManager
+        if( !numIterations || !mParentNode )
+            return;
+
+        if( !mManager || !mManager->getParticleSystemUpdatesThreaded() )
+        {
+            for( size_t i = 0u; i < numIterations; ++i )
+                _update( timeStep );
+            return;
+        }
+
+        if( mPendingUpdateIterations )
+        {
+            if( mPendingUpdateTimeStep == timeStep )
+            {
+                mPendingUpdateIterations += numIterations;
+                return;
+            }
+
+            // Can't merge different time steps without altering the simulation.
+            // Rare (the SceneManager didn't update since the last time), so just
+            // flush the old one here.
+            _executePendingUpdate();
+        }
+        else
+        {
+            mManager->_addPendingParticleSystemUpdate( this );
+        }
+
+        mPendingUpdateTimeStep = timeStep;
+        mPendingUpdateIterations = numIterations;
+    }
+    //-----------------------------------------------------------------------
+    bool ParticleSystem::_prepareThreadedUpdate()
+    {
+        if( !mParentNode )
+        {
+            // Detached after the update got scheduled. _update would do nothing
+            mPendingUpdateIterations = 0u;
+            return false;
+        }
+
+        configureRenderer();
+        initialiseEmittedEmitters();
+
+        ParticleAffectorList::const_iterator itor = mAffectors.begin();
+        ParticleAffectorList::const_iterator endt = mAffectors.end();
+        while( itor != endt )
+        {
+            ( *itor )->_prepareThreadedUpdate();
+            ++itor;
+        }
+
+        mCachedParentTransform = mParentNode->_getFullTransformUpdated();
+        if( mParticleEmitterRootNode )
+            mCachedEmitterRootTransform = mParticleEmitterRootNode->_getFullTransformUpdated();
+        mUseCachedTransforms = true;
+
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::_executePendingUpdate()
+    {
+        const size_t numIterations = mPendingUpdateIterations;
+        for( size_t i = 0u; i < numIterations; ++i )
+            _update( mPendingUpdateTimeStep );
+
+        mPendingUpdateIterations = 0u;
+        mUseCachedTransforms = false;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::setUseOwnRandomGenerator( bool bUseOwnRandom )
+    {
+        mUseOwnRandom = bUseOwnRandom;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::setRandomSeed( uint64 seed )
+    {
+        mRandomSeed = seed;
+        mRandom.seed( seed );
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::RandomGenerator::seed( uint64 seed )
+    {
+        // splitmix64 finaliser, so that consecutive seeds (i.e. Ids) start far apart
+        seed += 0x9E3779B97F4A7C15ull;
+        seed = ( seed ^ ( seed >> 30u ) ) * 0xBF58476D1CE4E5B9ull;
+        seed = ( seed ^ ( seed >> 27u ) ) * 0x94D049BB133111EBull;
+        seed = seed ^ ( seed >> 31u );
+        mState = seed ? seed : 1u;  // xorshift must never be 0
+    }
+    //-----------------------------------------------------------------------
+    Real ParticleSystem::RandomGenerator::getRandomUnit()
+    {
+        mState ^= mState >> 12u;
+        mState ^= mState << 25u;
+        mState ^= mState >> 27u;
+        const uint64 value = mState * 0x2545F4914F6CDD1Dull;
+        // Top 24 bits, which is all the precision a float has. Range is [0; 1]
+        return Real( value >> 40u ) * Real( 1.0 / 16777215.0 );
+    }
+    //-----------------------------------------------------------------------
+    const Matrix4 &ParticleSystem::getParentNodeTransform()
+    {
+        // TODO: (dark_sylinc) Refactor this. ControllerManager gets executed before us
+        //(because it doesn't know if we'll update a SceneNode)
+        if( mUseCachedTransforms )
+            return mCachedParentTransform;
+        return mParentNode->_getFullTransformUpdated();
+    }
+    //-----------------------------------------------------------------------
+    const Matrix4 &ParticleSystem::getEmitterRootNodeTransform()
+    {
+        if( mUseCachedTransforms )
+            return mCachedEmitterRootTransform;
+        return mParticleEmitterRootNode->_getFullTransformUpdated();
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::_expire( Real timeElapsed )
     {
-        ActiveParticleList::iterator i, itEnd;
-        Particle *pParticle;
-        ParticleEmitter *pParticleEmitter;
+        const size_t numParticles = mParticleSoA.getNumParticles();
+        const size_t numPacks = mParticleSoA.getNumPacks();
+        ArrayReal *RESTRICT_ALIAS timeToLive = mParticleSoA.getArray( ParticleSoA::TimeToLive );
+        const ArrayReal elapsed = Mathlib::SetAll( timeElapsed );
 
-        itEnd = mActiveParticles.end();
+        mExpiredSlots.clear();
 
-        for( i = mActiveParticles.begin(); i != itEnd; )
+        for( size_t i = 0u; i < numPacks; ++i )
         {
-            pParticle = static_cast<Particle *>( *i );
-            if( pParticle->mTimeToLive < timeElapsed )
+            const ArrayMaskR expired = Mathlib::CompareLess( timeToLive[i], elapsed );
+            // Decrement TTL of the survivors
+            timeToLive[i] = Mathlib::Cmov4( timeToLive[i], timeToLive[i] - elapsed, expired );
+
+            uint32 expiredLanes = BooleanMask4::getScalarMask( expired );
+            while( expiredLanes )
             {
-                // Notify renderer
-                mRenderer->_notifyParticleExpired( pParticle );
+                const uint32 lane = Bitwise::ctz32( expiredLanes );
+                const size_t slot = i * ARRAY_PACKED_REALS + lane;
+                if( slot < numParticles )
+                    mExpiredSlots.push_back( slot );
+                expiredLanes &= expiredLanes - 1u;
+            }
+        }
 
-                // Identify the particle type
-                if( pParticle->mParticleType == Particle::Visual )
-                {
-                    // Destroy this one
-                    mFreeParticles.splice( mFreeParticles.end(), mActiveParticles, i++ );
-                }
-                else
-                {
-                    // For now, it can only be an emitted emitter
-                    pParticleEmitter = static_cast<ParticleEmitter *>( *i );
-                    list<ParticleEmitter *>::type *fee =
-                        findFreeEmittedEmitter( pParticleEmitter->getName() );
-                    fee->push_back( pParticleEmitter );
+        if( mExpiredSlots.empty() )
+            return;
 
-                    // Also erase from mActiveEmittedEmitters
-                    removeFromActiveEmittedEmitters( pParticleEmitter );
+        vector<size_t>::type::const_iterator itor = mExpiredSlots.begin();
+        vector<size_t>::type::const_iterator endt = mExpiredSlots.end();
 
-                    // And erase from mActiveParticles
-                    i = mActiveParticles.erase( i );
-                }
+        while( itor != endt )
+        {
+            // Notify renderer, with the Particle up to date
+            mParticleSoA.scatter( *itor );
+            Particle *pParticle = mParticleSoA.getParticle( *itor );
+            mRenderer->_notifyParticleExpired( pParticle );
+
+            // Identify the particle type
+            if( pParticle->mParticleType == Particle::Visual )
+            {
+                // Destroy this one
+                mFreeParticles.push_back( pParticle );
             }
             else
             {
-                // Decrement TTL
-                pParticle->mTimeToLive -= timeElapsed;
-                ++i;
+                // For now, it can only be an emitted emitter
+                ParticleEmitter *pParticleEmitter = static_cast<ParticleEmitter *>( pParticle );
+                list<ParticleEmitter *>::type *fee =
+                    findFreeEmittedEmitter( pParticleEmitter->getName() );
+                fee->push_back( pParticleEmitter );
+
+                // Also erase from mActiveEmittedEmitters
+                removeFromActiveEmittedEmitters( pParticleEmitter );
             }
+            ++itor;
         }
+
+        // Sorted systems get reordered before rendering anyway, so don't bother keeping
+        // the order. Unsorted ones are rendered in emission order, which must not change
+        // or overlapping transparent particles would flicker.
+        if( mSorted )
+            mParticleSoA.removeUnordered( &mExpiredSlots[0], mExpiredSlots.size() );
+        else
+            mParticleSoA.removeStable( &mExpiredSlots[0], mExpiredSlots.size() );
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::_triggerEmitters( Real timeElapsed )
     {
         // Add up requests for emission
-        static vector<unsigned>::type requested;
-        static vector<unsigned>::type emittedRequested;
+        vector<unsigned>::type &requested = mEmitterRequested;
+        vector<unsigned>::type &emittedRequested = mEmittedEmitterRequested;
 
         if( requested.size() != mEmitters.size() )
             requested.resize( mEmitters.size() );
@@ -560,6 +739,8 @@ namespace Ogre
         for( itActiveEmit = mActiveEmittedEmitters.begin(), i = 0;
              itActiveEmit != mActiveEmittedEmitters.end(); ++itActiveEmit, ++i )
             _executeTriggerEmitters( *itActiveEmit, emittedRequested[i], timeElapsed );
+
+        gatherNewParticles();
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::_executeTriggerEmitters( ParticleEmitter *emitter, unsigned requested,
@@ -574,9 +755,7 @@ namespace Ogre
 
         Real timeInc = timeElapsed / Real( requested );
 
-        // TODO: (dark_sylinc) Refactor this. ControllerManager gets executed before us
-        //(because it doesn't know if we'll update a SceneNode)
-        const Matrix4 fullTransformParentNode = mParentNode->_getFullTransformUpdated();
+        const Matrix4 fullTransformParentNode = getParentNodeTransform();
 
         for( unsigned int j = 0; j < requested; ++j )
         {
@@ -600,8 +779,7 @@ namespace Ogre
             {
                 if( mParticleEmitterRootNode )
                 {
-                    const Matrix4 fullTransformEmitterRootNode =
-                        mParticleEmitterRootNode->_getFullTransformUpdated();
+                    const Matrix4 &fullTransformEmitterRootNode = getEmitterRootNodeTransform();
                     // Translate position & direction into world space
                     p->mPosition = fullTransformEmitterRootNode.transformAffine( p->mPosition );
                     if( mTranslateParticleDirectionIntoWorldSpace )
@@ -622,8 +800,7 @@ namespace Ogre
                 if( mParticleEmitterRootNode )
                 {
                     // Emit from mParticleEmitterRootNode into mParentNode space
-                    const Matrix4 fullTransformEmitterRootNode =
-                        mParticleEmitterRootNode->_getFullTransformUpdated();
+                    const Matrix4 &fullTransformEmitterRootNode = getEmitterRootNodeTransform();
                     // Translate position
                     p->mPosition = mParentNode->getOrientation().Inverse() *
                                    ( fullTransformEmitterRootNode.transformAffine( p->mPosition ) -
@@ -666,39 +843,67 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void ParticleSystem::_applyMotion( Real timeElapsed )
     {
-        ActiveParticleList::iterator i, itEnd;
-        Particle *pParticle;
-        ParticleEmitter *pParticleEmitter;
+        const size_t numPacks = mParticleSoA.getNumPacks();
+        const ArrayReal elapsed = Mathlib::SetAll( timeElapsed );
 
-        itEnd = mActiveParticles.end();
-        for( i = mActiveParticles.begin(); i != itEnd; ++i )
+        for( size_t i = 0u; i < numPacks; ++i )
         {
-            pParticle = static_cast<Particle *>( *i );
-            pParticle->mPosition += ( pParticle->mDirection * timeElapsed );
+            ArrayVector3 position = mParticleSoA.getVector3( ParticleSoA::PositionX, i );
+            position += mParticleSoA.getVector3( ParticleSoA::DirectionX, i ) * elapsed;
+            mParticleSoA.setVector3( ParticleSoA::PositionX, i, position );
+        }
 
-            if( pParticle->mParticleType == Particle::Emitter )
+        if( !mActiveEmittedEmitters.empty() )
+        {
+            const size_t numParticles = mParticleSoA.getNumParticles();
+            for( size_t i = 0u; i < numParticles; ++i )
             {
-                // If it is an emitter, the emitter position must also be updated
-                // Note, that position of the emitter becomes a position in worldspace if mLocalSpace is
-                // set to false (will this become a problem?)
-                pParticleEmitter = static_cast<ParticleEmitter *>( *i );
-                pParticleEmitter->setPosition( pParticle->mPosition );
+                Particle *pParticle = mParticleSoA.getParticle( i );
+                if( pParticle->mParticleType == Particle::Emitter )
+                {
+                    // If it is an emitter, the emitter position must also be updated
+                    // Note, that position of the emitter becomes a position in worldspace if
+                    // mLocalSpace is set to false (will this become a problem?)
+                    ParticleEmitter *pParticleEmitter = static_cast<ParticleEmitter *>( pParticle );
+                    pParticleEmitter->setPosition( mParticleSoA.getPosition( i ) );
+                }
             }
         }
-
-        // Notify renderer
-        mRenderer->_notifyParticleMoved( mActiveParticles );
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::_triggerAffectors( Real timeElapsed )
     {
+        // Affectors without a ParticleSoA version work on the Particle instances, which
+        // need to be written before, and read again after each run of such affectors
+        bool bScattered = false;
+
         ParticleAffectorList::iterator i, itEnd;
 
         itEnd = mAffectors.end();
         for( i = mAffectors.begin(); i != itEnd; ++i )
         {
-            ( *i )->_affectParticles( this, timeElapsed );
+            if( ( *i )->getSupportsSoA() )
+            {
+                if( bScattered )
+                {
+                    gatherParticleSoA();
+                    bScattered = false;
+                }
+                ( *i )->_affectParticlesSoA( this, mParticleSoA, timeElapsed );
+            }
+            else
+            {
+                if( !bScattered )
+                {
+                    scatterParticleSoA();
+                    bScattered = true;
+                }
+                ( *i )->_affectParticles( this, timeElapsed );
+            }
         }
+
+        if( bScattered )
+            gatherParticleSoA();
     }
     //-----------------------------------------------------------------------
     void ParticleSystem::increasePool( size_t size )
@@ -721,6 +926,84 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void ParticleSystem::addActiveParticle( Particle *p )
+    {
+        if( !mSpareParticleNodes.empty() )
+        {
+            mSpareParticleNodes.front() = p;
+            mActiveParticles.splice( mActiveParticles.end(), mSpareParticleNodes,
+                                     mSpareParticleNodes.begin() );
+        }
+        else
+        {
+            mActiveParticles.push_back( p );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::gatherParticleSoA()
+    {
+        mParticleSoA.resize( mActiveParticles.size() );
+
+        size_t slot = 0u;
+        ActiveParticleList::const_iterator itor = mActiveParticles.begin();
+        ActiveParticleList::const_iterator endt = mActiveParticles.end();
+        while( itor != endt )
+        {
+            mParticleSoA.gather( slot, *itor, mDefaultWidth, mDefaultHeight );
+            ++slot;
+            ++itor;
+        }
+
+        mUpdatingSoA = true;
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::gatherNewParticles()
+    {
+        const size_t oldNumParticles = mParticleSoA.getNumParticles();
+        mParticleSoA.resize( oldNumParticles + mNewParticles.size() );
+
+        for( size_t i = 0u; i < mNewParticles.size(); ++i )
+            mParticleSoA.gather( oldNumParticles + i, mNewParticles[i], mDefaultWidth, mDefaultHeight );
+
+        mNewParticles.clear();
+    }
+    //-----------------------------------------------------------------------
+    void ParticleSystem::scatterParticleSoA()
+    {
+        const size_t numParticles = mParticleSoA.getNumParticles();
+
+        // Resize mActiveParticles, moving nodes from/to mSpareParticleNodes
+        const size_t oldNumParticles = mActiveParticles.size();
+        if( oldNumParticles > numParticles )
+        {
+            ActiveParticleList::iterator itor = mActiveParticles.end();
+            std::advance( itor, -static_cast<ptrdiff_t>( oldNumParticles - numParticles ) );
+            mSpareParticleNodes.splice( mSpareParticleNodes.end(), mActiveParticles, itor,
+                                        mActiveParticles.end() );
+        }
+        else if( oldNumParticles < numParticles )
+        {
+            const size_t numSpare =
+                std::min( numParticles - oldNumParticles, mSpareParticleNodes.size() );
+            ActiveParticleList::iterator itor = mSpareParticleNodes.begin();
+            std::advance( itor, static_cast<ptrdiff_t>( numSpare ) );
+            mActiveParticles.splice( mActiveParticles.end(), mSpareParticleNodes,
+                                     mSpareParticleNodes.begin(), itor );
+            mActiveParticles.resize( numParticles );
+        }
+
+        size_t slot = 0u;
+        ActiveParticleList::iterator itor = mActiveParticles.begin();
+        ActiveParticleList::iterator endt = mActiveParticles.end();
+        while( itor != endt )
+        {
+            mParticleSoA.scatter( slot );
+            *itor = mParticleSoA.getParticle( slot );
+            ++slot;
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
     ParticleIterator ParticleSystem::_getIterator()
     {
         return ParticleIterator( mActiveParticles.begin(), mActiveParticles.end() );
@@ -740,8 +1023,12 @@ namespace Ogre
         if( !mFreeParticles.empty() )
         {
             // Fast creation (don't use superclass since emitter will init)
-            p = mFreeParticles.front();
-            mActiveParticles.splice( mActiveParticles.end(), mFreeParticles, mFreeParticles.begin() );
+            p = mFreeParticles.back();
+            mFreeParticles.pop_back();
+            if( mUpdatingSoA )
+                mNewParticles.push_back( p );
+            else
+                addActiveParticle( p );
 
             p->_notifyOwner( this );
         }
@@ -759,7 +1046,10 @@ namespace Ogre
             p = fee->front();
             p->mParticleType = Particle::Emitter;
             fee->pop_front();
-            mActiveParticles.push_back( p );
+            if( mUpdatingSoA )
+                mNewParticles.push_back( p );
+            else
+                addActiveParticle( p );
 
             // Also add to mActiveEmittedEmitters. This is needed to traverse through all active emitters
             // that are emitted. Don't use mActiveParticles for that (although they are added to
@@ -866,8 +1156,13 @@ namespace Ogre
     {
         if( mParentNode && ( mBoundsAutoUpdate || mBoundsUpdateTime > 0.0f ) )
         {
+            // Outside of _update, the Particle instances hold the latest data
+            const bool bWasUpdatingSoA = mUpdatingSoA;
+            if( !bWasUpdatingSoA )
+                gatherParticleSoA();
+
             Aabb aabb;
-            if( mActiveParticles.empty() )
+            if( !mParticleSoA.getNumParticles() )
             {
                 // No particles, reset to null if auto update bounds
                 if( mBoundsAutoUpdate )
@@ -875,38 +1170,42 @@ namespace Ogre
             }
             else
             {
-                Vector3 min;
-                Vector3 max;
-                min.x = min.y = min.z = Math::POS_INFINITY;
-                max.x = max.y = max.z = Math::NEG_INFINITY;
-
-                ActiveParticleList::iterator p;
-                Vector3 halfScale = Vector3::UNIT_SCALE * 0.5;
-                Vector3 defaultPadding = halfScale * std::max( mDefaultHeight, mDefaultWidth );
-                for( p = mActiveParticles.begin(); p != mActiveParticles.end(); ++p )
+                // Unused lanes must not contribute
+                mParticleSoA.padLastPack();
+
+                const size_t numPacks = mParticleSoA.getNumPacks();
+                const ArrayReal *RESTRICT_ALIAS width = mParticleSoA.getArray( ParticleSoA::Width );
+                const ArrayReal *RESTRICT_ALIAS height = mParticleSoA.getArray( ParticleSoA::Height );
+                const ArrayReal half = Mathlib::SetAll( 0.5f );
+
+                ArrayVector3 min( Mathlib::SetAll( Math::POS_INFINITY ),
+                                  Mathlib::SetAll( Math::POS_INFINITY ),
+                                  Mathlib::SetAll( Math::POS_INFINITY ) );
+                ArrayVector3 max( Mathlib::SetAll( Math::NEG_INFINITY ),
+                                  Mathlib::SetAll( Math::NEG_INFINITY ),
+                                  Mathlib::SetAll( Math::NEG_INFINITY ) );
+
+                for( size_t i = 0u; i < numPacks; ++i )
                 {
-                    if( ( *p )->mOwnDimensions )
-                    {
-                        Vector3 padding = halfScale * std::max( ( *p )->mWidth, ( *p )->mHeight );
-                        min.makeFloor( ( *p )->mPosition - padding );
-                        max.makeCeil( ( *p )->mPosition + padding );
-                    }
-                    else
-                    {
-                        min.makeFloor( ( *p )->mPosition - defaultPadding );
-                        max.makeCeil( ( *p )->mPosition + defaultPadding );
-                    }
+                    const ArrayReal halfSize = Mathlib::Max( width[i], height[i] ) * half;
+                    const ArrayVector3 padding( halfSize, halfSize, halfSize );
+                    const ArrayVector3 position = mParticleSoA.getVector3( ParticleSoA::PositionX, i );
+                    min.makeFloor( position - padding );
+                    max.makeCeil( position + padding );
                 }
-                aabb.setExtents( min, max );
+                aabb.setExtents( min.collapseMin(), max.collapseMax() );
             }
 
+            if( !bWasUpdatingSoA )
+                mUpdatingSoA = false;
+
             if( !mLocalSpace )
             {
                 // We've already put particles in world space to decouple them from the
                 // node transform, so reverse transform back since we're expected to
                 // provide a local AABB
                 // TODO: (dark_sylinc) refactor the "Updated" part
-                aabb.transformAffine( mParentNode->_getFullTransformUpdated().inverseAffine() );
+                aabb.transformAffine( getParentNodeTransform().inverseAffine() );
             }
 
             mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
@@ -1047,8 +1346,18 @@ namespace Ogre
             mRenderer->_notifyParticleCleared( mActiveParticles );
         }
 
-        // Move actives to free list
-        mFreeParticles.splice( mFreeParticles.end(), mActiveParticles );
+        // Move actives to free list. Emitted emitters are returned to their own
+        // free lists by addActiveEmittedEmittersToFreeList below.
+        ActiveParticleList::const_iterator itor = mActiveParticles.begin();
+        ActiveParticleList::const_iterator endt = mActiveParticles.end();
+        while( itor != endt )
+        {
+            if( ( *itor )->mParticleType == Particle::Visual )
+                mFreeParticles.push_back( *itor );
+            ++itor;
+        }
+        mSpareParticleNodes.splice( mSpareParticleNodes.end(), mActiveParticles );
+        mParticleSoA.resize( 0u );
 
         // Add active emitted emitters to free list
         addActiveEmittedEmittersToFreeList();
@@ -38,6 +38,8 @@ THE SOFTWARE.
 #include "OgreProfiler.h"
 #include "OgreTextureBox.h"
 
+#include "Math/Array/OgreArrayConfig.h"
+
 namespace Ogre
 {
 #if OGRE_COMPILER == OGRE_COMPILER_MSVC && OGRE_COMP_VER < 1800
@@ -1108,7 +1110,7 @@ namespace Ogre
             std::swap( rgbaPtr[0], rgbaPtr[2] );
             break;
         case PFG_BGRX8_UNORM:
-            convertToFloat<uint8>( rgbaPtr, srcPtr, 4u, flags );
+            convertToFloat<uint8>( rgbaPtr, srcPtr, 3u, flags );
             std::swap( rgbaPtr[0], rgbaPtr[2] );
             break;
         case PFG_R10G10B10_XR_BIAS_A2_UNORM:
@@ -1302,6 +1304,354 @@ namespace Ogre
         void convCopy2Bpx( uint8 *src, uint8 *dst, size_t width ) { memcpy( dst, src, 2 * width ); }
         void convCopy1Bpx( uint8 *src, uint8 *dst, size_t width ) { memcpy( dst, src, 1 * width ); }
 
+        // The simd* functions convert as many pixels (or components) as they can in bulk and
+        // return how many they converted. The caller converts the remainder with scalar code,
+        // which also produces the exact same results as the brute force fallback.
+#if __OGRE_HAVE_SSE
+        /// Swaps R & B of 4 RGBA8 pixels. Alpha is forced to 0xFF if orMask = 0xFF000000
+        inline __m128i swapRB_SSE2( __m128i px, __m128i orMask )
+        {
+            const __m128i maskGA = _mm_set1_epi32( (int)0xFF00FF00 );
+            // 0x00BB00RR -> 0x00RR00BB
+            __m128i rb = _mm_andnot_si128( maskGA, px );
+            rb = _mm_or_si128( _mm_srli_epi32( rb, 16 ), _mm_slli_epi32( rb, 16 ) );
+            return _mm_or_si128( _mm_or_si128( _mm_and_si128( px, maskGA ), rb ), orMask );
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdSwapRB( const uint8 *src, uint8 *dst, size_t width, bool forceAlpha )
+        {
+            const __m128i orMask = _mm_set1_epi32( forceAlpha ? (int)0xFF000000 : 0 );
+            size_t i = 0;
+            for( ; i + 4u <= width; i += 4u )
+            {
+                const __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + i * 4u ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i * 4u ),
+                                  swapRB_SSE2( px, orMask ) );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdRGBtoRGBA( const uint8 *src, uint8 *dst, size_t width )
+        {
+            // SSE2 has no byte shuffle. Pixel k starts at byte 3k but must end up at 4k,
+            // so shift the whole register left by k bytes and keep only lane k.
+            const __m128i lane0 = _mm_setr_epi32( 0x00FFFFFF, 0, 0, 0 );
+            const __m128i lane1 = _mm_setr_epi32( 0, 0x00FFFFFF, 0, 0 );
+            const __m128i lane2 = _mm_setr_epi32( 0, 0, 0x00FFFFFF, 0 );
+            const __m128i lane3 = _mm_setr_epi32( 0, 0, 0, 0x00FFFFFF );
+            const __m128i alpha = _mm_set1_epi32( (int)0xFF000000 );
+
+            size_t i = 0;
+            // Each iteration reads 16 bytes but only consumes 12
+            for( ; i + 6u <= width; i += 4u )
+            {
+                const __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + i * 3u ) );
+                __m128i result = _mm_or_si128( alpha, _mm_and_si128( px, lane0 ) );
+                result = _mm_or_si128( result, _mm_and_si128( _mm_slli_si128( px, 1 ), lane1 ) );
+                result = _mm_or_si128( result, _mm_and_si128( _mm_slli_si128( px, 2 ), lane2 ) );
+                result = _mm_or_si128( result, _mm_and_si128( _mm_slli_si128( px, 3 ), lane3 ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i * 4u ), result );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdRtoRGBA( const uint8 *src, uint8 *dst, size_t width )
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i alpha = _mm_set1_epi32( (int)0xFF000000 );
+
+            size_t i = 0;
+            for( ; i + 16u <= width; i += 16u )
+            {
+                const __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + i ) );
+                const __m128i lo = _mm_unpacklo_epi8( px, zero );
+                const __m128i hi = _mm_unpackhi_epi8( px, zero );
+                __m128i *dstPtr = reinterpret_cast<__m128i *>( dst + i * 4u );
+                _mm_storeu_si128( dstPtr + 0, _mm_or_si128( _mm_unpacklo_epi16( lo, zero ), alpha ) );
+                _mm_storeu_si128( dstPtr + 1, _mm_or_si128( _mm_unpackhi_epi16( lo, zero ), alpha ) );
+                _mm_storeu_si128( dstPtr + 2, _mm_or_si128( _mm_unpacklo_epi16( hi, zero ), alpha ) );
+                _mm_storeu_si128( dstPtr + 3, _mm_or_si128( _mm_unpackhi_epi16( hi, zero ), alpha ) );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdUnorm8ToFloat( const uint8 *src, float *dst, size_t numComponents )
+        {
+            const __m128i zero = _mm_setzero_si128();
+            // Divide instead of multiplying by the reciprocal to match convertToFloat
+            const __m128 maxValue = _mm_set1_ps( 255.0f );
+
+            size_t i = 0;
+            for( ; i + 16u <= numComponents; i += 16u )
+            {
+                const __m128i val = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + i ) );
+                const __m128i lo = _mm_unpacklo_epi8( val, zero );
+                const __m128i hi = _mm_unpackhi_epi8( val, zero );
+                const __m128 v0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) );
+                const __m128 v1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) );
+                const __m128 v2 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) );
+                const __m128 v3 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) );
+                _mm_storeu_ps( dst + i + 0u, _mm_div_ps( v0, maxValue ) );
+                _mm_storeu_ps( dst + i + 4u, _mm_div_ps( v1, maxValue ) );
+                _mm_storeu_ps( dst + i + 8u, _mm_div_ps( v2, maxValue ) );
+                _mm_storeu_ps( dst + i + 12u, _mm_div_ps( v3, maxValue ) );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        /// saturate( val ) * 255 rounded half away from zero, like roundf.
+        /// _mm_cvtps_epi32 rounds half to even, hence it can't be used.
+        inline __m128i floatToUnorm8_SSE2( __m128 val )
+        {
+            val = _mm_min_ps( _mm_max_ps( val, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+            val = _mm_mul_ps( val, _mm_set1_ps( 255.0f ) );
+            const __m128i truncated = _mm_cvttps_epi32( val );
+            const __m128 fraction = _mm_sub_ps( val, _mm_cvtepi32_ps( truncated ) );
+            // roundUp is either 0 or -1
+            const __m128i roundUp = _mm_castps_si128( _mm_cmpge_ps( fraction, _mm_set1_ps( 0.5f ) ) );
+            return _mm_sub_epi32( truncated, roundUp );
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdFloatToUnorm8( const float *src, uint8 *dst, size_t numComponents )
+        {
+            size_t i = 0;
+            for( ; i + 16u <= numComponents; i += 16u )
+            {
+                const __m128i a = floatToUnorm8_SSE2( _mm_loadu_ps( src + i + 0u ) );
+                const __m128i b = floatToUnorm8_SSE2( _mm_loadu_ps( src + i + 4u ) );
+                const __m128i c = floatToUnorm8_SSE2( _mm_loadu_ps( src + i + 8u ) );
+                const __m128i d = floatToUnorm8_SSE2( _mm_loadu_ps( src + i + 12u ) );
+                // All values are in range [0; 255] so saturation never kicks in
+                const __m128i packed =
+                    _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i ), packed );
+            }
+            return i;
+        }
+#elif __OGRE_HAVE_NEON
+        size_t simdSwapRB( const uint8 *src, uint8 *dst, size_t width, bool forceAlpha )
+        {
+            size_t i = 0;
+            for( ; i + 16u <= width; i += 16u )
+            {
+                uint8x16x4_t px = vld4q_u8( src + i * 4u );
+                const uint8x16_t r = px.val[0];
+                px.val[0] = px.val[2];
+                px.val[2] = r;
+                if( forceAlpha )
+                    px.val[3] = vdupq_n_u8( 0xFF );
+                vst4q_u8( dst + i * 4u, px );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdRGBtoRGBA( const uint8 *src, uint8 *dst, size_t width )
+        {
+            size_t i = 0;
+            for( ; i + 16u <= width; i += 16u )
+            {
+                const uint8x16x3_t rgb = vld3q_u8( src + i * 3u );
+                uint8x16x4_t rgba;
+                rgba.val[0] = rgb.val[0];
+                rgba.val[1] = rgb.val[1];
+                rgba.val[2] = rgb.val[2];
+                rgba.val[3] = vdupq_n_u8( 0xFF );
+                vst4q_u8( dst + i * 4u, rgba );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdRtoRGBA( const uint8 *src, uint8 *dst, size_t width )
+        {
+            size_t i = 0;
+            for( ; i + 16u <= width; i += 16u )
+            {
+                uint8x16x4_t rgba;
+                rgba.val[0] = vld1q_u8( src + i );
+                rgba.val[1] = vdupq_n_u8( 0 );
+                rgba.val[2] = vdupq_n_u8( 0 );
+                rgba.val[3] = vdupq_n_u8( 0xFF );
+                vst4q_u8( dst + i * 4u, rgba );
+            }
+            return i;
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdUnorm8ToFloat( const uint8 *src, float *dst, size_t numComponents )
+        {
+#    if defined( __aarch64__ ) || defined( _M_ARM64 )
+            // Divide instead of multiplying by the reciprocal to match convertToFloat.
+            // ARMv7 NEON has no division, so it takes the scalar path.
+            const float32x4_t maxValue = vdupq_n_f32( 255.0f );
+
+            size_t i = 0;
+            for( ; i + 16u <= numComponents; i += 16u )
+            {
+                const uint8x16_t val = vld1q_u8( src + i );
+                const uint16x8_t lo = vmovl_u8( vget_low_u8( val ) );
+                const uint16x8_t hi = vmovl_u8( vget_high_u8( val ) );
+                vst1q_f32( dst + i + 0u,
+                           vdivq_f32( vcvtq_f32_u32( vmovl_u16( vget_low_u16( lo ) ) ), maxValue ) );
+                vst1q_f32( dst + i + 4u,
+                           vdivq_f32( vcvtq_f32_u32( vmovl_u16( vget_high_u16( lo ) ) ), maxValue ) );
+                vst1q_f32( dst + i + 8u,
+                           vdivq_f32( vcvtq_f32_u32( vmovl_u16( vget_low_u16( hi ) ) ), maxValue ) );
+                vst1q_f32( dst + i + 12u,
+                           vdivq_f32( vcvtq_f32_u32( vmovl_u16( vget_high_u16( hi ) ) ), maxValue ) );
+            }
+            return i;
+#    else
+            return 0u;
+#    endif
+        }
+        //-------------------------------------------------------------------------------
+        /// saturate( val ) * 255 rounded half away from zero, like roundf
+        inline uint16x4_t floatToUnorm8_NEON( float32x4_t val )
+        {
+            val = vminq_f32( vmaxq_f32( val, vdupq_n_f32( 0.0f ) ), vdupq_n_f32( 1.0f ) );
+            val = vmulq_f32( val, vdupq_n_f32( 255.0f ) );
+            const uint32x4_t truncated = vcvtq_u32_f32( val );
+            const float32x4_t fraction = vsubq_f32( val, vcvtq_f32_u32( truncated ) );
+            // roundUp is either 0 or 0xFFFFFFFF
+            const uint32x4_t roundUp = vcgeq_f32( fraction, vdupq_n_f32( 0.5f ) );
+            return vmovn_u32( vsubq_u32( truncated, roundUp ) );
+        }
+        //-------------------------------------------------------------------------------
+        size_t simdFloatToUnorm8( const float *src, uint8 *dst, size_t numComponents )
+        {
+            size_t i = 0;
+            for( ; i + 16u <= numComponents; i += 16u )
+            {
+                const uint16x8_t lo = vcombine_u16( floatToUnorm8_NEON( vld1q_f32( src + i + 0u ) ),
+                                                    floatToUnorm8_NEON( vld1q_f32( src + i + 4u ) ) );
+                const uint16x8_t hi = vcombine_u16( floatToUnorm8_NEON( vld1q_f32( src + i + 8u ) ),
+                                                    floatToUnorm8_NEON( vld1q_f32( src + i + 12u ) ) );
+                vst1q_u8( dst + i, vcombine_u8( vmovn_u16( lo ), vmovn_u16( hi ) ) );
+            }
+            return i;
+        }
+#else
+        size_t simdSwapRB( const uint8 *, uint8 *, size_t, bool ) { return 0u; }
+        size_t simdRGBtoRGBA( const uint8 *, uint8 *, size_t ) { return 0u; }
+        size_t simdRtoRGBA( const uint8 *, uint8 *, size_t ) { return 0u; }
+        size_t simdUnorm8ToFloat( const uint8 *, float *, size_t ) { return 0u; }
+        size_t simdFloatToUnorm8( const float *, uint8 *, size_t ) { return 0u; }
+#endif
+        //-------------------------------------------------------------------------------
+        void convRGBA8toRGBA32F( uint8 *src, uint8 *_dst, size_t width )
+        {
+            float *dst = reinterpret_cast<float *>( _dst );
+            const size_t numComponents = width * 4u;
+            for( size_t i = simdUnorm8ToFloat( src, dst, numComponents ); i < numComponents; ++i )
+                dst[i] = static_cast<float>( src[i] ) / 255.0f;
+        }
+        //-------------------------------------------------------------------------------
+        void convRGBA32FtoRGBA8( uint8 *_src, uint8 *dst, size_t width )
+        {
+            const float *src = reinterpret_cast<const float *>( _src );
+            const size_t numComponents = width * 4u;
+            for( size_t i = simdFloatToUnorm8( src, dst, numComponents ); i < numComponents; ++i )
+                dst[i] = static_cast<uint8>( roundf( Math::saturate( src[i] ) * 255.0f ) );
+        }
+        //-------------------------------------------------------------------------------
+        /// fromSRGB( i / 255 ) for every 8-bit value
+        struct SrgbToLinearTable
+        {
+            float values[256];
+            SrgbToLinearTable()
+            {
+                for( size_t i = 0; i < 256u; ++i )
+                    values[i] = PixelFormatGpuUtils::fromSRGB( static_cast<float>( i ) / 255.0f );
+            }
+        };
+        //-------------------------------------------------------------------------------
+        void convRGBA8SrgbtoRGBA32F( uint8 *src, uint8 *_dst, size_t width )
+        {
+            static const SrgbToLinearTable table;
+
+            float *dst = reinterpret_cast<float *>( _dst );
+            while( width-- )
+            {
+                dst[0] = table.values[src[0]];
+                dst[1] = table.values[src[1]];
+                dst[2] = table.values[src[2]];
+                dst[3] = static_cast<float>( src[3] ) / 255.0f;
+                src += 4u;
+                dst += 4u;
+            }
+        }
+        //-------------------------------------------------------------------------------
+        void convRGBA32FtoRGBA8Srgb( uint8 *_src, uint8 *dst, size_t width )
+        {
+            const float *src = reinterpret_cast<const float *>( _src );
+            while( width-- )
+            {
+                for( size_t i = 0; i < 3u; ++i )
+                {
+                    const float val = PixelFormatGpuUtils::toSRGB( Math::saturate( src[i] ) );
+                    dst[i] = static_cast<uint8>( roundf( val * 255.0f ) );
+                }
+                dst[3] = static_cast<uint8>( roundf( Math::saturate( src[3] ) * 255.0f ) );
+                src += 4u;
+                dst += 4u;
+            }
+        }
+        //-------------------------------------------------------------------------------
+        // There is no half <-> float conversion in SSE2 (F16C is a separate extension),
+        // but converting straight through Bitwise still skips the per-pixel format switch
+        void convRGBA16FtoRGBA32F( uint8 *_src, uint8 *_dst, size_t width )
+        {
+            const uint16 *src = reinterpret_cast<const uint16 *>( _src );
+            uint32 *dst = reinterpret_cast<uint32 *>( _dst );
+            const size_t numComponents = width * 4u;
+            for( size_t i = 0; i < numComponents; ++i )
+                dst[i] = Bitwise::halfToFloatI( src[i] );
+        }
+        //-------------------------------------------------------------------------------
+        void convRGBA32FtoRGBA16F( uint8 *_src, uint8 *_dst, size_t width )
+        {
+            const uint32 *src = reinterpret_cast<const uint32 *>( _src );
+            uint16 *dst = reinterpret_cast<uint16 *>( _dst );
+            const size_t numComponents = width * 4u;
+            for( size_t i = 0; i < numComponents; ++i )
+                dst[i] = Bitwise::floatToHalfI( src[i] );
+        }
+        //-------------------------------------------------------------------------------
+        void convRtoRGBA( uint8 *src, uint8 *dst, size_t width )
+        {
+            const size_t converted = simdRtoRGBA( src, dst, width );
+            src += converted;
+            dst += converted * 4u;
+            width -= converted;
+            while( width-- )
+            {
+                dst[0] = src[0];
+                dst[1] = 0u;
+                dst[2] = 0u;
+                dst[3] = 0xFF;
+                src += 1u;
+                dst += 4u;
+            }
+        }
+        //-------------------------------------------------------------------------------
+        struct FormatPairConversion
+        {
+            PixelFormatGpu srcFormat;
+            PixelFormatGpu dstFormat;
+            row_conversion_func_t rowConversionFunc;
+        };
+
+        /// Conversions between formats of different types (which would otherwise go through
+        /// unpackColour & packColour) that are common enough to deserve their own routine.
+        const FormatPairConversion c_formatPairConversions[] = {
+            { PFG_RGBA8_UNORM, PFG_RGBA32_FLOAT, convRGBA8toRGBA32F },
+            { PFG_RGBA32_FLOAT, PFG_RGBA8_UNORM, convRGBA32FtoRGBA8 },
+            { PFG_RGBA8_UNORM_SRGB, PFG_RGBA32_FLOAT, convRGBA8SrgbtoRGBA32F },
+            { PFG_RGBA32_FLOAT, PFG_RGBA8_UNORM_SRGB, convRGBA32FtoRGBA8Srgb },
+            { PFG_RGBA16_FLOAT, PFG_RGBA32_FLOAT, convRGBA16FtoRGBA32F },
+            { PFG_RGBA32_FLOAT, PFG_RGBA16_FLOAT, convRGBA32FtoRGBA16F },
+            { PFG_R8_UNORM, PFG_RGBA8_UNORM, convRtoRGBA },
+        };
+
         // clang-format off
         void convRGBA32toRGB32(uint8* _src, uint8* _dst, size_t width) {
             uint32* src = (uint32*)_src; uint32* dst = (uint32*)_dst;
@@ -1343,6 +1693,8 @@ namespace Ogre
         }
 
         void convRGBAtoBGRA(uint8* src, uint8* dst, size_t width) {
+            const size_t converted = simdSwapRB(src, dst, width, false);
+            src += converted * 4u; dst += converted * 4u; width -= converted;
             while (width--)
             { dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0]; dst[3] = src[3]; src += 4; dst += 4; }
         }
@@ -1379,6 +1731,8 @@ namespace Ogre
         }
 
         void convBGRXtoRGBA(uint8* src, uint8* dst, size_t width) {
+            const size_t converted = simdSwapRB(src, dst, width, true);
+            src += converted * 4u; dst += converted * 4u; width -= converted;
             while (width--)
             { dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0]; dst[3] = 0xFF; src += 4; dst += 4; }
         }
@@ -1388,6 +1742,8 @@ namespace Ogre
         }
 
         void convRGBtoRGBA(uint8* src, uint8* dst, size_t width) {
+            const size_t converted = simdRGBtoRGBA(src, dst, width);
+            src += converted * 3u; dst += converted * 4u; width -= converted;
             while (width--)
             { dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 0xFF; src += 3; dst += 4; }
         }
@@ -1588,6 +1944,21 @@ namespace Ogre
         }
 #undef PFL_PAIR
 
+        if( !rowConversionFunc )
+        {
+            // Conversions between different types, i.e. not a mere swizzle
+            const size_t numPairs =
+                sizeof( c_formatPairConversions ) / sizeof( c_formatPairConversions[0] );
+            for( size_t i = 0; i < numPairs && !rowConversionFunc; ++i )
+            {
+                if( c_formatPairConversions[i].srcFormat == srcFormat &&
+                    c_formatPairConversions[i].dstFormat == dstFormat )
+                {
+                    rowConversionFunc = c_formatPairConversions[i].rowConversionFunc;
+                }
+            }
+        }
+
         if( rowConversionFunc )
         {
             for( size_t z = 0; z < depthOrSlices; ++z )
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "CommandBuffer/OgreCbPipelineStateObject.h"
 #include "CommandBuffer/OgreCbShaderBuffer.h"
 #include "CommandBuffer/OgreCommandBuffer.h"
+#include "OgreCamera.h"
 #include "OgreHardwareBufferManager.h"
 #include "OgreHlms.h"
 #include "OgreHlmsDatablock.h"
@@ -42,10 +43,12 @@ THE SOFTWARE.
 #include "OgreMovableObject.h"
 #include "OgrePass.h"
 #include "OgreProfiler.h"
+#include "OgreRadixSort.h"
 #include "OgreRoot.h"
 #include "OgreSceneManager.h"
 #include "OgreSceneManagerEnumerator.h"
 #include "OgreTechnique.h"
+#include "Threading/OgreUniformScalableTask.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreIndirectBufferPacked.h"
 #include "Vao/OgreVaoManager.h"
@@ -57,6 +60,88 @@ namespace Ogre
 
     const HlmsCache c_dummyCache( 0, HLMS_MAX, HlmsPso() );
 
+    /// Below this size the fixed cost of the radix sort histograms isn't worth it.
+    static const size_t c_minRadixSortSize = 256u;
+
+    /// Cached sorted queues unused for more frames than this are released.
+    static const uint32 c_maxCachedSortedQueueAge = 16u;
+
+    /// MurmurHash3's 64-bit finalizer
+    static inline uint64 mixBits64( uint64 k )
+    {
+        k ^= k >> 33u;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33u;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33u;
+        return k;
+    }
+
+    struct QueuedRenderableKey
+    {
+        uint64 operator()( const QueuedRenderable &val ) const { return val.hash; }
+    };
+    typedef RadixSort64<QueuedRenderable, QueuedRenderableKey> QueuedRenderableRadixSort;
+
+    /// Radix sorts one slice of the queue per worker thread. See sortRenderablesInParallel
+    class RenderQueueSortTask final : public UniformScalableTask
+    {
+        QueuedRenderable *mQueuedRenderables;
+        QueuedRenderable *mScratch;
+        size_t            mNumRenderables;
+        size_t            mSliceSize;
+
+    public:
+        RenderQueueSortTask( QueuedRenderable *queuedRenderables, QueuedRenderable *scratch,
+                             size_t numRenderables, size_t sliceSize ) :
+            mQueuedRenderables( queuedRenderables ),
+            mScratch( scratch ),
+            mNumRenderables( numRenderables ),
+            mSliceSize( sliceSize )
+        {
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            const size_t firstIdx = std::min( threadId * mSliceSize, mNumRenderables );
+            const size_t lastIdx = std::min( firstIdx + mSliceSize, mNumRenderables );
+
+            // Each thread uses its own slice of the scratch buffer.
+            QueuedRenderableRadixSort::sort( mQueuedRenderables + firstIdx, mScratch + firstIdx,
+                                             lastIdx - firstIdx );
+        }
+    };
+
+    /// Resolves the Vao and shaders of a range of renderables per worker thread.
+    /// See RenderQueue::setParallelPrepareThreshold
+    class RenderQueue::PrepareTask final : public UniformScalableTask
+    {
+    public:
+        /// A FAST queue to prepare, and where its results start in mPreparedRenderables
+        struct Range
+        {
+            QueuedRenderableArray const *queuedRenderables;
+            size_t                       offset;
+        };
+        typedef FastArray<Range> RangeArray;
+
+    private:
+        RenderQueue      *mRenderQueue;
+        bool              mCasterPass;
+        RangeArray const &mRanges;
+
+    public:
+        PrepareTask( RenderQueue *renderQueue, bool casterPass, const RangeArray &ranges ) :
+            mRenderQueue( renderQueue ),
+            mCasterPass( casterPass ),
+            mRanges( ranges )
+        {
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override;
+    };
+    //-----------------------------------------------------------------------
+
     // clang-format off
     const int RqBits::SubRqIdBits           = 3;
     const int RqBits::TransparencyBits      = 1;
@@ -93,7 +178,12 @@ namespace Ogre
         mLastIndexData( 0 ),
         mLastTextureHash( 0 ),
         mCommandBuffer( 0 ),
-        mRenderingStarted( 0u )
+        mRenderingStarted( 0u ),
+        mParallelSortThreshold( 32768u ),
+        mParallelPrepareThreshold( 0u ),
+        mTemporalCoherence( false ),
+        mFrameCount( 0u ),
+        mNumReplayedQueues( 0u )
     {
         mCommandBuffer = new CommandBuffer();
 
@@ -178,11 +268,22 @@ namespace Ogre
             while( itor != endt )
             {
                 itor->q.clear();
+                itor->signature[0] = 0u;
+                itor->signature[1] = 0u;
                 ++itor;
             }
 
-            mRenderQueues[i].mQueuedRenderables.clear();
-            mRenderQueues[i].mSorted = false;
+            RenderQueueGroup &renderQueueGroup = mRenderQueues[i];
+            if( renderQueueGroup.mCachedQueueToSwap != std::numeric_limits<size_t>::max() )
+            {
+                // Give the sorted queue back to (or store it in) the cache
+                renderQueueGroup.mCachedSortedQueues[renderQueueGroup.mCachedQueueToSwap]
+                    .queuedRenderables.swap( renderQueueGroup.mQueuedRenderables );
+                renderQueueGroup.mCachedQueueToSwap = std::numeric_limits<size_t>::max();
+            }
+
+            renderQueueGroup.mQueuedRenderables.clear();
+            renderQueueGroup.mSorted = false;
         }
     }
     //-----------------------------------------------------------------------
@@ -296,8 +397,22 @@ namespace Ogre
 
 #undef OGRE_RQ_HASH
 
-        mRenderQueues[rqId].mQueuedRenderablesPerThread[threadIdx].q.push_back(
-            QueuedRenderable( hash, pRend, pMovableObject ) );
+        ThreadRenderQueue &threadRenderQueue =
+            mRenderQueues[rqId].mQueuedRenderablesPerThread[threadIdx];
+
+        if( mTemporalCoherence )
+        {
+            // Order-independent, since the order in which worker threads
+            // add the renderables changes every frame.
+            const uint64 ptrHash =
+                mixBits64( reinterpret_cast<uintptr_t>( pRend ) ^
+                           mixBits64( reinterpret_cast<uintptr_t>( pMovableObject ) ) );
+            const uint64 h = mixBits64( hash ^ ptrHash );
+            threadRenderQueue.signature[0] += h;
+            threadRenderQueue.signature[1] ^= mixBits64( h + 0x9e3779b97f4a7c15ULL );
+        }
+
+        threadRenderQueue.q.push_back( QueuedRenderable( hash, pRend, pMovableObject ) );
     }
     //-----------------------------------------------------------------------
     void RenderQueue::renderPassPrepare( bool casterPass, bool dualParaboloid )
@@ -376,56 +491,17 @@ namespace Ogre
 
         for( size_t i = firstRq; i < lastRq; ++i )
         {
-            QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
-            QueuedRenderableArrayPerThread &perThreadQueue =
-                mRenderQueues[i].mQueuedRenderablesPerThread;
-
             if( !mRenderQueues[i].mSorted )
-            {
-                OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
-
-                size_t numRenderables = 0;
-                QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
-                QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
-
-                while( itor != endt )
-                {
-                    numRenderables += itor->q.size();
-                    ++itor;
-                }
-
-                queuedRenderables.reserve( numRenderables );
-
-                itor = perThreadQueue.begin();
-                while( itor != endt )
-                {
-                    queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
-                    ++itor;
-                }
+                mergeAndSortRenderQueue( mRenderQueues[i], casterPass );
+        }
 
-                // TODO: Exploit temporal coherence across frames then use insertion sorts.
-                // As explained by L. Spiro in
-                // http://www.gamedev.net/topic/661114-temporal-coherence-and-render-queue-sorting/?view=findpost&p=5181408
-                // Keep a list of sorted indices from the previous frame (one per camera).
-                // If we have the sorted list "5, 1, 4, 3, 2, 0":
-                //  * If it grew from last frame, append: 5, 1, 4, 3, 2, 0, 6, 7 and use insertion sort.
-                //  * If it's the same, leave it as is, and use insertion sort just in case.
-                //  * If it's shorter, reset the indices 0, 1, 2, 3, 4; probably use quicksort or other
-                //  generic sort
-                //
-                // TODO2: Explore sorting first on multiple threads, then merge sort into one.
-                if( mRenderQueues[i].mSortMode == NormalSort )
-                {
-                    std::sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-                else if( mRenderQueues[i].mSortMode == StableSort )
-                {
-                    std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-            }
+        const bool preparedInParallel =
+            prepareRenderablesInParallel( firstRq, lastRq, casterPass, numNeededDraws );
+        const PreparedRenderable *preparedRenderables =
+            preparedInParallel ? mPreparedRenderables.begin() : 0;
 
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
             if( mRenderQueues[i].mMode == V1_LEGACY )
             {
                 if( mLastVaoName )
@@ -447,8 +523,11 @@ namespace Ogre
             }
             else if( numNeededDraws > 0 /*&& mRenderQueues[i].mMode == FAST*/ )
             {
-                indirectDraw = renderGL3( rs, casterPass, dualParaboloid, mPassCache, mRenderQueues[i],
-                                          indirectBuffer, indirectDraw, startIndirectDraw );
+                indirectDraw =
+                    renderGL3( rs, casterPass, dualParaboloid, mPassCache, mRenderQueues[i],
+                               indirectBuffer, indirectDraw, startIndirectDraw, preparedRenderables );
+                if( preparedRenderables )
+                    preparedRenderables += mRenderQueues[i].mQueuedRenderables.size();
             }
         }
 
@@ -566,7 +645,13 @@ namespace Ogre
 
             lastHlmsCacheHash = lastHlmsCache->hash;
             const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
-                                                            queuedRenderable, casterPass );
+                                                            queuedRenderable, casterPass, true );
+            if( !hlmsCache )
+            {
+                // Its shaders are still being generated. See Hlms::setAsyncShaderGeneration
+                ++itor;
+                continue;
+            }
             if( lastHlmsCacheHash != hlmsCache->hash )
             {
                 rs->_setPipelineStateObject( &hlmsCache->pso );
@@ -589,12 +674,252 @@ namespace Ogre
         mLastTextureHash = lastTextureHash;
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::sortRenderQueue( RenderQueueGroup &renderQueueGroup )
+    {
+        if( renderQueueGroup.mSortMode == DisableSort )
+            return;
+
+        QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        const size_t numRenderables = queuedRenderables.size();
+
+        if( numRenderables < c_minRadixSortSize )
+        {
+            if( renderQueueGroup.mSortMode == NormalSort )
+                std::sort( queuedRenderables.begin(), queuedRenderables.end() );
+            else
+                std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
+        }
+        else if( mParallelSortThreshold && numRenderables >= mParallelSortThreshold &&
+                 mSceneManager->getNumWorkerThreads() > 1u )
+        {
+            sortRenderablesInParallel( queuedRenderables );
+        }
+        else
+        {
+            // Radix sort is stable, thus it works for both NormalSort and StableSort.
+            // It is also fast when only a few bits of the hash differ between renderables.
+            mSortScratch.resizePOD( numRenderables );
+            QueuedRenderableRadixSort::sort( queuedRenderables.begin(), mSortScratch.begin(),
+                                             numRenderables );
+        }
+
+        renderQueueGroup.mSorted = true;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::mergeAndSortRenderQueue( RenderQueueGroup &renderQueueGroup, bool casterPass )
+    {
+        OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
+
+        QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        const QueuedRenderableArrayPerThread &perThreadQueue =
+            renderQueueGroup.mQueuedRenderablesPerThread;
+
+        size_t numRenderables = 0;
+        uint64 signature[2] = { 0u, 0u };
+        QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
+        QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
+
+        while( itor != endt )
+        {
+            numRenderables += itor->q.size();
+            signature[0] += itor->signature[0];
+            signature[1] ^= itor->signature[1];
+            ++itor;
+        }
+
+        // StableSort and DisableSort queues depend on the order in which renderables
+        // were added, thus they can't be replayed only based on the visible set.
+        if( mTemporalCoherence && renderQueueGroup.mSortMode == NormalSort && numRenderables > 1u )
+        {
+            const IdType cameraId = mSceneManager->getCamerasInProgress().renderingCamera->getId();
+
+            CachedSortedQueueVec &cachedQueues = renderQueueGroup.mCachedSortedQueues;
+            CachedSortedQueueVec::iterator itCache = cachedQueues.begin();
+            CachedSortedQueueVec::iterator enCache = cachedQueues.end();
+
+            while( itCache != enCache &&
+                   ( itCache->cameraId != cameraId || itCache->casterPass != casterPass ) )
+            {
+                ++itCache;
+            }
+
+            if( itCache == enCache )
+            {
+                cachedQueues.push_back( CachedSortedQueue() );
+                itCache = cachedQueues.end() - 1u;
+                itCache->cameraId = cameraId;
+                itCache->casterPass = casterPass;
+                itCache->signature[0] = 0u;
+                itCache->signature[1] = 0u;
+            }
+
+            CachedSortedQueue &cachedQueue = *itCache;
+            cachedQueue.lastUsedFrame = mFrameCount;
+            // Either way, clear() swaps mQueuedRenderables with the cached queue again
+            renderQueueGroup.mCachedQueueToSwap = static_cast<size_t>( itCache - cachedQueues.begin() );
+
+            if( cachedQueue.queuedRenderables.size() == numRenderables &&
+                cachedQueue.signature[0] == signature[0] && cachedQueue.signature[1] == signature[1] )
+            {
+                // Same renderables as last time, thus the same order is still valid.
+                // Borrow the cached queue instead of merging and sorting.
+                queuedRenderables.swap( cachedQueue.queuedRenderables );
+                renderQueueGroup.mSorted = true;
+                ++mNumReplayedQueues;
+                return;
+            }
+
+            // What gets sorted below will be stored in the cache on clear()
+            cachedQueue.signature[0] = signature[0];
+            cachedQueue.signature[1] = signature[1];
+        }
+
+        queuedRenderables.reserve( numRenderables );
+
+        itor = perThreadQueue.begin();
+        while( itor != endt )
+        {
+            queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
+            ++itor;
+        }
+
+        sortRenderQueue( renderQueueGroup );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::clearCachedSortedQueues( RenderQueueGroup &renderQueueGroup )
+    {
+        // If mQueuedRenderables is a borrowed cached queue, it just stays
+        // there until clear() empties it.
+        renderQueueGroup.mCachedQueueToSwap = std::numeric_limits<size_t>::max();
+        renderQueueGroup.mCachedSortedQueues.clear();
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::sortRenderablesInParallel( QueuedRenderableArray &queuedRenderables )
+    {
+        OgreProfileGroupAggregate( "Parallel Sorting", OGREPROF_RENDERING );
+
+        const size_t numRenderables = queuedRenderables.size();
+        const size_t numThreads = mSceneManager->getNumWorkerThreads();
+        const size_t sliceSize = ( numRenderables + numThreads - 1u ) / numThreads;
+
+        mSortScratch.resizePOD( numRenderables );
+
+        RenderQueueSortTask sortTask( queuedRenderables.begin(), mSortScratch.begin(), numRenderables,
+                                      sliceSize );
+        mSceneManager->executeUserScalableTask( &sortTask, true );
+
+        // Merge all sorted slices at once straight into mSortScratch
+        QueuedRenderableRadixSort::mergeSortedSlices( queuedRenderables.begin(), mSortScratch.begin(),
+                                                      numRenderables, sliceSize );
+        queuedRenderables.swap( mSortScratch );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::setParallelSortThreshold( size_t numRenderables )
+    {
+        mParallelSortThreshold = numRenderables;
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueue::prepareRenderablesInParallel( uint8 firstRq, uint8 lastRq, bool casterPass,
+                                                    size_t numNeededDraws )
+    {
+        if( !mParallelPrepareThreshold || numNeededDraws < mParallelPrepareThreshold )
+            return false;
+
+        OgreProfileGroupAggregate( "Parallel Renderable Preparation", OGREPROF_RENDERING );
+
+        PrepareTask::RangeArray ranges;
+        ranges.reserve( lastRq - firstRq );
+
+        size_t numRenderables = 0u;
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            if( mRenderQueues[i].mMode == FAST )
+            {
+                PrepareTask::Range range;
+                range.queuedRenderables = &mRenderQueues[i].mQueuedRenderables;
+                range.offset = numRenderables;
+                ranges.push_back( range );
+                numRenderables += mRenderQueues[i].mQueuedRenderables.size();
+            }
+        }
+
+        mPreparedRenderables.resizePOD( numRenderables );
+
+        // The worker threads only read the shader cache; they never create shaders. We block
+        // until they're done, so nothing can modify the cache while they're reading it.
+        PrepareTask prepareTask( this, casterPass, ranges );
+        mSceneManager->executeUserScalableTask( &prepareTask, true );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::PrepareTask::execute( size_t threadId, size_t numThreads )
+    {
+        // All renderables take roughly the same time, so split them evenly.
+        const size_t numRenderables = mRenderQueue->mPreparedRenderables.size();
+        const size_t numPerThread = ( numRenderables + numThreads - 1u ) / numThreads;
+        const size_t firstIdx = std::min( threadId * numPerThread, numRenderables );
+        const size_t lastIdx = std::min( firstIdx + numPerThread, numRenderables );
+
+        const bool casterPass = mCasterPass;
+        HlmsManager *hlmsManager = mRenderQueue->mHlmsManager;
+        const HlmsCache *passCache = mRenderQueue->mPassCache;
+        PreparedRenderable *preparedRenderables = mRenderQueue->mPreparedRenderables.begin();
+
+        RangeArray::const_iterator itRange = mRanges.begin();
+        RangeArray::const_iterator enRange = mRanges.end();
+
+        while( itRange != enRange )
+        {
+            const size_t rangeStart = itRange->offset;
+            const size_t rangeEnd = rangeStart + itRange->queuedRenderables->size();
+
+            const size_t start = std::max( firstIdx, rangeStart );
+            const size_t end = std::min( lastIdx, rangeEnd );
+
+            for( size_t i = start; i < end; ++i )
+            {
+                const QueuedRenderable &queuedRenderable =
+                    ( *itRange->queuedRenderables )[i - rangeStart];
+                PreparedRenderable &prepared = preparedRenderables[i];
+
+                const uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
+                const VertexArrayObjectArray &vaos =
+                    queuedRenderable.renderable->getVaos( static_cast<VertexPass>( casterPass ) );
+                prepared.vao = vaos[meshLod];
+
+                const HlmsDatablock *datablock = queuedRenderable.renderable->getDatablock();
+                const Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+                prepared.hlmsCache =
+                    hlms->findMaterial( passCache[datablock->mType], queuedRenderable, casterPass );
+            }
+
+            ++itRange;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::setParallelPrepareThreshold( size_t numRenderables )
+    {
+        mParallelPrepareThreshold = numRenderables;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::setTemporalCoherence( bool bEnabled )
+    {
+        mTemporalCoherence = bEnabled;
+        if( !bEnabled )
+        {
+            for( size_t i = 0; i < 256; ++i )
+                clearCachedSortedQueues( mRenderQueues[i] );
+        }
+    }
+    //-----------------------------------------------------------------------
     unsigned char *RenderQueue::renderGL3( RenderSystem *rs, bool casterPass, bool dualParaboloid,
                                            HlmsCache passCache[],
                                            const RenderQueueGroup &renderQueueGroup,
                                            IndirectBufferPacked *indirectBuffer,
                                            unsigned char *indirectDraw,
-                                           unsigned char *startIndirectDraw )
+                                           unsigned char *startIndirectDraw,
+                                           const PreparedRenderable *preparedRenderables )
     {
         VertexArrayObject *lastVao = 0;
         uint32 lastVaoName = mLastVaoName;
@@ -625,18 +950,44 @@ namespace Ogre
         while( itor != endt )
         {
             const QueuedRenderable &queuedRenderable = *itor;
-            uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
-            const VertexArrayObjectArray &vaos =
-                queuedRenderable.renderable->getVaos( static_cast<VertexPass>( casterPass ) );
-
-            VertexArrayObject *vao = vaos[meshLod];
             const HlmsDatablock *datablock = queuedRenderable.renderable->getDatablock();
 
             Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
 
+            VertexArrayObject *vao;
+            const HlmsCache *hlmsCache;
             lastHlmsCacheHash = lastHlmsCache->hash;
-            const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
-                                                            queuedRenderable, casterPass );
+
+            if( preparedRenderables )
+            {
+                // Resolved by the worker threads. See prepareRenderablesInParallel
+                vao = preparedRenderables->vao;
+                hlmsCache = preparedRenderables->hlmsCache;
+                ++preparedRenderables;
+                if( !hlmsCache )
+                {
+                    // The shaders didn't exist yet. Create them now.
+                    hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
+                                                   queuedRenderable, casterPass, true );
+                }
+            }
+            else
+            {
+                uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
+                const VertexArrayObjectArray &vaos =
+                    queuedRenderable.renderable->getVaos( static_cast<VertexPass>( casterPass ) );
+                vao = vaos[meshLod];
+
+                hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
+                                               queuedRenderable, casterPass, true );
+            }
+
+            if( !hlmsCache )
+            {
+                // Its shaders are still being generated. See Hlms::setAsyncShaderGeneration
+                ++itor;
+                continue;
+            }
             if( lastHlmsCacheHash != hlmsCache->hash )
             {
                 CbPipelineStateObject *psoCmd = mCommandBuffer->addCommand<CbPipelineStateObject>();
@@ -801,7 +1152,13 @@ namespace Ogre
 
             lastHlmsCacheHash = lastHlmsCache->hash;
             const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
-                                                            queuedRenderable, casterPass );
+                                                            queuedRenderable, casterPass, true );
+            if( !hlmsCache )
+            {
+                // Its shaders are still being generated. See Hlms::setAsyncShaderGeneration
+                ++itor;
+                continue;
+            }
             if( lastHlmsCache != hlmsCache )
             {
                 CbPipelineStateObject *psoCmd = mCommandBuffer->addCommand<CbPipelineStateObject>();
@@ -1002,6 +1359,37 @@ namespace Ogre
         mFreeIndirectBuffers.insert( mFreeIndirectBuffers.end(), mUsedIndirectBuffers.begin(),
                                      mUsedIndirectBuffers.end() );
         mUsedIndirectBuffers.clear();
+
+        if( mTemporalCoherence )
+        {
+            // Release the sorted queues of cameras that stopped rendering (or got destroyed)
+            for( size_t i = 0; i < 256; ++i )
+            {
+                RenderQueueGroup &renderQueueGroup = mRenderQueues[i];
+                CachedSortedQueueVec &cachedQueues = renderQueueGroup.mCachedSortedQueues;
+
+                size_t j = 0u;
+                while( j < cachedQueues.size() )
+                {
+                    if( mFrameCount - cachedQueues[j].lastUsedFrame > c_maxCachedSortedQueueAge &&
+                        j != renderQueueGroup.mCachedQueueToSwap )
+                    {
+                        cachedQueues.erase( cachedQueues.begin() + static_cast<ptrdiff_t>( j ) );
+                        if( j < renderQueueGroup.mCachedQueueToSwap &&
+                            renderQueueGroup.mCachedQueueToSwap != std::numeric_limits<size_t>::max() )
+                        {
+                            --renderQueueGroup.mCachedQueueToSwap;
+                        }
+                    }
+                    else
+                    {
+                        ++j;
+                    }
+                }
+            }
+        }
+
+        ++mFrameCount;
     }
     //-----------------------------------------------------------------------
     void RenderQueue::setRenderQueueMode( uint8 rqId, Modes newMode )
@@ -1017,6 +1405,8 @@ namespace Ogre
     void RenderQueue::setSortRenderQueue( uint8 rqId, RqSortMode sortMode )
     {
         mRenderQueues[rqId].mSortMode = sortMode;
+        if( sortMode != NormalSort )
+            clearCachedSortedQueues( mRenderQueues[rqId] );
     }
     //-----------------------------------------------------------------------
     RenderQueue::RqSortMode RenderQueue::getSortRenderQueue( uint8 rqId ) const
@@ -71,6 +71,7 @@ THE SOFTWARE.
 #include "OgreRibbonTrail.h"
 #include "OgreRoot.h"
 #include "OgreSceneNode.h"
+#include "OgreSceneQueryBvh.h"
 #include "OgreSubEntity.h"
 #include "OgreTechnique.h"
 #include "OgreTextureGpuManager.h"
@@ -105,6 +106,28 @@ namespace Ogre
 
     static NullAtmosphereComponent c_nullAtmosphere;
 
+    /// Runs the updates deferred by ParticleSystem::_scheduleUpdate. One chunk per system.
+    class _OgrePrivate ParticleSystemUpdateTask final : public UniformScalableTask
+    {
+        FastArray<ParticleSystem *> const &mParticleSystems;
+        WorkStealingScheduler             &mScheduler;
+
+    public:
+        ParticleSystemUpdateTask( const FastArray<ParticleSystem *> &particleSystems,
+                                  WorkStealingScheduler &scheduler ) :
+            mParticleSystems( particleSystems ),
+            mScheduler( scheduler )
+        {
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            size_t chunkIdx;
+            while( mScheduler.getNextChunk( threadId, chunkIdx ) )
+                mParticleSystems[chunkIdx]->_executePendingUpdate();
+        }
+    };
+
     //-----------------------------------------------------------------------
     uint32 SceneManager::QUERY_ENTITY_DEFAULT_MASK = 0x80000000;
     uint32 SceneManager::QUERY_FX_DEFAULT_MASK = 0x40000000;
@@ -165,10 +188,13 @@ namespace Ogre
         mFindVisibleObjects( true ),
         mNumWorkerThreads( std::max<size_t>( numWorkerThreads, 1u ) ),
         mForceMainThread( numWorkerThreads == 0u ? true : false ),
-        mUpdateBoundsRequest( 0 ),
         mUserTask( 0 ),
         mRequestType( NUM_REQUESTS ),
         mWorkerThreadsBarrier( 0 ),
+        mWorkStealingScheduler( std::max<size_t>( numWorkerThreads, 1u ) ),
+        mMinObjectsPerChunk( 64u ),
+        mSceneQueryBvh( 0 ),
+        mParticleSystemUpdatesThreaded( false ),
         mSuppressRenderStateChanges( false ),
         mLastLightHash( 0 ),
         mLastLightLimit( 0 ),
@@ -277,6 +303,9 @@ namespace Ogre
         OGRE_DELETE mRadialDensityMask;
         mRadialDensityMask = 0;
 
+        OGRE_DELETE mSceneQueryBvh;
+        mSceneQueryBvh = 0;
+
         fireSceneManagerDestroyed();
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
@@ -776,6 +805,64 @@ namespace Ogre
         destroyAllMovableObjectsByType( ParticleSystemFactory::FACTORY_TYPE_NAME );
     }
     //-----------------------------------------------------------------------
+    void SceneManager::setParticleSystemUpdatesThreaded( bool bThreaded )
+    {
+        mParticleSystemUpdatesThreaded = bThreaded;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_addPendingParticleSystemUpdate( ParticleSystem *particleSystem )
+    {
+        mPendingParticleSystemUpdates.push_back( particleSystem );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_removePendingParticleSystemUpdate( ParticleSystem *particleSystem )
+    {
+        FastArray<ParticleSystem *>::iterator itor = std::find(
+            mPendingParticleSystemUpdates.begin(), mPendingParticleSystemUpdates.end(), particleSystem );
+        if( itor != mPendingParticleSystemUpdates.end() )
+            efficientVectorRemove( mPendingParticleSystemUpdates, itor );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateAllParticleSystems()
+    {
+        if( mPendingParticleSystemUpdates.empty() )
+            return;
+
+        OgreProfile( "SceneManager::updateAllParticleSystems" );
+
+        // Systems that got detached since they scheduled their update have nothing to do.
+        // Drop them now rather than wasting a chunk on them
+        FastArray<ParticleSystem *>::iterator itor = mPendingParticleSystemUpdates.begin();
+        FastArray<ParticleSystem *>::iterator endt = mPendingParticleSystemUpdates.end();
+        FastArray<ParticleSystem *>::iterator dstItor = itor;
+
+        while( itor != endt )
+        {
+            if( ( *itor )->_prepareThreadedUpdate() )
+                *dstItor++ = *itor;
+            ++itor;
+        }
+        mPendingParticleSystemUpdates.resizePOD( static_cast<size_t>(
+            dstItor - mPendingParticleSystemUpdates.begin() ) );
+        endt = mPendingParticleSystemUpdates.end();
+
+        if( mNumWorkerThreads > 1u && mPendingParticleSystemUpdates.size() > 1u )
+        {
+            // Systems vary wildly in cost, hence one chunk per system plus work stealing
+            mWorkStealingScheduler.reset( mPendingParticleSystemUpdates.size() );
+            ParticleSystemUpdateTask task( mPendingParticleSystemUpdates, mWorkStealingScheduler );
+            executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            itor = mPendingParticleSystemUpdates.begin();
+            while( itor != endt )
+                ( *itor++ )->_executePendingUpdate();
+        }
+
+        mPendingParticleSystemUpdates.clear();
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::clearScene( bool deleteIndestructibleToo, bool reattachCameras )
     {
         destroyAllMovableObjects();
@@ -1705,7 +1792,7 @@ namespace Ogre
                     itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx + 1];
                 while( itor != endt )
                 {
-                    ( *itor )->update();
+                    ( *itor )->_updateThrottled( ( *it )->frameIdx );
                     ++itor;
                 }
 
@@ -1774,21 +1861,34 @@ namespace Ogre
     {
         mRequestType = UPDATE_ALL_ANIMATIONS;
         fireWorkerThreadsAndWait();
+
+        SkeletonAnimManagerVec::const_iterator it = mSkeletonAnimManagerCulledList.begin();
+        SkeletonAnimManagerVec::const_iterator en = mSkeletonAnimManagerCulledList.end();
+
+        while( it != en )
+        {
+            ++( *it )->frameIdx;
+            ++it;
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransformsThread( const UpdateTransformRequest &request,
                                                   size_t threadIdx )
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
+        {
+            Transform t( request.t );
+            const size_t toAdvance = chunkIdx * request.numNodesPerChunk;
 
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            // Prevent going out of bounds (usually in the last chunk, or
+            // when there are less nodes than ARRAY_PACKED_REALS
+            const size_t numNodes =
+                std::min( request.numNodesPerChunk, request.numTotalNodes - toAdvance );
+            t.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
-        Node::updateAllTransforms( numNodes, t );
+            Node::updateAllTransforms( numNodes, t );
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransforms()
@@ -1812,16 +1912,15 @@ namespace Ogre
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
                 if( numNodes )
                 {
+                    // nodesPerChunk is multiple of ARRAY_PACKED_REALS
+                    const size_t nodesPerChunk = calculateObjectsPerChunk( numNodes );
+
                     // Send them to worker threads. We need to go depth by depth because
                     // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
+                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerChunk, numNodes );
+                    mWorkStealingScheduler.reset( ( numNodes + nodesPerChunk - 1u ) / nodesPerChunk );
                     fireWorkerThreadsAndWait();
                     // Node::updateAllTransforms( numNodes, t );
                 }
@@ -1860,16 +1959,15 @@ namespace Ogre
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
                 if( numNodes )
                 {
+                    // nodesPerChunk is multiple of ARRAY_PACKED_REALS
+                    const size_t nodesPerChunk = calculateObjectsPerChunk( numNodes );
+
                     // Send them to worker threads. We need to go depth by depth because
                     // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
+                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerChunk, numNodes );
+                    mWorkStealingScheduler.reset( ( numNodes + nodesPerChunk - 1u ) / nodesPerChunk );
                     fireWorkerThreadsAndWait();
                 }
             }
@@ -1881,35 +1979,57 @@ namespace Ogre
     void SceneManager::updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
                                                            size_t threadIdx )
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
+        {
+            Transform t( request.t );
+            const size_t toAdvance = chunkIdx * request.numNodesPerChunk;
 
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            // Prevent going out of bounds (usually in the last chunk, or
+            // when there are less nodes than ARRAY_PACKED_REALS
+            const size_t numNodes =
+                std::min( request.numNodesPerChunk, request.numTotalNodes - toAdvance );
+            t.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
-        TagPoint::updateAllTransformsBoneToTag( numNodes, t );
+            TagPoint::updateAllTransformsBoneToTag( numNodes, t );
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
                                                           size_t threadIdx )
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
+        {
+            Transform t( request.t );
+            const size_t toAdvance = chunkIdx * request.numNodesPerChunk;
+
+            // Prevent going out of bounds (usually in the last chunk, or
+            // when there are less nodes than ARRAY_PACKED_REALS
+            const size_t numNodes =
+                std::min( request.numNodesPerChunk, request.numTotalNodes - toAdvance );
+            t.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            TagPoint::updateAllTransformsTagOnTag( numNodes, t );
+        }
+    }
+    //-----------------------------------------------------------------------
+    size_t SceneManager::calculateObjectsPerChunk( size_t totalObjs ) const
+    {
+        // Aim for a few chunks per thread, so that there is something left to steal
+        // by threads that finish early. Unless there is only one thread.
+        const size_t numChunksPerThread = mNumWorkerThreads > 1u ? 4u : 1u;
+        const size_t numChunks = mNumWorkerThreads * numChunksPerThread;
 
-        TagPoint::updateAllTransformsTagOnTag( numNodes, t );
+        size_t objsPerChunk = ( totalObjs + numChunks - 1u ) / numChunks;
+        objsPerChunk = std::max( objsPerChunk, mMinObjectsPerChunk );
+        objsPerChunk =
+            ( ( objsPerChunk + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+        return std::max<size_t>( objsPerChunk, ARRAY_PACKED_REALS );
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager,
-                                              size_t threadIdx )
+    void SceneManager::addObjectDataChunks( const ObjectMemoryManagerVec &objectMemManager,
+                                            size_t firstRq, size_t lastRq )
     {
         ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
         ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
@@ -1919,90 +2039,96 @@ namespace Ogre
             ObjectMemoryManager *memoryManager = *it;
             const size_t numRenderQueues = memoryManager->getNumRenderQueues();
 
-            for( size_t i = 0; i < numRenderQueues; ++i )
+            const size_t realFirstRq = std::min( firstRq, numRenderQueues );
+            const size_t realLastRq = std::min( lastRq, numRenderQueues );
+
+            for( size_t i = realFirstRq; i < realLastRq; ++i )
             {
                 ObjectData objData;
                 const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
-
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-                MovableObject::updateAllBounds( numObjs, objData );
+                if( totalObjs )
+                {
+                    const size_t objsPerChunk = calculateObjectsPerChunk( totalObjs );
+                    for( size_t firstObj = 0u; firstObj < totalObjs; firstObj += objsPerChunk )
+                    {
+                        mObjectDataChunks.push_back(
+                            ObjectDataChunk( memoryManager, i, firstObj,
+                                             std::min( objsPerChunk, totalObjs - firstObj ) ) );
+                    }
+                }
             }
 
             ++it;
         }
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllBounds( const ObjectMemoryManagerVec &objectMemManager )
+    void SceneManager::fireObjectDataChunks( RequestType requestType )
     {
-        mUpdateBoundsRequest = &objectMemManager;
-        mRequestType = UPDATE_ALL_BOUNDS;
+        mRequestType = requestType;
+        mWorkStealingScheduler.reset( mObjectDataChunks.size() );
         fireWorkerThreadsAndWait();
     }
     //-----------------------------------------------------------------------
+    void SceneManager::setMinObjectsPerChunk( size_t minObjectsPerChunk )
+    {
+        minObjectsPerChunk = std::max<size_t>( minObjectsPerChunk, 1u );
+        mMinObjectsPerChunk =
+            ( ( minObjectsPerChunk + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateAllBoundsThread( size_t threadIdx )
+    {
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
+        {
+            const ObjectDataChunk &chunk = mObjectDataChunks[chunkIdx];
+
+            ObjectData objData;
+            chunk.memoryManager->getFirstObjectData( objData, chunk.renderQueue );
+            objData.advancePack( chunk.firstObj / ARRAY_PACKED_REALS );
+
+            MovableObject::updateAllBounds( chunk.numObjs, objData );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateAllBounds( const ObjectMemoryManagerVec &objectMemManager )
+    {
+        mObjectDataChunks.clear();
+        addObjectDataChunks( objectMemManager, 0u, std::numeric_limits<size_t>::max() );
+        fireObjectDataChunks( UPDATE_ALL_BOUNDS );
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx )
     {
         LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
 
         const Camera *lodCamera = request.lodCamera;
-        ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
-        ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
 
-        while( it != en )
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
         {
-            ObjectMemoryManager *memoryManager = *it;
-            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
-
-            size_t firstRq = std::min<size_t>( request.firstRq, numRenderQueues );
-            size_t lastRq = std::min<size_t>( request.lastRq, numRenderQueues );
-
-            for( size_t i = firstRq; i < lastRq; ++i )
-            {
-                ObjectData objData;
-                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+            const ObjectDataChunk &chunk = mObjectDataChunks[chunkIdx];
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-                lodStrategy->lodUpdateImpl( numObjs, objData, lodCamera, request.lodBias );
-            }
+            ObjectData objData;
+            chunk.memoryManager->getFirstObjectData( objData, chunk.renderQueue );
+            objData.advancePack( chunk.firstObj / ARRAY_PACKED_REALS );
 
-            ++it;
+            lodStrategy->lodUpdateImpl( chunk.numObjs, objData, lodCamera, request.lodBias );
         }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllLods( const Camera *lodCamera, Real lodBias, uint8 firstRq,
                                       uint8 lastRq )
     {
-        mRequestType = UPDATE_ALL_LODS;
         mUpdateLodRequest = UpdateLodRequest( firstRq, lastRq, &mEntitiesMemoryManagerCulledList,
                                               lodCamera, lodCamera, lodBias );
 
         mUpdateLodRequest.camera->getFrustumPlanes();
         mUpdateLodRequest.lodCamera->getFrustumPlanes();
 
-        fireWorkerThreadsAndWait();
+        mObjectDataChunks.clear();
+        addObjectDataChunks( mEntitiesMemoryManagerCulledList, firstRq, lastRq );
+        fireObjectDataChunks( UPDATE_ALL_LODS );
     }
     //-----------------------------------------------------------------------
     void SceneManager::cullFrustum( const CullFrustumRequest &request, size_t threadIdx )
@@ -2030,73 +2156,50 @@ namespace Ogre
                     ( camera->getLastViewport()->getVisibilityMask() &
                       ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) );
 
-        ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
-        ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
-
-        while( it != en )
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
         {
-            ObjectMemoryManager *memoryManager = *it;
-            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+            const ObjectDataChunk &chunk = mObjectDataChunks[chunkIdx];
 
-            size_t firstRq = std::min<size_t>( request.firstRq, numRenderQueues );
-            size_t lastRq = std::min<size_t>( request.lastRq, numRenderQueues );
+            MovableObject::MovableObjectArray &outVisibleObjects =
+                *( visibleObjectsPerRq.begin() + chunk.renderQueue );
 
-            for( size_t i = firstRq; i < lastRq; ++i )
-            {
-                MovableObject::MovableObjectArray &outVisibleObjects =
-                    *( visibleObjectsPerRq.begin() + i );
+            ObjectData objData;
+            chunk.memoryManager->getFirstObjectData( objData, chunk.renderQueue );
+            objData.advancePack( chunk.firstObj / ARRAY_PACKED_REALS );
 
-                ObjectData objData;
-                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
-
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            MovableObject::cullFrustum( chunk.numObjs, objData, camera, visibilityMask,
+                                        outVisibleObjects, lodCamera );
 
-                MovableObject::cullFrustum( numObjs, objData, camera, visibilityMask, outVisibleObjects,
-                                            lodCamera );
+            const uint8 currRqId = static_cast<uint8>( chunk.renderQueue );
 
-                const uint8 currRqId = static_cast<uint8>( i );
+            if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
+                request.addToRenderQueue )
+            {
+                // V2 meshes can be added to the render queue in parallel
+                bool casterPass = request.casterPass;
+                MovableObject::MovableObjectArray::const_iterator itor = outVisibleObjects.begin();
+                MovableObject::MovableObjectArray::const_iterator endt = outVisibleObjects.end();
 
-                if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
-                    request.addToRenderQueue )
+                while( itor != endt )
                 {
-                    // V2 meshes can be added to the render queue in parallel
-                    bool casterPass = request.casterPass;
-                    MovableObject::MovableObjectArray::const_iterator itor = outVisibleObjects.begin();
-                    MovableObject::MovableObjectArray::const_iterator endt = outVisibleObjects.end();
+                    RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
+                    RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
 
-                    while( itor != endt )
+                    while( itRend != enRend )
                     {
-                        RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
-                        RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
-
-                        while( itRend != enRend )
+                        if( ( *itRend )->mRenderableVisible )
                         {
-                            if( ( *itRend )->mRenderableVisible )
-                            {
-                                mRenderQueue->addRenderableV2( threadIdx, currRqId, casterPass, *itRend,
-                                                               *itor );
-                            }
-                            ++itRend;
+                            mRenderQueue->addRenderableV2( threadIdx, currRqId, casterPass, *itRend,
+                                                           *itor );
                         }
-                        ++itor;
+                        ++itRend;
                     }
-
-                    outVisibleObjects.clear();
+                    ++itor;
                 }
-            }
 
-            ++it;
+                outVisibleObjects.clear();
+            }
         }
     }
     //-----------------------------------------------------------------------
@@ -2315,14 +2418,10 @@ namespace Ogre
         if( mBuildLegacyLightList )
         {
             // Now fire the threads again, to build the per-MovableObject lists
-            mRequestType = BUILD_LIGHT_LIST02;
-            if( mForceMainThread )
-                updateWorkerThreadImpl( 0 );
-            else
-            {
-                mWorkerThreadsBarrier->sync();  // Fire threads
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
-            }
+            mObjectDataChunks.clear();
+            addObjectDataChunks( mEntitiesMemoryManagerCulledList, 0u,
+                                 std::numeric_limits<size_t>::max() );
+            fireObjectDataChunks( BUILD_LIGHT_LIST02 );
         }
     }
     //-----------------------------------------------------------------------
@@ -2382,35 +2481,16 @@ namespace Ogre
     void SceneManager::buildLightListThread02( size_t threadIdx )
     {
         // Global light list built. Now build a per-movable object light list
-        ObjectMemoryManagerVec::const_iterator it = mEntitiesMemoryManagerCulledList.begin();
-        ObjectMemoryManagerVec::const_iterator en = mEntitiesMemoryManagerCulledList.end();
-        while( it != en )
+        size_t chunkIdx;
+        while( mWorkStealingScheduler.getNextChunk( threadIdx, chunkIdx ) )
         {
-            ObjectMemoryManager *objMemoryManager = *it;
-            const size_t numRenderQueues = objMemoryManager->getNumRenderQueues();
+            const ObjectDataChunk &chunk = mObjectDataChunks[chunkIdx];
 
-            for( size_t i = 0; i < numRenderQueues; ++i )
-            {
-                ObjectData objData;
-                const size_t totalObjs = objMemoryManager->getFirstObjectData( objData, i );
+            ObjectData objData;
+            chunk.memoryManager->getFirstObjectData( objData, chunk.renderQueue );
+            objData.advancePack( chunk.firstObj / ARRAY_PACKED_REALS );
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-                MovableObject::buildLightList( numObjs, objData, mGlobalLightList );
-            }
-
-            ++it;
+            MovableObject::buildLightList( chunk.numObjs, objData, mGlobalLightList );
         }
     }
     //-----------------------------------------------------------------------
@@ -2579,14 +2659,23 @@ namespace Ogre
 
         // Update controllers
         ControllerManager::getSingleton().updateAllControllers();
+        updateAllParticleSystems();
 
         highLevelCull();
         _applySceneAnimations();
         updateAllTransforms();
         updateAllAnimations();
         updateAllTagPoints();
-        updateAllBounds( mEntitiesMemoryManagerUpdateList );
-        updateAllBounds( mLightsMemoryManagerCulledList );
+        {
+            // Entities' and lights' bounds don't depend on each other.
+            // Update them in the same batch to save one sync point.
+            mObjectDataChunks.clear();
+            addObjectDataChunks( mEntitiesMemoryManagerUpdateList, 0u,
+                                 std::numeric_limits<size_t>::max() );
+            addObjectDataChunks( mLightsMemoryManagerCulledList, 0u,
+                                 std::numeric_limits<size_t>::max() );
+            fireObjectDataChunks( UPDATE_ALL_BOUNDS );
+        }
 
         {
             // Auto-track nodes
@@ -2626,6 +2715,9 @@ namespace Ogre
             }
         }
 
+        if( mSceneQueryBvh )
+            mSceneQueryBvh->update( mStaticEntitiesDirty );
+
         buildLightList();
 
         // Reset the list of render RQs for all cameras that are in a PASS_SCENE (except shadow passes)
@@ -3971,6 +4063,20 @@ namespace Ogre
         return q;
     }
     //---------------------------------------------------------------------
+    void SceneManager::setSceneQueryBvhEnabled( bool bEnabled )
+    {
+        if( bEnabled && !mSceneQueryBvh )
+        {
+            mSceneQueryBvh = OGRE_NEW SceneQueryBvh( this );
+            mSceneQueryBvh->update( true );
+        }
+        else if( !bEnabled && mSceneQueryBvh )
+        {
+            OGRE_DELETE mSceneQueryBvh;
+            mSceneQueryBvh = 0;
+        }
+    }
+    //---------------------------------------------------------------------
     IntersectionSceneQuery *SceneManager::createIntersectionQuery( uint32 mask )
     {
         DefaultIntersectionSceneQuery *q = OGRE_NEW DefaultIntersectionSceneQuery( this );
@@ -4456,13 +4562,15 @@ namespace Ogre
     void SceneManager::fireCullFrustumThreads( const CullFrustumRequest &request )
     {
         mCurrentCullFrustumRequest = request;
-        mRequestType = CULL_FRUSTUM;
         // This is where I figuratively kill whoever made mutable variables inside a
         // const function, silencing a race condition: Update the frustum planes now
         // in case they weren't up to date.
         mCurrentCullFrustumRequest.camera->getFrustumPlanes();
         mCurrentCullFrustumRequest.lodCamera->getFrustumPlanes();
-        fireWorkerThreadsAndWait();
+
+        mObjectDataChunks.clear();
+        addObjectDataChunks( *request.objectMemManager, request.firstRq, request.lastRq );
+        fireObjectDataChunks( CULL_FRUSTUM );
     }
     //---------------------------------------------------------------------
     void SceneManager::executeUserScalableTask( UniformScalableTask *task, bool bBlock )
@@ -4560,7 +4668,7 @@ namespace Ogre
             updateAllTransformsTagOnTagThread( mUpdateTransformRequest, threadIdx );
             break;
         case UPDATE_ALL_BOUNDS:
-            updateAllBoundsThread( *mUpdateBoundsRequest, threadIdx );
+            updateAllBoundsThread( threadIdx );
             break;
         case UPDATE_ALL_LODS:
             updateAllLodsThread( mUpdateLodRequest, threadIdx );
@@ -187,6 +187,48 @@ namespace Ogre
         return mResult;
     }
     //-----------------------------------------------------------------------
+    /// Keeps the nearest movable object. Used by the generic executeBatch
+    class NearestRaySceneQueryListener final : public RaySceneQueryListener
+    {
+    public:
+        RaySceneQueryBatchResult result;
+
+        NearestRaySceneQueryListener()
+        {
+            result.movable = 0;
+            result.distance = std::numeric_limits<Real>::max();
+        }
+
+        bool queryResult( MovableObject *obj, Real distance ) override
+        {
+            if( distance < result.distance )
+            {
+                result.movable = obj;
+                result.distance = distance;
+            }
+            return true;
+        }
+
+        bool queryResult( SceneQuery::WorldFragment *, Real ) override { return true; }
+    };
+    //-----------------------------------------------------------------------
+    void RaySceneQuery::executeBatch( const Ray *rays, size_t numRays,
+                                      RaySceneQueryBatchResult *outResults,
+                                      bool /*bUseWorkerThreads*/ )
+    {
+        const Ray oldRay = mRay;
+
+        for( size_t i = 0u; i < numRays; ++i )
+        {
+            NearestRaySceneQueryListener listener;
+            setRay( rays[i] );
+            execute( &listener );
+            outResults[i] = listener.result;
+        }
+
+        setRay( oldRay );
+    }
+    //-----------------------------------------------------------------------
     RaySceneQueryResult &RaySceneQuery::getLastResults() { return mResult; }
     //-----------------------------------------------------------------------
     void RaySceneQuery::clearResults()
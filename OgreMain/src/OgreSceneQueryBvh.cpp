@@ -0,0 +1,640 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreSceneQueryBvh.h"
+
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "OgreMovableObject.h"
+#include "OgreProfiler.h"
+#include "OgreRay.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneQuery.h"
+#include "OgreSphere.h"
+
+namespace Ogre
+{
+    /// Max depth is bounded by the median split; 64 levels is more than enough.
+    static const size_t c_maxBvhStackSize = 64u;
+
+    static inline Real surfaceArea( const SceneQueryBvh::Node &node )
+    {
+        const Real dx = node.aabbMax[0] - node.aabbMin[0];
+        const Real dy = node.aabbMax[1] - node.aabbMin[1];
+        const Real dz = node.aabbMax[2] - node.aabbMin[2];
+        // Infinite and null boxes would poison the sum
+        if( !( dx >= Real( 0 ) ) || !( dy >= Real( 0 ) ) || !( dz >= Real( 0 ) ) ||
+            dx == std::numeric_limits<Real>::infinity() ||
+            dy == std::numeric_limits<Real>::infinity() ||
+            dz == std::numeric_limits<Real>::infinity() )
+        {
+            return Real( 0 );
+        }
+        return Real( 2 ) * ( dx * dy + dy * dz + dz * dx );
+    }
+    //-------------------------------------------------------------------------
+    /// Slab test. Returns the distance to the entry point (0 if origin is inside)
+    static inline bool intersectsRay( const float aabbMin[3], const float aabbMax[3],
+                                      const Vector3 &origin, const Vector3 &invDir,
+                                      Real &outDistance )
+    {
+        Real tNear = -std::numeric_limits<Real>::infinity();
+        Real tFar = std::numeric_limits<Real>::infinity();
+
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            Real t0 = ( aabbMin[i] - origin[i] ) * invDir[i];
+            Real t1 = ( aabbMax[i] - origin[i] ) * invDir[i];
+            if( t0 > t1 )
+                std::swap( t0, t1 );
+            // Written so that NaNs (0 * inf) leave tNear & tFar untouched
+            tNear = t0 > tNear ? t0 : tNear;
+            tFar = t1 < tFar ? t1 : tFar;
+        }
+
+        outDistance = std::max( tNear, Real( 0 ) );
+        // A ray parallel to a slab it's outside of results in tNear = tFar = inf
+        return tNear <= tFar && tFar >= Real( 0 ) &&
+               tNear < std::numeric_limits<Real>::infinity();
+    }
+    //-------------------------------------------------------------------------
+    static inline bool intersectsSphere( const float aabbMin[3], const float aabbMax[3],
+                                         const Sphere &sphere )
+    {
+        const Vector3 &center = sphere.getCenter();
+        Real sqDist = 0;
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            const Real v = center[i];
+            if( v < aabbMin[i] )
+                sqDist += ( aabbMin[i] - v ) * ( aabbMin[i] - v );
+            else if( v > aabbMax[i] )
+                sqDist += ( v - aabbMax[i] ) * ( v - aabbMax[i] );
+        }
+        return sqDist <= sphere.getRadius() * sphere.getRadius();
+    }
+    //-------------------------------------------------------------------------
+    static inline bool intersectsAabb( const float aabbMin[3], const float aabbMax[3],
+                                       const Vector3 &otherMin, const Vector3 &otherMax )
+    {
+        return aabbMin[0] <= otherMax.x && aabbMax[0] >= otherMin.x &&  //
+               aabbMin[1] <= otherMax.y && aabbMax[1] >= otherMin.y &&  //
+               aabbMin[2] <= otherMax.z && aabbMax[2] >= otherMin.z;
+    }
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    SceneQueryBvh::SceneQueryBvh( SceneManager *sceneManager ) :
+        mSceneManager( sceneManager ),
+        mBuilt( false ),
+        mBuildCost( 0 ),
+        mCurrentCost( 0 ),
+        mRebuildThreshold( 2.0f ),
+        mMaxObjectsPerLeaf( 4u )
+    {
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+            mStructureRevisions[i] = 0u;
+    }
+    //-------------------------------------------------------------------------
+    SceneQueryBvh::~SceneQueryBvh() {}
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::calculateNodeBounds( size_t nodeIdx )
+    {
+        Node &node = mNodes[nodeIdx];
+
+        Vector3 vMin( std::numeric_limits<Real>::infinity() );
+        Vector3 vMax( -std::numeric_limits<Real>::infinity() );
+
+        if( node.numObjects )
+        {
+            ObjectEntryArray::const_iterator itor = mObjects.begin() + node.firstChildOrObject;
+            ObjectEntryArray::const_iterator endt = itor + node.numObjects;
+
+            while( itor != endt )
+            {
+                // Node bounds must also enclose the bounding sphere, since
+                // sphere queries test against it instead of the AABB.
+                const Vector3 radius( itor->worldRadius );
+                vMin.makeFloor( itor->worldAabb.getMinimum() );
+                vMax.makeCeil( itor->worldAabb.getMaximum() );
+                vMin.makeFloor( itor->worldAabb.mCenter - radius );
+                vMax.makeCeil( itor->worldAabb.mCenter + radius );
+                ++itor;
+            }
+        }
+        else
+        {
+            for( size_t i = 0; i < 2u; ++i )
+            {
+                const Node &child = mNodes[node.firstChildOrObject + i];
+                vMin.makeFloor( Vector3( child.aabbMin[0], child.aabbMin[1], child.aabbMin[2] ) );
+                vMax.makeCeil( Vector3( child.aabbMax[0], child.aabbMax[1], child.aabbMax[2] ) );
+            }
+        }
+
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            node.aabbMin[i] = static_cast<float>( vMin[i] );
+            node.aabbMax[i] = static_cast<float>( vMax[i] );
+        }
+    }
+    //-------------------------------------------------------------------------
+    struct CentroidAxisLess
+    {
+        size_t axis;
+        CentroidAxisLess( size_t _axis ) : axis( _axis ) {}
+        bool operator()( const SceneQueryBvh::ObjectEntry &a, const SceneQueryBvh::ObjectEntry &b ) const
+        {
+            return a.worldAabb.mCenter[axis] < b.worldAabb.mCenter[axis];
+        }
+    };
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::buildNode( size_t nodeIdx, size_t firstObj, size_t numObjs )
+    {
+        if( numObjs <= mMaxObjectsPerLeaf )
+        {
+            mNodes[nodeIdx].firstChildOrObject = static_cast<uint32>( firstObj );
+            mNodes[nodeIdx].numObjects = static_cast<uint32>( numObjs );
+            for( size_t i = firstObj; i < firstObj + numObjs; ++i )
+                mObjectLeaves[i] = static_cast<uint32>( nodeIdx );
+            calculateNodeBounds( nodeIdx );
+            return;
+        }
+
+        // Split at the median of the axis where the centroids are most spread out
+        Vector3 centroidMin( std::numeric_limits<Real>::max() );
+        Vector3 centroidMax( -std::numeric_limits<Real>::max() );
+        for( size_t i = firstObj; i < firstObj + numObjs; ++i )
+        {
+            centroidMin.makeFloor( mObjects[i].worldAabb.mCenter );
+            centroidMax.makeCeil( mObjects[i].worldAabb.mCenter );
+        }
+
+        const Vector3 spread = centroidMax - centroidMin;
+        size_t axis = 0u;
+        if( spread.y > spread[axis] )
+            axis = 1u;
+        if( spread.z > spread[axis] )
+            axis = 2u;
+
+        const size_t numLeft = numObjs >> 1u;
+        std::nth_element( mObjects.begin() + firstObj, mObjects.begin() + firstObj + numLeft,
+                          mObjects.begin() + firstObj + numObjs, CentroidAxisLess( axis ) );
+
+        const size_t firstChild = mNodes.size();
+        mNodes.resize( firstChild + 2u );
+        mNodeParents.push_back( static_cast<uint32>( nodeIdx ) );
+        mNodeParents.push_back( static_cast<uint32>( nodeIdx ) );
+        mNodes[nodeIdx].firstChildOrObject = static_cast<uint32>( firstChild );
+        mNodes[nodeIdx].numObjects = 0u;
+
+        buildNode( firstChild, firstObj, numLeft );
+        buildNode( firstChild + 1u, firstObj + numLeft, numObjs - numLeft );
+
+        calculateNodeBounds( nodeIdx );
+    }
+    //-------------------------------------------------------------------------
+    Real SceneQueryBvh::calculateCost() const
+    {
+        Real cost = 0;
+        NodeArray::const_iterator itor = mNodes.begin();
+        NodeArray::const_iterator endt = mNodes.end();
+        while( itor != endt )
+            cost += surfaceArea( *itor++ );
+        return cost;
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::build()
+    {
+        OgreProfileExhaustive( "SceneQueryBvh::build" );
+
+        mObjects.clear();
+        mNodes.clear();
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            ObjectMemoryManager &memoryManager =
+                mSceneManager->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+            mStructureRevisions[i] = memoryManager.getStructureRevision();
+
+            const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+            for( size_t j = 0; j < numRenderQueues; ++j )
+            {
+                ObjectData objData;
+                const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
+
+                for( size_t k = 0; k < totalObjs; k += ARRAY_PACKED_REALS )
+                {
+                    for( size_t l = 0; l < ARRAY_PACKED_REALS; ++l )
+                    {
+                        // Empty slots point to a dummy object without manager
+                        MovableObject *movableObject = objData.mOwner[l];
+                        if( movableObject && movableObject->_getManager() )
+                        {
+                            ObjectEntry entry;
+                            entry.movableObject = movableObject;
+                            entry.worldAabb = movableObject->getWorldAabb();
+                            entry.worldRadius = movableObject->getWorldRadius();
+                            mObjects.push_back( entry );
+                        }
+                    }
+                    objData.advancePack();
+                }
+            }
+        }
+
+        mNodeParents.clear();
+        mObjectLeaves.resizePOD( mObjects.size() );
+
+        if( !mObjects.empty() )
+        {
+            mNodes.reserve( mObjects.size() );
+            mNodeParents.reserve( mObjects.size() );
+            mNodes.resize( 1u );
+            mNodeParents.push_back( 0u );
+            buildNode( 0u, 0u, mObjects.size() );
+        }
+
+        // buildNode reorders mObjects, thus look for the dynamic ones afterwards
+        mDynamicObjects.clear();
+        for( size_t i = 0; i < mObjects.size(); ++i )
+        {
+            if( !mObjects[i].movableObject->isStatic() )
+                mDynamicObjects.push_back( static_cast<uint32>( i ) );
+        }
+
+        mDirtyNodes.clear();
+        mNodeDirtyFlags.clear();
+        mNodeDirtyFlags.resize( mNodes.size(), 0u );
+
+        mBuildCost = calculateCost();
+        mCurrentCost = mBuildCost;
+        mBuilt = true;
+    }
+    //-------------------------------------------------------------------------
+    inline void SceneQueryBvh::refitObject( size_t objIdx )
+    {
+        ObjectEntry &entry = mObjects[objIdx];
+
+        const Aabb worldAabb = entry.movableObject->getWorldAabb();
+        const Real worldRadius = entry.movableObject->getWorldRadius();
+        if( worldAabb == entry.worldAabb && worldRadius == entry.worldRadius )
+            return;
+
+        entry.worldAabb = worldAabb;
+        entry.worldRadius = worldRadius;
+
+        // Flag the leaf and walk up until we find a node that was already flagged
+        uint32 nodeIdx = mObjectLeaves[objIdx];
+        while( !mNodeDirtyFlags[nodeIdx] )
+        {
+            mNodeDirtyFlags[nodeIdx] = 1u;
+            mDirtyNodes.push_back( nodeIdx );
+            if( nodeIdx == 0u )
+                break;
+            nodeIdx = mNodeParents[nodeIdx];
+        }
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::refit( bool staticObjectsDirty )
+    {
+        OgreProfileExhaustive( "SceneQueryBvh::refit" );
+
+        if( staticObjectsDirty )
+        {
+            const size_t numObjects = mObjects.size();
+            for( size_t i = 0; i < numObjects; ++i )
+                refitObject( i );
+        }
+        else
+        {
+            FastArray<uint32>::const_iterator itor = mDynamicObjects.begin();
+            FastArray<uint32>::const_iterator endt = mDynamicObjects.end();
+            while( itor != endt )
+                refitObject( *itor++ );
+        }
+
+        if( mDirtyNodes.empty() )
+            return false;
+
+        // Children are always stored after their parents, thus going
+        // from the highest index to the lowest updates children first
+        std::sort( mDirtyNodes.begin(), mDirtyNodes.end(), std::greater<uint32>() );
+
+        FastArray<uint32>::const_iterator itor = mDirtyNodes.begin();
+        FastArray<uint32>::const_iterator endt = mDirtyNodes.end();
+
+        while( itor != endt )
+        {
+            const uint32 nodeIdx = *itor++;
+            mCurrentCost -= surfaceArea( mNodes[nodeIdx] );
+            calculateNodeBounds( nodeIdx );
+            mCurrentCost += surfaceArea( mNodes[nodeIdx] );
+            mNodeDirtyFlags[nodeIdx] = 0u;
+        }
+
+        mDirtyNodes.clear();
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::update( bool staticObjectsDirty )
+    {
+        if( !isUpToDate() )
+        {
+            build();
+        }
+        else if( refit( staticObjectsDirty ) && mCurrentCost > mBuildCost * mRebuildThreshold )
+        {
+            build();
+        }
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::isUpToDate() const
+    {
+        if( !mBuilt )
+            return false;
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            const ObjectMemoryManager &memoryManager =
+                mSceneManager->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+            if( memoryManager.getStructureRevision() != mStructureRevisions[i] )
+                return false;
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::setRebuildThreshold( Real threshold )
+    {
+        OGRE_ASSERT_LOW( threshold >= Real( 1 ) );
+        mRebuildThreshold = threshold;
+    }
+    //-------------------------------------------------------------------------
+    inline bool SceneQueryBvh::isObjectAccepted( const MovableObject *movableObject,
+                                                 uint32 queryMask, uint8 firstRq,
+                                                 uint8 lastRq ) const
+    {
+        const uint8 rqId = movableObject->getRenderQueueGroup();
+        return movableObject->getVisible() && ( movableObject->getQueryFlags() & queryMask ) &&
+               rqId >= firstRq && rqId < lastRq;
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::rayQuery( const Ray &ray, uint32 queryMask, uint8 firstRq, uint8 lastRq,
+                                  RaySceneQueryListener *listener ) const
+    {
+        if( mNodes.empty() )
+            return true;
+
+        const Vector3 &origin = ray.getOrigin();
+        const Vector3 &dir = ray.getDirection();
+        const Vector3 invDir( Real( 1 ) / dir.x, Real( 1 ) / dir.y, Real( 1 ) / dir.z );
+
+        uint32 stack[c_maxBvhStackSize];
+        size_t stackSize = 0u;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = mNodes[stack[--stackSize]];
+
+            Real distance;
+            if( !intersectsRay( node.aabbMin, node.aabbMax, origin, invDir, distance ) )
+                continue;
+
+            if( !node.numObjects )
+            {
+                OGRE_ASSERT_MEDIUM( stackSize + 2u <= c_maxBvhStackSize );
+                stack[stackSize++] = node.firstChildOrObject + 1u;
+                stack[stackSize++] = node.firstChildOrObject;
+                continue;
+            }
+
+            for( size_t i = node.firstChildOrObject; i < node.firstChildOrObject + node.numObjects;
+                 ++i )
+            {
+                const ObjectEntry &entry = mObjects[i];
+                if( !isObjectAccepted( entry.movableObject, queryMask, firstRq, lastRq ) )
+                    continue;
+
+                float aabbMin[3], aabbMax[3];
+                const Vector3 vMin = entry.worldAabb.getMinimum();
+                const Vector3 vMax = entry.worldAabb.getMaximum();
+                for( size_t j = 0; j < 3u; ++j )
+                {
+                    aabbMin[j] = static_cast<float>( vMin[j] );
+                    aabbMax[j] = static_cast<float>( vMax[j] );
+                }
+
+                if( intersectsRay( aabbMin, aabbMax, origin, invDir, distance ) )
+                {
+                    if( !listener->queryResult( entry.movableObject, distance ) )
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::rayQueryNearest( const Ray &ray, uint32 queryMask, uint8 firstRq,
+                                         uint8 lastRq, RaySceneQueryBatchResult &outResult ) const
+    {
+        outResult.movable = 0;
+        outResult.distance = std::numeric_limits<Real>::max();
+
+        if( mNodes.empty() )
+            return;
+
+        const Vector3 &origin = ray.getOrigin();
+        const Vector3 &dir = ray.getDirection();
+        const Vector3 invDir( Real( 1 ) / dir.x, Real( 1 ) / dir.y, Real( 1 ) / dir.z );
+
+        uint32 stack[c_maxBvhStackSize];
+        size_t stackSize = 0u;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = mNodes[stack[--stackSize]];
+
+            Real distance;
+            if( !intersectsRay( node.aabbMin, node.aabbMax, origin, invDir, distance ) ||
+                distance >= outResult.distance )
+            {
+                continue;
+            }
+
+            if( !node.numObjects )
+            {
+                // Visit the nearest child first, so the farthest one is more likely to get culled
+                const uint32 firstChild = node.firstChildOrObject;
+                Real distances[2];
+                const bool hit0 = intersectsRay( mNodes[firstChild].aabbMin, mNodes[firstChild].aabbMax,
+                                                 origin, invDir, distances[0] );
+                const bool hit1 =
+                    intersectsRay( mNodes[firstChild + 1u].aabbMin, mNodes[firstChild + 1u].aabbMax,
+                                   origin, invDir, distances[1] );
+
+                OGRE_ASSERT_MEDIUM( stackSize + 2u <= c_maxBvhStackSize );
+                if( hit0 && hit1 )
+                {
+                    const uint32 nearest = distances[0] <= distances[1] ? 0u : 1u;
+                    stack[stackSize++] = firstChild + ( nearest ^ 1u );
+                    stack[stackSize++] = firstChild + nearest;
+                }
+                else if( hit0 )
+                {
+                    stack[stackSize++] = firstChild;
+                }
+                else if( hit1 )
+                {
+                    stack[stackSize++] = firstChild + 1u;
+                }
+                continue;
+            }
+
+            for( size_t i = node.firstChildOrObject; i < node.firstChildOrObject + node.numObjects;
+                 ++i )
+            {
+                const ObjectEntry &entry = mObjects[i];
+                if( !isObjectAccepted( entry.movableObject, queryMask, firstRq, lastRq ) )
+                    continue;
+
+                float aabbMin[3], aabbMax[3];
+                const Vector3 vMin = entry.worldAabb.getMinimum();
+                const Vector3 vMax = entry.worldAabb.getMaximum();
+                for( size_t j = 0; j < 3u; ++j )
+                {
+                    aabbMin[j] = static_cast<float>( vMin[j] );
+                    aabbMax[j] = static_cast<float>( vMax[j] );
+                }
+
+                if( intersectsRay( aabbMin, aabbMax, origin, invDir, distance ) &&
+                    distance < outResult.distance )
+                {
+                    outResult.movable = entry.movableObject;
+                    outResult.distance = distance;
+                }
+            }
+        }
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::sphereQuery( const Sphere &sphere, uint32 queryMask, uint8 firstRq,
+                                     uint8 lastRq, SceneQueryListener *listener ) const
+    {
+        if( mNodes.empty() )
+            return true;
+
+        uint32 stack[c_maxBvhStackSize];
+        size_t stackSize = 0u;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = mNodes[stack[--stackSize]];
+
+            if( !intersectsSphere( node.aabbMin, node.aabbMax, sphere ) )
+                continue;
+
+            if( !node.numObjects )
+            {
+                OGRE_ASSERT_MEDIUM( stackSize + 2u <= c_maxBvhStackSize );
+                stack[stackSize++] = node.firstChildOrObject + 1u;
+                stack[stackSize++] = node.firstChildOrObject;
+                continue;
+            }
+
+            for( size_t i = node.firstChildOrObject; i < node.firstChildOrObject + node.numObjects;
+                 ++i )
+            {
+                const ObjectEntry &entry = mObjects[i];
+                if( !isObjectAccepted( entry.movableObject, queryMask, firstRq, lastRq ) )
+                    continue;
+
+                // Same test as DefaultSphereSceneQuery: sphere vs sphere
+                const Real radiusSum = sphere.getRadius() + entry.worldRadius;
+                if( sphere.getCenter().squaredDistance( entry.worldAabb.mCenter ) <=
+                    radiusSum * radiusSum )
+                {
+                    if( !listener->queryResult( entry.movableObject ) )
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::aabbQuery( const Aabb &aabb, uint32 queryMask, uint8 firstRq, uint8 lastRq,
+                                   SceneQueryListener *listener ) const
+    {
+        if( mNodes.empty() )
+            return true;
+
+        const Vector3 queryMin = aabb.getMinimum();
+        const Vector3 queryMax = aabb.getMaximum();
+
+        uint32 stack[c_maxBvhStackSize];
+        size_t stackSize = 0u;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = mNodes[stack[--stackSize]];
+
+            if( !intersectsAabb( node.aabbMin, node.aabbMax, queryMin, queryMax ) )
+                continue;
+
+            if( !node.numObjects )
+            {
+                OGRE_ASSERT_MEDIUM( stackSize + 2u <= c_maxBvhStackSize );
+                stack[stackSize++] = node.firstChildOrObject + 1u;
+                stack[stackSize++] = node.firstChildOrObject;
+                continue;
+            }
+
+            for( size_t i = node.firstChildOrObject; i < node.firstChildOrObject + node.numObjects;
+                 ++i )
+            {
+                const ObjectEntry &entry = mObjects[i];
+                if( !isObjectAccepted( entry.movableObject, queryMask, firstRq, lastRq ) )
+                    continue;
+
+                if( aabb.intersects( entry.worldAabb ) )
+                {
+                    if( !listener->queryResult( entry.movableObject ) )
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}  // namespace Ogre
@@ -30,16 +30,53 @@ THE SOFTWARE.
 
 #include "OgreTextureFilters.h"
 
+#include "OgreBlockCompressor.h"
 #include "OgreImage2.h"
 #include "OgrePixelFormatGpuUtils.h"
 #include "OgreProfiler.h"
 #include "OgreTextureBox.h"
 #include "OgreTextureGpuManager.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 namespace Ogre
 {
     namespace TextureFilter
     {
+        /// Don't bother splitting mips smaller than this across threads
+        static const size_t c_minBytesPerCompressTask = 64u * 1024u;
+        static const uint32 c_maxCompressTasks = 32u;
+
+        /// Splits the compression of a single mip level in bands of block rows,
+        /// so that CompressBc can process them in parallel
+        class CompressBcTask final : public UniformScalableTask
+        {
+            TextureBox mSrcBox;
+            PixelFormatGpu mSrcFormat;
+            TextureBox mDstBox;
+            PixelFormatGpu mDstFormat;
+
+        public:
+            CompressBcTask( const TextureBox &srcBox, PixelFormatGpu srcFormat,
+                            const TextureBox &dstBox, PixelFormatGpu dstFormat ) :
+                mSrcBox( srcBox ),
+                mSrcFormat( srcFormat ),
+                mDstBox( dstBox ),
+                mDstFormat( dstFormat )
+            {
+            }
+
+            uint32 getNumUnits() const { return BlockCompressor::getNumBlockRows( mSrcBox.height ); }
+
+            void execute( size_t threadId, size_t numThreads ) override
+            {
+                const size_t numUnits = getNumUnits();
+                const uint32 unitStart = static_cast<uint32>( numUnits * threadId / numThreads );
+                const uint32 unitEnd = static_cast<uint32>( numUnits * ( threadId + 1u ) / numThreads );
+                BlockCompressor::compress( mSrcBox, mSrcFormat, mDstBox, mDstFormat, unitStart,
+                                           unitEnd );
+            }
+        };
+        //-----------------------------------------------------------------------------------
         FilterBase::~FilterBase() {}
         //-----------------------------------------------------------------------------------
         uint8 FilterBase::selectMipmapGen( uint32 filters, const Image2 &image,
@@ -101,11 +138,23 @@ namespace Ogre
                 filtersVec.push_back( OGRE_NEW TextureFilter::PremultiplyAlpha() );
             }
 
+            bool bCompress = false;
+            if( filters & ( TextureFilter::TypeCompressBc | TextureFilter::TypeCompressBc7 ) )
+            {
+                const PixelFormatGpu compressedFormat = CompressBc::getDestinationFormat(
+                    finalPixelFormat, ( filters & TextureFilter::TypeCompressBc7 ) != 0u, image,
+                    texture->getTextureManager() );
+                bCompress = compressedFormat != finalPixelFormat;
+            }
+
             // Add mipmap generation as one of the last steps
             if( filters & TextureFilter::TypeGenerateDefaultMipmaps )
             {
-                const uint8 mipmapGen =
+                uint8 mipmapGen =
                     selectMipmapGen( filters, image, finalPixelFormat, texture->getTextureManager() );
+                // The GPU can't render to BC formats; mipmaps must be generated before compressing
+                if( bCompress && mipmapGen == DefaultMipmapGen::HwMode )
+                    mipmapGen = DefaultMipmapGen::SwMode;
                 // If the user wants Mipmaps when loading OnStorage -> OnSystemRam
                 // then he should either explicitly ask only for SW filters, or
                 // load the texture to Resident first, then download to OnSystemRam.
@@ -115,6 +164,13 @@ namespace Ogre
                     filtersVec.push_back( OGRE_NEW TextureFilter::GenerateSwMipmaps() );
             }
 
+            // Compression must be the very last step
+            if( bCompress )
+            {
+                filtersVec.push_back( OGRE_NEW TextureFilter::CompressBc(
+                    ( filters & TextureFilter::TypeCompressBc7 ) != 0u ) );
+            }
+
             filtersVec.swap( outFilters );
         }
         //-----------------------------------------------------------------------------------
@@ -142,11 +198,21 @@ namespace Ogre
             if( filters & TextureFilter::TypeLeaveChannelR )
                 inOutPixelFormat = LeaveChannelR::getDestinationFormat( inOutPixelFormat );
 
+            PixelFormatGpu compressedFormat = inOutPixelFormat;
+            if( filters & ( TextureFilter::TypeCompressBc | TextureFilter::TypeCompressBc7 ) )
+            {
+                compressedFormat = CompressBc::getDestinationFormat(
+                    inOutPixelFormat, ( filters & TextureFilter::TypeCompressBc7 ) != 0u, image,
+                    textureGpuManager );
+            }
+
             // Add mipmap generation as one of the last steps
             if( filters & TextureFilter::TypeGenerateDefaultMipmaps )
             {
-                const uint8 mipmapGen =
+                uint8 mipmapGen =
                     selectMipmapGen( filters, image, inOutPixelFormat, textureGpuManager );
+                if( compressedFormat != inOutPixelFormat && mipmapGen == DefaultMipmapGen::HwMode )
+                    mipmapGen = DefaultMipmapGen::SwMode;
 
                 const bool canDoMipmaps =
                     ( mipmapGen == DefaultMipmapGen::HwMode &&
@@ -163,6 +229,8 @@ namespace Ogre
                         image.getWidth(), image.getHeight(), image.getDepth() );
                 }
             }
+
+            inOutPixelFormat = compressedFormat;
         }
         //-----------------------------------------------------------------------------------
         uint32 GenerateSwMipmaps::getFilter( const Image2 &image )
@@ -181,7 +249,7 @@ namespace Ogre
             const Image2::Filter filter = static_cast<Image2::Filter>( getFilter( image ) );
 
             const bool isSRgb = PixelFormatGpuUtils::isSRgb( texture->getPixelFormat() );
-            image.generateMipmaps( isSRgb, filter );
+            image.generateMipmaps( isSRgb, filter, texture->getTextureManager() );
             if( texture->getNumMipmaps() != image.getNumMipmaps() )
                 texture->setNumMipmaps( image.getNumMipmaps() );
         }
@@ -493,5 +561,175 @@ namespace Ogre
                 }
             }
         }
+        //-----------------------------------------------------------------------------------
+        bool CompressBc::isOpaque( const Image2 &image )
+        {
+            const PixelFormatGpu format =
+                PixelFormatGpuUtils::getEquivalentLinear( image.getPixelFormat() );
+            if( format != PFG_RGBA8_UNORM && format != PFG_BGRA8_UNORM )
+                return true;
+
+            // Alpha is the 4th byte in both formats
+            const TextureBox box = image.getData( 0 );
+            const uint32 depthOrSlices = box.getDepthOrSlices();
+            for( size_t z = 0; z < depthOrSlices; ++z )
+            {
+                for( size_t y = 0; y < box.height; ++y )
+                {
+                    const uint8 *RESTRICT_ALIAS data =
+                        reinterpret_cast<const uint8 * RESTRICT_ALIAS>( box.at( 0, y, z ) );
+                    uint8 minAlpha = 0xFF;
+                    for( size_t x = 0; x < box.width; ++x )
+                        minAlpha = std::min( minAlpha, data[x * 4u + 3u] );
+                    if( minAlpha != 0xFF )
+                        return false;
+                }
+            }
+
+            return true;
+        }
+        //-----------------------------------------------------------------------------------
+        PixelFormatGpu CompressBc::getDestinationFormat( PixelFormatGpu srcFormat, bool bOpaque,
+                                                         bool bUseBc7 )
+        {
+            PixelFormatGpu dstFormat = srcFormat;
+
+            switch( PixelFormatGpuUtils::getEquivalentLinear( srcFormat ) )
+            {
+            case PFG_RGBA8_UNORM:
+            case PFG_BGRA8_UNORM:
+                dstFormat = bUseBc7 ? PFG_BC7_UNORM : ( bOpaque ? PFG_BC1_UNORM : PFG_BC3_UNORM );
+                break;
+            case PFG_BGRX8_UNORM:
+                dstFormat = bUseBc7 ? PFG_BC7_UNORM : PFG_BC1_UNORM;
+                break;
+            case PFG_R8_UNORM:
+                dstFormat = PFG_BC4_UNORM;
+                break;
+            case PFG_R8_SNORM:
+                dstFormat = PFG_BC4_SNORM;
+                break;
+            case PFG_RG8_UNORM:
+                dstFormat = PFG_BC5_UNORM;
+                break;
+            case PFG_RG8_SNORM:
+                dstFormat = PFG_BC5_SNORM;
+                break;
+            default:
+                // Not supported
+                return srcFormat;
+            }
+
+            if( PixelFormatGpuUtils::isSRgb( srcFormat ) )
+                dstFormat = PixelFormatGpuUtils::getEquivalentSRGB( dstFormat );
+
+            return dstFormat;
+        }
+        //-----------------------------------------------------------------------------------
+        PixelFormatGpu CompressBc::getDestinationFormat( PixelFormatGpu srcFormat, bool bUseBc7,
+                                                         const Image2 &image,
+                                                         const TextureGpuManager *textureManager )
+        {
+            // Cubemaps loaded from multiple files are loaded as 2D images
+            const TextureTypes::TextureTypes textureType = image.getTextureType();
+            if( textureType != TextureTypes::Type2D && textureType != TextureTypes::Type2DArray &&
+                textureType != TextureTypes::TypeCube && textureType != TextureTypes::TypeCubeArray )
+            {
+                return srcFormat;
+            }
+
+            // Not all APIs can create BC textures whose resolution isn't a multiple of the block
+            if( ( image.getWidth() & 0x03u ) || ( image.getHeight() & 0x03u ) )
+                return srcFormat;
+
+            // Only scan for alpha when it makes a difference
+            const PixelFormatGpu linearFormat = PixelFormatGpuUtils::getEquivalentLinear( srcFormat );
+            const bool bOpaque =
+                bUseBc7 || ( linearFormat != PFG_RGBA8_UNORM && linearFormat != PFG_BGRA8_UNORM ) ||
+                isOpaque( image );
+
+            const PixelFormatGpu dstFormat = getDestinationFormat( srcFormat, bOpaque, bUseBc7 );
+            if( dstFormat == srcFormat || !textureManager->checkSupport( dstFormat, textureType, 0u ) )
+                return srcFormat;
+
+            return dstFormat;
+        }
+        //-----------------------------------------------------------------------------------
+        void CompressBc::_executeStreaming( Image2 &image, TextureGpu *texture )
+        {
+            OgreProfileExhaustive( "CompressBc::_executeStreaming" );
+
+            const PixelFormatGpu srcFormat = image.getPixelFormat();
+
+            // If the texture is already a BC format (i.e. set by the metadata cache, or by the
+            // first face of a cubemap loaded from multiple files) we must follow it, otherwise
+            // faces may not agree on whether they have alpha.
+            PixelFormatGpu dstFormat = texture->getPixelFormat();
+            if( BlockCompressor::canCompress( srcFormat, dstFormat ) )
+            {
+                if( PixelFormatGpuUtils::isSRgb( srcFormat ) )
+                    dstFormat = PixelFormatGpuUtils::getEquivalentSRGB( dstFormat );
+                else
+                    dstFormat = PixelFormatGpuUtils::getEquivalentLinear( dstFormat );
+            }
+            else
+            {
+                dstFormat =
+                    getDestinationFormat( srcFormat, mUseBc7, image, texture->getTextureManager() );
+                if( dstFormat == srcFormat )
+                    return;
+            }
+
+            const uint8 numMipmaps = image.getNumMipmaps();
+
+            const uint32 rowAlignment = 4u;
+            const size_t dstSizeBytes =
+                PixelFormatGpuUtils::calculateSizeBytes( image.getWidth(),      //
+                                                         image.getHeight(),     //
+                                                         image.getDepth(),      //
+                                                         image.getNumSlices(),  //
+                                                         dstFormat,             //
+                                                         numMipmaps,            //
+                                                         rowAlignment );
+
+            void *data = OGRE_MALLOC_SIMD( dstSizeBytes, MEMCATEGORY_RESOURCE );
+
+            // Use a temporary Image2 that doesn't own the memory to get the mip boxes
+            Image2 dstImage;
+            dstImage.loadDynamicImage( data, image.getWidth(), image.getHeight(),
+                                       image.getDepthOrSlices(), image.getTextureType(), dstFormat,
+                                       false, numMipmaps );
+
+            TextureGpuManager *textureManager = texture->getTextureManager();
+
+            for( uint8 mip = 0; mip < numMipmaps; ++mip )
+            {
+                const TextureBox srcBox = image.getData( mip );
+                const TextureBox dstBox = dstImage.getData( mip );
+
+                CompressBcTask task( srcBox, srcFormat, dstBox, dstFormat );
+
+                const size_t numTasksBySize = srcBox.getSizeBytes() / c_minBytesPerCompressTask;
+                uint32 numTasks =
+                    static_cast<uint32>( std::min<size_t>( numTasksBySize, c_maxCompressTasks ) );
+                numTasks = std::max( std::min( numTasks, task.getNumUnits() ), 1u );
+
+                if( numTasks > 1u )
+                    textureManager->_executeOnMultiLoadPool( &task, numTasks );
+                else
+                    task.execute( 0u, 1u );
+            }
+
+            assert( image.getAutoDelete() && "This should be impossible. Memory will leak." );
+            image.loadDynamicImage( data, image.getWidth(), image.getHeight(), image.getDepthOrSlices(),
+                                    image.getTextureType(), dstFormat, true, numMipmaps );
+
+            // If the texture prefers sRGB, setPixelFormat already converted it
+            const PixelFormatGpu texFormat = texture->prefersLoadingFromFileAsSRGB()
+                                                 ? PixelFormatGpuUtils::getEquivalentSRGB( dstFormat )
+                                                 : dstFormat;
+            if( texture->getPixelFormat() != texFormat )
+                texture->setPixelFormat( dstFormat );
+        }
     }  // namespace TextureFilter
 }  // namespace Ogre
@@ -30,6 +30,8 @@ THE SOFTWARE.
 
 #include "OgreTextureGpuManager.h"
 
+#include "Hash/MurmurHash3.h"
+#include "OgreArchive.h"
 #include "OgreAsyncTextureTicket.h"
 #include "OgreBitset.inl"
 #include "OgreBitwise.h"
@@ -54,6 +56,7 @@ THE SOFTWARE.
 #    include "OgreTimer.h"
 #endif
 #include "Threading/OgreThreads.h"
+#include "Threading/OgreUniformScalableTask.h"
 #include "Vao/OgreVaoManager.h"
 
 #include <fstream>
@@ -90,6 +93,10 @@ namespace Ogre
     static const int c_mainThread = 0;
     static const int c_workerThread = 1;
 
+    /// Part of the name of every transcoded cache entry. Bump it whenever the
+    /// contents of the entries change, e.g. because a filter was modified
+    static const uint32 c_transcodedCacheVersion = 1u;
+
     static DefaultTextureGpuManagerListener sDefaultTextureGpuManagerListener;
 
     unsigned long updateStreamingWorkerThread( ThreadHandle *threadHandle );
@@ -109,6 +116,10 @@ namespace Ogre
         mAddedNewLoadRequests( false ),
         mMultiLoadsSemaphore( 0u ),
         mPendingMultiLoads( 0u ),
+        mPoolTask( 0 ),
+        mPoolTaskNextIdx( 0u ),
+        mPoolTaskNumTasks( 0u ),
+        mPoolTaskDoneSemaphore( 0u ),
         mEntriesToProcessPerIteration( 3u ),
         mMaxPreloadBytes( 256u * 1024u * 1024u ),  // A value of 512MB begins to shake driver bugs.
         mTextureGpuManagerListener( &sDefaultTextureGpuManagerListener ),
@@ -118,6 +129,11 @@ namespace Ogre
 #else
         mStagingTextureMaxBudgetBytes( 128u * 1024u * 1024u ),
 #endif
+        mTranscodedCacheArchive( 0 ),
+        mTranscodedCacheTmpCounter( 0u ),
+        mTranscodedCacheCapsTag( 0u ),
+        mTranscodedCacheBudget( 1024u * 1024u * 1024u ),
+        mTranscodedCacheBytes( 0u ),
         mDelayListenerCalls( false ),
         mIgnoreScheduledTasks( false ),
 #ifdef OGRE_PROFILING_TEXTURES
@@ -1394,6 +1410,202 @@ namespace Ogre
 #endif
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setTranscodedCacheArchive( Archive *archive )
+    {
+        ScopedLock lock( mTranscodedCacheMutex );
+
+        mTranscodedCacheArchive = archive;
+        mTranscodedCacheCapsTag = 0u;
+        mTranscodedCacheBytes = 0u;
+        mTranscodedCacheEntries.clear();
+        mTranscodedCacheEntryMap.clear();
+
+        if( !archive )
+            return;
+
+        // Formats CompressBc may produce. See CompressBc::getDestinationFormat
+        const PixelFormatGpu bcFormats[] = {
+            PFG_BC1_UNORM, PFG_BC1_UNORM_SRGB, PFG_BC3_UNORM, PFG_BC3_UNORM_SRGB,
+            PFG_BC4_UNORM, PFG_BC4_SNORM,      PFG_BC5_UNORM, PFG_BC5_SNORM,
+            PFG_BC7_UNORM, PFG_BC7_UNORM_SRGB,
+        };
+        for( uint32 i = 0u; i < sizeof( bcFormats ) / sizeof( bcFormats[0] ); ++i )
+        {
+            if( checkSupport( bcFormats[i], TextureTypes::Type2D, 0u ) )
+                mTranscodedCacheCapsTag |= 1u << i;
+        }
+
+        char tmpBuffer[32];
+        LwString versionPrefix( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+        versionPrefix.a( "v", c_transcodedCacheVersion, "_" );
+
+        struct FoundEntry
+        {
+            time_t          modifiedTime;
+            const FileInfo *fileInfo;
+
+            // Newest first
+            bool operator<( const FoundEntry &other ) const
+            {
+                return modifiedTime > other.modifiedTime;
+            }
+        };
+
+        vector<FoundEntry>::type foundEntries;
+
+        FileInfoListPtr fileInfoList = archive->listFileInfo( false, false );
+        FileInfoList::const_iterator itor = fileInfoList->begin();
+        FileInfoList::const_iterator endt = fileInfoList->end();
+
+        while( itor != endt )
+        {
+            const String &filename = itor->filename;
+            if( StringUtil::endsWith( filename, ".oitd", false ) &&
+                StringUtil::startsWith( filename, versionPrefix.c_str(), false ) )
+            {
+                FoundEntry foundEntry;
+                foundEntry.modifiedTime = archive->getModifiedTime( filename );
+                foundEntry.fileInfo = &( *itor );
+                foundEntries.push_back( foundEntry );
+            }
+            else if( StringUtil::endsWith( filename, ".oitd", false ) ||
+                     StringUtil::endsWith( filename, ".tmp", false ) )
+            {
+                // Entry of another version of the cache, or a leftover from a crash
+                try
+                {
+                    archive->remove( filename );
+                }
+                catch( Exception &e )
+                {
+                    LogManager::getSingleton().logMessage(
+                        "Could not remove stale transcoded cache entry " + filename + ": " +
+                        e.getFullDescription() );
+                }
+            }
+            ++itor;
+        }
+
+        std::sort( foundEntries.begin(), foundEntries.end() );
+
+        vector<FoundEntry>::type::const_iterator itFound = foundEntries.begin();
+        vector<FoundEntry>::type::const_iterator enFound = foundEntries.end();
+
+        while( itFound != enFound )
+        {
+            TranscodedCacheEntry entry;
+            entry.name = itFound->fileInfo->filename;
+            entry.sizeBytes = itFound->fileInfo->uncompressedSize;
+            mTranscodedCacheEntries.push_back( entry );
+            mTranscodedCacheEntryMap[entry.name] = --mTranscodedCacheEntries.end();
+            mTranscodedCacheBytes += entry.sizeBytes;
+            ++itFound;
+        }
+
+        if( mTranscodedCacheBudget )
+            evictTranscodedCacheEntries( mTranscodedCacheBudget );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setTranscodedCacheBudget( size_t bytes )
+    {
+        ScopedLock lock( mTranscodedCacheMutex );
+        mTranscodedCacheBudget = bytes;
+        if( mTranscodedCacheBudget && mTranscodedCacheArchive )
+            evictTranscodedCacheEntries( mTranscodedCacheBudget );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t TextureGpuManager::getTranscodedCacheSize()
+    {
+        ScopedLock lock( mTranscodedCacheMutex );
+        return mTranscodedCacheBytes;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::evictTranscodedCacheEntries( size_t budget )
+    {
+        while( mTranscodedCacheBytes > budget && !mTranscodedCacheEntries.empty() )
+        {
+            // Least recently used is at the back
+            const TranscodedCacheEntry &entry = mTranscodedCacheEntries.back();
+            try
+            {
+                mTranscodedCacheArchive->remove( entry.name );
+            }
+            catch( Exception &e )
+            {
+                LogManager::getSingleton().logMessage( "Could not evict transcoded cache entry " +
+                                                       entry.name + ": " + e.getFullDescription() );
+            }
+            mTranscodedCacheBytes -= entry.sizeBytes;
+            mTranscodedCacheEntryMap.erase( entry.name );
+            mTranscodedCacheEntries.pop_back();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_executeOnMultiLoadPool( UniformScalableTask *task, uint32 numTasks )
+    {
+        bool bUsePool = false;
+
+        if( numTasks > 1u )
+        {
+            mMultiLoadsMutex.lock();
+            // We use memory_order_relaxed because the mutex already guarantees ordering.
+            if( mUseMultiload.load( std::memory_order_relaxed ) && !mPoolTask )
+            {
+                mPoolTask = task;
+                mPoolTaskNextIdx = 0u;
+                mPoolTaskNumTasks = numTasks;
+                bUsePool = true;
+            }
+            mMultiLoadsMutex.unlock();
+        }
+
+        if( !bUsePool )
+        {
+            for( uint32 i = 0u; i < numTasks; ++i )
+                task->execute( i, numTasks );
+            return;
+        }
+
+        // Wake up the pool. Threads busy loading a texture won't help, and threads waking up
+        // after we're done will just find nothing to do. Both are harmless.
+        mMultiLoadsSemaphore.increment( numTasks - 1u );
+
+        while( executeNextPoolTask() )
+        {
+        }
+
+        // Every task has been grabbed, but some may still be running in the pool
+        for( uint32 i = 0u; i < numTasks; ++i )
+            mPoolTaskDoneSemaphore.decrementOrWait();
+
+        mMultiLoadsMutex.lock();
+        mPoolTask = 0;
+        mMultiLoadsMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::executeNextPoolTask()
+    {
+        UniformScalableTask *task = 0;
+        uint32 taskIdx = 0u;
+        uint32 numTasks = 0u;
+
+        mMultiLoadsMutex.lock();
+        if( mPoolTask && mPoolTaskNextIdx < mPoolTaskNumTasks )
+        {
+            task = mPoolTask;
+            taskIdx = mPoolTaskNextIdx++;
+            numTasks = mPoolTaskNumTasks;
+        }
+        mMultiLoadsMutex.unlock();
+
+        if( !task )
+            return false;
+
+        task->execute( taskIdx, numTasks );
+        mPoolTaskDoneSemaphore.increment();
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::setWorkerThreadMinimumBudget( const BudgetEntryVec &budget,
                                                           uint32 maxSplitResolution )
     {
@@ -2690,6 +2902,11 @@ namespace Ogre
         {
             mMultiLoadsSemaphore.decrementOrWait();
 
+            // Help the streaming thread first, as it is waiting for us (if there's any work)
+            while( executeNextPoolTask() )
+            {
+            }
+
             bool bWorkGrabbed = false;
 
             mMultiLoadsMutex.lock();
@@ -2747,7 +2964,8 @@ namespace Ogre
 
                     try
                     {
-                        img->load2( data, loadRequest.name );
+                        loadRequest.fromTranscodedCache =
+                            loadImage( *img, data, loadRequest, loadRequest.transcodedCacheName );
                     }
                     catch( Exception & )
                     {
@@ -2793,6 +3011,153 @@ namespace Ogre
         return 0;
     }
     //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::loadImage( Image2 &img, DataStreamPtr &data, const LoadRequest &loadRequest,
+                                       String &outTranscodedCacheName )
+    {
+        if( !mTranscodedCacheArchive || !loadRequest.archive ||
+            data->size() > size_t( std::numeric_limits<int>::max() ) )
+        {
+            img.load2( data, loadRequest.name );
+            return false;
+        }
+
+        OgreProfileExhaustive( "TextureGpuManager::loadImage with transcoded cache" );
+
+        // We need the whole file in memory to hash it. The codecs will read it from there
+        DataStreamPtr srcData = data;
+        if( !srcData->getContiguousPtr() )
+            srcData.reset( OGRE_NEW MemoryDataStream( data ) );
+
+        uint64 hashVal[2];
+        MurmurHash3_x64_128( srcData->getContiguousPtr(), static_cast<int>( srcData->size() ),
+                             IdString::Seed, hashVal );
+
+        char tmpBuffer[128];
+        LwString cacheName( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+        cacheName.a( "v", c_transcodedCacheVersion, "_", mTranscodedCacheCapsTag, "_" );
+        cacheName.a( hashVal[0], "_", hashVal[1], "_", loadRequest.filters );
+        if( loadRequest.texture->prefersLoadingFromFileAsSRGB() )
+            cacheName.a( "_srgb" );
+        cacheName.a( ".oitd" );
+
+        if( mTranscodedCacheArchive->exists( cacheName.c_str() ) )
+        {
+            try
+            {
+                DataStreamPtr cachedData = mTranscodedCacheArchive->open( cacheName.c_str() );
+                img.load( cachedData, "oitd" );
+                if( checkSupport( img.getPixelFormat(), img.getTextureType(), 0u ) )
+                {
+                    ScopedLock lock( mTranscodedCacheMutex );
+                    TranscodedCacheEntryMap::iterator itEntry =
+                        mTranscodedCacheEntryMap.find( cacheName.c_str() );
+                    if( itEntry != mTranscodedCacheEntryMap.end() )
+                    {
+                        // It's now the most recently used
+                        mTranscodedCacheEntries.splice( mTranscodedCacheEntries.begin(),
+                                                        mTranscodedCacheEntries, itEntry->second );
+                    }
+
+                    outTranscodedCacheName = cacheName.c_str();
+                    return true;
+                }
+
+                // The tag should have prevented this. Decode the original and overwrite it
+                LogManager::getSingleton().logMessage(
+                    "Transcoded cache entry " + String( cacheName.c_str() ) + " for " +
+                    loadRequest.name + " has format " +
+                    PixelFormatGpuUtils::toString( img.getPixelFormat() ) +
+                    ", which is not supported" );
+            }
+            catch( Exception &e )
+            {
+                // Corrupt entry. Decode the original and overwrite it
+                LogManager::getSingleton().logMessage(
+                    "Transcoded cache entry " + String( cacheName.c_str() ) + " for " +
+                    loadRequest.name + " could not be loaded: " + e.getFullDescription() );
+            }
+        }
+
+        img.load2( srcData, loadRequest.name );
+        outTranscodedCacheName = cacheName.c_str();
+        return false;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::saveToTranscodedCache( Image2 &img, const String &transcodedCacheName )
+    {
+        OgreProfileExhaustive( "TextureGpuManager::saveToTranscodedCache" );
+
+        // Readers (including us, if we crash halfway) must never see a partially written
+        // entry. The counter keeps threads writing the same entry from sharing the temp file
+        char tmpBuffer[128];
+        LwString tmpName( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+        tmpName.a( transcodedCacheName.c_str(), ".", mTranscodedCacheTmpCounter.fetch_add( 1u ),
+                   ".tmp" );
+
+        bool bTmpCreated = false;
+        try
+        {
+            DataStreamPtr encoded = img.encode( "oitd", 0u, img.getNumMipmaps() );
+            MemoryDataStream *encodedMem = static_cast<MemoryDataStream *>( encoded.get() );
+            const size_t entrySize = encodedMem->size();
+
+            {
+                ScopedLock lock( mTranscodedCacheMutex );
+                if( mTranscodedCacheBudget && entrySize > mTranscodedCacheBudget )
+                    return;
+            }
+
+            DataStreamPtr cacheFile = mTranscodedCacheArchive->create( tmpName.c_str() );
+            bTmpCreated = true;
+            cacheFile->write( encodedMem->getPtr(), entrySize );
+            // Flush it and release the handle before renaming
+            cacheFile->close();
+            cacheFile.reset();
+            mTranscodedCacheArchive->rename( tmpName.c_str(), transcodedCacheName );
+
+            ScopedLock lock( mTranscodedCacheMutex );
+
+            TranscodedCacheEntryMap::iterator itEntry =
+                mTranscodedCacheEntryMap.find( transcodedCacheName );
+            if( itEntry != mTranscodedCacheEntryMap.end() )
+            {
+                // We've overwritten it, i.e. it was corrupt or another thread loaded the same file
+                mTranscodedCacheBytes -= itEntry->second->sizeBytes;
+                mTranscodedCacheEntries.erase( itEntry->second );
+                mTranscodedCacheEntryMap.erase( itEntry );
+            }
+
+            if( mTranscodedCacheBudget )
+            {
+                evictTranscodedCacheEntries(
+                    entrySize < mTranscodedCacheBudget ? mTranscodedCacheBudget - entrySize : 0u );
+            }
+
+            TranscodedCacheEntry entry;
+            entry.name = transcodedCacheName;
+            entry.sizeBytes = entrySize;
+            mTranscodedCacheEntries.push_front( entry );
+            mTranscodedCacheEntryMap[transcodedCacheName] = mTranscodedCacheEntries.begin();
+            mTranscodedCacheBytes += entrySize;
+        }
+        catch( Exception &e )
+        {
+            LogManager::getSingleton().logMessage( "Could not write transcoded cache entry " +
+                                                   transcodedCacheName + ": " +
+                                                   e.getFullDescription() );
+            if( bTmpCreated )
+            {
+                try
+                {
+                    mTranscodedCacheArchive->remove( tmpName.c_str() );
+                }
+                catch( Exception & )
+                {
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::processLoadRequest( ObjCmdBuffer *commandBuffer, ThreadData &workerData,
                                                 const LoadRequest &loadRequest )
     {
@@ -2865,6 +3230,9 @@ namespace Ogre
         Image2 imgStack;
         Image2 *img = loadRequest.image;
 
+        bool fromTranscodedCache = loadRequest.fromTranscodedCache;
+        String transcodedCacheName = loadRequest.transcodedCacheName;
+
 #ifdef OGRE_PROFILING_TEXTURES
         Timer profilingTimer;
 #endif
@@ -2877,7 +3245,7 @@ namespace Ogre
                 try
                 {
                     if( data )
-                        img->load2( data, loadRequest.name );
+                        fromTranscodedCache = loadImage( *img, data, loadRequest, transcodedCacheName );
                 }
                 catch( Exception &e )
                 {
@@ -2911,6 +3279,21 @@ namespace Ogre
             }
         }
 
+        // Images from the transcoded cache already went through all filters, except for
+        // HW mipmap generation which doesn't get cached (and SW mipmaps will be skipped).
+        // Block compressed entries either come from CompressBc, which generates the mipmaps
+        // on the CPU before compressing, or from files that were already compressed, which
+        // the mipmap filters can't process. Either way nothing is left to do, and running the
+        // mipmap filters would pick HW mipmaps although GPUs can't render to BC formats.
+        uint32 filterFlags = loadRequest.filters;
+        if( fromTranscodedCache )
+        {
+            if( PixelFormatGpuUtils::isCompressed( img->getPixelFormat() ) )
+                filterFlags = 0u;
+            else
+                filterFlags &= TextureFilter::TypeGenerateDefaultMipmaps;
+        }
+
         if( ( loadRequest.sliceOrDepth == std::numeric_limits<uint32>::max() ||
               loadRequest.sliceOrDepth == 0 ) &&
             loadRequest.texture->getResidencyStatus() != GpuResidency::OnStorage )
@@ -2919,8 +3302,8 @@ namespace Ogre
             PixelFormatGpu pixelFormat = img->getPixelFormat();
             if( loadRequest.texture->prefersLoadingFromFileAsSRGB() )
                 pixelFormat = PixelFormatGpuUtils::getEquivalentSRGB( pixelFormat );
-            TextureFilter::FilterBase::simulateFiltersForCacheConsistency(
-                loadRequest.filters, *img, this, numMipmaps, pixelFormat );
+            TextureFilter::FilterBase::simulateFiltersForCacheConsistency( filterFlags, *img, this,
+                                                                           numMipmaps, pixelFormat );
 
             // Check the metadata cache was not out of date
             if( loadRequest.texture->getWidth() != img->getWidth() ||
@@ -2951,8 +3334,8 @@ namespace Ogre
         if( !wasRescheduled )
         {
             FilterBaseArray filters;
-            TextureFilter::FilterBase::createFilters( loadRequest.filters, filters, loadRequest.texture,
-                                                      *img, loadRequest.toSysRam );
+            TextureFilter::FilterBase::createFilters( filterFlags, filters, loadRequest.texture, *img,
+                                                      loadRequest.toSysRam );
 
             if( loadRequest.sliceOrDepth == std::numeric_limits<uint32>::max() ||
                 loadRequest.sliceOrDepth == 0 )
@@ -2985,6 +3368,9 @@ namespace Ogre
                     ++itFilters;
                 }
 
+                if( !fromTranscodedCache && !transcodedCacheName.empty() )
+                    saveToTranscodedCache( *img, transcodedCacheName );
+
                 const bool needsMultipleImages =
                     img->getTextureType() != loadRequest.texture->getTextureType() &&
                     loadRequest.texture->getTextureType() != TextureTypes::Type1D;
@@ -3071,6 +3457,9 @@ namespace Ogre
                     ++itFilters;
                 }
 
+                if( !fromTranscodedCache && !transcodedCacheName.empty() )
+                    saveToTranscodedCache( *img, transcodedCacheName );
+
                 if( loadRequest.toSysRam || loadRequest.texture->getGpuPageOutStrategy() ==
                                                 GpuPageOutStrategy::AlwaysKeepSystemRamCopy )
                 {
@@ -33,10 +33,165 @@ THE SOFTWARE.
 #include "OgreRoot.h"
 #include "OgreTimer.h"
 
+#include <algorithm>
 #include <sstream>
 
 namespace Ogre
 {
+    /// Counts how often a thread finds another one holding (or waiting for) a mutex.
+    /// Declare it right before locking, so that it outlives the lock.
+    struct MutexContentionCounter
+    {
+        std::atomic<uint32> &mUsers;
+
+        MutexContentionCounter( std::atomic<uint32> &users, std::atomic<uint64> &numContentions ) :
+            mUsers( users )
+        {
+            if( mUsers.fetch_add( 1u, std::memory_order_relaxed ) )
+                numContentions.fetch_add( 1u, std::memory_order_relaxed );
+        }
+        ~MutexContentionCounter() { mUsers.fetch_sub( 1u, std::memory_order_relaxed ); }
+    };
+
+    /// Keeps track of nested DefaultWorkQueueBase::processResponses calls, even if
+    /// a ResponseHandler throws.
+    struct ResponseProcessingScope
+    {
+        uint32 &mDepth;
+
+        ResponseProcessingScope( uint32 &depth ) : mDepth( depth ) { ++mDepth; }
+        ~ResponseProcessingScope() { --mDepth; }
+    };
+
+    /** Vyukov's bounded MPMC queue. Each cell's sequence tells whether it's ready to be
+        written (== position) or read (== position + 1) by whoever claimed that position,
+        so producers & consumers only contend on the position they CAS.
+    */
+    struct DefaultWorkQueueBase::RequestRing : public OgreAllocatedObj
+    {
+        static const size_t NumCells = 1024u;  // Must be a power of 2
+
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            Request            *request;
+        };
+
+        uint16       mChannel;
+        RequestRing *mNext;  // Immutable once the ring is published
+
+        // Padding avoids false sharing between producers and consumers
+        uint8               mPadding0[64u];
+        std::atomic<size_t> mPushPos;
+        uint8               mPadding1[64u - sizeof( std::atomic<size_t> )];
+        std::atomic<size_t> mPopPos;
+        uint8               mPadding2[64u - sizeof( std::atomic<size_t> )];
+        Cell                mCells[NumCells];
+
+        RequestRing( uint16 channel ) : mChannel( channel ), mNext( 0 ), mPushPos( 0u ), mPopPos( 0u )
+        {
+            for( size_t i = 0u; i < NumCells; ++i )
+            {
+                mCells[i].sequence.store( i, std::memory_order_relaxed );
+                mCells[i].request = 0;
+            }
+        }
+
+        /// Returns false if the ring is full
+        bool push( Request *req, std::atomic<uint64> &numRetries )
+        {
+            size_t pos = mPushPos.load( std::memory_order_relaxed );
+            Cell *cell;
+            while( true )
+            {
+                cell = &mCells[pos & ( NumCells - 1u )];
+                const size_t seq = cell->sequence.load( std::memory_order_acquire );
+                const ptrdiff_t diff = static_cast<ptrdiff_t>( seq - pos );
+                if( diff == 0 )
+                {
+                    if( mPushPos.compare_exchange_weak( pos, pos + 1u, std::memory_order_relaxed ) )
+                        break;
+                    numRetries.fetch_add( 1u, std::memory_order_relaxed );
+                }
+                else if( diff < 0 )
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = mPushPos.load( std::memory_order_relaxed );
+                }
+            }
+
+            cell->request = req;
+            cell->sequence.store( pos + 1u, std::memory_order_release );
+            return true;
+        }
+
+        /// Returns null if the ring is empty
+        Request *pop()
+        {
+            size_t pos = mPopPos.load( std::memory_order_relaxed );
+            Cell *cell;
+            while( true )
+            {
+                cell = &mCells[pos & ( NumCells - 1u )];
+                const size_t seq = cell->sequence.load( std::memory_order_acquire );
+                const ptrdiff_t diff = static_cast<ptrdiff_t>( seq - ( pos + 1u ) );
+                if( diff == 0 )
+                {
+                    if( mPopPos.compare_exchange_weak( pos, pos + 1u, std::memory_order_relaxed ) )
+                        break;
+                }
+                else if( diff < 0 )
+                {
+                    return 0;
+                }
+                else
+                {
+                    pos = mPopPos.load( std::memory_order_relaxed );
+                }
+            }
+
+            Request *req = cell->request;
+            cell->sequence.store( pos + NumCells, std::memory_order_release );
+            return req;
+        }
+    };
+
+    struct DefaultWorkQueueBase::ResponseAbort : public OgreAllocatedObj
+    {
+        enum Type
+        {
+            ById,
+            ByChannel,
+            All
+        };
+
+        Type           mType;
+        RequestID      mId;
+        uint16         mChannel;
+        ResponseAbort *mNext;
+
+        ResponseAbort( Type type, RequestID id, uint16 channel ) :
+            mType( type ),
+            mId( id ),
+            mChannel( channel ),
+            mNext( 0 )
+        {
+        }
+
+        bool matches( const Request *req ) const
+        {
+            return mType == All || ( mType == ById && req->getID() == mId ) ||
+                   ( mType == ByChannel && req->getChannel() == mChannel );
+        }
+    };
+
+#define OGRE_LOCK_REQUEST_MUTEX \
+    MutexContentionCounter requestMutexContention( mRequestMutexUsers, mNumRequestLockContentions ); \
+    OGRE_LOCK_MUTEX( mRequestMutex )
+
     //---------------------------------------------------------------------
     uint16 WorkQueue::getChannel( const String &channelName )
     {
@@ -50,15 +205,41 @@ namespace Ogre
         return i->second;
     }
     //---------------------------------------------------------------------
+    WorkQueue::RequestID WorkQueue::addPrioritisedRequest( uint16 channel, uint16 requestType,
+                                                           const Any &rData, int16 priority,
+                                                           uint64 deadline, uint8 retryCount,
+                                                           bool forceSynchronous, bool idleThread )
+    {
+        (void)priority;
+        (void)deadline;
+        return addRequest( channel, requestType, rData, retryCount, forceSynchronous, idleThread );
+    }
+    //---------------------------------------------------------------------
+    bool WorkQueue::setRequestPriority( RequestID id, int16 priority )
+    {
+        (void)id;
+        (void)priority;
+        return false;
+    }
+    //---------------------------------------------------------------------
+    bool WorkQueue::cancelPendingRequest( RequestID id )
+    {
+        (void)id;
+        return false;
+    }
+    //---------------------------------------------------------------------
     WorkQueue::Request::Request( uint16 channel, uint16 rtype, const Any &rData, uint8 retry,
-                                 RequestID rid ) :
+                                 RequestID rid, int16 priority, uint64 deadline ) :
         mChannel( channel ),
         mType( rtype ),
         mData( rData ),
         mRetryCount( retry ),
         mID( rid ),
-        mAborted( false )
+        mAborted( false ),
+        mPriority( priority ),
+        mDeadline( deadline )
     {
+        mHeapIdx[0] = mHeapIdx[1] = 0u;
     }
     //---------------------------------------------------------------------
     WorkQueue::Request::~Request() {}
@@ -69,7 +250,8 @@ namespace Ogre
         mRequest( rq ),
         mSuccess( success ),
         mMessages( msg ),
-        mData( data )
+        mData( data ),
+        mNext( 0 )
     {
     }
     //---------------------------------------------------------------------
@@ -82,13 +264,30 @@ namespace Ogre
         mWorkerRenderSystemAccess( false ),
         mIsRunning( false ),
         mResposeTimeLimitMS( 8 ),
+        mUrgentResponsePriority( std::numeric_limits<int32>::max() ),
+        mRequestRings( 0 ),
+        mNumRingRequests( 0 ),
+        mNumSleepingWorkers( 0u ),
+        mPublishedResponses( 0 ),
+        mPublishedResponseAborts( 0 ),
+        mNumRequests( 0u ),
+        mNumResponses( 0u ),
+        mNumResponsePushRetries( 0u ),
+        mNumRequestHandlerUpdates( 0u ),
+        mNumRequestLockContentions( 0u ),
+        mNumRequestPushRetries( 0u ),
+        mNumRequestRingOverflows( 0u ),
+        mRequestMutexUsers( 0u ),
         mWorkerFunc( 0 ),
+        mRequestHandlers( new RequestHandlerListByChannel() ),
         mRequestCount( 0 ),
         mPaused( false ),
         mAcceptRequests( true ),
         mShuttingDown( false ),
         mIdleThreadRunning( false ),
-        mIdleProcessed( 0 )
+        mIdleProcessed( 0 ),
+        mNextBatchResponse( 0u ),
+        mResponseProcessingDepth( 0u )
     {
     }
     //---------------------------------------------------------------------
@@ -112,57 +311,92 @@ namespace Ogre
     {
         // shutdown(); // can't call here; abstract function
 
-        for( RequestQueue::iterator i = mRequestQueue.begin(); i != mRequestQueue.end(); ++i )
+        drainRequestRings();
+        RequestRing *ring = mRequestRings.exchange( 0, std::memory_order_acquire );
+        while( ring )
+        {
+            RequestRing *next = ring->mNext;
+            OGRE_DELETE ring;
+            ring = next;
+        }
+
+        for( RequestHeap::const_iterator i = mRequestQueue.begin(); i != mRequestQueue.end(); ++i )
         {
             OGRE_DELETE( *i );
         }
         mRequestQueue.clear();
+        mRequestDeadlines.clear();
+        mQueuedRequestsById.clear();
 
+        drainPublishedResponses();
         for( ResponseQueue::iterator i = mResponseQueue.begin(); i != mResponseQueue.end(); ++i )
         {
             OGRE_DELETE( *i );
         }
         mResponseQueue.clear();
+        // Only non-empty if a ResponseHandler threw in the middle of processResponses
+        for( ResponseQueue::iterator i = mResponseBatch.begin(); i != mResponseBatch.end(); ++i )
+        {
+            OGRE_DELETE( *i );
+        }
+        mResponseBatch.clear();
+
+        ResponseAbort *abort = mPublishedResponseAborts.exchange( 0, std::memory_order_acquire );
+        while( abort )
+        {
+            ResponseAbort *next = abort->mNext;
+            OGRE_DELETE abort;
+            abort = next;
+        }
     }
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::addRequestHandler( uint16 channel, RequestHandler *rh )
     {
         OGRE_LOCK_RW_MUTEX_WRITE( mRequestHandlerMutex );
 
-        RequestHandlerListByChannel::iterator i = mRequestHandlers.find( channel );
-        if( i == mRequestHandlers.end() )
-            i = mRequestHandlers.emplace( channel, RequestHandlerList() ).first;
-
-        RequestHandlerList &handlers = i->second;
-        bool duplicate = false;
-        for( RequestHandlerList::iterator j = handlers.begin(); j != handlers.end(); ++j )
+        RequestHandlerListByChannel::const_iterator i = mRequestHandlers->find( channel );
+        if( i != mRequestHandlers->end() )
         {
-            if( ( *j )->getHandler() == rh )
+            const RequestHandlerList &handlers = i->second;
+            for( RequestHandlerList::const_iterator j = handlers.begin(); j != handlers.end(); ++j )
             {
-                duplicate = true;
-                break;
+                if( ( *j )->getHandler() == rh )
+                    return;  // Duplicate
             }
         }
-        if( !duplicate )
-            handlers.push_back( RequestHandlerHolderPtr( OGRE_NEW RequestHandlerHolder( rh ) ) );
+
+        // Copy on write. Workers may be iterating the current map
+        RequestHandlerListByChannelPtr newHandlers(
+            new RequestHandlerListByChannel( *mRequestHandlers ) );
+        ( *newHandlers )[channel].push_back(
+            RequestHandlerHolderPtr( OGRE_NEW RequestHandlerHolder( rh ) ) );
+        mRequestHandlers = newHandlers;
+        mNumRequestHandlerUpdates.fetch_add( 1u, std::memory_order_relaxed );
     }
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::removeRequestHandler( uint16 channel, RequestHandler *rh )
     {
         OGRE_LOCK_RW_MUTEX_WRITE( mRequestHandlerMutex );
 
-        RequestHandlerListByChannel::iterator i = mRequestHandlers.find( channel );
-        if( i != mRequestHandlers.end() )
+        RequestHandlerListByChannel::const_iterator i = mRequestHandlers->find( channel );
+        if( i != mRequestHandlers->end() )
         {
-            RequestHandlerList &handlers = i->second;
-            for( RequestHandlerList::iterator j = handlers.begin(); j != handlers.end(); ++j )
+            const RequestHandlerList &handlers = i->second;
+            for( size_t j = 0u; j < handlers.size(); ++j )
             {
-                if( ( *j )->getHandler() == rh )
+                if( handlers[j]->getHandler() == rh )
                 {
-                    // Disconnect - this will make it safe across copies of the list
+                    // Disconnect - this will make it safe for workers still holding the old map
                     // this is threadsafe and will wait for existing processes to finish
-                    ( *j )->disconnectHandler();
-                    handlers.erase( j );
+                    handlers[j]->disconnectHandler();
+
+                    // Copy on write. Workers may be iterating the current map
+                    RequestHandlerListByChannelPtr newHandlers(
+                        new RequestHandlerListByChannel( *mRequestHandlers ) );
+                    RequestHandlerList &newList = ( *newHandlers )[channel];
+                    newList.erase( newList.begin() + static_cast<ptrdiff_t>( j ) );
+                    mRequestHandlers = newHandlers;
+                    mNumRequestHandlerUpdates.fetch_add( 1u, std::memory_order_relaxed );
                     break;
                 }
             }
@@ -192,23 +426,226 @@ namespace Ogre
         }
     }
     //---------------------------------------------------------------------
+    bool DefaultWorkQueueBase::requestGoesFirst( RequestHeapType heapType, const Request *a,
+                                                 const Request *b )
+    {
+        if( heapType == RequestHeapPriority )
+        {
+            if( a->getPriority() != b->getPriority() )
+                return a->getPriority() > b->getPriority();
+            // Requests without deadline (0) go after those with one
+            const uint64 deadlineA = a->getDeadline() - 1u;
+            const uint64 deadlineB = b->getDeadline() - 1u;
+            if( deadlineA != deadlineB )
+                return deadlineA < deadlineB;
+        }
+        else if( a->getDeadline() != b->getDeadline() )
+        {
+            return a->getDeadline() < b->getDeadline();
+        }
+        return a->getID() < b->getID();
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::requestHeapSet( RequestHeap &heap, RequestHeapType heapType,
+                                               size_t idx, Request *req )
+    {
+        heap[idx] = req;
+        req->mHeapIdx[heapType] = idx;
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::requestHeapUpdate( RequestHeap &heap, RequestHeapType heapType,
+                                                  size_t idx )
+    {
+        Request *req = heap[idx];
+
+        // Move up
+        while( idx > 0u )
+        {
+            const size_t parentIdx = ( idx - 1u ) >> 1u;
+            if( !requestGoesFirst( heapType, req, heap[parentIdx] ) )
+                break;
+            requestHeapSet( heap, heapType, idx, heap[parentIdx] );
+            idx = parentIdx;
+        }
+
+        // Move down
+        const size_t numRequests = heap.size();
+        while( true )
+        {
+            size_t childIdx = ( idx << 1u ) + 1u;
+            if( childIdx >= numRequests )
+                break;
+            if( childIdx + 1u < numRequests &&
+                requestGoesFirst( heapType, heap[childIdx + 1u], heap[childIdx] ) )
+            {
+                ++childIdx;
+            }
+            if( !requestGoesFirst( heapType, heap[childIdx], req ) )
+                break;
+            requestHeapSet( heap, heapType, idx, heap[childIdx] );
+            idx = childIdx;
+        }
+
+        requestHeapSet( heap, heapType, idx, req );
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::requestHeapPush( RequestHeap &heap, RequestHeapType heapType,
+                                                Request *req )
+    {
+        heap.push_back( req );
+        requestHeapUpdate( heap, heapType, heap.size() - 1u );
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::requestHeapErase( RequestHeap &heap, RequestHeapType heapType,
+                                                 size_t idx )
+    {
+        Request *last = heap.back();
+        heap.pop_back();
+        if( idx < heap.size() )
+        {
+            requestHeapSet( heap, heapType, idx, last );
+            requestHeapUpdate( heap, heapType, idx );
+        }
+    }
+    //---------------------------------------------------------------------
+    DefaultWorkQueueBase::RequestRing *DefaultWorkQueueBase::getRequestRing( uint16 channel )
+    {
+        RequestRing *head = mRequestRings.load( std::memory_order_acquire );
+        RequestRing *newRing = 0;
+        while( true )
+        {
+            for( RequestRing *ring = head; ring; ring = ring->mNext )
+            {
+                if( ring->mChannel == channel )
+                {
+                    // Someone else added it while we were trying to
+                    OGRE_DELETE newRing;
+                    return ring;
+                }
+            }
+
+            if( !newRing )
+                newRing = OGRE_NEW RequestRing( channel );
+            newRing->mNext = head;
+            // On failure head is updated; look again in case the new ones include ours
+            if( mRequestRings.compare_exchange_weak( head, newRing, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire ) )
+            {
+                return newRing;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::pushRequest( Request *req )
+    {
+        if( getRequestRing( req->getChannel() )->push( req, mNumRequestPushRetries ) )
+        {
+            // Sequentially consistent, pairs with waitForNextRequest's check so that either
+            // the worker sees the request, or we see the worker (see notifyWorkers)
+            mNumRingRequests.fetch_add( 1 );
+        }
+        else
+        {
+            mNumRequestRingOverflows.fetch_add( 1u, std::memory_order_relaxed );
+            OGRE_LOCK_REQUEST_MUTEX;
+            queueRequest( req );
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::drainRequestRings()
+    {
+        // A request that was just pushed may not be counted yet. Its producer will
+        // notify the workers once it is, so it won't be forgotten
+        if( mNumRingRequests.load( std::memory_order_relaxed ) <= 0 )
+            return;
+
+        // The heap sorts them by priority, deadline and ID, thus it doesn't matter
+        // in which order the rings are drained
+        RequestRing *ring = mRequestRings.load( std::memory_order_acquire );
+        while( ring )
+        {
+            Request *req;
+            while( ( req = ring->pop() ) != 0 )
+            {
+                queueRequest( req );
+                mNumRingRequests.fetch_sub( 1, std::memory_order_relaxed );
+            }
+            ring = ring->mNext;
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::queueRequest( Request *req )
+    {
+        requestHeapPush( mRequestQueue, RequestHeapPriority, req );
+        if( req->getDeadline() )
+            requestHeapPush( mRequestDeadlines, RequestHeapDeadline, req );
+        mQueuedRequestsById[req->getID()] = req;
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::unqueueRequest( Request *req )
+    {
+        if( req->getDeadline() )
+            requestHeapErase( mRequestDeadlines, RequestHeapDeadline, req->mHeapIdx[1] );
+        requestHeapErase( mRequestQueue, RequestHeapPriority, req->mHeapIdx[0] );
+        mQueuedRequestsById.erase( req->getID() );
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Request *DefaultWorkQueueBase::dequeueNextRequest()
+    {
+        if( mRequestQueue.empty() )
+            return 0;
+
+        Request *retVal = mRequestQueue.front();
+        if( !mRequestDeadlines.empty() )
+        {
+            // An overdue request goes before anything else, regardless of its priority
+            Request *earliest = mRequestDeadlines.front();
+            if( earliest != retVal &&
+                earliest->getDeadline() <= Root::getSingleton().getTimer()->getMilliseconds() )
+            {
+                retVal = earliest;
+            }
+        }
+
+        unqueueRequest( retVal );
+        return retVal;
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::Request *DefaultWorkQueueBase::findQueuedRequest( RequestID id ) const
+    {
+        QueuedRequestMap::const_iterator itor = mQueuedRequestsById.find( id );
+        return itor != mQueuedRequestsById.end() ? itor->second : 0;
+    }
+    //---------------------------------------------------------------------
     WorkQueue::RequestID DefaultWorkQueueBase::addRequest( uint16 channel, uint16 requestType,
                                                            const Any &rData, uint8 retryCount,
                                                            bool forceSynchronous, bool idleThread )
     {
-        Request *req = 0;
-        RequestID rid = 0;
+        return addPrioritisedRequest( channel, requestType, rData, 0, 0u, retryCount,
+                                      forceSynchronous, idleThread );
+    }
+    //---------------------------------------------------------------------
+    WorkQueue::RequestID DefaultWorkQueueBase::addPrioritisedRequest(
+        uint16 channel, uint16 requestType, const Any &rData, int16 priority, uint64 deadline,
+        uint8 retryCount, bool forceSynchronous, bool idleThread )
+    {
+        if( !mAcceptRequests || mShuttingDown )
+            return 0;
 
-        {
-            // lock to acquire rid and push request to the queue
-            OGRE_LOCK_MUTEX( mRequestMutex );
+        const RequestID rid = ++mRequestCount;
+        Request *req =
+            OGRE_NEW Request( channel, requestType, rData, retryCount, rid, priority, deadline );
 
-            if( !mAcceptRequests || mShuttingDown )
-                return 0;
+#if OGRE_THREAD_SUPPORT
+        // Lock-free unless the channel's ring is full
+        if( !forceSynchronous && !idleThread )
+            pushRequest( req );
+#endif
 
-            rid = ++mRequestCount;
-            req = OGRE_NEW Request( channel, requestType, rData, retryCount, rid );
+        mNumRequests.fetch_add( 1u, std::memory_order_relaxed );
 
+        if( isTraceLogEnabled() )
+        {
             LogManager::getSingleton().stream( LML_TRIVIAL )
                 << "DefaultWorkQueueBase('" << mName << "') - QUEUED(thread:" <<
 #if OGRE_THREAD_SUPPORT
@@ -216,16 +653,17 @@ namespace Ogre
 #else
                 "main"
 #endif
-                << "): ID=" << rid << " channel=" << channel << " requestType=" << requestType;
+                << "): ID=" << rid << " channel=" << channel << " requestType=" << requestType
+                << " priority=" << priority;
+        }
+
 #if OGRE_THREAD_SUPPORT
-            if( !forceSynchronous && !idleThread )
-            {
-                mRequestQueue.push_back( req );
-                notifyWorkers();
-                return rid;
-            }
-#endif
+        if( !forceSynchronous && !idleThread )
+        {
+            notifyWorkers();
+            return rid;
         }
+#endif
         if( OGRE_THREAD_SUPPORT && idleThread )
         {
             OGRE_LOCK_MUTEX( mIdleMutex );
@@ -244,32 +682,83 @@ namespace Ogre
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::addRequestWithRID( WorkQueue::RequestID rid, uint16 channel,
                                                   uint16 requestType, const Any &rData,
-                                                  uint8 retryCount )
+                                                  uint8 retryCount, int16 priority, uint64 deadline )
     {
-        // lock to push request to the queue
-        OGRE_LOCK_MUTEX( mRequestMutex );
-
         if( mShuttingDown )
             return;
 
-        Request *req = OGRE_NEW Request( channel, requestType, rData, retryCount, rid );
+        Request *req =
+            OGRE_NEW Request( channel, requestType, rData, retryCount, rid, priority, deadline );
 
-        LogManager::getSingleton().stream( LML_TRIVIAL )
-            << "DefaultWorkQueueBase('" << mName << "') - REQUEUED(thread:" <<
+        if( isTraceLogEnabled() )
+        {
+            LogManager::getSingleton().stream( LML_TRIVIAL )
+                << "DefaultWorkQueueBase('" << mName << "') - REQUEUED(thread:" <<
 #if OGRE_THREAD_SUPPORT
-            OGRE_THREAD_CURRENT_ID
+                OGRE_THREAD_CURRENT_ID
 #else
-            "main"
+                "main"
 #endif
-            << "): ID=" << rid << " channel=" << channel << " requestType=" << requestType;
+                << "): ID=" << rid << " channel=" << channel << " requestType=" << requestType
+                << " priority=" << priority;
+        }
 #if OGRE_THREAD_SUPPORT
-        mRequestQueue.push_back( req );
+        pushRequest( req );
         notifyWorkers();
 #else
         processRequestResponse( req, true );
 #endif
     }
     //---------------------------------------------------------------------
+    bool DefaultWorkQueueBase::setRequestPriority( RequestID id, int16 priority )
+    {
+        OGRE_LOCK_REQUEST_MUTEX;
+        drainRequestRings();
+
+        Request *req = findQueuedRequest( id );
+        if( !req )
+            return false;
+
+        if( req->getPriority() != priority )
+        {
+            req->_setPriority( priority );
+            requestHeapUpdate( mRequestQueue, RequestHeapPriority, req->mHeapIdx[0] );
+        }
+        return true;
+    }
+    //---------------------------------------------------------------------
+    bool DefaultWorkQueueBase::cancelPendingRequest( RequestID id )
+    {
+        Request *req = 0;
+        {
+            OGRE_LOCK_REQUEST_MUTEX;
+            drainRequestRings();
+
+            req = findQueuedRequest( id );
+            if( req )
+                unqueueRequest( req );
+        }
+
+        if( !req )
+        {
+            OGRE_LOCK_MUTEX( mIdleMutex );
+
+            for( RequestQueue::iterator i = mIdleRequestQueue.begin(); i != mIdleRequestQueue.end();
+                 ++i )
+            {
+                if( ( *i )->getID() == id )
+                {
+                    req = *i;
+                    mIdleRequestQueue.erase( i );
+                    break;
+                }
+            }
+        }
+
+        OGRE_DELETE req;
+        return req != 0;
+    }
+    //---------------------------------------------------------------------
     void DefaultWorkQueueBase::abortRequest( RequestID id )
     {
         OGRE_LOCK_MUTEX( mProcessMutex );
@@ -287,16 +776,12 @@ namespace Ogre
         }
 
         {
-            OGRE_LOCK_MUTEX( mRequestMutex );
+            OGRE_LOCK_REQUEST_MUTEX;
+            drainRequestRings();
 
-            for( RequestQueue::iterator i = mRequestQueue.begin(); i != mRequestQueue.end(); ++i )
-            {
-                if( ( *i )->getID() == id )
-                {
-                    ( *i )->abortRequest();
-                    break;
-                }
-            }
+            Request *req = findQueuedRequest( id );
+            if( req )
+                req->abortRequest();
         }
 
         {
@@ -313,18 +798,8 @@ namespace Ogre
             }
         }
 
-        {
-            OGRE_LOCK_MUTEX( mResponseMutex );
-
-            for( ResponseQueue::iterator i = mResponseQueue.begin(); i != mResponseQueue.end(); ++i )
-            {
-                if( ( *i )->getRequest()->getID() == id )
-                {
-                    ( *i )->abortRequest();
-                    break;
-                }
-            }
-        }
+        // The responses belong to the main thread. It applies this before processing them
+        publishResponseAbort( OGRE_NEW ResponseAbort( ResponseAbort::ById, id, 0u ) );
     }
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::abortRequestsByChannel( uint16 channel )
@@ -340,9 +815,11 @@ namespace Ogre
         }
 
         {
-            OGRE_LOCK_MUTEX( mRequestMutex );
+            OGRE_LOCK_REQUEST_MUTEX;
+            drainRequestRings();
 
-            for( RequestQueue::iterator i = mRequestQueue.begin(); i != mRequestQueue.end(); ++i )
+            for( RequestHeap::const_iterator i = mRequestQueue.begin(); i != mRequestQueue.end();
+                 ++i )
             {
                 if( ( *i )->getChannel() == channel )
                 {
@@ -368,24 +845,17 @@ namespace Ogre
             }
         }
 
-        {
-            OGRE_LOCK_MUTEX( mResponseMutex );
-
-            for( ResponseQueue::iterator i = mResponseQueue.begin(); i != mResponseQueue.end(); ++i )
-            {
-                if( ( *i )->getRequest()->getChannel() == channel )
-                {
-                    ( *i )->abortRequest();
-                }
-            }
-        }
+        publishResponseAbort( OGRE_NEW ResponseAbort( ResponseAbort::ByChannel, 0u, channel ) );
     }
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::abortPendingRequestsByChannel( uint16 channel )
     {
         {
-            OGRE_LOCK_MUTEX( mRequestMutex );
-            for( RequestQueue::iterator i = mRequestQueue.begin(); i != mRequestQueue.end(); ++i )
+            OGRE_LOCK_REQUEST_MUTEX;
+            drainRequestRings();
+
+            for( RequestHeap::const_iterator i = mRequestQueue.begin(); i != mRequestQueue.end();
+                 ++i )
             {
                 if( ( *i )->getChannel() == channel )
                 {
@@ -418,9 +888,11 @@ namespace Ogre
         }
 
         {
-            OGRE_LOCK_MUTEX( mRequestMutex );
+            OGRE_LOCK_REQUEST_MUTEX;
+            drainRequestRings();
 
-            for( RequestQueue::iterator i = mRequestQueue.begin(); i != mRequestQueue.end(); ++i )
+            for( RequestHeap::const_iterator i = mRequestQueue.begin(); i != mRequestQueue.end();
+                 ++i )
             {
                 ( *i )->abortRequest();
             }
@@ -441,19 +913,12 @@ namespace Ogre
             }
         }
 
-        {
-            OGRE_LOCK_MUTEX( mResponseMutex );
-
-            for( ResponseQueue::iterator i = mResponseQueue.begin(); i != mResponseQueue.end(); ++i )
-            {
-                ( *i )->abortRequest();
-            }
-        }
+        publishResponseAbort( OGRE_NEW ResponseAbort( ResponseAbort::All, 0u, 0u ) );
     }
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::setPaused( bool pause )
     {
-        OGRE_LOCK_MUTEX( mRequestMutex );
+        OGRE_LOCK_REQUEST_MUTEX;
 
         mPaused = pause;
     }
@@ -462,7 +927,7 @@ namespace Ogre
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::setRequestsAccepted( bool accept )
     {
-        OGRE_LOCK_MUTEX( mRequestMutex );
+        OGRE_LOCK_REQUEST_MUTEX;
 
         mAcceptRequests = accept;
     }
@@ -481,14 +946,12 @@ namespace Ogre
             // scoped to only lock while retrieving the next request
             OGRE_LOCK_MUTEX( mProcessMutex );
             {
-                OGRE_LOCK_MUTEX( mRequestMutex );
+                OGRE_LOCK_REQUEST_MUTEX;
+                drainRequestRings();
 
-                if( !mRequestQueue.empty() )
-                {
-                    request = mRequestQueue.front();
-                    mRequestQueue.pop_front();
+                request = dequeueNextRequest();
+                if( request )
                     mProcessQueue.push_back( request );
-                }
             }
         }
 
@@ -526,7 +989,8 @@ namespace Ogre
                 if( req->getRetryCount() )
                 {
                     addRequestWithRID( req->getID(), req->getChannel(), req->getType(), req->getData(),
-                                       req->getRetryCount() - 1 );
+                                       req->getRetryCount() - 1, req->getPriority(),
+                                       req->getDeadline() );
                     // discard response (this also deletes request)
                     OGRE_DELETE response;
                     return;
@@ -544,10 +1008,8 @@ namespace Ogre
                     // destroy response user data
                     response->abortRequest();
                 }
-                // Queue response
-                OGRE_LOCK_MUTEX( mResponseMutex );
-                mResponseQueue.push_back( response );
-                // no need to wake thread, this is processed by the main thread
+                // Queue response. No need to wake thread, this is processed by the main thread
+                publishResponse( response );
             }
         }
         else
@@ -567,70 +1029,108 @@ namespace Ogre
     {
         const uint64 msStart = Root::getSingleton().getTimer()->getMilliseconds();
         uint64 msCurrent = 0;
+        bool outOfTime = false;
+
+        // Take all the responses at once. Only the main thread touches the queues, thus
+        // no lock is needed; workers & abort*() calls publish to lock-free lists instead.
+        applyResponseAborts();
+        sortResponsesByPriority( mResponseQueue, 0u );
+        if( mResponseBatch.empty() )
+        {
+            mResponseBatch.swap( mResponseQueue );
+        }
+        else
+        {
+            // We're being called from a ResponseHandler (or one threw last time). Carry
+            // on with the same batch plus the new responses, merged by priority so the
+            // time limit doesn't cut off urgent new responses behind older ones
+            mResponseBatch.insert( mResponseBatch.end(), mResponseQueue.begin(),
+                                   mResponseQueue.end() );
+            mResponseQueue.clear();
+            sortResponsesByPriority( mResponseBatch, mNextBatchResponse );
+        }
+
+        ResponseProcessingScope processingScope( mResponseProcessingDepth );
 
         // keep going until we run out of responses or out of time
-        while( true )
+        while( mNextBatchResponse < mResponseBatch.size() )
         {
-            Response *response = 0;
-            {
-                OGRE_LOCK_MUTEX( mResponseMutex );
+            // A ResponseHandler (or another thread) may have aborted requests
+            if( mPublishedResponseAborts.load( std::memory_order_relaxed ) )
+                applyResponseAborts();
 
-                if( mResponseQueue.empty() )
-                    break;  // exit loop
-                else
-                {
-                    response = mResponseQueue.front();
-                    mResponseQueue.pop_front();
-                }
-            }
+            Response *response = mResponseBatch[mNextBatchResponse];
+            // Once out of time, only urgent responses get through. They're sorted first
+            if( outOfTime && response->getRequest()->getPriority() < mUrgentResponsePriority )
+                break;
 
-            if( response )
-            {
-                processResponse( response );
+            ++mNextBatchResponse;
 
-                OGRE_DELETE response;
-            }
+            if( response->getRequest()->getAborted() )
+                response->abortRequest();
+
+            processResponse( response );
 
             // time limit
-            if( mResposeTimeLimitMS )
+            if( mResposeTimeLimitMS && !outOfTime )
             {
                 msCurrent = Root::getSingleton().getTimer()->getMilliseconds();
-                if( msCurrent - msStart > mResposeTimeLimitMS )
-                    break;
+                outOfTime = msCurrent - msStart > mResposeTimeLimitMS;
             }
         }
+
+        if( mResponseProcessingDepth == 1u )
+        {
+            // Processed responses are deleted here rather than one by one, as an outer
+            // call may still be using them if we were called from a ResponseHandler.
+            const ptrdiff_t numProcessed = static_cast<ptrdiff_t>( mNextBatchResponse );
+            for( ptrdiff_t i = 0; i < numProcessed; ++i )
+                OGRE_DELETE mResponseBatch[static_cast<size_t>( i )];
+
+            // The ones we ran out of time for go back, ahead of any newer ones
+            mResponseQueue.insert( mResponseQueue.begin(), mResponseBatch.begin() + numProcessed,
+                                   mResponseBatch.end() );
+            mResponseBatch.clear();
+            mNextBatchResponse = 0u;
+        }
     }
     //---------------------------------------------------------------------
     WorkQueue::Response *DefaultWorkQueueBase::processRequest( Request *r )
     {
-        RequestHandlerListByChannel handlerListCopy;
+        RequestHandlerListByChannelPtr handlerListRef;
         {
-            // lock the list only to make a copy of it, to maximise parallelism
+            // lock the list only to grab a reference to it, to maximise parallelism
             OGRE_LOCK_RW_MUTEX_READ( mRequestHandlerMutex );
 
-            handlerListCopy = mRequestHandlers;
+            handlerListRef = mRequestHandlers;
         }
 
         Response *response = 0;
 
+        const bool traceLog = isTraceLogEnabled();
         StringStream dbgMsg;
-        dbgMsg <<
+        if( traceLog )
+        {
+            dbgMsg <<
 #if OGRE_THREAD_SUPPORT
-            OGRE_THREAD_CURRENT_ID
+                OGRE_THREAD_CURRENT_ID
 #else
-            "main"
+                "main"
 #endif
-               << "): ID=" << r->getID() << " channel=" << r->getChannel()
-               << " requestType=" << r->getType();
+                   << "): ID=" << r->getID() << " channel=" << r->getChannel()
+                   << " requestType=" << r->getType();
 
-        LogManager::getSingleton().stream( LML_TRIVIAL )
-            << "DefaultWorkQueueBase('" << mName << "') - PROCESS_REQUEST_START(" << dbgMsg.str();
+            LogManager::getSingleton().stream( LML_TRIVIAL )
+                << "DefaultWorkQueueBase('" << mName << "') - PROCESS_REQUEST_START("
+                << dbgMsg.str();
+        }
 
-        RequestHandlerListByChannel::iterator i = handlerListCopy.find( r->getChannel() );
-        if( i != handlerListCopy.end() )
+        RequestHandlerListByChannel::const_iterator i = handlerListRef->find( r->getChannel() );
+        if( i != handlerListRef->end() )
         {
-            RequestHandlerList &handlers = i->second;
-            for( RequestHandlerList::reverse_iterator j = handlers.rbegin(); j != handlers.rend(); ++j )
+            const RequestHandlerList &handlers = i->second;
+            for( RequestHandlerList::const_reverse_iterator j = handlers.rbegin();
+                 j != handlers.rend(); ++j )
             {
                 // threadsafe call which tests canHandleRequest and calls it if so
                 response = ( *j )->handleRequest( r, this );
@@ -640,28 +1140,38 @@ namespace Ogre
             }
         }
 
-        LogManager::getSingleton().stream( LML_TRIVIAL )
-            << "DefaultWorkQueueBase('" << mName << "') - PROCESS_REQUEST_END(" << dbgMsg.str()
-            << " processed=" << ( response != 0 );
+        if( traceLog )
+        {
+            LogManager::getSingleton().stream( LML_TRIVIAL )
+                << "DefaultWorkQueueBase('" << mName << "') - PROCESS_REQUEST_END(" << dbgMsg.str()
+                << " processed=" << ( response != 0 );
+        }
 
         return response;
     }
     //---------------------------------------------------------------------
     void DefaultWorkQueueBase::processResponse( Response *r )
     {
+        mNumResponses.fetch_add( 1u, std::memory_order_relaxed );
+
+        const bool traceLog = isTraceLogEnabled();
         StringStream dbgMsg;
-        dbgMsg << "thread:" <<
+        if( traceLog )
+        {
+            dbgMsg << "thread:" <<
 #if OGRE_THREAD_SUPPORT
-            OGRE_THREAD_CURRENT_ID
+                OGRE_THREAD_CURRENT_ID
 #else
-            "main"
+                "main"
 #endif
-               << "): ID=" << r->getRequest()->getID() << " success=" << r->succeeded() << " messages=["
-               << r->getMessages() << "] channel=" << r->getRequest()->getChannel()
-               << " requestType=" << r->getRequest()->getType();
+                   << "): ID=" << r->getRequest()->getID() << " success=" << r->succeeded()
+                   << " messages=[" << r->getMessages() << "] channel=" << r->getRequest()->getChannel()
+                   << " requestType=" << r->getRequest()->getType();
 
-        LogManager::getSingleton().stream( LML_TRIVIAL )
-            << "DefaultWorkQueueBase('" << mName << "') - PROCESS_RESPONSE_START(" << dbgMsg.str();
+            LogManager::getSingleton().stream( LML_TRIVIAL )
+                << "DefaultWorkQueueBase('" << mName << "') - PROCESS_RESPONSE_START("
+                << dbgMsg.str();
+        }
 
         ResponseHandlerListByChannel::iterator i =
             mResponseHandlers.find( r->getRequest()->getChannel() );
@@ -676,10 +1186,129 @@ namespace Ogre
                 }
             }
         }
-        LogManager::getSingleton().stream( LML_TRIVIAL )
-            << "DefaultWorkQueueBase('" << mName << "') - PROCESS_RESPONSE_END(" << dbgMsg.str();
+
+        if( traceLog )
+        {
+            LogManager::getSingleton().stream( LML_TRIVIAL )
+                << "DefaultWorkQueueBase('" << mName << "') - PROCESS_RESPONSE_END(" << dbgMsg.str();
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::publishResponse( Response *r )
+    {
+        r->mNext = mPublishedResponses.load( std::memory_order_relaxed );
+        while( !mPublishedResponses.compare_exchange_weak( r->mNext, r, std::memory_order_release,
+                                                           std::memory_order_relaxed ) )
+        {
+            mNumResponsePushRetries.fetch_add( 1u, std::memory_order_relaxed );
+        }
     }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::drainPublishedResponses()
+    {
+        Response *r = mPublishedResponses.exchange( 0, std::memory_order_acquire );
 
+        // The list is newest first. Reverse it to keep the order they were published in
+        Response *oldestFirst = 0;
+        while( r )
+        {
+            Response *next = r->mNext;
+            r->mNext = oldestFirst;
+            oldestFirst = r;
+            r = next;
+        }
+
+        while( oldestFirst )
+        {
+            Response *next = oldestFirst->mNext;
+            oldestFirst->mNext = 0;
+            mResponseQueue.push_back( oldestFirst );
+            oldestFirst = next;
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::publishResponseAbort( ResponseAbort *abort )
+    {
+        abort->mNext = mPublishedResponseAborts.load( std::memory_order_relaxed );
+        while( !mPublishedResponseAborts.compare_exchange_weak(
+            abort->mNext, abort, std::memory_order_release, std::memory_order_relaxed ) )
+        {
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::applyResponseAborts()
+    {
+        ResponseAbort *aborts = mPublishedResponseAborts.exchange( 0, std::memory_order_acquire );
+        drainPublishedResponses();
+
+        while( aborts )
+        {
+            for( ResponseQueue::const_iterator i = mResponseQueue.begin(); i != mResponseQueue.end();
+                 ++i )
+            {
+                if( aborts->matches( ( *i )->getRequest() ) )
+                    ( *i )->getRequest()->abortRequest();
+            }
+
+            // processResponses may be going through these right now. Only raise the
+            // flag; it discards their data before handing them to the handlers
+            for( ResponseQueue::const_iterator i = mResponseBatch.begin(); i != mResponseBatch.end();
+                 ++i )
+            {
+                if( aborts->matches( ( *i )->getRequest() ) )
+                    ( *i )->getRequest()->abortRequest();
+            }
+
+            ResponseAbort *next = aborts->mNext;
+            OGRE_DELETE aborts;
+            aborts = next;
+        }
+    }
+    //---------------------------------------------------------------------
+    struct ResponsePriorityOrder
+    {
+        bool operator()( const WorkQueue::Response *a, const WorkQueue::Response *b ) const
+        {
+            return a->getRequest()->getPriority() > b->getRequest()->getPriority();
+        }
+    };
+    void DefaultWorkQueueBase::sortResponsesByPriority( ResponseQueue &responses, size_t first )
+    {
+        // Stable: responses with the same priority keep the order they were published in
+        std::stable_sort( responses.begin() + static_cast<ptrdiff_t>( first ), responses.end(),
+                          ResponsePriorityOrder() );
+    }
+    //---------------------------------------------------------------------
+    bool DefaultWorkQueueBase::isTraceLogEnabled()
+    {
+        const Log *log = LogManager::getSingleton().getDefaultLog();
+        return log && ( log->getLogDetail() + uint32( LML_TRIVIAL ) ) >= OGRE_LOG_THRESHOLD;
+    }
+    //---------------------------------------------------------------------
+    DefaultWorkQueueBase::Statistics DefaultWorkQueueBase::getStatistics() const
+    {
+        Statistics retVal;
+        retVal.numRequests = mNumRequests.load( std::memory_order_relaxed );
+        retVal.numResponses = mNumResponses.load( std::memory_order_relaxed );
+        retVal.numResponsePushRetries = mNumResponsePushRetries.load( std::memory_order_relaxed );
+        retVal.numRequestHandlerUpdates = mNumRequestHandlerUpdates.load( std::memory_order_relaxed );
+        retVal.numRequestLockContentions = mNumRequestLockContentions.load( std::memory_order_relaxed );
+        retVal.numRequestPushRetries = mNumRequestPushRetries.load( std::memory_order_relaxed );
+        retVal.numRequestRingOverflows = mNumRequestRingOverflows.load( std::memory_order_relaxed );
+        return retVal;
+    }
+    //---------------------------------------------------------------------
+    void DefaultWorkQueueBase::resetStatistics()
+    {
+        mNumRequests.store( 0u, std::memory_order_relaxed );
+        mNumResponses.store( 0u, std::memory_order_relaxed );
+        mNumResponsePushRetries.store( 0u, std::memory_order_relaxed );
+        mNumRequestHandlerUpdates.store( 0u, std::memory_order_relaxed );
+        mNumRequestLockContentions.store( 0u, std::memory_order_relaxed );
+        mNumRequestPushRetries.store( 0u, std::memory_order_relaxed );
+        mNumRequestRingOverflows.store( 0u, std::memory_order_relaxed );
+    }
+    //---------------------------------------------------------------------
     bool DefaultWorkQueueBase::processIdleRequests()
     {
         {
@@ -142,6 +142,15 @@ namespace Ogre
     //---------------------------------------------------------------------
     void DefaultWorkQueue::notifyWorkers()
     {
+#if OGRE_THREAD_SUPPORT
+        // Requests are added without locking mRequestMutex. If a worker is going to sleep,
+        // lock it anyway: once we own it, that worker is either already waiting, or will
+        // see the new request before it does. See waitForNextRequest
+        if( mNumSleepingWorkers.load() )
+        {
+            OGRE_LOCK_MUTEX( mRequestMutex );
+        }
+#endif
         // wake up waiting thread
         OGRE_THREAD_NOTIFY_ONE( mRequestCondition );
     }
@@ -152,11 +161,15 @@ namespace Ogre
 #if OGRE_THREAD_SUPPORT
         // Lock; note that OGRE_THREAD_WAIT will free the lock
         OGRE_LOCK_MUTEX_NAMED( mRequestMutex, queueLock );
-        if( mRequestQueue.empty() )
+        // Sequentially consistent with pushRequest's count of mNumRingRequests: either
+        // we see its request, or its notifyWorkers sees us
+        mNumSleepingWorkers.fetch_add( 1u );
+        if( mRequestQueue.empty() && mNumRingRequests.load() <= 0 )
         {
             // frees lock and suspends the thread
             OGRE_THREAD_WAIT( mRequestCondition, mRequestMutex, queueLock );
         }
+        mNumSleepingWorkers.fetch_sub( 1u, std::memory_order_relaxed );
         // When we get back here, it's because we've been notified
         // and thus the thread has been woken up. Lock has also been
         // re-acquired, but we won't use it. It's safe to try processing and fail
@@ -0,0 +1,134 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Threading/OgreWorkStealingScheduler.h"
+
+namespace Ogre
+{
+    WorkStealingScheduler::WorkStealingScheduler( size_t numThreads ) :
+        mQueues( 0 ),
+        mNumThreads( std::max<size_t>( numThreads, 1u ) ),
+        mNumChunks( 0 )
+    {
+        static_assert( sizeof( ThreadQueue ) == c_cacheLineSize,
+                       "ThreadQueue must fill exactly one cache line" );
+
+        // new[] only guarantees alignof( ThreadQueue ), which is not enough to keep
+        // each queue in its own cache line.
+        mQueues = reinterpret_cast<ThreadQueue *>( OGRE_MALLOC_ALIGN(
+            sizeof( ThreadQueue ) * mNumThreads, MEMCATEGORY_GENERAL, c_cacheLineSize ) );
+        for( size_t i = 0; i < mNumThreads; ++i )
+        {
+            new( &mQueues[i] ) ThreadQueue();
+            mQueues[i].range.store( 0, std::memory_order_relaxed );
+            mQueues[i].numSteals = 0;
+        }
+    }
+    //-------------------------------------------------------------------------
+    WorkStealingScheduler::~WorkStealingScheduler()
+    {
+        for( size_t i = 0; i < mNumThreads; ++i )
+            mQueues[i].~ThreadQueue();
+        OGRE_FREE_ALIGN( mQueues, MEMCATEGORY_GENERAL, c_cacheLineSize );
+        mQueues = 0;
+    }
+    //-------------------------------------------------------------------------
+    void WorkStealingScheduler::reset( size_t numChunks )
+    {
+        OGRE_ASSERT_LOW( numChunks <= std::numeric_limits<uint32>::max() );
+        mNumChunks = static_cast<uint32>( numChunks );
+
+        const uint32 chunksPerThread =
+            static_cast<uint32>( ( numChunks + mNumThreads - 1u ) / mNumThreads );
+
+        uint32 begin = 0u;
+        for( size_t i = 0; i < mNumThreads; ++i )
+        {
+            const uint32 end = std::min( begin + chunksPerThread, mNumChunks );
+            mQueues[i].range.store( packRange( begin, end ), std::memory_order_relaxed );
+            mQueues[i].numSteals = 0;
+            begin = end;
+        }
+    }
+    //-------------------------------------------------------------------------
+    bool WorkStealingScheduler::getNextChunk( size_t threadIdx, size_t &outChunkIdx )
+    {
+        OGRE_ASSERT_MEDIUM( threadIdx < mNumThreads );
+
+        // Pop from the front of our own range
+        ThreadQueue &ownQueue = mQueues[threadIdx];
+        uint64 range = ownQueue.range.load( std::memory_order_relaxed );
+        uint32 begin = static_cast<uint32>( range & 0xFFFFFFFFu );
+        uint32 end = static_cast<uint32>( range >> 32u );
+        while( begin < end )
+        {
+            if( ownQueue.range.compare_exchange_weak( range, packRange( begin + 1u, end ),
+                                                      std::memory_order_acq_rel ) )
+            {
+                outChunkIdx = begin;
+                return true;
+            }
+            begin = static_cast<uint32>( range & 0xFFFFFFFFu );
+            end = static_cast<uint32>( range >> 32u );
+        }
+
+        // We're out of work. Steal from the back of other threads' ranges, starting
+        // with our neighbour so that not every thread hits the same victim.
+        for( size_t i = 1u; i < mNumThreads; ++i )
+        {
+            ThreadQueue &victim = mQueues[( threadIdx + i ) % mNumThreads];
+            range = victim.range.load( std::memory_order_relaxed );
+            begin = static_cast<uint32>( range & 0xFFFFFFFFu );
+            end = static_cast<uint32>( range >> 32u );
+            while( begin < end )
+            {
+                if( victim.range.compare_exchange_weak( range, packRange( begin, end - 1u ),
+                                                        std::memory_order_acq_rel ) )
+                {
+                    ++ownQueue.numSteals;
+                    outChunkIdx = end - 1u;
+                    return true;
+                }
+                begin = static_cast<uint32>( range & 0xFFFFFFFFu );
+                end = static_cast<uint32>( range >> 32u );
+            }
+        }
+
+        return false;
+    }
+    //-------------------------------------------------------------------------
+    size_t WorkStealingScheduler::getNumSteals() const
+    {
+        size_t numSteals = 0;
+        for( size_t i = 0; i < mNumThreads; ++i )
+            numSteals += mQueues[i].numSteals;
+        return numSteals;
+    }
+}  // namespace Ogre
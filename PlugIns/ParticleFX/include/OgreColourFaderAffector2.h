@@ -121,6 +121,13 @@ namespace Ogre
         /** See ParticleAffector. */
         void _affectParticles( ParticleSystem *pSystem, Real timeElapsed ) override;
 
+        /** See ParticleAffector. */
+        bool getSupportsSoA() const override { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                  Real timeElapsed ) override;
+
         /** Sets the colour adjustment to be made per second to particles.
         @param red, green, blue, alpha
             Sets the adjustment to be made to each of the colour components per second. These
@@ -57,6 +57,9 @@ namespace Ogre
         /** See ParticleAffector. */
         void _affectParticles( ParticleSystem *pSystem, Real timeElapsed ) override;
 
+        /// Loads the image, as resources can't be loaded from worker threads.
+        void _prepareThreadedUpdate() override;
+
         void   setImageAdjust( String name );
         String getImageAdjust() const;
 
@@ -69,6 +72,10 @@ namespace Ogre
 
         /** Internal method to load the image */
         void _loadImage();
+
+        /// Loads the image if it isn't yet. Must not be called from a worker thread
+        /// (the image must've been loaded by _prepareThreadedUpdate then).
+        void ensureImageLoaded();
     };
 
 }  // namespace Ogre
@@ -80,6 +80,13 @@ namespace Ogre
         /** See ParticleAffector. */
         void _affectParticles( ParticleSystem *pSystem, Real timeElapsed ) override;
 
+        /** See ParticleAffector. */
+        bool getSupportsSoA() const override { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                  Real timeElapsed ) override;
+
         /** Sets the force vector to apply to the particles in a system. */
         void setForceVector( const Vector3 &force );
 
@@ -85,6 +85,13 @@ namespace Ogre
         /** See ParticleAffector. */
         void _affectParticles( ParticleSystem *pSystem, Real timeElapsed ) override;
 
+        /** See ParticleAffector. */
+        bool getSupportsSoA() const override { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                  Real timeElapsed ) override;
+
         /** Sets the minimum rotation speed of particles to be emitted. */
         void setRotationSpeedRangeStart( const Radian &angle );
         /** Sets the maximum rotation speed of particles to be emitted. */
@@ -57,6 +57,13 @@ namespace Ogre
         /** See ParticleAffector. */
         void _affectParticles( ParticleSystem *pSystem, Real timeElapsed ) override;
 
+        /** See ParticleAffector. */
+        bool getSupportsSoA() const override { return true; }
+
+        /** See ParticleAffector. */
+        void _affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                  Real timeElapsed ) override;
+
         /** Sets the scale adjustment to be made per second to particles.
         @param rate
             Sets the adjustment to be made to the x and y scale components per second. These
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "OgreColourFaderAffector.h"
 
 #include "OgreParticle.h"
+#include "OgreParticleSoA.h"
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 
@@ -97,6 +98,30 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void ColourFaderAffector::_affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                                   Real timeElapsed )
+    {
+        const size_t numPacks = particles.getNumPacks();
+
+        // Scale adjustments by time
+        const ArrayReal adjust[4] = { Mathlib::SetAll( mRedAdj * timeElapsed ),
+                                      Mathlib::SetAll( mGreenAdj * timeElapsed ),
+                                      Mathlib::SetAll( mBlueAdj * timeElapsed ),
+                                      Mathlib::SetAll( mAlphaAdj * timeElapsed ) };
+
+        const ArrayReal zero = Mathlib::SetAll( 0.0f );
+        for( size_t c = 0u; c < 4u; ++c )
+        {
+            ArrayReal *RESTRICT_ALIAS colour =
+                particles.getArray( static_cast<ParticleSoA::Attribute>( ParticleSoA::ColourR + c ) );
+            for( size_t i = 0u; i < numPacks; ++i )
+            {
+                // Add, then clamp to [0; 1]
+                colour[i] = Mathlib::Min( Mathlib::Max( colour[i] + adjust[c], zero ), Mathlib::ONE );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void ColourFaderAffector::setAdjust( float red, float green, float blue, float alpha )
     {
         mRedAdj = red;
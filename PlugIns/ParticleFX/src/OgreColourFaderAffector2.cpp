@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "OgreColourFaderAffector2.h"
 
 #include "OgreParticle.h"
+#include "OgreParticleSoA.h"
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 
@@ -159,6 +160,38 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void ColourFaderAffector2::_affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                                    Real timeElapsed )
+    {
+        const size_t numPacks = particles.getNumPacks();
+        const ArrayReal *RESTRICT_ALIAS timeToLive = particles.getArray( ParticleSoA::TimeToLive );
+        const ArrayReal stateChangeVal = Mathlib::SetAll( StateChangeVal );
+
+        // Scale adjustments by time
+        const ArrayReal adjust1[4] = { Mathlib::SetAll( mRedAdj1 * timeElapsed ),
+                                       Mathlib::SetAll( mGreenAdj1 * timeElapsed ),
+                                       Mathlib::SetAll( mBlueAdj1 * timeElapsed ),
+                                       Mathlib::SetAll( mAlphaAdj1 * timeElapsed ) };
+        const ArrayReal adjust2[4] = { Mathlib::SetAll( mRedAdj2 * timeElapsed ),
+                                       Mathlib::SetAll( mGreenAdj2 * timeElapsed ),
+                                       Mathlib::SetAll( mBlueAdj2 * timeElapsed ),
+                                       Mathlib::SetAll( mAlphaAdj2 * timeElapsed ) };
+
+        const ArrayReal zero = Mathlib::SetAll( 0.0f );
+        for( size_t c = 0u; c < 4u; ++c )
+        {
+            ArrayReal *RESTRICT_ALIAS colour =
+                particles.getArray( static_cast<ParticleSoA::Attribute>( ParticleSoA::ColourR + c ) );
+            for( size_t i = 0u; i < numPacks; ++i )
+            {
+                const ArrayReal adjust = Mathlib::Cmov4(
+                    adjust1[c], adjust2[c], Mathlib::CompareGreater( timeToLive[i], stateChangeVal ) );
+                // Add, then clamp to [0; 1]
+                colour[i] = Mathlib::Min( Mathlib::Max( colour[i] + adjust, zero ), Mathlib::ONE );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void ColourFaderAffector2::setAdjust1( float red, float green, float blue, float alpha )
     {
         mRedAdj1 = red;
@@ -58,10 +58,7 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void ColourImageAffector::_initParticle( Particle *pParticle )
     {
-        if( !mColourImageLoaded )
-        {
-            _loadImage();
-        }
+        ensureImageLoaded();
 
         pParticle->mColour = mColourImage.getColourAt( 0, 0, 0 );
     }
@@ -71,10 +68,7 @@ namespace Ogre
         Particle *p;
         ParticleIterator pi = pSystem->_getIterator();
 
-        if( !mColourImageLoaded )
-        {
-            _loadImage();
-        }
+        ensureImageLoaded();
 
         const size_t width = mColourImage.getWidth() - 1u;
 
@@ -121,6 +115,23 @@ namespace Ogre
         mColourImageLoaded = false;
     }
     //-----------------------------------------------------------------------
+    void ColourImageAffector::_prepareThreadedUpdate()
+    {
+        if( !mColourImageLoaded )
+            _loadImage();
+    }
+    //-----------------------------------------------------------------------
+    void ColourImageAffector::ensureImageLoaded()
+    {
+        if( !mColourImageLoaded )
+        {
+            OGRE_ASSERT_LOW( !mParent->_isThreadedUpdatePrepared() &&
+                             "ColourImageAffector: the image must be loaded in "
+                             "_prepareThreadedUpdate before updating from a worker thread" );
+            _loadImage();
+        }
+    }
+    //-----------------------------------------------------------------------
     void ColourImageAffector::_loadImage()
     {
         mColourImage.load( mColourImageName, mParent->getResourceGroupName() );
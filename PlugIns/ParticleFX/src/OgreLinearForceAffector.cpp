@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "OgreLinearForceAffector.h"
 
 #include "OgreParticle.h"
+#include "OgreParticleSoA.h"
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 
@@ -91,6 +92,38 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void LinearForceAffector::_affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                                   Real timeElapsed )
+    {
+        const size_t numPacks = particles.getNumPacks();
+
+        if( mForceApplication == FA_ADD )
+        {
+            // Scale force by time
+            ArrayVector3 scaledVector;
+            scaledVector.setAll( mForceVector * timeElapsed );
+
+            for( size_t i = 0u; i < numPacks; ++i )
+            {
+                ArrayVector3 direction = particles.getVector3( ParticleSoA::DirectionX, i );
+                direction += scaledVector;
+                particles.setVector3( ParticleSoA::DirectionX, i, direction );
+            }
+        }
+        else  // FA_AVERAGE
+        {
+            ArrayVector3 forceVector;
+            forceVector.setAll( mForceVector );
+            const ArrayReal half = Mathlib::SetAll( 0.5f );
+
+            for( size_t i = 0u; i < numPacks; ++i )
+            {
+                const ArrayVector3 direction = particles.getVector3( ParticleSoA::DirectionX, i );
+                particles.setVector3( ParticleSoA::DirectionX, i, ( direction + forceVector ) * half );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void LinearForceAffector::setForceVector( const Vector3 &force ) { mForceVector = force; }
     //-----------------------------------------------------------------------
     void LinearForceAffector::setForceApplication( ForceApplication fa ) { mForceApplication = fa; }
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "OgreRotationAffector.h"
 
 #include "OgreParticle.h"
+#include "OgreParticleSoA.h"
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 
@@ -114,6 +115,26 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void RotationAffector::_affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                                Real timeElapsed )
+    {
+        const size_t numPacks = particles.getNumPacks();
+        if( !numPacks )
+            return;
+
+        // Rotation adjustments by time
+        const ArrayReal ds = Mathlib::SetAll( timeElapsed );
+
+        ArrayReal *RESTRICT_ALIAS rotation = particles.getArray( ParticleSoA::Rotation );
+        const ArrayReal *RESTRICT_ALIAS rotationSpeed =
+            particles.getArray( ParticleSoA::RotationSpeed );
+        for( size_t i = 0u; i < numPacks; ++i )
+            rotation[i] = rotation[i] + ds * rotationSpeed[i];
+
+        // Same as Particle::setRotation
+        pSystem->_notifyParticleRotated();
+    }
+    //-----------------------------------------------------------------------
     const Radian &RotationAffector::getRotationSpeedRangeStart() const
     {
         return mRotationSpeedRangeStart;
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "OgreScaleAffector.h"
 
 #include "OgreParticle.h"
+#include "OgreParticleSoA.h"
 #include "OgreParticleSystem.h"
 #include "OgreStringConverter.h"
 
@@ -84,6 +85,31 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void ScaleAffector::_affectParticlesSoA( ParticleSystem *pSystem, ParticleSoA &particles,
+                                             Real timeElapsed )
+    {
+        const size_t numPacks = particles.getNumPacks();
+        if( !numPacks )
+            return;
+
+        // Scale adjustments by time
+        const ArrayReal ds = Mathlib::SetAll( mScaleAdj * timeElapsed );
+
+        // The particles without their own dimensions hold the default ones, which
+        // is what they have to be scaled from
+        ArrayReal *RESTRICT_ALIAS width = particles.getArray( ParticleSoA::Width );
+        ArrayReal *RESTRICT_ALIAS height = particles.getArray( ParticleSoA::Height );
+        for( size_t i = 0u; i < numPacks; ++i )
+        {
+            width[i] = width[i] + ds;
+            height[i] = height[i] + ds;
+        }
+
+        // Same as Particle::setDimensions
+        particles.setAllOwnDimensions();
+        pSystem->_notifyParticleResized();
+    }
+    //-----------------------------------------------------------------------
     void ScaleAffector::setAdjust( Real rate ) { mScaleAdj = rate; }
     //-----------------------------------------------------------------------
     Real ScaleAffector::getAdjust() const { return mScaleAdj; }
@@ -0,0 +1,320 @@
+
+#include "AnimationCompressionGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreMesh.h"
+#include "OgreMesh2.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshManager2.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include <limits>
+
+#include "Animation/OgreSkeletonAnimation.h"
+#include "Animation/OgreSkeletonDef.h"
+#include "Animation/OgreSkeletonInstance.h"
+#include "Animation/OgreSkeletonManager.h"
+#include "Animation/OgreSkeletonTrack.h"
+
+using namespace Demo;
+
+static const size_t c_numInstances = 1024u;
+static const size_t c_numIterations = 200u;
+
+AnimationCompressionGameState::AnimationCompressionGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription ),
+    mFirstFrame( true )
+{
+}
+//-----------------------------------------------------------------------------------
+void AnimationCompressionGameState::createScene01()
+{
+    TutorialGameState::createScene01();
+
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    v1::MeshPtr v1Mesh = v1::MeshManager::getSingleton().load(
+        "char_reference.mesh", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+        v1::HardwareBuffer::HBU_STATIC, v1::HardwareBuffer::HBU_STATIC );
+    MeshManager::getSingleton().createByImportingV1( "char_reference.mesh",
+                                                     ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+                                                     v1Mesh.get(), true, true, false );
+    v1Mesh->unload();
+
+    SceneNode *rootNode = sceneManager->getRootSceneNode( SCENE_DYNAMIC );
+
+    mAnimations.reserve( c_numInstances );
+
+    for( size_t i = 0; i < c_numInstances; ++i )
+    {
+        Item *item = sceneManager->createItem( "char_reference.mesh",
+                                               ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+                                               SCENE_DYNAMIC );
+        SceneNode *sceneNode = rootNode->createChildSceneNode( SCENE_DYNAMIC );
+        sceneNode->setPosition( Real( i % 32u ) * 2.0f, 0.0f, Real( i / 32u ) * 2.0f );
+        sceneNode->attachObject( item );
+
+        SkeletonInstance *skeletonInstance = item->getSkeletonInstance();
+        skeletonInstance->addAnimationsFromSkeleton(
+            "char_mining.skeleton", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME );
+        SkeletonAnimation *animation = skeletonInstance->getAnimation( "char_mining" );
+        animation->setEnabled( true );
+        // Desync the instances so that they don't all sample the same keyframes
+        animation->setTime( Real( i ) * 0.0137f );
+        mAnimations.push_back( animation );
+    }
+}
+//-----------------------------------------------------------------------------------
+double AnimationCompressionGameState::runBenchmark( size_t numIterations )
+{
+    Ogre::SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    Ogre::Timer timer;
+    Ogre::uint64 totalTime = 0;
+
+    for( size_t i = 0; i < numIterations; ++i )
+    {
+        std::vector<Ogre::SkeletonAnimation *>::const_iterator itor = mAnimations.begin();
+        std::vector<Ogre::SkeletonAnimation *>::const_iterator endt = mAnimations.end();
+        while( itor != endt )
+        {
+            ( *itor )->addTime( 1.0f / 60.0f );
+            ++itor;
+        }
+
+        const Ogre::uint64 startTime = timer.getMicroseconds();
+        sceneManager->updateAllAnimations();
+        totalTime += timer.getMicroseconds() - startTime;
+    }
+
+    return double( totalTime ) / double( numIterations );
+}
+//-----------------------------------------------------------------------------------
+size_t AnimationCompressionGameState::getKeyFrameMemoryUsage() const
+{
+    Ogre::SkeletonDefPtr skeletonDef =
+        Ogre::SkeletonManager::getSingleton().getSkeletonDef( "char_mining.skeleton" );
+
+    size_t memoryUsage = 0;
+    const Ogre::SkeletonAnimationDefVec &animationDefs = skeletonDef->getAnimationDefs();
+    Ogre::SkeletonAnimationDefVec::const_iterator itor = animationDefs.begin();
+    Ogre::SkeletonAnimationDefVec::const_iterator endt = animationDefs.end();
+    while( itor != endt )
+    {
+        memoryUsage += itor->getKeyFrameMemoryUsage();
+        ++itor;
+    }
+
+    return memoryUsage;
+}
+//-----------------------------------------------------------------------------------
+void AnimationCompressionGameState::sampleKeyFrames( const Ogre::SkeletonDef *skeletonDef,
+                                                     KeyFrameSampleVec &outSamples )
+{
+    using namespace Ogre;
+
+    const SkeletonAnimationDefVec &animationDefs = skeletonDef->getAnimationDefs();
+    SkeletonAnimationDefVec::const_iterator itAnim = animationDefs.begin();
+    SkeletonAnimationDefVec::const_iterator enAnim = animationDefs.end();
+    while( itAnim != enAnim )
+    {
+        const SkeletonTrackVec &tracks = itAnim->getTracks();
+        SkeletonTrackVec::const_iterator itTrack = tracks.begin();
+        SkeletonTrackVec::const_iterator enTrack = tracks.end();
+        while( itTrack != enTrack )
+        {
+            const size_t numKeyFrames = itTrack->getKeyFrames().size();
+            for( size_t i = 0; i < numKeyFrames; ++i )
+            {
+                for( size_t slot = 0; slot < itTrack->getUsedSlots(); ++slot )
+                {
+                    KeyFrameSample sample;
+                    itTrack->getKeyFrameTransform( i, slot, sample.position, sample.orientation,
+                                                   sample.scale );
+                    outSamples.push_back( sample );
+                }
+            }
+            ++itTrack;
+        }
+        ++itAnim;
+    }
+}
+//-----------------------------------------------------------------------------------
+size_t AnimationCompressionGameState::checkCompressionError(
+    const Ogre::SkeletonDef *skeletonDef, const KeyFrameSampleVec &originalSamples )
+{
+    using namespace Ogre;
+
+    KeyFrameSampleVec compressedSamples;
+    sampleKeyFrames( skeletonDef, compressedSamples );
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    if( compressedSamples.size() != originalSamples.size() )
+    {
+        logManager.logMessage( "Compressed tracks have " +
+                               StringConverter::toString( compressedSamples.size() ) +
+                               " keyframe samples, expected " +
+                               StringConverter::toString( originalSamples.size() ) );
+        return 1u;
+    }
+
+    // Positions & scales are rounded to 1 / 65534th of their range within the track, and
+    // orientation components to 1 / 65534; although renormalising the orientation moves
+    // them a bit further. The slack covers the constant channel threshold
+    // used by compressAnimations, and float rounding
+    const Real c_slack = 2e-5f;
+    const Real c_orientationTolerance = 2.0f / 32767.0f + c_slack;
+
+    size_t numFailures = 0u;
+    Real maxPositionError = 0;
+    Real maxOrientationError = 0;
+    Real maxScaleError = 0;
+
+    size_t sampleIdx = 0u;
+
+    const SkeletonAnimationDefVec &animationDefs = skeletonDef->getAnimationDefs();
+    SkeletonAnimationDefVec::const_iterator itAnim = animationDefs.begin();
+    SkeletonAnimationDefVec::const_iterator enAnim = animationDefs.end();
+    while( itAnim != enAnim )
+    {
+        const SkeletonTrackVec &tracks = itAnim->getTracks();
+        for( size_t trackIdx = 0; trackIdx < tracks.size(); ++trackIdx )
+        {
+            const SkeletonTrack &track = tracks[trackIdx];
+            const size_t numSamples = track.getKeyFrames().size() * track.getUsedSlots();
+
+            if( !track.isCompressed() )
+            {
+                logManager.logMessage( itAnim->getNameStr() + " track " +
+                                       StringConverter::toString( trackIdx ) +
+                                       " was not compressed" );
+                ++numFailures;
+            }
+
+            // The range of each channel within the track determines the quantisation step
+            Vector3 posMin( std::numeric_limits<Real>::max() ), posMax( -posMin );
+            Vector3 scaleMin( posMin ), scaleMax( posMax );
+            for( size_t i = sampleIdx; i < sampleIdx + numSamples; ++i )
+            {
+                posMin.makeFloor( originalSamples[i].position );
+                posMax.makeCeil( originalSamples[i].position );
+                scaleMin.makeFloor( originalSamples[i].scale );
+                scaleMax.makeCeil( originalSamples[i].scale );
+            }
+
+            Vector3 posError( Vector3::ZERO ), scaleError( Vector3::ZERO );
+            Real orientationError = 0;
+            for( size_t i = sampleIdx; i < sampleIdx + numSamples; ++i )
+            {
+                const KeyFrameSample &original = originalSamples[i];
+                const KeyFrameSample &compressed = compressedSamples[i];
+
+                Vector3 diff = compressed.position - original.position;
+                diff.makeAbs();
+                posError.makeCeil( diff );
+                diff = compressed.scale - original.scale;
+                diff.makeAbs();
+                scaleError.makeCeil( diff );
+
+                // q and -q are the same rotation
+                const Real sign = original.orientation.Dot( compressed.orientation ) < 0 ? -1 : 1;
+                for( size_t j = 0; j < 4u; ++j )
+                {
+                    orientationError = std::max(
+                        orientationError,
+                        Math::Abs( compressed.orientation[j] * sign - original.orientation[j] ) );
+                }
+            }
+
+            const Vector3 posTolerance = ( posMax - posMin ) * ( 0.5f / 32767.0f ) + c_slack;
+            const Vector3 scaleTolerance = ( scaleMax - scaleMin ) * ( 0.5f / 32767.0f ) + c_slack;
+
+            // Vector3::operator< is true only if all components are smaller
+            if( !( posError < posTolerance ) || !( scaleError < scaleTolerance ) ||
+                orientationError > c_orientationTolerance )
+            {
+                logManager.logMessage(
+                    itAnim->getNameStr() + " track " + StringConverter::toString( trackIdx ) +
+                    ": error too large. Position " + StringConverter::toString( posError ) +
+                    " (max " + StringConverter::toString( posTolerance ) + "), orientation " +
+                    StringConverter::toString( orientationError ) + ", scale " +
+                    StringConverter::toString( scaleError ) + " (max " +
+                    StringConverter::toString( scaleTolerance ) + ")" );
+                ++numFailures;
+            }
+
+            maxPositionError = std::max( maxPositionError, posError.collapseMax() );
+            maxOrientationError = std::max( maxOrientationError, orientationError );
+            maxScaleError = std::max( maxScaleError, scaleError.collapseMax() );
+
+            sampleIdx += numSamples;
+        }
+        ++itAnim;
+    }
+
+    logManager.logMessage( "Largest compression error. Position: " +
+                           StringConverter::toString( maxPositionError ) +
+                           " orientation: " + StringConverter::toString( maxOrientationError ) +
+                           " scale: " + StringConverter::toString( maxScaleError ) );
+
+    return numFailures;
+}
+//-----------------------------------------------------------------------------------
+void AnimationCompressionGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    if( mFirstFrame )
+    {
+        // SceneManager::updateAllAnimations needs the list of
+        // SkeletonAnimManagers to update, which gets built after rendering.
+        mFirstFrame = false;
+        return;
+    }
+
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    // Warm up the caches
+    runBenchmark( 10u );
+
+    const size_t uncompressedMemory = getKeyFrameMemoryUsage();
+    const double uncompressedTime = runBenchmark( c_numIterations );
+
+    SkeletonDefPtr skeletonDef =
+        SkeletonManager::getSingleton().getSkeletonDef( "char_mining.skeleton" );
+
+    KeyFrameSampleVec originalSamples;
+    sampleKeyFrames( skeletonDef.get(), originalSamples );
+
+    skeletonDef->compressAnimations();
+
+    const size_t numFailures = checkCompressionError( skeletonDef.get(), originalSamples );
+
+    runBenchmark( 10u );
+
+    const size_t compressedMemory = getKeyFrameMemoryUsage();
+    const double compressedTime = runBenchmark( c_numIterations );
+
+    logManager.logMessage( "Animation compression benchmark. Instances: " +
+                           StringConverter::toString( c_numInstances ) );
+    logManager.logMessage( "Uncompressed: " + StringConverter::toString( uncompressedMemory ) +
+                           " bytes; " + StringConverter::toString( Real( uncompressedTime ) ) +
+                           " us per update" );
+    logManager.logMessage( "Compressed: " + StringConverter::toString( compressedMemory ) +
+                           " bytes; " + StringConverter::toString( Real( compressedTime ) ) +
+                           " us per update" );
+
+    OGRE_ASSERT( numFailures == 0u && "Compressed keyframes are too far from the original ones" );
+
+    mGraphicsSystem->setQuit();
+}
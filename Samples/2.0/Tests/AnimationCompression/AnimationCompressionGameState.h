@@ -0,0 +1,60 @@
+
+#ifndef Demo_AnimationCompressionGameState_H
+#define Demo_AnimationCompressionGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgreQuaternion.h"
+#include "OgreVector3.h"
+
+#include "TutorialGameState.h"
+
+#include <vector>
+
+namespace Ogre
+{
+    class SkeletonAnimation;
+}
+
+namespace Demo
+{
+    class AnimationCompressionGameState : public TutorialGameState
+    {
+        struct KeyFrameSample
+        {
+            Ogre::Vector3    position;
+            Ogre::Quaternion orientation;
+            Ogre::Vector3    scale;
+        };
+        typedef std::vector<KeyFrameSample> KeyFrameSampleVec;
+
+        std::vector<Ogre::SkeletonAnimation *> mAnimations;
+        /// We need at least one frame rendered before we can call updateAllAnimations
+        bool mFirstFrame;
+
+        /// Returns the average time in microseconds per updateAllAnimations call
+        double runBenchmark( size_t numIterations );
+        size_t getKeyFrameMemoryUsage() const;
+
+        /// Calls SkeletonTrack::getKeyFrameTransform for every used slot of every keyframe
+        /// of every track, and appends the results in that order.
+        static void sampleKeyFrames( const Ogre::SkeletonDef *skeletonDef,
+                                     KeyFrameSampleVec &outSamples );
+
+        /** Compares the keyframes of the compressed tracks against the ones sampled with
+            sampleKeyFrames before compressing, and logs the largest errors.
+        @return
+            The number of tracks whose error exceeds what the quantisation allows.
+        */
+        static size_t checkCompressionError( const Ogre::SkeletonDef *skeletonDef,
+                                             const KeyFrameSampleVec &originalSamples );
+
+    public:
+        AnimationCompressionGameState( const Ogre::String &helpDescription );
+
+        void createScene01() override;
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
@@ -0,0 +1,56 @@
+
+#include "BlockCompressionGameState.h"
+#include "GraphicsSystem.h"
+
+// Declares WinMain / main
+#include "MainEntryPointHelper.h"
+#include "System/MainEntryPoints.h"
+
+#if OGRE_PLATFORM != OGRE_PLATFORM_ANDROID
+#    if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+INT WINAPI WinMainApp( HINSTANCE hInst, HINSTANCE hPrevInstance, LPSTR strCmdLine, INT nCmdShow )
+#    else
+int mainApp( int argc, const char *argv[] )
+#    endif
+{
+    return Demo::MainEntryPoints::mainAppSingleThreaded( DEMO_MAIN_ENTRY_PARAMS );
+}
+#endif
+
+namespace Demo
+{
+    class BlockCompression final : public GraphicsSystem
+    {
+    public:
+        BlockCompression( GameState *gameState ) : GraphicsSystem( gameState )
+        {
+            mAlwaysAskForConfig = false;
+        }
+    };
+
+    void MainEntryPoints::createSystems( GameState **outGraphicsGameState,
+                                         GraphicsSystem **outGraphicsSystem,
+                                         GameState **outLogicGameState, LogicSystem **outLogicSystem )
+    {
+        BlockCompressionGameState *gfxGameState = new BlockCompressionGameState(
+            "Compresses synthetic images to BC1/3/4/5/7 with BlockCompressor, decodes\n"
+            "them back and checks the error stays within bounds.\n"
+            "Results are written to Ogre.log" );
+
+        GraphicsSystem *graphicsSystem = new BlockCompression( gfxGameState );
+
+        gfxGameState->_notifyGraphicsSystem( graphicsSystem );
+
+        *outGraphicsGameState = gfxGameState;
+        *outGraphicsSystem = graphicsSystem;
+    }
+
+    void MainEntryPoints::destroySystems( GameState *graphicsGameState, GraphicsSystem *graphicsSystem,
+                                          GameState *logicGameState, LogicSystem *logicSystem )
+    {
+        delete graphicsSystem;
+        delete graphicsGameState;
+    }
+
+    const char *MainEntryPoints::getWindowTitle() { return "Block Compression Test"; }
+}  // namespace Demo
@@ -0,0 +1,410 @@
+
+#include "BlockCompressionGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreBlockCompressor.h"
+#include "OgreLogManager.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+
+#include "ogrestd/vector.h"
+
+#include <math.h>
+
+using namespace Demo;
+
+namespace
+{
+    /// Decodes the 4 colour palette of a BC1 block (or the colour half of a BC3 block).
+    /// BC3 always uses 4-colour mode. BC1 uses 3 colours + transparent black when
+    /// colour0 <= colour1.
+    void decodeColourBlock( const Ogre::uint8 *block, bool bForce4Colours, Ogre::uint8 outRgba[16 * 4] )
+    {
+        using namespace Ogre;
+
+        const uint16 colours[2] = { static_cast<uint16>( block[0] | ( block[1] << 8u ) ),
+                                    static_cast<uint16>( block[2] | ( block[3] << 8u ) ) };
+
+        int palette[4][4];
+        for( size_t i = 0; i < 2u; ++i )
+        {
+            const int r = ( colours[i] >> 11u ) & 0x1F;
+            const int g = ( colours[i] >> 5u ) & 0x3F;
+            const int b = colours[i] & 0x1F;
+            palette[i][0] = ( r << 3 ) | ( r >> 2 );
+            palette[i][1] = ( g << 2 ) | ( g >> 4 );
+            palette[i][2] = ( b << 3 ) | ( b >> 2 );
+            palette[i][3] = 255;
+        }
+
+        if( bForce4Colours || colours[0] > colours[1] )
+        {
+            for( size_t c = 0; c < 3u; ++c )
+            {
+                palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+                palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 255;
+        }
+        else
+        {
+            for( size_t c = 0; c < 3u; ++c )
+            {
+                palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2;
+                palette[3][c] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+
+        const uint32 indices = uint32( block[4] ) | ( uint32( block[5] ) << 8u ) |
+                               ( uint32( block[6] ) << 16u ) | ( uint32( block[7] ) << 24u );
+        for( size_t i = 0; i < 16u; ++i )
+        {
+            const uint32 idx = ( indices >> ( i * 2u ) ) & 0x03u;
+            for( size_t c = 0; c < 4u; ++c )
+                outRgba[i * 4u + c] = static_cast<uint8>( palette[idx][c] );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    /// Decodes a BC4 block (also BC3's alpha & each half of BC5), unsigned or signed
+    void decodeSingleChannelBlock( const Ogre::uint8 *block, bool bSigned, int outValues[16] )
+    {
+        using namespace Ogre;
+
+        int palette[8];
+        palette[0] = bSigned ? std::max<int>( int8( block[0] ), -127 ) : block[0];
+        palette[1] = bSigned ? std::max<int>( int8( block[1] ), -127 ) : block[1];
+
+        if( palette[0] > palette[1] )
+        {
+            for( int i = 1; i < 7; ++i )
+                palette[i + 1] = ( ( 7 - i ) * palette[0] + i * palette[1] ) / 7;
+        }
+        else
+        {
+            for( int i = 1; i < 5; ++i )
+                palette[i + 1] = ( ( 5 - i ) * palette[0] + i * palette[1] ) / 5;
+            palette[6] = bSigned ? -127 : 0;
+            palette[7] = bSigned ? 127 : 255;
+        }
+
+        uint64 indices = 0u;
+        for( size_t i = 0; i < 6u; ++i )
+            indices |= uint64( block[2u + i] ) << ( i * 8u );
+        for( size_t i = 0; i < 16u; ++i )
+            outValues[i] = palette[( indices >> ( i * 3u ) ) & 0x07u];
+    }
+    //-----------------------------------------------------------------------------------
+    /// Decodes a BC7 block. Only mode 6 is supported, as it's the only one
+    /// BlockCompressor writes. Returns false for any other mode.
+    bool decodeBc7Block( const Ogre::uint8 *block, Ogre::uint8 outRgba[16 * 4] )
+    {
+        using namespace Ogre;
+
+        size_t bitPos = 0u;
+        struct BitReader
+        {
+            static uint32 read( const uint8 *data, size_t &bitPos, uint32 numBits )
+            {
+                uint32 value = 0u;
+                for( uint32 i = 0u; i < numBits; ++i )
+                {
+                    value |= uint32( ( data[bitPos >> 3u] >> ( bitPos & 0x07u ) ) & 0x01u ) << i;
+                    ++bitPos;
+                }
+                return value;
+            }
+        };
+
+        if( BitReader::read( block, bitPos, 7u ) != ( 1u << 6u ) )
+            return false;
+
+        int endPoints[2][4];
+        for( size_t c = 0; c < 4u; ++c )
+        {
+            endPoints[0][c] = int( BitReader::read( block, bitPos, 7u ) );
+            endPoints[1][c] = int( BitReader::read( block, bitPos, 7u ) );
+        }
+        for( size_t e = 0; e < 2u; ++e )
+        {
+            const int pBit = int( BitReader::read( block, bitPos, 1u ) );
+            for( size_t c = 0; c < 4u; ++c )
+                endPoints[e][c] = ( endPoints[e][c] << 1 ) | pBit;
+        }
+
+        const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        for( size_t i = 0; i < 16u; ++i )
+        {
+            // The most significant bit of the first index is implicitly 0
+            const int w = weights[BitReader::read( block, bitPos, i == 0u ? 3u : 4u )];
+            for( size_t c = 0; c < 4u; ++c )
+            {
+                outRgba[i * 4u + c] = static_cast<uint8>(
+                    ( ( 64 - w ) * endPoints[0][c] + w * endPoints[1][c] + 32 ) >> 6 );
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    /// Decodes one block into up to 4 values per texel, in the channel order of the
+    /// (RGBA) source. Returns the number of channels, or 0 if the block can't be decoded.
+    size_t decodeBlock( const Ogre::uint8 *block, Ogre::PixelFormatGpu dstFormat, int outTexels[16 * 4] )
+    {
+        using namespace Ogre;
+
+        uint8 rgba[16 * 4];
+        int values[16];
+
+        switch( dstFormat )
+        {
+        case PFG_BC1_UNORM:
+            decodeColourBlock( block, false, rgba );
+            for( size_t i = 0; i < 16u * 4u; ++i )
+                outTexels[i] = rgba[i];
+            // Alpha is ignored by the encoder
+            return 3u;
+        case PFG_BC3_UNORM:
+            decodeColourBlock( block + 8u, true, rgba );
+            decodeSingleChannelBlock( block, false, values );
+            for( size_t i = 0; i < 16u; ++i )
+            {
+                for( size_t c = 0; c < 3u; ++c )
+                    outTexels[i * 4u + c] = rgba[i * 4u + c];
+                outTexels[i * 4u + 3u] = values[i];
+            }
+            return 4u;
+        case PFG_BC4_UNORM:
+        case PFG_BC4_SNORM:
+            decodeSingleChannelBlock( block, dstFormat == PFG_BC4_SNORM, values );
+            for( size_t i = 0; i < 16u; ++i )
+                outTexels[i * 4u] = values[i];
+            return 1u;
+        case PFG_BC5_UNORM:
+        case PFG_BC5_SNORM:
+            for( size_t c = 0; c < 2u; ++c )
+            {
+                decodeSingleChannelBlock( block + c * 8u, dstFormat == PFG_BC5_SNORM, values );
+                for( size_t i = 0; i < 16u; ++i )
+                    outTexels[i * 4u + c] = values[i];
+            }
+            return 2u;
+        case PFG_BC7_UNORM:
+            if( !decodeBc7Block( block, rgba ) )
+                return 0u;
+            for( size_t i = 0; i < 16u * 4u; ++i )
+                outTexels[i] = rgba[i];
+            return 4u;
+        default:
+            return 0u;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    /// Returns channel c of pixel (x, y) as an integer. BGRA is read back as RGBA.
+    int readSrcChannel( const Ogre::TextureBox &box, Ogre::PixelFormatGpu srcFormat, Ogre::uint32 x,
+                        Ogre::uint32 y, size_t c )
+    {
+        using namespace Ogre;
+
+        if( srcFormat == PFG_BGRA8_UNORM && c < 3u )
+            c = 2u - c;
+
+        const uint8 *pixel = reinterpret_cast<const uint8 *>( box.at( x, y, 0u ) );
+        if( PixelFormatGpuUtils::isSigned( srcFormat ) )
+            return std::max<int>( reinterpret_cast<const int8 *>( pixel )[c], -127 );
+        return pixel[c];
+    }
+}  // namespace
+
+BlockCompressionGameState::BlockCompressionGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+bool BlockCompressionGameState::runTest( Ogre::PixelFormatGpu srcFormat,
+                                         Ogre::PixelFormatGpu dstFormat, Ogre::uint32 width,
+                                         Ogre::uint32 height, Pattern pattern, float maxRmse,
+                                         int maxError )
+{
+    using namespace Ogre;
+
+    OGRE_ASSERT( BlockCompressor::canCompress( srcFormat, dstFormat ) );
+
+    const size_t numSrcChannels = PixelFormatGpuUtils::getNumberOfComponents( srcFormat );
+    const uint32 srcBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( srcFormat );
+    vector<uint8>::type srcData( width * height * srcBytesPerPixel );
+    TextureBox srcBox( width, height, 1u, 1u, srcBytesPerPixel, width * srcBytesPerPixel,
+                       srcData.size() );
+    srcBox.data = &srcData[0];
+
+    // Reproducible random data
+    uint32 seed = 12345u;
+    for( uint32 y = 0u; y < height; ++y )
+    {
+        for( uint32 x = 0u; x < width; ++x )
+        {
+            uint8 *pixel = reinterpret_cast<uint8 *>( srcBox.at( x, y, 0u ) );
+            for( size_t c = 0; c < numSrcChannels; ++c )
+            {
+                uint8 value;
+                if( pattern == PatternNoise )
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    value = static_cast<uint8>( seed >> 24u );
+                }
+                else
+                {
+                    // A different slope & phase per channel. The frequency is per pixel
+                    // (not per image) so that small images are as smooth as big ones
+                    const float v = 128.0f + 100.0f * sinf( 0.04f * float( x ) +
+                                                            0.03f * float( y * ( c + 1u ) ) +
+                                                            float( c ) );
+                    value = static_cast<uint8>( v + 0.5f );
+                }
+                // Signed formats store the same pattern in [-128; 127]
+                if( PixelFormatGpuUtils::isSigned( srcFormat ) )
+                    value = static_cast<uint8>( value ^ 0x80u );
+                pixel[c] = value;
+            }
+            // BC1 has no alpha
+            if( dstFormat == PFG_BC1_UNORM && numSrcChannels == 4u )
+                pixel[3] = 0xFF;
+        }
+    }
+
+    const uint32 numBlockRows = BlockCompressor::getNumBlockRows( height );
+    const uint32 dstBytesPerRow =
+        static_cast<uint32>( PixelFormatGpuUtils::getSizeBytes( width, 1u, 1u, 1u, dstFormat, 1u ) );
+    const size_t dstBytesPerImage =
+        PixelFormatGpuUtils::getSizeBytes( width, height, 1u, 1u, dstFormat, 1u );
+    const size_t blockSize = PixelFormatGpuUtils::getCompressedBlockSize( dstFormat );
+
+    vector<uint8>::type dstData( dstBytesPerImage );
+    vector<uint8>::type bandedData( dstBytesPerImage );
+    TextureBox dstBox( width, height, 1u, 1u, 0u, dstBytesPerRow, dstBytesPerImage );
+    dstBox.setCompressedPixelFormat( dstFormat );
+    TextureBox bandedBox( dstBox );
+    dstBox.data = &dstData[0];
+    bandedBox.data = &bandedData[0];
+
+    BlockCompressor::compress( srcBox, srcFormat, dstBox, dstFormat, 0u, numBlockRows );
+    // Bands must be independent of each other (the streaming threads rely on it)
+    BlockCompressor::compress( srcBox, srcFormat, bandedBox, dstFormat, 0u, numBlockRows / 2u );
+    BlockCompressor::compress( srcBox, srcFormat, bandedBox, dstFormat, numBlockRows / 2u,
+                               numBlockRows );
+    const bool bBandsMatch = dstData == bandedData;
+
+    // Decode every block and compare the texels inside the image against the source.
+    // Blocks past the edges were padded; those texels are not part of the image.
+    bool bDecoded = true;
+    double sumSqError = 0.0;
+    size_t numSamples = 0u;
+    int worstError = 0;
+    for( uint32 yBlock = 0u; yBlock < numBlockRows && bDecoded; ++yBlock )
+    {
+        for( uint32 xBlock = 0u; xBlock < ( width + 3u ) / 4u && bDecoded; ++xBlock )
+        {
+            const uint8 *block = &dstData[yBlock * dstBytesPerRow + xBlock * blockSize];
+            int texels[16 * 4];
+            const size_t numChannels = decodeBlock( block, dstFormat, texels );
+            bDecoded = numChannels != 0u;
+
+            for( uint32 y = 0u; y < 4u && yBlock * 4u + y < height && bDecoded; ++y )
+            {
+                for( uint32 x = 0u; x < 4u && xBlock * 4u + x < width; ++x )
+                {
+                    for( size_t c = 0; c < numChannels; ++c )
+                    {
+                        const int srcValue =
+                            readSrcChannel( srcBox, srcFormat, xBlock * 4u + x, yBlock * 4u + y, c );
+                        const int error = std::abs( texels[( y * 4u + x ) * 4u + c] - srcValue );
+                        worstError = std::max( worstError, error );
+                        sumSqError += double( error * error );
+                        ++numSamples;
+                    }
+                }
+            }
+        }
+    }
+
+    const float rmse = numSamples ? float( sqrt( sumSqError / double( numSamples ) ) ) : 0.0f;
+    const bool bPassed = bBandsMatch && bDecoded && rmse <= maxRmse && worstError <= maxError;
+
+    LogManager::getSingleton().logMessage(
+        String( PixelFormatGpuUtils::toString( srcFormat ) ) + " -> " +
+        PixelFormatGpuUtils::toString( dstFormat ) + " " + StringConverter::toString( width ) + "x" +
+        StringConverter::toString( height ) + ( pattern == PatternNoise ? " noise" : " smooth" ) +
+        ": RMSE " + StringConverter::toString( rmse ) + " (max " +
+        StringConverter::toString( maxRmse ) + "), max error " +
+        StringConverter::toString( worstError ) + " (max " + StringConverter::toString( maxError ) +
+        ")" + ( bBandsMatch ? "" : " BANDS DIFFER" ) + ( bDecoded ? "" : " UNEXPECTED BLOCK" ) +
+        ( bPassed ? "" : " FAILED" ) );
+
+    return bPassed;
+}
+//-----------------------------------------------------------------------------------
+void BlockCompressionGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    struct FormatDesc
+    {
+        PixelFormatGpu srcFormat;
+        PixelFormatGpu dstFormat;
+        float smoothMaxRmse;
+        int smoothMaxError;
+        float noiseMaxRmse;
+        int noiseMaxError;
+    };
+
+    // The bounds leave some margin over what the encoders currently achieve. With noise
+    // the colour formats can be arbitrarily wrong on some texel, so only their RMSE is
+    // bounded; BC4 & BC5 in 8-value mode are never off by more than 1/14 of 255.
+    const FormatDesc formats[] = {
+        { PFG_RGBA8_UNORM, PFG_BC1_UNORM, 4.0f, 16, 70.0f, 255 },
+        { PFG_BGRA8_UNORM, PFG_BC1_UNORM, 4.0f, 16, 70.0f, 255 },
+        { PFG_RGBA8_UNORM, PFG_BC3_UNORM, 4.0f, 16, 70.0f, 255 },
+        { PFG_R8_UNORM, PFG_BC4_UNORM, 1.5f, 4, 12.0f, 19 },
+        { PFG_R8_SNORM, PFG_BC4_SNORM, 1.5f, 4, 12.0f, 19 },
+        { PFG_RG8_UNORM, PFG_BC5_UNORM, 1.5f, 4, 12.0f, 19 },
+        { PFG_RG8_SNORM, PFG_BC5_SNORM, 1.5f, 4, 12.0f, 19 },
+        { PFG_RGBA8_UNORM, PFG_BC7_UNORM, 2.5f, 8, 70.0f, 255 },
+        { PFG_BGRA8_UNORM, PFG_BC7_UNORM, 2.5f, 8, 70.0f, 255 },
+    };
+
+    // Sizes that aren't multiples of 4 exercise the padding of the edge blocks
+    const uint32 sizes[][2] = {
+        { 64u, 64u }, { 61u, 37u }, { 13u, 7u }, { 5u, 4u }, { 2u, 3u }, { 1u, 1u }, { 1u, 9u },
+    };
+
+    LogManager::getSingleton().logMessage( "Block compression test" );
+
+    size_t numFailures = 0u;
+    for( size_t i = 0; i < sizeof( formats ) / sizeof( formats[0] ); ++i )
+    {
+        for( size_t j = 0; j < sizeof( sizes ) / sizeof( sizes[0] ); ++j )
+        {
+            const FormatDesc &desc = formats[i];
+            if( !runTest( desc.srcFormat, desc.dstFormat, sizes[j][0], sizes[j][1], PatternSmooth,
+                          desc.smoothMaxRmse, desc.smoothMaxError ) )
+            {
+                ++numFailures;
+            }
+            if( !runTest( desc.srcFormat, desc.dstFormat, sizes[j][0], sizes[j][1], PatternNoise,
+                          desc.noiseMaxRmse, desc.noiseMaxError ) )
+            {
+                ++numFailures;
+            }
+        }
+    }
+
+    OGRE_ASSERT( numFailures == 0u && "BlockCompressor error is out of bounds" );
+
+    mGraphicsSystem->setQuit();
+}
@@ -0,0 +1,46 @@
+
+#ifndef Demo_BlockCompressionGameState_H
+#define Demo_BlockCompressionGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class BlockCompressionGameState : public TutorialGameState
+    {
+    public:
+        enum Pattern
+        {
+            /// Gradients that vary slowly inside each block
+            PatternSmooth,
+            /// Every channel of every pixel is random
+            PatternNoise
+        };
+
+    private:
+        /** Compresses a synthetic image with BlockCompressor, decodes it back and checks
+            the error against the source pixels. The image is also compressed in two bands
+            of block rows, which must produce the same blocks.
+        @param maxRmse
+            Maximum root mean square error, in 8-bit units, over all channels the format stores.
+        @param maxError
+            Maximum absolute error of any channel of any pixel.
+        @return
+            False if the bounds are exceeded or the bands differ.
+        */
+        static bool runTest( Ogre::PixelFormatGpu srcFormat, Ogre::PixelFormatGpu dstFormat,
+                             Ogre::uint32 width, Ogre::uint32 height, Pattern pattern,
+                             float maxRmse, int maxError );
+
+    public:
+        BlockCompressionGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
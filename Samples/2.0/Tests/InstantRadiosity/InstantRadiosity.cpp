@@ -0,0 +1,57 @@
+
+#include "InstantRadiosityGameState.h"
+#include "GraphicsSystem.h"
+
+// Declares WinMain / main
+#include "MainEntryPointHelper.h"
+#include "System/MainEntryPoints.h"
+
+#if OGRE_PLATFORM != OGRE_PLATFORM_ANDROID
+#    if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+INT WINAPI WinMainApp( HINSTANCE hInst, HINSTANCE hPrevInstance, LPSTR strCmdLine, INT nCmdShow )
+#    else
+int mainApp( int argc, const char *argv[] )
+#    endif
+{
+    return Demo::MainEntryPoints::mainAppSingleThreaded( DEMO_MAIN_ENTRY_PARAMS );
+}
+#endif
+
+namespace Demo
+{
+    class InstantRadiosityGraphicsSystem final : public GraphicsSystem
+    {
+    public:
+        InstantRadiosityGraphicsSystem( GameState *gameState ) : GraphicsSystem( gameState )
+        {
+            mAlwaysAskForConfig = false;
+        }
+    };
+
+    void MainEntryPoints::createSystems( GameState **outGraphicsGameState,
+                                         GraphicsSystem **outGraphicsSystem,
+                                         GameState **outLogicGameState, LogicSystem **outLogicSystem )
+    {
+        InstantRadiosityGameState *gfxGameState = new InstantRadiosityGameState(
+            "Instant Radiosity test.\n"
+            "Checks the VPLs traced with the triangle BVH match the ones traced\n"
+            "against every triangle, that they do not depend on the number of threads,\n"
+            "and that updateChangedLights gives the same result as building again." );
+
+        GraphicsSystem *graphicsSystem = new InstantRadiosityGraphicsSystem( gfxGameState );
+
+        gfxGameState->_notifyGraphicsSystem( graphicsSystem );
+
+        *outGraphicsGameState = gfxGameState;
+        *outGraphicsSystem = graphicsSystem;
+    }
+
+    void MainEntryPoints::destroySystems( GameState *graphicsGameState, GraphicsSystem *graphicsSystem,
+                                          GameState *logicGameState, LogicSystem *logicSystem )
+    {
+        delete graphicsSystem;
+        delete graphicsGameState;
+    }
+
+    const char *MainEntryPoints::getWindowTitle() { return "Instant Radiosity"; }
+}  // namespace Demo
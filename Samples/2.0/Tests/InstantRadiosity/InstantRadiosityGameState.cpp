@@ -0,0 +1,333 @@
+
+#include "InstantRadiosityGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "InstantRadiosity/OgreInstantRadiosity.h"
+#include "OgreHlms.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsPbsDatablock.h"
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include <algorithm>
+
+using namespace Demo;
+
+static const size_t c_numDatablocks = 3u;
+static const size_t c_numLights = 2u;
+
+namespace
+{
+    struct VplPositionLess
+    {
+        template <typename T>
+        bool operator()( const T &a, const T &b ) const
+        {
+            if( a.position.x != b.position.x )
+                return a.position.x < b.position.x;
+            if( a.position.y != b.position.y )
+                return a.position.y < b.position.y;
+            return a.position.z < b.position.z;
+        }
+    };
+}  // namespace
+
+InstantRadiosityGameState::InstantRadiosityGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+void InstantRadiosityGameState::createTestScene( Ogre::SceneManager *sceneManager,
+                                                 Ogre::Light **outLights )
+{
+    using namespace Ogre;
+
+    SceneNode *rootNode = sceneManager->getRootSceneNode( SCENE_STATIC );
+
+    // Floor, and two walls so that the rays bounce back into the room
+    const Vector3 boxPositions[] = { Vector3( 0.0f, -0.5f, 0.0f ), Vector3( 0.0f, 5.0f, -10.5f ),
+                                     Vector3( -10.5f, 5.0f, 0.0f ) };
+    const Vector3 boxScales[] = { Vector3( 20.0f, 1.0f, 20.0f ), Vector3( 20.0f, 11.0f, 1.0f ),
+                                  Vector3( 1.0f, 11.0f, 20.0f ) };
+
+    for( size_t i = 0; i < sizeof( boxPositions ) / sizeof( boxPositions[0] ); ++i )
+    {
+        Item *item = sceneManager->createItem(
+            "Cube_d.mesh", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, SCENE_STATIC );
+        item->setDatablock( "InstantRadiosity Test 0" );
+        SceneNode *sceneNode = rootNode->createChildSceneNode( SCENE_STATIC );
+        sceneNode->setPosition( boxPositions[i] );
+        sceneNode->setScale( boxScales[i] );
+        sceneNode->attachObject( item );
+    }
+
+    for( size_t i = 0; i < 8u; ++i )
+    {
+        Item *item = sceneManager->createItem( i % 2u ? "Cube_d.mesh" : "Sphere1000.mesh",
+                                               ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+                                               SCENE_STATIC );
+        item->setDatablock( "InstantRadiosity Test " +
+                            StringConverter::toString( 1u + i % ( c_numDatablocks - 1u ) ) );
+        SceneNode *sceneNode = rootNode->createChildSceneNode( SCENE_STATIC );
+        sceneNode->setPosition( ( Real( i % 4u ) - 1.5f ) * 4.0f, 1.0f + Real( i / 4u ) * 1.5f,
+                                ( Real( i / 4u ) - 0.5f ) * 6.0f );
+        sceneNode->setScale( Vector3( 1.5f ) );
+        sceneNode->attachObject( item );
+    }
+
+    rootNode = sceneManager->getRootSceneNode();
+
+    Light *light = sceneManager->createLight();
+    SceneNode *lightNode = rootNode->createChildSceneNode();
+    lightNode->attachObject( light );
+    light->setPowerScale( Math::PI );
+    light->setType( Light::LT_POINT );
+    light->setAttenuation( 23.0f, 0.5f, 0.0f, 0.5f );
+    lightNode->setPosition( 2.0f, 6.0f, 2.0f );
+    outLights[0] = light;
+
+    light = sceneManager->createLight();
+    lightNode = rootNode->createChildSceneNode();
+    lightNode->attachObject( light );
+    light->setDiffuseColour( 0.8f, 0.4f, 0.2f );
+    light->setPowerScale( Math::PI );
+    light->setType( Light::LT_SPOTLIGHT );
+    light->setAttenuation( 23.0f, 0.5f, 0.0f, 0.5f );
+    lightNode->setPosition( -6.0f, 8.0f, 6.0f );
+    light->setDirection( Vector3( 1.0f, -1.0f, -1.0f ).normalisedCopy() );
+    outLights[1] = light;
+}
+//-----------------------------------------------------------------------------------
+Ogre::InstantRadiosity *InstantRadiosityGameState::createInstantRadiosity(
+    Ogre::SceneManager *sceneManager )
+{
+    using namespace Ogre;
+
+    Ogre::InstantRadiosity *instantRadiosity =
+        new Ogre::InstantRadiosity( sceneManager, mGraphicsSystem->getRoot()->getHlmsManager() );
+    // Doesn't create VPL Lights; we only care about the VPLs themselves
+    instantRadiosity->setUseIrradianceVolume( true );
+    instantRadiosity->mNumRays = 1024u;
+    instantRadiosity->mNumRayBounces = 1u;
+    instantRadiosity->mCellSize = 2.0f;
+    return instantRadiosity;
+}
+//-----------------------------------------------------------------------------------
+void InstantRadiosityGameState::getVpls( const Ogre::InstantRadiosity *instantRadiosity,
+                                         VplDataVec &outVpls )
+{
+    const size_t numVpls = instantRadiosity->getNumVpls();
+    outVpls.resize( numVpls );
+    for( size_t i = 0; i < numVpls; ++i )
+    {
+        VplData &vpl = outVpls[i];
+        instantRadiosity->getVpl( i, vpl.position, vpl.normal, vpl.diffuse );
+    }
+}
+//-----------------------------------------------------------------------------------
+void InstantRadiosityGameState::sortVpls( VplDataVec &inOutVpls )
+{
+    std::sort( inOutVpls.begin(), inOutVpls.end(), VplPositionLess() );
+}
+//-----------------------------------------------------------------------------------
+size_t InstantRadiosityGameState::compareVpls( const VplDataVec &a, const VplDataVec &b,
+                                               Ogre::Real tolerance, const char *stage )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    if( a.size() != b.size() )
+    {
+        logManager.logMessage( String( stage ) + ": " + StringConverter::toString( a.size() ) +
+                               " VPLs vs " + StringConverter::toString( b.size() ) );
+        return 1u;
+    }
+
+    size_t numFailures = 0u;
+    for( size_t i = 0; i < a.size(); ++i )
+    {
+        if( !a[i].position.positionEquals( b[i].position, tolerance ) ||
+            !a[i].normal.positionEquals( b[i].normal, tolerance ) ||
+            !a[i].diffuse.positionEquals( b[i].diffuse, tolerance ) )
+        {
+            logManager.logMessage(
+                String( stage ) + ": VPL " + StringConverter::toString( i ) + " differs. Position " +
+                StringConverter::toString( a[i].position ) + " vs " +
+                StringConverter::toString( b[i].position ) + ", diffuse " +
+                StringConverter::toString( a[i].diffuse ) + " vs " +
+                StringConverter::toString( b[i].diffuse ) );
+            ++numFailures;
+        }
+    }
+
+    return numFailures;
+}
+//-----------------------------------------------------------------------------------
+size_t InstantRadiosityGameState::testIncrementalUpdate( Ogre::SceneManager *sceneManager,
+                                                         Ogre::InstantRadiosity *instantRadiosity,
+                                                         Ogre::Light **lights )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    size_t numFailures = 0u;
+
+    instantRadiosity->build();
+
+    if( instantRadiosity->updateChangedLights() != 0u )
+    {
+        logManager.logMessage( "Incremental update: lights were traced again with no changes" );
+        ++numFailures;
+    }
+
+    for( int step = 0; step < 2; ++step )
+    {
+        size_t expectedChanges = 0u;
+        if( step == 0 )
+        {
+            // Move one light and change the colour of the other
+            lights[0]->getParentSceneNode()->setPosition( -3.0f, 5.0f, 4.0f );
+            lights[1]->setDiffuseColour( 0.2f, 0.6f, 0.9f );
+            expectedChanges = 2u;
+        }
+        else
+        {
+            // Replace the spot light. The new one may get the address of the old one,
+            // but it must still be recognised as a different light
+            SceneNode *lightNode = lights[1]->getParentSceneNode();
+            sceneManager->destroyLight( lights[1] );
+
+            Light *light = sceneManager->createLight();
+            lightNode->attachObject( light );
+            light->setPowerScale( Math::PI );
+            light->setType( Light::LT_SPOTLIGHT );
+            light->setAttenuation( 23.0f, 0.5f, 0.0f, 0.5f );
+            light->setDirection( Vector3( -1.0f, -1.0f, -1.0f ).normalisedCopy() );
+            lightNode->setPosition( 6.0f, 8.0f, 6.0f );
+            lights[1] = light;
+            // The removed light plus the new one
+            expectedChanges = 2u;
+        }
+
+        const String stepStr = "Incremental update step " + StringConverter::toString( step );
+
+        const size_t numChanges = instantRadiosity->updateChangedLights();
+        if( numChanges != expectedChanges )
+        {
+            logManager.logMessage( stepStr + ": " + StringConverter::toString( numChanges ) +
+                                   " lights traced again or removed, expected " +
+                                   StringConverter::toString( expectedChanges ) );
+            ++numFailures;
+        }
+
+        VplDataVec incrementalVpls;
+        getVpls( instantRadiosity, incrementalVpls );
+
+        instantRadiosity->build();
+        VplDataVec fullVpls;
+        getVpls( instantRadiosity, fullVpls );
+
+        // Incremental updates append the VPLs they cluster again, thus the order differs
+        sortVpls( incrementalVpls );
+        sortVpls( fullVpls );
+        numFailures += compareVpls( fullVpls, incrementalVpls, 1e-4f, stepStr.c_str() );
+    }
+
+    return numFailures;
+}
+//-----------------------------------------------------------------------------------
+void InstantRadiosityGameState::update( float timeSinceLast )
+{
+    using namespace Ogre;
+
+    Root *root = mGraphicsSystem->getRoot();
+    LogManager &logManager = LogManager::getSingleton();
+
+    Hlms *hlmsPbs = root->getHlmsManager()->getHlms( HLMS_PBS );
+    for( size_t i = 0; i < c_numDatablocks; ++i )
+    {
+        const String datablockName = "InstantRadiosity Test " + StringConverter::toString( i );
+        HlmsPbsDatablock *datablock = static_cast<HlmsPbsDatablock *>( hlmsPbs->createDatablock(
+            datablockName, datablockName, HlmsMacroblock(), HlmsBlendblock(), HlmsParamVec() ) );
+        datablock->setDiffuse( Vector3( 0.2f + Real( i ) * 0.3f, 0.8f - Real( i ) * 0.3f, 0.5f ) );
+    }
+
+    logManager.logMessage( "Instant Radiosity test" );
+
+    // The results must not depend on how the rays got split between the worker threads
+    const size_t threadCounts[] = { 1u, 2u, 4u };
+
+    size_t numFailures = 0u;
+    VplDataVec referenceVpls;
+
+    for( size_t i = 0; i < sizeof( threadCounts ) / sizeof( threadCounts[0] ); ++i )
+    {
+        const String threadsStr = StringConverter::toString( threadCounts[i] ) + " threads";
+
+        SceneManager *sceneManager =
+            root->createSceneManager( ST_GENERIC, threadCounts[i], "InstantRadiosity " + threadsStr );
+        Light *lights[c_numLights];
+        createTestScene( sceneManager, lights );
+
+        Ogre::InstantRadiosity *instantRadiosity = createInstantRadiosity( sceneManager );
+
+        Timer timer;
+        instantRadiosity->build();
+        const uint64 bvhTime = timer.getMicroseconds();
+
+        VplDataVec vpls;
+        getVpls( instantRadiosity, vpls );
+
+        if( vpls.empty() )
+        {
+            logManager.logMessage( threadsStr + ": no VPLs were generated" );
+            ++numFailures;
+        }
+
+        if( i == 0u )
+        {
+            referenceVpls.swap( vpls );
+
+            // Every ray against every triangle. The BVH must find exactly the same hits
+            instantRadiosity->setUseBvh( false );
+            timer.reset();
+            instantRadiosity->build();
+            const uint64 bruteForceTime = timer.getMicroseconds();
+
+            VplDataVec bruteForceVpls;
+            getVpls( instantRadiosity, bruteForceVpls );
+            numFailures += compareVpls( referenceVpls, bruteForceVpls, 0.0f, "BVH vs brute force" );
+
+            logManager.logMessage( StringConverter::toString( referenceVpls.size() ) +
+                                   " VPLs. Build time: " + StringConverter::toString( bvhTime ) +
+                                   "us with the BVH, " + StringConverter::toString( bruteForceTime ) +
+                                   "us brute force" );
+
+            instantRadiosity->setUseBvh( true );
+            numFailures += testIncrementalUpdate( sceneManager, instantRadiosity, lights );
+        }
+        else
+        {
+            numFailures += compareVpls( referenceVpls, vpls, 0.0f, threadsStr.c_str() );
+        }
+
+        delete instantRadiosity;
+        root->destroySceneManager( sceneManager );
+    }
+
+    for( size_t i = 0; i < c_numDatablocks; ++i )
+        hlmsPbs->destroyDatablock( "InstantRadiosity Test " + StringConverter::toString( i ) );
+
+    OGRE_ASSERT( numFailures == 0u && "InstantRadiosity VPLs differ" );
+
+    TutorialGameState::update( timeSinceLast );
+
+    mGraphicsSystem->setQuit();
+}
@@ -0,0 +1,68 @@
+
+#ifndef Demo_InstantRadiosityGameState_H
+#define Demo_InstantRadiosityGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgreVector3.h"
+
+#include "TutorialGameState.h"
+
+#include "ogrestd/vector.h"
+
+namespace Ogre
+{
+    class InstantRadiosity;
+}
+
+namespace Demo
+{
+    class InstantRadiosityGameState : public TutorialGameState
+    {
+        struct VplData
+        {
+            Ogre::Vector3 position;
+            Ogre::Vector3 normal;
+            Ogre::Vector3 diffuse;
+        };
+        typedef Ogre::vector<VplData>::type VplDataVec;
+
+        /** Creates the same room with a few objects and lights in any SceneManager,
+            so that the results of different SceneManagers can be compared.
+        @param outLights
+            Receives the point light and the spot light, in that order.
+        */
+        static void createTestScene( Ogre::SceneManager *sceneManager, Ogre::Light **outLights );
+
+        /// Creates an InstantRadiosity with the settings used by every test
+        Ogre::InstantRadiosity *createInstantRadiosity( Ogre::SceneManager *sceneManager );
+
+        static void getVpls( const Ogre::InstantRadiosity *instantRadiosity, VplDataVec &outVpls );
+
+        /// Sorts by position, for comparing VPLs produced in a different order
+        static void sortVpls( VplDataVec &inOutVpls );
+
+        /** Logs every mismatch between both sets of VPLs and returns how many there were.
+        @param tolerance
+            Maximum absolute difference per component. 0 requires an exact match.
+        */
+        static size_t compareVpls( const VplDataVec &a, const VplDataVec &b, Ogre::Real tolerance,
+                                   const char *stage );
+
+        /** Changes, removes and adds lights, calling updateChangedLights after each step.
+            Every time the result must be the same as building again from scratch.
+        @return
+            The number of failed checks.
+        */
+        static size_t testIncrementalUpdate( Ogre::SceneManager *sceneManager,
+                                             Ogre::InstantRadiosity *instantRadiosity,
+                                             Ogre::Light **lights );
+
+    public:
+        InstantRadiosityGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
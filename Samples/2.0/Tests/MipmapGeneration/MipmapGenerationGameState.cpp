@@ -0,0 +1,387 @@
+
+#include "MipmapGenerationGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreImage2.h"
+#include "OgreLogManager.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreRoot.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+#include "OgreTextureGpuManager.h"
+#include "OgreTimer.h"
+
+using namespace Demo;
+
+namespace
+{
+    enum ChannelType
+    {
+        ChannelU8,
+        ChannelS8,
+        ChannelF32
+    };
+
+    /// How Image2::getDownsamplerFunctions treats each format
+    struct DownsampleDesc
+    {
+        size_t numChannels;
+        /// -1 if there is no alpha
+        int alphaIdx;
+        ChannelType type;
+        bool gamma;
+
+        DownsampleDesc( Ogre::PixelFormatGpu format, bool gammaCorrected )
+        {
+            using namespace Ogre;
+            numChannels = PixelFormatGpuUtils::getNumberOfComponents( format );
+            alphaIdx = format == PFG_A8_UNORM ? 0 : ( numChannels == 4u ? 3 : -1 );
+            if( PixelFormatGpuUtils::isFloat( format ) )
+                type = ChannelF32;
+            else if( PixelFormatGpuUtils::isSigned( format ) )
+                type = ChannelS8;
+            else
+                type = ChannelU8;
+            // Only the unsigned 8-bit downsamplers have sRGB variants
+            gamma = type == ChannelU8 && ( gammaCorrected || PixelFormatGpuUtils::isSRgb( format ) );
+        }
+    };
+
+    /// Computes one pixel of dst the same way OgreImageDownsamplerImpl.inl does with the
+    /// bilinear kernel: a 2x2 block clamped to the destination borders. Alpha is rounded up
+    /// and averaged linearly. Colour is rounded to nearest, and averaged in linear space
+    /// (squared) when gamma corrected.
+    void downsamplePixel( const Ogre::TextureBox &src, Ogre::uint32 dstWidth, Ogre::uint32 dstHeight,
+                          Ogre::uint32 x, Ogre::uint32 y, const DownsampleDesc &desc,
+                          Ogre::uint8 *outPixel )
+    {
+        using namespace Ogre;
+
+        const uint32 kEndY = std::min( dstHeight - y - 1u, 1u );
+        const uint32 kEndX = std::min( dstWidth - x - 1u, 1u );
+
+        for( size_t c = 0; c < desc.numChannels; ++c )
+        {
+            const bool bIsAlpha = int( c ) == desc.alphaIdx;
+
+            if( desc.type == ChannelF32 )
+            {
+                float accum = 0.0f;
+                float divisor = 0.0f;
+                for( uint32 ky = 0u; ky <= kEndY; ++ky )
+                {
+                    for( uint32 kx = 0u; kx <= kEndX; ++kx )
+                    {
+                        accum += reinterpret_cast<const float *>(
+                                     src.at( x * 2u + kx, y * 2u + ky, 0u ) )[c] *
+                                 1.0f;
+                        divisor += 1.0f;
+                    }
+                }
+
+                float result;
+                if( bIsAlpha )
+                    result = ( accum + divisor - 1.0f ) / divisor;
+                else
+                {
+                    const float invDivisor = 1.0f / divisor;
+                    result = accum * invDivisor + 0.0f;
+                }
+                reinterpret_cast<float *>( outPixel )[c] = result;
+            }
+            else if( desc.type == ChannelS8 )
+            {
+                int32 accum = 0;
+                int32 divisor = 0;
+                for( uint32 ky = 0u; ky <= kEndY; ++ky )
+                {
+                    for( uint32 kx = 0u; kx <= kEndX; ++kx )
+                    {
+                        accum += reinterpret_cast<const int8 *>(
+                            src.at( x * 2u + kx, y * 2u + ky, 0u ) )[c];
+                        ++divisor;
+                    }
+                }
+
+                int8 result;
+                if( bIsAlpha )
+                    result = static_cast<int8>( ( accum + divisor - 1 ) / divisor );
+                else
+                {
+                    const float invDivisor = 1.0f / static_cast<float>( divisor );
+                    result = static_cast<int8>( static_cast<float>( accum ) * invDivisor + 0.5f );
+                }
+                reinterpret_cast<int8 *>( outPixel )[c] = result;
+            }
+            else
+            {
+                uint32 accum = 0u;
+                uint32 divisor = 0u;
+                for( uint32 ky = 0u; ky <= kEndY; ++ky )
+                {
+                    for( uint32 kx = 0u; kx <= kEndX; ++kx )
+                    {
+                        const uint32 value = reinterpret_cast<const uint8 *>(
+                            src.at( x * 2u + kx, y * 2u + ky, 0u ) )[c];
+                        accum += ( desc.gamma && !bIsAlpha ) ? value * value : value;
+                        ++divisor;
+                    }
+                }
+
+                uint8 result;
+                if( bIsAlpha )
+                    result = static_cast<uint8>( ( accum + divisor - 1u ) / divisor );
+                else
+                {
+                    const float invDivisor = 1.0f / static_cast<float>( divisor );
+                    const float linear = static_cast<float>( accum ) * invDivisor;
+                    result = static_cast<uint8>( ( desc.gamma ? sqrtf( linear ) : linear ) + 0.5f );
+                }
+                outPixel[c] = result;
+            }
+        }
+    }
+}  // namespace
+
+MipmapGenerationGameState::MipmapGenerationGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+void MipmapGenerationGameState::generateSrcData( Ogre::Image2 &image )
+{
+    using namespace Ogre;
+
+    const PixelFormatGpu format = image.getPixelFormat();
+    const TextureBox box = image.getData( 0u );
+    const size_t bytesPerRow = box.width * box.bytesPerPixel;
+
+    // Reproducible random data
+    uint32 seed = 12345u;
+
+    for( size_t z = 0u; z < box.getDepthOrSlices(); ++z )
+    {
+        for( size_t y = 0u; y < box.height; ++y )
+        {
+            uint8 *rowPtr = reinterpret_cast<uint8 *>( box.at( 0u, y, z ) );
+            if( PixelFormatGpuUtils::isFloat( format ) )
+            {
+                for( size_t i = 0u; i < bytesPerRow / sizeof( float ); ++i )
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    reinterpret_cast<float *>( rowPtr )[i] =
+                        float( seed >> 8u ) / float( 1u << 24u ) * 1.5f - 0.25f;
+                }
+            }
+            else
+            {
+                for( size_t i = 0u; i < bytesPerRow; ++i )
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    rowPtr[i] = static_cast<uint8>( seed >> 24u );
+                }
+            }
+        }
+    }
+}
+//-----------------------------------------------------------------------------------
+bool MipmapGenerationGameState::checkAgainstReference( const Ogre::Image2 &image, bool gammaCorrected,
+                                                       Ogre::uint64 &outReferenceTime )
+{
+    using namespace Ogre;
+
+    const DownsampleDesc desc( image.getPixelFormat(), gammaCorrected );
+    const uint32 bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( image.getPixelFormat() );
+
+    vector<uint8>::type refPixel( bytesPerPixel );
+
+    Timer timer;
+    const uint64 startTime = timer.getMicroseconds();
+
+    bool bMatches = true;
+    for( uint8 mip = 1u; mip < image.getNumMipmaps() && bMatches; ++mip )
+    {
+        const TextureBox srcBox = image.getData( mip - 1u );
+        const TextureBox dstBox = image.getData( mip );
+
+        for( uint32 y = 0u; y < dstBox.height && bMatches; ++y )
+        {
+            for( uint32 x = 0u; x < dstBox.width && bMatches; ++x )
+            {
+                downsamplePixel( srcBox, dstBox.width, dstBox.height, x, y, desc, &refPixel[0] );
+                if( memcmp( &refPixel[0], dstBox.at( x, y, 0u ), bytesPerPixel ) != 0 )
+                {
+                    LogManager::getSingleton().logMessage(
+                        "Mip " + StringConverter::toString( mip ) + " differs from the reference at (" +
+                        StringConverter::toString( x ) + ", " + StringConverter::toString( y ) + ")" );
+                    bMatches = false;
+                }
+            }
+        }
+    }
+
+    outReferenceTime = timer.getMicroseconds() - startTime;
+
+    return bMatches;
+}
+//-----------------------------------------------------------------------------------
+bool MipmapGenerationGameState::compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b )
+{
+    using namespace Ogre;
+
+    if( a.getNumMipmaps() != b.getNumMipmaps() )
+        return false;
+
+    for( uint8 mip = 0u; mip < a.getNumMipmaps(); ++mip )
+    {
+        const TextureBox boxA = a.getData( mip );
+        const TextureBox boxB = b.getData( mip );
+        // Don't compare the row padding
+        const size_t bytesPerRow = boxA.width * boxA.bytesPerPixel;
+
+        for( size_t z = 0u; z < boxA.getDepthOrSlices(); ++z )
+        {
+            for( size_t y = 0u; y < boxA.height; ++y )
+            {
+                if( memcmp( boxA.at( 0u, y, z ), boxB.at( 0u, y, z ), bytesPerRow ) != 0 )
+                {
+                    LogManager::getSingleton().logMessage(
+                        "Mip " + StringConverter::toString( mip ) + " row " +
+                        StringConverter::toString( y ) + " slice " + StringConverter::toString( z ) +
+                        " differs between serial and multithreaded generation" );
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+bool MipmapGenerationGameState::runTest( Ogre::TextureTypes::TextureTypes textureType,
+                                         Ogre::PixelFormatGpu format, Ogre::uint32 width,
+                                         Ogre::uint32 height, Ogre::uint32 depthOrSlices,
+                                         bool gammaCorrected )
+{
+    using namespace Ogre;
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+
+    Image2 serialImage;
+    serialImage.createEmptyImage( width, height, depthOrSlices, textureType, format );
+    generateSrcData( serialImage );
+    Image2 bandedImage( serialImage );
+
+    Timer timer;
+
+    uint64 startTime = timer.getMicroseconds();
+    const bool bSerialOk = serialImage.generateMipmaps( gammaCorrected, Image2::FILTER_BILINEAR );
+    const uint64 serialTime = timer.getMicroseconds() - startTime;
+
+    startTime = timer.getMicroseconds();
+    const bool bBandedOk =
+        bandedImage.generateMipmaps( gammaCorrected, Image2::FILTER_BILINEAR, textureManager );
+    const uint64 bandedTime = timer.getMicroseconds() - startTime;
+
+    bool bMatches = bSerialOk && bBandedOk && compareImages( serialImage, bandedImage );
+
+    // The SIMD kernels only exist for 2D
+    uint64 referenceTime = 0u;
+    if( bMatches && textureType == TextureTypes::Type2D )
+        bMatches = checkAgainstReference( serialImage, gammaCorrected, referenceTime );
+
+    LogManager::getSingleton().logMessage(
+        String( PixelFormatGpuUtils::toString( format ) ) + ( gammaCorrected ? " (gamma)" : "" ) +
+        " " + StringConverter::toString( width ) + "x" + StringConverter::toString( height ) + "x" +
+        StringConverter::toString( depthOrSlices ) +
+        ( textureType == TextureTypes::Type3D
+              ? " 3D"
+              : ( textureType == TextureTypes::TypeCube ? " Cube" : " 2D" ) ) +
+        ": serial " + StringConverter::toString( Real( double( serialTime ) / 1000.0 ) ) +
+        " ms, multithreaded " + StringConverter::toString( Real( double( bandedTime ) / 1000.0 ) ) +
+        " ms" +
+        ( referenceTime ? ", reference " +
+                              StringConverter::toString( Real( double( referenceTime ) / 1000.0 ) ) +
+                              " ms"
+                        : "" ) +
+        ( bMatches ? "" : " RESULTS DO NOT MATCH" ) );
+
+    return bMatches;
+}
+//-----------------------------------------------------------------------------------
+void MipmapGenerationGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    // Every format Image2::generateMipmaps supports. Formats with SIMD kernels are
+    // checked against the scalar reference; the rest still cover the multithreaded path
+    const PixelFormatGpu formats[] = {
+        PFG_R8_UNORM,    PFG_A8_UNORM,         PFG_RG8_UNORM,        PFG_RGBA8_UNORM,
+        PFG_BGRA8_UNORM, PFG_RGBA8_UNORM_SRGB, PFG_BGRA8_UNORM_SRGB, PFG_R8_SNORM,
+        PFG_RG8_SNORM,   PFG_RGBA8_SNORM,      PFG_R32_FLOAT,        PFG_RG32_FLOAT,
+        PFG_RGB32_FLOAT, PFG_RGBA32_FLOAT,
+    };
+
+    // Odd sizes exercise the image borders, which the SIMD kernels leave to the scalar code
+    const uint32 sizes2D[][2] = {
+        { 512u, 512u }, { 257u, 131u }, { 75u, 1u }, { 1u, 75u }, { 3u, 5u },
+    };
+    const uint32 sizes3D[][3] = {
+        { 64u, 64u, 64u },
+        { 33u, 17u, 9u },
+    };
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+    textureManager->setMultiLoadPool( 4u );
+
+    LogManager::getSingleton().logMessage( "Mipmap generation test" );
+
+    size_t numMismatches = 0u;
+    for( size_t i = 0; i < sizeof( formats ) / sizeof( formats[0] ); ++i )
+    {
+        for( int gamma = 0; gamma < 2; ++gamma )
+        {
+            const bool gammaCorrected = gamma != 0;
+            // sRGB formats are always gamma corrected. Signed & float formats ignore it
+            if( !gammaCorrected && PixelFormatGpuUtils::isSRgb( formats[i] ) )
+                continue;
+            if( gammaCorrected && ( PixelFormatGpuUtils::isSigned( formats[i] ) ||
+                                    PixelFormatGpuUtils::isFloat( formats[i] ) ) )
+            {
+                continue;
+            }
+
+            for( size_t j = 0; j < sizeof( sizes2D ) / sizeof( sizes2D[0] ); ++j )
+            {
+                if( !runTest( TextureTypes::Type2D, formats[i], sizes2D[j][0], sizes2D[j][1], 1u,
+                              gammaCorrected ) )
+                {
+                    ++numMismatches;
+                }
+            }
+
+            for( size_t j = 0; j < sizeof( sizes3D ) / sizeof( sizes3D[0] ); ++j )
+            {
+                if( !runTest( TextureTypes::Type3D, formats[i], sizes3D[j][0], sizes3D[j][1],
+                              sizes3D[j][2], gammaCorrected ) )
+                {
+                    ++numMismatches;
+                }
+            }
+
+            if( !runTest( TextureTypes::TypeCube, formats[i], 128u, 128u, 6u, gammaCorrected ) )
+                ++numMismatches;
+        }
+    }
+
+    textureManager->setMultiLoadPool( 0u );
+
+    OGRE_ASSERT( numMismatches == 0u && "generateMipmaps differs from the scalar reference" );
+
+    mGraphicsSystem->setQuit();
+}
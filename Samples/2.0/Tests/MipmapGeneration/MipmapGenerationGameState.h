@@ -0,0 +1,41 @@
+
+#ifndef Demo_MipmapGenerationGameState_H
+#define Demo_MipmapGenerationGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+#include "OgreTextureGpu.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class MipmapGenerationGameState : public TutorialGameState
+    {
+        /// Fills mip 0 of the image with reproducible random contents valid for its format
+        static void generateSrcData( Ogre::Image2 &image );
+
+        /// Downsamples every mip of a 2D image from the previous one with a plain scalar
+        /// 2x2 filter that follows the same rules as the bilinear ImageDownsampler2D
+        /// functions, and returns false if any of them differs.
+        static bool checkAgainstReference( const Ogre::Image2 &image, bool gammaCorrected,
+                                           Ogre::uint64 &outReferenceTime );
+
+        /// Returns false if any mip of the images differs
+        static bool compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b );
+
+        /// Generates the mipmaps serially and split in bands across the multiload pool,
+        /// checks the results and logs the timings. Returns false if anything differs.
+        bool runTest( Ogre::TextureTypes::TextureTypes textureType, Ogre::PixelFormatGpu format,
+                      Ogre::uint32 width, Ogre::uint32 height, Ogre::uint32 depthOrSlices,
+                      bool gammaCorrected );
+
+    public:
+        MipmapGenerationGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
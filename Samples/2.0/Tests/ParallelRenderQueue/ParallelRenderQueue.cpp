@@ -0,0 +1,57 @@
+
+#include "ParallelRenderQueueGameState.h"
+#include "GraphicsSystem.h"
+
+// Declares WinMain / main
+#include "MainEntryPointHelper.h"
+#include "System/MainEntryPoints.h"
+
+#if OGRE_PLATFORM != OGRE_PLATFORM_ANDROID
+#    if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+INT WINAPI WinMainApp( HINSTANCE hInst, HINSTANCE hPrevInstance, LPSTR strCmdLine, INT nCmdShow )
+#    else
+int mainApp( int argc, const char *argv[] )
+#    endif
+{
+    return Demo::MainEntryPoints::mainAppSingleThreaded( DEMO_MAIN_ENTRY_PARAMS );
+}
+#endif
+
+namespace Demo
+{
+    class ParallelRenderQueue final : public GraphicsSystem
+    {
+    public:
+        ParallelRenderQueue( GameState *gameState ) : GraphicsSystem( gameState )
+        {
+            mAlwaysAskForConfig = false;
+        }
+    };
+
+    void MainEntryPoints::createSystems( GameState **outGraphicsGameState,
+                                         GraphicsSystem **outGraphicsSystem,
+                                         GameState **outLogicGameState, LogicSystem **outLogicSystem )
+    {
+        ParallelRenderQueueGameState *gfxGameState = new ParallelRenderQueueGameState(
+            "Renders thousands of Items with RenderQueue::setParallelPrepareThreshold\n"
+            "enabled and disabled, checks both produce the exact same image and logs\n"
+            "how long each takes.\n"
+            "Results are written to Ogre.log" );
+
+        GraphicsSystem *graphicsSystem = new ParallelRenderQueue( gfxGameState );
+
+        gfxGameState->_notifyGraphicsSystem( graphicsSystem );
+
+        *outGraphicsGameState = gfxGameState;
+        *outGraphicsSystem = graphicsSystem;
+    }
+
+    void MainEntryPoints::destroySystems( GameState *graphicsGameState, GraphicsSystem *graphicsSystem,
+                                          GameState *logicGameState, LogicSystem *logicSystem )
+    {
+        delete graphicsSystem;
+        delete graphicsGameState;
+    }
+
+    const char *MainEntryPoints::getWindowTitle() { return "Parallel Render Queue"; }
+}  // namespace Demo
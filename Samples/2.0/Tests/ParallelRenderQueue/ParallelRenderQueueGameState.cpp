@@ -0,0 +1,231 @@
+
+#include "ParallelRenderQueueGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "Compositor/OgreCompositorManager2.h"
+#include "Compositor/OgreCompositorNodeDef.h"
+#include "Compositor/OgreCompositorWorkspace.h"
+#include "Compositor/OgreCompositorWorkspaceDef.h"
+#include "Compositor/Pass/PassScene/OgreCompositorPassSceneDef.h"
+#include "OgreCamera.h"
+#include "OgreHlms.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsUnlitDatablock.h"
+#include "OgreImage2.h"
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreMeshManager2.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreRenderQueue.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+#include "OgreTextureGpuManager.h"
+#include "OgreTimer.h"
+
+using namespace Demo;
+
+static const size_t c_gridSize = 96u;
+static const size_t c_numDatablocks = 16u;
+static const size_t c_numTimedFrames = 20u;
+
+ParallelRenderQueueGameState::ParallelRenderQueueGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+void ParallelRenderQueueGameState::createScene01()
+{
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    // Several datablocks and meshes, so that the queue has shader, Vao and instancing breaks
+    Hlms *hlmsUnlit = mGraphicsSystem->getRoot()->getHlmsManager()->getHlms( HLMS_UNLIT );
+
+    HlmsUnlitDatablock *datablocks[c_numDatablocks];
+    for( size_t i = 0; i < c_numDatablocks; ++i )
+    {
+        const String datablockName = "ParallelRenderQueue " + StringConverter::toString( i );
+        HlmsBlendblock blendblock;
+        if( i % 4u == 3u )
+            blendblock.setBlendType( SBT_TRANSPARENT_ALPHA );
+        datablocks[i] = static_cast<HlmsUnlitDatablock *>( hlmsUnlit->createDatablock(
+            datablockName, datablockName, HlmsMacroblock(), blendblock, HlmsParamVec() ) );
+        datablocks[i]->setUseColour( true );
+        datablocks[i]->setColour( ColourValue( Real( i & 0x01u ), Real( ( i >> 1u ) & 0x01u ),
+                                               Real( ( i >> 2u ) & 0x01u ), 0.5f + Real( i ) * 0.03f ) );
+    }
+
+    const char *meshNames[] = { "Cube_d.mesh", "Sphere1000.mesh" };
+
+    SceneNode *rootNode = sceneManager->getRootSceneNode( SCENE_STATIC );
+
+    for( size_t y = 0; y < c_gridSize; ++y )
+    {
+        for( size_t x = 0; x < c_gridSize; ++x )
+        {
+            const size_t idx = y * c_gridSize + x;
+
+            Item *item = sceneManager->createItem( meshNames[( idx / 7u ) % 2u],
+                                                   ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+                                                   SCENE_STATIC );
+            item->setDatablock( datablocks[( idx * 7u ) % c_numDatablocks] );
+
+            SceneNode *sceneNode = rootNode->createChildSceneNode( SCENE_STATIC );
+            sceneNode->setPosition( ( Real( x ) - Real( c_gridSize ) * 0.5f ) * 1.5f,
+                                    ( Real( y ) - Real( c_gridSize ) * 0.5f ) * 1.5f,
+                                    -Real( ( idx * 13u ) % 17u ) );
+            sceneNode->setScale( Vector3( 0.5f ) );
+            sceneNode->attachObject( item );
+        }
+    }
+
+    Camera *camera = mGraphicsSystem->getCamera();
+    camera->setPosition( 0, 0, Real( c_gridSize ) * 1.0f );
+    camera->lookAt( 0, 0, 0 );
+
+    CompositorManager2 *compositorManager = mGraphicsSystem->getRoot()->getCompositorManager2();
+    CompositorNodeDef *nodeDef = compositorManager->addNodeDefinition( "ParallelRenderQueue Node" );
+    nodeDef->addTextureSourceName( "RenderTarget", 0, TextureDefinitionBase::TEXTURE_INPUT );
+    nodeDef->setNumTargetPass( 1 );
+    {
+        CompositorTargetDef *targetDef = nodeDef->addTargetPass( "RenderTarget" );
+        targetDef->setNumPasses( 1 );
+        {
+            CompositorPassSceneDef *passScene =
+                static_cast<CompositorPassSceneDef *>( targetDef->addPass( PASS_SCENE ) );
+            passScene->setAllClearColours( ColourValue( 0.2f, 0.4f, 0.6f, 1.0f ) );
+            passScene->setAllLoadActions( LoadAction::Clear );
+            passScene->mIncludeOverlays = false;
+        }
+    }
+
+    CompositorWorkspaceDef *workDef =
+        compositorManager->addWorkspaceDefinition( "ParallelRenderQueue Workspace" );
+    workDef->connectExternal( 0, nodeDef->getName(), 0 );
+
+    TutorialGameState::createScene01();
+}
+//-----------------------------------------------------------------------------------
+Ogre::uint64 ParallelRenderQueueGameState::renderScene( Ogre::CompositorWorkspace *workspace,
+                                                        Ogre::TextureGpu *renderTarget,
+                                                        size_t parallelPrepareThreshold,
+                                                        Ogre::Image2 *outImage )
+{
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+    sceneManager->getRenderQueue()->setParallelPrepareThreshold( parallelPrepareThreshold );
+
+    Timer timer;
+    workspace->_validateFinalTarget();
+    workspace->_beginUpdate( false );
+    workspace->_update();
+    workspace->_endUpdate( false );
+    const uint64 elapsed = timer.getMicroseconds();
+
+    if( outImage )
+        outImage->convertFromTexture( renderTarget, 0u, 0u );
+
+    return elapsed;
+}
+//-----------------------------------------------------------------------------------
+bool ParallelRenderQueueGameState::compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b )
+{
+    using namespace Ogre;
+
+    if( a.getPixelFormat() != b.getPixelFormat() || a.getWidth() != b.getWidth() ||
+        a.getHeight() != b.getHeight() )
+    {
+        return false;
+    }
+
+    const TextureBox boxA = a.getData( 0u );
+    const TextureBox boxB = b.getData( 0u );
+    const size_t rowBytes = boxA.width * boxA.bytesPerPixel;
+
+    for( size_t y = 0u; y < boxA.height; ++y )
+    {
+        if( memcmp( boxA.at( 0u, y, 0u ), boxB.at( 0u, y, 0u ), rowBytes ) != 0 )
+            return false;
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+void ParallelRenderQueueGameState::update( float timeSinceLast )
+{
+    using namespace Ogre;
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+
+    TextureGpu *renderTarget = textureManager->createTexture(
+        "ParallelRenderQueue RT", GpuPageOutStrategy::Discard, TextureFlags::RenderToTexture,
+        TextureTypes::Type2D );
+    renderTarget->setResolution( 512u, 512u );
+    renderTarget->setPixelFormat( PFG_RGBA8_UNORM );
+    renderTarget->scheduleTransitionTo( GpuResidency::Resident );
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+    sceneManager->updateSceneGraph();
+
+    CompositorManager2 *compositorManager = mGraphicsSystem->getRoot()->getCompositorManager2();
+    CompositorWorkspace *workspace =
+        compositorManager->addWorkspace( sceneManager, renderTarget, mGraphicsSystem->getCamera(),
+                                         "ParallelRenderQueue Workspace", false );
+
+    LogManager &logManager = LogManager::getSingleton();
+    logManager.logMessage( "Parallel render queue preparation test. " +
+                           StringConverter::toString( sceneManager->getNumWorkerThreads() ) +
+                           " worker threads" );
+
+    // The first frame has to create every shader. With the parallel preparation enabled,
+    // the worker threads don't find them and the main thread must create them.
+    Image2 firstParallelImage;
+    renderScene( workspace, renderTarget, 1u, &firstParallelImage );
+
+    Image2 serialImage;
+    renderScene( workspace, renderTarget, 0u, &serialImage );
+
+    Image2 parallelImage;
+    renderScene( workspace, renderTarget, 1u, &parallelImage );
+
+    size_t numFailures = 0u;
+    if( !compareImages( firstParallelImage, serialImage ) )
+    {
+        logManager.logMessage( "Parallel preparation while creating shaders differs from serial" );
+        ++numFailures;
+    }
+    if( !compareImages( parallelImage, serialImage ) )
+    {
+        logManager.logMessage( "Parallel preparation differs from serial" );
+        ++numFailures;
+    }
+
+    uint64 serialTime = 0u;
+    uint64 parallelTime = 0u;
+    for( size_t i = 0u; i < c_numTimedFrames; ++i )
+    {
+        serialTime += renderScene( workspace, renderTarget, 0u, 0 );
+        parallelTime += renderScene( workspace, renderTarget, 1u, 0 );
+    }
+
+    logManager.logMessage(
+        StringConverter::toString( c_gridSize * c_gridSize ) + " Items. Average frame time: " +
+        StringConverter::toString( serialTime / c_numTimedFrames ) + "us serial, " +
+        StringConverter::toString( parallelTime / c_numTimedFrames ) + "us parallel preparation" );
+
+    sceneManager->getRenderQueue()->setParallelPrepareThreshold( 0u );
+    compositorManager->removeWorkspace( workspace );
+    textureManager->destroyTexture( renderTarget );
+
+    OGRE_ASSERT( numFailures == 0u && "Parallel render queue preparation changed the output" );
+
+    TutorialGameState::update( timeSinceLast );
+
+    mGraphicsSystem->setQuit();
+}
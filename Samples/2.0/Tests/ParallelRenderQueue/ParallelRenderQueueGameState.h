@@ -0,0 +1,30 @@
+
+#ifndef Demo_ParallelRenderQueueGameState_H
+#define Demo_ParallelRenderQueueGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class ParallelRenderQueueGameState : public TutorialGameState
+    {
+        /// Renders the scene once into renderTarget with the given preparation threshold,
+        /// downloads the result into outImage and returns the CPU time it took.
+        Ogre::uint64 renderScene( Ogre::CompositorWorkspace *workspace,
+                                  Ogre::TextureGpu *renderTarget, size_t parallelPrepareThreshold,
+                                  Ogre::Image2 *outImage );
+
+        /// Returns false if the contents of both images differ. The row padding is not compared.
+        static bool compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b );
+
+    public:
+        ParallelRenderQueueGameState( const Ogre::String &helpDescription );
+
+        void createScene01() override;
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
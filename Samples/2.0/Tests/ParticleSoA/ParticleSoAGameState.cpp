@@ -0,0 +1,329 @@
+
+#include "ParticleSoAGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreLogManager.h"
+#include "OgreParticle.h"
+#include "OgreParticleAffector.h"
+#include "OgreParticleAffectorFactory.h"
+#include "OgreParticleSystem.h"
+#include "OgreParticleSystemManager.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include <algorithm>
+
+using namespace Demo;
+
+static const Ogre::Real c_timeStep = 1.0f / 30.0f;
+static const size_t c_numSteps = 30u;
+static const size_t c_numParticles = 61u;
+static const size_t c_numTimedParticles = 20000u;
+static const size_t c_numTimedSteps = 60u;
+
+namespace
+{
+    /// Affector without SoA support, so that the system has to write its particles back
+    /// and read them again around it.
+    class LegacyTestAffector final : public Ogre::ParticleAffector
+    {
+    public:
+        LegacyTestAffector( Ogre::ParticleSystem *psys ) : ParticleAffector( psys )
+        {
+            mType = "ParticleSoATestLegacy";
+        }
+
+        void _affectParticles( Ogre::ParticleSystem *pSystem, Ogre::Real timeElapsed ) override
+        {
+            Ogre::ParticleIterator itor = pSystem->_getIterator();
+            while( !itor.end() )
+            {
+                Ogre::Particle *p = itor.getNext();
+                p->mTimeToLive -= 0.01f;
+                p->mColour.b *= 0.5f;
+                p->mDirection.x += timeElapsed;
+            }
+        }
+    };
+
+    class LegacyTestAffectorFactory final : public Ogre::ParticleAffectorFactory
+    {
+    public:
+        Ogre::String getName() const override { return "ParticleSoATestLegacy"; }
+
+        Ogre::ParticleAffector *createAffector( Ogre::ParticleSystem *psys ) override
+        {
+            Ogre::ParticleAffector *affector = OGRE_NEW LegacyTestAffector( psys );
+            mAffectors.push_back( affector );
+            return affector;
+        }
+    };
+
+    // ParticleSystemManager doesn't own the factories, so it must outlive it
+    LegacyTestAffectorFactory g_legacyTestAffectorFactory;
+
+    /// What the affectors of the test do, one particle at a time
+    struct ReferenceParticle
+    {
+        size_t id;
+        Ogre::Vector3 position;
+        Ogre::Vector3 direction;
+        Ogre::ColourValue colour;
+        Ogre::Real timeToLive;
+        Ogre::Real rotation;
+        Ogre::Real rotationSpeed;
+        bool ownDimensions;
+        Ogre::Real width;
+        Ogre::Real height;
+
+        void legacyTestAffector( Ogre::Real timeElapsed )
+        {
+            timeToLive -= 0.01f;
+            colour.b *= 0.5f;
+            direction.x += timeElapsed;
+        }
+    };
+
+    bool equal( Ogre::Real a, Ogre::Real b )
+    {
+        return Ogre::Math::Abs( a - b ) <= 1e-4f * std::max( Ogre::Real( 1 ), Ogre::Math::Abs( a ) );
+    }
+
+    Ogre::Real clamp01( Ogre::Real value )
+    {
+        return std::min( std::max( value, Ogre::Real( 0 ) ), Ogre::Real( 1 ) );
+    }
+}  // namespace
+
+ParticleSoAGameState::ParticleSoAGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+size_t ParticleSoAGameState::runTest( bool bSorted )
+{
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+    LogManager &logManager = LogManager::getSingleton();
+    const String testName = bSorted ? "Sorted: " : "Unsorted: ";
+
+    ParticleSystem *particleSystem = sceneManager->createParticleSystem( c_numParticles );
+    SceneNode *sceneNode = sceneManager->getRootSceneNode()->createChildSceneNode();
+    sceneNode->attachObject( particleSystem );
+    particleSystem->setSortingEnabled( bSorted );
+    particleSystem->setDefaultDimensions( 4.0f, 5.0f );
+
+    const Vector3 force( 0.0f, -9.8f, 0.0f );
+    const Real redAdj = -0.25f;
+    const Real greenAdj = 0.3f;
+    const Real alphaAdj = -0.5f;
+    const Real scaleAdj = 3.0f;
+
+    // ParticleFX affectors support SoA, ours doesn't. Put ours in the middle and at the end
+    ParticleAffector *affector = particleSystem->addAffector( "LinearForce" );
+    affector->setParameter( "force_vector", StringConverter::toString( force ) );
+    affector->setParameter( "force_application", "add" );
+    particleSystem->addAffector( "ParticleSoATestLegacy" );
+    affector = particleSystem->addAffector( "ColourFader" );
+    affector->setParameter( "red", StringConverter::toString( redAdj ) );
+    affector->setParameter( "green", StringConverter::toString( greenAdj ) );
+    affector->setParameter( "alpha", StringConverter::toString( alphaAdj ) );
+    affector = particleSystem->addAffector( "Scaler" );
+    affector->setParameter( "rate", StringConverter::toString( scaleAdj ) );
+    particleSystem->addAffector( "Rotator" );
+    particleSystem->addAffector( "ParticleSoATestLegacy" );
+
+    // The pool gets allocated by the first update
+    particleSystem->_update( 0.0f );
+
+    std::vector<ReferenceParticle> reference;
+    for( size_t i = 0u; i < c_numParticles; ++i )
+    {
+        Particle *p = particleSystem->createParticle();
+        if( !p )
+        {
+            logManager.logMessage( testName + "createParticle failed" );
+            sceneManager->destroyParticleSystem( particleSystem );
+            sceneManager->destroySceneNode( sceneNode );
+            return 1u;
+        }
+
+        ReferenceParticle ref;
+        ref.id = i;
+        ref.position = Vector3( Real( i ), Real( i ) * 0.5f, -Real( i ) );
+        ref.direction = Vector3( Real( i ) * 0.1f, 1.0f, 0.0f );
+        ref.colour = ColourValue( Real( i % 5u ) * 0.25f, 0.5f, 1.0f, 1.0f );
+        ref.timeToLive = 0.05f + Real( ( i * 7u ) % 13u ) * 0.1f;
+        ref.rotation = 0.0f;
+        ref.rotationSpeed = Real( i ) * 0.1f;
+        ref.ownDimensions = ( i % 3u ) == 0u;
+        ref.width = ref.ownDimensions ? 1.0f + Real( i ) : particleSystem->getDefaultWidth();
+        ref.height = ref.ownDimensions ? 2.0f + Real( i ) : particleSystem->getDefaultHeight();
+        reference.push_back( ref );
+
+        p->mPosition = ref.position;
+        p->mDirection = ref.direction;
+        p->mColour = ref.colour;
+        p->mTimeToLive = ref.timeToLive;
+        // Not touched by any affector, so it identifies the particle
+        p->mTotalTimeToLive = Real( i );
+        p->mRotation = Radian( ref.rotation );
+        p->mRotationSpeed = Radian( ref.rotationSpeed );
+        p->mOwnDimensions = ref.ownDimensions;
+        if( ref.ownDimensions )
+        {
+            p->mWidth = ref.width;
+            p->mHeight = ref.height;
+        }
+    }
+
+    size_t numFailures = 0u;
+    for( size_t step = 0u; step < c_numSteps && !numFailures; ++step )
+    {
+        particleSystem->_update( c_timeStep );
+
+        // Expiry (keeping the order), then the affectors in the order they were added, then motion
+        std::vector<ReferenceParticle> survivors;
+        for( size_t i = 0u; i < reference.size(); ++i )
+        {
+            if( reference[i].timeToLive >= c_timeStep )
+            {
+                survivors.push_back( reference[i] );
+                survivors.back().timeToLive -= c_timeStep;
+            }
+        }
+        reference.swap( survivors );
+
+        for( size_t i = 0u; i < reference.size(); ++i )
+        {
+            ReferenceParticle &ref = reference[i];
+            ref.direction += force * c_timeStep;
+            ref.legacyTestAffector( c_timeStep );
+            ref.colour.r = clamp01( ref.colour.r + redAdj * c_timeStep );
+            ref.colour.g = clamp01( ref.colour.g + greenAdj * c_timeStep );
+            ref.colour.b = clamp01( ref.colour.b );
+            ref.colour.a = clamp01( ref.colour.a + alphaAdj * c_timeStep );
+            ref.width += scaleAdj * c_timeStep;
+            ref.height += scaleAdj * c_timeStep;
+            ref.ownDimensions = true;
+            ref.rotation += c_timeStep * ref.rotationSpeed;
+            ref.legacyTestAffector( c_timeStep );
+            ref.position += ref.direction * c_timeStep;
+        }
+
+        if( particleSystem->getNumParticles() != reference.size() )
+        {
+            logManager.logMessage( testName + "step " + StringConverter::toString( step ) + ": " +
+                                   StringConverter::toString( particleSystem->getNumParticles() ) +
+                                   " particles, expected " +
+                                   StringConverter::toString( reference.size() ) );
+            ++numFailures;
+            break;
+        }
+
+        // Sorted systems may reorder the particles, find them by id instead
+        std::vector<Particle *> particlesById( c_numParticles, (Particle *)0 );
+        for( size_t i = 0u; i < reference.size(); ++i )
+        {
+            Particle *p = particleSystem->getParticle( i );
+            const size_t id = static_cast<size_t>( p->mTotalTimeToLive );
+            if( !bSorted && id != reference[i].id )
+            {
+                logManager.logMessage( testName + "step " + StringConverter::toString( step ) +
+                                       ": the order of the particles changed" );
+                ++numFailures;
+            }
+            particlesById[id] = p;
+        }
+
+        for( size_t i = 0u; i < reference.size() && !numFailures; ++i )
+        {
+            const ReferenceParticle &ref = reference[i];
+            const Particle *p = particlesById[ref.id];
+            if( !p || !equal( p->mPosition.x, ref.position.x ) ||
+                !equal( p->mPosition.y, ref.position.y ) ||
+                !equal( p->mPosition.z, ref.position.z ) ||
+                !equal( p->mDirection.x, ref.direction.x ) ||
+                !equal( p->mDirection.y, ref.direction.y ) ||
+                !equal( p->mDirection.z, ref.direction.z ) || !equal( p->mColour.r, ref.colour.r ) ||
+                !equal( p->mColour.g, ref.colour.g ) || !equal( p->mColour.b, ref.colour.b ) ||
+                !equal( p->mColour.a, ref.colour.a ) || !equal( p->mTimeToLive, ref.timeToLive ) ||
+                !equal( p->mRotation.valueRadians(), ref.rotation ) ||
+                p->mOwnDimensions != ref.ownDimensions || !equal( p->mWidth, ref.width ) ||
+                !equal( p->mHeight, ref.height ) )
+            {
+                logManager.logMessage( testName + "step " + StringConverter::toString( step ) +
+                                       ": particle " + StringConverter::toString( ref.id ) +
+                                       " differs from the reference" );
+                ++numFailures;
+            }
+        }
+    }
+
+    if( !numFailures )
+    {
+        logManager.logMessage( testName + "OK. " + StringConverter::toString( reference.size() ) +
+                               " of " + StringConverter::toString( c_numParticles ) +
+                               " particles alive after " + StringConverter::toString( c_numSteps ) +
+                               " steps" );
+    }
+
+    sceneManager->destroyParticleSystem( particleSystem );
+    sceneManager->destroySceneNode( sceneNode );
+
+    return numFailures;
+}
+//-----------------------------------------------------------------------------------
+void ParticleSoAGameState::update( float timeSinceLast )
+{
+    using namespace Ogre;
+
+    ParticleSystemManager::getSingleton().addAffectorFactory( &g_legacyTestAffectorFactory );
+
+    LogManager::getSingleton().logMessage( "Particle SoA test" );
+
+    size_t numFailures = 0u;
+    numFailures += runTest( false );
+    numFailures += runTest( true );
+
+    // Not a benchmark against anything, but gives an idea of the cost per particle
+    {
+        SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+        ParticleSystem *particleSystem = sceneManager->createParticleSystem( c_numTimedParticles );
+        SceneNode *sceneNode = sceneManager->getRootSceneNode()->createChildSceneNode();
+        sceneNode->attachObject( particleSystem );
+        particleSystem->addAffector( "LinearForce" );
+        particleSystem->addAffector( "ColourFader" );
+        particleSystem->addAffector( "Scaler" );
+        particleSystem->addAffector( "Rotator" );
+        particleSystem->_update( 0.0f );
+
+        for( size_t i = 0u; i < c_numTimedParticles; ++i )
+        {
+            Particle *p = particleSystem->createParticle();
+            p->mTimeToLive = 1000.0f;
+            p->mDirection = Vector3( 0.0f, 1.0f, 0.0f );
+        }
+
+        Timer timer;
+        for( size_t i = 0u; i < c_numTimedSteps; ++i )
+            particleSystem->_update( c_timeStep );
+        const uint64 elapsed = timer.getMicroseconds();
+
+        LogManager::getSingleton().logMessage(
+            StringConverter::toString( c_numTimedParticles ) + " particles, 4 SoA affectors: " +
+            StringConverter::toString( elapsed / c_numTimedSteps ) + "us per update" );
+
+        sceneManager->destroyParticleSystem( particleSystem );
+        sceneManager->destroySceneNode( sceneNode );
+    }
+
+    OGRE_ASSERT( numFailures == 0u && "The SoA particle update differs from the reference" );
+
+    TutorialGameState::update( timeSinceLast );
+
+    mGraphicsSystem->setQuit();
+}
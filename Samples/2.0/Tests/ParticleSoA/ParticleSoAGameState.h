@@ -0,0 +1,29 @@
+
+#ifndef Demo_ParticleSoAGameState_H
+#define Demo_ParticleSoAGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class ParticleSoAGameState : public TutorialGameState
+    {
+        /** Creates particles by hand, updates the system a number of times and compares
+            the result against the same affectors applied one particle at a time.
+        @param bSorted
+            Sorted systems don't keep the order of the particles when some expire.
+        @return
+            The number of mismatches.
+        */
+        size_t runTest( bool bSorted );
+
+    public:
+        ParticleSoAGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
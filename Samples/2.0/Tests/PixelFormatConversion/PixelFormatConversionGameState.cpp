@@ -0,0 +1,160 @@
+
+#include "PixelFormatConversionGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreBitwise.h"
+#include "OgreLogManager.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+#include "OgreTimer.h"
+
+using namespace Demo;
+
+static const Ogre::uint32 c_width = 512u;
+static const Ogre::uint32 c_height = 512u;
+static const size_t c_numIterations = 5u;
+
+PixelFormatConversionGameState::PixelFormatConversionGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+void PixelFormatConversionGameState::generateSrcData( Ogre::PixelFormatGpu srcFormat, size_t numPixels )
+{
+    using namespace Ogre;
+
+    const size_t bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( srcFormat );
+    mSrcData.resize( numPixels * bytesPerPixel );
+
+    // Reproducible random data
+    uint32 seed = 12345u;
+
+    if( PixelFormatGpuUtils::isFloat( srcFormat ) || PixelFormatGpuUtils::isHalf( srcFormat ) )
+    {
+        const size_t numComponents = numPixels * PixelFormatGpuUtils::getNumberOfComponents( srcFormat );
+        for( size_t i = 0; i < numComponents; ++i )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            // Slightly out of [0; 1] range to exercise clamping
+            const float value = float( seed >> 8u ) / float( 1u << 24u ) * 1.5f - 0.25f;
+            if( PixelFormatGpuUtils::isFloat( srcFormat ) )
+                reinterpret_cast<float *>( &mSrcData[0] )[i] = value;
+            else
+                reinterpret_cast<uint16 *>( &mSrcData[0] )[i] = Bitwise::floatToHalf( value );
+        }
+    }
+    else
+    {
+        for( size_t i = 0; i < mSrcData.size(); ++i )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            mSrcData[i] = static_cast<uint8>( seed >> 24u );
+        }
+    }
+}
+//-----------------------------------------------------------------------------------
+bool PixelFormatConversionGameState::runBenchmark( Ogre::PixelFormatGpu srcFormat,
+                                                   Ogre::PixelFormatGpu dstFormat )
+{
+    using namespace Ogre;
+
+    const size_t numPixels = c_width * c_height;
+    const uint32 srcBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( srcFormat );
+    const uint32 dstBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( dstFormat );
+
+    generateSrcData( srcFormat, numPixels );
+    mDstData.resize( numPixels * dstBytesPerPixel );
+    mRefData.resize( numPixels * dstBytesPerPixel );
+
+    TextureBox srcBox( c_width, c_height, 1u, 1u, srcBytesPerPixel, c_width * srcBytesPerPixel,
+                       numPixels * srcBytesPerPixel );
+    TextureBox dstBox( c_width, c_height, 1u, 1u, dstBytesPerPixel, c_width * dstBytesPerPixel,
+                       numPixels * dstBytesPerPixel );
+    srcBox.data = &mSrcData[0];
+    dstBox.data = &mDstData[0];
+
+    Timer timer;
+
+    uint64 startTime = timer.getMicroseconds();
+    for( size_t i = 0; i < c_numIterations; ++i )
+        PixelFormatGpuUtils::bulkPixelConversion( srcBox, srcFormat, dstBox, dstFormat );
+    const uint64 bulkTime = timer.getMicroseconds() - startTime;
+
+    startTime = timer.getMicroseconds();
+    for( size_t i = 0; i < c_numIterations; ++i )
+    {
+        const uint8 *srcPtr = &mSrcData[0];
+        uint8 *dstPtr = &mRefData[0];
+        float rgba[4];
+        for( size_t j = 0; j < numPixels; ++j )
+        {
+            PixelFormatGpuUtils::unpackColour( rgba, srcFormat, srcPtr );
+            PixelFormatGpuUtils::packColour( rgba, dstFormat, dstPtr );
+            srcPtr += srcBytesPerPixel;
+            dstPtr += dstBytesPerPixel;
+        }
+    }
+    const uint64 bruteForceTime = timer.getMicroseconds() - startTime;
+
+    const bool bMatches = mDstData == mRefData;
+
+    const double bulkMs = double( bulkTime ) / double( c_numIterations ) / 1000.0;
+    const double bruteForceMs = double( bruteForceTime ) / double( c_numIterations ) / 1000.0;
+
+    LogManager::getSingleton().logMessage(
+        String( PixelFormatGpuUtils::toString( srcFormat ) ) + " -> " +
+        PixelFormatGpuUtils::toString( dstFormat ) + ": " +
+        StringConverter::toString( Real( bulkMs ) ) + " ms vs brute force " +
+        StringConverter::toString( Real( bruteForceMs ) ) + " ms (x" +
+        StringConverter::toString( Real( bruteForceMs / std::max( bulkMs, 1e-6 ) ) ) + ")" +
+        ( bMatches ? "" : " RESULTS DO NOT MATCH" ) );
+
+    return bMatches;
+}
+//-----------------------------------------------------------------------------------
+void PixelFormatConversionGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    // The same pairs covered by Tests/OgreMain's PixelFormatTests,
+    // plus the conversions between different types that have dedicated routines
+    const PixelFormatGpu pairs[][2] = {
+        { PFG_RGBA8_UNORM, PFG_BGRA8_UNORM },
+        { PFG_BGRA8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_BGRX8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_BGRX8_UNORM, PFG_BGRA8_UNORM },
+        { PFG_RGBA8_UNORM, PFG_R8_UNORM },
+        { PFG_BGRA8_UNORM, PFG_R8_UNORM },
+        { PFG_R8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGB8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGB8_UNORM, PFG_BGRA8_UNORM },
+        { PFG_BGR8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGB8_UNORM, PFG_BGR8_UNORM },
+        { PFG_RGBA8_UNORM, PFG_RGB8_UNORM },
+        { PFG_RGBA8_UNORM, PFG_RGBA32_FLOAT },
+        { PFG_RGBA32_FLOAT, PFG_RGBA8_UNORM },
+        { PFG_RGBA8_UNORM_SRGB, PFG_RGBA32_FLOAT },
+        { PFG_RGBA32_FLOAT, PFG_RGBA8_UNORM_SRGB },
+        { PFG_RGBA16_FLOAT, PFG_RGBA32_FLOAT },
+        { PFG_RGBA32_FLOAT, PFG_RGBA16_FLOAT },
+    };
+
+    LogManager::getSingleton().logMessage(
+        "Pixel format conversion benchmark. Resolution: " + StringConverter::toString( c_width ) +
+        "x" + StringConverter::toString( c_height ) );
+
+    size_t numMismatches = 0u;
+    for( size_t i = 0; i < sizeof( pairs ) / sizeof( pairs[0] ); ++i )
+    {
+        if( !runBenchmark( pairs[i][0], pairs[i][1] ) )
+            ++numMismatches;
+    }
+
+    OGRE_ASSERT( numMismatches == 0u && "bulkPixelConversion differs from unpack/packColour" );
+
+    mGraphicsSystem->setQuit();
+}
@@ -0,0 +1,36 @@
+
+#ifndef Demo_PixelFormatConversionGameState_H
+#define Demo_PixelFormatConversionGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+
+#include "TutorialGameState.h"
+
+#include "ogrestd/vector.h"
+
+namespace Demo
+{
+    class PixelFormatConversionGameState : public TutorialGameState
+    {
+        Ogre::vector<Ogre::uint8>::type mSrcData;
+        Ogre::vector<Ogre::uint8>::type mDstData;
+        Ogre::vector<Ogre::uint8>::type mRefData;
+
+        /// Fills mSrcData with reproducible random contents valid for the given format
+        void generateSrcData( Ogre::PixelFormatGpu srcFormat, size_t numPixels );
+
+        /// Converts mSrcData into mDstData (bulkPixelConversion) and into mRefData
+        /// (unpackColour / packColour per pixel), logs the timings of both and
+        /// returns false if the results differ.
+        bool runBenchmark( Ogre::PixelFormatGpu srcFormat, Ogre::PixelFormatGpu dstFormat );
+
+    public:
+        PixelFormatConversionGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
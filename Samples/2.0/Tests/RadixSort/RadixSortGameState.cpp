@@ -0,0 +1,205 @@
+
+#include "RadixSortGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreLogManager.h"
+#include "OgreRadixSort.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "Threading/OgreUniformScalableTask.h"
+
+#include "ogrestd/vector.h"
+
+#include <algorithm>
+
+using namespace Demo;
+
+namespace
+{
+    struct KeyValue64
+    {
+        Ogre::uint64 key;
+        size_t originalIdx;
+    };
+
+    struct KeyValue64Key
+    {
+        Ogre::uint64 operator()( const KeyValue64 &val ) const { return val.key; }
+    };
+
+    bool orderKeyValue64( const KeyValue64 &a, const KeyValue64 &b ) { return a.key < b.key; }
+
+    typedef Ogre::RadixSort64<KeyValue64, KeyValue64Key> KeyValue64RadixSort;
+    typedef Ogre::vector<KeyValue64>::type KeyValue64Vec;
+
+    /// Sorts one slice per worker thread, the same way RenderQueue does
+    class SortSlicesTask final : public Ogre::UniformScalableTask
+    {
+        KeyValue64 *mData;
+        KeyValue64 *mScratch;
+        size_t mNumElements;
+        size_t mSliceSize;
+
+    public:
+        SortSlicesTask( KeyValue64 *data, KeyValue64 *scratch, size_t numElements,
+                        size_t sliceSize ) :
+            mData( data ),
+            mScratch( scratch ),
+            mNumElements( numElements ),
+            mSliceSize( sliceSize )
+        {
+        }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            const size_t numSlices = ( mNumElements + mSliceSize - 1u ) / mSliceSize;
+            for( size_t i = threadId; i < numSlices; i += numThreads )
+            {
+                const size_t firstIdx = i * mSliceSize;
+                const size_t lastIdx = std::min( firstIdx + mSliceSize, mNumElements );
+                KeyValue64RadixSort::sort( mData + firstIdx, mScratch + firstIdx,
+                                           lastIdx - firstIdx );
+            }
+        }
+    };
+
+    bool equalKeyValues( const KeyValue64Vec &a, const KeyValue64Vec &b )
+    {
+        if( a.size() != b.size() )
+            return false;
+        for( size_t i = 0; i < a.size(); ++i )
+        {
+            if( a[i].key != b[i].key || a[i].originalIdx != b[i].originalIdx )
+                return false;
+        }
+        return true;
+    }
+}  // namespace
+
+RadixSortGameState::RadixSortGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription ),
+    mSeed( 12345u )
+{
+}
+//-----------------------------------------------------------------------------------
+Ogre::uint64 RadixSortGameState::randomUInt64()
+{
+    mSeed = mSeed * 6364136223846793005ull + 1442695040888963407ull;
+    // The low bits of an LCG are poor. Mix the high ones down.
+    return mSeed ^ ( mSeed >> 29u );
+}
+//-----------------------------------------------------------------------------------
+bool RadixSortGameState::runTest( KeyPattern keyPattern, size_t numElements, size_t numSlices )
+{
+    using namespace Ogre;
+
+    const String testName = "Pattern " + StringConverter::toString( keyPattern ) + " " +
+                            StringConverter::toString( numElements ) + " elements " +
+                            StringConverter::toString( numSlices ) + " slices";
+
+    KeyValue64Vec source( numElements );
+    for( size_t i = 0; i < numElements; ++i )
+    {
+        switch( keyPattern )
+        {
+        case KeyPatternFewDistinct:
+            source[i].key = ( ( randomUInt64() & 0x0Fu ) << 56u ) | ( randomUInt64() & 0x0Fu );
+            break;
+        case KeyPatternRandom:
+            source[i].key = randomUInt64();
+            break;
+        case KeyPatternConstant:
+            source[i].key = 0x0123456789ABCDEFull;
+            break;
+        case KeyPatternDescending:
+            source[i].key = uint64( numElements - i ) << 20u;
+            break;
+        }
+        source[i].originalIdx = i;
+    }
+
+    KeyValue64Vec reference = source;
+    std::stable_sort( reference.begin(), reference.end(), orderKeyValue64 );
+
+    KeyValue64Vec scratch( numElements );
+
+    // Whole array
+    KeyValue64Vec sorted = source;
+    const size_t numPasses =
+        KeyValue64RadixSort::sort( sorted.data(), scratch.data(), numElements );
+    if( !equalKeyValues( sorted, reference ) )
+    {
+        LogManager::getSingleton().logMessage( testName + ": sort() differs from std::stable_sort" );
+        return false;
+    }
+
+    // Only the two varying byte columns need a pass
+    if( keyPattern == KeyPatternFewDistinct && numElements >= 256u && numPasses != 2u )
+    {
+        LogManager::getSingleton().logMessage( testName + ": expected 2 passes, got " +
+                                               StringConverter::toString( numPasses ) );
+        return false;
+    }
+
+    if( KeyValue64RadixSort::sort( sorted.data(), scratch.data(), numElements ) != 0u )
+    {
+        LogManager::getSingleton().logMessage( testName + ": sorting sorted data did some pass" );
+        return false;
+    }
+
+    // Slices sorted in the worker threads, then merged
+    if( numElements > 0u )
+    {
+        const size_t sliceSize = std::max<size_t>( ( numElements + numSlices - 1u ) / numSlices, 1u );
+
+        sorted = source;
+        SortSlicesTask sortTask( sorted.data(), scratch.data(), numElements, sliceSize );
+        mGraphicsSystem->getSceneManager()->executeUserScalableTask( &sortTask, true );
+
+        KeyValue64RadixSort::mergeSortedSlices( sorted.data(), scratch.data(), numElements,
+                                                sliceSize );
+        if( !equalKeyValues( scratch, reference ) )
+        {
+            LogManager::getSingleton().logMessage( testName +
+                                                   ": merged slices differ from std::stable_sort" );
+            return false;
+        }
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+void RadixSortGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    LogManager::getSingleton().logMessage( "RadixSort64 test" );
+
+    const KeyPattern keyPatterns[] = { KeyPatternFewDistinct, KeyPatternRandom, KeyPatternConstant,
+                                       KeyPatternDescending };
+    const size_t sizes[] = { 0u, 1u, 2u, 5u, 255u, 256u, 1000u, 4099u, 65536u };
+    const size_t numSlices[] = { 1u, 2u, 3u, 7u, 16u };
+
+    size_t numFailures = 0u;
+    for( size_t i = 0; i < sizeof( keyPatterns ) / sizeof( keyPatterns[0] ); ++i )
+    {
+        for( size_t j = 0; j < sizeof( sizes ) / sizeof( sizes[0] ); ++j )
+        {
+            for( size_t k = 0; k < sizeof( numSlices ) / sizeof( numSlices[0] ); ++k )
+            {
+                if( !runTest( keyPatterns[i], sizes[j], numSlices[k] ) )
+                    ++numFailures;
+            }
+        }
+    }
+
+    LogManager::getSingleton().logMessage( "RadixSort64 test: " +
+                                           StringConverter::toString( numFailures ) + " failures" );
+
+    OGRE_ASSERT( numFailures == 0u && "RadixSort64 doesn't match std::stable_sort" );
+
+    mGraphicsSystem->setQuit();
+}
@@ -0,0 +1,47 @@
+
+#ifndef Demo_RadixSortGameState_H
+#define Demo_RadixSortGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class RadixSortGameState : public TutorialGameState
+    {
+    public:
+        enum KeyPattern
+        {
+            /// Only the highest and lowest bytes vary, with few distinct values.
+            /// Lots of equal keys (tests stability) and constant byte columns
+            KeyPatternFewDistinct,
+            /// Every bit is random
+            KeyPatternRandom,
+            /// All keys are the same
+            KeyPatternConstant,
+            /// Sorted backwards
+            KeyPatternDescending
+        };
+
+    private:
+        Ogre::uint64 mSeed;
+
+        Ogre::uint64 randomUInt64();
+
+        /** Sorts an array of reproducible keys with RadixSort64 as a whole, then split in
+            numSlices slices sorted by the SceneManager's worker threads and merged with
+            RadixSort64::mergeSortedSlices, and compares both against std::stable_sort.
+        @return
+            False if any of the results differs from the reference.
+        */
+        bool runTest( KeyPattern keyPattern, size_t numElements, size_t numSlices );
+
+    public:
+        RadixSortGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
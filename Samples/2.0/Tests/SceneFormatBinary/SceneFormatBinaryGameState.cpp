@@ -0,0 +1,238 @@
+
+#include "SceneFormatBinaryGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreMeshManager2.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include "OgreSceneFormatExporter.h"
+#include "OgreSceneFormatImporter.h"
+
+#include <algorithm>
+
+using namespace Demo;
+
+static const size_t c_numParents = 256u;
+static const size_t c_numChildrenPerParent = 16u;
+static const size_t c_numIterations = 5u;
+
+static const Ogre::uint32 c_sceneFlags = Ogre::SceneFlags::SceneNodes | Ogre::SceneFlags::Items;
+
+SceneFormatBinaryGameState::SceneFormatBinaryGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription ),
+    mSceneRoot( 0 )
+{
+}
+//-----------------------------------------------------------------------------------
+void SceneFormatBinaryGameState::createScene01()
+{
+    TutorialGameState::createScene01();
+
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    // Load it upfront so that the benchmark doesn't measure disk access
+    MeshManager::getSingleton().load( "Cube_d.mesh",
+                                      ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME );
+
+    mSceneRoot = sceneManager->getRootSceneNode( SCENE_DYNAMIC )->createChildSceneNode( SCENE_DYNAMIC );
+
+    for( size_t i = 0; i < c_numParents; ++i )
+    {
+        SceneNode *parentNode = mSceneRoot->createChildSceneNode( SCENE_DYNAMIC );
+        parentNode->setPosition( Real( i % 16u ) * 10.0f, 0.0f, Real( i / 16u ) * 10.0f );
+        parentNode->setOrientation( Quaternion( Degree( Real( i ) ), Vector3::UNIT_Y ) );
+
+        for( size_t j = 0; j < c_numChildrenPerParent; ++j )
+        {
+            Item *item = sceneManager->createItem(
+                "Cube_d.mesh", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, SCENE_DYNAMIC );
+            item->setName( "Cube " + StringConverter::toString( i * c_numChildrenPerParent + j ) );
+
+            SceneNode *sceneNode = parentNode->createChildSceneNode( SCENE_DYNAMIC );
+            sceneNode->setPosition( Real( j % 4u ) * 2.0f, 0.0f, Real( j / 4u ) * 2.0f );
+            sceneNode->setScale( 0.5f, 0.5f, 0.5f );
+            sceneNode->attachObject( item );
+        }
+    }
+}
+//-----------------------------------------------------------------------------------
+void SceneFormatBinaryGameState::destroyBenchmarkScene()
+{
+    Ogre::SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+    sceneManager->destroyAllItems();
+    mSceneRoot->removeAndDestroyAllChildren();
+}
+//-----------------------------------------------------------------------------------
+void SceneFormatBinaryGameState::getItemTransforms( Ogre::SceneNode *sceneNode,
+                                                    ItemTransformVec &outTransforms )
+{
+    const size_t numAttachedObjects = sceneNode->numAttachedObjects();
+    for( size_t i = 0; i < numAttachedObjects; ++i )
+    {
+        ItemTransform itemTransform;
+        itemTransform.name = sceneNode->getAttachedObject( i )->getName();
+        itemTransform.position = sceneNode->_getDerivedPositionUpdated();
+        itemTransform.orientation = sceneNode->_getDerivedOrientationUpdated();
+        itemTransform.scale = sceneNode->_getDerivedScaleUpdated();
+        outTransforms.push_back( itemTransform );
+    }
+
+    const size_t numChildren = sceneNode->numChildren();
+    for( size_t i = 0; i < numChildren; ++i )
+    {
+        getItemTransforms( static_cast<Ogre::SceneNode *>( sceneNode->getChild( i ) ),
+                           outTransforms );
+    }
+}
+//-----------------------------------------------------------------------------------
+size_t SceneFormatBinaryGameState::compareItemTransforms( const ItemTransformVec &a,
+                                                          const ItemTransformVec &b )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    if( a.size() != b.size() )
+    {
+        logManager.logMessage( "Imported " + StringConverter::toString( a.size() ) +
+                               " Items from JSON but " + StringConverter::toString( b.size() ) +
+                               " from binary" );
+        return 1u;
+    }
+
+    size_t numMismatches = 0u;
+
+    for( size_t i = 0; i < a.size(); ++i )
+    {
+        // Floats are exported as binary in both formats, thus they must match exactly
+        if( a[i].name != b[i].name || a[i].position != b[i].position ||
+            a[i].orientation != b[i].orientation || a[i].scale != b[i].scale )
+        {
+            logManager.logMessage( "Item " + a[i].name + " differs from binary Item " + b[i].name );
+            ++numMismatches;
+        }
+    }
+
+    return numMismatches;
+}
+//-----------------------------------------------------------------------------------
+double SceneFormatBinaryGameState::runJsonBenchmark( const Ogre::String &json, size_t numIterations,
+                                                     ItemTransformVec *outTransforms )
+{
+    Ogre::SceneFormatImporter importer( mGraphicsSystem->getRoot(),
+                                        mGraphicsSystem->getSceneManager(), Ogre::BLANKSTRING );
+    // The exported root node gets mapped to mSceneRoot, so that destroyBenchmarkScene
+    // cleans up everything that was imported
+    importer.setRootNodes( mSceneRoot, 0 );
+
+    Ogre::Timer timer;
+    Ogre::uint64 totalTime = 0;
+
+    for( size_t i = 0; i < numIterations; ++i )
+    {
+        const Ogre::uint64 startTime = timer.getMicroseconds();
+        importer.importScene( "SceneFormatBinary.json", json.c_str(), c_sceneFlags );
+        totalTime += timer.getMicroseconds() - startTime;
+
+        if( outTransforms && i + 1u == numIterations )
+        {
+            outTransforms->clear();
+            getItemTransforms( mSceneRoot, *outTransforms );
+            std::sort( outTransforms->begin(), outTransforms->end() );
+        }
+
+        destroyBenchmarkScene();
+    }
+
+    return double( totalTime ) / double( numIterations );
+}
+//-----------------------------------------------------------------------------------
+double SceneFormatBinaryGameState::runBinaryBenchmark( const Ogre::vector<Ogre::uint8>::type &binary,
+                                                       size_t numIterations,
+                                                       ItemTransformVec *outTransforms )
+{
+    Ogre::SceneFormatImporter importer( mGraphicsSystem->getRoot(),
+                                        mGraphicsSystem->getSceneManager(), Ogre::BLANKSTRING );
+    importer.setRootNodes( mSceneRoot, 0 );
+
+    Ogre::Timer timer;
+    Ogre::uint64 totalTime = 0;
+
+    for( size_t i = 0; i < numIterations; ++i )
+    {
+        const Ogre::uint64 startTime = timer.getMicroseconds();
+        importer.importSceneBinary( "SceneFormatBinary.bin", &binary[0], binary.size(),
+                                    c_sceneFlags );
+        totalTime += timer.getMicroseconds() - startTime;
+
+        if( outTransforms && i + 1u == numIterations )
+        {
+            outTransforms->clear();
+            getItemTransforms( mSceneRoot, *outTransforms );
+            std::sort( outTransforms->begin(), outTransforms->end() );
+        }
+
+        destroyBenchmarkScene();
+    }
+
+    return double( totalTime ) / double( numIterations );
+}
+//-----------------------------------------------------------------------------------
+void SceneFormatBinaryGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    String json;
+    vector<uint8>::type binary;
+
+    {
+        SceneFormatExporter exporter( mGraphicsSystem->getRoot(), mGraphicsSystem->getSceneManager(),
+                                      0 );
+        exporter.exportScene( json, c_sceneFlags );
+        exporter.exportSceneBinary( binary, c_sceneFlags );
+    }
+
+    destroyBenchmarkScene();
+
+    // Warm up the caches
+    runJsonBenchmark( json, 1u );
+    runBinaryBenchmark( binary, 1u );
+
+    ItemTransformVec jsonTransforms;
+    ItemTransformVec binaryTransforms;
+    const double jsonTime = runJsonBenchmark( json, c_numIterations, &jsonTransforms );
+    const double binaryTime = runBinaryBenchmark( binary, c_numIterations, &binaryTransforms );
+
+    LogManager &logManager = LogManager::getSingleton();
+    logManager.logMessage( "Binary scene format benchmark. Nodes: " +
+                           StringConverter::toString( c_numParents * ( c_numChildrenPerParent + 1u ) ) +
+                           " Items: " +
+                           StringConverter::toString( c_numParents * c_numChildrenPerParent ) );
+    logManager.logMessage( "JSON: " + StringConverter::toString( json.size() ) + " bytes; " +
+                           StringConverter::toString( Real( jsonTime / 1000.0 ) ) + " ms per import" );
+    logManager.logMessage( "Binary: " + StringConverter::toString( binary.size() ) + " bytes; " +
+                           StringConverter::toString( Real( binaryTime / 1000.0 ) ) +
+                           " ms per import" );
+    if( binaryTime > 0.0 )
+    {
+        logManager.logMessage( "Binary loads " +
+                               StringConverter::toString( Real( jsonTime / binaryTime ) ) +
+                               "x as fast as JSON" );
+    }
+
+    const size_t numMismatches = compareItemTransforms( jsonTransforms, binaryTransforms );
+    OGRE_ASSERT( jsonTransforms.size() == c_numParents * c_numChildrenPerParent &&
+                 numMismatches == 0u && "Binary import doesn't match JSON import" );
+    OGRE_UNUSED_VAR( numMismatches );
+
+    mGraphicsSystem->setQuit();
+}
@@ -0,0 +1,60 @@
+
+#ifndef Demo_SceneFormatBinaryGameState_H
+#define Demo_SceneFormatBinaryGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgreQuaternion.h"
+#include "OgreVector3.h"
+
+#include "TutorialGameState.h"
+
+#include "ogrestd/vector.h"
+
+namespace Demo
+{
+    class SceneFormatBinaryGameState : public TutorialGameState
+    {
+        struct ItemTransform
+        {
+            Ogre::String     name;
+            Ogre::Vector3    position;
+            Ogre::Quaternion orientation;
+            Ogre::Vector3    scale;
+
+            bool operator<( const ItemTransform &other ) const { return name < other.name; }
+        };
+        typedef Ogre::vector<ItemTransform>::type ItemTransformVec;
+
+        /// All the benchmarked nodes hang from it
+        Ogre::SceneNode *mSceneRoot;
+
+        /// Destroys all Items and the children of mSceneRoot
+        void destroyBenchmarkScene();
+
+        /// Collects the derived transform of every Item below sceneNode (unsorted)
+        static void getItemTransforms( Ogre::SceneNode *sceneNode, ItemTransformVec &outTransforms );
+
+        /** Logs every Item that is missing or placed differently in b and returns how many
+            there were. Both must be sorted.
+        */
+        static size_t compareItemTransforms( const ItemTransformVec &a, const ItemTransformVec &b );
+
+        /** Returns the average time in microseconds of each import
+        @param outTransforms [out]
+            Optional. Receives the sorted transforms of the imported Items.
+        */
+        double runJsonBenchmark( const Ogre::String &json, size_t numIterations,
+                                 ItemTransformVec *outTransforms = 0 );
+        double runBinaryBenchmark( const Ogre::vector<Ogre::uint8>::type &binary,
+                                   size_t numIterations, ItemTransformVec *outTransforms = 0 );
+
+    public:
+        SceneFormatBinaryGameState( const Ogre::String &helpDescription );
+
+        void createScene01() override;
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
@@ -0,0 +1,342 @@
+
+#include "SceneQueryBvhGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreMeshManager2.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneQueryBvh.h"
+#include "OgreStringConverter.h"
+
+using namespace Demo;
+
+static const size_t c_numItems = 2048u;
+static const size_t c_numQueriesPerType = 512u;
+static const Ogre::Real c_sceneHalfSize = 100.0f;
+static const Ogre::uint32 c_queryMasks[3] = { 0xFFFFFFFF, 1u, 2u };
+
+SceneQueryBvhGameState::SceneQueryBvhGameState( const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription ),
+    mFrame( 0u ),
+    mSeed( 12345u )
+{
+}
+//-----------------------------------------------------------------------------------
+Ogre::Real SceneQueryBvhGameState::randomReal( Ogre::Real minValue, Ogre::Real maxValue )
+{
+    mSeed = mSeed * 1664525u + 1013904223u;
+    const Ogre::Real unitValue = Ogre::Real( mSeed >> 8u ) / Ogre::Real( 1u << 24u );
+    return minValue + unitValue * ( maxValue - minValue );
+}
+//-----------------------------------------------------------------------------------
+void SceneQueryBvhGameState::createScene01()
+{
+    TutorialGameState::createScene01();
+
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    MeshManager::getSingleton().load( "Cube_d.mesh",
+                                      ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME );
+
+    mSceneNodes.reserve( c_numItems );
+    for( size_t i = 0; i < c_numItems; ++i )
+    {
+        // Static objects are only refitted when flagged as dirty. Test both kinds.
+        const SceneMemoryMgrTypes sceneType = ( i % 3u ) == 0u ? SCENE_STATIC : SCENE_DYNAMIC;
+
+        Item *item = sceneManager->createItem(
+            "Cube_d.mesh", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, sceneType );
+        // Half of the objects can only be found with each mask
+        item->setQueryFlags( ( i & 0x01u ) ? 1u : 2u );
+
+        SceneNode *sceneNode =
+            sceneManager->getRootSceneNode( sceneType )->createChildSceneNode( sceneType );
+        sceneNode->setPosition( randomReal( -c_sceneHalfSize, c_sceneHalfSize ),
+                                randomReal( -c_sceneHalfSize, c_sceneHalfSize ),
+                                randomReal( -c_sceneHalfSize, c_sceneHalfSize ) );
+        sceneNode->setOrientation(
+            Quaternion( Radian( randomReal( 0.0f, Math::TWO_PI ) ), Vector3::UNIT_Y ) );
+        sceneNode->setScale( Vector3( randomReal( 0.25f, 4.0f ) ) );
+        sceneNode->attachObject( item );
+
+        mSceneNodes.push_back( sceneNode );
+    }
+
+    const Real extent = c_sceneHalfSize * 1.2f;
+    for( size_t i = 0; i < c_numQueriesPerType; ++i )
+    {
+        Vector3 origin( randomReal( -extent, extent ), randomReal( -extent, extent ),
+                        randomReal( -extent, extent ) );
+        Vector3 dir( randomReal( -1.0f, 1.0f ), randomReal( -1.0f, 1.0f ),
+                     randomReal( -1.0f, 1.0f ) );
+        // Exercise rays parallel to the slabs too
+        if( ( i % 8u ) == 0u )
+            dir.y = 0.0f;
+        if( ( i % 16u ) == 0u )
+            dir.z = 0.0f;
+        if( dir.isZeroLength() )
+            dir = Vector3::UNIT_X;
+        dir.normalise();
+        mRays.push_back( Ray( origin, dir ) );
+
+        const Vector3 center( randomReal( -extent, extent ), randomReal( -extent, extent ),
+                              randomReal( -extent, extent ) );
+        mSpheres.push_back( Sphere( center, randomReal( 1.0f, 30.0f ) ) );
+
+        const Vector3 halfSize( randomReal( 1.0f, 30.0f ), randomReal( 1.0f, 30.0f ),
+                                randomReal( 1.0f, 30.0f ) );
+        mAabbs.push_back( AxisAlignedBox( center - halfSize, center + halfSize ) );
+    }
+}
+//-----------------------------------------------------------------------------------
+void SceneQueryBvhGameState::runQueries( QueryResults &outResults )
+{
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    outResults.rays.clear();
+    outResults.spheres.clear();
+    outResults.aabbs.clear();
+    outResults.nearest.clear();
+    outResults.nearestThreaded.clear();
+
+    RaySceneQuery *rayQuery = sceneManager->createRayQuery( Ray() );
+    rayQuery->setSortByDistance( true );
+    for( size_t i = 0; i < mRays.size(); ++i )
+    {
+        rayQuery->setRay( mRays[i] );
+        rayQuery->setQueryMask( c_queryMasks[i % 3u] );
+        RaySceneQueryResult result = rayQuery->execute();
+
+        // Entries at the same distance may come in any order
+        std::sort( result.begin(), result.end(),
+                   []( const RaySceneQueryResultEntry &a, const RaySceneQueryResultEntry &b )
+                   { return a.movable < b.movable; } );
+        outResults.rays.push_back( result );
+    }
+
+    // Batches use a single mask. c_queryMasks[0] matches what the
+    // rays with i % 3 == 0 used above, so these can be cross-checked.
+    rayQuery->setQueryMask( c_queryMasks[0] );
+    outResults.nearest.resize( mRays.size() );
+    rayQuery->executeBatch( &mRays[0], mRays.size(), &outResults.nearest[0], false );
+    outResults.nearestThreaded.resize( mRays.size() );
+    rayQuery->executeBatch( &mRays[0], mRays.size(), &outResults.nearestThreaded[0], true );
+    sceneManager->destroyQuery( rayQuery );
+
+    SphereSceneQuery *sphereQuery = sceneManager->createSphereQuery( Sphere() );
+    for( size_t i = 0; i < mSpheres.size(); ++i )
+    {
+        sphereQuery->setSphere( mSpheres[i] );
+        sphereQuery->setQueryMask( c_queryMasks[i % 3u] );
+        const SceneQueryResult &result = sphereQuery->execute();
+        MovableObjectVec movables( result.movables.begin(), result.movables.end() );
+        std::sort( movables.begin(), movables.end() );
+        outResults.spheres.push_back( movables );
+    }
+    sceneManager->destroyQuery( sphereQuery );
+
+    AxisAlignedBoxSceneQuery *aabbQuery = sceneManager->createAABBQuery( AxisAlignedBox() );
+    for( size_t i = 0; i < mAabbs.size(); ++i )
+    {
+        aabbQuery->setBox( mAabbs[i] );
+        aabbQuery->setQueryMask( c_queryMasks[i % 3u] );
+        const SceneQueryResult &result = aabbQuery->execute();
+        MovableObjectVec movables( result.movables.begin(), result.movables.end() );
+        std::sort( movables.begin(), movables.end() );
+        outResults.aabbs.push_back( movables );
+    }
+    sceneManager->destroyQuery( aabbQuery );
+}
+//-----------------------------------------------------------------------------------
+size_t SceneQueryBvhGameState::compareResults( const QueryResults &bruteForce,
+                                               const QueryResults &bvh, const char *stage )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    size_t numMismatches = 0u;
+    size_t numHits = 0u;
+
+    for( size_t i = 0; i < bruteForce.rays.size(); ++i )
+    {
+        const RaySceneQueryResult &expected = bruteForce.rays[i];
+        const RaySceneQueryResult &actual = bvh.rays[i];
+
+        bool bMatches = expected.size() == actual.size();
+        for( size_t j = 0; j < expected.size() && bMatches; ++j )
+        {
+            const Real tolerance = std::max( expected[j].distance, Real( 1.0f ) ) * 1e-4f;
+            bMatches = expected[j].movable == actual[j].movable &&
+                       Math::Abs( expected[j].distance - actual[j].distance ) <= tolerance;
+        }
+
+        if( !bMatches )
+        {
+            logManager.logMessage( String( stage ) + ": ray #" + StringConverter::toString( i ) +
+                                   " hit " + StringConverter::toString( actual.size() ) +
+                                   " objects. Brute force hit " +
+                                   StringConverter::toString( expected.size() ) );
+            ++numMismatches;
+        }
+        numHits += expected.size();
+    }
+
+    for( size_t i = 0; i < bruteForce.spheres.size(); ++i )
+    {
+        if( bruteForce.spheres[i] != bvh.spheres[i] )
+        {
+            logManager.logMessage( String( stage ) + ": sphere #" + StringConverter::toString( i ) +
+                                   " found " + StringConverter::toString( bvh.spheres[i].size() ) +
+                                   " objects. Brute force found " +
+                                   StringConverter::toString( bruteForce.spheres[i].size() ) );
+            ++numMismatches;
+        }
+        numHits += bruteForce.spheres[i].size();
+    }
+
+    for( size_t i = 0; i < bruteForce.aabbs.size(); ++i )
+    {
+        if( bruteForce.aabbs[i] != bvh.aabbs[i] )
+        {
+            logManager.logMessage( String( stage ) + ": aabb #" + StringConverter::toString( i ) +
+                                   " found " + StringConverter::toString( bvh.aabbs[i].size() ) +
+                                   " objects. Brute force found " +
+                                   StringConverter::toString( bruteForce.aabbs[i].size() ) );
+            ++numMismatches;
+        }
+        numHits += bruteForce.aabbs[i].size();
+    }
+
+    logManager.logMessage( String( stage ) + ": " + StringConverter::toString( numHits ) +
+                           " hits in total, " + StringConverter::toString( numMismatches ) +
+                           " queries differ from brute force" );
+
+    return numMismatches;
+}
+//-----------------------------------------------------------------------------------
+size_t SceneQueryBvhGameState::compareNearestHits( const QueryResults &results, const char *stage )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    size_t numMismatches = 0u;
+
+    for( size_t i = 0; i < mRays.size(); ++i )
+    {
+        const RaySceneQueryBatchResult &nearest = results.nearest[i];
+        const RaySceneQueryBatchResult &nearestThreaded = results.nearestThreaded[i];
+
+        // Splitting the batch across threads must not change anything
+        bool bMatches = nearest.movable == nearestThreaded.movable &&
+                        ( !nearest.movable || nearest.distance == nearestThreaded.distance );
+
+        if( bMatches && ( i % 3u ) == 0u )
+        {
+            // The full ray query with the same mask must agree on the nearest distance.
+            // Objects at the same distance may be reported in any order though.
+            const RaySceneQueryResult &rayResult = results.rays[i];
+            const RaySceneQueryResultEntry *expected = 0;
+            for( size_t j = 0; j < rayResult.size(); ++j )
+            {
+                if( !expected || rayResult[j].distance < expected->distance )
+                    expected = &rayResult[j];
+            }
+
+            if( !expected )
+                bMatches = nearest.movable == 0;
+            else
+            {
+                const Real tolerance = std::max( expected->distance, Real( 1.0f ) ) * 1e-4f;
+                bMatches = nearest.movable != 0 &&
+                           Math::Abs( expected->distance - nearest.distance ) <= tolerance;
+            }
+        }
+
+        if( !bMatches )
+        {
+            logManager.logMessage( String( stage ) + ": executeBatch ray #" +
+                                   StringConverter::toString( i ) +
+                                   " nearest hit differs. Distance: " +
+                                   StringConverter::toString( nearest.distance ) +
+                                   " threaded: " +
+                                   StringConverter::toString( nearestThreaded.distance ) );
+            ++numMismatches;
+        }
+    }
+
+    logManager.logMessage( String( stage ) + ": " + StringConverter::toString( numMismatches ) +
+                           " executeBatch rays differ from RaySceneQuery::execute" );
+
+    return numMismatches;
+}
+//-----------------------------------------------------------------------------------
+void SceneQueryBvhGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    // The world bounds are only known after the first updateSceneGraph
+    if( mFrame == 1u )
+    {
+        // Freshly built tree
+        QueryResults bruteForce, bvh;
+        sceneManager->setSceneQueryBvhEnabled( false );
+        runQueries( bruteForce );
+        sceneManager->setSceneQueryBvhEnabled( true );
+        OGRE_ASSERT( sceneManager->_getSceneQueryBvh()->isUpToDate() );
+        runQueries( bvh );
+
+        size_t numMismatches = compareResults( bruteForce, bvh, "Build" );
+        numMismatches += compareNearestHits( bruteForce, "Build (brute force)" );
+        numMismatches += compareNearestHits( bvh, "Build (BVH)" );
+        if( numMismatches != 0u )
+        {
+            OGRE_EXCEPT( Exception::ERR_RT_ASSERTION_FAILED,
+                         "Scene query results differ. See Ogre.log", "Test failed!" );
+        }
+
+        // Move and scale half of the objects, so that the next
+        // updateSceneGraph has to refit the tree
+        for( size_t i = 0; i < mSceneNodes.size(); i += 2u )
+        {
+            mSceneNodes[i]->translate( randomReal( -10.0f, 10.0f ), randomReal( -10.0f, 10.0f ),
+                                       randomReal( -10.0f, 10.0f ) );
+            mSceneNodes[i]->setScale( Vector3( randomReal( 0.25f, 4.0f ) ) );
+            if( mSceneNodes[i]->isStatic() )
+                sceneManager->notifyStaticDirty( mSceneNodes[i] );
+        }
+    }
+    else if( mFrame == 2u )
+    {
+        // Refitted tree. Query it before disabling it, which would destroy it.
+        QueryResults bruteForce, bvh;
+        OGRE_ASSERT( sceneManager->_getSceneQueryBvh()->isUpToDate() );
+        runQueries( bvh );
+        sceneManager->setSceneQueryBvhEnabled( false );
+        runQueries( bruteForce );
+
+        size_t numMismatches = compareResults( bruteForce, bvh, "Refit" );
+        numMismatches += compareNearestHits( bruteForce, "Refit (brute force)" );
+        numMismatches += compareNearestHits( bvh, "Refit (BVH)" );
+        if( numMismatches != 0u )
+        {
+            OGRE_EXCEPT( Exception::ERR_RT_ASSERTION_FAILED,
+                         "Scene query results differ. See Ogre.log", "Test failed!" );
+        }
+
+        mGraphicsSystem->setQuit();
+    }
+
+    ++mFrame;
+}
@@ -0,0 +1,63 @@
+
+#ifndef Demo_SceneQueryBvhGameState_H
+#define Demo_SceneQueryBvhGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgreAxisAlignedBox.h"
+#include "OgreRay.h"
+#include "OgreSceneQuery.h"
+#include "OgreSphere.h"
+
+#include "TutorialGameState.h"
+
+#include "ogrestd/vector.h"
+
+namespace Demo
+{
+    class SceneQueryBvhGameState : public TutorialGameState
+    {
+        typedef Ogre::vector<Ogre::MovableObject *>::type MovableObjectVec;
+
+        struct QueryResults
+        {
+            Ogre::vector<Ogre::RaySceneQueryResult>::type      rays;
+            Ogre::vector<MovableObjectVec>::type               spheres;
+            Ogre::vector<MovableObjectVec>::type               aabbs;
+            /// RaySceneQuery::executeBatch of mRays, without and with worker threads
+            Ogre::vector<Ogre::RaySceneQueryBatchResult>::type nearest;
+            Ogre::vector<Ogre::RaySceneQueryBatchResult>::type nearestThreaded;
+        };
+
+        Ogre::vector<Ogre::SceneNode *>::type    mSceneNodes;
+        Ogre::vector<Ogre::Ray>::type            mRays;
+        Ogre::vector<Ogre::Sphere>::type         mSpheres;
+        Ogre::vector<Ogre::AxisAlignedBox>::type mAabbs;
+        Ogre::uint32                             mFrame;
+        /// Reproducible random numbers
+        Ogre::uint32 mSeed;
+
+        Ogre::Real randomReal( Ogre::Real minValue, Ogre::Real maxValue );
+
+        /// Runs every query in mRays, mSpheres and mAabbs using whatever path the
+        /// SceneManager currently uses (brute force or BVH). Results are sorted by
+        /// pointer so they can be compared regardless of the traversal order.
+        void runQueries( QueryResults &outResults );
+
+        /// Logs every mismatch between both sets of results and returns how many there were.
+        size_t compareResults( const QueryResults &bruteForce, const QueryResults &bvh,
+                               const char *stage );
+
+        /// Checks the nearest hits of executeBatch against the sorted ray query results.
+        /// Logs every mismatch and returns how many there were.
+        size_t compareNearestHits( const QueryResults &results, const char *stage );
+
+    public:
+        SceneQueryBvhGameState( const Ogre::String &helpDescription );
+
+        void createScene01() override;
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
@@ -0,0 +1,297 @@
+
+#include "SkeletonInstanceUpdateGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreMesh.h"
+#include "OgreMesh2.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshManager2.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+
+#include "Animation/OgreSkeletonAnimation.h"
+#include "Animation/OgreSkeletonInstance.h"
+
+using namespace Demo;
+
+static const size_t c_numThrottled = 3u;
+static const Ogre::uint8 c_updateInterval = 3u;
+static const size_t c_numFollowers = 3u;
+static const size_t c_numFrames = 12u;
+
+SkeletonInstanceUpdateGameState::SkeletonInstanceUpdateGameState(
+    const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription ),
+    mReference( 0 ),
+    mFrozen( 0 ),
+    mPoseSource( 0 ),
+    mFirstFrame( true )
+{
+}
+//-----------------------------------------------------------------------------------
+Ogre::SkeletonInstance *SkeletonInstanceUpdateGameState::createInstance( size_t idx )
+{
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    Item *item = sceneManager->createItem(
+        "char_reference.mesh", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, SCENE_DYNAMIC );
+    SceneNode *sceneNode =
+        sceneManager->getRootSceneNode( SCENE_DYNAMIC )->createChildSceneNode( SCENE_DYNAMIC );
+    sceneNode->setPosition( Real( idx ) * 2.0f, 0.0f, 0.0f );
+    sceneNode->attachObject( item );
+
+    SkeletonInstance *skeletonInstance = item->getSkeletonInstance();
+    skeletonInstance->addAnimationsFromSkeleton(
+        "char_mining.skeleton", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME );
+    SkeletonAnimation *animation = skeletonInstance->getAnimation( "char_mining" );
+    animation->setEnabled( true );
+    mAnimations.push_back( animation );
+
+    return skeletonInstance;
+}
+//-----------------------------------------------------------------------------------
+void SkeletonInstanceUpdateGameState::createScene01()
+{
+    TutorialGameState::createScene01();
+
+    using namespace Ogre;
+
+    v1::MeshPtr v1Mesh = v1::MeshManager::getSingleton().load(
+        "char_reference.mesh", ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+        v1::HardwareBuffer::HBU_STATIC, v1::HardwareBuffer::HBU_STATIC );
+    MeshManager::getSingleton().createByImportingV1( "char_reference.mesh",
+                                                     ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+                                                     v1Mesh.get(), true, true, false );
+    v1Mesh->unload();
+
+    size_t idx = 0u;
+    mReference = createInstance( idx++ );
+
+    for( size_t i = 0; i < c_numThrottled; ++i )
+    {
+        SkeletonInstance *skeletonInstance = createInstance( idx++ );
+        skeletonInstance->setUpdateInterval( c_updateInterval );
+        mThrottled.push_back( skeletonInstance );
+    }
+
+    mFrozen = createInstance( idx++ );
+    mFrozen->setUpdateInterval( 0u );
+
+    mPoseSource = createInstance( idx++ );
+    for( size_t i = 0; i < c_numFollowers; ++i )
+    {
+        SkeletonInstance *skeletonInstance = createInstance( idx++ );
+        skeletonInstance->setSharedPoseSource( mPoseSource );
+        mFollowers.push_back( skeletonInstance );
+    }
+}
+//-----------------------------------------------------------------------------------
+void SkeletonInstanceUpdateGameState::getPose( Ogre::SkeletonInstance *skeletonInstance,
+                                               Pose &outPose )
+{
+    const size_t numBones = skeletonInstance->getNumBones();
+    outPose.resize( numBones );
+    for( size_t i = 0; i < numBones; ++i )
+    {
+        const Ogre::Bone *bone = skeletonInstance->getBone( i );
+        outPose[i].position = bone->getPosition();
+        outPose[i].orientation = bone->getOrientation();
+        outPose[i].scale = bone->getScale();
+    }
+}
+//-----------------------------------------------------------------------------------
+bool SkeletonInstanceUpdateGameState::posesEqual( const Pose &a, const Pose &b,
+                                                  Ogre::Real tolerance )
+{
+    using namespace Ogre;
+
+    if( a.size() != b.size() )
+        return false;
+
+    for( size_t i = 0; i < a.size(); ++i )
+    {
+        if( !a[i].position.positionEquals( b[i].position, tolerance ) ||
+            !a[i].scale.positionEquals( b[i].scale, tolerance ) )
+        {
+            return false;
+        }
+        for( size_t j = 0; j < 4u; ++j )
+        {
+            if( Math::Abs( a[i].orientation[j] - b[i].orientation[j] ) > tolerance )
+                return false;
+        }
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+void SkeletonInstanceUpdateGameState::advanceFrame()
+{
+    std::vector<Ogre::SkeletonAnimation *>::const_iterator itor = mAnimations.begin();
+    std::vector<Ogre::SkeletonAnimation *>::const_iterator endt = mAnimations.end();
+    while( itor != endt )
+    {
+        ( *itor )->addTime( 1.0f / 60.0f );
+        ++itor;
+    }
+
+    mGraphicsSystem->getSceneManager()->updateAllAnimations();
+}
+//-----------------------------------------------------------------------------------
+size_t SkeletonInstanceUpdateGameState::testThrottling()
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    size_t numFailures = 0u;
+
+    std::vector<Pose> prevPoses( c_numThrottled );
+    for( size_t i = 0; i < c_numThrottled; ++i )
+        getPose( mThrottled[i], prevPoses[i] );
+
+    Pose frozenPose;
+    getPose( mFrozen, frozenPose );
+
+    std::vector<std::vector<size_t> > sampledFrames( c_numThrottled );
+
+    Pose referencePose;
+    Pose pose;
+
+    for( size_t frame = 0; frame < c_numFrames; ++frame )
+    {
+        advanceFrame();
+
+        getPose( mReference, referencePose );
+
+        for( size_t i = 0; i < c_numThrottled; ++i )
+        {
+            getPose( mThrottled[i], pose );
+
+            // When sampled, it must be at the same time as everyone else
+            if( !posesEqual( pose, prevPoses[i] ) )
+            {
+                if( !posesEqual( pose, referencePose ) )
+                {
+                    logManager.logMessage( "Throttled instance " + StringConverter::toString( i ) +
+                                           ", frame " + StringConverter::toString( frame ) +
+                                           ": pose differs from the reference" );
+                    ++numFailures;
+                }
+                sampledFrames[i].push_back( frame );
+            }
+
+            prevPoses[i].swap( pose );
+        }
+
+        getPose( mFrozen, pose );
+        if( !posesEqual( pose, frozenPose ) )
+        {
+            logManager.logMessage( "Frame " + StringConverter::toString( frame ) +
+                                   ": the frozen instance changed" );
+            ++numFailures;
+        }
+    }
+
+    for( size_t i = 0; i < c_numThrottled; ++i )
+    {
+        const std::vector<size_t> &frames = sampledFrames[i];
+
+        bool bOk = frames.size() == c_numFrames / c_updateInterval && frames[0] < c_updateInterval;
+        for( size_t j = 1u; j < frames.size() && bOk; ++j )
+            bOk = frames[j] - frames[j - 1u] == c_updateInterval;
+
+        // Each instance gets the next frame offset, thus it is sampled one frame earlier
+        if( bOk && i > 0u && !sampledFrames[i - 1u].empty() )
+            bOk = ( frames[0] + 1u ) % c_updateInterval == sampledFrames[i - 1u][0];
+
+        if( !bOk )
+        {
+            String framesStr;
+            for( size_t j = 0; j < frames.size(); ++j )
+                framesStr += " " + StringConverter::toString( frames[j] );
+            logManager.logMessage( "Throttled instance " + StringConverter::toString( i ) +
+                                   " was sampled in frames" + framesStr );
+            ++numFailures;
+        }
+    }
+
+    return numFailures;
+}
+//-----------------------------------------------------------------------------------
+size_t SkeletonInstanceUpdateGameState::testSharedPose()
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    size_t numFailures = 0u;
+
+    Pose prevReferencePose;
+    getPose( mReference, prevReferencePose );
+
+    Pose referencePose;
+    Pose pose;
+
+    for( size_t frame = 0; frame < c_numFrames; ++frame )
+    {
+        advanceFrame();
+
+        getPose( mReference, referencePose );
+
+        getPose( mPoseSource, pose );
+        if( !posesEqual( pose, referencePose ) )
+        {
+            logManager.logMessage( "Frame " + StringConverter::toString( frame ) +
+                                   ": the pose source differs from the reference" );
+            ++numFailures;
+        }
+
+        // Followers are one frame late. Copying the pose goes through a lerp
+        // against the manual bone mask, which may not be exact
+        for( size_t i = 0; i < c_numFollowers; ++i )
+        {
+            getPose( mFollowers[i], pose );
+            if( !posesEqual( pose, prevReferencePose, 1e-5f ) )
+            {
+                logManager.logMessage( "Follower " + StringConverter::toString( i ) + ", frame " +
+                                       StringConverter::toString( frame ) +
+                                       ": pose differs from the reference's previous frame" );
+                ++numFailures;
+            }
+        }
+
+        prevReferencePose.swap( referencePose );
+    }
+
+    return numFailures;
+}
+//-----------------------------------------------------------------------------------
+void SkeletonInstanceUpdateGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    if( mFirstFrame )
+    {
+        // SceneManager::updateAllAnimations needs the list of
+        // SkeletonAnimManagers to update, which gets built after rendering.
+        mFirstFrame = false;
+        return;
+    }
+
+    using namespace Ogre;
+
+    LogManager::getSingleton().logMessage( "SkeletonInstance update test" );
+
+    size_t numFailures = testThrottling();
+    numFailures += testSharedPose();
+
+    OGRE_ASSERT( numFailures == 0u && "SkeletonInstance updates don't match the settings" );
+
+    mGraphicsSystem->setQuit();
+}
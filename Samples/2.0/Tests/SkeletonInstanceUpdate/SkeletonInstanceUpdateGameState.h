@@ -0,0 +1,81 @@
+
+#ifndef Demo_SkeletonInstanceUpdateGameState_H
+#define Demo_SkeletonInstanceUpdateGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgreQuaternion.h"
+#include "OgreVector3.h"
+
+#include "TutorialGameState.h"
+
+#include <vector>
+
+namespace Ogre
+{
+    class SkeletonAnimation;
+}
+
+namespace Demo
+{
+    class SkeletonInstanceUpdateGameState : public TutorialGameState
+    {
+        struct BonePose
+        {
+            Ogre::Vector3    position;
+            Ogre::Quaternion orientation;
+            Ogre::Vector3    scale;
+        };
+        typedef std::vector<BonePose> Pose;
+
+        std::vector<Ogre::SkeletonAnimation *> mAnimations;
+
+        /// Samples every frame. Everything else is compared against it
+        Ogre::SkeletonInstance *mReference;
+        /// Created one after the other, thus their update frames are staggered
+        std::vector<Ogre::SkeletonInstance *> mThrottled;
+        Ogre::SkeletonInstance *mFrozen;
+        /// Plays the animation in sync with the reference, for mFollowers
+        Ogre::SkeletonInstance *mPoseSource;
+        /// Take their pose from mPoseSource (@see SkeletonInstance::setSharedPoseSource)
+        std::vector<Ogre::SkeletonInstance *> mFollowers;
+
+        /// We need at least one frame rendered before we can call updateAllAnimations
+        bool mFirstFrame;
+
+        /// Creates an Item playing the same animation, in sync with all the others
+        Ogre::SkeletonInstance *createInstance( size_t idx );
+
+        /// Copies the local transform of every bone
+        static void getPose( Ogre::SkeletonInstance *skeletonInstance, Pose &outPose );
+        /// @param tolerance
+        ///     Maximum absolute difference per component. 0 requires an exact match.
+        static bool posesEqual( const Pose &a, const Pose &b, Ogre::Real tolerance = 0 );
+
+        /// Advances all animations by one frame and calls SceneManager::updateAllAnimations
+        void advanceFrame();
+
+        /** Checks the throttled instances only change on every Nth frame, where they must
+            match the reference; and that consecutive instances are sampled in different
+            frames.
+        @return
+            The number of failed checks.
+        */
+        size_t testThrottling();
+
+        /** Checks the source of a shared pose matches the reference, and that its followers
+            match what the reference had in the previous frame.
+        @return
+            The number of failed checks.
+        */
+        size_t testSharedPose();
+
+    public:
+        SkeletonInstanceUpdateGameState( const Ogre::String &helpDescription );
+
+        void createScene01() override;
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
@@ -0,0 +1,297 @@
+
+#include "TemporalCoherentRenderQueueGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "Compositor/OgreCompositorManager2.h"
+#include "Compositor/OgreCompositorNodeDef.h"
+#include "Compositor/OgreCompositorWorkspace.h"
+#include "Compositor/OgreCompositorWorkspaceDef.h"
+#include "Compositor/Pass/PassScene/OgreCompositorPassSceneDef.h"
+#include "OgreCamera.h"
+#include "OgreHlms.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsUnlitDatablock.h"
+#include "OgreImage2.h"
+#include "OgreItem.h"
+#include "OgreLogManager.h"
+#include "OgreRenderQueue.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+#include "OgreTextureGpuManager.h"
+#include "OgreTimer.h"
+
+using namespace Demo;
+
+static const size_t c_gridSize = 64u;
+static const size_t c_numDatablocks = 8u;
+static const size_t c_numTimedFrames = 20u;
+
+namespace
+{
+    /// The scene goes through these states, one per rendered frame
+    enum SceneState
+    {
+        InitialScene,
+        /// Nothing changed
+        InitialSceneAgain,
+        /// The dynamic Items moved closer to the camera, changing the sort order
+        MovedItems,
+        MovedItemsAgain,
+        /// The dynamic Items switched between opaque and transparent datablocks
+        SwappedDatablocks,
+        SwappedDatablocksAgain,
+        NumSceneStates
+    };
+}  // namespace
+
+TemporalCoherentRenderQueueGameState::TemporalCoherentRenderQueueGameState(
+    const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+void TemporalCoherentRenderQueueGameState::createScene01()
+{
+    using namespace Ogre;
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+
+    // Half of the datablocks are transparent, so that a wrong order changes the output
+    Hlms *hlmsUnlit = mGraphicsSystem->getRoot()->getHlmsManager()->getHlms( HLMS_UNLIT );
+
+    for( size_t i = 0; i < c_numDatablocks; ++i )
+    {
+        const String datablockName = "TemporalCoherentRenderQueue " + StringConverter::toString( i );
+        HlmsBlendblock blendblock;
+        if( i % 2u )
+            blendblock.setBlendType( SBT_TRANSPARENT_ALPHA );
+        HlmsUnlitDatablock *datablock = static_cast<HlmsUnlitDatablock *>( hlmsUnlit->createDatablock(
+            datablockName, datablockName, HlmsMacroblock(), blendblock, HlmsParamVec() ) );
+        datablock->setUseColour( true );
+        datablock->setColour( ColourValue( Real( i & 0x01u ), Real( ( i >> 1u ) & 0x01u ),
+                                           Real( ( i >> 2u ) & 0x01u ), 0.5f + Real( i ) * 0.05f ) );
+    }
+
+    const char *meshNames[] = { "Cube_d.mesh", "Sphere1000.mesh" };
+
+    for( size_t y = 0; y < c_gridSize; ++y )
+    {
+        for( size_t x = 0; x < c_gridSize; ++x )
+        {
+            const size_t idx = y * c_gridSize + x;
+
+            // Every 16th Item is dynamic, and gets changed during the test
+            const SceneMemoryMgrTypes sceneType = ( idx % 16u ) == 0u ? SCENE_DYNAMIC : SCENE_STATIC;
+
+            Item *item = sceneManager->createItem( meshNames[( idx / 5u ) % 2u],
+                                                   ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+                                                   sceneType );
+            item->setDatablock( "TemporalCoherentRenderQueue " +
+                                StringConverter::toString( ( idx * 3u ) % c_numDatablocks ) );
+
+            SceneNode *sceneNode =
+                sceneManager->getRootSceneNode( sceneType )->createChildSceneNode( sceneType );
+            sceneNode->setPosition( ( Real( x ) - Real( c_gridSize ) * 0.5f ) * 1.5f,
+                                    ( Real( y ) - Real( c_gridSize ) * 0.5f ) * 1.5f,
+                                    -Real( ( idx * 13u ) % 17u ) );
+            sceneNode->setScale( Vector3( 0.9f ) );
+            sceneNode->attachObject( item );
+
+            if( sceneType == SCENE_DYNAMIC )
+                mDynamicNodes.push_back( sceneNode );
+        }
+    }
+
+    Camera *camera = mGraphicsSystem->getCamera();
+    camera->setPosition( 0, 0, Real( c_gridSize ) * 1.0f );
+    camera->lookAt( 0, 0, 0 );
+
+    CompositorManager2 *compositorManager = mGraphicsSystem->getRoot()->getCompositorManager2();
+    CompositorNodeDef *nodeDef =
+        compositorManager->addNodeDefinition( "TemporalCoherentRenderQueue Node" );
+    nodeDef->addTextureSourceName( "RenderTarget", 0, TextureDefinitionBase::TEXTURE_INPUT );
+    nodeDef->setNumTargetPass( 1 );
+    {
+        CompositorTargetDef *targetDef = nodeDef->addTargetPass( "RenderTarget" );
+        targetDef->setNumPasses( 1 );
+        {
+            CompositorPassSceneDef *passScene =
+                static_cast<CompositorPassSceneDef *>( targetDef->addPass( PASS_SCENE ) );
+            passScene->setAllClearColours( ColourValue( 0.2f, 0.4f, 0.6f, 1.0f ) );
+            passScene->setAllLoadActions( LoadAction::Clear );
+            passScene->mIncludeOverlays = false;
+        }
+    }
+
+    CompositorWorkspaceDef *workDef =
+        compositorManager->addWorkspaceDefinition( "TemporalCoherentRenderQueue Workspace" );
+    workDef->connectExternal( 0, nodeDef->getName(), 0 );
+
+    TutorialGameState::createScene01();
+}
+//-----------------------------------------------------------------------------------
+void TemporalCoherentRenderQueueGameState::setSceneState( int sceneState )
+{
+    using namespace Ogre;
+
+    const bool bMoved = sceneState >= MovedItems;
+    const bool bSwapped = sceneState >= SwappedDatablocks;
+
+    for( size_t i = 0; i < mDynamicNodes.size(); ++i )
+    {
+        SceneNode *sceneNode = mDynamicNodes[i];
+
+        Vector3 pos = sceneNode->getPosition();
+        pos.z = bMoved ? 20.0f : -Real( ( i * 16u * 13u ) % 17u );
+        sceneNode->setPosition( pos );
+
+        // Datablocks alternate between opaque and transparent, thus
+        // moving to the next one always changes the transparency
+        Item *item = static_cast<Item *>( sceneNode->getAttachedObject( 0u ) );
+        const size_t datablockIdx = ( i * 16u * 3u + ( bSwapped ? 1u : 0u ) ) % c_numDatablocks;
+        item->setDatablock( "TemporalCoherentRenderQueue " +
+                            StringConverter::toString( datablockIdx ) );
+    }
+
+    mGraphicsSystem->getSceneManager()->updateSceneGraph();
+}
+//-----------------------------------------------------------------------------------
+Ogre::uint64 TemporalCoherentRenderQueueGameState::renderScene( Ogre::CompositorWorkspace *workspace,
+                                                                Ogre::TextureGpu *renderTarget,
+                                                                Ogre::Image2 *outImage )
+{
+    using namespace Ogre;
+
+    Timer timer;
+    workspace->_validateFinalTarget();
+    workspace->_beginUpdate( false );
+    workspace->_update();
+    workspace->_endUpdate( false );
+    const uint64 elapsed = timer.getMicroseconds();
+
+    if( outImage )
+        outImage->convertFromTexture( renderTarget, 0u, 0u );
+
+    return elapsed;
+}
+//-----------------------------------------------------------------------------------
+bool TemporalCoherentRenderQueueGameState::compareImages( const Ogre::Image2 &a,
+                                                          const Ogre::Image2 &b )
+{
+    using namespace Ogre;
+
+    if( a.getPixelFormat() != b.getPixelFormat() || a.getWidth() != b.getWidth() ||
+        a.getHeight() != b.getHeight() )
+    {
+        return false;
+    }
+
+    const TextureBox boxA = a.getData( 0u );
+    const TextureBox boxB = b.getData( 0u );
+    const size_t rowBytes = boxA.width * boxA.bytesPerPixel;
+
+    for( size_t y = 0u; y < boxA.height; ++y )
+    {
+        if( memcmp( boxA.at( 0u, y, 0u ), boxB.at( 0u, y, 0u ), rowBytes ) != 0 )
+            return false;
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+void TemporalCoherentRenderQueueGameState::update( float timeSinceLast )
+{
+    using namespace Ogre;
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+
+    TextureGpu *renderTarget = textureManager->createTexture(
+        "TemporalCoherentRenderQueue RT", GpuPageOutStrategy::Discard, TextureFlags::RenderToTexture,
+        TextureTypes::Type2D );
+    renderTarget->setResolution( 512u, 512u );
+    renderTarget->setPixelFormat( PFG_RGBA8_UNORM );
+    renderTarget->scheduleTransitionTo( GpuResidency::Resident );
+
+    SceneManager *sceneManager = mGraphicsSystem->getSceneManager();
+    RenderQueue *renderQueue = sceneManager->getRenderQueue();
+
+    CompositorManager2 *compositorManager = mGraphicsSystem->getRoot()->getCompositorManager2();
+    CompositorWorkspace *workspace =
+        compositorManager->addWorkspace( sceneManager, renderTarget, mGraphicsSystem->getCamera(),
+                                         "TemporalCoherentRenderQueue Workspace", false );
+
+    LogManager &logManager = LogManager::getSingleton();
+    logManager.logMessage( "Temporal coherent render queue test. " +
+                           StringConverter::toString( sceneManager->getNumWorkerThreads() ) +
+                           " worker threads" );
+
+    // Reference images, always sorting
+    Image2 referenceImages[NumSceneStates];
+    renderQueue->setTemporalCoherence( false );
+    for( int i = 0; i < NumSceneStates; ++i )
+    {
+        setSceneState( i );
+        renderScene( workspace, renderTarget, &referenceImages[i] );
+    }
+
+    // The same frames again, with temporal coherence. The first frame of each state
+    // must be sorted again, while the second one must replay the queue of the first
+    size_t numFailures = 0u;
+    renderQueue->setTemporalCoherence( true );
+    for( int i = 0; i < NumSceneStates; ++i )
+    {
+        setSceneState( i );
+
+        const size_t numReplayedQueues = renderQueue->getNumReplayedQueues();
+        Image2 image;
+        renderScene( workspace, renderTarget, &image );
+
+        const bool bReplayed = renderQueue->getNumReplayedQueues() != numReplayedQueues;
+        const bool bExpectReplay = ( i % 2 ) == 1;
+
+        if( bReplayed != bExpectReplay )
+        {
+            logManager.logMessage( "Scene state " + StringConverter::toString( i ) +
+                                   ( bExpectReplay ? ": the queue was sorted again"
+                                                   : ": a stale queue was replayed" ) );
+            ++numFailures;
+        }
+        if( !compareImages( image, referenceImages[i] ) )
+        {
+            logManager.logMessage( "Scene state " + StringConverter::toString( i ) +
+                                   ": temporal coherence changed the output" );
+            ++numFailures;
+        }
+    }
+
+    uint64 sortTime = 0u;
+    uint64 replayTime = 0u;
+    for( size_t i = 0u; i < c_numTimedFrames; ++i )
+    {
+        renderQueue->setTemporalCoherence( false );
+        sortTime += renderScene( workspace, renderTarget, 0 );
+        renderQueue->setTemporalCoherence( true );
+        // Fill the cache, then time the replay
+        renderScene( workspace, renderTarget, 0 );
+        replayTime += renderScene( workspace, renderTarget, 0 );
+    }
+
+    logManager.logMessage(
+        StringConverter::toString( c_gridSize * c_gridSize ) + " Items. Average frame time: " +
+        StringConverter::toString( sortTime / c_numTimedFrames ) + "us sorting, " +
+        StringConverter::toString( replayTime / c_numTimedFrames ) + "us replaying" );
+
+    renderQueue->setTemporalCoherence( false );
+    compositorManager->removeWorkspace( workspace );
+    textureManager->destroyTexture( renderTarget );
+
+    OGRE_ASSERT( numFailures == 0u && "Temporal coherence rendered wrong results" );
+
+    TutorialGameState::update( timeSinceLast );
+
+    mGraphicsSystem->setQuit();
+}
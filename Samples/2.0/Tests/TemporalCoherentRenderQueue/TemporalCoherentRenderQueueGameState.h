@@ -0,0 +1,36 @@
+
+#ifndef Demo_TemporalCoherentRenderQueueGameState_H
+#define Demo_TemporalCoherentRenderQueueGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class TemporalCoherentRenderQueueGameState : public TutorialGameState
+    {
+        Ogre::FastArray<Ogre::SceneNode *> mDynamicNodes;
+
+        /// Moves the dynamic Items and changes their datablocks according
+        /// to the given SceneState, then updates the scene graph.
+        void setSceneState( int sceneState );
+
+        /// Renders the scene once into renderTarget, downloads the result
+        /// into outImage (if not null) and returns the CPU time it took.
+        Ogre::uint64 renderScene( Ogre::CompositorWorkspace *workspace,
+                                  Ogre::TextureGpu *renderTarget, Ogre::Image2 *outImage );
+
+
+        /// Returns false if the contents of both images differ. The row padding is not compared.
+        static bool compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b );
+
+    public:
+        TemporalCoherentRenderQueueGameState( const Ogre::String &helpDescription );
+
+        void createScene01() override;
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif
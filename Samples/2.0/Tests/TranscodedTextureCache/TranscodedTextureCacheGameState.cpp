@@ -0,0 +1,346 @@
+
+#include "TranscodedTextureCacheGameState.h"
+
+#include "GraphicsSystem.h"
+
+#include "OgreArchive.h"
+#include "OgreArchiveManager.h"
+#include "OgreFileSystemLayer.h"
+#include "OgreImage2.h"
+#include "OgreLogManager.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreRoot.h"
+#include "OgreString.h"
+#include "OgreStringConverter.h"
+#include "OgreStringVector.h"
+#include "OgreTextureBox.h"
+#include "OgreTextureFilters.h"
+#include "OgreTextureGpuManager.h"
+
+#include <algorithm>
+
+using namespace Demo;
+
+TranscodedTextureCacheGameState::TranscodedTextureCacheGameState(
+    const Ogre::String &helpDescription ) :
+    TutorialGameState( helpDescription )
+{
+}
+//-----------------------------------------------------------------------------------
+void TranscodedTextureCacheGameState::loadTexture( const Ogre::String &name,
+                                                   const Ogre::String &aliasName,
+                                                   Ogre::uint32 filters, Ogre::Image2 &outImage )
+{
+    using namespace Ogre;
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+
+    TextureGpu *texture = textureManager->createOrRetrieveTexture(
+        name, aliasName, GpuPageOutStrategy::Discard, 0u, TextureTypes::Type2D,
+        ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, filters );
+    texture->scheduleTransitionTo( GpuResidency::Resident );
+    textureManager->waitForStreamingCompletion();
+
+    outImage.convertFromTexture( texture, 0u, static_cast<uint8>( texture->getNumMipmaps() - 1u ) );
+
+    textureManager->destroyTexture( texture );
+}
+//-----------------------------------------------------------------------------------
+bool TranscodedTextureCacheGameState::compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b,
+                                                     Ogre::uint8 numMipmaps )
+{
+    using namespace Ogre;
+
+    if( a.getPixelFormat() != b.getPixelFormat() || a.getWidth() != b.getWidth() ||
+        a.getHeight() != b.getHeight() || a.getNumMipmaps() < numMipmaps ||
+        b.getNumMipmaps() < numMipmaps )
+    {
+        return false;
+    }
+
+    const PixelFormatGpu format = a.getPixelFormat();
+
+    for( uint8 mip = 0u; mip < numMipmaps; ++mip )
+    {
+        const TextureBox boxA = a.getData( mip );
+        const TextureBox boxB = b.getData( mip );
+
+        // Works for compressed formats too, where a row is a row of blocks
+        const size_t rowBytes = PixelFormatGpuUtils::getSizeBytes( boxA.width, 1u, 1u, 1u, format, 1u );
+        const size_t numRows =
+            PixelFormatGpuUtils::getSizeBytes( boxA.width, boxA.height, 1u, 1u, format, 1u ) / rowBytes;
+
+        for( size_t row = 0u; row < numRows; ++row )
+        {
+            const uint8 *rowA = reinterpret_cast<const uint8 *>( boxA.data ) + row * boxA.bytesPerRow;
+            const uint8 *rowB = reinterpret_cast<const uint8 *>( boxB.data ) + row * boxB.bytesPerRow;
+            if( memcmp( rowA, rowB, rowBytes ) != 0 )
+                return false;
+        }
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+bool TranscodedTextureCacheGameState::runTest( Ogre::Archive *cacheArchive, const Ogre::String &name,
+                                               Ogre::uint32 filters )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+    const String testName = name + " filters " + StringConverter::toString( filters );
+
+    StringVectorPtr entriesBefore = cacheArchive->list( false, false );
+
+    Image2 missImage;
+    loadTexture( name, "Miss " + testName, filters, missImage );
+
+    // Exactly one new entry must have been written, and no temporary file left behind
+    StringVectorPtr entriesAfter = cacheArchive->list( false, false );
+    String entryName;
+    size_t numNewEntries = 0u;
+    bool bTmpFilesLeft = false;
+    for( const String &entry : *entriesAfter )
+    {
+        if( StringUtil::endsWith( entry, ".tmp" ) )
+            bTmpFilesLeft = true;
+        else if( std::find( entriesBefore->begin(), entriesBefore->end(), entry ) ==
+                 entriesBefore->end() )
+        {
+            entryName = entry;
+            ++numNewEntries;
+        }
+    }
+
+    if( bTmpFilesLeft || numNewEntries != 1u )
+    {
+        logManager.logMessage( testName + ": expected 1 new cache entry, found " +
+                               StringConverter::toString( numNewEntries ) +
+                               ( bTmpFilesLeft ? " and temporary files left behind" : "" ) );
+        return false;
+    }
+
+    // The entry holds what got uploaded, minus the mipmaps generated on the GPU
+    Image2 entryImage;
+    {
+        DataStreamPtr stream = cacheArchive->open( entryName );
+        entryImage.load( stream, "oitd" );
+    }
+    if( !compareImages( entryImage, missImage, entryImage.getNumMipmaps() ) )
+    {
+        logManager.logMessage( testName + ": cache entry " + entryName +
+                               " differs from the uploaded texture" );
+        return false;
+    }
+
+    Image2 hitImage;
+    loadTexture( name, "Hit " + testName, filters, hitImage );
+    if( hitImage.getNumMipmaps() != missImage.getNumMipmaps() ||
+        !compareImages( hitImage, missImage, missImage.getNumMipmaps() ) )
+    {
+        logManager.logMessage(
+            testName + ": the texture loaded from the cache differs from the original (" +
+            PixelFormatGpuUtils::toString( hitImage.getPixelFormat() ) + " " +
+            StringConverter::toString( hitImage.getNumMipmaps() ) + " mips vs " +
+            PixelFormatGpuUtils::toString( missImage.getPixelFormat() ) + " " +
+            StringConverter::toString( missImage.getNumMipmaps() ) + " mips)" );
+        return false;
+    }
+
+    // Tamper with mip 0 of the entry. If the next load doesn't see it,
+    // the cache isn't being used and the comparison above proved nothing
+    {
+        const TextureBox box = entryImage.getData( 0u );
+        uint8 *data = reinterpret_cast<uint8 *>( box.data );
+        for( size_t i = 0u; i < box.bytesPerImage; ++i )
+            data[i] ^= 0xFFu;
+
+        DataStreamPtr encoded = entryImage.encode( "oitd", 0u, entryImage.getNumMipmaps() );
+        MemoryDataStream *encodedMem = static_cast<MemoryDataStream *>( encoded.get() );
+        DataStreamPtr cacheFile = cacheArchive->create( entryName );
+        cacheFile->write( encodedMem->getPtr(), encodedMem->size() );
+    }
+
+    Image2 tamperedImage;
+    loadTexture( name, "Tampered " + testName, filters, tamperedImage );
+    if( !compareImages( tamperedImage, entryImage, 1u ) )
+    {
+        logManager.logMessage( testName + ": the cache entry was not used" );
+        return false;
+    }
+
+    logManager.logMessage( testName + ": OK. " +
+                           PixelFormatGpuUtils::toString( missImage.getPixelFormat() ) + ", " +
+                           StringConverter::toString( missImage.getNumMipmaps() ) + " mips, " +
+                           StringConverter::toString( entryImage.getNumMipmaps() ) + " of them cached" );
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+Ogre::StringVector TranscodedTextureCacheGameState::listEntries( Ogre::Archive *cacheArchive )
+{
+    using namespace Ogre;
+
+    StringVector entries;
+    StringVectorPtr files = cacheArchive->list( false, false );
+    for( const String &file : *files )
+    {
+        if( StringUtil::endsWith( file, ".oitd" ) )
+            entries.push_back( file );
+    }
+    std::sort( entries.begin(), entries.end() );
+    return entries;
+}
+//-----------------------------------------------------------------------------------
+bool TranscodedTextureCacheGameState::testEviction( Ogre::Archive *cacheArchive )
+{
+    using namespace Ogre;
+
+    LogManager &logManager = LogManager::getSingleton();
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+
+    const size_t defaultBudget = textureManager->getTranscodedCacheBudget();
+    // SW mipmaps get cached, thus the entries are reasonably big
+    const uint32 filters = TextureFilter::TypeGenerateSwMipmaps;
+
+    bool bOk = true;
+    Image2 image;
+
+    textureManager->setTranscodedCacheBudget( 1u );
+    if( !listEntries( cacheArchive ).empty() || textureManager->getTranscodedCacheSize() != 0u )
+    {
+        logManager.logMessage( "Eviction: a budget of 1 byte must evict every entry" );
+        bOk = false;
+    }
+
+    loadTexture( "snow_1024.jpg", "Over budget", filters, image );
+    if( !listEntries( cacheArchive ).empty() )
+    {
+        logManager.logMessage( "Eviction: an entry bigger than the budget was saved" );
+        bOk = false;
+    }
+
+    textureManager->setTranscodedCacheBudget( 0u );
+
+    loadTexture( "snow_1024.jpg", "Evict A", filters, image );
+    const StringVector entriesA = listEntries( cacheArchive );
+    const size_t sizeA = textureManager->getTranscodedCacheSize();
+
+    loadTexture( "KAMEN320x240.jpg", "Evict B", filters, image );
+    const size_t numEntriesAB = listEntries( cacheArchive ).size();
+
+    // A is a cache hit, which makes B the least recently used
+    loadTexture( "snow_1024.jpg", "Evict A again", filters, image );
+    textureManager->setTranscodedCacheBudget( textureManager->getTranscodedCacheSize() - 1u );
+
+    if( entriesA.size() != 1u || numEntriesAB != 2u || listEntries( cacheArchive ) != entriesA ||
+        textureManager->getTranscodedCacheSize() != sizeA )
+    {
+        logManager.logMessage( "Eviction: expected the least recently used entry to be evicted. "
+                               "Entries after loading A: " +
+                               StringConverter::toString( entriesA.size() ) + ", A & B: " +
+                               StringConverter::toString( numEntriesAB ) + ", after evicting: " +
+                               StringConverter::toString( listEntries( cacheArchive ).size() ) );
+        bOk = false;
+    }
+
+    textureManager->setTranscodedCacheBudget( defaultBudget );
+
+    if( bOk )
+        logManager.logMessage( "Eviction: OK" );
+
+    return bOk;
+}
+//-----------------------------------------------------------------------------------
+void TranscodedTextureCacheGameState::update( float timeSinceLast )
+{
+    TutorialGameState::update( timeSinceLast );
+
+    using namespace Ogre;
+
+    // Start from an empty cache, otherwise the first loads would already be hits
+    const String cacheFolder = mGraphicsSystem->getWriteAccessFolder() + "TranscodedTextureCache";
+    FileSystemLayer::createDirectory( cacheFolder );
+
+    ArchiveManager &archiveManager = ArchiveManager::getSingleton();
+    Archive *cacheArchive = archiveManager.load( cacheFolder, "FileSystem", false );
+    {
+        StringVectorPtr oldEntries = cacheArchive->list( false, false );
+        for( const String &entry : *oldEntries )
+            cacheArchive->remove( entry );
+    }
+
+    // Entries of other cache versions and temporary files must be deleted when the
+    // archive is set. Anything else isn't ours and must be left alone
+    const char *staleEntry = "v0_stale.oitd";
+    const char *tmpFile = "v1_0_stale.oitd.0.tmp";
+    const char *otherFile = "NotACacheEntry.txt";
+    {
+        const char *files[] = { staleEntry, tmpFile, otherFile };
+        for( size_t i = 0; i < sizeof( files ) / sizeof( files[0] ); ++i )
+        {
+            DataStreamPtr file = cacheArchive->create( files[i] );
+            file->write( files[i], strlen( files[i] ) );
+        }
+    }
+
+    TextureGpuManager *textureManager =
+        mGraphicsSystem->getRoot()->getRenderSystem()->getTextureGpuManager();
+    textureManager->setTranscodedCacheArchive( cacheArchive );
+
+    LogManager &logManager = LogManager::getSingleton();
+    logManager.logMessage( "Transcoded texture cache test" );
+
+    size_t numFailures = 0u;
+
+    if( cacheArchive->exists( staleEntry ) || cacheArchive->exists( tmpFile ) ||
+        !cacheArchive->exists( otherFile ) )
+    {
+        logManager.logMessage( "Setting the archive must only delete stale entries & temporary files" );
+        ++numFailures;
+    }
+    if( cacheArchive->exists( otherFile ) )
+        cacheArchive->remove( otherFile );
+
+    struct TestDesc
+    {
+        const char *name;
+        uint32 filters;
+    };
+
+    // snow_1024.jpg is 1024x1024, thus it can be compressed.
+    // KAMEN320x240.jpg is 640x477, which is not a multiple of 4 and thus never compressed
+    const TestDesc tests[] = {
+        { "snow_1024.jpg", TextureFilter::TypeGenerateDefaultMipmaps },
+        { "snow_1024.jpg", TextureFilter::TypeGenerateHwMipmaps },
+        // HW mipmaps requested, but compression forces them to be generated on the CPU.
+        // Cache hits must not try to generate them on the GPU
+        { "snow_1024.jpg", TextureFilter::TypeGenerateHwMipmaps | TextureFilter::TypeCompressBc },
+        { "snow_1024.jpg",
+          TextureFilter::TypeGenerateDefaultMipmaps | TextureFilter::TypeCompressBc7 },
+        { "KAMEN320x240.jpg",
+          TextureFilter::TypeGenerateDefaultMipmaps | TextureFilter::TypePrepareForNormalMapping },
+        { "KAMEN320x240.jpg",
+          TextureFilter::TypeGenerateSwMipmaps | TextureFilter::TypeCompressBc },
+    };
+
+    for( size_t i = 0; i < sizeof( tests ) / sizeof( tests[0] ); ++i )
+    {
+        if( !runTest( cacheArchive, tests[i].name, tests[i].filters ) )
+            ++numFailures;
+    }
+
+    if( !testEviction( cacheArchive ) )
+        ++numFailures;
+
+    textureManager->setTranscodedCacheArchive( 0 );
+    archiveManager.unload( cacheArchive );
+
+    OGRE_ASSERT( numFailures == 0u && "Transcoded texture cache round trip failed" );
+
+    mGraphicsSystem->setQuit();
+}
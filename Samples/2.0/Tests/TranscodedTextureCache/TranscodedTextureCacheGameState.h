@@ -0,0 +1,50 @@
+
+#ifndef Demo_TranscodedTextureCacheGameState_H
+#define Demo_TranscodedTextureCacheGameState_H
+
+#include "OgrePrerequisites.h"
+
+#include "OgreStringVector.h"
+
+#include "TutorialGameState.h"
+
+namespace Demo
+{
+    class TranscodedTextureCacheGameState : public TutorialGameState
+    {
+        /// Loads the file into a new texture, waits until it's resident, downloads
+        /// all of its mips into outImage and destroys the texture
+        void loadTexture( const Ogre::String &name, const Ogre::String &aliasName,
+                          Ogre::uint32 filters, Ogre::Image2 &outImage );
+
+        /// Returns false if the format, resolution or the contents of the first numMipmaps
+        /// mips differ. The row padding is not compared.
+        static bool compareImages( const Ogre::Image2 &a, const Ogre::Image2 &b,
+                                   Ogre::uint8 numMipmaps );
+
+        /** Loads the file once to fill the cache and checks a single complete entry was
+            written. Then loads it again, which must match the first load, and once more
+            after tampering with the entry, to prove the cache is really being read.
+        @return
+            False if any of the checks fails.
+        */
+        bool runTest( Ogre::Archive *cacheArchive, const Ogre::String &name, Ogre::uint32 filters );
+
+        /// Returns the names of the cache entries in the archive, sorted
+        static Ogre::StringVector listEntries( Ogre::Archive *cacheArchive );
+
+        /** Checks lowering the budget evicts the least recently used entries first,
+            and that entries bigger than the budget are not saved.
+        @return
+            False if any of the checks fails.
+        */
+        bool testEviction( Ogre::Archive *cacheArchive );
+
+    public:
+        TranscodedTextureCacheGameState( const Ogre::String &helpDescription );
+
+        void update( float timeSinceLast ) override;
+    };
+}  // namespace Demo
+
+#endif